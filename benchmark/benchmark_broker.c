@@ -0,0 +1,914 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file benchmark_broker.c
+ * @brief Implements the broker declared in benchmark_broker.h.
+ *
+ * The broker thread polls the broker end of every client and a wake pipe.
+ * Bytes received are framed into packets, each handled in turn, and the
+ * replies and routed publishes are queued on the receiving clients. While
+ * any queue holds more than #SEND_HIGH_WATER bytes, the broker stops reading,
+ * so publishers are held back by the socket buffers as they are by a real
+ * broker that does not keep up. The mutex of the broker is held except while
+ * the thread waits in `poll`.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "benchmark_broker.h"
+
+/**
+ * @brief Bytes queued on a client above which the broker stops reading.
+ */
+#define SEND_HIGH_WATER          ( 262144U )
+
+/**
+ * @brief Bytes queued on a client below which a flood adds publishes.
+ */
+#define FLOOD_LOW_WATER          ( 65536U )
+
+/**
+ * @brief Initial size of the send queue of a client.
+ */
+#define INITIAL_SEND_SIZE        ( 65536U )
+
+/**
+ * @brief Size of a CONNACK, PUBACK, PUBREC, PUBREL, PUBCOMP or UNSUBACK.
+ */
+#define ACK_PACKET_SIZE          ( 4U )
+
+/**
+ * @brief Most bytes of the fixed header of a packet.
+ */
+#define MAX_FIXED_HEADER_SIZE    ( 5U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Make room for bytes at the end of the send queue of a client.
+ */
+static bool reserveSend( BenchmarkBrokerClient_t * pClient,
+                         size_t length )
+{
+    uint8_t * pSend;
+    size_t newSize = pClient->sendSize;
+    bool success = true;
+
+    if( pClient->sendStart == pClient->sendEnd )
+    {
+        pClient->sendStart = 0U;
+        pClient->sendEnd = 0U;
+    }
+
+    if( ( pClient->sendEnd + length ) > pClient->sendSize )
+    {
+        /* Move the unsent bytes to the front, and grow if they still do not fit. */
+        ( void ) memmove( pClient->pSend, &( pClient->pSend[ pClient->sendStart ] ),
+                          pClient->sendEnd - pClient->sendStart );
+        pClient->sendEnd -= pClient->sendStart;
+        pClient->sendStart = 0U;
+
+        while( ( pClient->sendEnd + length ) > newSize )
+        {
+            newSize *= 2U;
+        }
+
+        if( newSize != pClient->sendSize )
+        {
+            pSend = realloc( pClient->pSend, newSize );
+
+            if( pSend != NULL )
+            {
+                pClient->pSend = pSend;
+                pClient->sendSize = newSize;
+            }
+            else
+            {
+                success = false;
+            }
+        }
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Queue a packet of 4 bytes with a packet ID.
+ */
+static bool queueAck( BenchmarkBrokerClient_t * pClient,
+                      uint8_t packetType,
+                      uint16_t packetId )
+{
+    uint8_t * pPacket;
+    bool success = reserveSend( pClient, ACK_PACKET_SIZE );
+
+    if( success == true )
+    {
+        pPacket = &( pClient->pSend[ pClient->sendEnd ] );
+        pPacket[ 0 ] = packetType;
+        pPacket[ 1 ] = 2U;
+        pPacket[ 2 ] = ( uint8_t ) ( packetId >> 8 );
+        pPacket[ 3 ] = ( uint8_t ) packetId;
+        pClient->sendEnd += ACK_PACKET_SIZE;
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Queue a publish, with a new packet ID for QoS 1 and 2.
+ */
+static bool queuePublish( BenchmarkBrokerClient_t * pClient,
+                          const MQTTPublishInfo_t * pPublishInfo )
+{
+    MQTTFixedBuffer_t fixedBuffer;
+    size_t remainingLength = 0U, packetSize = 0U;
+    uint16_t packetId = 0U;
+    bool success;
+
+    success = ( MQTT_GetPublishPacketSize( pPublishInfo, &remainingLength, &packetSize ) == MQTTSuccess ) &&
+              reserveSend( pClient, packetSize );
+
+    if( ( success == true ) && ( pPublishInfo->qos != MQTTQoS0 ) )
+    {
+        pClient->inflight++;
+        packetId = pClient->nextPacketId;
+        pClient->nextPacketId = ( packetId == UINT16_MAX ) ? 1U : ( uint16_t ) ( packetId + 1U );
+    }
+
+    if( success == true )
+    {
+        fixedBuffer.pBuffer = &( pClient->pSend[ pClient->sendEnd ] );
+        fixedBuffer.size = packetSize;
+        success = MQTT_SerializePublish( pPublishInfo, packetId, remainingLength, &fixedBuffer ) == MQTTSuccess;
+    }
+
+    if( success == true )
+    {
+        pClient->sendEnd += packetSize;
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read a big-endian 16 bit value.
+ */
+static uint16_t readUint16( const uint8_t * pBytes )
+{
+    return ( uint16_t ) ( ( ( uint16_t ) pBytes[ 0 ] << 8 ) | pBytes[ 1 ] );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Route a publish to every client with a matching subscription.
+ */
+static void routePublish( BenchmarkBroker_t * pBroker,
+                          const MQTTPublishInfo_t * pPublishInfo )
+{
+    MQTTPublishInfo_t routed = *pPublishInfo;
+    BenchmarkBrokerClient_t * pClient;
+    const BenchmarkBrokerSubscription_t * pSubscription;
+    bool isMatch;
+    size_t i, j;
+
+    routed.dup = false;
+    routed.retain = false;
+
+    for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+    {
+        pClient = &( pBroker->clients[ i ] );
+
+        for( j = 0U; ( pClient->socketDescriptor >= 0 ) && ( j < pClient->subscriptionCount ); j++ )
+        {
+            pSubscription = &( pClient->subscriptions[ j ] );
+            isMatch = false;
+            ( void ) MQTT_MatchTopic( pPublishInfo->pTopicName, pPublishInfo->topicNameLength,
+                                      pSubscription->filter, pSubscription->filterLength, &isMatch );
+
+            if( isMatch == true )
+            {
+                /* Deliver once, at the QoS of the first matching filter. */
+                routed.qos = ( pSubscription->qos < pPublishInfo->qos ) ? pSubscription->qos : pPublishInfo->qos;
+
+                if( queuePublish( pClient, &routed ) == true )
+                {
+                    pBroker->stats.publishesSent++;
+                }
+
+                break;
+            }
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Handle a PUBLISH from a client.
+ */
+static bool handlePublish( BenchmarkBroker_t * pBroker,
+                           BenchmarkBrokerClient_t * pClient,
+                           uint8_t flags,
+                           const uint8_t * pBody,
+                           size_t length )
+{
+    MQTTPublishInfo_t publishInfo = { 0 };
+    uint16_t packetId = 0U;
+    size_t index = 2U;
+    bool success = length >= 2U;
+
+    publishInfo.qos = ( MQTTQoS_t ) ( ( flags >> 1 ) & 0x03U );
+    publishInfo.retain = ( flags & 0x01U ) != 0U;
+
+    if( success == true )
+    {
+        publishInfo.topicNameLength = readUint16( pBody );
+        publishInfo.pTopicName = ( const char * ) &( pBody[ index ] );
+        index += publishInfo.topicNameLength;
+        success = ( publishInfo.qos <= MQTTQoS2 ) && ( publishInfo.topicNameLength > 0U ) &&
+                  ( index + ( ( publishInfo.qos != MQTTQoS0 ) ? 2U : 0U ) <= length );
+    }
+
+    if( ( success == true ) && ( publishInfo.qos != MQTTQoS0 ) )
+    {
+        packetId = readUint16( &( pBody[ index ] ) );
+        index += 2U;
+        success = queueAck( pClient, ( publishInfo.qos == MQTTQoS1 ) ? MQTT_PACKET_TYPE_PUBACK : MQTT_PACKET_TYPE_PUBREC,
+                            packetId );
+    }
+
+    if( success == true )
+    {
+        publishInfo.pPayload = &( pBody[ index ] );
+        publishInfo.payloadLength = length - index;
+        pBroker->stats.publishesReceived++;
+        routePublish( pBroker, &publishInfo );
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Handle a SUBSCRIBE from a client, granting the QoS requested.
+ */
+static bool handleSubscribe( BenchmarkBrokerClient_t * pClient,
+                             const uint8_t * pBody,
+                             size_t length )
+{
+    BenchmarkBrokerSubscription_t * pSubscription;
+    uint8_t codes[ BENCHMARK_BROKER_MAX_SUBSCRIPTIONS ];
+    size_t codeCount = 0U, index = 2U, i;
+    uint16_t filterLength;
+    bool success = length >= 2U;
+
+    while( ( success == true ) && ( index < length ) )
+    {
+        filterLength = ( ( index + 2U ) <= length ) ? readUint16( &( pBody[ index ] ) ) : 0U;
+        success = ( filterLength > 0U ) && ( filterLength < BENCHMARK_BROKER_MAX_FILTER_LENGTH ) &&
+                  ( ( index + 3U + filterLength ) <= length ) && ( codeCount < BENCHMARK_BROKER_MAX_SUBSCRIPTIONS );
+
+        if( success == true )
+        {
+            /* A filter subscribed to again keeps its slot. */
+            for( i = 0U; i < pClient->subscriptionCount; i++ )
+            {
+                if( ( pClient->subscriptions[ i ].filterLength == filterLength ) &&
+                    ( memcmp( pClient->subscriptions[ i ].filter, &( pBody[ index + 2U ] ), filterLength ) == 0 ) )
+                {
+                    break;
+                }
+            }
+
+            if( i < BENCHMARK_BROKER_MAX_SUBSCRIPTIONS )
+            {
+                pSubscription = &( pClient->subscriptions[ i ] );
+                ( void ) memcpy( pSubscription->filter, &( pBody[ index + 2U ] ), filterLength );
+                pSubscription->filterLength = filterLength;
+                pSubscription->qos = ( MQTTQoS_t ) ( pBody[ index + 2U + filterLength ] & 0x03U );
+                pClient->subscriptionCount += ( i == pClient->subscriptionCount ) ? 1U : 0U;
+                codes[ codeCount ] = ( uint8_t ) pSubscription->qos;
+            }
+            else
+            {
+                codes[ codeCount ] = 0x80U;
+            }
+
+            codeCount++;
+            index += 3U + filterLength;
+        }
+    }
+
+    success = success && ( codeCount > 0U ) && reserveSend( pClient, 4U + codeCount );
+
+    if( success == true )
+    {
+        pClient->pSend[ pClient->sendEnd ] = MQTT_PACKET_TYPE_SUBACK;
+        pClient->pSend[ pClient->sendEnd + 1U ] = ( uint8_t ) ( 2U + codeCount );
+        pClient->pSend[ pClient->sendEnd + 2U ] = pBody[ 0 ];
+        pClient->pSend[ pClient->sendEnd + 3U ] = pBody[ 1 ];
+        ( void ) memcpy( &( pClient->pSend[ pClient->sendEnd + 4U ] ), codes, codeCount );
+        pClient->sendEnd += 4U + codeCount;
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Handle an UNSUBSCRIBE from a client.
+ */
+static bool handleUnsubscribe( BenchmarkBrokerClient_t * pClient,
+                               const uint8_t * pBody,
+                               size_t length )
+{
+    size_t index = 2U, i;
+    uint16_t filterLength;
+    bool success = length >= 2U;
+
+    while( ( success == true ) && ( index < length ) )
+    {
+        filterLength = ( ( index + 2U ) <= length ) ? readUint16( &( pBody[ index ] ) ) : 0U;
+        success = ( filterLength > 0U ) && ( ( index + 2U + filterLength ) <= length );
+
+        for( i = 0U; ( success == true ) && ( i < pClient->subscriptionCount ); i++ )
+        {
+            if( ( pClient->subscriptions[ i ].filterLength == filterLength ) &&
+                ( memcmp( pClient->subscriptions[ i ].filter, &( pBody[ index + 2U ] ), filterLength ) == 0 ) )
+            {
+                pClient->subscriptionCount--;
+                pClient->subscriptions[ i ] = pClient->subscriptions[ pClient->subscriptionCount ];
+                break;
+            }
+        }
+
+        index += 2U + filterLength;
+    }
+
+    return success && queueAck( pClient, MQTT_PACKET_TYPE_UNSUBACK, readUint16( pBody ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Handle one packet from a client.
+ *
+ * @return false if the connection must be closed.
+ */
+static bool handlePacket( BenchmarkBroker_t * pBroker,
+                          BenchmarkBrokerClient_t * pClient,
+                          uint8_t type,
+                          const uint8_t * pBody,
+                          size_t length )
+{
+    bool success = true;
+
+    if( ( type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        success = handlePublish( pBroker, pClient, type & 0x0FU, pBody, length );
+    }
+    else if( type == MQTT_PACKET_TYPE_CONNECT )
+    {
+        success = queueAck( pClient, MQTT_PACKET_TYPE_CONNACK, 0U );
+    }
+    else if( ( type == MQTT_PACKET_TYPE_PUBACK ) || ( type == MQTT_PACKET_TYPE_PUBCOMP ) )
+    {
+        pBroker->stats.acksReceived++;
+        pClient->inflight -= ( pClient->inflight > 0U ) ? 1U : 0U;
+        success = length == 2U;
+    }
+    else if( type == MQTT_PACKET_TYPE_PUBREC )
+    {
+        success = ( length == 2U ) && queueAck( pClient, MQTT_PACKET_TYPE_PUBREL, readUint16( pBody ) );
+    }
+    else if( type == MQTT_PACKET_TYPE_PUBREL )
+    {
+        success = ( length == 2U ) && queueAck( pClient, MQTT_PACKET_TYPE_PUBCOMP, readUint16( pBody ) );
+    }
+    else if( type == MQTT_PACKET_TYPE_SUBSCRIBE )
+    {
+        success = handleSubscribe( pClient, pBody, length );
+    }
+    else if( type == MQTT_PACKET_TYPE_UNSUBSCRIBE )
+    {
+        success = handleUnsubscribe( pClient, pBody, length );
+    }
+    else if( type == MQTT_PACKET_TYPE_PINGREQ )
+    {
+        success = reserveSend( pClient, 2U );
+
+        if( success == true )
+        {
+            pClient->pSend[ pClient->sendEnd ] = MQTT_PACKET_TYPE_PINGRESP;
+            pClient->pSend[ pClient->sendEnd + 1U ] = 0U;
+            pClient->sendEnd += 2U;
+        }
+    }
+    else
+    {
+        /* A DISCONNECT, or a packet a client does not send. */
+        pBroker->stats.protocolErrors += ( type == MQTT_PACKET_TYPE_DISCONNECT ) ? 0U : 1U;
+        success = false;
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Handle every whole packet in the receive buffer of a client.
+ *
+ * @return false if the connection must be closed.
+ */
+static bool handleReceived( BenchmarkBroker_t * pBroker,
+                            BenchmarkBrokerClient_t * pClient )
+{
+    size_t offset = 0U, headerLength, remainingLength, multiplier;
+    bool success = true, framing = true;
+
+    while( ( success == true ) && ( framing == true ) )
+    {
+        /* Decode the remaining length after the first byte. */
+        headerLength = 1U;
+        remainingLength = 0U;
+        multiplier = 1U;
+        framing = false;
+
+        while( ( offset + headerLength ) < pClient->receiveLength )
+        {
+            remainingLength += ( size_t ) ( pClient->pReceive[ offset + headerLength ] & 0x7FU ) * multiplier;
+            multiplier *= 128U;
+            headerLength++;
+
+            if( ( pClient->pReceive[ offset + headerLength - 1U ] & 0x80U ) == 0U )
+            {
+                framing = true;
+                break;
+            }
+            else if( headerLength == MAX_FIXED_HEADER_SIZE )
+            {
+                success = false;
+                break;
+            }
+            else
+            {
+                /* Empty else MISRA 15.7 */
+            }
+        }
+
+        if( ( framing == true ) && ( ( headerLength + remainingLength ) > BENCHMARK_BROKER_RECEIVE_SIZE ) )
+        {
+            success = false;
+        }
+        else if( ( framing == true ) && ( ( offset + headerLength + remainingLength ) <= pClient->receiveLength ) )
+        {
+            success = handlePacket( pBroker, pClient, pClient->pReceive[ offset ],
+                                    &( pClient->pReceive[ offset + headerLength ] ), remainingLength );
+            offset += headerLength + remainingLength;
+        }
+        else
+        {
+            framing = false;
+        }
+    }
+
+    if( ( success == true ) && ( offset > 0U ) )
+    {
+        pClient->receiveLength -= offset;
+        ( void ) memmove( pClient->pReceive, &( pClient->pReceive[ offset ] ), pClient->receiveLength );
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Close the broker end of a client and free its slot.
+ */
+static void closeClient( BenchmarkBrokerClient_t * pClient )
+{
+    if( pClient->socketDescriptor >= 0 )
+    {
+        ( void ) close( pClient->socketDescriptor );
+    }
+
+    free( pClient->pReceive );
+    free( pClient->pSend );
+    ( void ) memset( pClient, 0, sizeof( *pClient ) );
+    pClient->socketDescriptor = -1;
+    pClient->clientDescriptor = -1;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send queued bytes of a client, without blocking.
+ *
+ * @return false if the connection must be closed.
+ */
+static bool sendQueued( BenchmarkBrokerClient_t * pClient )
+{
+    ssize_t sent = 0;
+
+    while( ( pClient->sendStart < pClient->sendEnd ) && ( sent >= 0 ) )
+    {
+        sent = send( pClient->socketDescriptor, &( pClient->pSend[ pClient->sendStart ] ),
+                     pClient->sendEnd - pClient->sendStart, MSG_DONTWAIT | MSG_NOSIGNAL );
+
+        if( sent > 0 )
+        {
+            pClient->sendStart += ( size_t ) sent;
+        }
+        else if( ( sent < 0 ) && ( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) ) )
+        {
+            /* The rest is sent when the socket is writable. */
+            sent = 0;
+            break;
+        }
+        else
+        {
+            sent = -1;
+        }
+    }
+
+    return sent >= 0;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive bytes of a client and handle the whole packets among them.
+ *
+ * @return false if the connection must be closed.
+ */
+static bool receiveClient( BenchmarkBroker_t * pBroker,
+                           BenchmarkBrokerClient_t * pClient )
+{
+    ssize_t received;
+    bool success = true;
+
+    received = recv( pClient->socketDescriptor, &( pClient->pReceive[ pClient->receiveLength ] ),
+                     BENCHMARK_BROKER_RECEIVE_SIZE - pClient->receiveLength, MSG_DONTWAIT );
+
+    if( received > 0 )
+    {
+        pClient->receiveLength += ( size_t ) received;
+        success = handleReceived( pBroker, pClient );
+    }
+    else if( ( received < 0 ) && ( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) ) )
+    {
+        /* Nothing to receive yet. */
+    }
+    else
+    {
+        success = false;
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Queue publishes of the flood of a client until its queue is full or
+ * too many wait for acknowledgments.
+ */
+static void refillFlood( BenchmarkBroker_t * pBroker,
+                         BenchmarkBrokerClient_t * pClient )
+{
+    while( ( pClient->floodRemaining > 0U ) && ( ( pClient->sendEnd - pClient->sendStart ) < FLOOD_LOW_WATER ) &&
+           ( ( pClient->floodInfo.qos == MQTTQoS0 ) || ( pClient->inflight < BENCHMARK_BROKER_MAX_INFLIGHT ) ) )
+    {
+        if( queuePublish( pClient, &( pClient->floodInfo ) ) == false )
+        {
+            pClient->floodRemaining = 0U;
+        }
+        else
+        {
+            pClient->floodRemaining--;
+            pBroker->stats.publishesSent++;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The thread of the broker.
+ */
+static void * runBroker( void * pArgument )
+{
+    BenchmarkBroker_t * pBroker = ( BenchmarkBroker_t * ) pArgument;
+    struct pollfd pollDescriptors[ BENCHMARK_BROKER_MAX_CLIENTS + 1U ];
+    BenchmarkBrokerClient_t * pClient;
+    uint8_t drain[ 64 ];
+    bool receiving;
+    size_t i;
+
+    ( void ) pthread_mutex_lock( &( pBroker->mutex ) );
+
+    while( pBroker->running == true )
+    {
+        /* Stop reading while any client has too much queued. */
+        receiving = true;
+
+        for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+        {
+            pClient = &( pBroker->clients[ i ] );
+
+            if( pClient->socketDescriptor >= 0 )
+            {
+                refillFlood( pBroker, pClient );
+                receiving = receiving && ( ( pClient->sendEnd - pClient->sendStart ) <= SEND_HIGH_WATER );
+            }
+        }
+
+        pollDescriptors[ 0 ].fd = pBroker->wakeDescriptors[ 0 ];
+        pollDescriptors[ 0 ].events = POLLIN;
+
+        for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+        {
+            pClient = &( pBroker->clients[ i ] );
+            pollDescriptors[ i + 1U ].fd = pClient->socketDescriptor;
+            pollDescriptors[ i + 1U ].events = ( short ) ( ( receiving == true ) ? POLLIN : 0 );
+            pollDescriptors[ i + 1U ].events |= ( short ) ( ( pClient->sendStart < pClient->sendEnd ) ? POLLOUT : 0 );
+            pollDescriptors[ i + 1U ].revents = 0;
+        }
+
+        ( void ) pthread_mutex_unlock( &( pBroker->mutex ) );
+        ( void ) poll( pollDescriptors, BENCHMARK_BROKER_MAX_CLIENTS + 1U, -1 );
+        ( void ) pthread_mutex_lock( &( pBroker->mutex ) );
+
+        if( ( pollDescriptors[ 0 ].revents & POLLIN ) != 0 )
+        {
+            ( void ) read( pBroker->wakeDescriptors[ 0 ], drain, sizeof( drain ) );
+        }
+
+        for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+        {
+            pClient = &( pBroker->clients[ i ] );
+
+            /* A client added while polling has no events yet. */
+            if( ( pClient->socketDescriptor >= 0 ) && ( pollDescriptors[ i + 1U ].fd == pClient->socketDescriptor ) &&
+                ( pollDescriptors[ i + 1U ].revents != 0 ) )
+            {
+                if( ( ( ( pollDescriptors[ i + 1U ].revents & ( POLLIN | POLLHUP | POLLERR ) ) != 0 ) &&
+                      ( receiveClient( pBroker, pClient ) == false ) ) ||
+                    ( sendQueued( pClient ) == false ) )
+                {
+                    closeClient( pClient );
+                }
+            }
+        }
+
+        /* Replies to one client may have been queued on the others. */
+        for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+        {
+            pClient = &( pBroker->clients[ i ] );
+
+            if( ( pClient->socketDescriptor >= 0 ) && ( sendQueued( pClient ) == false ) )
+            {
+                closeClient( pClient );
+            }
+        }
+    }
+
+    ( void ) pthread_mutex_unlock( &( pBroker->mutex ) );
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Wake the broker thread from `poll`.
+ */
+static void wakeBroker( BenchmarkBroker_t * pBroker )
+{
+    ( void ) write( pBroker->wakeDescriptors[ 1 ], "w", 1U );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Give the broker end of a connection to a free slot.
+ *
+ * @return false if there is no free slot, in which case the broker end is
+ * closed.
+ */
+static bool addConnection( BenchmarkBroker_t * pBroker,
+                           int socketDescriptor,
+                           int clientDescriptor )
+{
+    BenchmarkBrokerClient_t * pClient = NULL;
+    bool success = false;
+    size_t i;
+
+    ( void ) pthread_mutex_lock( &( pBroker->mutex ) );
+
+    for( i = 0U; ( i < BENCHMARK_BROKER_MAX_CLIENTS ) && ( pClient == NULL ); i++ )
+    {
+        if( pBroker->clients[ i ].socketDescriptor < 0 )
+        {
+            pClient = &( pBroker->clients[ i ] );
+        }
+    }
+
+    if( pClient != NULL )
+    {
+        pClient->socketDescriptor = socketDescriptor;
+        pClient->pReceive = malloc( BENCHMARK_BROKER_RECEIVE_SIZE );
+        pClient->pSend = malloc( INITIAL_SEND_SIZE );
+
+        if( ( pClient->pReceive != NULL ) && ( pClient->pSend != NULL ) )
+        {
+            pClient->clientDescriptor = clientDescriptor;
+            pClient->sendSize = INITIAL_SEND_SIZE;
+            pClient->nextPacketId = 1U;
+            wakeBroker( pBroker );
+            success = true;
+        }
+        else
+        {
+            closeClient( pClient );
+        }
+    }
+    else
+    {
+        ( void ) close( socketDescriptor );
+    }
+
+    ( void ) pthread_mutex_unlock( &( pBroker->mutex ) );
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+bool BenchmarkBroker_Start( BenchmarkBroker_t * pBroker )
+{
+    size_t i;
+    bool success;
+
+    ( void ) memset( pBroker, 0, sizeof( *pBroker ) );
+
+    for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+    {
+        pBroker->clients[ i ].socketDescriptor = -1;
+        pBroker->clients[ i ].clientDescriptor = -1;
+    }
+
+    pBroker->running = true;
+    success = ( pipe2( pBroker->wakeDescriptors, O_NONBLOCK | O_CLOEXEC ) == 0 ) &&
+              ( pthread_mutex_init( &( pBroker->mutex ), NULL ) == 0 );
+
+    if( ( success == true ) && ( pthread_create( &( pBroker->thread ), NULL, runBroker, pBroker ) != 0 ) )
+    {
+        ( void ) pthread_mutex_destroy( &( pBroker->mutex ) );
+        success = false;
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+void BenchmarkBroker_Stop( BenchmarkBroker_t * pBroker )
+{
+    size_t i;
+
+    ( void ) pthread_mutex_lock( &( pBroker->mutex ) );
+    pBroker->running = false;
+    wakeBroker( pBroker );
+    ( void ) pthread_mutex_unlock( &( pBroker->mutex ) );
+    ( void ) pthread_join( pBroker->thread, NULL );
+
+    for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+    {
+        if( pBroker->clients[ i ].socketDescriptor >= 0 )
+        {
+            closeClient( &( pBroker->clients[ i ] ) );
+        }
+    }
+
+    ( void ) close( pBroker->wakeDescriptors[ 0 ] );
+    ( void ) close( pBroker->wakeDescriptors[ 1 ] );
+    ( void ) pthread_mutex_destroy( &( pBroker->mutex ) );
+}
+
+/*-----------------------------------------------------------*/
+
+int BenchmarkBroker_AddClient( BenchmarkBroker_t * pBroker )
+{
+    int descriptors[ 2 ];
+    int clientDescriptor = -1;
+
+    if( socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, descriptors ) == 0 )
+    {
+        if( addConnection( pBroker, descriptors[ 0 ], descriptors[ 1 ] ) == true )
+        {
+            clientDescriptor = descriptors[ 1 ];
+        }
+        else
+        {
+            ( void ) close( descriptors[ 1 ] );
+        }
+    }
+
+    return clientDescriptor;
+}
+
+/*-----------------------------------------------------------*/
+
+bool BenchmarkBroker_AddSocket( BenchmarkBroker_t * pBroker,
+                                int socketDescriptor )
+{
+    return addConnection( pBroker, socketDescriptor, -1 );
+}
+
+/*-----------------------------------------------------------*/
+
+bool BenchmarkBroker_Flood( BenchmarkBroker_t * pBroker,
+                            int clientDescriptor,
+                            const MQTTPublishInfo_t * pPublishInfo,
+                            size_t count )
+{
+    BenchmarkBrokerClient_t * pClient;
+    bool success = false;
+    size_t i;
+
+    ( void ) pthread_mutex_lock( &( pBroker->mutex ) );
+
+    for( i = 0U; i < BENCHMARK_BROKER_MAX_CLIENTS; i++ )
+    {
+        pClient = &( pBroker->clients[ i ] );
+
+        if( ( pClient->socketDescriptor >= 0 ) && ( pClient->clientDescriptor == clientDescriptor ) &&
+            ( pPublishInfo->topicNameLength < BENCHMARK_BROKER_MAX_FILTER_LENGTH ) )
+        {
+            pClient->floodInfo = *pPublishInfo;
+            ( void ) memcpy( pClient->floodTopic, pPublishInfo->pTopicName, pPublishInfo->topicNameLength );
+            pClient->floodInfo.pTopicName = pClient->floodTopic;
+            pClient->floodRemaining = count;
+            wakeBroker( pBroker );
+            success = true;
+            break;
+        }
+    }
+
+    ( void ) pthread_mutex_unlock( &( pBroker->mutex ) );
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+void BenchmarkBroker_GetStats( BenchmarkBroker_t * pBroker,
+                               BenchmarkBrokerStats_t * pStats )
+{
+    ( void ) pthread_mutex_lock( &( pBroker->mutex ) );
+    *pStats = pBroker->stats;
+    ( void ) pthread_mutex_unlock( &( pBroker->mutex ) );
+}
@@ -0,0 +1,211 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file benchmark_broker.h
+ * @brief A minimal MQTT 3.1.1 broker that runs on a thread of the benchmark
+ * process, for measuring the library without a real broker or network.
+ *
+ * Each client is one end of a UNIX domain socket pair, given to the client
+ * with #BenchmarkBroker_AddClient and used through the POSIX transport, or
+ * a socket accepted by the benchmark and given to #BenchmarkBroker_AddSocket. The
+ * broker answers CONNECT, SUBSCRIBE, UNSUBSCRIBE and PINGREQ, acknowledges
+ * publishes of QoS 1 and 2, and routes every publish to each client with a
+ * matching subscription, at the lower of the two QoS levels. A client
+ * subscribed to the topics it publishes to receives its own messages back.
+ * #BenchmarkBroker_Flood makes the broker send publishes to a client as fast
+ * as the client reads them.
+ *
+ * There are no sessions, retained messages or wills, and routing takes
+ * place when a publish arrives rather than when a QoS 2 flow completes.
+ */
+#ifndef BENCHMARK_BROKER_H
+#define BENCHMARK_BROKER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core_mqtt.h"
+
+/**
+ * @brief Most clients connected at once.
+ */
+#define BENCHMARK_BROKER_MAX_CLIENTS          ( 64U )
+
+/**
+ * @brief Most topic filters of each client.
+ */
+#define BENCHMARK_BROKER_MAX_SUBSCRIPTIONS    ( 8U )
+
+/**
+ * @brief Longest topic filter.
+ */
+#define BENCHMARK_BROKER_MAX_FILTER_LENGTH    ( 128U )
+
+/**
+ * @brief Most publishes of QoS 1 and 2 of a flood that are not yet
+ * acknowledged, as the in-flight limit of a real broker.
+ */
+#define BENCHMARK_BROKER_MAX_INFLIGHT         ( 16U )
+
+/**
+ * @brief Size of the receive buffer of each client, which bounds the size of
+ * the packets the broker accepts.
+ */
+#define BENCHMARK_BROKER_RECEIVE_SIZE         ( 131072U )
+
+/**
+ * @brief A subscription of a client.
+ */
+typedef struct BenchmarkBrokerSubscription
+{
+    char filter[ BENCHMARK_BROKER_MAX_FILTER_LENGTH ]; /**< @brief The topic filter. */
+    uint16_t filterLength;                             /**< @brief Length of filter. */
+    MQTTQoS_t qos;                                     /**< @brief The granted QoS. */
+} BenchmarkBrokerSubscription_t;
+
+/**
+ * @brief The broker side of a client connection.
+ */
+typedef struct BenchmarkBrokerClient
+{
+    int socketDescriptor;                                                              /**< @brief The broker end, or -1 if the slot is free. */
+    int clientDescriptor;                                                              /**< @brief The client end, which identifies the client. */
+    uint8_t * pReceive;                                                                /**< @brief Bytes received and not yet handled. */
+    size_t receiveLength;                                                              /**< @brief Number of bytes in pReceive. */
+    uint8_t * pSend;                                                                   /**< @brief Bytes queued for sending. */
+    size_t sendStart;                                                                  /**< @brief Index of the first unsent byte in pSend. */
+    size_t sendEnd;                                                                    /**< @brief Index after the last queued byte in pSend. */
+    size_t sendSize;                                                                   /**< @brief Size of pSend. */
+    BenchmarkBrokerSubscription_t subscriptions[ BENCHMARK_BROKER_MAX_SUBSCRIPTIONS ]; /**< @brief Topic filters of the client. */
+    size_t subscriptionCount;                                                          /**< @brief Number of subscriptions. */
+    uint16_t nextPacketId;                                                             /**< @brief Packet ID of the next publish sent with QoS 1 or 2. */
+    size_t inflight;                                                                   /**< @brief Publishes of QoS 1 and 2 sent and not yet acknowledged. */
+    MQTTPublishInfo_t floodInfo;                                                       /**< @brief The publish sent by a flood. */
+    char floodTopic[ BENCHMARK_BROKER_MAX_FILTER_LENGTH ];                             /**< @brief Topic of the publish sent by a flood. */
+    size_t floodRemaining;                                                             /**< @brief Number of publishes of the flood left to send. */
+} BenchmarkBrokerClient_t;
+
+/**
+ * @brief Counters of the broker, read with #BenchmarkBroker_GetStats.
+ */
+typedef struct BenchmarkBrokerStats
+{
+    uint64_t publishesReceived; /**< @brief Publishes received from clients. */
+    uint64_t publishesSent;     /**< @brief Publishes routed or flooded to clients. */
+    uint64_t acksReceived;      /**< @brief PUBACK and PUBCOMP packets received from clients. */
+    uint64_t protocolErrors;    /**< @brief Connections closed for a packet the broker did not accept. */
+} BenchmarkBrokerStats_t;
+
+/**
+ * @brief A broker and the thread that runs it.
+ *
+ * The members are private to the broker.
+ */
+typedef struct BenchmarkBroker
+{
+    pthread_t thread;                                                /**< @brief The thread of the broker. */
+    pthread_mutex_t mutex;                                           /**< @brief Guards the members while the thread runs. */
+    int wakeDescriptors[ 2 ];                                        /**< @brief Pipe written to wake the thread. */
+    bool running;                                                    /**< @brief Cleared to stop the thread. */
+    BenchmarkBrokerClient_t clients[ BENCHMARK_BROKER_MAX_CLIENTS ]; /**< @brief The client connections. */
+    BenchmarkBrokerStats_t stats;                                    /**< @brief Counters of the broker. */
+} BenchmarkBroker_t;
+
+/**
+ * @brief Start the thread of a broker.
+ *
+ * @param[out] pBroker The broker to start.
+ *
+ * @return true if the broker runs; false otherwise.
+ */
+bool BenchmarkBroker_Start( BenchmarkBroker_t * pBroker );
+
+/**
+ * @brief Stop the thread of a broker and close the broker end of every
+ * client.
+ *
+ * @param[in] pBroker The broker to stop.
+ */
+void BenchmarkBroker_Stop( BenchmarkBroker_t * pBroker );
+
+/**
+ * @brief Create a connection to the broker.
+ *
+ * @param[in] pBroker The broker.
+ *
+ * @return The client end of the connection, a blocking UNIX domain stream
+ * socket to pass to #PosixTransport_Attach; -1 if the broker has no free slot.
+ */
+int BenchmarkBroker_AddClient( BenchmarkBroker_t * pBroker );
+
+/**
+ * @brief Serve a connected socket, such as one accepted from a loopback TCP
+ * listener.
+ *
+ * @param[in] pBroker The broker.
+ * @param[in] socketDescriptor The broker end of the connection. The broker
+ * owns it from then on, even if the call fails.
+ *
+ * @return true if the broker serves the connection; false if it has no free
+ * slot. A flood cannot be sent to such a connection.
+ */
+bool BenchmarkBroker_AddSocket( BenchmarkBroker_t * pBroker,
+                                int socketDescriptor );
+
+/**
+ * @brief Send publishes from the broker to a client.
+ *
+ * The broker writes as many as fit in the socket buffer and queues the rest
+ * as the client reads them. Publishes of QoS 1 and 2 get packet IDs of their
+ * own, and their acknowledgments are answered as for routed publishes. At
+ * most #BENCHMARK_BROKER_MAX_INFLIGHT of them wait for acknowledgments.
+ *
+ * @param[in] pBroker The broker.
+ * @param[in] clientDescriptor The client end returned by
+ * #BenchmarkBroker_AddClient.
+ * @param[in] pPublishInfo The publish to send. The topic is copied, and the
+ * payload must stay valid until every publish has been sent.
+ * @param[in] count Number of publishes to send.
+ *
+ * @return true if the flood was started; false if the client is not known
+ * or the topic is too long.
+ */
+bool BenchmarkBroker_Flood( BenchmarkBroker_t * pBroker,
+                            int clientDescriptor,
+                            const MQTTPublishInfo_t * pPublishInfo,
+                            size_t count );
+
+/**
+ * @brief Read the counters of a broker.
+ *
+ * @param[in] pBroker The broker.
+ * @param[out] pStats The counters.
+ */
+void BenchmarkBroker_GetStats( BenchmarkBroker_t * pBroker,
+                               BenchmarkBrokerStats_t * pStats );
+
+#endif /* ifndef BENCHMARK_BROKER_H */
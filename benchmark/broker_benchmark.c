@@ -0,0 +1,631 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file broker_benchmark.c
+ * @brief Measures publish and receive rates of the library against the broker
+ * of benchmark_broker.h, over UNIX domain socket pairs and the POSIX
+ * transport.
+ *
+ * - `publish`: one client publishes to a topic nobody subscribes to, keeping
+ *   up to #WINDOW_SIZE publishes of QoS 1 and 2, or #WINDOW_BYTES of
+ *   payload, in flight. A last publish of
+ *   QoS 1 marks the end of a QoS 0 run.
+ * - `echo`: one client subscribes to the topic it publishes to, and receives
+ *   each message back through #MQTT_ProcessLoop.
+ * - `fanout`: one client publishes to #FANOUT_SUBSCRIBERS subscribed clients,
+ *   a window at a time.
+ * - `ingress`: the broker floods one client, which only runs
+ *   #MQTT_ProcessLoop.
+ *
+ * Each is run for QoS 0, 1 and 2 and several payload sizes. Results are
+ * printed as CSV with the columns
+ * `benchmark,qos,payload_bytes,clients,messages,messages_per_sec,mbytes_per_sec`,
+ * where the rate counts messages delivered to the receiving clients, or
+ * published when nobody receives them.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+#include "benchmark_broker.h"
+
+/**
+ * @brief Most messages in a run.
+ */
+#define MAX_MESSAGE_COUNT      ( 100000U )
+
+/**
+ * @brief Payload bytes of a run, which bounds the messages of large payloads.
+ */
+#define PAYLOAD_BYTE_BUDGET    ( 64U * 1024U * 1024U )
+
+/**
+ * @brief Most publishes in flight, and the number of QoS records of each
+ * context.
+ */
+#define WINDOW_SIZE            ( 32U )
+
+/**
+ * @brief Most payload bytes in flight, which keeps the messages echoed or
+ * fanned out within the queues of the broker while the clients publish.
+ */
+#define WINDOW_BYTES           ( 65536U )
+
+/**
+ * @brief Number of subscribers of the fanout benchmark.
+ */
+#define FANOUT_SUBSCRIBERS     ( 4U )
+
+/**
+ * @brief Size of the network buffer of each context, which holds the
+ * largest payload.
+ */
+#define NETWORK_BUFFER_SIZE    ( 20480U )
+
+/**
+ * @brief Time to wait for a packet before a run fails.
+ */
+#define WAIT_TIMEOUT_MS        ( 5000U )
+
+/**
+ * @brief Topic name of the published messages.
+ */
+#define TOPIC_NAME             "benchmark/broker/telemetry"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A client of the broker.
+ */
+typedef struct BenchmarkClient
+{
+    MQTTContext_t context;                             /**< @brief The MQTT context, first so the event callback finds the client. */
+    PosixTransport_t posixTransport;                   /**< @brief The connection to the broker. */
+    TransportInterface_t transport;                    /**< @brief The transport interface of the connection. */
+    uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];      /**< @brief The network buffer of the context. */
+    MQTTPubAckInfo_t outgoingRecords[ WINDOW_SIZE ];   /**< @brief Records of outgoing publishes of QoS 1 and 2. */
+    MQTTPubAckInfo_t incomingRecords[ WINDOW_SIZE ];   /**< @brief Records of incoming publishes of QoS 1 and 2. */
+    size_t received;                                   /**< @brief Publishes received. */
+    size_t completed;                                  /**< @brief Outgoing publishes of QoS 1 and 2 acknowledged. */
+    size_t subAcks;                                    /**< @brief SUBACK packets received. */
+    size_t packets;                                    /**< @brief Packets of any type received. */
+} BenchmarkClient_t;
+
+static BenchmarkBroker_t broker;
+static BenchmarkClient_t clients[ FANOUT_SUBSCRIBERS + 1U ];
+static uint8_t payload[ 16384 ];
+static size_t window;
+
+/**
+ * @brief Payload sizes of each benchmark.
+ */
+static const size_t payloadSizes[] = { 16U, 256U, 4096U, 16384U };
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    BenchmarkClient_t * pClient = ( BenchmarkClient_t * ) pContext;
+
+    ( void ) pDeserializedInfo;
+
+    pClient->packets++;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        pClient->received++;
+    }
+    else if( ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK ) || ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBCOMP ) )
+    {
+        pClient->completed++;
+    }
+    else if( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK )
+    {
+        pClient->subAcks++;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connect a client to the broker.
+ */
+static MQTTStatus_t connectClient( BenchmarkClient_t * pClient,
+                                   const char * pClientIdentifier )
+{
+    MQTTFixedBuffer_t fixedBuffer = { pClient->networkBuffer, NETWORK_BUFFER_SIZE };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    PosixTransportConfig_t config = { 0 };
+    MQTTStatus_t status = MQTTSuccess;
+    bool sessionPresent = false;
+    int socketDescriptor;
+
+    ( void ) memset( pClient, 0, sizeof( *pClient ) );
+    socketDescriptor = BenchmarkBroker_AddClient( &broker );
+
+    if( ( socketDescriptor < 0 ) ||
+        ( PosixTransport_Attach( &( pClient->posixTransport ), socketDescriptor, &config ) != PosixTransportSuccess ) )
+    {
+        status = MQTTSendFailed;
+    }
+
+    if( status == MQTTSuccess )
+    {
+        PosixTransport_GetInterface( &( pClient->posixTransport ), &( pClient->transport ) );
+        status = MQTT_Init( &( pClient->context ), &( pClient->transport ), getTimeMs, eventCallback, &fixedBuffer );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_InitStatefulQoS( &( pClient->context ), pClient->outgoingRecords, WINDOW_SIZE,
+                                       pClient->incomingRecords, WINDOW_SIZE );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        connectInfo.cleanSession = true;
+        connectInfo.pClientIdentifier = pClientIdentifier;
+        connectInfo.clientIdentifierLength = ( uint16_t ) strlen( pClientIdentifier );
+        status = MQTT_Connect( &( pClient->context ), &connectInfo, NULL, WAIT_TIMEOUT_MS, &sessionPresent );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Disconnect a client from the broker.
+ */
+static void disconnectClient( BenchmarkClient_t * pClient )
+{
+    ( void ) MQTT_Disconnect( &( pClient->context ) );
+    ( void ) PosixTransport_Disconnect( &( pClient->posixTransport ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run #MQTT_ProcessLoop until a counter of a client reaches a value.
+ */
+static MQTTStatus_t processUntil( BenchmarkClient_t * pClient,
+                                  const size_t * pCounter,
+                                  size_t target )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t idleSinceMs = getTimeMs();
+    size_t before;
+
+    while( ( status == MQTTSuccess ) && ( *pCounter < target ) )
+    {
+        before = pClient->packets;
+        status = MQTT_ProcessLoop( &( pClient->context ) );
+
+        /* The rest of a partly received packet comes with the next call. */
+        status = ( status == MQTTNeedMoreBytes ) ? MQTTSuccess : status;
+
+        if( pClient->packets != before )
+        {
+            idleSinceMs = getTimeMs();
+        }
+        else if( ( getTimeMs() - idleSinceMs ) > WAIT_TIMEOUT_MS )
+        {
+            status = MQTTRecvFailed;
+        }
+        else
+        {
+            /* Nothing complete is buffered, so wait for the socket. */
+            ( void ) PosixTransport_WaitReadable( ( NetworkContext_t * ) &( pClient->posixTransport ), 10U );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Subscribe a client to the topic of the messages.
+ */
+static MQTTStatus_t subscribeClient( BenchmarkClient_t * pClient,
+                                     MQTTQoS_t qos )
+{
+    MQTTSubscribeInfo_t subscription = { 0 };
+    MQTTStatus_t status;
+
+    subscription.qos = qos;
+    subscription.pTopicFilter = TOPIC_NAME;
+    subscription.topicFilterLength = ( uint16_t ) strlen( TOPIC_NAME );
+
+    status = MQTT_Subscribe( &( pClient->context ), &subscription, 1U, MQTT_GetPacketId( &( pClient->context ) ) );
+
+    if( status == MQTTSuccess )
+    {
+        status = processUntil( pClient, &( pClient->subAcks ), 1U );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish a message from a client, waiting for an acknowledgment if
+ * the window is full.
+ */
+static MQTTStatus_t publishWindowed( BenchmarkClient_t * pClient,
+                                     MQTTPublishInfo_t * pPublishInfo,
+                                     size_t published )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint16_t packetId = 0U;
+
+    if( pPublishInfo->qos != MQTTQoS0 )
+    {
+        if( ( published - pClient->completed ) >= window )
+        {
+            status = processUntil( pClient, &( pClient->completed ), published - window + 1U );
+        }
+
+        packetId = MQTT_GetPacketId( &( pClient->context ) );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_Publish( &( pClient->context ), pPublishInfo, packetId );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Print a result row.
+ */
+static void printResult( const char * pBenchmark,
+                         MQTTQoS_t qos,
+                         size_t payloadSize,
+                         size_t clientCount,
+                         size_t messageCount,
+                         uint64_t elapsedNs )
+{
+    printf( "%s,%d,%zu,%zu,%zu,%.0f,%.1f\n", pBenchmark, ( int ) qos, payloadSize, clientCount, messageCount,
+            ( ( double ) messageCount * 1e9 ) / ( double ) elapsedNs,
+            ( ( double ) messageCount * ( double ) payloadSize * 1000.0 ) / ( double ) elapsedNs );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish to a topic without subscribers.
+ */
+static MQTTStatus_t runPublish( MQTTQoS_t qos,
+                                size_t payloadSize,
+                                size_t messageCount )
+{
+    BenchmarkClient_t * pClient = &( clients[ 0 ] );
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status;
+    uint64_t start;
+    size_t i;
+
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = payloadSize;
+
+    status = connectClient( pClient, "publisher" );
+    start = nowNs();
+
+    for( i = 0U; ( i < messageCount ) && ( status == MQTTSuccess ); i++ )
+    {
+        status = publishWindowed( pClient, &publishInfo, i );
+    }
+
+    /* The broker handles packets in order, so the ack of a last publish of
+     * QoS 1 means every publish before it was received. */
+    if( ( status == MQTTSuccess ) && ( qos == MQTTQoS0 ) )
+    {
+        publishInfo.qos = MQTTQoS1;
+        publishInfo.payloadLength = 0U;
+        status = MQTT_Publish( &( pClient->context ), &publishInfo, MQTT_GetPacketId( &( pClient->context ) ) );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = processUntil( pClient, &( pClient->completed ), ( qos == MQTTQoS0 ) ? 1U : messageCount );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        printResult( "publish", qos, payloadSize, 1U, messageCount, nowNs() - start );
+    }
+
+    disconnectClient( pClient );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish to a topic the publisher is subscribed to.
+ */
+static MQTTStatus_t runEcho( MQTTQoS_t qos,
+                             size_t payloadSize,
+                             size_t messageCount )
+{
+    BenchmarkClient_t * pClient = &( clients[ 0 ] );
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status;
+    uint64_t start;
+    size_t i;
+
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = payloadSize;
+
+    status = connectClient( pClient, "echo" );
+
+    if( status == MQTTSuccess )
+    {
+        status = subscribeClient( pClient, qos );
+    }
+
+    start = nowNs();
+
+    for( i = 0U; ( i < messageCount ) && ( status == MQTTSuccess ); i++ )
+    {
+        /* Keep the echoed messages in flight within the window too. */
+        if( ( i - pClient->received ) >= window )
+        {
+            status = processUntil( pClient, &( pClient->received ), i - window + 1U );
+        }
+
+        if( status == MQTTSuccess )
+        {
+            status = publishWindowed( pClient, &publishInfo, i );
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = processUntil( pClient, &( pClient->received ), messageCount );
+    }
+
+    if( ( status == MQTTSuccess ) && ( qos != MQTTQoS0 ) )
+    {
+        status = processUntil( pClient, &( pClient->completed ), messageCount );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        printResult( "echo", qos, payloadSize, 1U, messageCount, nowNs() - start );
+    }
+
+    disconnectClient( pClient );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish from one client to several subscribers.
+ */
+static MQTTStatus_t runFanout( MQTTQoS_t qos,
+                               size_t payloadSize,
+                               size_t messageCount )
+{
+    BenchmarkClient_t * pPublisher = &( clients[ 0 ] );
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status;
+    char clientIdentifier[ 16 ];
+    uint64_t start;
+    size_t i, j;
+
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = payloadSize;
+
+    status = connectClient( pPublisher, "publisher" );
+
+    for( j = 1U; ( j <= FANOUT_SUBSCRIBERS ) && ( status == MQTTSuccess ); j++ )
+    {
+        ( void ) snprintf( clientIdentifier, sizeof( clientIdentifier ), "subscriber%zu", j );
+        status = connectClient( &( clients[ j ] ), clientIdentifier );
+
+        if( status == MQTTSuccess )
+        {
+            status = subscribeClient( &( clients[ j ] ), qos );
+        }
+    }
+
+    start = nowNs();
+
+    /* The clients run on one thread, so the subscribers catch up after each
+     * window of publishes. */
+    for( i = 0U; ( i < messageCount ) && ( status == MQTTSuccess ); i++ )
+    {
+        status = publishWindowed( pPublisher, &publishInfo, i );
+
+        for( j = 1U; ( ( ( i + 1U ) % window ) == 0U ) && ( j <= FANOUT_SUBSCRIBERS ) && ( status == MQTTSuccess ); j++ )
+        {
+            status = processUntil( &( clients[ j ] ), &( clients[ j ].received ), i + 1U );
+        }
+    }
+
+    for( j = 1U; ( j <= FANOUT_SUBSCRIBERS ) && ( status == MQTTSuccess ); j++ )
+    {
+        status = processUntil( &( clients[ j ] ), &( clients[ j ].received ), messageCount );
+    }
+
+    if( ( status == MQTTSuccess ) && ( qos != MQTTQoS0 ) )
+    {
+        status = processUntil( pPublisher, &( pPublisher->completed ), messageCount );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        printResult( "fanout", qos, payloadSize, FANOUT_SUBSCRIBERS + 1U, messageCount * FANOUT_SUBSCRIBERS,
+                     nowNs() - start );
+    }
+
+    for( j = 0U; j <= FANOUT_SUBSCRIBERS; j++ )
+    {
+        disconnectClient( &( clients[ j ] ) );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive a flood of publishes from the broker.
+ */
+static MQTTStatus_t runIngress( MQTTQoS_t qos,
+                                size_t payloadSize,
+                                size_t messageCount )
+{
+    BenchmarkClient_t * pClient = &( clients[ 0 ] );
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status;
+    uint64_t start;
+
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = payloadSize;
+
+    status = connectClient( pClient, "subscriber" );
+    start = nowNs();
+
+    if( ( status == MQTTSuccess ) &&
+        ( BenchmarkBroker_Flood( &broker, pClient->posixTransport.socketDescriptor, &publishInfo,
+                                 messageCount ) == false ) )
+    {
+        status = MQTTBadParameter;
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = processUntil( pClient, &( pClient->received ), messageCount );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        printResult( "ingress", qos, payloadSize, 1U, messageCount, nowNs() - start );
+    }
+
+    disconnectClient( pClient );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    static MQTTStatus_t ( * const benchmarks[] )( MQTTQoS_t, size_t, size_t ) =
+    {
+        runPublish, runEcho, runFanout, runIngress
+    };
+    MQTTStatus_t status = MQTTSuccess;
+    size_t messageCount, i, j;
+    int qos;
+
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    if( BenchmarkBroker_Start( &broker ) == false )
+    {
+        fprintf( stderr, "Failed to start the broker\n" );
+        return EXIT_FAILURE;
+    }
+
+    printf( "benchmark,qos,payload_bytes,clients,messages,messages_per_sec,mbytes_per_sec\n" );
+
+    for( i = 0U; ( i < ( sizeof( benchmarks ) / sizeof( benchmarks[ 0 ] ) ) ) && ( status == MQTTSuccess ); i++ )
+    {
+        for( qos = 0; ( qos <= 2 ) && ( status == MQTTSuccess ); qos++ )
+        {
+            for( j = 0U; ( j < ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ) ) && ( status == MQTTSuccess ); j++ )
+            {
+                messageCount = PAYLOAD_BYTE_BUDGET / payloadSizes[ j ];
+                messageCount = ( messageCount < MAX_MESSAGE_COUNT ) ? messageCount : MAX_MESSAGE_COUNT;
+                window = WINDOW_BYTES / payloadSizes[ j ];
+                window = ( window < WINDOW_SIZE ) ? window : WINDOW_SIZE;
+                status = benchmarks[ i ]( ( MQTTQoS_t ) qos, payloadSizes[ j ], messageCount );
+            }
+        }
+    }
+
+    if( status != MQTTSuccess )
+    {
+        fprintf( stderr, "A benchmark failed: %s\n", MQTT_Status_strerror( status ) );
+    }
+
+    BenchmarkBroker_Stop( &broker );
+
+    return ( status == MQTTSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,62 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_config.h
+ * @brief Configuration of the library built for contention_benchmark.c.
+ *
+ * The send hooks and the state update hooks call functions of the benchmark,
+ * which lock the context with the lock of the variant being measured.
+ */
+#ifndef CORE_MQTT_CONFIG_H_
+#define CORE_MQTT_CONFIG_H_
+
+struct MQTTContext;
+
+/**
+ * @brief Lock the context before its state is updated.
+ */
+void ContentionBenchmark_LockState( const struct MQTTContext * pContext );
+
+/**
+ * @brief Unlock the context after its state is updated.
+ */
+void ContentionBenchmark_UnlockState( const struct MQTTContext * pContext );
+
+/**
+ * @brief Lock the context before bytes are sent.
+ */
+void ContentionBenchmark_LockSend( const struct MQTTContext * pContext );
+
+/**
+ * @brief Unlock the context after bytes are sent.
+ */
+void ContentionBenchmark_UnlockSend( const struct MQTTContext * pContext );
+
+#define MQTT_PRE_STATE_UPDATE_HOOK( pContext )     ContentionBenchmark_LockState( pContext )
+#define MQTT_POST_STATE_UPDATE_HOOK( pContext )    ContentionBenchmark_UnlockState( pContext )
+#define MQTT_PRE_SEND_HOOK( pContext )             ContentionBenchmark_LockSend( pContext )
+#define MQTT_POST_SEND_HOOK( pContext )            ContentionBenchmark_UnlockSend( pContext )
+
+#endif /* ifndef CORE_MQTT_CONFIG_H_ */
@@ -0,0 +1,624 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file contention_benchmark.c
+ * @brief Measures how the state update hooks scale when several threads
+ * publish on one context while another thread runs #MQTT_ReceiveLoop.
+ *
+ * The library is built with the configuration in `contention/`, whose hooks
+ * call the lock functions of this file. Each variant is built from it:
+ *
+ * - `mutex`: the hooks lock a `pthread_mutex_t`.
+ * - `spinlock`: the hooks lock a `pthread_spinlock_t`.
+ * - `none`: the library is built without hooks. It is not safe to share
+ *   the context between threads then, so one thread publishes and runs
+ *   #MQTT_ReceiveLoop in turn, which gives the rate without locking.
+ *
+ * Publishers send QoS 1 messages to the broker of benchmark_broker.h, which
+ * nobody subscribes to, and retry while the records of the context are
+ * full. Each run sends #MESSAGE_COUNT messages split evenly between the
+ * publishers. Results are printed as CSV with the columns
+ * `benchmark,hooks,publishers,messages,messages_per_sec,record_retries,lock_acquisitions,wait_mean_ns,wait_max_ns,hold_mean_ns,ack_p50_ns,ack_p99_ns`,
+ * where the lock times cover the state update hooks of every thread, and the
+ * ack latency is from the start of #MQTT_Publish to the PUBACK reaching the
+ * event callback.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+#include "benchmark_broker.h"
+
+#ifndef BENCHMARK_VARIANT
+    #define BENCHMARK_VARIANT    "none"
+#endif
+
+/**
+ * @brief Lock taken by the hooks: 0 for none, 1 for a mutex and 2 for a
+ * spinlock.
+ */
+#ifndef CONTENTION_LOCK
+    #define CONTENTION_LOCK    0
+#endif
+
+/**
+ * @brief Messages of each run.
+ */
+#define MESSAGE_COUNT          ( 80000U )
+
+/**
+ * @brief Most publisher threads.
+ */
+#define MAX_PUBLISHERS         ( 8U )
+
+/**
+ * @brief Number of QoS records of the context, shared by the publishers.
+ */
+#define RECORD_COUNT           ( 64U )
+
+/**
+ * @brief Payload bytes of each message.
+ */
+#define PAYLOAD_SIZE           ( 64U )
+
+/**
+ * @brief Size of the network buffer of the context.
+ */
+#define NETWORK_BUFFER_SIZE    ( 4096U )
+
+/**
+ * @brief Time to wait for a packet before a run fails.
+ */
+#define WAIT_TIMEOUT_MS        ( 5000U )
+
+/**
+ * @brief Topic name of the published messages.
+ */
+#define TOPIC_NAME             "benchmark/contention/telemetry"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Lock times of one thread.
+ */
+typedef struct LockStats
+{
+    uint64_t acquisitions; /**< @brief Times the state lock was taken. */
+    uint64_t waitNs;       /**< @brief Total time spent waiting for the lock. */
+    uint64_t maxWaitNs;    /**< @brief Longest wait for the lock. */
+    uint64_t holdNs;       /**< @brief Total time the lock was held. */
+    uint64_t lockedAtNs;   /**< @brief When the lock was last taken. */
+} LockStats_t;
+
+/**
+ * @brief A publisher thread.
+ */
+typedef struct Publisher
+{
+    pthread_t thread;     /**< @brief The thread. */
+    size_t messageCount;  /**< @brief Messages to publish. */
+    size_t retries;       /**< @brief Publishes retried because the records were full. */
+    MQTTStatus_t status;  /**< @brief Result of the thread. */
+    LockStats_t stats;    /**< @brief Lock times of the thread. */
+} Publisher_t;
+
+static BenchmarkBroker_t broker;
+static MQTTContext_t context;
+static PosixTransport_t posixTransport;
+static TransportInterface_t transport;
+static uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];
+static MQTTPubAckInfo_t outgoingRecords[ RECORD_COUNT ];
+static uint8_t payload[ PAYLOAD_SIZE ];
+static Publisher_t publishers[ MAX_PUBLISHERS ];
+static LockStats_t receiverStats;
+
+/**
+ * @brief When each packet ID was last published.
+ */
+static uint64_t sendTimes[ 65536 ];
+
+/**
+ * @brief Ack latency of each message, in the order of the PUBACKs.
+ */
+static uint64_t ackLatencies[ MESSAGE_COUNT ];
+
+/**
+ * @brief PUBACKs received in the run, read by the publishing thread.
+ */
+static size_t acked;
+
+/**
+ * @brief Packets of any type received in the run.
+ */
+static size_t packets;
+
+/**
+ * @brief The lock times of the calling thread, or NULL to not record them.
+ */
+static __thread LockStats_t * pThreadStats;
+
+#if CONTENTION_LOCK == 1
+    static pthread_mutex_t stateLock = PTHREAD_MUTEX_INITIALIZER;
+    static pthread_mutex_t sendLock = PTHREAD_MUTEX_INITIALIZER;
+#elif CONTENTION_LOCK == 2
+    static pthread_spinlock_t stateLock;
+    static pthread_spinlock_t sendLock;
+#endif
+
+/**
+ * @brief Publisher thread counts of each run.
+ */
+static const size_t publisherCounts[] = { 1U, 2U, 4U, 8U };
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+void ContentionBenchmark_LockState( const struct MQTTContext * pContext )
+{
+    uint64_t start = nowNs();
+    uint64_t waitNs;
+
+    ( void ) pContext;
+
+    #if CONTENTION_LOCK == 1
+        ( void ) pthread_mutex_lock( &stateLock );
+    #elif CONTENTION_LOCK == 2
+        ( void ) pthread_spin_lock( &stateLock );
+    #endif
+
+    if( pThreadStats != NULL )
+    {
+        pThreadStats->lockedAtNs = nowNs();
+        waitNs = pThreadStats->lockedAtNs - start;
+        pThreadStats->acquisitions++;
+        pThreadStats->waitNs += waitNs;
+        pThreadStats->maxWaitNs = ( waitNs > pThreadStats->maxWaitNs ) ? waitNs : pThreadStats->maxWaitNs;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+void ContentionBenchmark_UnlockState( const struct MQTTContext * pContext )
+{
+    ( void ) pContext;
+
+    if( pThreadStats != NULL )
+    {
+        pThreadStats->holdNs += nowNs() - pThreadStats->lockedAtNs;
+    }
+
+    #if CONTENTION_LOCK == 1
+        ( void ) pthread_mutex_unlock( &stateLock );
+    #elif CONTENTION_LOCK == 2
+        ( void ) pthread_spin_unlock( &stateLock );
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+void ContentionBenchmark_LockSend( const struct MQTTContext * pContext )
+{
+    ( void ) pContext;
+
+    #if CONTENTION_LOCK == 1
+        ( void ) pthread_mutex_lock( &sendLock );
+    #elif CONTENTION_LOCK == 2
+        ( void ) pthread_spin_lock( &sendLock );
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+void ContentionBenchmark_UnlockSend( const struct MQTTContext * pContext )
+{
+    ( void ) pContext;
+
+    #if CONTENTION_LOCK == 1
+        ( void ) pthread_mutex_unlock( &sendLock );
+    #elif CONTENTION_LOCK == 2
+        ( void ) pthread_spin_unlock( &sendLock );
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    size_t count;
+
+    ( void ) pContext;
+
+    packets++;
+
+    if( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK )
+    {
+        /* Only this thread writes the count, so it is read once. */
+        count = __atomic_load_n( &acked, __ATOMIC_RELAXED );
+
+        if( count < MESSAGE_COUNT )
+        {
+            ackLatencies[ count ] = nowNs() - sendTimes[ pDeserializedInfo->packetIdentifier ];
+        }
+
+        __atomic_store_n( &acked, count + 1U, __ATOMIC_RELEASE );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run #MQTT_ReceiveLoop until a number of PUBACKs have been received.
+ */
+static MQTTStatus_t receiveUntil( size_t target )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t idleSinceMs = getTimeMs();
+    size_t before;
+
+    while( ( status == MQTTSuccess ) && ( __atomic_load_n( &acked, __ATOMIC_ACQUIRE ) < target ) )
+    {
+        before = packets;
+        status = MQTT_ReceiveLoop( &context );
+
+        /* The rest of a partly received packet comes with the next call. */
+        status = ( status == MQTTNeedMoreBytes ) ? MQTTSuccess : status;
+
+        if( packets != before )
+        {
+            idleSinceMs = getTimeMs();
+        }
+        else if( ( getTimeMs() - idleSinceMs ) > WAIT_TIMEOUT_MS )
+        {
+            status = MQTTRecvFailed;
+        }
+        else
+        {
+            /* Nothing complete is buffered, so wait for the socket. */
+            ( void ) PosixTransport_WaitReadable( ( NetworkContext_t * ) &posixTransport, 10U );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish the messages of a publisher, retrying while the records are
+ * full.
+ *
+ * Without hooks, the PUBACKs are received on the same thread when the
+ * records are full.
+ */
+static MQTTStatus_t publishMessages( Publisher_t * pPublisher )
+{
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status = MQTTSuccess;
+    uint16_t packetId;
+    size_t i;
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = PAYLOAD_SIZE;
+
+    for( i = 0U; ( i < pPublisher->messageCount ) && ( status == MQTTSuccess ); i++ )
+    {
+        packetId = MQTT_GetPacketId( &context );
+
+        do
+        {
+            sendTimes[ packetId ] = nowNs();
+            status = MQTT_Publish( &context, &publishInfo, packetId );
+
+            if( status == MQTTNoMemory )
+            {
+                pPublisher->retries++;
+
+                #if CONTENTION_LOCK == 0
+                    status = receiveUntil( __atomic_load_n( &acked, __ATOMIC_ACQUIRE ) + 1U );
+                    status = ( status == MQTTSuccess ) ? MQTTNoMemory : status;
+                #else
+                    ( void ) sched_yield();
+                #endif
+            }
+        } while( status == MQTTNoMemory );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+#if CONTENTION_LOCK != 0
+
+static void * publisherThread( void * pArgument )
+{
+    Publisher_t * pPublisher = ( Publisher_t * ) pArgument;
+
+    pThreadStats = &( pPublisher->stats );
+    pPublisher->status = publishMessages( pPublisher );
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static void * receiverThread( void * pArgument )
+{
+    MQTTStatus_t * pStatus = ( MQTTStatus_t * ) pArgument;
+
+    pThreadStats = &receiverStats;
+    *pStatus = receiveUntil( MESSAGE_COUNT );
+
+    return NULL;
+}
+
+#endif /* if CONTENTION_LOCK != 0 */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connect the context to the broker.
+ */
+static MQTTStatus_t connectContext( void )
+{
+    MQTTFixedBuffer_t fixedBuffer = { networkBuffer, NETWORK_BUFFER_SIZE };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    PosixTransportConfig_t config = { 0 };
+    MQTTStatus_t status = MQTTSuccess;
+    bool sessionPresent = false;
+    int socketDescriptor;
+
+    socketDescriptor = BenchmarkBroker_AddClient( &broker );
+
+    if( ( socketDescriptor < 0 ) ||
+        ( PosixTransport_Attach( &posixTransport, socketDescriptor, &config ) != PosixTransportSuccess ) )
+    {
+        status = MQTTSendFailed;
+    }
+
+    if( status == MQTTSuccess )
+    {
+        PosixTransport_GetInterface( &posixTransport, &transport );
+        status = MQTT_Init( &context, &transport, getTimeMs, eventCallback, &fixedBuffer );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_InitStatefulQoS( &context, outgoingRecords, RECORD_COUNT, NULL, 0U );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        /* Without a keep-alive, the receive thread never sends a PINGREQ. */
+        connectInfo.cleanSession = true;
+        connectInfo.pClientIdentifier = "contention";
+        connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+        status = MQTT_Connect( &context, &connectInfo, NULL, WAIT_TIMEOUT_MS, &sessionPresent );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static int compareLatencies( const void * pLeft,
+                             const void * pRight )
+{
+    uint64_t left = *( const uint64_t * ) pLeft;
+    uint64_t right = *( const uint64_t * ) pRight;
+
+    return ( left > right ) - ( left < right );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Print a result row from the stats of the publishers and receiver.
+ */
+static void printResult( size_t publisherCount,
+                         uint64_t elapsedNs )
+{
+    LockStats_t total = receiverStats;
+    size_t retries = 0U;
+    double divisor;
+    size_t i;
+
+    for( i = 0U; i < publisherCount; i++ )
+    {
+        total.acquisitions += publishers[ i ].stats.acquisitions;
+        total.waitNs += publishers[ i ].stats.waitNs;
+        total.holdNs += publishers[ i ].stats.holdNs;
+        total.maxWaitNs = ( publishers[ i ].stats.maxWaitNs > total.maxWaitNs ) ? publishers[ i ].stats.maxWaitNs : total.maxWaitNs;
+        retries += publishers[ i ].retries;
+    }
+
+    /* The variant without hooks takes no lock. */
+    divisor = ( total.acquisitions == 0U ) ? 1.0 : ( double ) total.acquisitions;
+
+    qsort( ackLatencies, MESSAGE_COUNT, sizeof( ackLatencies[ 0 ] ), compareLatencies );
+
+    printf( "contention,%s,%zu,%u,%.0f,%zu,%llu,%.0f,%llu,%.0f,%llu,%llu\n",
+            BENCHMARK_VARIANT, publisherCount, MESSAGE_COUNT,
+            ( ( double ) MESSAGE_COUNT * 1e9 ) / ( double ) elapsedNs,
+            retries,
+            ( unsigned long long ) total.acquisitions,
+            ( double ) total.waitNs / divisor,
+            ( unsigned long long ) total.maxWaitNs,
+            ( double ) total.holdNs / divisor,
+            ( unsigned long long ) ackLatencies[ MESSAGE_COUNT / 2U ],
+            ( unsigned long long ) ackLatencies[ ( MESSAGE_COUNT * 99U ) / 100U ] );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish from several threads while one thread receives the acks.
+ */
+static MQTTStatus_t runContention( size_t publisherCount )
+{
+    MQTTStatus_t status;
+    uint64_t start;
+
+    #if CONTENTION_LOCK != 0
+        MQTTStatus_t receiveStatus = MQTTSuccess;
+        bool receiverStarted = false;
+        pthread_t receiver;
+        size_t i;
+    #endif
+
+    ( void ) memset( publishers, 0, sizeof( publishers ) );
+    ( void ) memset( &receiverStats, 0, sizeof( receiverStats ) );
+    acked = 0U;
+    packets = 0U;
+
+    status = connectContext();
+    start = nowNs();
+
+    #if CONTENTION_LOCK == 0
+        /* The context is not safe to share between threads without hooks. */
+        publishers[ 0 ].messageCount = MESSAGE_COUNT;
+
+        if( status == MQTTSuccess )
+        {
+            status = publishMessages( &( publishers[ 0 ] ) );
+        }
+
+        if( status == MQTTSuccess )
+        {
+            status = receiveUntil( MESSAGE_COUNT );
+        }
+    #else
+        if( status == MQTTSuccess )
+        {
+            receiverStarted = ( pthread_create( &receiver, NULL, receiverThread, &receiveStatus ) == 0 );
+            status = receiverStarted ? MQTTSuccess : MQTTIllegalState;
+        }
+
+        for( i = 0U; ( i < publisherCount ) && ( status == MQTTSuccess ); i++ )
+        {
+            publishers[ i ].messageCount = MESSAGE_COUNT / publisherCount;
+
+            if( pthread_create( &( publishers[ i ].thread ), NULL, publisherThread, &( publishers[ i ] ) ) != 0 )
+            {
+                status = MQTTIllegalState;
+            }
+        }
+
+        /* A run that failed to start every thread leaves the receiver to
+         * time out. */
+        while( i > 0U )
+        {
+            i--;
+            ( void ) pthread_join( publishers[ i ].thread, NULL );
+            status = ( status == MQTTSuccess ) ? publishers[ i ].status : status;
+        }
+
+        if( receiverStarted )
+        {
+            ( void ) pthread_join( receiver, NULL );
+            status = ( status == MQTTSuccess ) ? receiveStatus : status;
+        }
+    #endif /* if CONTENTION_LOCK == 0 */
+
+    if( status == MQTTSuccess )
+    {
+        printResult( publisherCount, nowNs() - start );
+    }
+
+    ( void ) MQTT_Disconnect( &context );
+    ( void ) PosixTransport_Disconnect( &posixTransport );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    size_t i;
+
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    #if CONTENTION_LOCK == 2
+        ( void ) pthread_spin_init( &stateLock, PTHREAD_PROCESS_PRIVATE );
+        ( void ) pthread_spin_init( &sendLock, PTHREAD_PROCESS_PRIVATE );
+    #endif
+
+    if( BenchmarkBroker_Start( &broker ) == false )
+    {
+        fprintf( stderr, "Failed to start the broker\n" );
+        return EXIT_FAILURE;
+    }
+
+    printf( "benchmark,hooks,publishers,messages,messages_per_sec,record_retries,lock_acquisitions,wait_mean_ns,wait_max_ns,hold_mean_ns,ack_p50_ns,ack_p99_ns\n" );
+
+    /* Without hooks, only one thread uses the context. */
+    for( i = 0U; ( i < ( ( CONTENTION_LOCK == 0 ) ? 1U : ( sizeof( publisherCounts ) / sizeof( publisherCounts[ 0 ] ) ) ) ) &&
+         ( status == MQTTSuccess ); i++ )
+    {
+        status = runContention( publisherCounts[ i ] );
+    }
+
+    if( status != MQTTSuccess )
+    {
+        fprintf( stderr, "A benchmark failed: %s\n", MQTT_Status_strerror( status ) );
+    }
+
+    BenchmarkBroker_Stop( &broker );
+
+    return ( status == MQTTSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,773 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file latency_benchmark.c
+ * @brief Measures the round-trip latency of publishes echoed by the broker of
+ * benchmark_broker.h, at fixed offered loads.
+ *
+ * A client subscribes to the topic it publishes to. Publishes are sent on a
+ * fixed schedule, whatever the latency of earlier ones, and each carries
+ * the time it was due to be sent. The latency of a message is counted from
+ * that time to the time #MQTT_ProcessLoop hands the echo to the event
+ * callback, so delays in sending are included rather than hidden by a
+ * slower schedule. At most #INFLIGHT_BYTES of payload, and at most
+ * #RECORD_COUNT messages, are in flight, as the publish call of an
+ * application blocks on a full connection. A load the client cannot keep
+ * up with shows as latency that grows over the run.
+ *
+ * Runs cover the POSIX transport over a UNIX domain socket pair and over
+ * loopback TCP, and the io_uring transport over a socket pair when the
+ * kernel supports it, for QoS 0, 1 and 2, several payload sizes and several
+ * offered loads. Results are printed as CSV with the columns
+ * `benchmark,transport,qos,payload_bytes,offered_per_sec,achieved_per_sec,messages,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns`.
+ * With `--hgrm <directory>`, the full distribution of each run is also
+ * written to the directory in the percentile format of HdrHistogram, with
+ * values in microseconds.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+#include "core_mqtt_transport_uring.h"
+#include "benchmark_broker.h"
+
+/**
+ * @brief Time over which the messages of a run are offered.
+ */
+#define RUN_DURATION_MS        ( 1000U )
+
+/**
+ * @brief Number of QoS records of the context, which bounds the messages of
+ * QoS 1 and 2 in flight.
+ */
+#define RECORD_COUNT           ( 256U )
+
+/**
+ * @brief Most payload bytes in flight, below the queue size at which the
+ * broker stops reading.
+ */
+#define INFLIGHT_BYTES         ( 131072U )
+
+/**
+ * @brief Size of the network buffer of the context, and of each io_uring
+ * buffer, which holds the largest payload.
+ */
+#define NETWORK_BUFFER_SIZE    ( 20480U )
+
+/**
+ * @brief Time without any packet after which a run fails.
+ */
+#define WAIT_TIMEOUT_MS        ( 5000U )
+
+/**
+ * @brief Topic name of the published messages.
+ */
+#define TOPIC_NAME             "benchmark/latency/echo"
+
+/**
+ * @brief Number of bits of the sub-buckets of the histogram. Values are kept
+ * with a relative error below 2 to the power of 1 minus this.
+ */
+#define SUB_BUCKET_BITS        ( 7U )
+
+/**
+ * @brief Number of sub-buckets of the histogram.
+ */
+#define SUB_BUCKET_COUNT       ( 1U << SUB_BUCKET_BITS )
+
+/**
+ * @brief Number of buckets of the histogram, enough for values up to
+ * 2 to the power of 40 nanoseconds.
+ */
+#define BUCKET_COUNT           ( SUB_BUCKET_COUNT + ( ( 40U - SUB_BUCKET_BITS ) * ( SUB_BUCKET_COUNT / 2U ) ) )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A log-linear histogram of latencies in nanoseconds, as used by
+ * HdrHistogram.
+ *
+ * Values below #SUB_BUCKET_COUNT have a bucket each. Above, each power of 2
+ * is split into #SUB_BUCKET_COUNT / 2 buckets.
+ */
+typedef struct Histogram
+{
+    uint64_t counts[ BUCKET_COUNT ]; /**< @brief Count of each bucket. */
+    uint64_t totalCount;             /**< @brief Number of values recorded. */
+    uint64_t totalNs;                /**< @brief Sum of the values recorded. */
+    uint64_t maxNs;                  /**< @brief Largest value recorded. */
+} Histogram_t;
+
+/**
+ * @brief The transport a client is connected with.
+ */
+typedef enum TransportKind
+{
+    TransportUnix,  /**< @brief The POSIX transport over a UNIX domain socket pair. */
+    TransportTcp,   /**< @brief The POSIX transport over loopback TCP. */
+    TransportUring  /**< @brief The io_uring transport over a UNIX domain socket pair. */
+} TransportKind_t;
+
+/**
+ * @brief The client of a run.
+ */
+typedef struct LatencyClient
+{
+    MQTTContext_t context;                            /**< @brief The MQTT context. */
+    TransportKind_t kind;                             /**< @brief The transport of the connection. */
+    PosixTransport_t posixTransport;                  /**< @brief The POSIX connection. */
+    UringTransport_t uringTransport;                  /**< @brief The io_uring connection. */
+    TransportInterface_t transport;                   /**< @brief The transport interface of the connection. */
+    uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];     /**< @brief The network buffer of the context. */
+    MQTTPubAckInfo_t outgoingRecords[ RECORD_COUNT ]; /**< @brief Records of outgoing publishes of QoS 1 and 2. */
+    MQTTPubAckInfo_t incomingRecords[ RECORD_COUNT ]; /**< @brief Records of incoming publishes of QoS 1 and 2. */
+    size_t received;                                  /**< @brief Echoed publishes received. */
+    size_t completed;                                 /**< @brief Outgoing publishes of QoS 1 and 2 acknowledged. */
+    size_t subAcks;                                   /**< @brief SUBACK packets received. */
+    size_t packets;                                   /**< @brief Packets of any type received. */
+} LatencyClient_t;
+
+static BenchmarkBroker_t broker;
+static LatencyClient_t client;
+static Histogram_t histogram;
+static UringTransportRing_t ring;
+static bool uringSupported;
+static uint8_t uringBufferMemory[ 2U * NETWORK_BUFFER_SIZE ];
+static uint8_t payload[ 16384 ];
+static int tcpListener = -1;
+static uint16_t tcpPort;
+static const char * pHgrmDirectory;
+
+/**
+ * @brief Payload sizes of the runs, at least the 8 bytes of the due time.
+ */
+static const size_t payloadSizes[] = { 16U, 1024U, 16384U };
+
+/**
+ * @brief Offered loads of the runs, in messages per second.
+ */
+static const uint32_t offeredRates[] = { 1000U, 10000U, 40000U };
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the bucket of a value.
+ */
+static size_t bucketOf( uint64_t valueNs )
+{
+    size_t bucket;
+    uint32_t shift;
+
+    if( valueNs < SUB_BUCKET_COUNT )
+    {
+        bucket = ( size_t ) valueNs;
+    }
+    else
+    {
+        /* Keep the top bits of the value below its leading bit. */
+        shift = ( 63U - ( uint32_t ) __builtin_clzll( valueNs ) ) - ( SUB_BUCKET_BITS - 1U );
+        bucket = SUB_BUCKET_COUNT + ( ( shift - 1U ) * ( SUB_BUCKET_COUNT / 2U ) ) +
+                 ( size_t ) ( ( valueNs >> shift ) - ( SUB_BUCKET_COUNT / 2U ) );
+        bucket = ( bucket < BUCKET_COUNT ) ? bucket : ( BUCKET_COUNT - 1U );
+    }
+
+    return bucket;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the largest value of a bucket.
+ */
+static uint64_t bucketMaxNs( size_t bucket )
+{
+    uint64_t valueNs;
+    uint32_t shift;
+
+    if( bucket < SUB_BUCKET_COUNT )
+    {
+        valueNs = bucket;
+    }
+    else
+    {
+        shift = ( uint32_t ) ( ( bucket - SUB_BUCKET_COUNT ) / ( SUB_BUCKET_COUNT / 2U ) ) + 1U;
+        valueNs = ( ( uint64_t ) ( ( bucket - SUB_BUCKET_COUNT ) % ( SUB_BUCKET_COUNT / 2U ) ) +
+                    ( SUB_BUCKET_COUNT / 2U ) + 1U ) << shift;
+        valueNs -= 1U;
+    }
+
+    return valueNs;
+}
+
+/*-----------------------------------------------------------*/
+
+static void recordLatency( uint64_t valueNs )
+{
+    histogram.counts[ bucketOf( valueNs ) ]++;
+    histogram.totalCount++;
+    histogram.totalNs += valueNs;
+    histogram.maxNs = ( valueNs > histogram.maxNs ) ? valueNs : histogram.maxNs;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the value below which a fraction of the recorded values lie,
+ * as the largest value of its bucket, capped by the largest value recorded.
+ */
+static uint64_t percentileNs( double percentile )
+{
+    uint64_t target = ( uint64_t ) ( ( ( double ) histogram.totalCount * percentile ) / 100.0 );
+    uint64_t cumulative = 0U, valueNs = histogram.maxNs;
+    size_t bucket;
+
+    target = ( target > 0U ) ? target : 1U;
+
+    for( bucket = 0U; bucket < BUCKET_COUNT; bucket++ )
+    {
+        cumulative += histogram.counts[ bucket ];
+
+        if( cumulative >= target )
+        {
+            valueNs = bucketMaxNs( bucket );
+            break;
+        }
+    }
+
+    return ( valueNs < histogram.maxNs ) ? valueNs : histogram.maxNs;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write the distribution of a run in the percentile format of
+ * HdrHistogram.
+ */
+static void writeHgrm( const char * pTransport,
+                       MQTTQoS_t qos,
+                       size_t payloadSize,
+                       uint32_t offeredRate )
+{
+    char path[ 512 ];
+    FILE * pFile;
+    const double meanNs = ( double ) histogram.totalNs / ( double ) histogram.totalCount;
+    uint64_t cumulative = 0U;
+    double percentile, deviation, varianceSum = 0.0;
+    size_t bucket;
+
+    ( void ) snprintf( path, sizeof( path ), "%s/%s_qos%d_%zu_%u.hgrm", pHgrmDirectory, pTransport, ( int ) qos,
+                       payloadSize, offeredRate );
+    pFile = fopen( path, "w" );
+
+    if( pFile == NULL )
+    {
+        fprintf( stderr, "Failed to open %s: errno=%d\n", path, errno );
+    }
+    else
+    {
+        fprintf( pFile, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)" );
+
+        for( bucket = 0U; bucket < BUCKET_COUNT; bucket++ )
+        {
+            if( histogram.counts[ bucket ] > 0U )
+            {
+                cumulative += histogram.counts[ bucket ];
+                deviation = ( double ) bucketMaxNs( bucket ) - meanNs;
+                varianceSum += deviation * deviation * ( double ) histogram.counts[ bucket ];
+                percentile = ( double ) cumulative / ( double ) histogram.totalCount;
+
+                if( cumulative < histogram.totalCount )
+                {
+                    fprintf( pFile, "%12.3f %2.12f %10llu %14.2f\n", ( double ) bucketMaxNs( bucket ) / 1000.0,
+                             percentile, ( unsigned long long ) cumulative, 1.0 / ( 1.0 - percentile ) );
+                }
+                else
+                {
+                    fprintf( pFile, "%12.3f %2.12f %10llu\n", ( double ) histogram.maxNs / 1000.0,
+                             percentile, ( unsigned long long ) cumulative );
+                }
+            }
+        }
+
+        fprintf( pFile, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", meanNs / 1000.0,
+                 sqrt( varianceSum / ( double ) histogram.totalCount ) / 1000.0 );
+        fprintf( pFile, "#[Max     = %12.3f, Total count    = %12llu]\n", ( double ) histogram.maxNs / 1000.0,
+                 ( unsigned long long ) histogram.totalCount );
+        fprintf( pFile, "#[Buckets = %12u, SubBuckets     = %12u]\n", BUCKET_COUNT, SUB_BUCKET_COUNT );
+        ( void ) fclose( pFile );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    uint64_t dueNs;
+
+    ( void ) pContext;
+
+    client.packets++;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        ( void ) memcpy( &dueNs, pDeserializedInfo->pPublishInfo->pPayload, sizeof( dueNs ) );
+        recordLatency( nowNs() - dueNs );
+        client.received++;
+    }
+    else if( ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK ) || ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBCOMP ) )
+    {
+        client.completed++;
+    }
+    else if( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK )
+    {
+        client.subAcks++;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Open the connection of the client over a transport.
+ */
+static bool openTransport( TransportKind_t kind )
+{
+    PosixTransportConfig_t config = { 0 };
+    int socketDescriptor = -1;
+    bool success = false;
+
+    if( kind == TransportTcp )
+    {
+        config.noDelay = true;
+        config.connectTimeoutMs = 1000U;
+
+        if( PosixTransport_Connect( &( client.posixTransport ), "127.0.0.1", tcpPort, &config ) ==
+            PosixTransportSuccess )
+        {
+            socketDescriptor = accept( tcpListener, NULL, NULL );
+            success = ( socketDescriptor >= 0 ) && BenchmarkBroker_AddSocket( &broker, socketDescriptor );
+        }
+
+        PosixTransport_GetInterface( &( client.posixTransport ), &( client.transport ) );
+    }
+    else
+    {
+        socketDescriptor = BenchmarkBroker_AddClient( &broker );
+
+        if( ( socketDescriptor >= 0 ) && ( kind == TransportUnix ) )
+        {
+            success = PosixTransport_Attach( &( client.posixTransport ), socketDescriptor, &config ) ==
+                      PosixTransportSuccess;
+            PosixTransport_GetInterface( &( client.posixTransport ), &( client.transport ) );
+        }
+        else if( socketDescriptor >= 0 )
+        {
+            success = UringTransport_Attach( &ring, &( client.uringTransport ), 0U, socketDescriptor ) ==
+                      UringTransportSuccess;
+            UringTransport_GetInterface( &( client.uringTransport ), &( client.transport ) );
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Close the connection of the client.
+ */
+static void closeTransport( void )
+{
+    if( client.kind == TransportUring )
+    {
+        ( void ) UringTransport_Disconnect( &( client.uringTransport ), 1000U );
+    }
+    else
+    {
+        ( void ) PosixTransport_Disconnect( &( client.posixTransport ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run #MQTT_ProcessLoop once, and wait for the transport if no packet
+ * was handled.
+ *
+ * @param[in] waitMs Most time to wait, or 0 to yield to the broker thread.
+ * @param[in,out] pIdleSinceMs Time the last packet was handled.
+ */
+static MQTTStatus_t processOnce( uint32_t waitMs,
+                                 uint32_t * pIdleSinceMs )
+{
+    MQTTStatus_t status;
+    size_t before = client.packets;
+
+    status = MQTT_ProcessLoop( &( client.context ) );
+
+    /* The rest of a partly received packet comes with the next call. */
+    status = ( status == MQTTNeedMoreBytes ) ? MQTTSuccess : status;
+
+    if( client.packets != before )
+    {
+        *pIdleSinceMs = getTimeMs();
+    }
+    else if( ( getTimeMs() - *pIdleSinceMs ) > WAIT_TIMEOUT_MS )
+    {
+        status = MQTTRecvFailed;
+    }
+    else if( waitMs > 0U )
+    {
+        ( void ) client.transport.waitReadable( client.transport.pNetworkContext, waitMs );
+    }
+    else
+    {
+        ( void ) sched_yield();
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connect the client over a transport and subscribe it to the topic
+ * it publishes to.
+ */
+static MQTTStatus_t connectClient( TransportKind_t kind,
+                                   MQTTQoS_t qos )
+{
+    MQTTFixedBuffer_t fixedBuffer = { client.networkBuffer, NETWORK_BUFFER_SIZE };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTSubscribeInfo_t subscription = { 0 };
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t idleSinceMs = getTimeMs();
+    bool sessionPresent = false;
+
+    ( void ) memset( &client, 0, sizeof( client ) );
+    client.kind = kind;
+
+    if( openTransport( kind ) == false )
+    {
+        status = MQTTSendFailed;
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_Init( &( client.context ), &( client.transport ), getTimeMs, eventCallback, &fixedBuffer );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_InitStatefulQoS( &( client.context ), client.outgoingRecords, RECORD_COUNT,
+                                       client.incomingRecords, RECORD_COUNT );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        connectInfo.cleanSession = true;
+        connectInfo.pClientIdentifier = "latency";
+        connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+        status = MQTT_Connect( &( client.context ), &connectInfo, NULL, WAIT_TIMEOUT_MS, &sessionPresent );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        subscription.qos = qos;
+        subscription.pTopicFilter = TOPIC_NAME;
+        subscription.topicFilterLength = ( uint16_t ) strlen( TOPIC_NAME );
+        status = MQTT_Subscribe( &( client.context ), &subscription, 1U, MQTT_GetPacketId( &( client.context ) ) );
+    }
+
+    while( ( status == MQTTSuccess ) && ( client.subAcks == 0U ) )
+    {
+        status = processOnce( 10U, &idleSinceMs );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Offer messages on a fixed schedule and record the latency of their
+ * echoes.
+ */
+static MQTTStatus_t runSchedule( MQTTQoS_t qos,
+                                 size_t payloadSize,
+                                 uint32_t offeredRate,
+                                 size_t messageCount,
+                                 uint64_t * pElapsedNs )
+{
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status = MQTTSuccess;
+    const uint64_t intervalNs = 1000000000U / offeredRate;
+    size_t inflightMax = INFLIGHT_BYTES / payloadSize;
+    uint32_t idleSinceMs = getTimeMs();
+    uint64_t start, dueNs, now;
+    size_t sent = 0U;
+    uint32_t waitMs;
+
+    inflightMax = ( inflightMax < RECORD_COUNT ) ? inflightMax : RECORD_COUNT;
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = payloadSize;
+    start = nowNs();
+
+    while( ( status == MQTTSuccess ) &&
+           ( ( client.received < messageCount ) || ( ( qos != MQTTQoS0 ) && ( client.completed < sent ) ) ) )
+    {
+        now = nowNs();
+
+        /* Send every message that is due, as long as the window allows. */
+        while( ( status == MQTTSuccess ) && ( sent < messageCount ) &&
+               ( ( start + ( sent * intervalNs ) ) <= now ) && ( ( sent - client.received ) < inflightMax ) &&
+               ( ( qos == MQTTQoS0 ) || ( ( sent - client.completed ) < inflightMax ) ) )
+        {
+            dueNs = start + ( sent * intervalNs );
+            ( void ) memcpy( payload, &dueNs, sizeof( dueNs ) );
+            status = MQTT_Publish( &( client.context ), &publishInfo,
+                                   ( qos == MQTTQoS0 ) ? 0U : MQTT_GetPacketId( &( client.context ) ) );
+            sent++;
+        }
+
+        /* Wait for an echo until the next message is due. */
+        waitMs = 10U;
+
+        if( ( sent < messageCount ) && ( ( sent - client.received ) < inflightMax ) )
+        {
+            dueNs = start + ( sent * intervalNs );
+            now = nowNs();
+            waitMs = ( dueNs > now ) ? ( uint32_t ) ( ( dueNs - now ) / 1000000U ) : 0U;
+        }
+
+        if( status == MQTTSuccess )
+        {
+            status = processOnce( waitMs, &idleSinceMs );
+        }
+    }
+
+    *pElapsedNs = nowNs() - start;
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run one transport, QoS, payload size and offered load, and print
+ * the result.
+ */
+static MQTTStatus_t runLatency( TransportKind_t kind,
+                                const char * pTransport,
+                                MQTTQoS_t qos,
+                                size_t payloadSize,
+                                uint32_t offeredRate )
+{
+    const size_t messageCount = ( size_t ) ( ( ( uint64_t ) offeredRate * RUN_DURATION_MS ) / 1000U );
+    MQTTStatus_t status;
+    uint64_t elapsedNs = 0U;
+
+    ( void ) memset( &histogram, 0, sizeof( histogram ) );
+    status = connectClient( kind, qos );
+
+    if( status == MQTTSuccess )
+    {
+        status = runSchedule( qos, payloadSize, offeredRate, messageCount, &elapsedNs );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        printf( "latency,%s,%d,%zu,%u,%.0f,%llu,%.0f,%llu,%llu,%llu,%llu,%llu,%llu\n", pTransport, ( int ) qos,
+                payloadSize, offeredRate, ( ( double ) messageCount * 1e9 ) / ( double ) elapsedNs,
+                ( unsigned long long ) histogram.totalCount,
+                ( double ) histogram.totalNs / ( double ) histogram.totalCount,
+                ( unsigned long long ) percentileNs( 50.0 ), ( unsigned long long ) percentileNs( 90.0 ),
+                ( unsigned long long ) percentileNs( 99.0 ), ( unsigned long long ) percentileNs( 99.9 ),
+                ( unsigned long long ) percentileNs( 99.99 ), ( unsigned long long ) histogram.maxNs );
+
+        if( pHgrmDirectory != NULL )
+        {
+            writeHgrm( pTransport, qos, payloadSize, offeredRate );
+        }
+    }
+    else
+    {
+        fprintf( stderr, "%s: QoS %d, %zu bytes at %u per second failed: %s\n", pTransport, ( int ) qos,
+                 payloadSize, offeredRate, MQTT_Status_strerror( status ) );
+    }
+
+    ( void ) MQTT_Disconnect( &( client.context ) );
+    closeTransport();
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Listen for the TCP connections of the runs on the loopback
+ * interface.
+ */
+static bool listenTcp( void )
+{
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof( address );
+    bool success;
+
+    tcpListener = socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    ( void ) memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    success = ( tcpListener >= 0 ) &&
+              ( bind( tcpListener, ( struct sockaddr * ) &address, sizeof( address ) ) == 0 ) &&
+              ( listen( tcpListener, 1 ) == 0 ) &&
+              ( getsockname( tcpListener, ( struct sockaddr * ) &address, &addressLength ) == 0 );
+    tcpPort = ntohs( address.sin_port );
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static const struct
+    {
+        TransportKind_t kind;
+        const char * pName;
+    } transports[] =
+    {
+        { TransportUnix,  "unix"     },
+        { TransportTcp,   "tcp"      },
+        { TransportUring, "io_uring" }
+    };
+    MQTTStatus_t status = MQTTSuccess;
+    size_t i, j, k;
+    int qos;
+
+    if( ( argc == 3 ) && ( strcmp( argv[ 1 ], "--hgrm" ) == 0 ) )
+    {
+        pHgrmDirectory = argv[ 2 ];
+    }
+    else if( argc != 1 )
+    {
+        fprintf( stderr, "Usage: %s [--hgrm <directory>]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    if( ( BenchmarkBroker_Start( &broker ) == false ) || ( listenTcp() == false ) )
+    {
+        fprintf( stderr, "Failed to start the broker\n" );
+        return EXIT_FAILURE;
+    }
+
+    uringSupported = UringTransport_InitRing( &ring, 64U, uringBufferMemory, 1U, NETWORK_BUFFER_SIZE ) ==
+                     UringTransportSuccess;
+
+    if( uringSupported == false )
+    {
+        fprintf( stderr, "io_uring is not supported, skipping its runs\n" );
+    }
+
+    printf( "benchmark,transport,qos,payload_bytes,offered_per_sec,achieved_per_sec,messages,"
+            "mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns\n" );
+
+    for( i = 0U; ( i < ( sizeof( transports ) / sizeof( transports[ 0 ] ) ) ) && ( status == MQTTSuccess ); i++ )
+    {
+        for( qos = 0; ( qos <= 2 ) && ( status == MQTTSuccess ) &&
+             ( ( transports[ i ].kind != TransportUring ) || ( uringSupported == true ) ); qos++ )
+        {
+            for( j = 0U; ( j < ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ) ) && ( status == MQTTSuccess ); j++ )
+            {
+                for( k = 0U; ( k < ( sizeof( offeredRates ) / sizeof( offeredRates[ 0 ] ) ) ) && ( status == MQTTSuccess ); k++ )
+                {
+                    status = runLatency( transports[ i ].kind, transports[ i ].pName, ( MQTTQoS_t ) qos,
+                                         payloadSizes[ j ], offeredRates[ k ] );
+                }
+            }
+        }
+    }
+
+    if( uringSupported == true )
+    {
+        ( void ) UringTransport_CleanupRing( &ring );
+    }
+
+    ( void ) close( tcpListener );
+    BenchmarkBroker_Stop( &broker );
+
+    return ( status == MQTTSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,490 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file replay_benchmark.c
+ * @brief Records the bytes a client receives from the broker of
+ * benchmark_broker.h, and replays them through #MQTT_ProcessLoop without a
+ * network, with the transports of core_mqtt_transport_replay.h.
+ *
+ * - `replay_benchmark` records a session of publishes of QoS 0, 1 and 2 and
+ *   several payload sizes into a temporary file and replays it.
+ * - `replay_benchmark record <file>` only records that session to a file.
+ * - `replay_benchmark replay <file>` replays a recording, such as one
+ *   captured on a real connection with a #ReplayRecorder_t.
+ *
+ * A recording is replayed #REPLAY_ITERATIONS times at once, and once at the
+ * recorded pace. Replaying starts with #MQTT_Connect, which receives the
+ * CONNACK of the recording, so the session must be recorded from the start
+ * of the connection. Acknowledgments of publishes the client sent in the
+ * recorded session are not expected by the replaying context, so a session
+ * in which the client published at QoS 1 or 2 fails to replay.
+ *
+ * Results are printed as CSV with the columns
+ * `benchmark,mode,iterations,bytes,packets,publishes,seconds,packets_per_sec,mbytes_per_sec,ns_per_packet`,
+ * where the bytes and packets are those of every iteration.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+#include "core_mqtt_transport_replay.h"
+#include "benchmark_broker.h"
+
+/**
+ * @brief Times a recording is replayed at once.
+ */
+#define REPLAY_ITERATIONS      ( 10U )
+
+/**
+ * @brief Number of QoS records for incoming publishes.
+ */
+#define RECORD_COUNT           ( 64U )
+
+/**
+ * @brief Size of the network buffer of the context, which holds the
+ * largest payload.
+ */
+#define NETWORK_BUFFER_SIZE    ( 8192U )
+
+/**
+ * @brief Time to wait for a packet before a run fails.
+ */
+#define WAIT_TIMEOUT_MS        ( 5000U )
+
+/**
+ * @brief Topic name of the recorded messages.
+ */
+#define TOPIC_NAME             "benchmark/replay/telemetry"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A part of the recorded session, flooded by the broker.
+ */
+typedef struct SessionPart
+{
+    MQTTQoS_t qos;      /**< @brief QoS of the publishes. */
+    size_t payloadSize; /**< @brief Payload bytes of each publish. */
+    size_t count;       /**< @brief Number of publishes. */
+} SessionPart_t;
+
+static MQTTContext_t context;
+static uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];
+static MQTTPubAckInfo_t incomingRecords[ RECORD_COUNT ];
+static uint8_t payload[ 4096 ];
+static size_t packets;
+static size_t publishes;
+
+/**
+ * @brief The parts of the recorded session, in order.
+ */
+static const SessionPart_t sessionParts[] =
+{
+    { MQTTQoS0, 64U,   50000U },
+    { MQTTQoS1, 256U,  20000U },
+    { MQTTQoS2, 1024U, 5000U  },
+    { MQTTQoS0, 4096U, 2000U  }
+};
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+    ( void ) pDeserializedInfo;
+
+    packets++;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        publishes++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Initialize the context over a transport and connect it.
+ */
+static MQTTStatus_t connectContext( const TransportInterface_t * pTransport )
+{
+    MQTTFixedBuffer_t fixedBuffer = { networkBuffer, NETWORK_BUFFER_SIZE };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTStatus_t status;
+    bool sessionPresent = false;
+
+    status = MQTT_Init( &context, pTransport, getTimeMs, eventCallback, &fixedBuffer );
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_InitStatefulQoS( &context, NULL, 0U, incomingRecords, RECORD_COUNT );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        connectInfo.cleanSession = true;
+        connectInfo.pClientIdentifier = "replay";
+        connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+        status = MQTT_Connect( &context, &connectInfo, NULL, WAIT_TIMEOUT_MS, &sessionPresent );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record a session of publishes flooded by the broker.
+ */
+static MQTTStatus_t recordSession( int fileDescriptor )
+{
+    BenchmarkBroker_t broker;
+    PosixTransport_t posixTransport;
+    PosixTransportConfig_t config = { 0 };
+    TransportInterface_t liveTransport = { 0 };
+    TransportInterface_t transport = { 0 };
+    ReplayRecorder_t recorder;
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t idleSinceMs;
+    size_t target = 0U;
+    size_t before, i;
+    int socketDescriptor;
+
+    if( BenchmarkBroker_Start( &broker ) == false )
+    {
+        status = MQTTSendFailed;
+    }
+
+    socketDescriptor = ( status == MQTTSuccess ) ? BenchmarkBroker_AddClient( &broker ) : -1;
+
+    if( ( socketDescriptor < 0 ) ||
+        ( PosixTransport_Attach( &posixTransport, socketDescriptor, &config ) != PosixTransportSuccess ) )
+    {
+        status = MQTTSendFailed;
+    }
+
+    if( status == MQTTSuccess )
+    {
+        PosixTransport_GetInterface( &posixTransport, &liveTransport );
+
+        if( ReplayRecorder_Start( &recorder, &liveTransport, fileDescriptor ) != ReplayTransportSuccess )
+        {
+            status = MQTTSendFailed;
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        ReplayRecorder_GetInterface( &recorder, &transport );
+        status = connectContext( &transport );
+    }
+
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+
+    for( i = 0U; ( i < ( sizeof( sessionParts ) / sizeof( sessionParts[ 0 ] ) ) ) && ( status == MQTTSuccess ); i++ )
+    {
+        publishInfo.qos = sessionParts[ i ].qos;
+        publishInfo.payloadLength = sessionParts[ i ].payloadSize;
+        target += sessionParts[ i ].count;
+
+        if( BenchmarkBroker_Flood( &broker, socketDescriptor, &publishInfo, sessionParts[ i ].count ) == false )
+        {
+            status = MQTTBadParameter;
+        }
+
+        idleSinceMs = getTimeMs();
+
+        while( ( status == MQTTSuccess ) && ( publishes < target ) )
+        {
+            before = packets;
+            status = MQTT_ProcessLoop( &context );
+
+            /* The rest of a partly received packet comes with the next call. */
+            status = ( status == MQTTNeedMoreBytes ) ? MQTTSuccess : status;
+
+            if( packets != before )
+            {
+                idleSinceMs = getTimeMs();
+            }
+            else if( ( getTimeMs() - idleSinceMs ) > WAIT_TIMEOUT_MS )
+            {
+                status = MQTTRecvFailed;
+            }
+            else
+            {
+                /* Nothing complete is buffered, so wait for the socket. */
+                ( void ) PosixTransport_WaitReadable( ( NetworkContext_t * ) &posixTransport, 10U );
+            }
+        }
+    }
+
+    if( socketDescriptor >= 0 )
+    {
+        ( void ) MQTT_Disconnect( &context );
+        ( void ) PosixTransport_Disconnect( &posixTransport );
+    }
+
+    if( ( status == MQTTSuccess ) && ( recorder.failed == true ) )
+    {
+        status = MQTTSendFailed;
+    }
+
+    BenchmarkBroker_Stop( &broker );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read a whole recording into memory.
+ *
+ * @return The recording, to be freed by the caller, or NULL if it could not
+ * be read.
+ */
+static uint8_t * readRecording( int fileDescriptor,
+                                size_t * pLength )
+{
+    struct stat fileStatus;
+    uint8_t * pRecording = NULL;
+
+    if( ( fstat( fileDescriptor, &fileStatus ) == 0 ) && ( fileStatus.st_size > 0 ) )
+    {
+        pRecording = malloc( ( size_t ) fileStatus.st_size );
+    }
+
+    if( ( pRecording != NULL ) &&
+        ( pread( fileDescriptor, pRecording, ( size_t ) fileStatus.st_size, 0 ) != fileStatus.st_size ) )
+    {
+        free( pRecording );
+        pRecording = NULL;
+    }
+
+    *pLength = ( pRecording != NULL ) ? ( size_t ) fileStatus.st_size : 0U;
+
+    return pRecording;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Replay a recording through #MQTT_ProcessLoop until every byte of it
+ * has been received and processed.
+ */
+static MQTTStatus_t replayOnce( ReplayTransport_t * pReplay )
+{
+    TransportInterface_t transport = { 0 };
+    MQTTStatus_t status;
+    size_t before;
+    bool finished = false;
+
+    ( void ) ReplayTransport_Rewind( pReplay );
+    ReplayTransport_GetInterface( pReplay, &transport );
+    status = connectContext( &transport );
+
+    /* Packets received in full stay buffered after the last record, so
+     * processing goes on until a call processes nothing. */
+    while( ( status == MQTTSuccess ) && ( finished == false ) )
+    {
+        before = packets;
+        finished = ReplayTransport_IsFinished( pReplay );
+        status = MQTT_ProcessLoop( &context );
+        status = ( status == MQTTNeedMoreBytes ) ? MQTTSuccess : status;
+
+        if( packets != before )
+        {
+            finished = false;
+        }
+        else if( finished == false )
+        {
+            /* A paced replay waits for the next record. */
+            ( void ) ReplayTransport_WaitReadable( ( NetworkContext_t * ) pReplay, 10U );
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Replay a recording a number of times and print a result row.
+ */
+static MQTTStatus_t runReplay( const uint8_t * pRecording,
+                               size_t recordingLength,
+                               bool paced,
+                               size_t iterations )
+{
+    ReplayTransport_t replay;
+    MQTTStatus_t status = MQTTSuccess;
+    uint64_t start, elapsedNs;
+    size_t i;
+
+    if( ReplayTransport_Open( &replay, pRecording, recordingLength, paced ) != ReplayTransportSuccess )
+    {
+        status = MQTTBadParameter;
+    }
+
+    packets = 0U;
+    publishes = 0U;
+    start = nowNs();
+
+    for( i = 0U; ( i < iterations ) && ( status == MQTTSuccess ); i++ )
+    {
+        status = replayOnce( &replay );
+    }
+
+    elapsedNs = nowNs() - start;
+
+    if( status == MQTTSuccess )
+    {
+        printf( "replay,%s,%zu,%zu,%zu,%zu,%.3f,%.0f,%.1f,%.1f\n", paced ? "paced" : "max", iterations,
+                recordingLength * iterations, packets, publishes, ( double ) elapsedNs / 1e9,
+                ( ( double ) packets * 1e9 ) / ( double ) elapsedNs,
+                ( ( double ) recordingLength * ( double ) iterations * 1000.0 ) / ( double ) elapsedNs,
+                ( double ) elapsedNs / ( double ) packets );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint8_t * pRecording = NULL;
+    size_t recordingLength = 0U;
+    FILE * pTemporary = NULL;
+    int fileDescriptor = -1;
+    bool record = true;
+    bool replay = true;
+
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    if( ( argc == 3 ) && ( strcmp( argv[ 1 ], "record" ) == 0 ) )
+    {
+        replay = false;
+        fileDescriptor = open( argv[ 2 ], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+    }
+    else if( ( argc == 3 ) && ( strcmp( argv[ 1 ], "replay" ) == 0 ) )
+    {
+        record = false;
+        fileDescriptor = open( argv[ 2 ], O_RDONLY | O_CLOEXEC );
+    }
+    else if( argc == 1 )
+    {
+        pTemporary = tmpfile();
+        fileDescriptor = ( pTemporary != NULL ) ? fileno( pTemporary ) : -1;
+    }
+    else
+    {
+        fprintf( stderr, "Usage: %s [record <file> | replay <file>]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+
+    if( fileDescriptor < 0 )
+    {
+        fprintf( stderr, "Failed to open the recording\n" );
+        return EXIT_FAILURE;
+    }
+
+    if( record == true )
+    {
+        status = recordSession( fileDescriptor );
+    }
+
+    if( ( status == MQTTSuccess ) && ( replay == true ) )
+    {
+        pRecording = readRecording( fileDescriptor, &recordingLength );
+        status = ( pRecording != NULL ) ? MQTTSuccess : MQTTBadParameter;
+
+        if( status == MQTTSuccess )
+        {
+            printf( "benchmark,mode,iterations,bytes,packets,publishes,seconds,packets_per_sec,mbytes_per_sec,ns_per_packet\n" );
+            status = runReplay( pRecording, recordingLength, false, REPLAY_ITERATIONS );
+        }
+
+        if( status == MQTTSuccess )
+        {
+            status = runReplay( pRecording, recordingLength, true, 1U );
+        }
+    }
+
+    if( status != MQTTSuccess )
+    {
+        fprintf( stderr, "A benchmark failed: %s\n", MQTT_Status_strerror( status ) );
+    }
+
+    free( pRecording );
+
+    if( pTemporary != NULL )
+    {
+        ( void ) fclose( pTemporary );
+    }
+    else
+    {
+        ( void ) close( fileDescriptor );
+    }
+
+    return ( status == MQTTSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
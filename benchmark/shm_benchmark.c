@@ -0,0 +1,522 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file shm_benchmark.c
+ * @brief Compares the shared memory transport with the POSIX transport over
+ * loopback TCP, between a client process and a broker process.
+ *
+ * The broker is a child process that answers the CONNECT, reads a stream of
+ * QoS 0 publishes from the client, and then echoes publishes back one at a
+ * time. The client measures the publish rate of the stream and the round-trip
+ * time of the echoed publishes. Results are printed as CSV with the columns
+ * `benchmark,transport,messages,messages_per_sec,rtt_mean_ns,rtt_p50_ns,rtt_p99_ns`.
+ */
+
+#define _GNU_SOURCE
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+#include "core_mqtt_transport_shm.h"
+
+/**
+ * @brief Number of publishes in the stream.
+ */
+#define STREAM_MESSAGE_COUNT    ( 200000U )
+
+/**
+ * @brief Number of echoed publishes timed.
+ */
+#define ROUND_TRIP_COUNT        ( 20000U )
+
+/**
+ * @brief Size of the network buffer of the MQTT context.
+ */
+#define NETWORK_BUFFER_SIZE     ( 1024U )
+
+/**
+ * @brief Size of each ring of the shared memory transport, near the socket
+ * buffer sizes that loopback TCP grows to.
+ */
+#define RING_SIZE               ( 1048576U )
+
+/**
+ * @brief Topic name of the published messages.
+ */
+#define TOPIC_NAME              "benchmark/shm/telemetry"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The broker end of a connection, used with blocking semantics.
+ */
+typedef struct BrokerEnd
+{
+    ShmTransport_t * pShmTransport; /**< @brief The shared memory end, or NULL for TCP. */
+    int socketDescriptor;           /**< @brief The accepted TCP socket. */
+} BrokerEnd_t;
+
+static uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];
+static uint8_t payload[ 64 ];
+static size_t connectPacketLength;
+static size_t publishPacketLength;
+static size_t messagesReceived;
+static uint64_t roundTripNs[ ROUND_TRIP_COUNT ];
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+    ( void ) pDeserializedInfo;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        messagesReceived++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static int compareNs( const void * pLeft,
+                      const void * pRight )
+{
+    const uint64_t left = *( const uint64_t * ) pLeft;
+    const uint64_t right = *( const uint64_t * ) pRight;
+
+    return ( left > right ) - ( left < right );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Receive at least one byte on the broker end, waiting for it.
+ */
+static int32_t brokerRecv( BrokerEnd_t * pEnd,
+                           uint8_t * pBuffer,
+                           size_t length )
+{
+    int32_t result = 0;
+
+    if( pEnd->pShmTransport != NULL )
+    {
+        while( result == 0 )
+        {
+            result = ShmTransport_Recv( ( NetworkContext_t * ) pEnd->pShmTransport, pBuffer, length );
+
+            if( result == 0 )
+            {
+                ( void ) ShmTransport_Wait( pEnd->pShmTransport, 1000U );
+            }
+        }
+    }
+    else
+    {
+        result = ( int32_t ) read( pEnd->socketDescriptor, pBuffer, length );
+        result = ( result == 0 ) ? -1 : result;
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send all bytes from the broker end.
+ */
+static bool brokerSend( BrokerEnd_t * pEnd,
+                        const uint8_t * pBuffer,
+                        size_t length )
+{
+    size_t sent = 0U;
+    int32_t result = 0;
+
+    while( ( sent < length ) && ( result >= 0 ) )
+    {
+        if( pEnd->pShmTransport != NULL )
+        {
+            result = ShmTransport_Send( ( NetworkContext_t * ) pEnd->pShmTransport, &( pBuffer[ sent ] ),
+                                        length - sent );
+        }
+        else
+        {
+            result = ( int32_t ) write( pEnd->socketDescriptor, &( pBuffer[ sent ] ), length - sent );
+        }
+
+        if( result > 0 )
+        {
+            sent += ( size_t ) result;
+        }
+    }
+
+    return sent == length;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run the broker side of the benchmark in the child process.
+ */
+static int runBroker( BrokerEnd_t * pEnd )
+{
+    static const uint8_t connack[] = { 0x20U, 0x02U, 0x00U, 0x00U };
+    static uint8_t buffer[ 65536 ];
+    const size_t streamLength = connectPacketLength + ( STREAM_MESSAGE_COUNT * publishPacketLength );
+    size_t received = 0U;
+    size_t packetBytes;
+    uint32_t i;
+    int32_t result = 0;
+
+    /* Answer the CONNECT, then take in the stream of publishes. */
+    if( brokerSend( pEnd, connack, sizeof( connack ) ) == false )
+    {
+        result = -1;
+    }
+
+    while( ( result >= 0 ) && ( received < streamLength ) )
+    {
+        result = brokerRecv( pEnd, buffer, sizeof( buffer ) );
+        received += ( result > 0 ) ? ( size_t ) result : 0U;
+    }
+
+    if( ( result >= 0 ) && ( brokerSend( pEnd, ( const uint8_t * ) "d", 1U ) == false ) )
+    {
+        result = -1;
+    }
+
+    /* Echo each publish back to the client. */
+    for( i = 0U; ( i < ROUND_TRIP_COUNT ) && ( result >= 0 ); i++ )
+    {
+        packetBytes = 0U;
+
+        while( ( result >= 0 ) && ( packetBytes < publishPacketLength ) )
+        {
+            result = brokerRecv( pEnd, &( buffer[ packetBytes ] ), publishPacketLength - packetBytes );
+            packetBytes += ( result > 0 ) ? ( size_t ) result : 0U;
+        }
+
+        if( ( result >= 0 ) && ( brokerSend( pEnd, buffer, publishPacketLength ) == false ) )
+        {
+            result = -1;
+        }
+    }
+
+    return ( result >= 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Wait until the client end has bytes to receive.
+ */
+static void clientWait( ShmTransport_t * pShmTransport,
+                        int socketDescriptor )
+{
+    struct pollfd pollDescriptor;
+
+    if( pShmTransport != NULL )
+    {
+        ( void ) ShmTransport_Wait( pShmTransport, 1000U );
+    }
+    else
+    {
+        pollDescriptor.fd = socketDescriptor;
+        pollDescriptor.events = POLLIN;
+        ( void ) poll( &pollDescriptor, 1U, 1000 );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run the client side of the benchmark and print its results.
+ */
+static int runClient( const char * pName,
+                      TransportInterface_t * pTransport,
+                      ShmTransport_t * pShmTransport,
+                      int socketDescriptor )
+{
+    MQTTFixedBuffer_t fixedBuffer = { networkBuffer, NETWORK_BUFFER_SIZE };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTContext_t context;
+    MQTTStatus_t status;
+    bool sessionPresent = false;
+    uint64_t start, streamNs, totalNs = 0U;
+    uint8_t done = 0U;
+    uint32_t i;
+    int32_t result = 0;
+
+    connectInfo.cleanSession = true;
+    connectInfo.pClientIdentifier = "shm_benchmark";
+    connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = sizeof( payload );
+
+    status = MQTT_Init( &context, pTransport, getTimeMs, eventCallback, &fixedBuffer );
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_Connect( &context, &connectInfo, NULL, 5000U, &sessionPresent );
+    }
+
+    /* The stream ends when the broker has read every byte of it. */
+    start = nowNs();
+
+    for( i = 0U; ( i < STREAM_MESSAGE_COUNT ) && ( status == MQTTSuccess ); i++ )
+    {
+        status = MQTT_Publish( &context, &publishInfo, 0U );
+    }
+
+    while( ( status == MQTTSuccess ) && ( result == 0 ) )
+    {
+        clientWait( pShmTransport, socketDescriptor );
+        result = pTransport->recv( pTransport->pNetworkContext, &done, 1U );
+    }
+
+    streamNs = nowNs() - start;
+
+    for( i = 0U; ( i < ROUND_TRIP_COUNT ) && ( status == MQTTSuccess ); i++ )
+    {
+        const size_t expected = messagesReceived + 1U;
+
+        start = nowNs();
+        status = MQTT_Publish( &context, &publishInfo, 0U );
+
+        while( ( status == MQTTSuccess ) && ( messagesReceived < expected ) )
+        {
+            clientWait( pShmTransport, socketDescriptor );
+            status = MQTT_ProcessLoop( &context );
+        }
+
+        roundTripNs[ i ] = nowNs() - start;
+        totalNs += roundTripNs[ i ];
+    }
+
+    if( ( status != MQTTSuccess ) || ( done != ( uint8_t ) 'd' ) )
+    {
+        fprintf( stderr, "%s: the client failed: %s\n", pName, MQTT_Status_strerror( status ) );
+        result = -1;
+    }
+    else
+    {
+        qsort( roundTripNs, ROUND_TRIP_COUNT, sizeof( roundTripNs[ 0 ] ), compareNs );
+        printf( "shm,%s,%u,%.0f,%.0f,%llu,%llu\n", pName, STREAM_MESSAGE_COUNT,
+                ( ( double ) STREAM_MESSAGE_COUNT * 1e9 ) / ( double ) streamNs,
+                ( double ) totalNs / ( double ) ROUND_TRIP_COUNT,
+                ( unsigned long long ) roundTripNs[ ROUND_TRIP_COUNT / 2U ],
+                ( unsigned long long ) roundTripNs[ ( ROUND_TRIP_COUNT * 99U ) / 100U ] );
+        result = 0;
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+static int waitForBroker( pid_t child )
+{
+    int childStatus = 0;
+
+    return ( ( waitpid( child, &childStatus, 0 ) == child ) && WIFEXITED( childStatus ) &&
+             ( WEXITSTATUS( childStatus ) == EXIT_SUCCESS ) ) ? 0 : -1;
+}
+
+/*-----------------------------------------------------------*/
+
+static int runShm( void )
+{
+    ShmTransport_t clientEnd, brokerEnd;
+    TransportInterface_t transport;
+    BrokerEnd_t end = { NULL, -1 };
+    pid_t child;
+    int result = -1;
+
+    if( ShmTransport_Create( &clientEnd, RING_SIZE ) != ShmTransportSuccess )
+    {
+        fprintf( stderr, "Failed to create the shared memory segment\n" );
+        return -1;
+    }
+
+    child = fork();
+
+    if( child == 0 )
+    {
+        result = EXIT_FAILURE;
+
+        if( ShmTransport_Open( &brokerEnd, dup( clientEnd.segmentDescriptor ) ) == ShmTransportSuccess )
+        {
+            end.pShmTransport = &brokerEnd;
+            result = runBroker( &end );
+            ( void ) ShmTransport_Disconnect( &brokerEnd );
+        }
+
+        _exit( result );
+    }
+
+    if( child > 0 )
+    {
+        ShmTransport_GetInterface( &clientEnd, &transport );
+        result = runClient( "shm", &transport, &clientEnd, -1 );
+        ( void ) ShmTransport_Disconnect( &clientEnd );
+
+        if( waitForBroker( child ) != 0 )
+        {
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+static int runTcp( void )
+{
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof( address );
+    PosixTransport_t posixTransport;
+    PosixTransportConfig_t config = { 0 };
+    TransportInterface_t transport;
+    BrokerEnd_t end = { NULL, -1 };
+    int listener, one = 1;
+    pid_t child;
+    int result = -1;
+
+    listener = socket( AF_INET, SOCK_STREAM, 0 );
+    ( void ) memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    if( ( listener < 0 ) ||
+        ( bind( listener, ( struct sockaddr * ) &address, sizeof( address ) ) != 0 ) ||
+        ( listen( listener, 1 ) != 0 ) ||
+        ( getsockname( listener, ( struct sockaddr * ) &address, &addressLength ) != 0 ) )
+    {
+        fprintf( stderr, "Failed to listen on the loopback interface\n" );
+        return -1;
+    }
+
+    child = fork();
+
+    if( child == 0 )
+    {
+        end.socketDescriptor = accept( listener, NULL, NULL );
+        ( void ) setsockopt( end.socketDescriptor, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+        _exit( ( end.socketDescriptor >= 0 ) ? runBroker( &end ) : EXIT_FAILURE );
+    }
+
+    /* Bytes read ahead would not be reported by poll. */
+    config.noDelay = true;
+    config.connectTimeoutMs = 1000U;
+
+    if( ( child > 0 ) &&
+        ( PosixTransport_Connect( &posixTransport, "127.0.0.1", ntohs( address.sin_port ), &config ) ==
+          PosixTransportSuccess ) )
+    {
+        PosixTransport_GetInterface( &posixTransport, &transport );
+        result = runClient( "tcp", &transport, NULL, posixTransport.socketDescriptor );
+        ( void ) PosixTransport_Disconnect( &posixTransport );
+    }
+
+    if( ( child > 0 ) && ( waitForBroker( child ) != 0 ) )
+    {
+        result = -1;
+    }
+
+    ( void ) close( listener );
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    size_t remainingLength;
+    int result;
+
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    /* The broker counts the bytes of the CONNECT and of each publish. */
+    connectInfo.cleanSession = true;
+    connectInfo.pClientIdentifier = "shm_benchmark";
+    connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+    ( void ) MQTT_GetConnectPacketSize( &connectInfo, NULL, &remainingLength, &connectPacketLength );
+
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.payloadLength = sizeof( payload );
+    ( void ) MQTT_GetPublishPacketSize( &publishInfo, &remainingLength, &publishPacketLength );
+
+    printf( "benchmark,transport,messages,messages_per_sec,rtt_mean_ns,rtt_p50_ns,rtt_p99_ns\n" );
+
+    result = runTcp();
+
+    if( result == 0 )
+    {
+        result = runShm();
+    }
+
+    return ( result == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,417 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file sim_benchmark.c
+ * @brief Measures the library over the simulated transport of
+ * core_mqtt_transport_sim.h, under several impairment profiles, against the
+ * broker of benchmark_broker.h.
+ *
+ * In each run one client subscribes to the topic it publishes to, and keeps
+ * #WINDOW_SIZE publishes of QoS 1 in flight, so the partial sends of
+ * publishes and the partial receives of acknowledgments and echoed publishes
+ * are both exercised. The simulated transport wraps the POSIX transport over
+ * a UNIX domain socket pair. The seed of the impairments is 1, or the
+ * argument `--seed <n>`.
+ *
+ * Results are printed as CSV with the columns
+ * `benchmark,profile,messages,seconds,messages_per_sec,mbytes_per_sec,cpu_ns_per_byte,zero_recvs,zero_sends,short_writes`,
+ * where the bytes are those the client sent and received, and the CPU time
+ * is that of the client thread, not of the broker.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+#include "core_mqtt_transport_sim.h"
+#include "benchmark_broker.h"
+
+/**
+ * @brief Most publishes in flight, and the number of QoS records of the
+ * context.
+ */
+#define WINDOW_SIZE            ( 32U )
+
+/**
+ * @brief Payload bytes of each message.
+ */
+#define PAYLOAD_SIZE           ( 256U )
+
+/**
+ * @brief Size of the network buffer of the context.
+ */
+#define NETWORK_BUFFER_SIZE    ( 4096U )
+
+/**
+ * @brief Time to wait for a packet before a run fails.
+ */
+#define WAIT_TIMEOUT_MS        ( 5000U )
+
+/**
+ * @brief Topic name of the published messages.
+ */
+#define TOPIC_NAME             "benchmark/sim/telemetry"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief An impairment profile.
+ */
+typedef struct Profile
+{
+    const char * pName;          /**< @brief Name of the profile in the results. */
+    size_t messageCount;         /**< @brief Messages of the run. */
+    SimTransportConfig_t config; /**< @brief The impairments, without the seed. */
+} Profile_t;
+
+static BenchmarkBroker_t broker;
+static MQTTContext_t context;
+static PosixTransport_t posixTransport;
+static SimTransport_t simTransport;
+static TransportInterface_t transport;
+static uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];
+static MQTTPubAckInfo_t outgoingRecords[ WINDOW_SIZE ];
+static MQTTPubAckInfo_t incomingRecords[ WINDOW_SIZE ];
+static uint8_t payload[ PAYLOAD_SIZE ];
+static size_t received;
+static size_t completed;
+static size_t subAcks;
+static size_t packets;
+
+/**
+ * @brief The impairment profiles, in the order they are run. Receiving or
+ * sending one byte at a time is slow, so those runs are shorter.
+ */
+static const Profile_t profiles[] =
+{
+    { "clean",            20000U, { 0 }                                                                        },
+    { "recv_1_byte",      2000U,  { .maxRecvSize = 1U }                                                        },
+    { "send_1_byte",      2000U,  { .maxSendSize = 1U }                                                        },
+    { "zero_returns_50",  20000U, { .zeroRecvPercent = 50U, .zeroSendPercent = 50U }                           },
+    { "short_writev_50",  20000U, { .shortWritevPercent = 50U }                                                },
+    { "bandwidth_10MBps", 20000U, { .recvBytesPerSecond = 10000000U, .sendBytesPerSecond = 10000000U }         },
+    { "latency_1ms",      20000U, { .latencyUs = 1000U }                                                       },
+    { "combined",         5000U,  { .maxRecvSize = 7U, .maxSendSize = 13U, .zeroRecvPercent = 10U,
+                                    .zeroSendPercent = 10U, .shortWritevPercent = 25U, .latencyUs = 200U,
+                                    .recvBytesPerSecond = 20000000U, .sendBytesPerSecond = 20000000U } }
+};
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t threadCpuNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+    ( void ) pDeserializedInfo;
+
+    packets++;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        received++;
+    }
+    else if( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK )
+    {
+        completed++;
+    }
+    else if( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK )
+    {
+        subAcks++;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run #MQTT_ProcessLoop until a counter reaches a value.
+ */
+static MQTTStatus_t processUntil( const size_t * pCounter,
+                                  size_t target )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t idleSinceMs = getTimeMs();
+    size_t before;
+
+    while( ( status == MQTTSuccess ) && ( *pCounter < target ) )
+    {
+        before = packets;
+        status = MQTT_ProcessLoop( &context );
+
+        /* The rest of a partly received packet comes with the next call. */
+        status = ( status == MQTTNeedMoreBytes ) ? MQTTSuccess : status;
+
+        if( packets != before )
+        {
+            idleSinceMs = getTimeMs();
+        }
+        else if( ( getTimeMs() - idleSinceMs ) > WAIT_TIMEOUT_MS )
+        {
+            status = MQTTRecvFailed;
+        }
+        else
+        {
+            /* Nothing complete is buffered, so wait through the simulated
+             * transport, which also waits for held bytes. */
+            ( void ) transport.waitReadable( transport.pNetworkContext, 10U );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connect the context to the broker over a simulated transport and
+ * subscribe it to the topic of the messages.
+ */
+static MQTTStatus_t connectContext( const SimTransportConfig_t * pConfig )
+{
+    MQTTFixedBuffer_t fixedBuffer = { networkBuffer, NETWORK_BUFFER_SIZE };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTSubscribeInfo_t subscription = { 0 };
+    PosixTransportConfig_t posixConfig = { 0 };
+    TransportInterface_t posixInterface = { 0 };
+    MQTTStatus_t status = MQTTSuccess;
+    bool sessionPresent = false;
+    int socketDescriptor;
+
+    received = 0U;
+    completed = 0U;
+    subAcks = 0U;
+    packets = 0U;
+    socketDescriptor = BenchmarkBroker_AddClient( &broker );
+
+    if( ( socketDescriptor < 0 ) ||
+        ( PosixTransport_Attach( &posixTransport, socketDescriptor, &posixConfig ) != PosixTransportSuccess ) )
+    {
+        status = MQTTSendFailed;
+    }
+
+    if( status == MQTTSuccess )
+    {
+        PosixTransport_GetInterface( &posixTransport, &posixInterface );
+        status = ( SimTransport_Init( &simTransport, &posixInterface, pConfig ) == SimTransportSuccess ) ?
+                 MQTTSuccess : MQTTBadParameter;
+    }
+
+    if( status == MQTTSuccess )
+    {
+        SimTransport_GetInterface( &simTransport, &transport );
+        status = MQTT_Init( &context, &transport, getTimeMs, eventCallback, &fixedBuffer );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = MQTT_InitStatefulQoS( &context, outgoingRecords, WINDOW_SIZE, incomingRecords, WINDOW_SIZE );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        connectInfo.cleanSession = true;
+        connectInfo.pClientIdentifier = "sim";
+        connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+        status = MQTT_Connect( &context, &connectInfo, NULL, WAIT_TIMEOUT_MS, &sessionPresent );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        subscription.qos = MQTTQoS1;
+        subscription.pTopicFilter = TOPIC_NAME;
+        subscription.topicFilterLength = ( uint16_t ) strlen( TOPIC_NAME );
+        status = MQTT_Subscribe( &context, &subscription, 1U, MQTT_GetPacketId( &context ) );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = processUntil( &subAcks, 1U );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Echo messages through the broker under an impairment profile.
+ */
+static MQTTStatus_t runProfile( const Profile_t * pProfile,
+                                uint32_t seed )
+{
+    SimTransportConfig_t config = pProfile->config;
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t status;
+    SimTransportStats_t stats;
+    uint64_t start, startCpu, elapsedNs, cpuNs, bytes;
+    size_t i;
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = PAYLOAD_SIZE;
+
+    config.seed = seed;
+    status = connectContext( &config );
+
+    /* Only the messages are measured, not the connection. */
+    stats = simTransport.stats;
+    start = nowNs();
+    startCpu = threadCpuNs();
+
+    for( i = 0U; ( i < pProfile->messageCount ) && ( status == MQTTSuccess ); i++ )
+    {
+        /* Keep both the publishes and their echoes within the window. */
+        if( ( i - completed ) >= WINDOW_SIZE )
+        {
+            status = processUntil( &completed, i - WINDOW_SIZE + 1U );
+        }
+
+        if( ( status == MQTTSuccess ) && ( ( i - received ) >= WINDOW_SIZE ) )
+        {
+            status = processUntil( &received, i - WINDOW_SIZE + 1U );
+        }
+
+        if( status == MQTTSuccess )
+        {
+            status = MQTT_Publish( &context, &publishInfo, MQTT_GetPacketId( &context ) );
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = processUntil( &received, pProfile->messageCount );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        status = processUntil( &completed, pProfile->messageCount );
+    }
+
+    elapsedNs = nowNs() - start;
+    cpuNs = threadCpuNs() - startCpu;
+
+    if( status == MQTTSuccess )
+    {
+        bytes = ( simTransport.stats.bytesSent - stats.bytesSent ) + ( simTransport.stats.bytesReceived - stats.bytesReceived );
+        printf( "sim,%s,%zu,%.3f,%.0f,%.2f,%.1f,%llu,%llu,%llu\n", pProfile->pName, pProfile->messageCount,
+                ( double ) elapsedNs / 1e9,
+                ( ( double ) pProfile->messageCount * 1e9 ) / ( double ) elapsedNs,
+                ( ( double ) bytes * 1000.0 ) / ( double ) elapsedNs,
+                ( double ) cpuNs / ( double ) bytes,
+                ( unsigned long long ) ( simTransport.stats.zeroRecvs - stats.zeroRecvs ),
+                ( unsigned long long ) ( simTransport.stats.zeroSends - stats.zeroSends ),
+                ( unsigned long long ) ( simTransport.stats.shortWrites - stats.shortWrites ) );
+    }
+
+    ( void ) MQTT_Disconnect( &context );
+    ( void ) PosixTransport_Disconnect( &posixTransport );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t seed = 1U;
+    size_t i;
+
+    if( ( argc == 3 ) && ( strcmp( argv[ 1 ], "--seed" ) == 0 ) )
+    {
+        seed = ( uint32_t ) strtoul( argv[ 2 ], NULL, 0 );
+    }
+    else if( argc != 1 )
+    {
+        fprintf( stderr, "Usage: %s [--seed <n>]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    if( BenchmarkBroker_Start( &broker ) == false )
+    {
+        fprintf( stderr, "Failed to start the broker\n" );
+        return EXIT_FAILURE;
+    }
+
+    printf( "benchmark,profile,messages,seconds,messages_per_sec,mbytes_per_sec,cpu_ns_per_byte,zero_recvs,zero_sends,short_writes\n" );
+
+    for( i = 0U; ( i < ( sizeof( profiles ) / sizeof( profiles[ 0 ] ) ) ) && ( status == MQTTSuccess ); i++ )
+    {
+        status = runProfile( &( profiles[ i ] ), seed );
+
+        if( status != MQTTSuccess )
+        {
+            fprintf( stderr, "The %s profile failed: %s\n", profiles[ i ].pName, MQTT_Status_strerror( status ) );
+        }
+    }
+
+    BenchmarkBroker_Stop( &broker );
+
+    return ( status == MQTTSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
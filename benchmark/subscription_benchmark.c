@@ -0,0 +1,359 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file subscription_benchmark.c
+ * @brief Compares dispatching topic names with a subscription trie against
+ * calling MQTT_MatchTopic or MQTT_MatchCompiledFilter for every subscribed
+ * topic filter.
+ *
+ * Results are printed as CSV with the columns
+ * `benchmark,filters,topics,ns_per_topic,matches`.
+ */
+
+#define _POSIX_C_SOURCE    199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_subscription.h"
+
+/**
+ * @brief Number of topic filters subscribed to.
+ */
+#define FILTER_COUNT             ( 10000U )
+
+/**
+ * @brief Maximum length of a topic filter or topic name.
+ */
+#define TOPIC_LENGTH_MAX         ( 48U )
+
+/**
+ * @brief Number of topic names dispatched with the trie.
+ */
+#define TRIE_TOPIC_COUNT         ( 1000000U )
+
+/**
+ * @brief Number of topic names dispatched with the linear search.
+ */
+#define LINEAR_TOPIC_COUNT       ( 1000U )
+
+/**
+ * @brief Number of distinct topic names generated.
+ */
+#define TOPIC_POOL_COUNT         ( 4096U )
+
+/**
+ * @brief Sizes of the trie memory.
+ */
+#define TRIE_NODE_COUNT          ( 8U * FILTER_COUNT )
+#define TRIE_LEVEL_LENGTH_MAX    ( 16U )
+#define TRIE_BUCKET_COUNT        ( 16384U )
+
+/**
+ * @brief Maximum number of levels of a compiled topic filter.
+ */
+#define FILTER_LEVELS_MAX        ( 8U )
+
+/**
+ * @brief Maximum number of handlers matching one topic name.
+ */
+#define MATCH_COUNT_MAX          ( 16U )
+
+/*-----------------------------------------------------------*/
+
+static char filters[ FILTER_COUNT ][ TOPIC_LENGTH_MAX ];
+static uint16_t filterLengths[ FILTER_COUNT ];
+static MQTTCompiledFilter_t compiledFilters[ FILTER_COUNT ];
+static MQTTFilterLevel_t filterLevels[ FILTER_COUNT ][ FILTER_LEVELS_MAX ];
+static char topics[ TOPIC_POOL_COUNT ][ TOPIC_LENGTH_MAX ];
+static uint16_t topicLengths[ TOPIC_POOL_COUNT ];
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t nextRandom( uint32_t * pState )
+{
+    /* Deterministic LCG so that every run dispatches the same topic names. */
+    *pState = ( *pState * 1103515245U ) + 12345U;
+
+    return *pState >> 8;
+}
+
+/*-----------------------------------------------------------*/
+
+static void generateFilters( void )
+{
+    uint32_t i;
+    int length;
+
+    for( i = 0U; i < FILTER_COUNT; i++ )
+    {
+        if( ( i % 100U ) == 0U )
+        {
+            length = snprintf( filters[ i ], TOPIC_LENGTH_MAX, "site/b%u/f%u/r%u/#",
+                               i % 50U, ( i / 50U ) % 20U, i / 1000U );
+        }
+        else if( ( i % 10U ) == 0U )
+        {
+            length = snprintf( filters[ i ], TOPIC_LENGTH_MAX, "site/b%u/+/r%u/temp%u",
+                               i % 50U, i / 1000U, i );
+        }
+        else
+        {
+            length = snprintf( filters[ i ], TOPIC_LENGTH_MAX, "site/b%u/f%u/r%u/temp",
+                               i % 50U, ( i / 50U ) % 20U, i / 1000U );
+        }
+
+        filterLengths[ i ] = ( uint16_t ) length;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void generateTopics( void )
+{
+    uint32_t state = 1U;
+    uint32_t i;
+    int length;
+
+    for( i = 0U; i < TOPIC_POOL_COUNT; i++ )
+    {
+        length = snprintf( topics[ i ], TOPIC_LENGTH_MAX, "site/b%u/f%u/r%u/temp",
+                           nextRandom( &state ) % 50U,
+                           nextRandom( &state ) % 20U,
+                           nextRandom( &state ) % 10U );
+        topicLengths[ i ] = ( uint16_t ) length;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static int runTrie( size_t * pMatchesPerPool )
+{
+    MQTTSubscriptionTrie_t trie;
+    MQTTSubscriptionNode_t * pNodes;
+    char * pLevels;
+    uint32_t * pBuckets;
+    uint32_t handlerIds[ MATCH_COUNT_MAX ];
+    size_t matchCount = 0U, totalMatches = 0U;
+    MQTTStatus_t status;
+    uint64_t start, elapsed;
+    uint32_t i;
+
+    pNodes = malloc( TRIE_NODE_COUNT * sizeof( MQTTSubscriptionNode_t ) );
+    pLevels = malloc( TRIE_NODE_COUNT * TRIE_LEVEL_LENGTH_MAX );
+    pBuckets = malloc( TRIE_BUCKET_COUNT * sizeof( uint32_t ) );
+
+    if( ( pNodes == NULL ) || ( pLevels == NULL ) || ( pBuckets == NULL ) )
+    {
+        return -1;
+    }
+
+    status = MQTT_SubscriptionInit( &trie, pNodes, pLevels, TRIE_NODE_COUNT,
+                                    TRIE_LEVEL_LENGTH_MAX, pBuckets, TRIE_BUCKET_COUNT );
+
+    for( i = 0U; ( i < FILTER_COUNT ) && ( status == MQTTSuccess ); i++ )
+    {
+        status = MQTT_SubscriptionAdd( &trie, filters[ i ], filterLengths[ i ], i );
+    }
+
+    if( status != MQTTSuccess )
+    {
+        fprintf( stderr, "Adding filters failed: %s\n", MQTT_Status_strerror( status ) );
+        return -1;
+    }
+
+    /* Matches over one pass of the topic pool, to check against the linear search. */
+    *pMatchesPerPool = 0U;
+
+    for( i = 0U; i < TOPIC_POOL_COUNT; i++ )
+    {
+        ( void ) MQTT_SubscriptionMatch( &trie, topics[ i ], topicLengths[ i ],
+                                         handlerIds, MATCH_COUNT_MAX, &matchCount );
+        *pMatchesPerPool += matchCount;
+    }
+
+    start = nowNs();
+
+    for( i = 0U; i < TRIE_TOPIC_COUNT; i++ )
+    {
+        const uint32_t topic = i % TOPIC_POOL_COUNT;
+
+        ( void ) MQTT_SubscriptionMatch( &trie, topics[ topic ], topicLengths[ topic ],
+                                         handlerIds, MATCH_COUNT_MAX, &matchCount );
+        totalMatches += matchCount;
+    }
+
+    elapsed = nowNs() - start;
+
+    printf( "trie,%u,%u,%.1f,%zu\n", FILTER_COUNT, TRIE_TOPIC_COUNT,
+            ( double ) elapsed / ( double ) TRIE_TOPIC_COUNT, totalMatches );
+
+    free( pNodes );
+    free( pLevels );
+    free( pBuckets );
+
+    return 0;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t matchLinear( uint32_t topic )
+{
+    size_t matches = 0U;
+    bool isMatch = false;
+    uint32_t j;
+
+    for( j = 0U; j < FILTER_COUNT; j++ )
+    {
+        ( void ) MQTT_MatchTopic( topics[ topic ], topicLengths[ topic ],
+                                  filters[ j ], filterLengths[ j ], &isMatch );
+
+        if( isMatch == true )
+        {
+            matches++;
+        }
+    }
+
+    return matches;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t runLinear( void )
+{
+    size_t totalMatches = 0U;
+    uint64_t start, elapsed;
+    uint32_t i;
+
+    start = nowNs();
+
+    for( i = 0U; i < LINEAR_TOPIC_COUNT; i++ )
+    {
+        totalMatches += matchLinear( i % TOPIC_POOL_COUNT );
+    }
+
+    elapsed = nowNs() - start;
+
+    printf( "linear,%u,%u,%.1f,%zu\n", FILTER_COUNT, LINEAR_TOPIC_COUNT,
+            ( double ) elapsed / ( double ) LINEAR_TOPIC_COUNT, totalMatches );
+
+    return totalMatches;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t runCompiled( void )
+{
+    size_t totalMatches = 0U;
+    uint64_t start, elapsed;
+    uint32_t i, j, topic;
+    bool isMatch = false;
+
+    for( j = 0U; j < FILTER_COUNT; j++ )
+    {
+        ( void ) MQTT_CompileTopicFilter( filters[ j ], filterLengths[ j ],
+                                          filterLevels[ j ], FILTER_LEVELS_MAX,
+                                          &compiledFilters[ j ] );
+    }
+
+    start = nowNs();
+
+    for( i = 0U; i < LINEAR_TOPIC_COUNT; i++ )
+    {
+        topic = i % TOPIC_POOL_COUNT;
+
+        for( j = 0U; j < FILTER_COUNT; j++ )
+        {
+            ( void ) MQTT_MatchCompiledFilter( topics[ topic ], topicLengths[ topic ],
+                                               &compiledFilters[ j ], &isMatch );
+
+            if( isMatch == true )
+            {
+                totalMatches++;
+            }
+        }
+    }
+
+    elapsed = nowNs() - start;
+
+    printf( "compiled,%u,%u,%.1f,%zu\n", FILTER_COUNT, LINEAR_TOPIC_COUNT,
+            ( double ) elapsed / ( double ) LINEAR_TOPIC_COUNT, totalMatches );
+
+    return totalMatches;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    size_t trieMatchesPerPool = 0U, linearMatchesPerPool = 0U;
+    uint32_t i;
+    int result;
+
+    generateFilters();
+    generateTopics();
+
+    printf( "benchmark,filters,topics,ns_per_topic,matches\n" );
+
+    result = runTrie( &trieMatchesPerPool );
+
+    if( result == 0 )
+    {
+        if( runLinear() != runCompiled() )
+        {
+            fprintf( stderr, "Compiled filters match differently from MQTT_MatchTopic\n" );
+            result = -1;
+        }
+
+        /* Both ways of dispatching must find the same handlers. */
+        for( i = 0U; i < TOPIC_POOL_COUNT; i++ )
+        {
+            linearMatchesPerPool += matchLinear( i );
+        }
+
+        if( ( result == 0 ) && ( linearMatchesPerPool != trieMatchesPerPool ) )
+        {
+            fprintf( stderr, "Match counts differ: trie %zu, linear %zu\n",
+                     trieMatchesPerPool, linearMatchesPerPool );
+            result = -1;
+        }
+    }
+
+    return ( result == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,217 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file topic_benchmark.c
+ * @brief Times MQTT_MatchTopic and MQTT_ValidateTopicName on deep topic
+ * hierarchies with long levels.
+ *
+ * The same source is built as `topic_benchmark` and `topic_benchmark_scalar`,
+ * linked against the library with and without #MQTT_TOPIC_SIMD. Results are
+ * printed as CSV with the columns `benchmark,variant,topics,ns_per_topic,matches`.
+ */
+
+#define _POSIX_C_SOURCE    199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "core_mqtt.h"
+
+#ifndef BENCHMARK_VARIANT
+    #define BENCHMARK_VARIANT    "default"
+#endif
+
+/**
+ * @brief Number of distinct topic names generated.
+ */
+#define TOPIC_POOL_COUNT    ( 1024U )
+
+/**
+ * @brief Number of topic names matched or validated per benchmark.
+ */
+#define ITERATION_COUNT     ( 2000000U )
+
+/**
+ * @brief Maximum length of a generated topic name or filter.
+ */
+#define TOPIC_LENGTH_MAX    ( 256U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Levels of the generated topic names, like those of a fleet of
+ * industrial devices.
+ */
+static const char * const levelNames[] =
+{
+    "enterprise-north-america",
+    "manufacturing-site-0042",
+    "assembly-line-07",
+    "robotic-cell-controller-b",
+    "servo-drive-axis-3",
+    "telemetry",
+    "motor-winding-temperature",
+    "celsius"
+};
+
+/**
+ * @brief Number of levels of the generated topic names.
+ */
+#define LEVEL_COUNT    ( sizeof( levelNames ) / sizeof( levelNames[ 0 ] ) )
+
+static char topics[ TOPIC_POOL_COUNT ][ TOPIC_LENGTH_MAX ];
+static uint16_t topicLengths[ TOPIC_POOL_COUNT ];
+
+/**
+ * @brief Topic filters matched against every topic name: an exact filter,
+ * one with a '+' level in the middle, and one ending in '#'.
+ */
+static char filters[ 3 ][ TOPIC_LENGTH_MAX ];
+static uint16_t filterLengths[ 3 ];
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t buildTopic( char * pBuffer,
+                            uint32_t deviceId,
+                            int wildcardLevel,
+                            bool multiLevel )
+{
+    size_t length = 0U;
+    size_t level;
+    int written;
+
+    for( level = 0U; level < LEVEL_COUNT; level++ )
+    {
+        if( level > 0U )
+        {
+            pBuffer[ length++ ] = '/';
+        }
+
+        if( ( multiLevel == true ) && ( ( int ) level == wildcardLevel ) )
+        {
+            pBuffer[ length++ ] = '#';
+            break;
+        }
+        else if( ( int ) level == wildcardLevel )
+        {
+            pBuffer[ length++ ] = '+';
+        }
+        else if( level == 4U )
+        {
+            /* The device level differs between topic names. */
+            written = snprintf( &pBuffer[ length ], TOPIC_LENGTH_MAX - length,
+                                "%s-%04u", levelNames[ level ], deviceId );
+            length += ( size_t ) written;
+        }
+        else
+        {
+            written = snprintf( &pBuffer[ length ], TOPIC_LENGTH_MAX - length,
+                                "%s", levelNames[ level ] );
+            length += ( size_t ) written;
+        }
+    }
+
+    return ( uint16_t ) length;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    uint64_t start, elapsed;
+    size_t matches, filter;
+    uint32_t i, topic;
+    bool isMatch = false;
+
+    for( i = 0U; i < TOPIC_POOL_COUNT; i++ )
+    {
+        topicLengths[ i ] = buildTopic( topics[ i ], i, -1, false );
+    }
+
+    filterLengths[ 0 ] = buildTopic( filters[ 0 ], 7U, -1, false );
+    filterLengths[ 1 ] = buildTopic( filters[ 1 ], 0U, 4, false );
+    filterLengths[ 2 ] = buildTopic( filters[ 2 ], 0U, 5, true );
+
+    printf( "benchmark,variant,topics,ns_per_topic,matches\n" );
+
+    for( filter = 0U; filter < 3U; filter++ )
+    {
+        matches = 0U;
+        start = nowNs();
+
+        for( i = 0U; i < ITERATION_COUNT; i++ )
+        {
+            topic = i % TOPIC_POOL_COUNT;
+            ( void ) MQTT_MatchTopic( topics[ topic ], topicLengths[ topic ],
+                                      filters[ filter ], filterLengths[ filter ],
+                                      &isMatch );
+
+            if( isMatch == true )
+            {
+                matches++;
+            }
+        }
+
+        elapsed = nowNs() - start;
+
+        printf( "match_%s,%s,%u,%.1f,%zu\n",
+                ( filter == 0U ) ? "exact" : ( ( filter == 1U ) ? "single_level" : "multi_level" ),
+                BENCHMARK_VARIANT, ITERATION_COUNT,
+                ( double ) elapsed / ( double ) ITERATION_COUNT, matches );
+    }
+
+    matches = 0U;
+    start = nowNs();
+
+    for( i = 0U; i < ITERATION_COUNT; i++ )
+    {
+        topic = i % TOPIC_POOL_COUNT;
+
+        if( MQTT_ValidateTopicName( topics[ topic ], topicLengths[ topic ] ) == MQTTSuccess )
+        {
+            matches++;
+        }
+    }
+
+    elapsed = nowNs() - start;
+
+    printf( "validate,%s,%u,%.1f,%zu\n", BENCHMARK_VARIANT, ITERATION_COUNT,
+            ( double ) elapsed / ( double ) ITERATION_COUNT, matches );
+
+    return ( matches == ITERATION_COUNT ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,224 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file topic_filter_benchmark.cpp
+ * @brief Routes topic names through a fixed table of topic filters built at
+ * compile time with core_mqtt_topic_filter.hpp, and through the same table
+ * matched with MQTT_MatchCompiledFilter and MQTT_MatchTopic.
+ *
+ * The static assertions check the compile-time filters against the matching
+ * rules of the C library. Results are printed as CSV with the columns
+ * `benchmark,filters,topics,ns_per_topic,matches`.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "core_mqtt.h"
+#include "core_mqtt_subscription.h"
+#include "core_mqtt_topic_filter.hpp"
+
+namespace
+{
+    /**
+     * @brief Number of topic names routed per benchmark.
+     */
+    constexpr std::size_t ITERATION_COUNT = 4000000U;
+
+    /**
+     * @brief Maximum number of levels of a compiled topic filter.
+     */
+    constexpr std::size_t FILTER_LEVELS_MAX = 8U;
+
+    /**
+     * @brief The routing table, tried in order.
+     */
+    constexpr auto statusFilter = coremqtt::makeTopicFilter( "site/building1/floor2/status" );
+    constexpr auto temperatureFilter = coremqtt::makeTopicFilter( "site/+/+/room/+/temperature" );
+    constexpr auto humidityFilter = coremqtt::makeTopicFilter( "site/+/+/room/+/humidity" );
+    constexpr auto commandFilter = coremqtt::makeTopicFilter( "devices/thing1/commands/#" );
+    constexpr auto shadowFilter = coremqtt::makeTopicFilter( "$aws/things/thing1/shadow/update/+" );
+    constexpr auto alarmFilter = coremqtt::makeTopicFilter( "+/alarms/#" );
+    constexpr auto everythingFilter = coremqtt::makeTopicFilter( "#" );
+
+    constexpr std::string_view filters[] =
+    {
+        statusFilter.str(),
+        temperatureFilter.str(),
+        humidityFilter.str(),
+        commandFilter.str(),
+        shadowFilter.str(),
+        alarmFilter.str(),
+        everythingFilter.str()
+    };
+
+    constexpr std::size_t FILTER_COUNT = sizeof( filters ) / sizeof( filters[ 0 ] );
+
+    constexpr std::string_view topics[] =
+    {
+        "site/building1/floor2/status",
+        "site/building1/floor2/room/12/temperature",
+        "site/building3/floor1/room/7/humidity",
+        "site/building3/floor1/room/7/pressure",
+        "devices/thing1/commands/reboot/now",
+        "devices/thing2/commands/reboot",
+        "$aws/things/thing1/shadow/update/accepted",
+        "$SYS/broker/uptime",
+        "factory/alarms/line3/overheat"
+    };
+
+    constexpr std::size_t TOPIC_COUNT = sizeof( topics ) / sizeof( topics[ 0 ] );
+
+    constexpr std::size_t route( std::string_view topicName ) noexcept
+    {
+        return coremqtt::findFirstMatch( topicName, statusFilter, temperatureFilter,
+                                         humidityFilter, commandFilter, shadowFilter,
+                                         alarmFilter, everythingFilter );
+    }
+
+    /* Routing is decided at compile time for these topic names. */
+    static_assert( route( "site/building1/floor2/status" ) == 0U );
+    static_assert( route( "site/b/f/room/1/temperature" ) == 1U );
+    static_assert( route( "site/b/f/room//humidity" ) == 2U );
+    static_assert( route( "devices/thing1/commands" ) == 3U );
+    static_assert( route( "$aws/things/thing1/shadow/update/delta" ) == 4U );
+    static_assert( route( "line/alarms" ) == 5U );
+    static_assert( route( "$SYS/broker/uptime" ) == FILTER_COUNT );
+    static_assert( route( "site/building1/floor2" ) == 6U );
+
+    /* Compiled filters keep the prefix before the first wildcard. */
+    static_assert( temperatureFilter.getLevelCount() == 6U );
+    static_assert( temperatureFilter.getLevel( 1U ).kind == coremqtt::FilterLevelKind::Single );
+    static_assert( commandFilter.getLevel( 3U ).kind == coremqtt::FilterLevelKind::Multi );
+
+    MQTTCompiledFilter_t compiledFilters[ FILTER_COUNT ];
+    MQTTFilterLevel_t filterLevels[ FILTER_COUNT ][ FILTER_LEVELS_MAX ];
+
+    /*-----------------------------------------------------------*/
+
+    std::size_t routeCompiled( std::string_view topicName )
+    {
+        std::size_t index = 0U;
+        bool isMatch = false;
+
+        for( index = 0U; ( index < FILTER_COUNT ) && ( isMatch == false ); index++ )
+        {
+            ( void ) MQTT_MatchCompiledFilter( topicName.data(),
+                                               static_cast< uint16_t >( topicName.size() ),
+                                               &compiledFilters[ index ], &isMatch );
+        }
+
+        return ( isMatch == true ) ? ( index - 1U ) : FILTER_COUNT;
+    }
+
+    /*-----------------------------------------------------------*/
+
+    std::size_t routeMatchTopic( std::string_view topicName )
+    {
+        std::size_t index = 0U;
+        bool isMatch = false;
+
+        for( index = 0U; ( index < FILTER_COUNT ) && ( isMatch == false ); index++ )
+        {
+            ( void ) MQTT_MatchTopic( topicName.data(),
+                                      static_cast< uint16_t >( topicName.size() ),
+                                      filters[ index ].data(),
+                                      static_cast< uint16_t >( filters[ index ].size() ),
+                                      &isMatch );
+        }
+
+        return ( isMatch == true ) ? ( index - 1U ) : FILTER_COUNT;
+    }
+
+    /*-----------------------------------------------------------*/
+
+    template< typename Router >
+    std::size_t run( const char * pName,
+                     Router router )
+    {
+        std::size_t checksum = 0U;
+        std::size_t i;
+        const auto start = std::chrono::steady_clock::now();
+
+        for( i = 0U; i < ITERATION_COUNT; i++ )
+        {
+            /* Vary the topic name through a volatile index so that the
+             * compiler cannot route it at compile time. */
+            volatile std::size_t topic = i % TOPIC_COUNT;
+
+            checksum += router( topics[ topic ] );
+        }
+
+        const auto elapsed = std::chrono::duration< double, std::nano >(
+            std::chrono::steady_clock::now() - start );
+
+        std::printf( "%s,%zu,%zu,%.1f,%zu\n", pName, FILTER_COUNT, ITERATION_COUNT,
+                     elapsed.count() / static_cast< double >( ITERATION_COUNT ), checksum );
+
+        return checksum;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    std::size_t i;
+    std::size_t constexprChecksum, compiledChecksum, matchTopicChecksum;
+    int result = EXIT_SUCCESS;
+
+    for( i = 0U; i < FILTER_COUNT; i++ )
+    {
+        if( MQTT_CompileTopicFilter( filters[ i ].data(),
+                                     static_cast< uint16_t >( filters[ i ].size() ),
+                                     filterLevels[ i ], FILTER_LEVELS_MAX,
+                                     &compiledFilters[ i ] ) != MQTTSuccess )
+        {
+            std::fprintf( stderr, "Compiling %s failed\n", filters[ i ].data() );
+            result = EXIT_FAILURE;
+        }
+    }
+
+    if( result == EXIT_SUCCESS )
+    {
+        std::printf( "benchmark,filters,topics,ns_per_topic,matches\n" );
+
+        constexprChecksum = run( "constexpr", route );
+        compiledChecksum = run( "compiled", routeCompiled );
+        matchTopicChecksum = run( "match_topic", routeMatchTopic );
+
+        /* The checksum sums the routed indices, so every way of matching
+         * must route each topic name to the same filter. */
+        if( ( constexprChecksum != compiledChecksum ) || ( constexprChecksum != matchTopicChecksum ) )
+        {
+            std::fprintf( stderr, "Routing differs: constexpr %zu, compiled %zu, match_topic %zu\n",
+                          constexprChecksum, compiledChecksum, matchTopicChecksum );
+            result = EXIT_FAILURE;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,282 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file transport_benchmark.c
+ * @brief Publishes QoS 0 messages over the POSIX transport on a loopback TCP
+ * connection, with the transport writev function and with send only.
+ *
+ * A thread accepts the connection, answers the CONNECT with a CONNACK, and
+ * counts the bytes received until the client disconnects. Results are
+ * printed as CSV with the columns
+ * `benchmark,path,payload_bytes,messages,ns_per_message,mbytes_per_sec`.
+ */
+
+#define _POSIX_C_SOURCE    200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+
+/**
+ * @brief Number of messages published per run.
+ */
+#define MESSAGE_COUNT          ( 200000U )
+
+/**
+ * @brief Size of the network buffer of the MQTT context.
+ */
+#define NETWORK_BUFFER_SIZE    ( 1024U )
+
+/**
+ * @brief Topic name of the published messages.
+ */
+#define TOPIC_NAME             "benchmark/transport/throughput"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief State shared with the thread reading from the connection.
+ */
+typedef struct ServerState
+{
+    int listener;
+    size_t bytesReceived;
+} ServerState_t;
+
+static uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];
+static uint8_t payload[ 16384 ];
+
+/**
+ * @brief Payload sizes published.
+ */
+static const size_t payloadSizes[] = { 16U, 256U, 4096U, 16384U };
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+    ( void ) pPacketInfo;
+    ( void ) pDeserializedInfo;
+}
+
+/*-----------------------------------------------------------*/
+
+static void * serverThread( void * pArgument )
+{
+    ServerState_t * pState = ( ServerState_t * ) pArgument;
+    static const uint8_t connack[] = { 0x20U, 0x02U, 0x00U, 0x00U };
+    uint8_t buffer[ 65536 ];
+    ssize_t bytesRead;
+    int connection;
+
+    connection = accept( pState->listener, NULL, NULL );
+
+    if( connection >= 0 )
+    {
+        /* The CONNECT of the benchmark fits in a single read. */
+        bytesRead = read( connection, buffer, sizeof( buffer ) );
+
+        if( ( bytesRead > 0 ) && ( write( connection, connack, sizeof( connack ) ) == ( ssize_t ) sizeof( connack ) ) )
+        {
+            do
+            {
+                bytesRead = read( connection, buffer, sizeof( buffer ) );
+
+                if( bytesRead > 0 )
+                {
+                    pState->bytesReceived += ( size_t ) bytesRead;
+                }
+            } while( bytesRead > 0 );
+        }
+
+        ( void ) close( connection );
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static int runPath( const char * pPath,
+                    bool useWritev,
+                    size_t payloadSize )
+{
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof( address );
+    ServerState_t state = { -1, 0U };
+    PosixTransport_t posixTransport;
+    PosixTransportConfig_t config = { 0 };
+    TransportInterface_t transport;
+    MQTTFixedBuffer_t fixedBuffer = { networkBuffer, NETWORK_BUFFER_SIZE };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTContext_t context;
+    MQTTStatus_t status;
+    bool sessionPresent = false;
+    pthread_t thread;
+    uint64_t start, elapsed;
+    uint32_t i;
+    int result = -1;
+
+    state.listener = socket( AF_INET, SOCK_STREAM, 0 );
+    ( void ) memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+    if( ( state.listener < 0 ) ||
+        ( bind( state.listener, ( struct sockaddr * ) &address, sizeof( address ) ) != 0 ) ||
+        ( listen( state.listener, 1 ) != 0 ) ||
+        ( getsockname( state.listener, ( struct sockaddr * ) &address, &addressLength ) != 0 ) ||
+        ( pthread_create( &thread, NULL, serverThread, &state ) != 0 ) )
+    {
+        fprintf( stderr, "Failed to listen on the loopback interface\n" );
+        return -1;
+    }
+
+    config.noDelay = true;
+    config.connectTimeoutMs = 1000U;
+
+    if( PosixTransport_Connect( &posixTransport, "127.0.0.1", ntohs( address.sin_port ), &config ) ==
+        PosixTransportSuccess )
+    {
+        PosixTransport_GetInterface( &posixTransport, &transport );
+
+        if( useWritev == false )
+        {
+            transport.writev = NULL;
+        }
+
+        connectInfo.cleanSession = true;
+        connectInfo.pClientIdentifier = "transport_benchmark";
+        connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+
+        publishInfo.qos = MQTTQoS0;
+        publishInfo.pTopicName = TOPIC_NAME;
+        publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+        publishInfo.pPayload = payload;
+        publishInfo.payloadLength = payloadSize;
+
+        status = MQTT_Init( &context, &transport, getTimeMs, eventCallback, &fixedBuffer );
+
+        if( status == MQTTSuccess )
+        {
+            status = MQTT_Connect( &context, &connectInfo, NULL, 1000U, &sessionPresent );
+        }
+
+        start = nowNs();
+
+        for( i = 0U; ( i < MESSAGE_COUNT ) && ( status == MQTTSuccess ); i++ )
+        {
+            status = MQTT_Publish( &context, &publishInfo, 0U );
+        }
+
+        /* The run ends once the server has read every byte. */
+        ( void ) MQTT_Disconnect( &context );
+        ( void ) PosixTransport_Disconnect( &posixTransport );
+        ( void ) pthread_join( thread, NULL );
+        elapsed = nowNs() - start;
+
+        if( status == MQTTSuccess )
+        {
+            printf( "transport,%s,%zu,%u,%.1f,%.1f\n", pPath, payloadSize, MESSAGE_COUNT,
+                    ( double ) elapsed / ( double ) MESSAGE_COUNT,
+                    ( ( double ) state.bytesReceived * 1000.0 ) / ( double ) elapsed );
+            result = 0;
+        }
+        else
+        {
+            fprintf( stderr, "Publishing failed: %s\n", MQTT_Status_strerror( status ) );
+        }
+    }
+    else
+    {
+        fprintf( stderr, "Failed to connect to the loopback interface\n" );
+        ( void ) close( state.listener );
+        state.listener = -1;
+        ( void ) pthread_cancel( thread );
+        ( void ) pthread_join( thread, NULL );
+    }
+
+    if( state.listener >= 0 )
+    {
+        ( void ) close( state.listener );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    size_t i;
+    int result = 0;
+
+    ( void ) memset( payload, 'x', sizeof( payload ) );
+
+    printf( "benchmark,path,payload_bytes,messages,ns_per_message,mbytes_per_sec\n" );
+
+    for( i = 0U; ( i < ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ) ) && ( result == 0 ); i++ )
+    {
+        result = runPath( "writev", true, payloadSizes[ i ] );
+
+        if( result == 0 )
+        {
+            result = runPath( "send", false, payloadSizes[ i ] );
+        }
+    }
+
+    return ( result == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,452 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file uring_benchmark.c
+ * @brief Receives QoS 0 messages on many MQTT connections in one thread,
+ * with the io_uring transport and with epoll and the POSIX transport.
+ *
+ * Each connection is a pair of UNIX domain sockets. A thread writes PUBLISH
+ * packets to the connections in turn, as a broker fanning messages out to a
+ * bridge would, and the main thread runs #MQTT_ProcessLoop on the
+ * connections reported ready until every message has been received.
+ *
+ * The number of connections is the first argument, 10000 by default, and is
+ * reduced to fit the open file limit. Results are printed as CSV with the
+ * columns `benchmark,path,connections,messages,ns_per_message,messages_per_sec`.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "core_mqtt.h"
+#include "core_mqtt_transport_posix.h"
+#include "core_mqtt_transport_uring.h"
+
+/**
+ * @brief Default number of connections.
+ */
+#define CONNECTION_COUNT_DEFAULT    ( 10000U )
+
+/**
+ * @brief Messages written to each connection per run.
+ */
+#define MESSAGES_PER_CONNECTION     ( 20U )
+
+/**
+ * @brief Size of the network buffer of each MQTT context, and of each
+ * io_uring transport buffer.
+ */
+#define NETWORK_BUFFER_SIZE         ( 1024U )
+
+/**
+ * @brief Most connections handled per wait.
+ */
+#define READY_COUNT_MAX             ( 256U )
+
+/**
+ * @brief Topic name of the published messages.
+ */
+#define TOPIC_NAME                  "benchmark/uring/fanin"
+
+/**
+ * @brief Payload of the published messages.
+ */
+#define PAYLOAD                     "0123456789abcdef0123456789abcdef"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A connection of the bridge, with the socket the writer uses.
+ */
+typedef struct Connection
+{
+    MQTTContext_t context;
+    PosixTransport_t posixTransport;
+    UringTransport_t uringTransport;
+    uint8_t networkBuffer[ NETWORK_BUFFER_SIZE ];
+    int peerSocket;
+} Connection_t;
+
+static Connection_t * pConnections;
+static size_t connectionCount;
+static uint8_t publishPacket[ 64 ];
+static size_t publishPacketLength;
+static size_t messagesReceived;
+
+/*-----------------------------------------------------------*/
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t getTimeMs( void )
+{
+    return ( uint32_t ) ( nowNs() / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+    ( void ) pDeserializedInfo;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        messagesReceived++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void * writerThread( void * pArgument )
+{
+    size_t round, i;
+
+    ( void ) pArgument;
+
+    for( round = 0U; round < MESSAGES_PER_CONNECTION; round++ )
+    {
+        for( i = 0U; i < connectionCount; i++ )
+        {
+            if( write( pConnections[ i ].peerSocket, publishPacket, publishPacketLength ) !=
+                ( ssize_t ) publishPacketLength )
+            {
+                fprintf( stderr, "Writing a PUBLISH failed\n" );
+                exit( EXIT_FAILURE );
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+static void serializePublish( void )
+{
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTFixedBuffer_t fixedBuffer = { publishPacket, sizeof( publishPacket ) };
+    size_t remainingLength, packetSize;
+
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = TOPIC_NAME;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( TOPIC_NAME );
+    publishInfo.pPayload = PAYLOAD;
+    publishInfo.payloadLength = strlen( PAYLOAD );
+
+    ( void ) MQTT_GetPublishPacketSize( &publishInfo, &remainingLength, &packetSize );
+    ( void ) MQTT_SerializePublish( &publishInfo, 0U, remainingLength, &fixedBuffer );
+    publishPacketLength = packetSize;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t getConnectionCount( size_t requested )
+{
+    struct rlimit limit;
+    size_t available;
+
+    /* Each connection uses two descriptors, and a few are kept spare. */
+    if( getrlimit( RLIMIT_NOFILE, &limit ) == 0 )
+    {
+        limit.rlim_cur = limit.rlim_max;
+        ( void ) setrlimit( RLIMIT_NOFILE, &limit );
+        ( void ) getrlimit( RLIMIT_NOFILE, &limit );
+        available = ( limit.rlim_cur > 64U ) ? ( ( size_t ) limit.rlim_cur - 64U ) / 2U : 0U;
+
+        if( requested > available )
+        {
+            fprintf( stderr, "Reducing connections from %zu to %zu for the open file limit\n",
+                     requested, available );
+            requested = available;
+        }
+    }
+
+    return requested;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Create the socket pairs, attach the bridge ends to a transport, and
+ * connect an MQTT context over each.
+ */
+static int openConnections( UringTransportRing_t * pRing,
+                            int epollDescriptor )
+{
+    static const uint8_t connack[] = { 0x20U, 0x02U, 0x00U, 0x00U };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    PosixTransportConfig_t config = { 0 };
+    TransportInterface_t transport;
+    MQTTFixedBuffer_t fixedBuffer;
+    struct epoll_event event;
+    bool sessionPresent;
+    Connection_t * pConnection;
+    int sockets[ 2 ];
+    size_t i;
+    int result = 0;
+
+    connectInfo.cleanSession = true;
+    connectInfo.pClientIdentifier = "uring_benchmark";
+    connectInfo.clientIdentifierLength = ( uint16_t ) strlen( connectInfo.pClientIdentifier );
+
+    for( i = 0U; ( i < connectionCount ) && ( result == 0 ); i++ )
+    {
+        pConnection = &( pConnections[ i ] );
+
+        if( ( socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) != 0 ) ||
+            ( write( sockets[ 1 ], connack, sizeof( connack ) ) != ( ssize_t ) sizeof( connack ) ) )
+        {
+            fprintf( stderr, "Failed to create connection %zu\n", i );
+            result = -1;
+            break;
+        }
+
+        pConnection->peerSocket = sockets[ 1 ];
+
+        if( pRing != NULL )
+        {
+            result = ( UringTransport_Attach( pRing, &( pConnection->uringTransport ), i, sockets[ 0 ] ) ==
+                       UringTransportSuccess ) ? 0 : -1;
+            UringTransport_GetInterface( &( pConnection->uringTransport ), &transport );
+        }
+        else
+        {
+            /* Bytes read ahead would not be reported by epoll. */
+            result = ( PosixTransport_Attach( &( pConnection->posixTransport ), sockets[ 0 ], &config ) ==
+                       PosixTransportSuccess ) ? 0 : -1;
+            PosixTransport_GetInterface( &( pConnection->posixTransport ), &transport );
+
+            event.events = EPOLLIN;
+            event.data.ptr = pConnection;
+
+            if( ( result == 0 ) && ( epoll_ctl( epollDescriptor, EPOLL_CTL_ADD, sockets[ 0 ], &event ) != 0 ) )
+            {
+                result = -1;
+            }
+        }
+
+        fixedBuffer.pBuffer = pConnection->networkBuffer;
+        fixedBuffer.size = NETWORK_BUFFER_SIZE;
+
+        if( ( result != 0 ) ||
+            ( MQTT_Init( &( pConnection->context ), &transport, getTimeMs, eventCallback, &fixedBuffer ) != MQTTSuccess ) ||
+            ( MQTT_Connect( &( pConnection->context ), &connectInfo, NULL, 1000U, &sessionPresent ) != MQTTSuccess ) )
+        {
+            fprintf( stderr, "Failed to connect connection %zu\n", i );
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+static void closeConnections( bool useUring )
+{
+    size_t i;
+
+    for( i = 0U; i < connectionCount; i++ )
+    {
+        if( useUring == true )
+        {
+            ( void ) UringTransport_Disconnect( &( pConnections[ i ].uringTransport ), 0U );
+        }
+        else
+        {
+            ( void ) PosixTransport_Disconnect( &( pConnections[ i ].posixTransport ) );
+        }
+
+        ( void ) close( pConnections[ i ].peerSocket );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void processConnection( Connection_t * pConnection )
+{
+    MQTTStatus_t status;
+
+    /* Each call processes at most one packet. Bytes left in the socket are
+     * reported by the next wait. */
+    do
+    {
+        status = MQTT_ProcessLoop( &( pConnection->context ) );
+    } while( ( status == MQTTSuccess ) && ( pConnection->context.index > 0U ) );
+
+    if( ( status != MQTTSuccess ) && ( status != MQTTNeedMoreBytes ) )
+    {
+        fprintf( stderr, "Processing failed: %s\n", MQTT_Status_strerror( status ) );
+        exit( EXIT_FAILURE );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static int runPath( bool useUring )
+{
+    static UringTransport_t * ready[ READY_COUNT_MAX ];
+    static struct epoll_event events[ READY_COUNT_MAX ];
+    const size_t messageCount = connectionCount * MESSAGES_PER_CONNECTION;
+    UringTransportRing_t ring;
+    uint8_t * pBufferMemory = NULL;
+    int epollDescriptor = -1;
+    size_t readyCount, i;
+    pthread_t thread;
+    uint64_t start, elapsed;
+    int eventCount;
+    int result = 0;
+
+    ( void ) memset( pConnections, 0, connectionCount * sizeof( Connection_t ) );
+    messagesReceived = 0U;
+
+    if( useUring == true )
+    {
+        pBufferMemory = malloc( 2U * connectionCount * NETWORK_BUFFER_SIZE );
+
+        if( ( pBufferMemory == NULL ) ||
+            ( UringTransport_InitRing( &ring, READY_COUNT_MAX * 4U, pBufferMemory, connectionCount,
+                                       NETWORK_BUFFER_SIZE ) != UringTransportSuccess ) )
+        {
+            fprintf( stderr, "Failed to set up the io_uring\n" );
+            free( pBufferMemory );
+            return -1;
+        }
+    }
+    else
+    {
+        epollDescriptor = epoll_create1( 0 );
+    }
+
+    result = openConnections( ( useUring == true ) ? &ring : NULL, epollDescriptor );
+
+    if( result == 0 )
+    {
+        start = nowNs();
+        result = pthread_create( &thread, NULL, writerThread, NULL );
+
+        while( ( result == 0 ) && ( messagesReceived < messageCount ) )
+        {
+            if( useUring == true )
+            {
+                ( void ) UringTransport_Poll( &ring, 100U, ready, READY_COUNT_MAX, &readyCount );
+
+                for( i = 0U; i < readyCount; i++ )
+                {
+                    /* Get the connection holding the transport. */
+                    processConnection( ( Connection_t * ) ( ( uint8_t * ) ready[ i ] -
+                                                            offsetof( Connection_t, uringTransport ) ) );
+                }
+            }
+            else
+            {
+                eventCount = epoll_wait( epollDescriptor, events, READY_COUNT_MAX, 100 );
+
+                for( i = 0U; ( int ) i < eventCount; i++ )
+                {
+                    processConnection( ( Connection_t * ) events[ i ].data.ptr );
+                }
+            }
+        }
+
+        elapsed = nowNs() - start;
+
+        if( result == 0 )
+        {
+            ( void ) pthread_join( thread, NULL );
+            printf( "uring,%s,%zu,%zu,%.1f,%.0f\n", ( useUring == true ) ? "io_uring" : "epoll",
+                    connectionCount, messageCount,
+                    ( double ) elapsed / ( double ) messageCount,
+                    ( ( double ) messageCount * 1e9 ) / ( double ) elapsed );
+        }
+    }
+
+    closeConnections( useUring );
+
+    if( useUring == true )
+    {
+        ( void ) UringTransport_CleanupRing( &ring );
+        free( pBufferMemory );
+    }
+    else
+    {
+        ( void ) close( epollDescriptor );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    int result;
+
+    connectionCount = getConnectionCount( ( argc > 1 ) ? ( size_t ) strtoul( argv[ 1 ], NULL, 10 ) :
+                                          CONNECTION_COUNT_DEFAULT );
+    pConnections = malloc( connectionCount * sizeof( Connection_t ) );
+
+    if( ( connectionCount == 0U ) || ( pConnections == NULL ) )
+    {
+        fprintf( stderr, "No connections to run with\n" );
+        return EXIT_FAILURE;
+    }
+
+    serializePublish();
+
+    printf( "benchmark,path,connections,messages,ns_per_message,messages_per_sec\n" );
+
+    result = runPath( false );
+
+    if( result == 0 )
+    {
+        result = runPath( true );
+    }
+
+    free( pConnections );
+
+    return ( result == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -14,6 +14,42 @@ set( MQTT_SOURCES
 set( MQTT_SERIALIZER_SOURCES
      "${CMAKE_CURRENT_LIST_DIR}/source/core_mqtt_serializer.c" )
 
+# MQTT subscription trie source files.
+set( MQTT_SUBSCRIPTION_SOURCES
+     "${CMAKE_CURRENT_LIST_DIR}/source/core_mqtt_subscription.c" )
+
+# MQTT reference POSIX TCP transport source files.
+set( MQTT_TRANSPORT_POSIX_SOURCES
+     "${CMAKE_CURRENT_LIST_DIR}/source/transport/core_mqtt_transport_posix.c" )
+
+# MQTT reference Linux io_uring transport source files.
+set( MQTT_TRANSPORT_URING_SOURCES
+     "${CMAKE_CURRENT_LIST_DIR}/source/transport/core_mqtt_transport_uring.c" )
+
+# MQTT reference Linux shared memory transport source files.
+set( MQTT_TRANSPORT_SHM_SOURCES
+     "${CMAKE_CURRENT_LIST_DIR}/source/transport/core_mqtt_transport_shm.c" )
+
+# MQTT recording and replay transport source files.
+set( MQTT_TRANSPORT_REPLAY_SOURCES
+     "${CMAKE_CURRENT_LIST_DIR}/source/transport/core_mqtt_transport_replay.c" )
+
+# MQTT simulated transport source files.
+set( MQTT_TRANSPORT_SIM_SOURCES
+     "${CMAKE_CURRENT_LIST_DIR}/source/transport/core_mqtt_transport_sim.c" )
+
+# MQTT reference transport include directories.
+set( MQTT_TRANSPORT_INCLUDE_DIRS
+     "${CMAKE_CURRENT_LIST_DIR}/source/transport/include" )
+
+# MQTT trace ring backend source files.
+set( MQTT_TRACE_RING_SOURCES
+     "${CMAKE_CURRENT_LIST_DIR}/source/trace/core_mqtt_trace_ring.c" )
+
+# MQTT tracing backend include directories.
+set( MQTT_TRACE_INCLUDE_DIRS
+     "${CMAKE_CURRENT_LIST_DIR}/source/trace/include" )
+
 # MQTT library Public Include directories.
 set( MQTT_INCLUDE_PUBLIC_DIRS
      "${CMAKE_CURRENT_LIST_DIR}/source/include"
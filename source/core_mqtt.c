@@ -35,6 +35,20 @@
 /* Include config defaults header to get default values of configs. */
 #include "core_mqtt_config_defaults.h"
 
+#if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ )
+    #include <emmintrin.h>
+
+/**
+ * @brief Number of topic bytes scanned at a time with SIMD instructions.
+ */
+    #define TOPIC_BLOCK_SIZE    ( 16U )
+
+/**
+ * @brief Mask of the comparison results of a whole block.
+ */
+    #define TOPIC_BLOCK_MASK    ( 0xFFFFU )
+#endif
+
 #ifndef MQTT_PRE_SEND_HOOK
 
 /**
@@ -68,6 +82,61 @@
     #define MQTT_POST_STATE_UPDATE_HOOK( pContext )
 #endif /* !MQTT_POST_STATE_UPDATE_HOOK */
 
+#if ( MQTT_METRICS_ENABLED == 1 )
+
+/**
+ * @brief Add to a counter of the #MQTTMetrics_t of a context, if it has one.
+ */
+    #define MQTT_METRICS_ADD( pContext, counter, value )          \
+    do                                                            \
+    {                                                             \
+        if( ( pContext )->pMetrics != NULL )                      \
+        {                                                         \
+            ( pContext )->pMetrics->counter += ( value );         \
+        }                                                         \
+    } while( 0 )
+
+/**
+ * @brief Update the most publish records in use of the #MQTTMetrics_t of a
+ * context, if it has one.
+ */
+    #define MQTT_METRICS_RECORDS( pContext )    updateRecordsHighWater( pContext )
+
+/**
+ * @brief Count a packet received by a context in its #MQTTMetrics_t, if it
+ * has one.
+ */
+    #define MQTT_METRICS_RECEIVED( pContext, pPacket )                                                        \
+    do                                                                                                        \
+    {                                                                                                         \
+        MQTT_METRICS_ADD( pContext, packetsReceived[ MQTT_METRICS_INDEX( ( pPacket )->type ) ], 1U );         \
+        MQTT_METRICS_ADD( pContext, bytesReceived[ MQTT_METRICS_INDEX( ( pPacket )->type ) ],                 \
+                          ( uint64_t ) ( pPacket )->headerLength + ( uint64_t ) ( pPacket )->remainingLength ); \
+    } while( 0 )
+
+/**
+ * @brief Note in the #MQTTCallbackTiming_t of a context, if it has one,
+ * whether its network buffer holds bytes not yet handled.
+ */
+    #define MQTT_BUFFER_BUSY( pContext )    updateBufferBusy( pContext )
+#else
+    #define MQTT_METRICS_ADD( pContext, counter, value )
+    #define MQTT_METRICS_RECORDS( pContext )
+    #define MQTT_METRICS_RECEIVED( pContext, pPacket )
+    #define MQTT_BUFFER_BUSY( pContext )
+#endif /* if ( MQTT_METRICS_ENABLED == 1 ) */
+
+#if ( MQTT_TRANSPORT_SKIP_ENABLED == 1 )
+
+/**
+ * @brief The skip function of the transport interface of a context, or NULL
+ * if it has none.
+ */
+    #define MQTT_TRANSPORT_SKIP( pContext )    ( ( pContext )->transportInterface.skip )
+#else
+    #define MQTT_TRANSPORT_SKIP( pContext )    ( ( TransportSkip_t ) NULL )
+#endif
+
 /**
  * @brief Bytes required to encode any string length in an MQTT packet header.
  * Length is always encoded in two bytes according to the MQTT specification.
@@ -90,6 +159,16 @@
  */
 #define CORE_MQTT_UNSUBSCRIBE_PER_TOPIC_VECTOR_LENGTH    ( 2U )
 
+/**
+ * @brief Offset basis of the 32 bit FNV-1a hash used for the topic cache.
+ */
+#define TOPIC_CACHE_FNV_OFFSET_BASIS                     ( 2166136261U )
+
+/**
+ * @brief Prime of the 32 bit FNV-1a hash used for the topic cache.
+ */
+#define TOPIC_CACHE_FNV_PRIME                            ( 16777619U )
+
 struct MQTTVec
 {
     TransportOutVector_t * pVector; /**< Pointer to transport vector. USER SHOULD NOT ACCESS THIS DIRECTLY - IT IS AN INTERNAL DETAIL AND CAN CHANGE. */
@@ -150,7 +229,8 @@ static MQTTStatus_t sendConnectWithoutCopy( MQTTContext_t * pContext,
  *
  * @note The preference is given to 'writev' function if it is present in the
  * transport interface. Otherwise, a send call is made repeatedly to achieve the
- * result.
+ * result, with small consecutive vectors gathered into one call by
+ * #gatherVectors.
  *
  * @param[in] pContext Initialized MQTT context.
  * @param[in] pIoVec The vector array to be sent.
@@ -172,6 +252,90 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
                                   TransportOutVector_t * pIoVec,
                                   size_t ioVecCount );
 
+#if ( MQTT_SEND_GATHER_BUFFER_SIZE > 0U )
+
+/**
+ * @brief Copy consecutive vectors into a buffer, stopping at the first one
+ * that does not fit in the space left.
+ *
+ * @param[in] pIoVec The first vector to copy.
+ * @param[in] ioVecCount The number of vectors from @p pIoVec onwards.
+ * @param[out] pBuffer The buffer of #MQTT_SEND_GATHER_BUFFER_SIZE bytes to copy
+ * the vectors into.
+ *
+ * @return The number of bytes copied into @p pBuffer, or 0 if fewer than two
+ * vectors fit, in which case the first vector is best sent without copying.
+ */
+    static size_t gatherVectors( const TransportOutVector_t * pIoVec,
+                                 size_t ioVecCount,
+                                 uint8_t * pBuffer );
+#endif
+
+#if ( MQTT_METRICS_ENABLED == 1 )
+
+/**
+ * @brief Raise the most publish records in use in the metrics of a context
+ * to the number in use now.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ */
+    static void updateRecordsHighWater( MQTTContext_t * pContext );
+
+/**
+ * @brief Count the publish records in use.
+ *
+ * @param[in] pRecords The records, or NULL.
+ * @param[in] recordCount The number of records.
+ *
+ * @return The number of records with a packet ID.
+ */
+    static size_t countRecordsInUse( const MQTTPubAckInfo_t * pRecords,
+                                     size_t recordCount );
+
+/**
+ * @brief Start or end a busy time of the network buffer in the callback
+ * timing of a context, when bytes arrive in the empty buffer or the last of
+ * them is handled.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ */
+    static void updateBufferBusy( MQTTContext_t * pContext );
+
+/**
+ * @brief Get the time before an application callback is called, if the
+ * context times its callbacks.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ *
+ * @return The time, or 0 if the context does not time its callbacks.
+ */
+    static uint32_t callbackStartTime( const MQTTContext_t * pContext );
+
+/**
+ * @brief Record the duration of an application callback in the callback
+ * timing of a context, if it has one, and report the call if it was slow.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] packetType Type of the packet given to the callback.
+ * @param[in] startTimeMs Time returned by #callbackStartTime before the call.
+ */
+    static void recordCallbackTime( MQTTContext_t * pContext,
+                                    uint8_t packetType,
+                                    uint32_t startTimeMs );
+#endif
+
+/**
+ * @brief Give an incoming packet to the application callback, timing the
+ * call if the context times its callbacks.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] pIncomingPacket The incoming packet.
+ * @param[in] pDeserializedInfo Deserialized information of the packet.
+ */
+static void deliverToApplication( MQTTContext_t * pContext,
+                                  MQTTPacketInfo_t * pIncomingPacket,
+                                  MQTTDeserializedInfo_t * pDeserializedInfo );
+
 /**
  * @brief Add a string and its length after serializing it in a manner outlined by
  * the MQTT specification.
@@ -258,6 +422,8 @@ static MQTTPubAckType_t getAckFromPacketType( uint8_t packetType );
  * @brief Receive bytes into the network buffer.
  *
  * @param[in] pContext Initialized MQTT Context.
+ * @param[in] bufferOffset Offset in the network buffer at which to store the
+ * received bytes.
  * @param[in] bytesToRecv Number of bytes to receive.
  *
  * @note This operation calls the transport receive function
@@ -269,12 +435,46 @@ static MQTTPubAckType_t getAckFromPacketType( uint8_t packetType );
  *                    OR
  * 3. There is an error in reading from the network.
  *
+ * When the transport has a wait function, it is called instead of polling
+ * after a receive that returned no bytes.
  *
  * @return Number of bytes received, or negative number on network error.
  */
 static int32_t recvExact( MQTTContext_t * pContext,
+                          size_t bufferOffset,
                           size_t bytesToRecv );
 
+/**
+ * @brief Receive or skip an exact number of bytes, as described for
+ * #recvExact.
+ *
+ * @param[in] pContext Initialized MQTT Context.
+ * @param[in] pBuffer Buffer to receive the bytes into, or NULL to skip them
+ * with the transport skip function.
+ * @param[in] bytesToTransfer Number of bytes to receive or skip.
+ *
+ * @return Number of bytes received or skipped, or negative number on network
+ * error.
+ */
+static int32_t transferExact( MQTTContext_t * pContext,
+                              uint8_t * pBuffer,
+                              size_t bytesToTransfer );
+
+/**
+ * @brief Discard bytes of a packet that does not fit in the network buffer.
+ *
+ * The bytes are skipped with the transport skip function if it is set, and
+ * are otherwise received into the network buffer.
+ *
+ * @param[in] pContext Initialized MQTT Context.
+ * @param[in] bytesToDiscard Number of bytes to discard, at most the size of
+ * the network buffer.
+ *
+ * @return Number of bytes discarded, or negative number on network error.
+ */
+static int32_t discardExact( MQTTContext_t * pContext,
+                             size_t bytesToDiscard );
+
 /**
  * @brief Discard a packet from the transport interface.
  *
@@ -300,10 +500,14 @@ static MQTTStatus_t discardStoredPacket( MQTTContext_t * pContext,
                                          const MQTTPacketInfo_t * pPacketInfo );
 
 /**
- * @brief Receive a packet from the transport interface.
+ * @brief Receive the rest of a packet from the transport interface.
+ *
+ * The first #MQTTContext_t.index bytes of the packet are expected to be in
+ * the network buffer already. On success, the index is advanced past the
+ * end of the packet.
  *
  * @param[in] pContext MQTT Connection context.
- * @param[in] incomingPacket packet struct with remaining length.
+ * @param[in] incomingPacket packet struct with header and remaining length.
  * @param[in] remainingTimeMs Time remaining to receive the packet.
  *
  * @return #MQTTSuccess or #MQTTRecvFailed.
@@ -356,6 +560,85 @@ static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext );
 static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
                                            MQTTPacketInfo_t * pIncomingPacket );
 
+/**
+ * @brief Deserialize a received MQTT PUBLISH packet and update its state record.
+ *
+ * @param[in] pContext MQTT Connection context.
+ * @param[in] pIncomingPacket Incoming packet.
+ * @param[out] pPacketId Packet identifier of the publish.
+ * @param[out] pPublishInfo Deserialized publish information.
+ * @param[out] pPublishRecordState State of the publish after the update.
+ * @param[out] pDuplicatePublish Set to true if the publish was already received.
+ *
+ * @return MQTTSuccess, MQTTIllegalState or deserialization error.
+ */
+static MQTTStatus_t deserializeIncomingPublish( MQTTContext_t * pContext,
+                                                MQTTPacketInfo_t * pIncomingPacket,
+                                                uint16_t * pPacketId,
+                                                MQTTPublishInfo_t * pPublishInfo,
+                                                MQTTPublishState_t * pPublishRecordState,
+                                                bool * pDuplicatePublish );
+
+/**
+ * @brief Find the handler ID of the topic name of an incoming publish in the
+ * topic cache, resolving and caching it on a miss.
+ *
+ * @param[in] pContext MQTT Connection context.
+ * @param[in] pPublishInfo Deserialized incoming publish.
+ *
+ * @return The handler ID, or #MQTT_HANDLER_ID_NONE if no topic cache is used.
+ */
+static uint32_t lookUpTopicHandler( MQTTContext_t * pContext,
+                                    const MQTTPublishInfo_t * pPublishInfo );
+
+/**
+ * @brief Empty all the entries of the topic cache, if one is used.
+ *
+ * @param[in] pContext MQTT Connection context.
+ */
+static void clearTopicCache( MQTTContext_t * pContext );
+
+/**
+ * @brief Add a received MQTT PUBLISH packet to the current publish batch.
+ *
+ * The batch is delivered to the application if it becomes full. Acks for
+ * duplicate publishes are sent after the publishes before them are delivered.
+ *
+ * @param[in] pContext MQTT Connection context.
+ * @param[in] pIncomingPacket Incoming packet.
+ *
+ * @return MQTTSuccess, MQTTIllegalState, MQTTSendFailed or deserialization error.
+ */
+static MQTTStatus_t batchIncomingPublish( MQTTContext_t * pContext,
+                                          MQTTPacketInfo_t * pIncomingPacket );
+
+/**
+ * @brief Deliver the current publish batch to the application and send the
+ * acks for its publishes.
+ *
+ * @param[in] pContext MQTT Connection context.
+ *
+ * @return MQTTSuccess, MQTTIllegalState or MQTTSendFailed.
+ */
+static MQTTStatus_t flushPublishBatch( MQTTContext_t * pContext );
+
+/**
+ * @brief Handle all the complete packets in the network buffer, batching
+ * incoming publishes.
+ *
+ * @param[in] pContext MQTT Connection context.
+ * @param[in] pIncomingPacket First packet in the buffer, which must be complete.
+ * @param[in] manageKeepAlive Flag indicating if PINGRESPs should not be given
+ * to the application
+ * @param[out] pBytesConsumed Number of bytes of the buffer handled.
+ *
+ * @return MQTTSuccess, MQTTIllegalState, MQTTSendFailed or deserialization error.
+ */
+static MQTTStatus_t handleIncomingPacketBatch( MQTTContext_t * pContext,
+                                               const MQTTPacketInfo_t * pIncomingPacket,
+                                               bool manageKeepAlive,
+                                               size_t * pBytesConsumed );
+
 /**
  * @brief Handle received MQTT publish acks.
  *
@@ -543,6 +826,46 @@ static bool matchWildcards( const char * pTopicName,
                             uint16_t * pFilterIndex,
                             bool * pMatch );
 
+/**
+ * @brief Find the next level separator in a topic name or filter.
+ *
+ * @param[in] pTopic The topic name or filter.
+ * @param[in] topicLength Length of the topic.
+ * @param[in] startIndex Index to start searching from.
+ *
+ * @return Index of the next '/' at or after @p startIndex, or @p topicLength
+ * if there is none.
+ */
+static uint16_t findLevelSeparator( const char * pTopic,
+                                    uint16_t topicLength,
+                                    uint16_t startIndex );
+
+/**
+ * @brief Count the bytes that are equal at the start of two buffers.
+ *
+ * @param[in] pFirst The first buffer.
+ * @param[in] pSecond The second buffer.
+ * @param[in] length Number of bytes to compare.
+ *
+ * @return Index of the first byte that differs, or @p length if all are equal.
+ */
+static uint16_t countEqualBytes( const char * pFirst,
+                                 const char * pSecond,
+                                 uint16_t length );
+
+/**
+ * @brief Find the first byte not allowed in a topic name: a wildcard or a
+ * null character.
+ *
+ * @param[in] pTopicName The topic name.
+ * @param[in] topicNameLength Length of the topic name.
+ *
+ * @return Index of the first byte not allowed, or @p topicNameLength if the
+ * topic name has none.
+ */
+static uint16_t findInvalidTopicNameByte( const char * pTopicName,
+                                          uint16_t topicNameLength );
+
 /**
  * @brief Match a topic name and topic filter allowing the use of wildcards.
  *
@@ -560,6 +883,164 @@ static bool matchTopicFilter( const char * pTopicName,
 
 /*-----------------------------------------------------------*/
 
+static uint16_t findLevelSeparator( const char * pTopic,
+                                    uint16_t topicLength,
+                                    uint16_t startIndex )
+{
+    uint16_t index = startIndex;
+    bool separatorFound = false;
+
+    #if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ )
+        const __m128i separators = _mm_set1_epi8( '/' );
+        __m128i block;
+        uint32_t separatorMask;
+    #endif
+
+    assert( pTopic != NULL );
+    assert( startIndex <= topicLength );
+
+    #if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ )
+        while( ( separatorFound == false ) && ( ( uint16_t ) ( topicLength - index ) >= TOPIC_BLOCK_SIZE ) )
+        {
+            /* One bit for each byte of the block that is a level separator. */
+            block = _mm_loadu_si128( ( const __m128i * ) &( pTopic[ index ] ) );
+            separatorMask = ( uint32_t ) _mm_movemask_epi8( _mm_cmpeq_epi8( block, separators ) );
+
+            if( separatorMask != 0U )
+            {
+                index += ( uint16_t ) __builtin_ctz( separatorMask );
+                separatorFound = true;
+            }
+            else
+            {
+                index += ( uint16_t ) TOPIC_BLOCK_SIZE;
+            }
+        }
+    #endif /* if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ ) */
+
+    while( ( separatorFound == false ) && ( index < topicLength ) )
+    {
+        if( pTopic[ index ] == '/' )
+        {
+            separatorFound = true;
+        }
+        else
+        {
+            index++;
+        }
+    }
+
+    return index;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t countEqualBytes( const char * pFirst,
+                                 const char * pSecond,
+                                 uint16_t length )
+{
+    uint16_t index = 0U;
+    bool differenceFound = false;
+
+    #if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ )
+        __m128i firstBlock, secondBlock;
+        uint32_t equalMask;
+    #endif
+
+    assert( pFirst != NULL );
+    assert( pSecond != NULL );
+
+    #if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ )
+        while( ( differenceFound == false ) && ( ( uint16_t ) ( length - index ) >= TOPIC_BLOCK_SIZE ) )
+        {
+            firstBlock = _mm_loadu_si128( ( const __m128i * ) &( pFirst[ index ] ) );
+            secondBlock = _mm_loadu_si128( ( const __m128i * ) &( pSecond[ index ] ) );
+            equalMask = ( uint32_t ) _mm_movemask_epi8( _mm_cmpeq_epi8( firstBlock, secondBlock ) );
+
+            if( equalMask != TOPIC_BLOCK_MASK )
+            {
+                index += ( uint16_t ) __builtin_ctz( ~equalMask );
+                differenceFound = true;
+            }
+            else
+            {
+                index += ( uint16_t ) TOPIC_BLOCK_SIZE;
+            }
+        }
+    #endif /* if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ ) */
+
+    while( ( differenceFound == false ) && ( index < length ) )
+    {
+        if( pFirst[ index ] != pSecond[ index ] )
+        {
+            differenceFound = true;
+        }
+        else
+        {
+            index++;
+        }
+    }
+
+    return index;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t findInvalidTopicNameByte( const char * pTopicName,
+                                          uint16_t topicNameLength )
+{
+    uint16_t index = 0U;
+    bool invalidByteFound = false;
+
+    #if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ )
+        const __m128i singleLevelWildcards = _mm_set1_epi8( '+' );
+        const __m128i multiLevelWildcards = _mm_set1_epi8( '#' );
+        const __m128i nullCharacters = _mm_setzero_si128();
+        __m128i block, invalidBytes;
+        uint32_t invalidMask;
+    #endif
+
+    assert( pTopicName != NULL );
+
+    #if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ )
+        while( ( invalidByteFound == false ) && ( ( uint16_t ) ( topicNameLength - index ) >= TOPIC_BLOCK_SIZE ) )
+        {
+            block = _mm_loadu_si128( ( const __m128i * ) &( pTopicName[ index ] ) );
+            invalidBytes = _mm_or_si128( _mm_cmpeq_epi8( block, singleLevelWildcards ),
+                                         _mm_cmpeq_epi8( block, multiLevelWildcards ) );
+            invalidBytes = _mm_or_si128( invalidBytes, _mm_cmpeq_epi8( block, nullCharacters ) );
+            invalidMask = ( uint32_t ) _mm_movemask_epi8( invalidBytes );
+
+            if( invalidMask != 0U )
+            {
+                index += ( uint16_t ) __builtin_ctz( invalidMask );
+                invalidByteFound = true;
+            }
+            else
+            {
+                index += ( uint16_t ) TOPIC_BLOCK_SIZE;
+            }
+        }
+    #endif /* if ( MQTT_TOPIC_SIMD == 1 ) && defined( __SSE2__ ) */
+
+    while( ( invalidByteFound == false ) && ( index < topicNameLength ) )
+    {
+        if( ( pTopicName[ index ] == '+' ) || ( pTopicName[ index ] == '#' ) ||
+            ( pTopicName[ index ] == '\0' ) )
+        {
+            invalidByteFound = true;
+        }
+        else
+        {
+            index++;
+        }
+    }
+
+    return index;
+}
+
+/*-----------------------------------------------------------*/
+
 static bool matchEndWildcardsSpecialCases( const char * pTopicFilter,
                                            uint16_t topicFilterLength,
                                            uint16_t filterIndex )
@@ -633,17 +1114,8 @@ static bool matchWildcards( const char * pTopicName,
         /* Move topic name index to the end of the current level. The end of the
          * current level is identified by the last character before the next level
          * separator '/'. */
-        while( *pNameIndex < topicNameLength )
-        {
-            /* Exit the loop if we hit the level separator. */
-            if( pTopicName[ *pNameIndex ] == '/' )
-            {
-                nextLevelExistsInTopicName = true;
-                break;
-            }
-
-            ( *pNameIndex )++;
-        }
+        *pNameIndex = findLevelSeparator( pTopicName, topicNameLength, *pNameIndex );
+        nextLevelExistsInTopicName = ( *pNameIndex < topicNameLength );
 
         /* Determine if the topic filter contains a child level after the current level
          * represented by the '+' wildcard. */
@@ -712,6 +1184,7 @@ static bool matchTopicFilter( const char * pTopicName,
 {
     bool matchFound = false, shouldStopMatching = false;
     uint16_t nameIndex = 0, filterIndex = 0;
+    uint16_t remainingLength, equalCount;
 
     assert( pTopicName != NULL );
     assert( topicNameLength != 0 );
@@ -720,18 +1193,33 @@ static bool matchTopicFilter( const char * pTopicName,
 
     while( ( nameIndex < topicNameLength ) && ( filterIndex < topicFilterLength ) )
     {
-        /* Check if the character in the topic name matches the corresponding
-         * character in the topic filter string. */
-        if( pTopicName[ nameIndex ] == pTopicFilter[ filterIndex ] )
+        remainingLength = topicNameLength - nameIndex;
+
+        if( remainingLength > ( topicFilterLength - filterIndex ) )
         {
+            remainingLength = topicFilterLength - filterIndex;
+        }
+
+        /* Skip the characters that match in the topic name and the topic
+         * filter, several at a time. */
+        equalCount = countEqualBytes( &( pTopicName[ nameIndex ] ),
+                                      &( pTopicFilter[ filterIndex ] ),
+                                      remainingLength );
+
+        if( equalCount > 0U )
+        {
+            nameIndex += equalCount;
+            filterIndex += equalCount;
+
             /* If the topic name has been consumed but the topic filter has not
              * been consumed, match for special cases when the topic filter ends
-             * with wildcard character. */
-            if( nameIndex == ( topicNameLength - 1U ) )
+             * with wildcard character. filterIndex is positive here, as
+             * equalCount is. */
+            if( nameIndex == topicNameLength )
             {
                 matchFound = matchEndWildcardsSpecialCases( pTopicFilter,
                                                             topicFilterLength,
-                                                            filterIndex );
+                                                            ( uint16_t ) ( filterIndex - 1U ) );
             }
         }
         else
@@ -744,16 +1232,19 @@ static bool matchTopicFilter( const char * pTopicName,
                                                  &nameIndex,
                                                  &filterIndex,
                                                  &matchFound );
+
+            if( shouldStopMatching == false )
+            {
+                /* Move past the level separator, or the end of the topic name. */
+                nameIndex++;
+                filterIndex++;
+            }
         }
 
         if( ( matchFound == true ) || ( shouldStopMatching == true ) )
         {
             break;
         }
-
-        /* Increment indexes. */
-        nameIndex++;
-        filterIndex++;
     }
 
     if( matchFound == false )
@@ -780,14 +1271,30 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
     TransportOutVector_t * pIoVectIterator;
     size_t vectorsToBeSent = ioVecCount;
     size_t bytesToSend = 0U;
+    size_t bytesGiven = 0U;
+    const void * pBytesGiven = NULL;
     int32_t bytesSentOrError = 0;
 
+    #if ( MQTT_SEND_GATHER_BUFFER_SIZE > 0U )
+        uint8_t gatherBuffer[ MQTT_SEND_GATHER_BUFFER_SIZE ];
+        size_t gatheredBytes;
+    #endif
+
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        size_t packetTypeIndex = 0U;
+    #endif
+
     assert( pContext != NULL );
     assert( pIoVec != NULL );
     assert( pContext->getTime != NULL );
     /* Send must always be defined */
     assert( pContext->transportInterface.send != NULL );
 
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        /* The first byte of a packet holds its type. */
+        packetTypeIndex = MQTT_METRICS_INDEX( *( ( const uint8_t * ) pIoVec->iov_base ) );
+    #endif
+
     /* Count the total number of bytes to be sent as outlined in the vector. */
     for( pIoVectIterator = pIoVec; pIoVectIterator <= &( pIoVec[ ioVecCount - 1U ] ); pIoVectIterator++ )
     {
@@ -804,17 +1311,34 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
     {
         if( pContext->transportInterface.writev != NULL )
         {
+            bytesGiven = bytesToSend - ( size_t ) bytesSentOrError;
             sendResult = pContext->transportInterface.writev( pContext->transportInterface.pNetworkContext,
                                                               pIoVectIterator,
                                                               vectorsToBeSent );
         }
         else
         {
+            pBytesGiven = pIoVectIterator->iov_base;
+            bytesGiven = pIoVectIterator->iov_len;
+
+            #if ( MQTT_SEND_GATHER_BUFFER_SIZE > 0U )
+                gatheredBytes = gatherVectors( pIoVectIterator, vectorsToBeSent, gatherBuffer );
+
+                if( gatheredBytes > 0U )
+                {
+                    pBytesGiven = gatherBuffer;
+                    bytesGiven = gatheredBytes;
+                }
+            #endif
+
             sendResult = pContext->transportInterface.send( pContext->transportInterface.pNetworkContext,
-                                                            pIoVectIterator->iov_base,
-                                                            pIoVectIterator->iov_len );
+                                                            pBytesGiven,
+                                                            bytesGiven );
         }
 
+        MQTT_METRICS_ADD( pContext, transportSendCalls, 1U );
+        MQTT_METRICS_ADD( pContext, partialSends, ( ( sendResult >= 0 ) && ( ( size_t ) sendResult < bytesGiven ) ) ? 1U : 0U );
+
         if( sendResult > 0 )
         {
             /* It is a bug in the application's transport send implementation if
@@ -822,6 +1346,7 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
             assert( sendResult <= ( ( int32_t ) bytesToSend - bytesSentOrError ) );
 
             bytesSentOrError += sendResult;
+            MQTT_METRICS_ADD( pContext, bytesSent[ packetTypeIndex ], ( uint64_t ) sendResult );
 
             /* Set last transmission time. */
             pContext->lastPacketTxTime = pContext->getTime();
@@ -872,9 +1397,210 @@ static int32_t sendMessageVector( MQTTContext_t * pContext,
         }
     }
 
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        if( bytesSentOrError == ( int32_t ) bytesToSend )
+        {
+            MQTT_METRICS_ADD( pContext, packetsSent[ packetTypeIndex ], 1U );
+        }
+    #endif
+
     return bytesSentOrError;
 }
 
+/*-----------------------------------------------------------*/
+
+#if ( MQTT_SEND_GATHER_BUFFER_SIZE > 0U )
+
+    static size_t gatherVectors( const TransportOutVector_t * pIoVec,
+                                 size_t ioVecCount,
+                                 uint8_t * pBuffer )
+    {
+        size_t gatheredBytes = 0U;
+        size_t gatheredVectors = 0U;
+
+        assert( pIoVec != NULL );
+        assert( pBuffer != NULL );
+
+        while( ( gatheredVectors < ioVecCount ) &&
+               ( pIoVec[ gatheredVectors ].iov_len <= ( MQTT_SEND_GATHER_BUFFER_SIZE - gatheredBytes ) ) )
+        {
+            ( void ) memcpy( &pBuffer[ gatheredBytes ],
+                             pIoVec[ gatheredVectors ].iov_base,
+                             pIoVec[ gatheredVectors ].iov_len );
+            gatheredBytes += pIoVec[ gatheredVectors ].iov_len;
+            gatheredVectors++;
+        }
+
+        if( gatheredVectors < 2U )
+        {
+            gatheredBytes = 0U;
+        }
+
+        return gatheredBytes;
+    }
+
+#endif /* if ( MQTT_SEND_GATHER_BUFFER_SIZE > 0U ) */
+
+/*-----------------------------------------------------------*/
+
+#if ( MQTT_METRICS_ENABLED == 1 )
+
+    static void updateRecordsHighWater( MQTTContext_t * pContext )
+    {
+        size_t recordsInUse;
+
+        assert( pContext != NULL );
+
+        if( pContext->pMetrics != NULL )
+        {
+            recordsInUse = countRecordsInUse( pContext->outgoingPublishRecords,
+                                              pContext->outgoingPublishRecordMaxCount );
+
+            if( recordsInUse > pContext->pMetrics->outgoingPublishRecordsMax )
+            {
+                pContext->pMetrics->outgoingPublishRecordsMax = recordsInUse;
+            }
+
+            recordsInUse = countRecordsInUse( pContext->incomingPublishRecords,
+                                              pContext->incomingPublishRecordMaxCount );
+
+            if( recordsInUse > pContext->pMetrics->incomingPublishRecordsMax )
+            {
+                pContext->pMetrics->incomingPublishRecordsMax = recordsInUse;
+            }
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    static size_t countRecordsInUse( const MQTTPubAckInfo_t * pRecords,
+                                     size_t recordCount )
+    {
+        size_t recordsInUse = 0U;
+        size_t i;
+
+        if( pRecords != NULL )
+        {
+            for( i = 0U; i < recordCount; i++ )
+            {
+                if( pRecords[ i ].packetId != MQTT_PACKET_ID_INVALID )
+                {
+                    recordsInUse++;
+                }
+            }
+        }
+
+        return recordsInUse;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static void updateBufferBusy( MQTTContext_t * pContext )
+    {
+        MQTTCallbackTiming_t * pTiming = pContext->pCallbackTiming;
+        uint32_t busyMs;
+
+        if( pTiming != NULL )
+        {
+            if( ( pContext->index > 0U ) && ( pTiming->bufferBusy == false ) )
+            {
+                pTiming->bufferBusySinceMs = pContext->getTime();
+                pTiming->bufferBusy = true;
+            }
+            else if( ( pContext->index == 0U ) && ( pTiming->bufferBusy == true ) )
+            {
+                busyMs = pContext->getTime() - pTiming->bufferBusySinceMs;
+                pTiming->bufferBusyMs += busyMs;
+
+                if( busyMs > pTiming->bufferBusyMaxMs )
+                {
+                    pTiming->bufferBusyMaxMs = busyMs;
+                }
+
+                pTiming->bufferBusy = false;
+            }
+            else
+            {
+                /* Empty else MISRA 15.7 */
+            }
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    static uint32_t callbackStartTime( const MQTTContext_t * pContext )
+    {
+        uint32_t startTimeMs = 0U;
+
+        if( pContext->pCallbackTiming != NULL )
+        {
+            startTimeMs = pContext->getTime();
+        }
+
+        return startTimeMs;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static void recordCallbackTime( MQTTContext_t * pContext,
+                                    uint8_t packetType,
+                                    uint32_t startTimeMs )
+    {
+        MQTTCallbackTiming_t * pTiming = pContext->pCallbackTiming;
+        size_t typeIndex = MQTT_METRICS_INDEX( packetType );
+        uint32_t durationMs;
+
+        if( pTiming != NULL )
+        {
+            durationMs = pContext->getTime() - startTimeMs;
+
+            MQTT_RecordLatency( &pTiming->duration, durationMs );
+            pTiming->calls[ typeIndex ]++;
+            pTiming->totalMs[ typeIndex ] += durationMs;
+
+            if( durationMs > pTiming->maxMs[ typeIndex ] )
+            {
+                pTiming->maxMs[ typeIndex ] = durationMs;
+            }
+
+            if( durationMs > pTiming->budgetMs )
+            {
+                pTiming->slowCalls++;
+
+                if( pTiming->slowConsumerCallback != NULL )
+                {
+                    pTiming->slowConsumerCallback( pContext,
+                                                   ( uint8_t ) ( packetType & 0xF0U ),
+                                                   durationMs );
+                }
+            }
+        }
+    }
+
+#endif /* if ( MQTT_METRICS_ENABLED == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+static void deliverToApplication( MQTTContext_t * pContext,
+                                  MQTTPacketInfo_t * pIncomingPacket,
+                                  MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        uint32_t startTimeMs = callbackStartTime( pContext );
+    #endif
+
+    MQTT_TRACE( Dispatch, pContext, pIncomingPacket->type, pDeserializedInfo->packetIdentifier,
+                pIncomingPacket->headerLength + pIncomingPacket->remainingLength, pDeserializedInfo->deserializationResult );
+
+    pContext->appCallback( pContext, pIncomingPacket, pDeserializedInfo );
+
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        recordCallbackTime( pContext, pIncomingPacket->type, startTimeMs );
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
 static int32_t sendBuffer( MQTTContext_t * pContext,
                            const uint8_t * pBufferToSend,
                            size_t bytesToSend )
@@ -898,6 +1624,9 @@ static int32_t sendBuffer( MQTTContext_t * pContext,
                                                         pIndex,
                                                         bytesToSend - ( size_t ) bytesSentOrError );
 
+        MQTT_METRICS_ADD( pContext, transportSendCalls, 1U );
+        MQTT_METRICS_ADD( pContext, partialSends, ( ( sendResult >= 0 ) && ( sendResult < ( ( int32_t ) bytesToSend - bytesSentOrError ) ) ) ? 1U : 0U );
+
         if( sendResult > 0 )
         {
             /* It is a bug in the application's transport send implementation if
@@ -906,6 +1635,7 @@ static int32_t sendBuffer( MQTTContext_t * pContext,
 
             bytesSentOrError += sendResult;
             pIndex = &pIndex[ sendResult ];
+            MQTT_METRICS_ADD( pContext, bytesSent[ MQTT_METRICS_INDEX( pBufferToSend[ 0 ] ) ], ( uint64_t ) sendResult );
 
             /* Set last transmission time. */
             pContext->lastPacketTxTime = pContext->getTime();
@@ -937,6 +1667,13 @@ static int32_t sendBuffer( MQTTContext_t * pContext,
         }
     }
 
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        if( ( bytesToSend > 0U ) && ( bytesSentOrError == ( int32_t ) bytesToSend ) )
+        {
+            MQTT_METRICS_ADD( pContext, packetsSent[ MQTT_METRICS_INDEX( pBufferToSend[ 0 ] ) ], 1U );
+        }
+    #endif
+
     return bytesSentOrError;
 }
 
@@ -964,43 +1701,81 @@ static MQTTPubAckType_t getAckFromPacketType( uint8_t packetType )
             ackType = MQTTPubrec;
             break;
 
-        case MQTT_PACKET_TYPE_PUBREL:
-            ackType = MQTTPubrel;
-            break;
+        case MQTT_PACKET_TYPE_PUBREL:
+            ackType = MQTTPubrel;
+            break;
+
+        default:
+
+            /* This function is only called after checking the type is one of
+             * the above four values, so packet type must be PUBCOMP here. */
+            assert( packetType == MQTT_PACKET_TYPE_PUBCOMP );
+            ackType = MQTTPubcomp;
+            break;
+    }
+
+    return ackType;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t recvExact( MQTTContext_t * pContext,
+                          size_t bufferOffset,
+                          size_t bytesToRecv )
+{
+    assert( pContext != NULL );
+    assert( bufferOffset <= pContext->networkBuffer.size );
+    assert( bytesToRecv <= ( pContext->networkBuffer.size - bufferOffset ) );
+    assert( pContext->networkBuffer.pBuffer != NULL );
+
+    return transferExact( pContext,
+                          &( pContext->networkBuffer.pBuffer[ bufferOffset ] ),
+                          bytesToRecv );
+}
+
+/*-----------------------------------------------------------*/
 
-        default:
+static int32_t discardExact( MQTTContext_t * pContext,
+                             size_t bytesToDiscard )
+{
+    int32_t bytesDiscarded;
 
-            /* This function is only called after checking the type is one of
-             * the above four values, so packet type must be PUBCOMP here. */
-            assert( packetType == MQTT_PACKET_TYPE_PUBCOMP );
-            ackType = MQTTPubcomp;
-            break;
+    assert( pContext != NULL );
+
+    if( MQTT_TRANSPORT_SKIP( pContext ) != NULL )
+    {
+        bytesDiscarded = transferExact( pContext, NULL, bytesToDiscard );
+    }
+    else
+    {
+        bytesDiscarded = recvExact( pContext, 0U, bytesToDiscard );
     }
 
-    return ackType;
+    return bytesDiscarded;
 }
 
 /*-----------------------------------------------------------*/
 
-static int32_t recvExact( MQTTContext_t * pContext,
-                          size_t bytesToRecv )
+static int32_t transferExact( MQTTContext_t * pContext,
+                              uint8_t * pBuffer,
+                              size_t bytesToTransfer )
 {
-    uint8_t * pIndex = NULL;
-    size_t bytesRemaining = bytesToRecv;
+    uint8_t * pIndex = pBuffer;
+    size_t bytesRemaining = bytesToTransfer;
     int32_t totalBytesRecvd = 0, bytesRecvd;
     uint32_t lastDataRecvTimeMs = 0U, timeSinceLastRecvMs = 0U;
     TransportRecv_t recvFunc = NULL;
+    TransportSkip_t skipFunc = NULL;
     MQTTGetCurrentTimeFunc_t getTimeStampMs = NULL;
     bool receiveError = false;
 
     assert( pContext != NULL );
-    assert( bytesToRecv <= pContext->networkBuffer.size );
     assert( pContext->getTime != NULL );
     assert( pContext->transportInterface.recv != NULL );
-    assert( pContext->networkBuffer.pBuffer != NULL );
+    assert( ( pBuffer != NULL ) || ( MQTT_TRANSPORT_SKIP( pContext ) != NULL ) );
 
-    pIndex = pContext->networkBuffer.pBuffer;
     recvFunc = pContext->transportInterface.recv;
+    skipFunc = MQTT_TRANSPORT_SKIP( pContext );
     getTimeStampMs = pContext->getTime;
 
     /* Part of the MQTT packet has been read before calling this function. */
@@ -1008,9 +1783,19 @@ static int32_t recvExact( MQTTContext_t * pContext,
 
     while( ( bytesRemaining > 0U ) && ( receiveError == false ) )
     {
-        bytesRecvd = recvFunc( pContext->transportInterface.pNetworkContext,
-                               pIndex,
-                               bytesRemaining );
+        if( pIndex == NULL )
+        {
+            bytesRecvd = skipFunc( pContext->transportInterface.pNetworkContext,
+                                   bytesRemaining );
+            MQTT_METRICS_ADD( pContext, transportSkipCalls, 1U );
+        }
+        else
+        {
+            bytesRecvd = recvFunc( pContext->transportInterface.pNetworkContext,
+                                   pIndex,
+                                   bytesRemaining );
+            MQTT_METRICS_ADD( pContext, transportRecvCalls, 1U );
+        }
 
         if( bytesRecvd < 0 )
         {
@@ -1042,8 +1827,13 @@ static int32_t recvExact( MQTTContext_t * pContext,
 
             bytesRemaining -= ( size_t ) bytesRecvd;
             totalBytesRecvd += ( int32_t ) bytesRecvd;
+
             /* Increment the index. */
-            pIndex = &pIndex[ bytesRecvd ];
+            if( pIndex != NULL )
+            {
+                pIndex = &pIndex[ bytesRecvd ];
+            }
+
             LogDebug( ( "BytesReceived=%ld, BytesRemaining=%lu, TotalBytesReceived=%ld.",
                         ( long int ) bytesRecvd,
                         ( unsigned long ) bytesRemaining,
@@ -1052,6 +1842,7 @@ static int32_t recvExact( MQTTContext_t * pContext,
         else
         {
             /* No bytes were read from the network. */
+            MQTT_METRICS_ADD( pContext, zeroByteRecvs, 1U );
             timeSinceLastRecvMs = calculateElapsedTime( getTimeStampMs(), lastDataRecvTimeMs );
 
             /* Check for timeout if we have been waiting to receive any byte on the network. */
@@ -1060,6 +1851,20 @@ static int32_t recvExact( MQTTContext_t * pContext,
                 LogError( ( "Unable to receive packet: Timed out in transport recv." ) );
                 receiveError = true;
             }
+
+            #if ( MQTT_TRANSPORT_WAIT_READABLE_ENABLED == 1 )
+                else if( pContext->transportInterface.waitReadable != NULL )
+                {
+                    /* Block until bytes arrive rather than polling the receive
+                     * function. An error is returned by the next receive. */
+                    ( void ) pContext->transportInterface.waitReadable( pContext->transportInterface.pNetworkContext,
+                                                                        MQTT_RECV_POLLING_TIMEOUT_MS - timeSinceLastRecvMs );
+                }
+            #endif
+            else
+            {
+                /* Empty else MISRA 15.7 */
+            }
         }
     }
 
@@ -1084,6 +1889,8 @@ static MQTTStatus_t discardPacket( MQTTContext_t * pContext,
     assert( pContext != NULL );
     assert( pContext->getTime != NULL );
 
+    /* Discard these many bytes at a time. Skipped bytes need no buffer, but
+     * are skipped in the same chunks, so the timeout is checked between them. */
     bytesToReceive = pContext->networkBuffer.size;
     getTimeStampMs = pContext->getTime;
 
@@ -1096,7 +1903,7 @@ static MQTTStatus_t discardPacket( MQTTContext_t * pContext,
             bytesToReceive = remainingLength - totalBytesReceived;
         }
 
-        bytesReceived = recvExact( pContext, bytesToReceive );
+        bytesReceived = discardExact( pContext, bytesToReceive );
 
         if( bytesReceived != ( int32_t ) bytesToReceive )
         {
@@ -1154,12 +1961,14 @@ static MQTTStatus_t discardStoredPacket( MQTTContext_t * pContext,
      * receive buffer. */
     assert( mqttPacketSize > pContext->networkBuffer.size );
 
-    /* Discard these many bytes at a time. */
-    bytesToReceive = pContext->networkBuffer.size;
-
     /* Number of bytes depicted by 'index' have already been received. */
     remainingLength = mqttPacketSize - pContext->index;
 
+    /* Discard these many bytes at a time. Skipped bytes need no buffer, but
+     * are skipped in the same chunks, so that one call does not wait on a
+     * whole packet of up to 256 MB. */
+    bytesToReceive = pContext->networkBuffer.size;
+
     while( ( totalBytesReceived < remainingLength ) && ( receiveError == false ) )
     {
         if( ( remainingLength - totalBytesReceived ) < bytesToReceive )
@@ -1167,7 +1976,7 @@ static MQTTStatus_t discardStoredPacket( MQTTContext_t * pContext,
             bytesToReceive = remainingLength - totalBytesReceived;
         }
 
-        bytesReceived = recvExact( pContext, bytesToReceive );
+        bytesReceived = discardExact( pContext, bytesToReceive );
 
         if( bytesReceived != ( int32_t ) bytesToReceive )
         {
@@ -1189,15 +1998,13 @@ static MQTTStatus_t discardStoredPacket( MQTTContext_t * pContext,
                     ( unsigned long ) totalBytesReceived ) );
         /* Packet dumped, so no data is available. */
         status = MQTTNoDataAvailable;
+        MQTT_METRICS_ADD( pContext, discardedPackets, 1U );
+        MQTT_METRICS_ADD( pContext, discardedBytes, ( uint64_t ) mqttPacketSize );
     }
 
-    /* Clear the buffer */
-    ( void ) memset( pContext->networkBuffer.pBuffer,
-                     0,
-                     pContext->networkBuffer.size );
-
-    /* Reset the index. */
+    /* Reset the index. The bytes left in the buffer are not used again. */
     pContext->index = 0;
+    pContext->pendingPacket.headerLength = 0U;
 
     return status;
 }
@@ -1211,31 +2018,48 @@ static MQTTStatus_t receivePacket( MQTTContext_t * pContext,
     MQTTStatus_t status = MQTTSuccess;
     int32_t bytesReceived = 0;
     size_t bytesToReceive = 0U;
+    size_t packetSize = 0U;
 
     assert( pContext != NULL );
     assert( pContext->networkBuffer.pBuffer != NULL );
 
-    if( incomingPacket.remainingLength > pContext->networkBuffer.size )
+    packetSize = incomingPacket.headerLength + incomingPacket.remainingLength;
+
+    if( packetSize > pContext->networkBuffer.size )
     {
         LogError( ( "Incoming packet will be dumped: "
                     "Packet length exceeds network buffer size."
                     "PacketSize=%lu, NetworkBufferSize=%lu.",
-                    ( unsigned long ) incomingPacket.remainingLength,
+                    ( unsigned long ) packetSize,
                     ( unsigned long ) pContext->networkBuffer.size ) );
         status = discardPacket( pContext,
-                                incomingPacket.remainingLength,
+                                packetSize - pContext->index,
                                 remainingTimeMs );
+        pContext->index = 0U;
+
+        if( status == MQTTNoDataAvailable )
+        {
+            MQTT_METRICS_ADD( pContext, discardedPackets, 1U );
+            MQTT_METRICS_ADD( pContext, discardedBytes, ( uint64_t ) packetSize );
+        }
+    }
+    else if( pContext->index >= packetSize )
+    {
+        /* The whole packet was read along with its header. */
+        LogDebug( ( "Packet received with its header. PacketSize=%lu.",
+                    ( unsigned long ) packetSize ) );
     }
     else
     {
-        bytesToReceive = incomingPacket.remainingLength;
-        bytesReceived = recvExact( pContext, bytesToReceive );
+        bytesToReceive = packetSize - pContext->index;
+        bytesReceived = recvExact( pContext, pContext->index, bytesToReceive );
 
         if( bytesReceived == ( int32_t ) bytesToReceive )
         {
             /* Receive successful, bytesReceived == bytesToReceive. */
             LogDebug( ( "Packet received. ReceivedBytes=%ld.",
                         ( long int ) bytesReceived ) );
+            pContext->index += bytesToReceive;
         }
         else
         {
@@ -1343,6 +2167,7 @@ static MQTTStatus_t sendPublishAcks( MQTTContext_t * pContext,
         if( status == MQTTSuccess )
         {
             pContext->controlPacketSent = true;
+            MQTT_TRACE( AckSent, pContext, packetTypeByte, packetId, MQTT_PUBLISH_ACK_PACKET_SIZE, status );
 
             MQTT_PRE_STATE_UPDATE_HOOK( pContext );
 
@@ -1354,7 +2179,11 @@ static MQTTStatus_t sendPublishAcks( MQTTContext_t * pContext,
 
             MQTT_POST_STATE_UPDATE_HOOK( pContext );
 
-            if( status != MQTTSuccess )
+            if( status == MQTTSuccess )
+            {
+                MQTT_TRACE( StateChange, pContext, packetTypeByte, packetId, 0U, newState );
+            }
+            else
             {
                 LogError( ( "Failed to update state of publish %hu.",
                             ( unsigned short ) packetId ) );
@@ -1401,6 +2230,8 @@ static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext )
             MQTT_PINGRESP_TIMEOUT_MS )
         {
             status = MQTTKeepAliveTimeout;
+            MQTT_METRICS_ADD( pContext, keepAliveTimeouts, 1U );
+            MQTT_TRACE( KeepAliveTimeout, pContext, MQTT_PACKET_TYPE_PINGRESP, 0U, 0U, status );
         }
     }
     else
@@ -1412,6 +2243,7 @@ static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext )
         if( ( packetTxTimeoutMs != 0U ) && ( calculateElapsedTime( now, lastPacketTxTime ) >= packetTxTimeoutMs ) )
         {
             status = MQTT_Ping( pContext );
+            MQTT_METRICS_ADD( pContext, keepAlivePingsSent, ( status == MQTTSuccess ) ? 1U : 0U );
         }
         else
         {
@@ -1420,6 +2252,7 @@ static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext )
             if( ( timeElapsed != 0U ) && ( timeElapsed >= PACKET_RX_TIMEOUT_MS ) )
             {
                 status = MQTT_Ping( pContext );
+                MQTT_METRICS_ADD( pContext, keepAlivePingsSent, ( status == MQTTSuccess ) ? 1U : 0U );
             }
         }
     }
@@ -1429,27 +2262,32 @@ static MQTTStatus_t handleKeepAlive( MQTTContext_t * pContext )
 
 /*-----------------------------------------------------------*/
 
-static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
-                                           MQTTPacketInfo_t * pIncomingPacket )
+static MQTTStatus_t deserializeIncomingPublish( MQTTContext_t * pContext,
+                                                MQTTPacketInfo_t * pIncomingPacket,
+                                                uint16_t * pPacketId,
+                                                MQTTPublishInfo_t * pPublishInfo,
+                                                MQTTPublishState_t * pPublishRecordState,
+                                                bool * pDuplicatePublish )
 {
     MQTTStatus_t status = MQTTBadParameter;
     MQTTPublishState_t publishRecordState = MQTTStateNull;
     uint16_t packetIdentifier = 0U;
-    MQTTPublishInfo_t publishInfo;
-    MQTTDeserializedInfo_t deserializedInfo;
     bool duplicatePublish = false;
 
     assert( pContext != NULL );
     assert( pIncomingPacket != NULL );
-    assert( pContext->appCallback != NULL );
+    assert( pPacketId != NULL );
+    assert( pPublishInfo != NULL );
+    assert( pPublishRecordState != NULL );
+    assert( pDuplicatePublish != NULL );
 
-    status = MQTT_DeserializePublish( pIncomingPacket, &packetIdentifier, &publishInfo );
+    status = MQTT_DeserializePublish( pIncomingPacket, &packetIdentifier, pPublishInfo );
     LogInfo( ( "De-serialized incoming PUBLISH packet: DeserializerResult=%s.",
                MQTT_Status_strerror( status ) ) );
 
     if( ( status == MQTTSuccess ) &&
         ( pContext->incomingPublishRecords == NULL ) &&
-        ( publishInfo.qos > MQTTQoS0 ) )
+        ( pPublishInfo->qos > MQTTQoS0 ) )
     {
         LogError( ( "Incoming publish has QoS > MQTTQoS0 but incoming "
                     "publish records have not been initialized. Dropping the "
@@ -1465,7 +2303,7 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
         status = MQTT_UpdateStatePublish( pContext,
                                           packetIdentifier,
                                           MQTT_RECEIVE,
-                                          publishInfo.qos,
+                                          pPublishInfo->qos,
                                           &publishRecordState );
 
         MQTT_POST_STATE_UPDATE_HOOK( pContext );
@@ -1474,6 +2312,8 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
         {
             LogInfo( ( "State record updated. New state=%s.",
                        MQTT_State_strerror( publishRecordState ) ) );
+            MQTT_METRICS_RECORDS( pContext );
+            MQTT_TRACE( StateChange, pContext, pIncomingPacket->type, packetIdentifier, 0U, publishRecordState );
         }
 
         /* Different cases in which an incoming publish with duplicate flag is
@@ -1510,12 +2350,12 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
             /* Calculate the state for the ack packet that needs to be sent out
              * for the duplicate incoming publish. */
             publishRecordState = MQTT_CalculateStatePublish( MQTT_RECEIVE,
-                                                             publishInfo.qos );
+                                                             pPublishInfo->qos );
 
             LogDebug( ( "Incoming publish packet with packet id %hu already exists.",
                         ( unsigned short ) packetIdentifier ) );
 
-            if( publishInfo.dup == false )
+            if( pPublishInfo->dup == false )
             {
                 LogError( ( "DUP flag is 0 for duplicate packet (MQTT-3.3.1.-1)." ) );
             }
@@ -1529,12 +2369,133 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
         }
     }
 
+    *pPacketId = packetIdentifier;
+    *pPublishRecordState = publishRecordState;
+    *pDuplicatePublish = duplicatePublish;
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t lookUpTopicHandler( MQTTContext_t * pContext,
+                                    const MQTTPublishInfo_t * pPublishInfo )
+{
+    uint32_t handlerId = MQTT_HANDLER_ID_NONE;
+    uint32_t hash = TOPIC_CACHE_FNV_OFFSET_BASIS;
+    MQTTTopicCacheEntry_t * pEntry = NULL;
+    char * pCachedName = NULL;
+    size_t entryIndex;
+    uint16_t i;
+    bool cacheHit = false;
+
+    assert( pContext != NULL );
+    assert( pPublishInfo != NULL );
+    assert( pPublishInfo->pTopicName != NULL );
+
+    if( pContext->resolveTopicFunction != NULL )
+    {
+        for( i = 0U; i < pPublishInfo->topicNameLength; i++ )
+        {
+            hash ^= ( uint32_t ) ( ( uint8_t ) pPublishInfo->pTopicName[ i ] );
+            hash *= TOPIC_CACHE_FNV_PRIME;
+        }
+
+        /* Each hash has a single entry, which the latest topic name with the
+         * hash replaces. */
+        entryIndex = ( size_t ) hash % pContext->topicCacheEntryCount;
+        pEntry = &( pContext->pTopicCache[ entryIndex ] );
+        pCachedName = &( pContext->pTopicCacheNames[ entryIndex * pContext->topicCacheNameLengthMax ] );
+
+        MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+        if( ( pEntry->topicNameLength == pPublishInfo->topicNameLength ) &&
+            ( pEntry->hash == hash ) &&
+            ( memcmp( pCachedName, pPublishInfo->pTopicName, pPublishInfo->topicNameLength ) == 0 ) )
+        {
+            handlerId = pEntry->handlerId;
+            cacheHit = true;
+            pContext->topicCacheHits++;
+        }
+        else
+        {
+            pContext->topicCacheMisses++;
+        }
+
+        MQTT_POST_STATE_UPDATE_HOOK( pContext );
+
+        if( cacheHit == false )
+        {
+            /* The application resolves the topic name without the state
+             * update hook held, so that it may use other MQTT APIs. */
+            handlerId = pContext->resolveTopicFunction( pContext,
+                                                        pPublishInfo->pTopicName,
+                                                        pPublishInfo->topicNameLength );
+
+            if( pPublishInfo->topicNameLength <= pContext->topicCacheNameLengthMax )
+            {
+                MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+
+                ( void ) memcpy( pCachedName, pPublishInfo->pTopicName, pPublishInfo->topicNameLength );
+                pEntry->hash = hash;
+                pEntry->handlerId = handlerId;
+                pEntry->topicNameLength = pPublishInfo->topicNameLength;
+
+                MQTT_POST_STATE_UPDATE_HOOK( pContext );
+            }
+        }
+    }
+
+    return handlerId;
+}
+
+/*-----------------------------------------------------------*/
+
+static void clearTopicCache( MQTTContext_t * pContext )
+{
+    size_t i;
+
+    assert( pContext != NULL );
+
+    if( pContext->pTopicCache != NULL )
+    {
+        for( i = 0U; i < pContext->topicCacheEntryCount; i++ )
+        {
+            pContext->pTopicCache[ i ].topicNameLength = 0U;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
+                                           MQTTPacketInfo_t * pIncomingPacket )
+{
+    MQTTStatus_t status = MQTTBadParameter;
+    MQTTPublishState_t publishRecordState = MQTTStateNull;
+    uint16_t packetIdentifier = 0U;
+    MQTTPublishInfo_t publishInfo;
+    MQTTDeserializedInfo_t deserializedInfo;
+    bool duplicatePublish = false;
+
+    assert( pContext != NULL );
+    assert( pIncomingPacket != NULL );
+    assert( pContext->appCallback != NULL );
+
+    status = deserializeIncomingPublish( pContext,
+                                         pIncomingPacket,
+                                         &packetIdentifier,
+                                         &publishInfo,
+                                         &publishRecordState,
+                                         &duplicatePublish );
+
     if( status == MQTTSuccess )
     {
         /* Set fields of deserialized struct. */
         deserializedInfo.packetIdentifier = packetIdentifier;
         deserializedInfo.pPublishInfo = &publishInfo;
         deserializedInfo.deserializationResult = status;
+        deserializedInfo.handlerId = MQTT_HANDLER_ID_NONE;
 
         /* Invoke application callback to hand the buffer over to application
          * before sending acks.
@@ -1542,9 +2503,11 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
          * duplicate incoming publishes. */
         if( duplicatePublish == false )
         {
-            pContext->appCallback( pContext,
-                                   pIncomingPacket,
-                                   &deserializedInfo );
+            deserializedInfo.handlerId = lookUpTopicHandler( pContext, &publishInfo );
+
+            deliverToApplication( pContext,
+                                  pIncomingPacket,
+                                  &deserializedInfo );
         }
 
         /* Send PUBACK or PUBREC if necessary. */
@@ -1558,6 +2521,211 @@ static MQTTStatus_t handleIncomingPublish( MQTTContext_t * pContext,
 
 /*-----------------------------------------------------------*/
 
+static MQTTStatus_t batchIncomingPublish( MQTTContext_t * pContext,
+                                          MQTTPacketInfo_t * pIncomingPacket )
+{
+    MQTTStatus_t status = MQTTBadParameter;
+    MQTTPublishState_t publishRecordState = MQTTStateNull;
+    uint16_t packetIdentifier = 0U;
+    MQTTPublishInfo_t * pPublishInfo = NULL;
+    MQTTDeserializedInfo_t * pDeserializedInfo = NULL;
+    bool duplicatePublish = false;
+
+    assert( pContext != NULL );
+    assert( pIncomingPacket != NULL );
+    assert( pContext->publishBatchCallback != NULL );
+    assert( pContext->publishBatchCount < pContext->publishBatchMaxCount );
+
+    pPublishInfo = &( pContext->pPublishBatchInfo[ pContext->publishBatchCount ] );
+
+    status = deserializeIncomingPublish( pContext,
+                                         pIncomingPacket,
+                                         &packetIdentifier,
+                                         pPublishInfo,
+                                         &publishRecordState,
+                                         &duplicatePublish );
+
+    if( ( status == MQTTSuccess ) && ( duplicatePublish == true ) )
+    {
+        /* Duplicate publishes are not given to the application, but the acks
+         * must still go out in the order the publishes were received. */
+        status = flushPublishBatch( pContext );
+
+        if( status == MQTTSuccess )
+        {
+            status = sendPublishAcks( pContext,
+                                      packetIdentifier,
+                                      publishRecordState );
+        }
+    }
+    else if( status == MQTTSuccess )
+    {
+        pDeserializedInfo = &( pContext->pPublishBatch[ pContext->publishBatchCount ] );
+        pDeserializedInfo->packetIdentifier = packetIdentifier;
+        pDeserializedInfo->pPublishInfo = pPublishInfo;
+        pDeserializedInfo->deserializationResult = status;
+        pDeserializedInfo->handlerId = lookUpTopicHandler( pContext, pPublishInfo );
+        pContext->publishBatchCount++;
+
+        if( pContext->publishBatchCount == pContext->publishBatchMaxCount )
+        {
+            status = flushPublishBatch( pContext );
+        }
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static MQTTStatus_t flushPublishBatch( MQTTContext_t * pContext )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTPublishState_t publishRecordState = MQTTStateNull;
+    size_t batchCount;
+    size_t i;
+
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        uint32_t startTimeMs = 0U;
+    #endif
+
+    assert( pContext != NULL );
+
+    batchCount = pContext->publishBatchCount;
+
+    if( batchCount > 0U )
+    {
+        assert( pContext->publishBatchCallback != NULL );
+
+        #if ( MQTT_METRICS_ENABLED == 1 )
+            startTimeMs = callbackStartTime( pContext );
+        #endif
+
+        MQTT_TRACE( Dispatch, pContext, MQTT_PACKET_TYPE_PUBLISH, 0U, batchCount, MQTTSuccess );
+
+        /* Hand the publishes over to the application before sending acks. */
+        pContext->publishBatchCallback( pContext,
+                                        pContext->pPublishBatch,
+                                        batchCount );
+
+        #if ( MQTT_METRICS_ENABLED == 1 )
+            recordCallbackTime( pContext, MQTT_PACKET_TYPE_PUBLISH, startTimeMs );
+        #endif
+        pContext->publishBatchCount = 0U;
+
+        for( i = 0U; ( i < batchCount ) && ( status == MQTTSuccess ); i++ )
+        {
+            /* The state of a new incoming publish depends only on its QoS. */
+            publishRecordState = MQTT_CalculateStatePublish( MQTT_RECEIVE,
+                                                             pContext->pPublishBatchInfo[ i ].qos );
+
+            /* Send PUBACK or PUBREC if necessary. */
+            status = sendPublishAcks( pContext,
+                                      pContext->pPublishBatch[ i ].packetIdentifier,
+                                      publishRecordState );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static MQTTStatus_t handleIncomingPacketBatch( MQTTContext_t * pContext,
+                                               const MQTTPacketInfo_t * pIncomingPacket,
+                                               bool manageKeepAlive,
+                                               size_t * pBytesConsumed )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTStatus_t flushStatus = MQTTSuccess;
+    MQTTPacketInfo_t packet;
+    size_t offset = 0U;
+    size_t available = 0U;
+    bool packetComplete = true;
+
+    assert( pContext != NULL );
+    assert( pIncomingPacket != NULL );
+    assert( pBytesConsumed != NULL );
+
+    packet = *pIncomingPacket;
+
+    while( packetComplete == true )
+    {
+        packet.pRemainingData = &( pContext->networkBuffer.pBuffer[ offset + packet.headerLength ] );
+        MQTT_METRICS_RECEIVED( pContext, &packet );
+        MQTT_TRACE( PacketReceived, pContext, packet.type, 0U,
+                    packet.headerLength + packet.remainingLength, MQTTSuccess );
+
+        /* PUBLISH packets allow flags in the lower four bits. For other
+         * packet types, they are reserved. */
+        if( ( packet.type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+        {
+            pContext->deliveredIndex = offset + packet.headerLength + packet.remainingLength;
+            status = batchIncomingPublish( pContext, &packet );
+        }
+        else
+        {
+            /* Publishes received before this packet are delivered first. */
+            pContext->deliveredIndex = offset;
+            status = flushPublishBatch( pContext );
+            offset -= pContext->takenLength;
+            pContext->takenLength = 0U;
+            pContext->deliveredIndex = 0U;
+
+            if( status == MQTTSuccess )
+            {
+                packet.pRemainingData = &( pContext->networkBuffer.pBuffer[ offset + packet.headerLength ] );
+                status = handleIncomingAck( pContext, &packet, manageKeepAlive );
+            }
+        }
+
+        /* Offsets are relative to the current network buffer, which starts
+         * after the bytes taken by the application, if any. */
+        offset += packet.headerLength + packet.remainingLength;
+        offset -= pContext->takenLength;
+        pContext->takenLength = 0U;
+        pContext->deliveredIndex = 0U;
+        packetComplete = false;
+
+        /* Continue with the next packet only if it is entirely in the buffer.
+         * Anything else is left for the next receive iteration. */
+        if( ( status == MQTTSuccess ) && ( offset < pContext->index ) )
+        {
+            available = pContext->index - offset;
+
+            if( MQTT_ProcessIncomingPacketTypeAndLength( &( pContext->networkBuffer.pBuffer[ offset ] ),
+                                                         &available,
+                                                         &packet ) == MQTTSuccess )
+            {
+                packetComplete = ( ( packet.headerLength + packet.remainingLength ) <= available );
+            }
+        }
+    }
+
+    /* Deliver what is left in the batch even on failure, since the state
+     * records of those publishes have already been updated. */
+    pContext->deliveredIndex = offset;
+    flushStatus = flushPublishBatch( pContext );
+    offset -= pContext->takenLength;
+    pContext->takenLength = 0U;
+    pContext->deliveredIndex = 0U;
+
+    if( status == MQTTSuccess )
+    {
+        status = flushStatus;
+    }
+
+    *pBytesConsumed = offset;
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
 static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
                                        MQTTPacketInfo_t * pIncomingPacket )
 {
@@ -1565,15 +2733,12 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
     MQTTPublishState_t publishRecordState = MQTTStateNull;
     uint16_t packetIdentifier;
     MQTTPubAckType_t ackType;
-    MQTTEventCallback_t appCallback;
     MQTTDeserializedInfo_t deserializedInfo;
 
     assert( pContext != NULL );
     assert( pIncomingPacket != NULL );
     assert( pContext->appCallback != NULL );
 
-    appCallback = pContext->appCallback;
-
     ackType = getAckFromPacketType( pIncomingPacket->type );
     status = MQTT_DeserializeAck( pIncomingPacket, &packetIdentifier, NULL );
     LogInfo( ( "Ack packet deserialized with result: %s.",
@@ -1595,6 +2760,7 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
         {
             LogInfo( ( "State record updated. New state=%s.",
                        MQTT_State_strerror( publishRecordState ) ) );
+            MQTT_TRACE( StateChange, pContext, pIncomingPacket->type, packetIdentifier, 0U, publishRecordState );
         }
         else
         {
@@ -1620,10 +2786,11 @@ static MQTTStatus_t handlePublishAcks( MQTTContext_t * pContext,
         deserializedInfo.packetIdentifier = packetIdentifier;
         deserializedInfo.deserializationResult = status;
         deserializedInfo.pPublishInfo = NULL;
+        deserializedInfo.handlerId = MQTT_HANDLER_ID_NONE;
 
         /* Invoke application callback to hand the buffer over to application
          * before sending acks. */
-        appCallback( pContext, pIncomingPacket, &deserializedInfo );
+        deliverToApplication( pContext, pIncomingPacket, &deserializedInfo );
 
         /* Send PUBREL or PUBCOMP if necessary. */
         status = sendPublishAcks( pContext,
@@ -1650,14 +2817,11 @@ static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
      * sending any PUBREL or PUBCOMP. However, for other cases, we invoke it
      * at the end to reduce the complexity of this function. */
     bool invokeAppCallback = false;
-    MQTTEventCallback_t appCallback = NULL;
 
     assert( pContext != NULL );
     assert( pIncomingPacket != NULL );
     assert( pContext->appCallback != NULL );
 
-    appCallback = pContext->appCallback;
-
     LogDebug( ( "Received packet of type %02x.",
                 ( unsigned int ) pIncomingPacket->type ) );
 
@@ -1689,6 +2853,12 @@ static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
             /* Deserialize and give these to the app provided callback. */
             status = MQTT_DeserializeAck( pIncomingPacket, &packetIdentifier, NULL );
             invokeAppCallback = ( status == MQTTSuccess ) || ( status == MQTTServerRefused );
+
+            /* The subscriptions changed, so cached topic names may now
+             * resolve to different handlers. */
+            MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+            clearTopicCache( pContext );
+            MQTT_POST_STATE_UPDATE_HOOK( pContext );
             break;
 
         default:
@@ -1705,7 +2875,8 @@ static MQTTStatus_t handleIncomingAck( MQTTContext_t * pContext,
         deserializedInfo.packetIdentifier = packetIdentifier;
         deserializedInfo.deserializationResult = status;
         deserializedInfo.pPublishInfo = NULL;
-        appCallback( pContext, pIncomingPacket, &deserializedInfo );
+        deserializedInfo.handlerId = MQTT_HANDLER_ID_NONE;
+        deliverToApplication( pContext, pIncomingPacket, &deserializedInfo );
         /* In case a SUBACK indicated refusal, reset the status to continue the loop. */
         status = MQTTSuccess;
     }
@@ -1729,6 +2900,7 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
     recvBytes = pContext->transportInterface.recv( pContext->transportInterface.pNetworkContext,
                                                    &( pContext->networkBuffer.pBuffer[ pContext->index ] ),
                                                    pContext->networkBuffer.size - pContext->index );
+    MQTT_METRICS_ADD( pContext, transportRecvCalls, 1U );
 
     if( recvBytes < 0 )
     {
@@ -1757,10 +2929,26 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
     {
         /* Update the number of bytes in the MQTT fixed buffer. */
         pContext->index += ( size_t ) recvBytes;
+        MQTT_BUFFER_BUSY( pContext );
+
+        if( pContext->pendingPacket.headerLength != 0U )
+        {
+            /* The header was parsed by an earlier call; only the arrival of
+             * the rest of the packet needs to be checked. */
+            incomingPacket = pContext->pendingPacket;
+            status = MQTTSuccess;
+        }
+        else
+        {
+            status = MQTT_ProcessIncomingPacketTypeAndLength( pContext->networkBuffer.pBuffer,
+                                                              &( pContext->index ),
+                                                              &incomingPacket );
 
-        status = MQTT_ProcessIncomingPacketTypeAndLength( pContext->networkBuffer.pBuffer,
-                                                          &( pContext->index ),
-                                                          &incomingPacket );
+            if( status == MQTTSuccess )
+            {
+                pContext->pendingPacket = incomingPacket;
+            }
+        }
 
         totalMQTTPacketLength = incomingPacket.remainingLength + incomingPacket.headerLength;
     }
@@ -1768,6 +2956,8 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
     /* No data was received, check for keep alive timeout. */
     if( recvBytes == 0 )
     {
+        MQTT_METRICS_ADD( pContext, zeroByteRecvs, 1U );
+
         if( manageKeepAlive == true )
         {
             /* Keep the copy of the status to be reset later. */
@@ -1825,19 +3015,42 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
     {
         incomingPacket.pRemainingData = &pContext->networkBuffer.pBuffer[ incomingPacket.headerLength ];
 
+        if( pContext->publishBatchCallback != NULL )
+        {
+            /* Handle every complete packet in the buffer so that the incoming
+             * publishes among them are delivered together. */
+            status = handleIncomingPacketBatch( pContext,
+                                                &incomingPacket,
+                                                manageKeepAlive,
+                                                &totalMQTTPacketLength );
+        }
         /* PUBLISH packets allow flags in the lower four bits. For other
          * packet types, they are reserved. */
-        if( ( incomingPacket.type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+        else if( ( incomingPacket.type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
         {
+            MQTT_METRICS_RECEIVED( pContext, &incomingPacket );
+            MQTT_TRACE( PacketReceived, pContext, incomingPacket.type, 0U,
+                        totalMQTTPacketLength, MQTTSuccess );
+            pContext->deliveredIndex = totalMQTTPacketLength;
             status = handleIncomingPublish( pContext, &incomingPacket );
+
+            /* The packet is no longer in the network buffer if the application
+             * took the buffer. */
+            totalMQTTPacketLength -= pContext->takenLength;
+            pContext->takenLength = 0U;
+            pContext->deliveredIndex = 0U;
         }
         else
         {
+            MQTT_METRICS_RECEIVED( pContext, &incomingPacket );
+            MQTT_TRACE( PacketReceived, pContext, incomingPacket.type, 0U,
+                        totalMQTTPacketLength, MQTTSuccess );
             status = handleIncomingAck( pContext, &incomingPacket, manageKeepAlive );
         }
 
         /* Update the index to reflect the remaining bytes in the buffer.  */
         pContext->index -= totalMQTTPacketLength;
+        pContext->pendingPacket.headerLength = 0U;
 
         /* Move the remaining bytes to the front of the buffer. */
         ( void ) memmove( pContext->networkBuffer.pBuffer,
@@ -1850,6 +3063,9 @@ static MQTTStatus_t receiveSingleIteration( MQTTContext_t * pContext,
         }
     }
 
+    MQTT_METRICS_ADD( pContext, needMoreBytes, ( status == MQTTNeedMoreBytes ) ? 1U : 0U );
+    MQTT_BUFFER_BUSY( pContext );
+
     if( status == MQTTNoDataAvailable )
     {
         /* No data available is not an error. Reset to MQTTSuccess so the
@@ -2412,24 +3628,40 @@ static MQTTStatus_t receiveConnack( MQTTContext_t * pContext,
     bool breakFromLoop = false;
     uint16_t loopCount = 0U;
 
+    #if ( MQTT_TRANSPORT_WAIT_READABLE_ENABLED == 1 )
+        TransportWaitReadable_t waitReadable = NULL;
+    #endif
+
     assert( pContext != NULL );
     assert( pIncomingPacket != NULL );
     assert( pContext->getTime != NULL );
 
     getTimeStamp = pContext->getTime;
 
+    #if ( MQTT_TRANSPORT_WAIT_READABLE_ENABLED == 1 )
+        waitReadable = pContext->transportInterface.waitReadable;
+    #endif
+
+    /* Nothing received before the CONNECT was sent belongs to this
+     * connection. */
+    pContext->index = 0U;
+    pContext->pendingPacket.headerLength = 0U;
+
     /* Get the entry time for the function. */
     entryTimeMs = getTimeStamp();
 
     do
     {
-        /* Transport read for incoming CONNACK packet type and length.
-         * MQTT_GetIncomingPacketTypeAndLength is a blocking call and it is
-         * returned after a transport receive timeout, an error, or a successful
-         * receive of packet type and length. */
-        status = MQTT_GetIncomingPacketTypeAndLength( pContext->transportInterface.recv,
-                                                      pContext->transportInterface.pNetworkContext,
-                                                      pIncomingPacket );
+        /* Transport read for incoming CONNACK packet type and length. The
+         * buffered variant reads whatever is available into the network buffer
+         * with a single receive call, so a CONNACK that arrives in one segment
+         * is received with one read. Bytes beyond the fixed header are kept
+         * in the network buffer. */
+        status = MQTT_GetIncomingPacketTypeAndLengthBuffered( pContext->transportInterface.recv,
+                                                              pContext->transportInterface.pNetworkContext,
+                                                              &( pContext->networkBuffer ),
+                                                              &( pContext->index ),
+                                                              pIncomingPacket );
 
         /* The loop times out based on 2 conditions.
          * 1. If timeoutMs is greater than 0:
@@ -2442,7 +3674,20 @@ static MQTTStatus_t receiveConnack( MQTTContext_t * pContext,
          *    A value of 0 for the config will try once to read CONNACK. */
         if( timeoutMs > 0U )
         {
-            breakFromLoop = calculateElapsedTime( getTimeStamp(), entryTimeMs ) >= timeoutMs;
+            timeTakenMs = calculateElapsedTime( getTimeStamp(), entryTimeMs );
+            breakFromLoop = timeTakenMs >= timeoutMs;
+
+            #if ( MQTT_TRANSPORT_WAIT_READABLE_ENABLED == 1 )
+
+                /* Block until the CONNACK arrives rather than polling the
+                 * receive function, when the transport can wait. */
+                if( ( breakFromLoop == false ) && ( waitReadable != NULL ) &&
+                    ( ( status == MQTTNoDataAvailable ) || ( status == MQTTNeedMoreBytes ) ) )
+                {
+                    ( void ) waitReadable( pContext->transportInterface.pNetworkContext,
+                                           timeoutMs - timeTakenMs );
+                }
+            #endif
         }
         else
         {
@@ -2451,7 +3696,14 @@ static MQTTStatus_t receiveConnack( MQTTContext_t * pContext,
         }
 
         /* Loop until there is data to read or if we have exceeded the timeout/retries. */
-    } while( ( status == MQTTNoDataAvailable ) && ( breakFromLoop == false ) );
+    } while( ( ( status == MQTTNoDataAvailable ) || ( status == MQTTNeedMoreBytes ) ) &&
+             ( breakFromLoop == false ) );
+
+    if( status == MQTTNeedMoreBytes )
+    {
+        LogError( ( "Timed out while receiving the CONNACK fixed header." ) );
+        status = MQTTRecvFailed;
+    }
 
     if( status == MQTTSuccess )
     {
@@ -2465,7 +3717,8 @@ static MQTTStatus_t receiveConnack( MQTTContext_t * pContext,
             remainingTimeMs = timeoutMs - timeTakenMs;
         }
 
-        /* Reading the remainder of the packet by transport recv.
+        /* Reading the remainder of the packet by transport recv, if it was
+         * not already read along with the header.
          * Attempt to read once even if the timeout has expired.
          * Invoking receivePacket with remainingTime as 0 would attempt to
          * recv from network once. If using retries, the remainder of the
@@ -2491,12 +3744,31 @@ static MQTTStatus_t receiveConnack( MQTTContext_t * pContext,
     if( status == MQTTSuccess )
     {
         /* Update the packet info pointer to the buffer read. */
-        pIncomingPacket->pRemainingData = pContext->networkBuffer.pBuffer;
+        pIncomingPacket->pRemainingData = &( pContext->networkBuffer.pBuffer[ pIncomingPacket->headerLength ] );
+        MQTT_METRICS_RECEIVED( pContext, pIncomingPacket );
+        MQTT_TRACE( PacketReceived, pContext, pIncomingPacket->type, 0U,
+                    pIncomingPacket->headerLength + pIncomingPacket->remainingLength, MQTTSuccess );
 
         /* Deserialize CONNACK. */
         status = MQTT_DeserializeAck( pIncomingPacket, NULL, pSessionPresent );
     }
 
+    if( status == MQTTSuccess )
+    {
+        /* Keep any bytes received after the CONNACK for the process loop. */
+        pContext->index -= pIncomingPacket->headerLength + pIncomingPacket->remainingLength;
+
+        ( void ) memmove( pContext->networkBuffer.pBuffer,
+                          &( pContext->networkBuffer.pBuffer[ pIncomingPacket->headerLength + pIncomingPacket->remainingLength ] ),
+                          pContext->index );
+    }
+    else
+    {
+        /* Drop partially received data so that it is not mistaken for the
+         * start of the next packet. */
+        pContext->index = 0U;
+    }
+
     /* If a clean session is requested, a session present should not be set by
      * broker. */
     if( status == MQTTSuccess )
@@ -2590,9 +3862,9 @@ static MQTTStatus_t handleCleanSession( MQTTContext_t * pContext )
 
     assert( pContext != NULL );
 
-    /* Reset the index and clear the buffer when a new session is established. */
-    pContext->index = 0;
-    ( void ) memset( pContext->networkBuffer.pBuffer, 0, pContext->networkBuffer.size );
+    /* The network buffer is not cleared. It was emptied before the CONNECT
+     * was sent, and holds only the bytes received after the CONNACK, which
+     * belong to the new session. */
 
     if( pContext->clearFunction != NULL )
     {
@@ -2832,6 +4104,374 @@ MQTTStatus_t MQTT_InitRetransmits( MQTTContext_t * pContext,
 
 /*-----------------------------------------------------------*/
 
+MQTTStatus_t MQTT_InitPublishBatch( MQTTContext_t * pContext,
+                                    MQTTPublishBatchCallback_t publishBatchCallback,
+                                    MQTTDeserializedInfo_t * pDeserializedInfoArray,
+                                    MQTTPublishInfo_t * pPublishInfoArray,
+                                    size_t batchMaxCount )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    if( pContext == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p\n",
+                    ( void * ) pContext ) );
+        status = MQTTBadParameter;
+    }
+    else if( publishBatchCallback == NULL )
+    {
+        LogError( ( "Invalid parameter: publishBatchCallback is NULL" ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pDeserializedInfoArray == NULL ) || ( pPublishInfoArray == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pDeserializedInfoArray=%p, "
+                    "pPublishInfoArray=%p",
+                    ( void * ) pDeserializedInfoArray,
+                    ( void * ) pPublishInfoArray ) );
+        status = MQTTBadParameter;
+    }
+    else if( batchMaxCount == 0U )
+    {
+        LogError( ( "Invalid parameter: batchMaxCount cannot be 0" ) );
+        status = MQTTBadParameter;
+    }
+    else if( pContext->appCallback == NULL )
+    {
+        LogError( ( "MQTT_InitPublishBatch must be called only after MQTT_Init has"
+                    " been called successfully.\n" ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        pContext->publishBatchCallback = publishBatchCallback;
+        pContext->pPublishBatch = pDeserializedInfoArray;
+        pContext->pPublishBatchInfo = pPublishInfoArray;
+        pContext->publishBatchMaxCount = batchMaxCount;
+        pContext->publishBatchCount = 0U;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_InitBufferExchange( MQTTContext_t * pContext,
+                                      MQTTGetBuffer_t getBufferFunction )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    if( pContext == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p\n",
+                    ( void * ) pContext ) );
+        status = MQTTBadParameter;
+    }
+    else if( getBufferFunction == NULL )
+    {
+        LogError( ( "Invalid parameter: getBufferFunction is NULL" ) );
+        status = MQTTBadParameter;
+    }
+    else if( pContext->appCallback == NULL )
+    {
+        LogError( ( "MQTT_InitBufferExchange must be called only after MQTT_Init has"
+                    " been called successfully.\n" ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        pContext->getBufferFunction = getBufferFunction;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_TakeReceiveBuffer( MQTTContext_t * pContext,
+                                     MQTTFixedBuffer_t * pTakenBuffer )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTFixedBuffer_t newBuffer = { 0 };
+    size_t remainingBytes = 0U;
+
+    if( ( pContext == NULL ) || ( pTakenBuffer == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pContext=%p, "
+                    "pTakenBuffer=%p",
+                    ( void * ) pContext,
+                    ( void * ) pTakenBuffer ) );
+        status = MQTTBadParameter;
+    }
+    else if( pContext->getBufferFunction == NULL )
+    {
+        LogError( ( "MQTT_InitBufferExchange must be called before the network "
+                    "buffer can be taken." ) );
+        status = MQTTBadParameter;
+    }
+    else if( pContext->deliveredIndex == 0U )
+    {
+        LogError( ( "The network buffer can only be taken while an incoming "
+                    "publish is given to the application." ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        remainingBytes = pContext->index - pContext->deliveredIndex;
+
+        if( ( pContext->getBufferFunction( pContext, remainingBytes, &newBuffer ) == false ) ||
+            ( newBuffer.pBuffer == NULL ) ||
+            ( newBuffer.size == 0U ) ||
+            ( newBuffer.size < remainingBytes ) )
+        {
+            LogError( ( "No replacement network buffer of at least %lu bytes is available.",
+                        ( unsigned long ) remainingBytes ) );
+            status = MQTTNoMemory;
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        /* Move the bytes received after the delivered packets to the new
+         * buffer, leaving the old buffer untouched for the application. */
+        ( void ) memcpy( newBuffer.pBuffer,
+                         &( pContext->networkBuffer.pBuffer[ pContext->deliveredIndex ] ),
+                         remainingBytes );
+
+        *pTakenBuffer = pContext->networkBuffer;
+        pContext->networkBuffer = newBuffer;
+        pContext->index = remainingBytes;
+
+        /* Record how much the start of the buffer moved so the receive loop
+         * can adjust its offsets. The buffer cannot be taken again until more
+         * data is delivered. */
+        pContext->takenLength += pContext->deliveredIndex;
+        pContext->deliveredIndex = 0U;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_InitTopicCache( MQTTContext_t * pContext,
+                                  MQTTResolveTopic_t resolveTopicFunction,
+                                  MQTTTopicCacheEntry_t * pEntries,
+                                  char * pTopicNameBuffer,
+                                  size_t entryCount,
+                                  size_t topicNameLengthMax )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    if( pContext == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p\n",
+                    ( void * ) pContext ) );
+        status = MQTTBadParameter;
+    }
+    else if( resolveTopicFunction == NULL )
+    {
+        LogError( ( "Invalid parameter: resolveTopicFunction is NULL" ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pEntries == NULL ) || ( pTopicNameBuffer == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pEntries=%p, "
+                    "pTopicNameBuffer=%p",
+                    ( void * ) pEntries,
+                    ( void * ) pTopicNameBuffer ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( entryCount == 0U ) || ( topicNameLengthMax == 0U ) )
+    {
+        LogError( ( "Invalid parameter: entryCount=%lu, topicNameLengthMax=%lu",
+                    ( unsigned long ) entryCount,
+                    ( unsigned long ) topicNameLengthMax ) );
+        status = MQTTBadParameter;
+    }
+    else if( pContext->appCallback == NULL )
+    {
+        LogError( ( "MQTT_InitTopicCache must be called only after MQTT_Init has"
+                    " been called successfully.\n" ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        pContext->resolveTopicFunction = resolveTopicFunction;
+        pContext->pTopicCache = pEntries;
+        pContext->pTopicCacheNames = pTopicNameBuffer;
+        pContext->topicCacheEntryCount = entryCount;
+        pContext->topicCacheNameLengthMax = topicNameLengthMax;
+        pContext->topicCacheHits = 0U;
+        pContext->topicCacheMisses = 0U;
+
+        clearTopicCache( pContext );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_InvalidateTopicCache( MQTTContext_t * pContext )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    if( pContext == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pContext=%p\n",
+                    ( void * ) pContext ) );
+        status = MQTTBadParameter;
+    }
+    else if( pContext->pTopicCache == NULL )
+    {
+        LogError( ( "MQTT_InitTopicCache must be called before the topic cache "
+                    "can be invalidated." ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        MQTT_PRE_STATE_UPDATE_HOOK( pContext );
+        clearTopicCache( pContext );
+        MQTT_POST_STATE_UPDATE_HOOK( pContext );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( MQTT_METRICS_ENABLED == 1 )
+
+    MQTTStatus_t MQTT_InitMetrics( MQTTContext_t * pContext,
+                                   MQTTMetrics_t * pMetrics )
+    {
+        MQTTStatus_t status = MQTTSuccess;
+
+        if( ( pContext == NULL ) || ( pMetrics == NULL ) )
+        {
+            LogError( ( "Argument cannot be NULL: pContext=%p, pMetrics=%p",
+                        ( void * ) pContext,
+                        ( void * ) pMetrics ) );
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            ( void ) memset( pMetrics, 0x00, sizeof( MQTTMetrics_t ) );
+            pContext->pMetrics = pMetrics;
+        }
+
+        return status;
+    }
+
+/*-----------------------------------------------------------*/
+
+    MQTTStatus_t MQTT_GetMetrics( const MQTTContext_t * pContext,
+                                  MQTTMetrics_t * pMetrics )
+    {
+        MQTTStatus_t status = MQTTSuccess;
+
+        if( ( pContext == NULL ) || ( pMetrics == NULL ) )
+        {
+            LogError( ( "Argument cannot be NULL: pContext=%p, pMetrics=%p",
+                        ( const void * ) pContext,
+                        ( void * ) pMetrics ) );
+            status = MQTTBadParameter;
+        }
+        else if( pContext->pMetrics == NULL )
+        {
+            LogError( ( "MQTT_InitMetrics must be called before the metrics "
+                        "can be read." ) );
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            *pMetrics = *( pContext->pMetrics );
+        }
+
+        return status;
+    }
+
+/*-----------------------------------------------------------*/
+
+    MQTTStatus_t MQTT_ResetMetrics( MQTTContext_t * pContext )
+    {
+        MQTTStatus_t status = MQTTSuccess;
+
+        if( pContext == NULL )
+        {
+            LogError( ( "Argument cannot be NULL: pContext=%p",
+                        ( void * ) pContext ) );
+            status = MQTTBadParameter;
+        }
+        else if( pContext->pMetrics == NULL )
+        {
+            LogError( ( "MQTT_InitMetrics must be called before the metrics "
+                        "can be reset." ) );
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            ( void ) memset( pContext->pMetrics, 0x00, sizeof( MQTTMetrics_t ) );
+        }
+
+        return status;
+    }
+
+/*-----------------------------------------------------------*/
+
+    MQTTStatus_t MQTT_InitAckLatency( MQTTContext_t * pContext,
+                                      MQTTAckLatency_t * pAckLatency )
+    {
+        MQTTStatus_t status = MQTTSuccess;
+
+        if( ( pContext == NULL ) || ( pAckLatency == NULL ) )
+        {
+            LogError( ( "Argument cannot be NULL: pContext=%p, pAckLatency=%p",
+                        ( void * ) pContext,
+                        ( void * ) pAckLatency ) );
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            ( void ) memset( pAckLatency, 0x00, sizeof( MQTTAckLatency_t ) );
+            pContext->pAckLatency = pAckLatency;
+        }
+
+        return status;
+    }
+
+/*-----------------------------------------------------------*/
+
+    MQTTStatus_t MQTT_InitCallbackTiming( MQTTContext_t * pContext,
+                                          MQTTCallbackTiming_t * pTiming,
+                                          uint32_t budgetMs,
+                                          MQTTSlowConsumer_t slowConsumerCallback )
+    {
+        MQTTStatus_t status = MQTTSuccess;
+
+        if( ( pContext == NULL ) || ( pTiming == NULL ) )
+        {
+            LogError( ( "Argument cannot be NULL: pContext=%p, pTiming=%p",
+                        ( void * ) pContext,
+                        ( void * ) pTiming ) );
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            ( void ) memset( pTiming, 0x00, sizeof( MQTTCallbackTiming_t ) );
+            pTiming->budgetMs = budgetMs;
+            pTiming->slowConsumerCallback = slowConsumerCallback;
+            pContext->pCallbackTiming = pTiming;
+        }
+
+        return status;
+    }
+
+#endif /* if ( MQTT_METRICS_ENABLED == 1 ) */
+
+/*-----------------------------------------------------------*/
+
 MQTTStatus_t MQTT_CancelCallback( const MQTTContext_t * pContext,
                                   uint16_t packetId )
 {
@@ -3079,6 +4719,11 @@ MQTTStatus_t MQTT_Subscribe( MQTTContext_t * pContext,
                                                remainingLength );
         }
 
+        if( status == MQTTSuccess )
+        {
+            clearTopicCache( pContext );
+        }
+
         MQTT_POST_STATE_UPDATE_HOOK( pContext );
     }
 
@@ -3157,6 +4802,8 @@ MQTTStatus_t MQTT_Publish( MQTTContext_t * pContext,
             {
                 status = MQTTSuccess;
             }
+
+            MQTT_METRICS_RECORDS( pContext );
         }
 
         if( status == MQTTSuccess )
@@ -3179,7 +4826,11 @@ MQTTStatus_t MQTT_Publish( MQTTContext_t * pContext,
                                               pPublishInfo->qos,
                                               &publishStatus );
 
-            if( status != MQTTSuccess )
+            if( status == MQTTSuccess )
+            {
+                MQTT_TRACE( StateChange, pContext, MQTT_PACKET_TYPE_PUBLISH, packetId, 0U, publishStatus );
+            }
+            else
             {
                 LogError( ( "Update state for publish failed with status %s."
                             " However PUBLISH packet was sent to the broker."
@@ -3284,6 +4935,7 @@ MQTTStatus_t MQTT_Ping( MQTTContext_t * pContext )
             {
                 pContext->pingReqSendTimeMs = pContext->lastPacketTxTime;
                 pContext->waitingForPingResp = true;
+                MQTT_TRACE( PingSent, pContext, MQTT_PACKET_TYPE_PINGREQ, 0U, packetSize, status );
                 LogDebug( ( "Sent %ld bytes of PINGREQ packet.",
                             ( long int ) sendResult ) );
             }
@@ -3344,6 +4996,11 @@ MQTTStatus_t MQTT_Unsubscribe( MQTTContext_t * pContext,
                                                  remainingLength );
         }
 
+        if( status == MQTTSuccess )
+        {
+            clearTopicCache( pContext );
+        }
+
         MQTT_POST_STATE_UPDATE_HOOK( pContext );
     }
 
@@ -3404,6 +5061,7 @@ MQTTStatus_t MQTT_Disconnect( MQTTContext_t * pContext )
 
             /* Reset the index and clean the buffer on a successful disconnect. */
             pContext->index = 0;
+            pContext->pendingPacket.headerLength = 0U;
             ( void ) memset( pContext->networkBuffer.pBuffer, 0, pContext->networkBuffer.size );
 
             LogError( ( "MQTT Connection Disconnected Successfully" ) );
@@ -3586,6 +5244,37 @@ MQTTStatus_t MQTT_MatchTopic( const char * pTopicName,
 
 /*-----------------------------------------------------------*/
 
+MQTTStatus_t MQTT_ValidateTopicName( const char * pTopicName,
+                                     uint16_t topicNameLength )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint16_t invalidIndex;
+
+    if( ( pTopicName == NULL ) || ( topicNameLength == 0U ) )
+    {
+        LogError( ( "Invalid parameter: Topic name should be non-NULL and its "
+                    "length should be > 0: TopicName=%p, TopicNameLength=%hu",
+                    ( const void * ) pTopicName,
+                    ( unsigned short ) topicNameLength ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        invalidIndex = findInvalidTopicNameByte( pTopicName, topicNameLength );
+
+        if( invalidIndex < topicNameLength )
+        {
+            LogError( ( "Topic name has a wildcard or null character at index %hu.",
+                        ( unsigned short ) invalidIndex ) );
+            status = MQTTBadParameter;
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
 MQTTStatus_t MQTT_GetSubAckStatusCodes( const MQTTPacketInfo_t * pSubackPacket,
                                         uint8_t ** pPayloadStart,
                                         size_t * pPayloadSize )
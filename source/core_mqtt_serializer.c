@@ -2710,3 +2710,172 @@ MQTTStatus_t MQTT_ProcessIncomingPacketTypeAndLength( const uint8_t * pBuffer,
 }
 
 /*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_GetIncomingPacketTypeAndLengthBuffered( TransportRecv_t readFunc,
+                                                          NetworkContext_t * pNetworkContext,
+                                                          const MQTTFixedBuffer_t * pFixedBuffer,
+                                                          size_t * pIndex,
+                                                          MQTTPacketInfo_t * pIncomingPacket )
+{
+    MQTTStatus_t status = MQTTNoDataAvailable;
+    int32_t bytesReceived = 0;
+
+    if( ( readFunc == NULL ) || ( pIncomingPacket == NULL ) || ( pIndex == NULL ) )
+    {
+        LogError( ( "Invalid parameter: readFunc, pIncomingPacket or pIndex is NULL." ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pFixedBuffer == NULL ) || ( pFixedBuffer->pBuffer == NULL ) )
+    {
+        LogError( ( "Invalid parameter: pFixedBuffer or its buffer is NULL." ) );
+        status = MQTTBadParameter;
+    }
+    else if( *pIndex > pFixedBuffer->size )
+    {
+        LogError( ( "Invalid parameter: Index %lu exceeds buffer size %lu.",
+                    ( unsigned long ) *pIndex,
+                    ( unsigned long ) pFixedBuffer->size ) );
+        status = MQTTBadParameter;
+    }
+    else if( *pIndex > 0U )
+    {
+        /* Data left over from an earlier read may already hold the header. */
+        status = MQTT_ProcessIncomingPacketTypeAndLength( pFixedBuffer->pBuffer,
+                                                          pIndex,
+                                                          pIncomingPacket );
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    if( ( ( status == MQTTNoDataAvailable ) || ( status == MQTTNeedMoreBytes ) ) &&
+        ( *pIndex < pFixedBuffer->size ) )
+    {
+        /* Read whatever is available in a single call. */
+        bytesReceived = readFunc( pNetworkContext,
+                                  &( pFixedBuffer->pBuffer[ *pIndex ] ),
+                                  pFixedBuffer->size - *pIndex );
+
+        if( bytesReceived < 0 )
+        {
+            LogError( ( "Transport receive failed while reading packet header: "
+                        "transportStatus=%ld.",
+                        ( long int ) bytesReceived ) );
+            status = MQTTRecvFailed;
+        }
+        else if( bytesReceived > 0 )
+        {
+            /* It is a bug in the application's transport receive implementation
+             * if more bytes than requested are received. */
+            assert( ( size_t ) bytesReceived <= ( pFixedBuffer->size - *pIndex ) );
+
+            *pIndex += ( size_t ) bytesReceived;
+
+            status = MQTT_ProcessIncomingPacketTypeAndLength( pFixedBuffer->pBuffer,
+                                                              pIndex,
+                                                              pIncomingPacket );
+        }
+        else
+        {
+            /* Nothing was read; keep the status from the buffered data. */
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_FramePackets( uint8_t * pBuffer,
+                                size_t bufferLength,
+                                MQTTPacketInfo_t * pPackets,
+                                size_t maxPackets,
+                                size_t * pPacketCount,
+                                size_t * pBytesConsumed )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    size_t offset = 0U, packetCount = 0U, bytesAvailable = 0U, packetSize = 0U;
+    MQTTPacketInfo_t * pPacket = NULL;
+    bool framing = true;
+
+    if( ( pPackets == NULL ) || ( pPacketCount == NULL ) || ( pBytesConsumed == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL: pPackets=%p, "
+                    "pPacketCount=%p, pBytesConsumed=%p.",
+                    ( void * ) pPackets,
+                    ( void * ) pPacketCount,
+                    ( void * ) pBytesConsumed ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pBuffer == NULL ) && ( bufferLength > 0U ) )
+    {
+        LogError( ( "pBuffer cannot be NULL when bufferLength is not zero." ) );
+        status = MQTTBadParameter;
+    }
+    else if( maxPackets == 0U )
+    {
+        LogError( ( "maxPackets cannot be 0." ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        while( ( framing == true ) && ( packetCount < maxPackets ) && ( offset < bufferLength ) )
+        {
+            pPacket = &( pPackets[ packetCount ] );
+            pPacket->type = pBuffer[ offset ];
+            bytesAvailable = bufferLength - offset;
+
+            if( incomingPacketValid( pPacket->type ) == false )
+            {
+                LogError( ( "Invalid packet at offset %lu: Packet type=%u.",
+                            ( unsigned long ) offset,
+                            ( unsigned int ) pPacket->type ) );
+                status = MQTTBadResponse;
+                framing = false;
+            }
+            else
+            {
+                status = processRemainingLength( &( pBuffer[ offset ] ),
+                                                 &bytesAvailable,
+                                                 pPacket );
+
+                if( status == MQTTSuccess )
+                {
+                    packetSize = pPacket->headerLength + pPacket->remainingLength;
+
+                    if( packetSize > bytesAvailable )
+                    {
+                        /* The body of the packet has not been received yet. */
+                        framing = false;
+                    }
+                    else
+                    {
+                        pPacket->pRemainingData = &( pBuffer[ offset + pPacket->headerLength ] );
+                        offset += packetSize;
+                        packetCount++;
+                    }
+                }
+                else if( status == MQTTNeedMoreBytes )
+                {
+                    /* The fixed header of the packet is incomplete. */
+                    status = MQTTSuccess;
+                    framing = false;
+                }
+                else
+                {
+                    LogError( ( "Invalid remaining length at offset %lu.",
+                                ( unsigned long ) offset ) );
+                    framing = false;
+                }
+            }
+        }
+
+        *pPacketCount = packetCount;
+        *pBytesConsumed = offset;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
@@ -229,6 +229,48 @@ static MQTTStatus_t updateStatePublish( const MQTTContext_t * pMqttContext,
                                         MQTTPublishState_t currentState,
                                         MQTTPublishState_t newState );
 
+#if ( MQTT_METRICS_ENABLED == 1 )
+
+/**
+ * @brief Find the bucket of an #MQTTLatencyHistogram_t in which a latency is
+ * counted.
+ *
+ * @param[in] latencyMs The latency.
+ *
+ * @return Index of the bucket.
+ */
+    static size_t latencyBucket( uint32_t latencyMs );
+
+/**
+ * @brief Get the longest latency counted in a bucket of an
+ * #MQTTLatencyHistogram_t.
+ *
+ * @param[in] bucket Index of the bucket, below the last one.
+ *
+ * @return The longest latency of the bucket.
+ */
+    static uint32_t latencyBucketMaxMs( size_t bucket );
+
+/**
+ * @brief Stamp or record the latencies of an outgoing publish after its state
+ * was updated for an acknowledgment.
+ *
+ * @param[in] pMqttContext Context initialized with #MQTT_InitAckLatency.
+ * @param[in] packetId Packet ID of the publish.
+ * @param[in] qos QoS of the publish.
+ * @param[in] newState New state of the publish.
+ * @param[in] sendTimeMs When the PUBLISH was sent.
+ * @param[in] pubRecTimeMs When the PUBREC was received, for QoS 2.
+ */
+    static void recordAckLatency( const MQTTContext_t * pMqttContext,
+                                  uint16_t packetId,
+                                  MQTTQoS_t qos,
+                                  MQTTPublishState_t newState,
+                                  uint32_t sendTimeMs,
+                                  uint32_t pubRecTimeMs );
+
+#endif /* if ( MQTT_METRICS_ENABLED == 1 ) */
+
 /*-----------------------------------------------------------*/
 
 static bool validateTransitionPublish( MQTTPublishState_t currentState,
@@ -496,11 +538,15 @@ static void compactRecords( MQTTPubAckInfo_t * records,
                 records[ emptyIndex ].packetId = records[ index ].packetId;
                 records[ emptyIndex ].qos = records[ index ].qos;
                 records[ emptyIndex ].publishState = records[ index ].publishState;
+                records[ emptyIndex ].sendTimeMs = records[ index ].sendTimeMs;
+                records[ emptyIndex ].pubRecTimeMs = records[ index ].pubRecTimeMs;
 
                 /* Mark the record at current non empty index as invalid. */
                 records[ index ].packetId = MQTT_PACKET_ID_INVALID;
                 records[ index ].qos = MQTTQoS0;
                 records[ index ].publishState = MQTTStateNull;
+                records[ index ].sendTimeMs = 0U;
+                records[ index ].pubRecTimeMs = 0U;
 
                 /* Advance the emptyIndex. */
                 emptyIndex++;
@@ -570,6 +616,8 @@ static MQTTStatus_t addRecord( MQTTPubAckInfo_t * records,
         records[ availableIndex ].packetId = packetId;
         records[ availableIndex ].qos = qos;
         records[ availableIndex ].publishState = publishState;
+        records[ availableIndex ].sendTimeMs = 0U;
+        records[ availableIndex ].pubRecTimeMs = 0U;
         status = MQTTSuccess;
     }
 
@@ -591,6 +639,8 @@ static void updateRecord( MQTTPubAckInfo_t * records,
         records[ recordIndex ].packetId = MQTT_PACKET_ID_INVALID;
         records[ recordIndex ].qos = MQTTQoS0;
         records[ recordIndex ].publishState = MQTTStateNull;
+        records[ recordIndex ].sendTimeMs = 0U;
+        records[ recordIndex ].pubRecTimeMs = 0U;
     }
     else
     {
@@ -801,6 +851,14 @@ static MQTTStatus_t updateStatePublish( const MQTTContext_t * pMqttContext,
                               newState,
                               false );
             }
+
+            #if ( MQTT_METRICS_ENABLED == 1 )
+                /* A resent publish is measured from the resend. */
+                if( pMqttContext->pAckLatency != NULL )
+                {
+                    pMqttContext->outgoingPublishRecords[ recordIndex ].sendTimeMs = pMqttContext->getTime();
+                }
+            #endif
         }
     }
     else
@@ -814,6 +872,98 @@ static MQTTStatus_t updateStatePublish( const MQTTContext_t * pMqttContext,
     return status;
 }
 
+#if ( MQTT_METRICS_ENABLED == 1 )
+
+    static size_t latencyBucket( uint32_t latencyMs )
+    {
+        uint32_t mantissa = latencyMs;
+        size_t shift = 0U;
+        size_t bucket = 0U;
+
+        /* Keep the 4 most significant bits of the latency. Latencies below
+         * 16 ms are kept whole, and each power of 2 above is split into 8
+         * buckets by the 3 bits after the leading one. */
+        while( mantissa >= 16U )
+        {
+            mantissa >>= 1U;
+            shift++;
+        }
+
+        bucket = ( shift * 8U ) + ( size_t ) mantissa;
+
+        if( bucket >= MQTT_LATENCY_BUCKET_COUNT )
+        {
+            bucket = MQTT_LATENCY_BUCKET_COUNT - 1U;
+        }
+
+        return bucket;
+    }
+
+/*-----------------------------------------------------------*/
+
+    static uint32_t latencyBucketMaxMs( size_t bucket )
+    {
+        uint32_t maxMs = ( uint32_t ) bucket;
+        uint32_t shift = 0U;
+
+        assert( bucket < ( MQTT_LATENCY_BUCKET_COUNT - 1U ) );
+
+        if( bucket >= 16U )
+        {
+            shift = ( uint32_t ) ( bucket / 8U ) - 1U;
+            maxMs = ( ( ( uint32_t ) ( bucket % 8U ) + 9U ) << shift ) - 1U;
+        }
+
+        return maxMs;
+    }
+
+
+/*-----------------------------------------------------------*/
+
+    static void recordAckLatency( const MQTTContext_t * pMqttContext,
+                                  uint16_t packetId,
+                                  MQTTQoS_t qos,
+                                  MQTTPublishState_t newState,
+                                  uint32_t sendTimeMs,
+                                  uint32_t pubRecTimeMs )
+    {
+        MQTTAckLatency_t * pAckLatency = pMqttContext->pAckLatency;
+        MQTTPubAckInfo_t * records = pMqttContext->outgoingPublishRecords;
+        uint32_t nowMs = pMqttContext->getTime();
+        size_t recordIndex = MQTT_INVALID_STATE_COUNT;
+        MQTTQoS_t foundQoS = MQTTQoS0;
+        MQTTPublishState_t foundState = MQTTStateNull;
+
+        if( newState == MQTTPubRelSend )
+        {
+            /* The PUBREC moved the record to the end of the records. */
+            recordIndex = findInRecord( records,
+                                        pMqttContext->outgoingPublishRecordMaxCount,
+                                        packetId,
+                                        &foundQoS,
+                                        &foundState );
+            assert( recordIndex != MQTT_INVALID_STATE_COUNT );
+
+            records[ recordIndex ].sendTimeMs = sendTimeMs;
+            records[ recordIndex ].pubRecTimeMs = nowMs;
+        }
+        else if( ( newState == MQTTPublishDone ) && ( qos == MQTTQoS1 ) )
+        {
+            MQTT_RecordLatency( &pAckLatency->pubAck, nowMs - sendTimeMs );
+        }
+        else if( newState == MQTTPublishDone )
+        {
+            MQTT_RecordLatency( &pAckLatency->pubComp, nowMs - sendTimeMs );
+            MQTT_RecordLatency( &pAckLatency->pubRecToPubComp, nowMs - pubRecTimeMs );
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+    }
+
+#endif /* if ( MQTT_METRICS_ENABLED == 1 ) */
+
 /*-----------------------------------------------------------*/
 
 MQTTStatus_t MQTT_ReserveState( const MQTTContext_t * pMqttContext,
@@ -1012,6 +1162,11 @@ MQTTStatus_t MQTT_UpdateStateAck( const MQTTContext_t * pMqttContext,
     MQTTPubAckInfo_t * records = NULL;
     MQTTStatus_t status = MQTTBadResponse;
 
+    #if ( MQTT_METRICS_ENABLED == 1 )
+        uint32_t sendTimeMs = 0U;
+        uint32_t pubRecTimeMs = 0U;
+    #endif
+
     if( ( pMqttContext == NULL ) || ( pNewState == NULL ) )
     {
         LogError( ( "Argument cannot be NULL: pMqttContext=%p, pNewState=%p.",
@@ -1053,6 +1208,12 @@ MQTTStatus_t MQTT_UpdateStateAck( const MQTTContext_t * pMqttContext,
     {
         newState = MQTT_CalculateStateAck( packetType, opType, qos );
 
+        #if ( MQTT_METRICS_ENABLED == 1 )
+            /* Read the stamps before the update clears or moves the record. */
+            sendTimeMs = records[ recordIndex ].sendTimeMs;
+            pubRecTimeMs = records[ recordIndex ].pubRecTimeMs;
+        #endif
+
         /* Validate state transition and update state record. */
         status = updateStateAck( records,
                                  maxRecordCount,
@@ -1065,6 +1226,20 @@ MQTTStatus_t MQTT_UpdateStateAck( const MQTTContext_t * pMqttContext,
         if( status == MQTTSuccess )
         {
             *pNewState = newState;
+
+            #if ( MQTT_METRICS_ENABLED == 1 )
+                if( ( pMqttContext->pAckLatency != NULL ) &&
+                    ( isOutgoingPublish == true ) &&
+                    ( currentState != newState ) )
+                {
+                    recordAckLatency( pMqttContext,
+                                      packetId,
+                                      qos,
+                                      newState,
+                                      sendTimeMs,
+                                      pubRecTimeMs );
+                }
+            #endif
         }
     }
     else
@@ -1204,3 +1379,86 @@ const char * MQTT_State_strerror( MQTTPublishState_t state )
 }
 
 /*-----------------------------------------------------------*/
+
+#if ( MQTT_METRICS_ENABLED == 1 )
+
+    void MQTT_RecordLatency( MQTTLatencyHistogram_t * pHistogram,
+                             uint32_t latencyMs )
+    {
+        assert( pHistogram != NULL );
+
+        pHistogram->buckets[ latencyBucket( latencyMs ) ]++;
+        pHistogram->count++;
+        pHistogram->totalMs += latencyMs;
+
+        if( latencyMs > pHistogram->maxMs )
+        {
+            pHistogram->maxMs = latencyMs;
+        }
+    }
+
+/*-----------------------------------------------------------*/
+
+    MQTTStatus_t MQTT_GetLatencyPercentile( const MQTTLatencyHistogram_t * pHistogram,
+                                            uint32_t perMille,
+                                            uint32_t * pLatencyMs )
+    {
+        MQTTStatus_t status = MQTTSuccess;
+        uint64_t rank = 0U;
+        uint64_t counted = 0U;
+        size_t bucket = 0U;
+
+        if( ( pHistogram == NULL ) || ( pLatencyMs == NULL ) )
+        {
+            LogError( ( "Argument cannot be NULL: pHistogram=%p, pLatencyMs=%p",
+                        ( const void * ) pHistogram,
+                        ( void * ) pLatencyMs ) );
+            status = MQTTBadParameter;
+        }
+        else if( perMille > 1000U )
+        {
+            LogError( ( "Percentile must be at most 1000 per mille, got %u.",
+                        ( unsigned int ) perMille ) );
+            status = MQTTBadParameter;
+        }
+        else if( pHistogram->count == 0U )
+        {
+            status = MQTTNoDataAvailable;
+        }
+        else
+        {
+            /* Rank of the latency among those recorded, rounded up. */
+            rank = ( ( ( uint64_t ) pHistogram->count * perMille ) + 999U ) / 1000U;
+
+            if( rank == 0U )
+            {
+                rank = 1U;
+            }
+
+            for( bucket = 0U; bucket < ( MQTT_LATENCY_BUCKET_COUNT - 1U ); bucket++ )
+            {
+                counted += pHistogram->buckets[ bucket ];
+
+                if( counted >= rank )
+                {
+                    break;
+                }
+            }
+
+            /* Report the longest latency of the bucket, but never more than
+             * the longest recorded. The last bucket has no bound. */
+            *pLatencyMs = pHistogram->maxMs;
+
+            if( ( bucket < ( MQTT_LATENCY_BUCKET_COUNT - 1U ) ) &&
+                ( latencyBucketMaxMs( bucket ) < pHistogram->maxMs ) )
+            {
+                *pLatencyMs = latencyBucketMaxMs( bucket );
+            }
+        }
+
+        return status;
+    }
+
+#endif /* if ( MQTT_METRICS_ENABLED == 1 ) */
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,1101 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_subscription.c
+ * @brief Implements the functions in core_mqtt_subscription.h.
+ */
+#include <string.h>
+#include <assert.h>
+
+#include "core_mqtt_subscription.h"
+
+/* Include config defaults header to get default values of configs. */
+#include "core_mqtt_config_defaults.h"
+
+/**
+ * @brief Index of the root node of a subscription trie.
+ */
+#define ROOT_NODE                 ( 0U )
+
+/**
+ * @brief Offset basis of the 32 bit FNV-1a hash used for topic levels.
+ */
+#define FNV_OFFSET_BASIS          ( 2166136261U )
+
+/**
+ * @brief Prime of the 32 bit FNV-1a hash used for topic levels.
+ */
+#define FNV_PRIME                 ( 16777619U )
+
+/**
+ * @brief Multiplier used to mix the parent node index into the hash of a level.
+ */
+#define PARENT_HASH_MULTIPLIER    ( 2654435761U )
+
+/**
+ * @brief Number of entries in the stack used by #MQTT_SubscriptionMatch.
+ *
+ * Each node taken from the stack adds at most two children one level deeper,
+ * so the stack holds at most one entry per level plus one.
+ */
+#define MATCH_STACK_SIZE          ( MQTT_SUBSCRIPTION_LEVELS_MAX + 1U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A partial match of a topic name, kept on the stack of
+ * #MQTT_SubscriptionMatch.
+ */
+typedef struct MatchState
+{
+    uint32_t node;     /**< @brief Node matching the levels before levelStart. */
+    size_t levelStart; /**< @brief Start of the next topic name level, or past the end of the topic name if all levels have been matched. */
+} MatchState_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Hash a topic level together with the index of its parent node.
+ *
+ * @param[in] parent Index of the parent node.
+ * @param[in] pLevel The level.
+ * @param[in] levelLength Length of the level.
+ *
+ * @return The hash of the level.
+ */
+static uint32_t hashLevel( uint32_t parent,
+                           const char * pLevel,
+                           uint16_t levelLength );
+
+/**
+ * @brief Get the length of the topic level starting at an index.
+ *
+ * @param[in] pTopic Topic name or topic filter.
+ * @param[in] topicLength Length of the topic.
+ * @param[in] levelStart Index of the first character of the level.
+ *
+ * @return The number of characters before the next '/' or the end of the topic.
+ */
+static uint16_t getLevelLength( const char * pTopic,
+                                uint16_t topicLength,
+                                size_t levelStart );
+
+/**
+ * @brief Check that a topic filter level either has no wildcards, or is a
+ * single wildcard.
+ *
+ * @param[in] pLevel The level.
+ * @param[in] levelLength Length of the level.
+ *
+ * @return `true` if the level is valid; `false` otherwise.
+ */
+static bool isValidFilterLevel( const char * pLevel,
+                                uint16_t levelLength );
+
+/**
+ * @brief Find the child of a node for a level without wildcards.
+ *
+ * @param[in] pTrie The subscription trie.
+ * @param[in] parent Index of the parent node.
+ * @param[in] pLevel The level.
+ * @param[in] levelLength Length of the level.
+ *
+ * @return Index of the child, or #MQTT_SUBSCRIPTION_NONE if there is none.
+ */
+static uint32_t findLiteralChild( const MQTTSubscriptionTrie_t * pTrie,
+                                  uint32_t parent,
+                                  const char * pLevel,
+                                  uint16_t levelLength );
+
+/**
+ * @brief Take a node from the free list and link it as a child of a node.
+ *
+ * @param[in] pTrie The subscription trie.
+ * @param[in] parent Index of the parent node.
+ * @param[in] pLevel The level of the child.
+ * @param[in] levelLength Length of the level.
+ *
+ * @return Index of the child, or #MQTT_SUBSCRIPTION_NONE if no node is free.
+ */
+static uint32_t addChild( MQTTSubscriptionTrie_t * pTrie,
+                          uint32_t parent,
+                          const char * pLevel,
+                          uint16_t levelLength );
+
+/**
+ * @brief Free a node and its ancestors for as long as they have no children
+ * and no handlers.
+ *
+ * @param[in] pTrie The subscription trie.
+ * @param[in] nodeIndex Index of the node to start from.
+ */
+static void pruneNodes( MQTTSubscriptionTrie_t * pTrie,
+                        uint32_t nodeIndex );
+
+/**
+ * @brief Walk a topic filter down the trie to the node of its last level.
+ *
+ * @param[in] pTrie The subscription trie.
+ * @param[in] pTopicFilter The topic filter.
+ * @param[in] topicFilterLength Length of the topic filter.
+ * @param[in] addNodes Whether to add the nodes missing for the filter.
+ * @param[out] pNodeIndex The last node reached, even on failure.
+ * @param[out] pMultiLevel Whether the filter ends with a '#' level.
+ *
+ * @return #MQTTBadParameter if the topic filter is invalid or, when not
+ * adding nodes, is not in the trie; #MQTTNoMemory if no node is free;
+ * #MQTTSuccess otherwise.
+ */
+static MQTTStatus_t walkTopicFilter( MQTTSubscriptionTrie_t * pTrie,
+                                     const char * pTopicFilter,
+                                     uint16_t topicFilterLength,
+                                     bool addNodes,
+                                     uint32_t * pNodeIndex,
+                                     bool * pMultiLevel );
+
+/**
+ * @brief Add a handler ID to the output of #MQTT_SubscriptionMatch.
+ *
+ * @param[in] handlerId The handler ID, which is ignored if it is
+ * #MQTT_SUBSCRIPTION_NONE.
+ * @param[out] pHandlerIds Array of matched handler IDs.
+ * @param[in] handlerIdCount Number of entries in @p pHandlerIds.
+ * @param[in,out] pMatchCount Number of handler IDs in @p pHandlerIds.
+ *
+ * @return #MQTTNoMemory if @p pHandlerIds is full; #MQTTSuccess otherwise.
+ */
+static MQTTStatus_t addMatch( uint32_t handlerId,
+                              uint32_t * pHandlerIds,
+                              size_t handlerIdCount,
+                              size_t * pMatchCount );
+
+
+/**
+ * @brief Match the topic name levels after the literal prefix of a compiled
+ * topic filter against the remaining levels of the filter.
+ *
+ * @param[in] pTopicName The topic name.
+ * @param[in] topicNameLength Length of the topic name.
+ * @param[in] levelStart Start of the first topic name level after the prefix,
+ * or past the end of the topic name if the prefix matched all levels.
+ * @param[in] pCompiledFilter The compiled topic filter.
+ *
+ * @return `true` if the levels match; `false` otherwise.
+ */
+static bool matchCompiledLevels( const char * pTopicName,
+                                 uint16_t topicNameLength,
+                                 size_t levelStart,
+                                 const MQTTCompiledFilter_t * pCompiledFilter );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t hashLevel( uint32_t parent,
+                           const char * pLevel,
+                           uint16_t levelLength )
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    uint16_t i;
+
+    assert( ( pLevel != NULL ) || ( levelLength == 0U ) );
+
+    for( i = 0U; i < levelLength; i++ )
+    {
+        hash ^= ( uint32_t ) ( ( uint8_t ) pLevel[ i ] );
+        hash *= FNV_PRIME;
+    }
+
+    return hash ^ ( parent * PARENT_HASH_MULTIPLIER );
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t getLevelLength( const char * pTopic,
+                                uint16_t topicLength,
+                                size_t levelStart )
+{
+    size_t levelEnd = levelStart;
+
+    assert( pTopic != NULL );
+    assert( levelStart <= topicLength );
+
+    while( ( levelEnd < topicLength ) && ( pTopic[ levelEnd ] != '/' ) )
+    {
+        levelEnd++;
+    }
+
+    return ( uint16_t ) ( levelEnd - levelStart );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool isValidFilterLevel( const char * pLevel,
+                                uint16_t levelLength )
+{
+    bool isValid = true;
+    uint16_t i;
+
+    assert( ( pLevel != NULL ) || ( levelLength == 0U ) );
+
+    /* A wildcard must occupy an entire level. */
+    if( levelLength > 1U )
+    {
+        for( i = 0U; ( i < levelLength ) && ( isValid == true ); i++ )
+        {
+            isValid = ( pLevel[ i ] != '+' ) && ( pLevel[ i ] != '#' );
+        }
+    }
+
+    return isValid;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t findLiteralChild( const MQTTSubscriptionTrie_t * pTrie,
+                                  uint32_t parent,
+                                  const char * pLevel,
+                                  uint16_t levelLength )
+{
+    uint32_t hash;
+    uint32_t index = MQTT_SUBSCRIPTION_NONE;
+    const MQTTSubscriptionNode_t * pNode = NULL;
+    bool found = false;
+
+    assert( pTrie != NULL );
+
+    /* No node can hold a level longer than the maximum. */
+    if( levelLength <= pTrie->levelLengthMax )
+    {
+        hash = hashLevel( parent, pLevel, levelLength );
+        index = pTrie->pBuckets[ ( size_t ) hash % pTrie->bucketCount ];
+
+        while( ( index != MQTT_SUBSCRIPTION_NONE ) && ( found == false ) )
+        {
+            pNode = &( pTrie->pNodes[ index ] );
+
+            if( ( pNode->hash == hash ) &&
+                ( pNode->parent == parent ) &&
+                ( pNode->levelLength == levelLength ) &&
+                ( memcmp( &( pTrie->pLevels[ ( size_t ) index * pTrie->levelLengthMax ] ),
+                          pLevel,
+                          levelLength ) == 0 ) )
+            {
+                found = true;
+            }
+            else
+            {
+                index = pNode->next;
+            }
+        }
+    }
+
+    return index;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t addChild( MQTTSubscriptionTrie_t * pTrie,
+                          uint32_t parent,
+                          const char * pLevel,
+                          uint16_t levelLength )
+{
+    uint32_t index;
+    size_t bucket;
+    MQTTSubscriptionNode_t * pNode = NULL;
+
+    assert( pTrie != NULL );
+    assert( levelLength <= pTrie->levelLengthMax );
+
+    index = pTrie->freeNode;
+
+    if( index != MQTT_SUBSCRIPTION_NONE )
+    {
+        pNode = &( pTrie->pNodes[ index ] );
+        pTrie->freeNode = pNode->next;
+
+        pNode->hash = hashLevel( parent, pLevel, levelLength );
+        pNode->parent = parent;
+        pNode->plusChild = MQTT_SUBSCRIPTION_NONE;
+        pNode->childCount = 0U;
+        pNode->handlerId = MQTT_SUBSCRIPTION_NONE;
+        pNode->multiLevelHandlerId = MQTT_SUBSCRIPTION_NONE;
+        pNode->levelLength = levelLength;
+        ( void ) memcpy( &( pTrie->pLevels[ ( size_t ) index * pTrie->levelLengthMax ] ),
+                         pLevel,
+                         levelLength );
+
+        /* '+' children are linked directly from their parent, since they
+         * are checked for every topic name level. */
+        if( ( levelLength == 1U ) && ( pLevel[ 0 ] == '+' ) )
+        {
+            pNode->next = MQTT_SUBSCRIPTION_NONE;
+            pTrie->pNodes[ parent ].plusChild = index;
+        }
+        else
+        {
+            bucket = ( size_t ) pNode->hash % pTrie->bucketCount;
+            pNode->next = pTrie->pBuckets[ bucket ];
+            pTrie->pBuckets[ bucket ] = index;
+        }
+
+        pTrie->pNodes[ parent ].childCount++;
+    }
+
+    return index;
+}
+
+/*-----------------------------------------------------------*/
+
+static void pruneNodes( MQTTSubscriptionTrie_t * pTrie,
+                        uint32_t nodeIndex )
+{
+    uint32_t index = nodeIndex;
+    uint32_t parent;
+    uint32_t * pLink = NULL;
+    MQTTSubscriptionNode_t * pNode = NULL;
+
+    assert( pTrie != NULL );
+
+    pNode = &( pTrie->pNodes[ index ] );
+
+    while( ( index != ROOT_NODE ) &&
+           ( pNode->childCount == 0U ) &&
+           ( pNode->handlerId == MQTT_SUBSCRIPTION_NONE ) &&
+           ( pNode->multiLevelHandlerId == MQTT_SUBSCRIPTION_NONE ) )
+    {
+        parent = pNode->parent;
+
+        if( pTrie->pNodes[ parent ].plusChild == index )
+        {
+            pTrie->pNodes[ parent ].plusChild = MQTT_SUBSCRIPTION_NONE;
+        }
+        else
+        {
+            /* Unlink the node from its hash bucket. */
+            pLink = &( pTrie->pBuckets[ ( size_t ) pNode->hash % pTrie->bucketCount ] );
+
+            while( *pLink != index )
+            {
+                assert( *pLink != MQTT_SUBSCRIPTION_NONE );
+                pLink = &( pTrie->pNodes[ *pLink ].next );
+            }
+
+            *pLink = pNode->next;
+        }
+
+        pTrie->pNodes[ parent ].childCount--;
+
+        pNode->next = pTrie->freeNode;
+        pTrie->freeNode = index;
+
+        index = parent;
+        pNode = &( pTrie->pNodes[ index ] );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static MQTTStatus_t walkTopicFilter( MQTTSubscriptionTrie_t * pTrie,
+                                     const char * pTopicFilter,
+                                     uint16_t topicFilterLength,
+                                     bool addNodes,
+                                     uint32_t * pNodeIndex,
+                                     bool * pMultiLevel )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t node = ROOT_NODE;
+    uint32_t child;
+    size_t levelStart = 0U;
+    uint16_t levelLength;
+    uint16_t levelCount = 0U;
+    const char * pLevel;
+    bool lastLevel = false;
+    bool multiLevel = false;
+
+    assert( pTrie != NULL );
+    assert( pTopicFilter != NULL );
+    assert( pNodeIndex != NULL );
+    assert( pMultiLevel != NULL );
+
+    while( ( status == MQTTSuccess ) && ( lastLevel == false ) )
+    {
+        levelLength = getLevelLength( pTopicFilter, topicFilterLength, levelStart );
+        pLevel = &( pTopicFilter[ levelStart ] );
+        lastLevel = ( levelStart + levelLength ) == topicFilterLength;
+
+        if( ( levelLength == 1U ) && ( pLevel[ 0 ] == '#' ) )
+        {
+            if( lastLevel == true )
+            {
+                multiLevel = true;
+            }
+            else
+            {
+                LogError( ( "'#' must be the last level of a topic filter." ) );
+                status = MQTTBadParameter;
+            }
+        }
+        else if( isValidFilterLevel( pLevel, levelLength ) == false )
+        {
+            LogError( ( "Wildcards must occupy an entire topic filter level." ) );
+            status = MQTTBadParameter;
+        }
+        else if( levelCount == MQTT_SUBSCRIPTION_LEVELS_MAX )
+        {
+            LogError( ( "Topic filter has more than %u levels.",
+                        ( unsigned int ) MQTT_SUBSCRIPTION_LEVELS_MAX ) );
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            if( ( levelLength == 1U ) && ( pLevel[ 0 ] == '+' ) )
+            {
+                child = pTrie->pNodes[ node ].plusChild;
+            }
+            else
+            {
+                child = findLiteralChild( pTrie, node, pLevel, levelLength );
+            }
+
+            if( child != MQTT_SUBSCRIPTION_NONE )
+            {
+                /* Empty else MISRA 15.7 */
+            }
+            else if( addNodes == false )
+            {
+                LogError( ( "Topic filter is not in the subscription trie." ) );
+                status = MQTTBadParameter;
+            }
+            else if( levelLength > pTrie->levelLengthMax )
+            {
+                LogError( ( "Topic filter level is longer than %lu characters.",
+                            ( unsigned long ) pTrie->levelLengthMax ) );
+                status = MQTTBadParameter;
+            }
+            else
+            {
+                child = addChild( pTrie, node, pLevel, levelLength );
+
+                if( child == MQTT_SUBSCRIPTION_NONE )
+                {
+                    LogError( ( "No free node in the subscription trie." ) );
+                    status = MQTTNoMemory;
+                }
+            }
+
+            if( status == MQTTSuccess )
+            {
+                node = child;
+                levelCount++;
+                levelStart += ( size_t ) levelLength + 1U;
+            }
+        }
+    }
+
+    *pNodeIndex = node;
+    *pMultiLevel = multiLevel;
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static MQTTStatus_t addMatch( uint32_t handlerId,
+                              uint32_t * pHandlerIds,
+                              size_t handlerIdCount,
+                              size_t * pMatchCount )
+{
+    MQTTStatus_t status = MQTTSuccess;
+
+    assert( pHandlerIds != NULL );
+    assert( pMatchCount != NULL );
+
+    if( handlerId == MQTT_SUBSCRIPTION_NONE )
+    {
+        /* Empty else MISRA 15.7 */
+    }
+    else if( *pMatchCount < handlerIdCount )
+    {
+        pHandlerIds[ *pMatchCount ] = handlerId;
+        ( *pMatchCount )++;
+    }
+    else
+    {
+        LogError( ( "More than %lu topic filters match the topic name.",
+                    ( unsigned long ) handlerIdCount ) );
+        status = MQTTNoMemory;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool matchCompiledLevels( const char * pTopicName,
+                                 uint16_t topicNameLength,
+                                 size_t levelStart,
+                                 const MQTTCompiledFilter_t * pCompiledFilter )
+{
+    const MQTTFilterLevel_t * pLevel;
+    size_t topicLevelStart = levelStart;
+    uint16_t topicLevelLength;
+    uint16_t levelIndex;
+    bool isMatch = true;
+    bool multiLevel = false;
+
+    assert( pTopicName != NULL );
+    assert( pCompiledFilter != NULL );
+
+    for( levelIndex = pCompiledFilter->prefixLevelCount;
+         ( levelIndex < pCompiledFilter->levelCount ) && ( isMatch == true ) && ( multiLevel == false );
+         levelIndex++ )
+    {
+        pLevel = &( pCompiledFilter->pLevels[ levelIndex ] );
+
+        if( pLevel->kind == MQTTFilterLevelMulti )
+        {
+            /* '#' matches the remaining levels, and also the level before it
+             * when the topic name has no levels left. */
+            multiLevel = true;
+        }
+        else if( topicLevelStart > topicNameLength )
+        {
+            isMatch = false;
+        }
+        else
+        {
+            topicLevelLength = getLevelLength( pTopicName, topicNameLength, topicLevelStart );
+
+            if( pLevel->kind == MQTTFilterLevelLiteral )
+            {
+                isMatch = ( topicLevelLength == pLevel->length ) &&
+                          ( memcmp( &( pTopicName[ topicLevelStart ] ),
+                                    &( pCompiledFilter->pTopicFilter[ pLevel->offset ] ),
+                                    topicLevelLength ) == 0 );
+            }
+
+            topicLevelStart += ( size_t ) topicLevelLength + 1U;
+        }
+    }
+
+    /* Without a '#' level, the filter must use all levels of the topic name. */
+    if( ( isMatch == true ) && ( multiLevel == false ) )
+    {
+        isMatch = ( topicLevelStart > topicNameLength );
+    }
+
+    return isMatch;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_SubscriptionInit( MQTTSubscriptionTrie_t * pTrie,
+                                    MQTTSubscriptionNode_t * pNodes,
+                                    char * pLevelBuffer,
+                                    size_t nodeCount,
+                                    size_t levelLengthMax,
+                                    uint32_t * pBuckets,
+                                    size_t bucketCount )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    size_t i;
+
+    if( ( pTrie == NULL ) || ( pNodes == NULL ) ||
+        ( pLevelBuffer == NULL ) || ( pBuckets == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTrie=%p, pNodes=%p, "
+                    "pLevelBuffer=%p, pBuckets=%p",
+                    ( void * ) pTrie,
+                    ( void * ) pNodes,
+                    ( void * ) pLevelBuffer,
+                    ( void * ) pBuckets ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( nodeCount == 0U ) || ( nodeCount >= ( size_t ) MQTT_SUBSCRIPTION_NONE ) )
+    {
+        LogError( ( "Invalid parameter: nodeCount=%lu",
+                    ( unsigned long ) nodeCount ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( levelLengthMax == 0U ) || ( levelLengthMax > UINT16_MAX ) ||
+             ( nodeCount > ( SIZE_MAX / levelLengthMax ) ) )
+    {
+        LogError( ( "Invalid parameter: levelLengthMax=%lu",
+                    ( unsigned long ) levelLengthMax ) );
+        status = MQTTBadParameter;
+    }
+    else if( bucketCount == 0U )
+    {
+        LogError( ( "Invalid parameter: bucketCount cannot be 0" ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        pTrie->pNodes = pNodes;
+        pTrie->pLevels = pLevelBuffer;
+        pTrie->nodeCount = nodeCount;
+        pTrie->levelLengthMax = levelLengthMax;
+        pTrie->pBuckets = pBuckets;
+        pTrie->bucketCount = bucketCount;
+        pTrie->filterCount = 0U;
+
+        /* Link all nodes but the root into the free list. */
+        for( i = 0U; i < nodeCount; i++ )
+        {
+            pNodes[ i ].next = ( ( i + 1U ) < nodeCount ) ? ( uint32_t ) ( i + 1U ) : MQTT_SUBSCRIPTION_NONE;
+        }
+
+        pTrie->freeNode = pNodes[ ROOT_NODE ].next;
+
+        pNodes[ ROOT_NODE ].hash = 0U;
+        pNodes[ ROOT_NODE ].parent = MQTT_SUBSCRIPTION_NONE;
+        pNodes[ ROOT_NODE ].next = MQTT_SUBSCRIPTION_NONE;
+        pNodes[ ROOT_NODE ].plusChild = MQTT_SUBSCRIPTION_NONE;
+        pNodes[ ROOT_NODE ].childCount = 0U;
+        pNodes[ ROOT_NODE ].handlerId = MQTT_SUBSCRIPTION_NONE;
+        pNodes[ ROOT_NODE ].multiLevelHandlerId = MQTT_SUBSCRIPTION_NONE;
+        pNodes[ ROOT_NODE ].levelLength = 0U;
+
+        for( i = 0U; i < bucketCount; i++ )
+        {
+            pBuckets[ i ] = MQTT_SUBSCRIPTION_NONE;
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_SubscriptionAdd( MQTTSubscriptionTrie_t * pTrie,
+                                   const char * pTopicFilter,
+                                   uint16_t topicFilterLength,
+                                   uint32_t handlerId )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t node = ROOT_NODE;
+    uint32_t * pHandlerId = NULL;
+    bool multiLevel = false;
+
+    if( ( pTrie == NULL ) || ( pTrie->pNodes == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL or uninitialized: pTrie=%p",
+                    ( void * ) pTrie ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pTopicFilter == NULL ) || ( topicFilterLength == 0U ) )
+    {
+        LogError( ( "Invalid parameter: Topic filter should be non-NULL and "
+                    "its length should be > 0: TopicFilter=%p, TopicFilterLength=%hu",
+                    ( void * ) pTopicFilter,
+                    ( unsigned short ) topicFilterLength ) );
+        status = MQTTBadParameter;
+    }
+    else if( handlerId == MQTT_SUBSCRIPTION_NONE )
+    {
+        LogError( ( "Invalid parameter: handlerId cannot be MQTT_SUBSCRIPTION_NONE" ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        status = walkTopicFilter( pTrie, pTopicFilter, topicFilterLength,
+                                  true, &node, &multiLevel );
+
+        if( status == MQTTSuccess )
+        {
+            pHandlerId = ( multiLevel == true ) ? &( pTrie->pNodes[ node ].multiLevelHandlerId ) :
+                         &( pTrie->pNodes[ node ].handlerId );
+
+            if( *pHandlerId == MQTT_SUBSCRIPTION_NONE )
+            {
+                pTrie->filterCount++;
+            }
+
+            *pHandlerId = handlerId;
+        }
+        else
+        {
+            /* Free the nodes added for the filter before the failure. */
+            pruneNodes( pTrie, node );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_SubscriptionRemove( MQTTSubscriptionTrie_t * pTrie,
+                                      const char * pTopicFilter,
+                                      uint16_t topicFilterLength )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint32_t node = ROOT_NODE;
+    uint32_t * pHandlerId = NULL;
+    bool multiLevel = false;
+
+    if( ( pTrie == NULL ) || ( pTrie->pNodes == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL or uninitialized: pTrie=%p",
+                    ( void * ) pTrie ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pTopicFilter == NULL ) || ( topicFilterLength == 0U ) )
+    {
+        LogError( ( "Invalid parameter: Topic filter should be non-NULL and "
+                    "its length should be > 0: TopicFilter=%p, TopicFilterLength=%hu",
+                    ( void * ) pTopicFilter,
+                    ( unsigned short ) topicFilterLength ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        status = walkTopicFilter( pTrie, pTopicFilter, topicFilterLength,
+                                  false, &node, &multiLevel );
+    }
+
+    if( status == MQTTSuccess )
+    {
+        pHandlerId = ( multiLevel == true ) ? &( pTrie->pNodes[ node ].multiLevelHandlerId ) :
+                     &( pTrie->pNodes[ node ].handlerId );
+
+        if( *pHandlerId == MQTT_SUBSCRIPTION_NONE )
+        {
+            LogError( ( "Topic filter is not in the subscription trie." ) );
+            status = MQTTBadParameter;
+        }
+        else
+        {
+            *pHandlerId = MQTT_SUBSCRIPTION_NONE;
+            pTrie->filterCount--;
+            pruneNodes( pTrie, node );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_SubscriptionMatch( const MQTTSubscriptionTrie_t * pTrie,
+                                     const char * pTopicName,
+                                     uint16_t topicNameLength,
+                                     uint32_t * pHandlerIds,
+                                     size_t handlerIdCount,
+                                     size_t * pMatchCount )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MatchState_t stack[ MATCH_STACK_SIZE ];
+    MatchState_t state;
+    size_t stackSize = 0U;
+    size_t matchCount = 0U;
+    size_t nextLevelStart;
+    uint16_t levelLength;
+    uint32_t child;
+    const MQTTSubscriptionNode_t * pNode = NULL;
+    bool isSystemTopic;
+    bool wildcardsMatch;
+
+    if( ( pTrie == NULL ) || ( pTrie->pNodes == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL or uninitialized: pTrie=%p",
+                    ( const void * ) pTrie ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pTopicName == NULL ) || ( topicNameLength == 0U ) )
+    {
+        LogError( ( "Invalid parameter: Topic name should be non-NULL and its "
+                    "length should be > 0: TopicName=%p, TopicNameLength=%hu",
+                    ( const void * ) pTopicName,
+                    ( unsigned short ) topicNameLength ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pHandlerIds == NULL ) || ( handlerIdCount == 0U ) || ( pMatchCount == NULL ) )
+    {
+        LogError( ( "Invalid parameter: pHandlerIds=%p, handlerIdCount=%lu, "
+                    "pMatchCount=%p",
+                    ( void * ) pHandlerIds,
+                    ( unsigned long ) handlerIdCount,
+                    ( void * ) pMatchCount ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        /* Topic names starting with '$' do not match filters starting with a
+         * wildcard, as in MQTT_MatchTopic. */
+        isSystemTopic = ( pTopicName[ 0 ] == '$' );
+
+        stack[ 0 ].node = ROOT_NODE;
+        stack[ 0 ].levelStart = 0U;
+        stackSize = 1U;
+
+        while( ( stackSize > 0U ) && ( status == MQTTSuccess ) )
+        {
+            stackSize--;
+            state = stack[ stackSize ];
+            pNode = &( pTrie->pNodes[ state.node ] );
+
+            if( state.levelStart > topicNameLength )
+            {
+                /* All levels matched. A filter ending with "/#" also matches
+                 * the level before the '#'. */
+                status = addMatch( pNode->handlerId, pHandlerIds,
+                                   handlerIdCount, &matchCount );
+
+                if( status == MQTTSuccess )
+                {
+                    status = addMatch( pNode->multiLevelHandlerId, pHandlerIds,
+                                       handlerIdCount, &matchCount );
+                }
+            }
+            else
+            {
+                wildcardsMatch = ( state.node != ROOT_NODE ) || ( isSystemTopic == false );
+                levelLength = getLevelLength( pTopicName, topicNameLength, state.levelStart );
+                nextLevelStart = state.levelStart + levelLength + 1U;
+
+                if( wildcardsMatch == true )
+                {
+                    /* '#' matches this and all remaining levels. */
+                    status = addMatch( pNode->multiLevelHandlerId, pHandlerIds,
+                                       handlerIdCount, &matchCount );
+                }
+
+                child = findLiteralChild( pTrie, state.node,
+                                          &( pTopicName[ state.levelStart ] ),
+                                          levelLength );
+
+                if( child != MQTT_SUBSCRIPTION_NONE )
+                {
+                    assert( stackSize < MATCH_STACK_SIZE );
+                    stack[ stackSize ].node = child;
+                    stack[ stackSize ].levelStart = nextLevelStart;
+                    stackSize++;
+                }
+
+                if( ( wildcardsMatch == true ) && ( pNode->plusChild != MQTT_SUBSCRIPTION_NONE ) )
+                {
+                    assert( stackSize < MATCH_STACK_SIZE );
+                    stack[ stackSize ].node = pNode->plusChild;
+                    stack[ stackSize ].levelStart = nextLevelStart;
+                    stackSize++;
+                }
+            }
+        }
+
+        *pMatchCount = matchCount;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_CompileTopicFilter( const char * pTopicFilter,
+                                      uint16_t topicFilterLength,
+                                      MQTTFilterLevel_t * pLevels,
+                                      size_t levelCountMax,
+                                      MQTTCompiledFilter_t * pCompiledFilter )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTFilterLevelKind_t kind;
+    size_t levelStart = 0U;
+    uint16_t levelLength;
+    uint16_t levelCount = 0U;
+    uint16_t prefixLevelCount = 0U;
+    const char * pLevel;
+    bool lastLevel = false;
+
+    if( ( pTopicFilter == NULL ) || ( topicFilterLength == 0U ) )
+    {
+        LogError( ( "Invalid parameter: Topic filter should be non-NULL and "
+                    "its length should be > 0: TopicFilter=%p, TopicFilterLength=%hu",
+                    ( const void * ) pTopicFilter,
+                    ( unsigned short ) topicFilterLength ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pLevels == NULL ) || ( levelCountMax == 0U ) || ( pCompiledFilter == NULL ) )
+    {
+        LogError( ( "Invalid parameter: pLevels=%p, levelCountMax=%lu, "
+                    "pCompiledFilter=%p",
+                    ( void * ) pLevels,
+                    ( unsigned long ) levelCountMax,
+                    ( void * ) pCompiledFilter ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        while( ( status == MQTTSuccess ) && ( lastLevel == false ) )
+        {
+            levelLength = getLevelLength( pTopicFilter, topicFilterLength, levelStart );
+            pLevel = &( pTopicFilter[ levelStart ] );
+            lastLevel = ( levelStart + levelLength ) == topicFilterLength;
+            kind = MQTTFilterLevelLiteral;
+
+            if( ( levelLength == 1U ) && ( pLevel[ 0 ] == '#' ) )
+            {
+                kind = MQTTFilterLevelMulti;
+
+                if( lastLevel == false )
+                {
+                    LogError( ( "'#' must be the last level of a topic filter." ) );
+                    status = MQTTBadParameter;
+                }
+            }
+            else if( ( levelLength == 1U ) && ( pLevel[ 0 ] == '+' ) )
+            {
+                kind = MQTTFilterLevelSingle;
+            }
+            else if( isValidFilterLevel( pLevel, levelLength ) == false )
+            {
+                LogError( ( "Wildcards must occupy an entire topic filter level." ) );
+                status = MQTTBadParameter;
+            }
+            else
+            {
+                /* Empty else MISRA 15.7 */
+            }
+
+            if( ( status == MQTTSuccess ) && ( levelCount == levelCountMax ) )
+            {
+                LogError( ( "Topic filter has more than %lu levels.",
+                            ( unsigned long ) levelCountMax ) );
+                status = MQTTBadParameter;
+            }
+
+            if( status == MQTTSuccess )
+            {
+                pLevels[ levelCount ].offset = ( uint16_t ) levelStart;
+                pLevels[ levelCount ].length = levelLength;
+                pLevels[ levelCount ].kind = kind;
+
+                /* The prefix ends at the first wildcard. */
+                if( ( kind == MQTTFilterLevelLiteral ) && ( prefixLevelCount == levelCount ) )
+                {
+                    prefixLevelCount++;
+                }
+
+                levelCount++;
+                levelStart += ( size_t ) levelLength + 1U;
+            }
+        }
+    }
+
+    if( status == MQTTSuccess )
+    {
+        pCompiledFilter->pTopicFilter = pTopicFilter;
+        pCompiledFilter->topicFilterLength = topicFilterLength;
+        pCompiledFilter->pLevels = pLevels;
+        pCompiledFilter->levelCount = levelCount;
+        pCompiledFilter->prefixLevelCount = prefixLevelCount;
+        pCompiledFilter->prefixLength = 0U;
+
+        if( prefixLevelCount > 0U )
+        {
+            pCompiledFilter->prefixLength = pLevels[ prefixLevelCount - 1U ].offset +
+                                            pLevels[ prefixLevelCount - 1U ].length;
+        }
+
+        pCompiledFilter->prefixHash = hashLevel( ROOT_NODE, pTopicFilter,
+                                                 pCompiledFilter->prefixLength );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+MQTTStatus_t MQTT_MatchCompiledFilter( const char * pTopicName,
+                                       uint16_t topicNameLength,
+                                       const MQTTCompiledFilter_t * pCompiledFilter,
+                                       bool * pIsMatch )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    uint16_t prefixLength;
+    size_t levelStart = 0U;
+    bool isMatch = true;
+
+    if( ( pTopicName == NULL ) || ( topicNameLength == 0U ) )
+    {
+        LogError( ( "Invalid parameter: Topic name should be non-NULL and its "
+                    "length should be > 0: TopicName=%p, TopicNameLength=%hu",
+                    ( const void * ) pTopicName,
+                    ( unsigned short ) topicNameLength ) );
+        status = MQTTBadParameter;
+    }
+    else if( ( pCompiledFilter == NULL ) || ( pCompiledFilter->pLevels == NULL ) )
+    {
+        LogError( ( "Argument cannot be NULL or uncompiled: pCompiledFilter=%p",
+                    ( const void * ) pCompiledFilter ) );
+        status = MQTTBadParameter;
+    }
+    else if( pIsMatch == NULL )
+    {
+        LogError( ( "Output parameter cannot be NULL: pIsMatch=%p",
+                    ( void * ) pIsMatch ) );
+        status = MQTTBadParameter;
+    }
+    else
+    {
+        prefixLength = pCompiledFilter->prefixLength;
+
+        if( pCompiledFilter->prefixLevelCount == 0U )
+        {
+            /* Topic names starting with '$' do not match filters starting
+             * with a wildcard, as in MQTT_MatchTopic. */
+            isMatch = ( pTopicName[ 0 ] != '$' );
+        }
+        else if( ( topicNameLength < prefixLength ) ||
+                 ( memcmp( pTopicName, pCompiledFilter->pTopicFilter, prefixLength ) != 0 ) )
+        {
+            isMatch = false;
+        }
+        else if( topicNameLength == prefixLength )
+        {
+            /* The prefix matched every level of the topic name. */
+            levelStart = ( size_t ) topicNameLength + 1U;
+        }
+        else if( pTopicName[ prefixLength ] == '/' )
+        {
+            levelStart = ( size_t ) prefixLength + 1U;
+        }
+        else
+        {
+            /* The last prefix level is only a prefix of the topic name level. */
+            isMatch = false;
+        }
+
+        if( isMatch == true )
+        {
+            isMatch = matchCompiledLevels( pTopicName, topicNameLength,
+                                           levelStart, pCompiledFilter );
+        }
+
+        *pIsMatch = isMatch;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
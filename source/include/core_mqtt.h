@@ -59,6 +59,36 @@
  */
 #define MQTT_PACKET_ID_INVALID    ( ( uint16_t ) 0U )
 
+/**
+ * @ingroup mqtt_constants
+ * @brief Handler ID of an incoming publish whose topic name has no handler,
+ * or when no topic cache is used.
+ */
+#define MQTT_HANDLER_ID_NONE    ( ( uint32_t ) 0xFFFFFFFFU )
+
+/**
+ * @ingroup mqtt_constants
+ * @brief Number of entries in the per packet type counters of #MQTTMetrics_t.
+ */
+#define MQTT_METRICS_PACKET_TYPE_COUNT    ( 16U )
+
+/**
+ * @ingroup mqtt_constants
+ * @brief Index of a packet type, such as #MQTT_PACKET_TYPE_PUBLISH, in the
+ * per packet type counters of #MQTTMetrics_t.
+ */
+#define MQTT_METRICS_INDEX( packetType )    ( ( size_t ) ( ( uint8_t ) ( packetType ) >> 4U ) )
+
+/**
+ * @ingroup mqtt_constants
+ * @brief Number of buckets of an #MQTTLatencyHistogram_t.
+ *
+ * Latencies below 16 ms each have their own bucket. Above that, every power
+ * of 2 is split into 8 buckets, so a bucket is at most 12.5% wide, up to
+ * 2^24 ms. Longer latencies are counted in the last bucket.
+ */
+#define MQTT_LATENCY_BUCKET_COUNT    ( 176U )
+
 /* Structures defined in this file. */
 struct MQTTPubAckInfo;
 struct MQTTContext;
@@ -160,6 +190,96 @@ typedef void (* MQTTClearPacketForRetransmit)( struct MQTTContext * pContext,
                                                uint16_t packetId );
 /* @[define_mqtt_retransmitclearpacket] */
 
+/**
+ * @ingroup mqtt_callback_types
+ * @brief Application callback for receiving the incoming publishes of a
+ * receive batch in one call.
+ *
+ * When enabled with #MQTT_InitPublishBatch, this callback is invoked in place
+ * of #MQTTEventCallback_t for incoming publishes. All publishes that are
+ * complete in the network buffer after a receive are passed together, and the
+ * PUBACKs and PUBRECs for them are sent after the callback returns. Incoming
+ * acks are still given to the #MQTTEventCallback_t, after the publishes that
+ * preceded them.
+ *
+ * @note The publish information and payloads point into the network buffer
+ * and are only valid until the callback returns.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] pDeserializedInfo Array of deserialized incoming publishes.
+ * @param[in] publishCount Number of entries in @p pDeserializedInfo.
+ */
+/* @[define_mqtt_publishbatchcallback] */
+typedef void (* MQTTPublishBatchCallback_t )( struct MQTTContext * pContext,
+                                              struct MQTTDeserializedInfo * pDeserializedInfo,
+                                              size_t publishCount );
+/* @[define_mqtt_publishbatchcallback] */
+
+/**
+ * @ingroup mqtt_callback_types
+ * @brief Application callback for getting a network buffer from an
+ * application owned pool.
+ *
+ * It is invoked by #MQTT_TakeReceiveBuffer to get the buffer that replaces
+ * the network buffer taken by the application. The new buffer is used for
+ * all further receives, so its size bounds the largest packet that can be
+ * received.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] minimumSize Number of bytes the buffer must be able to hold.
+ * @param[out] pBuffer The buffer to use as the network buffer.
+ *
+ * @return true if @p pBuffer was filled in; false if no buffer is available.
+ */
+/* @[define_mqtt_getbuffer] */
+typedef bool (* MQTTGetBuffer_t )( struct MQTTContext * pContext,
+                                   size_t minimumSize,
+                                   MQTTFixedBuffer_t * pBuffer );
+/* @[define_mqtt_getbuffer] */
+
+/**
+ * @ingroup mqtt_callback_types
+ * @brief Application callback for resolving the topic name of an incoming
+ * publish to the ID of the handler that processes it.
+ *
+ * It is invoked only for topic names not found in the topic cache set up with
+ * #MQTT_InitTopicCache, and its result is cached, so repeated topic names are
+ * not matched against the subscribed topic filters again. The application
+ * could, for example, use #MQTT_SubscriptionMatch here.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] pTopicName Topic name of the incoming publish.
+ * @param[in] topicNameLength Length of @p pTopicName.
+ *
+ * @return The application defined handler ID, or #MQTT_HANDLER_ID_NONE.
+ */
+/* @[define_mqtt_resolvetopic] */
+typedef uint32_t (* MQTTResolveTopic_t )( struct MQTTContext * pContext,
+                                          const char * pTopicName,
+                                          uint16_t topicNameLength );
+/* @[define_mqtt_resolvetopic] */
+
+/**
+ * @ingroup mqtt_callback_types
+ * @brief Application callback told of a slow consumer, set up with
+ * #MQTT_InitCallbackTiming.
+ *
+ * It is invoked after #MQTTContext_t.appCallback or
+ * #MQTTContext_t.publishBatchCallback returns, when the call took longer than
+ * the budget. It should only take note of the event, since it delays the
+ * processing of incoming packets further.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[in] packetType Type of the packet given to the callback, with the
+ * flags of a PUBLISH cleared. It is #MQTT_PACKET_TYPE_PUBLISH for a batch.
+ * @param[in] durationMs How long the call took.
+ */
+/* @[define_mqtt_slowconsumer] */
+typedef void (* MQTTSlowConsumer_t )( struct MQTTContext * pContext,
+                                      uint8_t packetType,
+                                      uint32_t durationMs );
+/* @[define_mqtt_slowconsumer] */
+
 /**
  * @ingroup mqtt_enum_types
  * @brief Values indicating if an MQTT connection exists.
@@ -214,6 +334,23 @@ typedef enum MQTTSubAckStatus
     MQTTSubAckFailure = 0x80      /**< @brief Failure. */
 } MQTTSubAckStatus_t;
 
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Events of the tracepoints given to #MQTT_TRACE.
+ *
+ * The name of an event without the `MQTTTrace` prefix is the one given to
+ * #MQTT_TRACE, so that a backend can paste it into a probe name.
+ */
+typedef enum MQTTTraceEvent
+{
+    MQTTTracePacketReceived = 1, /**< @brief A whole packet is in the network buffer. The bytes are its length. */
+    MQTTTraceDispatch,           /**< @brief A packet was given to the application callback. For a batch of publishes, the bytes are the number of publishes. */
+    MQTTTraceAckSent,            /**< @brief A PUBACK, PUBREC, PUBREL or PUBCOMP was sent. */
+    MQTTTraceStateChange,        /**< @brief The state of a publish changed. The status is the new #MQTTPublishState_t. */
+    MQTTTracePingSent,           /**< @brief A PINGREQ was sent. */
+    MQTTTraceKeepAliveTimeout    /**< @brief No PINGRESP arrived in time. */
+} MQTTTraceEvent_t;
+
 /**
  * @ingroup mqtt_struct_types
  * @brief An element of the state engine records for QoS 1 or Qos 2 publishes.
@@ -223,8 +360,120 @@ typedef struct MQTTPubAckInfo
     uint16_t packetId;               /**< @brief The packet ID of the original PUBLISH. */
     MQTTQoS_t qos;                   /**< @brief The QoS of the original PUBLISH. */
     MQTTPublishState_t publishState; /**< @brief The current state of the publish process. */
+    uint32_t sendTimeMs;             /**< @brief When an outgoing PUBLISH was last sent, if #MQTT_InitAckLatency was called. */
+    uint32_t pubRecTimeMs;           /**< @brief When the PUBREC of an outgoing QoS 2 PUBLISH was received, if #MQTT_InitAckLatency was called. */
 } MQTTPubAckInfo_t;
 
+/**
+ * @ingroup mqtt_struct_types
+ * @brief An entry of the topic cache set up with #MQTT_InitTopicCache.
+ *
+ * The members are private to the topic cache. An array of entries is
+ * supplied by the application.
+ */
+typedef struct MQTTTopicCacheEntry
+{
+    uint32_t hash;            /**< @brief Hash of the cached topic name. */
+    uint32_t handlerId;       /**< @brief Handler ID resolved for the topic name. */
+    uint16_t topicNameLength; /**< @brief Length of the cached topic name, or 0 if the entry is empty. */
+} MQTTTopicCacheEntry_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Counters of the activity of an MQTT context, set up with
+ * #MQTT_InitMetrics.
+ *
+ * The counters are only updated when the library is built with
+ * #MQTT_METRICS_ENABLED set to 1. The per packet type counters are indexed
+ * with #MQTT_METRICS_INDEX. The receive calls made by
+ * #MQTT_GetIncomingPacketTypeAndLengthBuffered while #MQTT_Connect waits for
+ * the CONNACK fixed header are not counted.
+ */
+typedef struct MQTTMetrics
+{
+    uint32_t packetsSent[ MQTT_METRICS_PACKET_TYPE_COUNT ];     /**< @brief Packets sent completely, per packet type. */
+    uint64_t bytesSent[ MQTT_METRICS_PACKET_TYPE_COUNT ];       /**< @brief Bytes sent, per packet type. */
+    uint32_t packetsReceived[ MQTT_METRICS_PACKET_TYPE_COUNT ]; /**< @brief Packets received and handled, per packet type. */
+    uint64_t bytesReceived[ MQTT_METRICS_PACKET_TYPE_COUNT ];   /**< @brief Bytes of the packets received and handled, per packet type. */
+
+    uint32_t transportSendCalls;        /**< @brief Calls to the transport send or writev function. */
+    uint32_t partialSends;              /**< @brief Calls to the transport send or writev function that sent fewer bytes than given. */
+    uint32_t transportRecvCalls;        /**< @brief Calls to the transport receive function. */
+    uint32_t zeroByteRecvs;             /**< @brief Calls to the transport receive function that returned no bytes. */
+    uint32_t transportSkipCalls;        /**< @brief Calls to the transport skip function. */
+    uint32_t needMoreBytes;             /**< @brief Receive loop iterations that ended with only part of a packet in the network buffer. */
+
+    uint32_t discardedPackets;          /**< @brief Packets discarded because they did not fit in the network buffer. */
+    uint64_t discardedBytes;            /**< @brief Bytes of the discarded packets. */
+
+    size_t outgoingPublishRecordsMax;   /**< @brief Most outgoing publish records in use at once. */
+    size_t incomingPublishRecordsMax;   /**< @brief Most incoming publish records in use at once. */
+
+    uint32_t keepAlivePingsSent;        /**< @brief PINGREQs sent by the library to keep the connection alive. */
+    uint32_t keepAliveTimeouts;         /**< @brief Times no PINGRESP arrived in time. */
+} MQTTMetrics_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A log-linear histogram of latencies in milliseconds.
+ *
+ * Recording a latency costs a few shifts and no memory beyond this
+ * structure. Use #MQTT_GetLatencyPercentile to read a percentile.
+ */
+typedef struct MQTTLatencyHistogram
+{
+    uint32_t count;                                /**< @brief Number of latencies recorded. */
+    uint32_t maxMs;                                /**< @brief Longest latency recorded. */
+    uint64_t totalMs;                              /**< @brief Sum of the latencies recorded. */
+    uint32_t buckets[ MQTT_LATENCY_BUCKET_COUNT ]; /**< @brief Number of latencies recorded per bucket. */
+} MQTTLatencyHistogram_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Latencies of the acknowledgments of outgoing publishes, set up with
+ * #MQTT_InitAckLatency.
+ *
+ * A latency is measured from the last time the PUBLISH was sent, so a
+ * PUBLISH resent after a reconnection is measured from the resend.
+ */
+typedef struct MQTTAckLatency
+{
+    MQTTLatencyHistogram_t pubAck;          /**< @brief QoS 1, from PUBLISH sent to PUBACK received. */
+    MQTTLatencyHistogram_t pubComp;         /**< @brief QoS 2, from PUBLISH sent to PUBCOMP received. */
+    MQTTLatencyHistogram_t pubRecToPubComp; /**< @brief QoS 2, from PUBREC received to PUBCOMP received. */
+} MQTTAckLatency_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Time spent in the application callbacks of an MQTT context, set up
+ * with #MQTT_InitCallbackTiming.
+ *
+ * A call of #MQTTContext_t.publishBatchCallback is counted as one call for
+ * #MQTT_PACKET_TYPE_PUBLISH. The per packet type members are indexed with
+ * #MQTT_METRICS_INDEX.
+ *
+ * The network buffer is busy from when the receive loop first finds bytes
+ * in it until it has handled them all. A long busy time with short callbacks
+ * points at the network, for example a packet arriving slowly, while a long
+ * busy time made of long callbacks points at the application.
+ */
+typedef struct MQTTCallbackTiming
+{
+    MQTTLatencyHistogram_t duration;                    /**< @brief Durations of all the calls. */
+    uint32_t calls[ MQTT_METRICS_PACKET_TYPE_COUNT ];   /**< @brief Calls, per packet type. */
+    uint64_t totalMs[ MQTT_METRICS_PACKET_TYPE_COUNT ]; /**< @brief Time spent in the calls, per packet type. */
+    uint32_t maxMs[ MQTT_METRICS_PACKET_TYPE_COUNT ];   /**< @brief Longest call, per packet type. */
+
+    uint32_t budgetMs;                       /**< @brief Longest a call may take before it is slow. */
+    uint32_t slowCalls;                      /**< @brief Calls that took longer than the budget. */
+    MQTTSlowConsumer_t slowConsumerCallback; /**< @brief Told of each slow call, or NULL. */
+
+    uint64_t bufferBusyMs;      /**< @brief Time the network buffer held bytes not yet handled. */
+    uint32_t bufferBusyMaxMs;   /**< @brief Longest time the network buffer held bytes not yet handled. */
+    uint32_t bufferBusySinceMs; /**< @brief When the network buffer became busy. Private to the library. */
+    bool bufferBusy;            /**< @brief Whether the network buffer is busy. Private to the library. */
+} MQTTCallbackTiming_t;
+
 /**
  * @ingroup mqtt_struct_types
  * @brief A struct representing an MQTT connection.
@@ -302,6 +551,15 @@ typedef struct MQTTContext
      */
     size_t index;
 
+    /**
+     * @brief Fixed header of the packet at the start of the network buffer.
+     *
+     * It is kept once the header has been parsed so that it is not parsed
+     * again while the rest of the packet arrives. A header length of zero
+     * means the header has not been parsed yet.
+     */
+    MQTTPacketInfo_t pendingPacket;
+
     /* Keep alive members. */
     uint16_t keepAliveIntervalSec; /**< @brief Keep Alive interval. */
     uint32_t pingReqSendTimeMs;    /**< @brief Timestamp of the last sent PINGREQ. */
@@ -321,6 +579,60 @@ typedef struct MQTTContext
      * @brief User defined API used to clear a particular copied publish packet.
      */
     MQTTClearPacketForRetransmit clearFunction;
+
+    /**
+     * @brief Callback used to give batches of incoming publishes to the
+     * application, or NULL to give them one at a time to #MQTTContext_t.appCallback.
+     */
+    MQTTPublishBatchCallback_t publishBatchCallback;
+
+    /* Publish batch members. */
+    struct MQTTDeserializedInfo * pPublishBatch; /**< @brief Deserialized information of the batched publishes. */
+    MQTTPublishInfo_t * pPublishBatchInfo;       /**< @brief Publish information of the batched publishes. */
+    size_t publishBatchMaxCount;                 /**< @brief Maximum number of publishes in a batch. */
+    size_t publishBatchCount;                    /**< @brief Number of publishes in the current batch. */
+
+    /**
+     * @brief Callback used to replace the network buffer when it is taken by
+     * the application with #MQTT_TakeReceiveBuffer.
+     */
+    MQTTGetBuffer_t getBufferFunction;
+
+    /* Buffer exchange members. */
+    size_t deliveredIndex; /**< @brief End of the bytes in the network buffer given to the application. */
+    size_t takenLength;    /**< @brief Bytes removed from the front of the network buffer by #MQTT_TakeReceiveBuffer. */
+
+    /**
+     * @brief Callback used to resolve the topic names of incoming publishes
+     * missing from the topic cache, or NULL if no topic cache is used.
+     */
+    MQTTResolveTopic_t resolveTopicFunction;
+
+    /* Topic cache members. */
+    MQTTTopicCacheEntry_t * pTopicCache; /**< @brief Entries of the topic cache. */
+    char * pTopicCacheNames;             /**< @brief Topic names of the entries, topicCacheNameLengthMax bytes each. */
+    size_t topicCacheEntryCount;         /**< @brief Number of entries in the topic cache. */
+    size_t topicCacheNameLengthMax;      /**< @brief Longest topic name that is cached. */
+    uint32_t topicCacheHits;             /**< @brief Number of incoming publishes whose handler ID was found in the topic cache. */
+    uint32_t topicCacheMisses;           /**< @brief Number of incoming publishes whose handler ID was resolved by resolveTopicFunction. */
+
+    /**
+     * @brief Counters updated by the library, or NULL if #MQTT_InitMetrics
+     * was not called.
+     */
+    MQTTMetrics_t * pMetrics;
+
+    /**
+     * @brief Latencies recorded by the state engine, or NULL if
+     * #MQTT_InitAckLatency was not called.
+     */
+    MQTTAckLatency_t * pAckLatency;
+
+    /**
+     * @brief Time spent in the application callbacks, or NULL if
+     * #MQTT_InitCallbackTiming was not called.
+     */
+    MQTTCallbackTiming_t * pCallbackTiming;
 } MQTTContext_t;
 
 /**
@@ -333,6 +645,7 @@ typedef struct MQTTDeserializedInfo
     uint16_t packetIdentifier;          /**< @brief Packet ID of deserialized packet. */
     MQTTPublishInfo_t * pPublishInfo;   /**< @brief Pointer to deserialized publish info. */
     MQTTStatus_t deserializationResult; /**< @brief Return code of deserialization. */
+    uint32_t handlerId;                 /**< @brief Handler ID of an incoming publish, from the topic cache set up with #MQTT_InitTopicCache. */
 } MQTTDeserializedInfo_t;
 
 /**
@@ -380,7 +693,7 @@ typedef struct MQTTDeserializedInfo
  * int32_t networkRecv( NetworkContext_t * pContext, void * pBuffer, size_t bytes );
  *
  * MQTTContext_t mqttContext;
- * TransportInterface_t transport;
+ * TransportInterface_t transport = { 0 };
  * MQTTFixedBuffer_t fixedBuffer;
  * // Create a globally accessible buffer which remains in scope for the entire duration
  * // of the MQTT context.
@@ -451,7 +764,7 @@ MQTTStatus_t MQTT_Init( MQTTContext_t * pContext,
  * int32_t networkRecv( NetworkContext_t * pContext, void * pBuffer, size_t bytes );
  *
  * MQTTContext_t mqttContext;
- * TransportInterface_t transport;
+ * TransportInterface_t transport = { 0 };
  * MQTTFixedBuffer_t fixedBuffer;
  * uint8_t buffer[ 1024 ];
  * const size_t outgoingPublishCount = 30;
@@ -533,7 +846,7 @@ MQTTStatus_t MQTT_InitStatefulQoS( MQTTContext_t * pContext,
  * bool publishClearAllCallback(struct MQTTContext* pContext);
  *
  * MQTTContext_t mqttContext;
- * TransportInterface_t transport;
+ * TransportInterface_t transport = { 0 };
  * MQTTFixedBuffer_t fixedBuffer;
  * uint8_t buffer[ 1024 ];
  * const size_t outgoingPublishCount = 30;
@@ -581,6 +894,408 @@ MQTTStatus_t MQTT_InitRetransmits( MQTTContext_t * pContext,
                                    MQTTClearPacketForRetransmit clearFunction );
 /* @[declare_mqtt_initretransmits] */
 
+/**
+ * @brief Initialize an MQTT context to deliver incoming publishes in batches.
+ *
+ * Once called, incoming publishes are given to @p publishBatchCallback
+ * instead of the #MQTTEventCallback_t passed to #MQTT_Init. Every publish
+ * that is complete in the network buffer after a receive is deserialized
+ * into the arrays provided here, and the whole batch is passed to the
+ * callback at once. The acks for the publishes are sent after the callback
+ * returns. A batch is also delivered early when it holds @p batchMaxCount
+ * publishes, or before any other packet is handed to the application, so the
+ * order of packets is kept.
+ *
+ * This function must be called on an #MQTTContext_t after #MQTT_Init.
+ *
+ * @param[in] pContext The context to initialize.
+ * @param[in] publishBatchCallback Callback for receiving batches of publishes.
+ * @param[in] pDeserializedInfoArray Array used to pass the batched publishes
+ * to the callback.
+ * @param[in] pPublishInfoArray Array used to hold the deserialized publishes.
+ * @param[in] batchMaxCount Number of entries in each of @p pDeserializedInfoArray
+ * and @p pPublishInfoArray.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Callback function for receiving batches of publishes.
+ * void publishBatchCallback(
+ *      MQTTContext_t * pContext,
+ *      MQTTDeserializedInfo_t * pDeserializedInfo,
+ *      size_t publishCount
+ * );
+ *
+ * MQTTDeserializedInfo_t batch[ 16 ];
+ * MQTTPublishInfo_t batchPublishes[ 16 ];
+ *
+ * status = MQTT_Init( &mqttContext, &transport, getTimeStampMs, eventCallback, &fixedBuffer );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      status = MQTT_InitPublishBatch( &mqttContext, publishBatchCallback,
+ *                                      batch, batchPublishes, 16 );
+ *
+ *      // Now incoming publishes are given to publishBatchCallback.
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_initpublishbatch] */
+MQTTStatus_t MQTT_InitPublishBatch( MQTTContext_t * pContext,
+                                    MQTTPublishBatchCallback_t publishBatchCallback,
+                                    MQTTDeserializedInfo_t * pDeserializedInfoArray,
+                                    MQTTPublishInfo_t * pPublishInfoArray,
+                                    size_t batchMaxCount );
+/* @[declare_mqtt_initpublishbatch] */
+
+/**
+ * @brief Initialize an MQTT context to allow the application to take
+ * ownership of the network buffer from its callbacks.
+ *
+ * Once called, #MQTT_TakeReceiveBuffer may be used from the
+ * #MQTTEventCallback_t or #MQTTPublishBatchCallback_t for incoming publishes.
+ *
+ * This function must be called on an #MQTTContext_t after #MQTT_Init.
+ *
+ * @param[in] pContext The context to initialize.
+ * @param[in] getBufferFunction Callback for getting replacement network buffers.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Function for getting a buffer from the application pool.
+ * bool getBuffer( MQTTContext_t * pContext,
+ *                 size_t minimumSize,
+ *                 MQTTFixedBuffer_t * pBuffer );
+ *
+ * status = MQTT_Init( &mqttContext, &transport, getTimeStampMs, eventCallback, &fixedBuffer );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      status = MQTT_InitBufferExchange( &mqttContext, getBuffer );
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_initbufferexchange] */
+MQTTStatus_t MQTT_InitBufferExchange( MQTTContext_t * pContext,
+                                      MQTTGetBuffer_t getBufferFunction );
+/* @[declare_mqtt_initbufferexchange] */
+
+/**
+ * @brief Take ownership of the network buffer holding the incoming publishes
+ * currently given to the application.
+ *
+ * Without this, the topic names and payloads of incoming publishes point into
+ * the network buffer and must be copied before the callback returns. When
+ * this function succeeds, the buffer is instead handed over to the
+ * application, so the publishes stay valid until the application returns the
+ * buffer to its pool. The context continues with a buffer from the
+ * #MQTTGetBuffer_t passed to #MQTT_InitBufferExchange, into which any bytes
+ * received after the delivered publishes are moved.
+ *
+ * All the publishes of one #MQTTPublishBatchCallback_t call share the taken
+ * buffer, so an application handing them to different workers can keep a
+ * reference count per taken buffer and release it when the count drops to 0.
+ *
+ * This function may only be called from the #MQTTEventCallback_t or the
+ * #MQTTPublishBatchCallback_t while an incoming publish is being delivered.
+ *
+ * @param[in] pContext Initialized MQTT context.
+ * @param[out] pTakenBuffer The network buffer now owned by the application.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or no incoming
+ * publish is being delivered;
+ * #MQTTNoMemory if no replacement buffer large enough is available;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * void eventCallback( MQTTContext_t * pContext,
+ *                     MQTTPacketInfo_t * pPacketInfo,
+ *                     MQTTDeserializedInfo_t * pDeserializedInfo )
+ * {
+ *      MQTTFixedBuffer_t takenBuffer;
+ *
+ *      if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+ *      {
+ *          if( MQTT_TakeReceiveBuffer( pContext, &takenBuffer ) == MQTTSuccess )
+ *          {
+ *              // The publish stays valid until takenBuffer is returned to the pool.
+ *              queueToWorker( pDeserializedInfo->pPublishInfo, &takenBuffer );
+ *          }
+ *          else
+ *          {
+ *              // Copy the publish before returning.
+ *          }
+ *      }
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_takereceivebuffer] */
+MQTTStatus_t MQTT_TakeReceiveBuffer( MQTTContext_t * pContext,
+                                     MQTTFixedBuffer_t * pTakenBuffer );
+/* @[declare_mqtt_takereceivebuffer] */
+
+/**
+ * @brief Initialize an MQTT context to cache the handler IDs resolved for the
+ * topic names of incoming publishes.
+ *
+ * Once called, the topic name of each incoming publish is hashed and looked
+ * up in the cache. On a miss, @p resolveTopicFunction is invoked and its
+ * result is stored in the entry for the hash, replacing any topic name cached
+ * there before. The handler ID is passed to the application in
+ * MQTTDeserializedInfo_t.handlerId. Topic names longer than
+ * @p topicNameLengthMax are resolved every time.
+ *
+ * The cache is cleared whenever a SUBSCRIBE or UNSUBSCRIBE is sent, and when
+ * its SUBACK or UNSUBACK is received, so that changes the application makes
+ * to its handlers around those requests take effect. Other changes to what
+ * @p resolveTopicFunction returns require a call to
+ * #MQTT_InvalidateTopicCache. The hits and misses are counted in
+ * #MQTTContext_t.topicCacheHits and #MQTTContext_t.topicCacheMisses.
+ *
+ * This function must be called on an #MQTTContext_t after #MQTT_Init.
+ *
+ * @param[in] pContext The context to initialize.
+ * @param[in] resolveTopicFunction Callback for resolving topic names missing
+ * from the cache.
+ * @param[in] pEntries Array of cache entries.
+ * @param[in] pTopicNameBuffer Buffer of at least
+ * `entryCount * topicNameLengthMax` bytes for the cached topic names.
+ * @param[in] entryCount Number of entries in @p pEntries.
+ * @param[in] topicNameLengthMax Length of the longest topic name to cache.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * MQTTTopicCacheEntry_t topicCacheEntries[ 256 ];
+ * char topicCacheNames[ 256 * 64 ];
+ *
+ * // Function matching a topic name against the subscriptions.
+ * uint32_t resolveTopic( MQTTContext_t * pContext,
+ *                        const char * pTopicName,
+ *                        uint16_t topicNameLength );
+ *
+ * status = MQTT_Init( &mqttContext, &transport, getTimeStampMs, eventCallback, &fixedBuffer );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      status = MQTT_InitTopicCache( &mqttContext, resolveTopic,
+ *                                    topicCacheEntries, topicCacheNames, 256, 64 );
+ * }
+ *
+ * // In the event callback, incoming publishes can be dispatched with
+ * // handlers[ pDeserializedInfo->handlerId ].
+ * @endcode
+ */
+/* @[declare_mqtt_inittopiccache] */
+MQTTStatus_t MQTT_InitTopicCache( MQTTContext_t * pContext,
+                                  MQTTResolveTopic_t resolveTopicFunction,
+                                  MQTTTopicCacheEntry_t * pEntries,
+                                  char * pTopicNameBuffer,
+                                  size_t entryCount,
+                                  size_t topicNameLengthMax );
+/* @[declare_mqtt_inittopiccache] */
+
+/**
+ * @brief Clear the topic cache, so that the topic names of all further
+ * incoming publishes are resolved again.
+ *
+ * @param[in] pContext Initialized MQTT context with a topic cache.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or no topic
+ * cache was set up with #MQTT_InitTopicCache;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // The handler of a topic filter changed.
+ * status = MQTT_InvalidateTopicCache( &mqttContext );
+ * @endcode
+ */
+/* @[declare_mqtt_invalidatetopiccache] */
+MQTTStatus_t MQTT_InvalidateTopicCache( MQTTContext_t * pContext );
+/* @[declare_mqtt_invalidatetopiccache] */
+
+/**
+ * @brief Initialize an MQTT context to count its activity in @p pMetrics.
+ *
+ * The counters are reset, and from then on are updated as packets are sent
+ * and received. The library must be built with #MQTT_METRICS_ENABLED set to
+ * 1, otherwise this function and #MQTT_GetMetrics and #MQTT_ResetMetrics are
+ * not compiled, and no counting code is either.
+ *
+ * This function must be called on an #MQTTContext_t after #MQTT_Init.
+ *
+ * @param[in] pContext The context to initialize.
+ * @param[in] pMetrics The counters, which must stay valid as long as the
+ * context is used.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * MQTTMetrics_t metrics;
+ * MQTTMetrics_t snapshot;
+ *
+ * status = MQTT_Init( &mqttContext, &transport, getTimeStampMs, eventCallback, &fixedBuffer );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      status = MQTT_InitMetrics( &mqttContext, &metrics );
+ * }
+ *
+ * // Later, possibly from another thread.
+ * if( MQTT_GetMetrics( &mqttContext, &snapshot ) == MQTTSuccess )
+ * {
+ *      printf( "PUBLISH sent: %u\n",
+ *              snapshot.packetsSent[ MQTT_METRICS_INDEX( MQTT_PACKET_TYPE_PUBLISH ) ] );
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_initmetrics] */
+MQTTStatus_t MQTT_InitMetrics( MQTTContext_t * pContext,
+                               MQTTMetrics_t * pMetrics );
+/* @[declare_mqtt_initmetrics] */
+
+/**
+ * @brief Copy the counters of an MQTT context.
+ *
+ * The copy is not synchronized with the thread using the context, so the
+ * counters copied while it sends or receives may be from slightly different
+ * times.
+ *
+ * @param[in] pContext Context initialized with #MQTT_InitMetrics.
+ * @param[out] pMetrics The copy of the counters.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or
+ * #MQTT_InitMetrics was not called;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_getmetrics] */
+MQTTStatus_t MQTT_GetMetrics( const MQTTContext_t * pContext,
+                              MQTTMetrics_t * pMetrics );
+/* @[declare_mqtt_getmetrics] */
+
+/**
+ * @brief Reset the counters of an MQTT context to zero, including the most
+ * publish records in use.
+ *
+ * @param[in] pContext Context initialized with #MQTT_InitMetrics.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or
+ * #MQTT_InitMetrics was not called;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_resetmetrics] */
+MQTTStatus_t MQTT_ResetMetrics( MQTTContext_t * pContext );
+/* @[declare_mqtt_resetmetrics] */
+
+/**
+ * @brief Initialize an MQTT context to record the latencies of the
+ * acknowledgments of its outgoing QoS 1 and QoS 2 publishes in @p pAckLatency.
+ *
+ * The histograms are reset. From then on, the state engine stamps each
+ * outgoing publish record with the time from #MQTTContext_t.getTime when the
+ * PUBLISH is sent and when its PUBREC is received, and records the latency
+ * when the PUBACK or PUBCOMP is received. Like #MQTT_InitMetrics, this
+ * function is only compiled when #MQTT_METRICS_ENABLED is set to 1. Calling
+ * it again resets the histograms.
+ *
+ * This function must be called on an #MQTTContext_t after
+ * #MQTT_InitStatefulQoS and before publishes are sent.
+ *
+ * @param[in] pContext The context to initialize.
+ * @param[in] pAckLatency The histograms, which must stay valid as long as the
+ * context is used.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * MQTTAckLatency_t ackLatency;
+ * uint32_t p99Ms;
+ *
+ * status = MQTT_InitAckLatency( &mqttContext, &ackLatency );
+ *
+ * // Later, after some publishes have been acknowledged.
+ * if( MQTT_GetLatencyPercentile( &ackLatency.pubAck, 990U, &p99Ms ) == MQTTSuccess )
+ * {
+ *      printf( "p99 PUBLISH to PUBACK: %u ms\n", p99Ms );
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_initacklatency] */
+MQTTStatus_t MQTT_InitAckLatency( MQTTContext_t * pContext,
+                                  MQTTAckLatency_t * pAckLatency );
+/* @[declare_mqtt_initacklatency] */
+
+/**
+ * @brief Initialize an MQTT context to time its application callbacks in
+ * @p pTiming, and to report the calls that take longer than @p budgetMs.
+ *
+ * The timing is reset. From then on, each call of
+ * #MQTTContext_t.appCallback and #MQTTContext_t.publishBatchCallback is
+ * timed with #MQTTContext_t.getTime, as is the time the network buffer holds
+ * bytes not yet handled. Like #MQTT_InitMetrics, this function is only
+ * compiled when #MQTT_METRICS_ENABLED is set to 1. Calling it again resets
+ * the timing.
+ *
+ * This function must be called on an #MQTTContext_t after #MQTT_Init.
+ *
+ * @param[in] pContext The context to initialize.
+ * @param[in] pTiming The timing, which must stay valid as long as the context
+ * is used.
+ * @param[in] budgetMs Longest a call may take before it is slow.
+ * @param[in] slowConsumerCallback Told of each slow call, or NULL to only
+ * count them.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * MQTTCallbackTiming_t callbackTiming;
+ *
+ * void slowConsumer( MQTTContext_t * pContext,
+ *                    uint8_t packetType,
+ *                    uint32_t durationMs )
+ * {
+ *      LogWarn( ( "Callback for packet type %02x took %u ms.",
+ *                 packetType, durationMs ) );
+ * }
+ *
+ * // Calls that take more than 50 ms are reported.
+ * status = MQTT_InitCallbackTiming( &mqttContext, &callbackTiming, 50U, slowConsumer );
+ * @endcode
+ */
+/* @[declare_mqtt_initcallbacktiming] */
+MQTTStatus_t MQTT_InitCallbackTiming( MQTTContext_t * pContext,
+                                      MQTTCallbackTiming_t * pTiming,
+                                      uint32_t budgetMs,
+                                      MQTTSlowConsumer_t slowConsumerCallback );
+/* @[declare_mqtt_initcallbacktiming] */
+
 /**
  * @brief Checks the MQTT connection status with the broker.
  *
@@ -1128,6 +1843,40 @@ MQTTStatus_t MQTT_MatchTopic( const char * pTopicName,
                               const uint16_t topicFilterLength,
                               bool * pIsMatch );
 
+/**
+ * @brief A utility function that checks whether a topic name is valid to
+ * publish to according to the MQTT 3.1.1 protocol specification.
+ *
+ * A valid topic name is at least one character long, and has neither
+ * wildcard characters nor null characters.
+ *
+ * @param[in] pTopicName The topic name to check.
+ * @param[in] topicNameLength Length of the topic name.
+ *
+ * @return Returns one of the following:
+ * - #MQTTBadParameter, if the topic name is NULL or is not valid.
+ * - #MQTTSuccess, if the topic name is valid.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * const char * pTopic = "sensors/kitchen/temperature";
+ * MQTTStatus_t status = MQTTSuccess;
+ *
+ * status = MQTT_ValidateTopicName( pTopic, strlen( pTopic ) );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      // The topic name can be used in MQTTPublishInfo_t.pTopicName.
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_validatetopicname] */
+MQTTStatus_t MQTT_ValidateTopicName( const char * pTopicName,
+                                     uint16_t topicNameLength );
+/* @[declare_mqtt_validatetopicname] */
+
 /**
  * @brief Parses the payload of an MQTT SUBACK packet that contains status codes
  * corresponding to topic filter subscription requests from the original
@@ -76,6 +76,36 @@
     #define MQTT_SUB_UNSUB_MAX_VECTORS    ( 4U )
 #endif
 
+/**
+ * @brief Maximum number of levels in a topic filter added to a subscription
+ * trie with #MQTT_SubscriptionAdd.
+ *
+ * A '#' level does not count towards this limit. #MQTT_SubscriptionMatch
+ * uses a stack with one entry per level, so this bounds its stack usage.
+ *
+ * <b>Possible values:</b> Any positive 16 bit integer. <br>
+ * <b>Default value:</b> `16`
+ */
+#ifndef MQTT_SUBSCRIPTION_LEVELS_MAX
+    #define MQTT_SUBSCRIPTION_LEVELS_MAX    ( 16U )
+#endif
+
+/**
+ * @brief Whether topic names and filters are scanned with SIMD instructions
+ * when the compiler targets a processor that has them.
+ *
+ * When enabled and SSE2 is available, #MQTT_MatchTopic and
+ * #MQTT_ValidateTopicName look for level separators and compare topic bytes
+ * 16 at a time. Otherwise, and for the bytes left over after the last full
+ * block of 16, the bytes are scanned one at a time.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `1`
+ */
+#ifndef MQTT_TOPIC_SIMD
+    #define MQTT_TOPIC_SIMD    ( 1 )
+#endif
+
 /**
  * @brief The number of retries for receiving CONNACK.
  *
@@ -156,6 +186,9 @@
  * If the timeout expires, the #MQTT_ProcessLoop and #MQTT_ReceiveLoop functions
  * return #MQTTRecvFailed.
  *
+ * If the transport interface has a #TransportWaitReadable_t function, it is
+ * called to wait for bytes instead of calling the receive function repeatedly.
+ *
  * @note If a dummy implementation of the #MQTTGetCurrentTimeFunc_t timer function,
  * is supplied to the library, then #MQTT_RECV_POLLING_TIMEOUT_MS MUST be set to 0.
  *
@@ -191,6 +224,78 @@
     #define MQTT_SEND_TIMEOUT_MS    ( 20000U )
 #endif
 
+/**
+ * @brief Size of the stack buffer used to gather the vectors of a packet into
+ * one send call when the transport interface has no writev function.
+ *
+ * Without writev, a packet made of several vectors, such as the fixed header,
+ * topic name, packet identifier and payload of a PUBLISH, would take one
+ * transport send call per vector. Instead, consecutive vectors that fit in
+ * this buffer together are copied into it and sent with a single call. A
+ * vector that does not fit, such as a large payload, is still sent from the
+ * application's buffer without copying. Set to `0` to send each vector with
+ * its own call and use no stack for the buffer.
+ *
+ * <b>Possible values:</b> `0` or any positive 16 bit integer. <br>
+ * <b>Default value:</b> `128`
+ */
+#ifndef MQTT_SEND_GATHER_BUFFER_SIZE
+    #define MQTT_SEND_GATHER_BUFFER_SIZE    ( 128U )
+#endif
+
+/**
+ * @brief Whether the library counts its activity in the #MQTTMetrics_t set up
+ * with #MQTT_InitMetrics.
+ *
+ * When disabled, #MQTT_InitMetrics, #MQTT_GetMetrics, #MQTT_ResetMetrics,
+ * #MQTT_InitAckLatency, #MQTT_GetLatencyPercentile and
+ * #MQTT_InitCallbackTiming are not compiled and no code is spent on counting
+ * or timing. When enabled, a context without metrics costs
+ * one check of a pointer at each counted event.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef MQTT_METRICS_ENABLED
+    #define MQTT_METRICS_ENABLED    ( 0 )
+#endif
+
+/**
+ * @brief Whether the library calls the optional
+ * #TransportInterface_t.waitReadable function.
+ *
+ * When enabled, the library calls the wait function of the transport
+ * interface, if it is not NULL, to block until bytes arrive instead of
+ * calling the receive function again at once. The application must then set
+ * the member to a valid function or NULL, for example by zero-initializing
+ * the #TransportInterface_t. When disabled, the member is never read, so
+ * applications that only assign the other members keep working unchanged.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef MQTT_TRANSPORT_WAIT_READABLE_ENABLED
+    #define MQTT_TRANSPORT_WAIT_READABLE_ENABLED    ( 0 )
+#endif
+
+/**
+ * @brief Whether the library calls the optional #TransportInterface_t.skip
+ * function.
+ *
+ * When enabled, the library discards the rest of a packet too big for its
+ * network buffer with the skip function of the transport interface, if it is
+ * not NULL, instead of receiving the bytes into the buffer. The application
+ * must then set the member to a valid function or NULL, for example by
+ * zero-initializing the #TransportInterface_t. When disabled, the member is
+ * never read.
+ *
+ * <b>Possible values:</b> `0` or `1` <br>
+ * <b>Default value:</b> `0`
+ */
+#ifndef MQTT_TRANSPORT_SKIP_ENABLED
+    #define MQTT_TRANSPORT_SKIP_ENABLED    ( 0 )
+#endif
+
 #ifdef MQTT_SEND_RETRY_TIMEOUT_MS
     #error MQTT_SEND_RETRY_TIMEOUT_MS is deprecated. Instead use MQTT_SEND_TIMEOUT_MS.
 #endif
@@ -275,6 +380,42 @@
     #define LogDebug( message )
 #endif
 
+/**
+ * @brief Macro that is called in the MQTT library at the tracepoints of the
+ * packet path.
+ *
+ * Unlike the logging macros, it formats nothing, so it can be left enabled in
+ * production. It is called when a packet is received, when a packet is given
+ * to the application callback, when an acknowledgment is sent, when the state
+ * of a publish changes, and for keep-alive events.
+ *
+ * @param event Name of the #MQTTTraceEvent_t without the `MQTTTrace`
+ * prefix, such as `PacketReceived`.
+ * @param pContext The #MQTTContext_t.
+ * @param packetType First byte of the packet, or 0.
+ * @param packetId Packet identifier, or 0 if the event has none.
+ * @param bytes Bytes of the packet, or as described by the event.
+ * @param status An #MQTTStatus_t, or as described by the event.
+ *
+ * Two backends are provided. @ref core_mqtt_trace_usdt.h maps it to USDT
+ * probes on Linux, which cost a no-op instruction until a tracer attaches to
+ * them. @ref core_mqtt_trace_ring.h maps it to fixed-size records in an
+ * in-memory ring:
+ * @code{c}
+ * // In core_mqtt_config.h.
+ * #include "core_mqtt_trace_ring.h"
+ * extern MQTTTraceRing_t traceRing;
+ * #define MQTT_TRACE( event, pContext, packetType, packetId, bytes, status ) \
+ *     MQTT_TRACE_RING( &traceRing, event, pContext, packetType, packetId, bytes, status )
+ * @endcode
+ *
+ * <b>Default value</b>: Tracing is turned off, and no code is generated for
+ * calls to the macro in the MQTT library on compilation.
+ */
+#ifndef MQTT_TRACE
+    #define MQTT_TRACE( event, pContext, packetType, packetId, bytes, status )
+#endif
+
 /* *INDENT-OFF* */
 #ifdef __cplusplus
     }
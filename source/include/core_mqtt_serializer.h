@@ -1224,6 +1224,147 @@ MQTTStatus_t MQTT_ProcessIncomingPacketTypeAndLength( const uint8_t * pBuffer,
                                                       MQTTPacketInfo_t * pIncomingPacket );
 /* @[declare_mqtt_processincomingpackettypeandlength] */
 
+/**
+ * @brief Buffered variant of #MQTT_GetIncomingPacketTypeAndLength.
+ *
+ * Instead of reading the packet type and every remaining length byte with a
+ * separate 1 byte transport receive, this function reads as many bytes as
+ * are available (up to the free space left in @p pFixedBuffer) with a single
+ * call to @p readFunc, and then parses the fixed header from the buffer with
+ * #MQTT_ProcessIncomingPacketTypeAndLength. If the buffer already holds a
+ * complete fixed header, no transport read is made.
+ *
+ * Any bytes read past the fixed header are left in the buffer, so the caller
+ * only needs to receive `headerLength + remainingLength - *pIndex` more bytes
+ * to complete the packet. The function may be called repeatedly with the same
+ * buffer and index until the header is complete.
+ *
+ * @param[in] readFunc Transport layer read function pointer.
+ * @param[in] pNetworkContext The network context pointer provided by the application.
+ * @param[in] pFixedBuffer Buffer into which incoming data is read.
+ * @param[in,out] pIndex Number of valid bytes at the start of the buffer. It
+ * is advanced by the number of bytes read from the transport.
+ * @param[out] pIncomingPacket Pointer to MQTTPacketInfo_t structure. This is
+ * where type, remaining length and header length of the packet is stored.
+ *
+ * @return #MQTTSuccess on successful extraction of type and length,
+ * #MQTTBadParameter if any of the parameters is invalid,
+ * #MQTTRecvFailed on transport receive failure,
+ * #MQTTBadResponse if an invalid packet is read,
+ * #MQTTNeedMoreBytes if only part of the fixed header has been received, and
+ * #MQTTNoDataAvailable if there is nothing to read.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // TransportRecv_t function for reading from the network.
+ * int32_t socket_recv(
+ *      NetworkContext_t * pNetworkContext,
+ *      void * pBuffer,
+ *      size_t bytesToRecv
+ * );
+ * // Some context to be used with above transport receive function.
+ * NetworkContext_t networkContext;
+ *
+ * // Buffer to hold the incoming packet.
+ * uint8_t buffer[ BUFFER_SIZE ];
+ * MQTTFixedBuffer_t fixedBuffer = { .pBuffer = buffer, .size = BUFFER_SIZE };
+ * size_t index = 0;
+ * MQTTPacketInfo_t incomingPacket;
+ * MQTTStatus_t status = MQTTSuccess;
+ *
+ * // Loop until the fixed header of the packet has been received.
+ * do{
+ *      status = MQTT_GetIncomingPacketTypeAndLengthBuffered(
+ *          socket_recv,
+ *          &networkContext,
+ *          &fixedBuffer,
+ *          &index,
+ *          &incomingPacket
+ *      );
+ * } while( ( status == MQTTNoDataAvailable ) || ( status == MQTTNeedMoreBytes ) );
+ *
+ * assert( status == MQTTSuccess );
+ *
+ * // Receive the rest of the incoming packet, if any.
+ * packetSize = incomingPacket.headerLength + incomingPacket.remainingLength;
+ * assert( packetSize <= BUFFER_SIZE );
+ *
+ * while( index < packetSize )
+ * {
+ *     index += socket_recv( &networkContext, &buffer[ index ], packetSize - index );
+ * }
+ *
+ * // Set the remaining data field.
+ * incomingPacket.pRemainingData = &buffer[ incomingPacket.headerLength ];
+ * @endcode
+ */
+/* @[declare_mqtt_getincomingpackettypeandlengthbuffered] */
+MQTTStatus_t MQTT_GetIncomingPacketTypeAndLengthBuffered( TransportRecv_t readFunc,
+                                                          NetworkContext_t * pNetworkContext,
+                                                          const MQTTFixedBuffer_t * pFixedBuffer,
+                                                          size_t * pIndex,
+                                                          MQTTPacketInfo_t * pIncomingPacket );
+/* @[declare_mqtt_getincomingpackettypeandlengthbuffered] */
+
+/**
+ * @brief Split a buffer of raw MQTT stream data into packets.
+ *
+ * The buffer is scanned from the start and an #MQTTPacketInfo_t is written
+ * for every complete packet found in it, with #MQTTPacketInfo_t.pRemainingData
+ * pointing into @p pBuffer. Scanning stops at the first packet that is not
+ * complete, or once @p maxPackets packets have been framed. This does not
+ * need an #MQTTContext_t and makes no transport calls, so it can be used to
+ * frame captured traffic or data forwarded by a bridge.
+ *
+ * @param[in] pBuffer Buffer holding the raw packet stream.
+ * @param[in] bufferLength Number of valid bytes in @p pBuffer.
+ * @param[out] pPackets Array to receive the framed packets.
+ * @param[in] maxPackets Number of entries in @p pPackets.
+ * @param[out] pPacketCount Number of packets written to @p pPackets.
+ * @param[out] pBytesConsumed Offset of the first byte that was not framed,
+ * i.e. the start of the trailing partial packet, or @p bufferLength if all of
+ * the data was framed.
+ *
+ * @return #MQTTSuccess if the buffer was framed up to a partial packet, the
+ * end of the buffer, or @p maxPackets packets;
+ * #MQTTBadParameter if any of the parameters is invalid;
+ * #MQTTBadResponse if an invalid packet is found. The packets before the
+ * invalid one are still reported through @p pPackets and @p pPacketCount.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Packets framed from one chunk of the stream.
+ * MQTTPacketInfo_t packets[ 32 ];
+ * size_t packetCount, consumed, i;
+ * MQTTStatus_t status;
+ *
+ * // pChunk holds chunkLength bytes of MQTT stream.
+ * status = MQTT_FramePackets( pChunk, chunkLength,
+ *                             packets, 32, &packetCount, &consumed );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      for( i = 0; i < packetCount; i++ )
+ *      {
+ *          // Handle packets[ i ].
+ *      }
+ *
+ *      // Move the bytes from pChunk[ consumed ] onwards to the front of the
+ *      // buffer and append more data after them before framing again.
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_framepackets] */
+MQTTStatus_t MQTT_FramePackets( uint8_t * pBuffer,
+                                size_t bufferLength,
+                                MQTTPacketInfo_t * pPackets,
+                                size_t maxPackets,
+                                size_t * pPacketCount,
+                                size_t * pBytesConsumed );
+/* @[declare_mqtt_framepackets] */
+
 /**
  * @brief Update the duplicate publish flag within the given header of the publish packet.
  *
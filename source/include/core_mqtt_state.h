@@ -285,6 +285,47 @@ uint16_t MQTT_PublishToResend( const MQTTContext_t * pMqttContext,
                                MQTTStateCursor_t * pCursor );
 /* @[declare_mqtt_publishtoresend] */
 
+/**
+ * @brief Get a percentile of the latencies recorded in a histogram of the
+ * #MQTTAckLatency_t set up with #MQTT_InitAckLatency.
+ *
+ * The latency reported is the longest of the bucket holding the percentile,
+ * so it is at most 12.5% above the exact percentile, and never above the
+ * longest latency recorded. Like #MQTT_InitAckLatency, this function is only
+ * compiled when #MQTT_METRICS_ENABLED is set to 1.
+ *
+ * @param[in] pHistogram The histogram, such as the `pubAck` member of an
+ * #MQTTAckLatency_t.
+ * @param[in] perMille The percentile in tenths of a percent, such as 500 for
+ * the median, 990 for p99 and 999 for p99.9.
+ * @param[out] pLatencyMs The latency in milliseconds.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTNoDataAvailable if no latency was recorded;
+ * #MQTTSuccess otherwise.
+ */
+/* @[declare_mqtt_getlatencypercentile] */
+MQTTStatus_t MQTT_GetLatencyPercentile( const MQTTLatencyHistogram_t * pHistogram,
+                                        uint32_t perMille,
+                                        uint32_t * pLatencyMs );
+/* @[declare_mqtt_getlatencypercentile] */
+
+/**
+ * @fn void MQTT_RecordLatency( MQTTLatencyHistogram_t * pHistogram, uint32_t latencyMs );
+ * @brief Record a latency in a histogram.
+ *
+ * @param[in] pHistogram The histogram.
+ * @param[in] latencyMs The latency.
+ */
+
+/**
+ * @cond DOXYGEN_IGNORE
+ * Doxygen should ignore this definition, this function is private.
+ */
+void MQTT_RecordLatency( MQTTLatencyHistogram_t * pHistogram,
+                         uint32_t latencyMs );
+/** @endcond */
+
 /**
  * @fn const char * MQTT_State_strerror( MQTTPublishState_t state );
  * @brief State to string conversion for state engine.
@@ -0,0 +1,485 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_subscription.h
+ * @brief User-facing functions for dispatching incoming PUBLISH topic names
+ * to the handlers of the topic filters they match.
+ */
+#ifndef CORE_MQTT_SUBSCRIPTION_H
+#define CORE_MQTT_SUBSCRIPTION_H
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "core_mqtt_serializer.h"
+
+/**
+ * @ingroup mqtt_constants
+ * @brief Value of a handler ID or node index that is not set.
+ */
+#define MQTT_SUBSCRIPTION_NONE    ( ( uint32_t ) 0xFFFFFFFFU )
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A node of a subscription trie, representing one level of the topic
+ * filters added to the trie.
+ *
+ * The members are private to the subscription trie. An array of nodes is
+ * supplied by the application to #MQTT_SubscriptionInit.
+ */
+typedef struct MQTTSubscriptionNode
+{
+    /**
+     * @brief Hash of the level and the parent node.
+     */
+    uint32_t hash;
+
+    /**
+     * @brief Index of the parent node.
+     */
+    uint32_t parent;
+
+    /**
+     * @brief Next node in the same hash bucket, or in the list of free nodes.
+     */
+    uint32_t next;
+
+    /**
+     * @brief Index of the child node for a '+' level.
+     */
+    uint32_t plusChild;
+
+    /**
+     * @brief Number of child nodes, including the '+' child.
+     */
+    uint32_t childCount;
+
+    /**
+     * @brief Handler ID of the topic filter ending at this level.
+     */
+    uint32_t handlerId;
+
+    /**
+     * @brief Handler ID of the topic filter ending with a '#' level after
+     * this level.
+     */
+    uint32_t multiLevelHandlerId;
+
+    /**
+     * @brief Length of the level.
+     */
+    uint16_t levelLength;
+} MQTTSubscriptionNode_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A trie of topic filters, used to find the handlers of all filters
+ * matching a topic name with a single walk over the topic name levels.
+ *
+ * The members are private to the subscription trie and are set with
+ * #MQTT_SubscriptionInit.
+ */
+typedef struct MQTTSubscriptionTrie
+{
+    /**
+     * @brief Nodes of the trie. The first node is the root.
+     */
+    MQTTSubscriptionNode_t * pNodes;
+
+    /**
+     * @brief Storage for the levels of the nodes, the maximum level length
+     * for each node.
+     */
+    char * pLevels;
+
+    /**
+     * @brief Number of nodes in the trie.
+     */
+    size_t nodeCount;
+
+    /**
+     * @brief Maximum length of a topic filter level.
+     */
+    size_t levelLengthMax;
+
+    /**
+     * @brief Hash buckets of the literal levels in the trie, each holding the
+     * index of the first node in the bucket.
+     */
+    uint32_t * pBuckets;
+
+    /**
+     * @brief Number of hash buckets.
+     */
+    size_t bucketCount;
+
+    /**
+     * @brief Index of the first free node.
+     */
+    uint32_t freeNode;
+
+    /**
+     * @brief Number of topic filters in the trie.
+     */
+    size_t filterCount;
+} MQTTSubscriptionTrie_t;
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Kinds of the levels of a compiled topic filter.
+ */
+typedef enum MQTTFilterLevelKind
+{
+    MQTTFilterLevelLiteral,    /**< @brief A level without wildcards. */
+    MQTTFilterLevelSingle,     /**< @brief A '+' level. */
+    MQTTFilterLevelMulti       /**< @brief A '#' level. */
+} MQTTFilterLevelKind_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A level of a compiled topic filter.
+ */
+typedef struct MQTTFilterLevel
+{
+    /**
+     * @brief Index of the first character of the level in the topic filter.
+     */
+    uint16_t offset;
+
+    /**
+     * @brief Length of the level.
+     */
+    uint16_t length;
+
+    /**
+     * @brief Whether the level is a literal or a wildcard.
+     */
+    MQTTFilterLevelKind_t kind;
+} MQTTFilterLevel_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A topic filter split into levels by #MQTT_CompileTopicFilter, for
+ * matching many topic names with #MQTT_MatchCompiledFilter.
+ *
+ * The levels refer to the topic filter string and the level array, which
+ * must both stay valid for as long as the compiled filter is used.
+ */
+typedef struct MQTTCompiledFilter
+{
+    /**
+     * @brief The topic filter.
+     */
+    const char * pTopicFilter;
+
+    /**
+     * @brief Length of the topic filter.
+     */
+    uint16_t topicFilterLength;
+
+    /**
+     * @brief The levels of the topic filter, in an array supplied by the
+     * application.
+     */
+    MQTTFilterLevel_t * pLevels;
+
+    /**
+     * @brief Number of entries used in pLevels.
+     */
+    uint16_t levelCount;
+
+    /**
+     * @brief Number of levels before the first wildcard.
+     */
+    uint16_t prefixLevelCount;
+
+    /**
+     * @brief Length of the levels before the first wildcard, including the
+     * separators between them but not the one after them.
+     */
+    uint16_t prefixLength;
+
+    /**
+     * @brief FNV-1a hash of the first prefixLength characters of the topic
+     * filter.
+     *
+     * Compiled filters with the same prefix length and hash very likely share
+     * their literal prefix, so an application matching a topic name against
+     * many compiled filters can group them by prefix and compare the prefix
+     * once per group.
+     */
+    uint32_t prefixHash;
+} MQTTCompiledFilter_t;
+
+/**
+ * @brief Initialize a subscription trie with memory supplied by the
+ * application.
+ *
+ * Each level of an added topic filter uses one node, unless a filter added
+ * before shares the level and the levels before it. A '#' level does not use
+ * a node. The levels are copied, so the topic filter strings do not need to
+ * stay valid after they are added.
+ *
+ * @param[out] pTrie The trie to initialize.
+ * @param[in] pNodes Array of nodes for the trie.
+ * @param[in] pLevelBuffer Buffer of at least `nodeCount * levelLengthMax`
+ * bytes for the levels of the nodes.
+ * @param[in] nodeCount Number of nodes in @p pNodes, including the root.
+ * @param[in] levelLengthMax Maximum length of a topic filter level.
+ * @param[in] pBuckets Array of hash buckets for finding the children of a node.
+ * @param[in] bucketCount Number of entries in @p pBuckets.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * MQTTSubscriptionTrie_t trie;
+ * MQTTSubscriptionNode_t nodes[ 64 ];
+ * char levels[ 64 * 32 ];
+ * uint32_t buckets[ 32 ];
+ * MQTTStatus_t status;
+ *
+ * status = MQTT_SubscriptionInit( &trie, nodes, levels, 64, 32, buckets, 32 );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      status = MQTT_SubscriptionAdd( &trie, "sensors/+/temperature", 21, 0 );
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_subscriptioninit] */
+MQTTStatus_t MQTT_SubscriptionInit( MQTTSubscriptionTrie_t * pTrie,
+                                    MQTTSubscriptionNode_t * pNodes,
+                                    char * pLevelBuffer,
+                                    size_t nodeCount,
+                                    size_t levelLengthMax,
+                                    uint32_t * pBuckets,
+                                    size_t bucketCount );
+/* @[declare_mqtt_subscriptioninit] */
+
+/**
+ * @brief Add a topic filter and the ID of its handler to a subscription trie.
+ *
+ * If the topic filter is already in the trie, its handler ID is replaced.
+ *
+ * @param[in] pTrie Initialized subscription trie.
+ * @param[in] pTopicFilter The topic filter to add.
+ * @param[in] topicFilterLength Length of @p pTopicFilter.
+ * @param[in] handlerId Application defined ID returned by
+ * #MQTT_SubscriptionMatch for topic names matching the filter. It cannot be
+ * #MQTT_SUBSCRIPTION_NONE.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed, or the topic
+ * filter is invalid or has more than #MQTT_SUBSCRIPTION_LEVELS_MAX levels;
+ * #MQTTNoMemory if the trie has no free nodes left;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Handler IDs could index an array of handler functions.
+ * status = MQTT_SubscriptionAdd( &trie, "sensors/#", 9, 1 );
+ * @endcode
+ */
+/* @[declare_mqtt_subscriptionadd] */
+MQTTStatus_t MQTT_SubscriptionAdd( MQTTSubscriptionTrie_t * pTrie,
+                                   const char * pTopicFilter,
+                                   uint16_t topicFilterLength,
+                                   uint32_t handlerId );
+/* @[declare_mqtt_subscriptionadd] */
+
+/**
+ * @brief Remove a topic filter from a subscription trie.
+ *
+ * The nodes used only by the removed topic filter are freed.
+ *
+ * @param[in] pTrie Initialized subscription trie.
+ * @param[in] pTopicFilter The topic filter to remove.
+ * @param[in] topicFilterLength Length of @p pTopicFilter.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed or the topic
+ * filter is not in the trie;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * status = MQTT_SubscriptionRemove( &trie, "sensors/#", 9 );
+ * @endcode
+ */
+/* @[declare_mqtt_subscriptionremove] */
+MQTTStatus_t MQTT_SubscriptionRemove( MQTTSubscriptionTrie_t * pTrie,
+                                      const char * pTopicFilter,
+                                      uint16_t topicFilterLength );
+/* @[declare_mqtt_subscriptionremove] */
+
+/**
+ * @brief Find the handlers of all topic filters in a subscription trie that
+ * match a topic name.
+ *
+ * The topic name is walked once, with the children of each node found by
+ * hashing, so the time taken depends on the number of levels in the topic
+ * name and on the wildcards in the trie, but not on the number of filters.
+ * Topic filters match by the rules of the MQTT specification. As with
+ * #MQTT_MatchTopic, topic names starting with '$' do not match filters
+ * starting with a wildcard. Unlike #MQTT_MatchTopic, a '+' level matches any
+ * topic name level, including an empty one, and a '#' level also matches the
+ * level before it after a '+' level. So the topic name "a/b" matches
+ * "a/+/#", "a/b/" matches "a/+/+", and "a" matches "+/#", none of which
+ * #MQTT_MatchTopic reports as a match.
+ *
+ * @param[in] pTrie Initialized subscription trie.
+ * @param[in] pTopicName The topic name to match.
+ * @param[in] topicNameLength Length of @p pTopicName.
+ * @param[out] pHandlerIds Array to write the handler IDs of the matching
+ * filters to.
+ * @param[in] handlerIdCount Number of entries in @p pHandlerIds.
+ * @param[out] pMatchCount Number of handler IDs written to @p pHandlerIds.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTNoMemory if more filters match than fit in @p pHandlerIds;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * uint32_t handlerIds[ 8 ];
+ * size_t matchCount = 0, i;
+ *
+ * status = MQTT_SubscriptionMatch( &trie,
+ *                                  pPublishInfo->pTopicName,
+ *                                  pPublishInfo->topicNameLength,
+ *                                  handlerIds,
+ *                                  8,
+ *                                  &matchCount );
+ *
+ * for( i = 0; i < matchCount; i++ )
+ * {
+ *      handlers[ handlerIds[ i ] ]( pPublishInfo );
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_subscriptionmatch] */
+MQTTStatus_t MQTT_SubscriptionMatch( const MQTTSubscriptionTrie_t * pTrie,
+                                     const char * pTopicName,
+                                     uint16_t topicNameLength,
+                                     uint32_t * pHandlerIds,
+                                     size_t handlerIdCount,
+                                     size_t * pMatchCount );
+/* @[declare_mqtt_subscriptionmatch] */
+
+/**
+ * @brief Split a topic filter into a table of levels, so that it can be
+ * matched against topic names without scanning it again.
+ *
+ * The topic filter is validated with the same rules as
+ * #MQTT_SubscriptionAdd. Neither the topic filter nor @p pLevels are copied,
+ * so both must stay valid for as long as @p pCompiledFilter is used.
+ *
+ * @param[in] pTopicFilter The topic filter to compile.
+ * @param[in] topicFilterLength Length of @p pTopicFilter.
+ * @param[in] pLevels Array to store the levels of the topic filter in.
+ * @param[in] levelCountMax Number of entries in @p pLevels.
+ * @param[out] pCompiledFilter The compiled topic filter.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed, or the topic
+ * filter is invalid or has more than @p levelCountMax levels;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * MQTTCompiledFilter_t compiledFilter;
+ * MQTTFilterLevel_t filterLevels[ 8 ];
+ * bool isMatch = false;
+ * MQTTStatus_t status;
+ *
+ * status = MQTT_CompileTopicFilter( "sensors/+/temperature", 21,
+ *                                   filterLevels, 8, &compiledFilter );
+ *
+ * if( status == MQTTSuccess )
+ * {
+ *      status = MQTT_MatchCompiledFilter( pPublishInfo->pTopicName,
+ *                                         pPublishInfo->topicNameLength,
+ *                                         &compiledFilter,
+ *                                         &isMatch );
+ * }
+ * @endcode
+ */
+/* @[declare_mqtt_compiletopicfilter] */
+MQTTStatus_t MQTT_CompileTopicFilter( const char * pTopicFilter,
+                                      uint16_t topicFilterLength,
+                                      MQTTFilterLevel_t * pLevels,
+                                      size_t levelCountMax,
+                                      MQTTCompiledFilter_t * pCompiledFilter );
+/* @[declare_mqtt_compiletopicfilter] */
+
+/**
+ * @brief Check whether a topic name matches a topic filter compiled with
+ * #MQTT_CompileTopicFilter.
+ *
+ * The literal prefix of the filter is compared first with a single `memcmp`,
+ * so topic names that differ from the filter before its first wildcard are
+ * rejected without splitting them into levels. The remaining levels are
+ * compared whole. Topic filters match with the same rules as
+ * #MQTT_SubscriptionMatch.
+ *
+ * @param[in] pTopicName The topic name to match.
+ * @param[in] topicNameLength Length of @p pTopicName.
+ * @param[in] pCompiledFilter The compiled topic filter.
+ * @param[out] pIsMatch Whether the topic name matches the filter.
+ *
+ * @return #MQTTBadParameter if invalid parameters are passed;
+ * #MQTTSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * status = MQTT_MatchCompiledFilter( "sensors/kitchen/temperature", 27,
+ *                                    &compiledFilter, &isMatch );
+ * @endcode
+ */
+/* @[declare_mqtt_matchcompiledfilter] */
+MQTTStatus_t MQTT_MatchCompiledFilter( const char * pTopicName,
+                                       uint16_t topicNameLength,
+                                       const MQTTCompiledFilter_t * pCompiledFilter,
+                                       bool * pIsMatch );
+/* @[declare_mqtt_matchcompiledfilter] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_SUBSCRIPTION_H */
@@ -0,0 +1,442 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_topic_filter.hpp
+ * @brief Header-only C++17 topic filters that are validated and split into
+ * levels at compile time.
+ *
+ * A coremqtt::TopicFilter is the compile-time counterpart of a topic filter
+ * compiled with #MQTT_CompileTopicFilter, and matches topic names with the
+ * same rules as #MQTT_MatchCompiledFilter. Declaring a filter `constexpr`, or
+ * creating it with coremqtt::makeTopicFilter in C++20, turns a misplaced
+ * wildcard into a compile error.
+ *
+ * <b>Example</b>
+ * @code{cpp}
+ *
+ * constexpr auto temperature = coremqtt::makeTopicFilter( "sensors/+/temperature" );
+ * constexpr auto commands = coremqtt::makeTopicFilter( "devices/thing1/commands/#" );
+ *
+ * // Compile error: '#' must be the last level of a topic filter.
+ * // constexpr auto typo = coremqtt::makeTopicFilter( "devices/#/commands" );
+ *
+ * static_assert( temperature.matches( "sensors/kitchen/temperature" ) );
+ *
+ * void handleTopic( std::string_view topicName )
+ * {
+ *     switch( coremqtt::findFirstMatch( topicName, temperature, commands ) )
+ *     {
+ *         case 0:
+ *             // Handle a temperature reading.
+ *             break;
+ *
+ *         case 1:
+ *             // Handle a command.
+ *             break;
+ *
+ *         default:
+ *             // No filter matched.
+ *             break;
+ *     }
+ * }
+ * @endcode
+ */
+#ifndef CORE_MQTT_TOPIC_FILTER_HPP
+#define CORE_MQTT_TOPIC_FILTER_HPP
+
+#if !defined( __cplusplus ) || ( __cplusplus < 201703L )
+    #error "core_mqtt_topic_filter.hpp requires C++17 or later."
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace coremqtt
+{
+    /**
+     * @brief Kind of a level of a coremqtt::TopicFilter, as
+     * #MQTTFilterLevelKind_t.
+     */
+    enum class FilterLevelKind : std::uint8_t
+    {
+        Literal, /**< @brief A level without wildcards. */
+        Single,  /**< @brief A '+' level. */
+        Multi    /**< @brief A '#' level. */
+    };
+
+    /**
+     * @brief A level of a coremqtt::TopicFilter, as #MQTTFilterLevel_t.
+     */
+    struct FilterLevel
+    {
+        std::uint16_t offset = 0U;                      /**< @brief Index of the first character of the level. */
+        std::uint16_t length = 0U;                      /**< @brief Length of the level. */
+        FilterLevelKind kind = FilterLevelKind::Literal; /**< @brief Whether the level is a literal or a wildcard. */
+    };
+
+    /** @cond DO_NOT_DOCUMENT */
+    namespace detail
+    {
+        /* These functions are deliberately not constexpr. Reaching one while a
+         * filter is built in a constant expression is a compile error, and the
+         * compiler names the function in its diagnostic. */
+        inline void multiLevelWildcardIsNotLastLevel() noexcept
+        {
+        }
+
+        inline void wildcardDoesNotOccupyWholeLevel() noexcept
+        {
+        }
+
+        inline void topicFilterContainsNullCharacter() noexcept
+        {
+        }
+
+        constexpr std::size_t getLevelLength( const char * pTopic,
+                                              std::size_t topicLength,
+                                              std::size_t levelStart ) noexcept
+        {
+            std::size_t levelEnd = levelStart;
+
+            while( ( levelEnd < topicLength ) && ( pTopic[ levelEnd ] != '/' ) )
+            {
+                levelEnd++;
+            }
+
+            return levelEnd - levelStart;
+        }
+    }
+    /** @endcond */
+
+    /**
+     * @brief A topic filter split into levels when it is constructed, for
+     * matching topic names without parsing the filter again.
+     *
+     * @tparam N Size of the string literal holding the topic filter,
+     * including its terminating null character.
+     *
+     * A filter constructed in a constant expression with a '#' that is not
+     * the last level, a wildcard sharing a level with other characters, or a
+     * null character does not compile. A filter constructed at run time with
+     * any of these is invalid and matches no topic names.
+     */
+    template< std::size_t N >
+    class TopicFilter
+    {
+        static_assert( N > 1U, "A topic filter cannot be empty." );
+        static_assert( ( N - 1U ) <= UINT16_MAX, "A topic filter must fit in an MQTT string." );
+
+        public:
+
+            /**
+             * @brief Validate a topic filter and split it into levels.
+             *
+             * @param[in] topicFilter String literal holding the topic filter.
+             */
+            constexpr explicit TopicFilter( const char ( &topicFilter )[ N ] ) noexcept
+            {
+                const std::size_t topicFilterLength = N - 1U;
+                std::size_t levelStart = 0U;
+                std::size_t length = 0U;
+                FilterLevelKind kind = FilterLevelKind::Literal;
+                bool lastLevel = false;
+                std::size_t i = 0U;
+
+                for( i = 0U; i < topicFilterLength; i++ )
+                {
+                    filter[ i ] = topicFilter[ i ];
+
+                    if( topicFilter[ i ] == '\0' )
+                    {
+                        detail::topicFilterContainsNullCharacter();
+                        valid = false;
+                    }
+                }
+
+                while( ( valid == true ) && ( lastLevel == false ) )
+                {
+                    length = detail::getLevelLength( filter, topicFilterLength, levelStart );
+                    lastLevel = ( levelStart + length ) == topicFilterLength;
+                    kind = FilterLevelKind::Literal;
+
+                    if( ( length == 1U ) && ( filter[ levelStart ] == '#' ) )
+                    {
+                        kind = FilterLevelKind::Multi;
+
+                        if( lastLevel == false )
+                        {
+                            detail::multiLevelWildcardIsNotLastLevel();
+                            valid = false;
+                        }
+                    }
+                    else if( ( length == 1U ) && ( filter[ levelStart ] == '+' ) )
+                    {
+                        kind = FilterLevelKind::Single;
+                    }
+                    else
+                    {
+                        /* A wildcard must occupy an entire level. */
+                        for( i = levelStart; ( i < ( levelStart + length ) ) && ( valid == true ); i++ )
+                        {
+                            if( ( filter[ i ] == '+' ) || ( filter[ i ] == '#' ) )
+                            {
+                                detail::wildcardDoesNotOccupyWholeLevel();
+                                valid = false;
+                            }
+                        }
+                    }
+
+                    if( valid == true )
+                    {
+                        levels[ levelCount ].offset = static_cast< std::uint16_t >( levelStart );
+                        levels[ levelCount ].length = static_cast< std::uint16_t >( length );
+                        levels[ levelCount ].kind = kind;
+
+                        /* The prefix ends at the first wildcard. */
+                        if( ( kind == FilterLevelKind::Literal ) && ( prefixLevelCount == levelCount ) )
+                        {
+                            prefixLevelCount++;
+                            prefixLength = levelStart + length;
+                        }
+
+                        levelCount++;
+                        levelStart += length + 1U;
+                    }
+                }
+            }
+
+            /**
+             * @brief Whether the topic filter is valid. Always `true` for a
+             * filter constructed in a constant expression.
+             */
+            constexpr bool isValid() const noexcept
+            {
+                return valid;
+            }
+
+            /**
+             * @brief The topic filter, without its terminating null character.
+             */
+            constexpr std::string_view str() const noexcept
+            {
+                return std::string_view( filter, N - 1U );
+            }
+
+            /**
+             * @brief Number of levels of the topic filter.
+             */
+            constexpr std::size_t getLevelCount() const noexcept
+            {
+                return levelCount;
+            }
+
+            /**
+             * @brief A level of the topic filter.
+             *
+             * @param[in] index Index of the level, less than getLevelCount().
+             */
+            constexpr const FilterLevel & getLevel( std::size_t index ) const noexcept
+            {
+                return levels[ index ];
+            }
+
+            /**
+             * @brief Check whether a topic name matches the topic filter.
+             *
+             * The levels before the first wildcard are compared with a single
+             * memory comparison, and only the levels after it are visited one
+             * at a time. Matching uses the same rules as
+             * #MQTT_MatchCompiledFilter.
+             *
+             * @param[in] topicName The topic name to match.
+             *
+             * @return `true` if the topic name matches; `false` if it does not,
+             * if it is empty, or if the topic filter is invalid.
+             */
+            constexpr bool matches( std::string_view topicName ) const noexcept
+            {
+                const char * pTopicName = topicName.data();
+                const std::size_t topicNameLength = topicName.size();
+                std::size_t levelStart = 0U;
+                bool isMatch = ( valid == true ) && ( topicNameLength > 0U );
+
+                if( isMatch == false )
+                {
+                    /* Empty else MISRA 15.7 */
+                }
+                else if( prefixLevelCount == 0U )
+                {
+                    /* Topic names starting with '$' do not match filters
+                     * starting with a wildcard. */
+                    isMatch = ( pTopicName[ 0 ] != '$' );
+                }
+                else if( ( topicNameLength < prefixLength ) ||
+                         ( std::char_traits< char >::compare( pTopicName, filter, prefixLength ) != 0 ) )
+                {
+                    isMatch = false;
+                }
+                else if( topicNameLength == prefixLength )
+                {
+                    /* The prefix matched every level of the topic name. */
+                    levelStart = topicNameLength + 1U;
+                }
+                else if( pTopicName[ prefixLength ] == '/' )
+                {
+                    levelStart = prefixLength + 1U;
+                }
+                else
+                {
+                    /* The last prefix level is only a prefix of the topic name level. */
+                    isMatch = false;
+                }
+
+                if( isMatch == true )
+                {
+                    isMatch = matchLevels( pTopicName, topicNameLength, levelStart );
+                }
+
+                return isMatch;
+            }
+
+        private:
+
+            /**
+             * @brief Match the levels after the prefix, as matchCompiledLevels
+             * in core_mqtt_subscription.c.
+             */
+            constexpr bool matchLevels( const char * pTopicName,
+                                        std::size_t topicNameLength,
+                                        std::size_t levelStart ) const noexcept
+            {
+                std::size_t topicLevelStart = levelStart;
+                std::size_t topicLevelLength = 0U;
+                std::size_t levelIndex = 0U;
+                bool isMatch = true;
+                bool multiLevel = false;
+
+                for( levelIndex = prefixLevelCount;
+                     ( levelIndex < levelCount ) && ( isMatch == true ) && ( multiLevel == false );
+                     levelIndex++ )
+                {
+                    const FilterLevel & level = levels[ levelIndex ];
+
+                    if( level.kind == FilterLevelKind::Multi )
+                    {
+                        /* '#' matches the remaining levels, and also the level
+                         * before it when the topic name has no levels left. */
+                        multiLevel = true;
+                    }
+                    else if( topicLevelStart > topicNameLength )
+                    {
+                        isMatch = false;
+                    }
+                    else
+                    {
+                        topicLevelLength = detail::getLevelLength( pTopicName, topicNameLength, topicLevelStart );
+
+                        if( level.kind == FilterLevelKind::Literal )
+                        {
+                            isMatch = ( topicLevelLength == level.length ) &&
+                                      ( std::char_traits< char >::compare( &( pTopicName[ topicLevelStart ] ),
+                                                                           &( filter[ level.offset ] ),
+                                                                           topicLevelLength ) == 0 );
+                        }
+
+                        topicLevelStart += topicLevelLength + 1U;
+                    }
+                }
+
+                /* Without a '#' level, the filter must use all levels of the topic name. */
+                if( ( isMatch == true ) && ( multiLevel == false ) )
+                {
+                    isMatch = ( topicLevelStart > topicNameLength );
+                }
+
+                return isMatch;
+            }
+
+            char filter[ N ] = {};                         /**< @brief Copy of the topic filter. */
+            std::array< FilterLevel, N > levels = {};      /**< @brief The levels of the topic filter. */
+            std::size_t levelCount = 0U;                   /**< @brief Number of entries used in levels. */
+            std::size_t prefixLevelCount = 0U;             /**< @brief Number of levels before the first wildcard. */
+            std::size_t prefixLength = 0U;                 /**< @brief Length of the levels before the first wildcard. */
+            bool valid = true;                             /**< @brief Whether the topic filter is valid. */
+    };
+
+    /** @cond DO_NOT_DOCUMENT */
+    template< std::size_t N >
+    TopicFilter( const char ( & )[ N ] )->TopicFilter< N >;
+    /** @endcond */
+
+    /**
+     * @brief Create a coremqtt::TopicFilter from a string literal.
+     *
+     * In C++20 the filter is always built at compile time, so an invalid
+     * topic filter is a compile error wherever this function is called. In
+     * C++17 the result must be assigned to a `constexpr` variable for the
+     * same check.
+     *
+     * @param[in] topicFilter String literal holding the topic filter.
+     *
+     * @return The topic filter.
+     */
+    template< std::size_t N >
+    #if defined( __cpp_consteval )
+        consteval
+    #else
+        constexpr
+    #endif
+    TopicFilter< N > makeTopicFilter( const char ( &topicFilter )[ N ] ) noexcept
+    {
+        return TopicFilter< N >( topicFilter );
+    }
+
+    /**
+     * @brief Find the first of a fixed set of topic filters that matches a
+     * topic name.
+     *
+     * @param[in] topicName The topic name to match.
+     * @param[in] filters The topic filters, in the order they are tried.
+     *
+     * @return Index of the first matching filter, or the number of filters if
+     * none match.
+     */
+    template< typename ... Filters >
+    constexpr std::size_t findFirstMatch( std::string_view topicName,
+                                          const Filters & ... filters ) noexcept
+    {
+        std::size_t index = 0U;
+
+        /* The fold stops at the first filter that matches. */
+        ( void ) ( ( filters.matches( topicName ) || ( ++index, false ) ) || ... );
+
+        return index;
+    }
+}
+
+#endif /* ifndef CORE_MQTT_TOPIC_FILTER_HPP */
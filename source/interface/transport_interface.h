@@ -58,6 +58,11 @@
  * - [Transport Receive](@ref TransportRecv_t)
  * - [Transport Send](@ref TransportSend_t)
  *
+ * The functions that may optionally be implemented are:<br>
+ * - [Transport Writev](@ref TransportWritev_t)
+ * - [Transport Wait Readable](@ref TransportWaitReadable_t)
+ * - [Transport Skip](@ref TransportSkip_t)
+ *
  * Each of the functions above take in an opaque context @ref NetworkContext_t.
  * The functions above and the context are also grouped together in the
  * @ref TransportInterface_t structure:<br><br>
@@ -290,17 +295,79 @@ typedef int32_t ( * TransportWritev_t )( NetworkContext_t * pNetworkContext,
                                          size_t ioVecCount );
 /* @[define_transportwritev] */
 
+/**
+ * @transportcallback
+ * @brief Optional transport interface function for waiting until bytes can be
+ * received.
+ *
+ * When the receive function returns zero while coreMQTT waits for the rest of
+ * a packet, or for a CONNACK, coreMQTT calls this function instead of calling
+ * the receive function again at once. It is typically implemented with
+ * `poll` or `select` on the socket, and must also return at once when bytes
+ * are already buffered by the transport, for example by a TLS layer.
+ *
+ * @note coreMQTT only calls this function when built with
+ * #MQTT_TRANSPORT_WAIT_READABLE_ENABLED set to 1. If it is not set, or the
+ * option is disabled, coreMQTT calls the receive function repeatedly until
+ * data arrives or the timeout expires.
+ *
+ * @param[in] pNetworkContext Implementation-defined network context.
+ * @param[in] timeoutMs The most time to wait, in milliseconds.
+ *
+ * @return A positive value if the receive function may return bytes or an
+ * error, zero if the timeout expired, or a negative value to indicate error.
+ * coreMQTT learns of errors from the next call to the receive function.
+ */
+/* @[define_transportwaitreadable] */
+typedef int32_t ( * TransportWaitReadable_t )( NetworkContext_t * pNetworkContext,
+                                               uint32_t timeoutMs );
+/* @[define_transportwaitreadable] */
+
+/**
+ * @transportcallback
+ * @brief Optional transport interface function for discarding received bytes
+ * without copying them.
+ *
+ * coreMQTT calls this to drop the rest of an incoming packet that does not fit
+ * in its network buffer, instead of receiving the bytes into the buffer. It
+ * is typically implemented with `recv` and `MSG_TRUNC` on a TCP socket, or by
+ * moving past bytes already buffered by the transport.
+ *
+ * @note coreMQTT only calls this function when built with
+ * #MQTT_TRANSPORT_SKIP_ENABLED set to 1. If it is not set, or the option is
+ * disabled, coreMQTT receives the bytes to discard into its network buffer.
+ *
+ * @param[in] pNetworkContext Implementation-defined network context.
+ * @param[in] bytesToSkip Number of bytes to discard.
+ *
+ * @return The number of bytes discarded or a negative value to indicate
+ * error. As for #TransportRecv_t, zero means that no bytes are available yet.
+ */
+/* @[define_transportskip] */
+typedef int32_t ( * TransportSkip_t )( NetworkContext_t * pNetworkContext,
+                                       size_t bytesToSkip );
+/* @[define_transportskip] */
+
 /**
  * @transportstruct
  * @brief The transport layer interface.
+ *
+ * @note The optional waitReadable and skip members are last, so that
+ * initializers listing the other members leave them NULL. A structure whose
+ * members are assigned one by one must be zero-initialized first, for example
+ * with `TransportInterface_t transport = { 0 };`, before coreMQTT is built
+ * with #MQTT_TRANSPORT_WAIT_READABLE_ENABLED or #MQTT_TRANSPORT_SKIP_ENABLED
+ * set to 1.
  */
 /* @[define_transportinterface] */
 typedef struct TransportInterface
 {
-    TransportRecv_t recv;               /**< Transport receive function pointer. */
-    TransportSend_t send;               /**< Transport send function pointer. */
-    TransportWritev_t writev;           /**< Transport writev function pointer. */
-    NetworkContext_t * pNetworkContext; /**< Implementation-defined network context. */
+    TransportRecv_t recv;                 /**< Transport receive function pointer. */
+    TransportSend_t send;                 /**< Transport send function pointer. */
+    TransportWritev_t writev;             /**< Transport writev function pointer. */
+    NetworkContext_t * pNetworkContext;   /**< Implementation-defined network context. */
+    TransportWaitReadable_t waitReadable; /**< Optional transport function to wait for bytes to receive, or NULL. */
+    TransportSkip_t skip;                 /**< Optional transport function to discard received bytes, or NULL. */
 } TransportInterface_t;
 /* @[define_transportinterface] */
 
@@ -0,0 +1,191 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_trace_ring.c
+ * @brief Implements the functions in core_mqtt_trace_ring.h.
+ *
+ * A writer claims the next position with an atomic increment of the number
+ * of records written, so writers never wait for each other. Each record
+ * carries the low bits of its position, set last with release ordering, and
+ * cleared before the record changes. A reader copies a record only when the
+ * sequence matches the position it expects before and after the copy, which
+ * tells a whole record from one being overwritten.
+ */
+
+#ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE    200809L
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "core_mqtt_trace_ring.h"
+
+/**
+ * @brief Nanoseconds in a second.
+ */
+#define NANOSECONDS_PER_SECOND    ( 1000000000ULL )
+
+/**
+ * @brief Half of the range of a sequence, used to tell sequences ahead of a
+ * position from those behind it.
+ */
+#define SEQUENCE_HALF_RANGE       ( 0x80000000U )
+
+/*-----------------------------------------------------------*/
+
+MQTTTraceRingStatus_t MQTTTraceRing_Init( MQTTTraceRing_t * pRing,
+                                          MQTTTraceRecord_t * pRecords,
+                                          uint32_t recordCount )
+{
+    MQTTTraceRingStatus_t status = MQTTTraceRingSuccess;
+    uint32_t i;
+
+    if( ( pRing == NULL ) || ( pRecords == NULL ) )
+    {
+        status = MQTTTraceRingBadParameter;
+    }
+    else if( ( recordCount == 0U ) || ( ( recordCount & ( recordCount - 1U ) ) != 0U ) )
+    {
+        /* The position of a record is masked with the record count. */
+        status = MQTTTraceRingBadParameter;
+    }
+    else
+    {
+        for( i = 0U; i < recordCount; i++ )
+        {
+            pRecords[ i ].sequence = 0U;
+        }
+
+        pRing->pRecords = pRecords;
+        pRing->recordCount = recordCount;
+        pRing->written = 0U;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+void MQTTTraceRing_Emit( MQTTTraceRing_t * pRing,
+                         uint8_t event,
+                         const void * pContext,
+                         uint8_t packetType,
+                         uint16_t packetId,
+                         uint32_t bytes,
+                         uint32_t status )
+{
+    struct timespec now;
+    uint64_t position;
+    MQTTTraceRecord_t * pRecord;
+
+    assert( pRing != NULL );
+    assert( pRing->pRecords != NULL );
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    position = __atomic_fetch_add( &( pRing->written ), 1U, __ATOMIC_RELAXED );
+    pRecord = &( pRing->pRecords[ position & ( ( uint64_t ) pRing->recordCount - 1U ) ] );
+
+    /* Mark the record as being written before changing it. */
+    __atomic_store_n( &( pRecord->sequence ), 0U, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    pRecord->timestampNs = ( ( uint64_t ) now.tv_sec * NANOSECONDS_PER_SECOND ) + ( uint64_t ) now.tv_nsec;
+    pRecord->context = ( uint64_t ) ( uintptr_t ) pContext;
+    pRecord->bytes = bytes;
+    pRecord->status = status;
+    pRecord->packetId = packetId;
+    pRecord->packetType = packetType;
+    pRecord->event = event;
+
+    __atomic_store_n( &( pRecord->sequence ), ( uint32_t ) ( position + 1U ), __ATOMIC_RELEASE );
+}
+
+/*-----------------------------------------------------------*/
+
+size_t MQTTTraceRing_Read( MQTTTraceRing_t * pRing,
+                           uint64_t * pCursor,
+                           MQTTTraceRecord_t * pRecords,
+                           size_t maxRecords )
+{
+    size_t count = 0U;
+    uint64_t written;
+    uint64_t cursor;
+    uint32_t expected;
+    uint32_t sequence;
+    const MQTTTraceRecord_t * pRecord;
+    bool recordPending = false;
+
+    if( ( pRing != NULL ) && ( pCursor != NULL ) && ( pRecords != NULL ) )
+    {
+        written = __atomic_load_n( &( pRing->written ), __ATOMIC_ACQUIRE );
+        cursor = *pCursor;
+
+        /* Records further back than the size of the ring were overwritten. */
+        if( ( cursor > written ) || ( ( written - cursor ) > pRing->recordCount ) )
+        {
+            cursor = ( written > pRing->recordCount ) ? ( written - pRing->recordCount ) : 0U;
+        }
+
+        while( ( cursor < written ) && ( count < maxRecords ) && ( recordPending == false ) )
+        {
+            pRecord = &( pRing->pRecords[ cursor & ( ( uint64_t ) pRing->recordCount - 1U ) ] );
+            expected = ( uint32_t ) ( cursor + 1U );
+            sequence = __atomic_load_n( &( pRecord->sequence ), __ATOMIC_ACQUIRE );
+
+            if( sequence == expected )
+            {
+                pRecords[ count ] = *pRecord;
+                __atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+                /* Keep the copy only if no writer changed the record meanwhile. */
+                if( __atomic_load_n( &( pRecord->sequence ), __ATOMIC_RELAXED ) == expected )
+                {
+                    count++;
+                }
+
+                cursor++;
+            }
+            else if( ( sequence != 0U ) && ( ( sequence - expected ) < SEQUENCE_HALF_RANGE ) )
+            {
+                /* A newer record overwrote this one. */
+                cursor++;
+            }
+            else
+            {
+                /* The record is still being written. */
+                recordPending = true;
+            }
+        }
+
+        *pCursor = cursor;
+    }
+
+    return count;
+}
+
+/*-----------------------------------------------------------*/
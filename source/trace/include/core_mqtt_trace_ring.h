@@ -0,0 +1,192 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_trace_ring.h
+ * @brief A backend of #MQTT_TRACE that writes fixed-size binary records into
+ * an in-memory ring.
+ *
+ * Writing a record takes a timestamp from `CLOCK_MONOTONIC`, one atomic
+ * increment and a 32 byte store, with no lock and no formatting, so any
+ * number of threads may trace into the same ring. When the ring is full, the
+ * oldest records are overwritten. A reader copies the records out with
+ * #MQTTTraceRing_Read, for example from a thread that writes them to a file.
+ */
+#ifndef CORE_MQTT_TRACE_RING_H
+#define CORE_MQTT_TRACE_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @brief Write a record for #MQTT_TRACE into a ring.
+ *
+ * @param pRing The #MQTTTraceRing_t.
+ * @param event Name of the #MQTTTraceEvent_t without the `MQTTTrace` prefix.
+ * @param pContext The #MQTTContext_t.
+ * @param packetType First byte of the packet, or 0.
+ * @param packetId Packet identifier, or 0.
+ * @param bytes Bytes of the packet, or as described by the event.
+ * @param status An #MQTTStatus_t, or as described by the event.
+ */
+#define MQTT_TRACE_RING( pRing, event, pContext, packetType, packetId, bytes, status ) \
+    MQTTTraceRing_Emit( ( pRing ),                                                    \
+                        ( uint8_t ) MQTTTrace ## event,                               \
+                        ( pContext ),                                                 \
+                        ( uint8_t ) ( packetType ),                                   \
+                        ( uint16_t ) ( packetId ),                                    \
+                        ( uint32_t ) ( bytes ),                                       \
+                        ( uint32_t ) ( status ) )
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Return codes of the trace ring functions.
+ */
+typedef enum MQTTTraceRingStatus
+{
+    MQTTTraceRingSuccess = 0,   /**< Function completed successfully. */
+    MQTTTraceRingBadParameter   /**< At least one parameter was invalid. */
+} MQTTTraceRingStatus_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A record of a trace ring.
+ */
+typedef struct MQTTTraceRecord
+{
+    uint64_t timestampNs; /**< @brief Time of the event from `CLOCK_MONOTONIC`, in nanoseconds. */
+    uint64_t context;     /**< @brief Address of the #MQTTContext_t. */
+    uint32_t sequence;    /**< @brief Low 32 bits of the position of the record plus one. Used by #MQTTTraceRing_Read to detect overwritten records. */
+    uint32_t bytes;       /**< @brief Bytes of the packet, or as described by the event. */
+    uint32_t status;      /**< @brief An #MQTTStatus_t, or as described by the event. */
+    uint16_t packetId;    /**< @brief Packet identifier, or 0. */
+    uint8_t packetType;   /**< @brief First byte of the packet, or 0. */
+    uint8_t event;        /**< @brief The #MQTTTraceEvent_t. */
+} MQTTTraceRecord_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A ring of trace records.
+ *
+ * The members are private to the trace ring. The records are supplied by the
+ * application.
+ */
+typedef struct MQTTTraceRing
+{
+    MQTTTraceRecord_t * pRecords; /**< @brief The records. */
+    uint32_t recordCount;         /**< @brief Number of records, a power of 2. */
+    uint64_t written;             /**< @brief Number of records ever written. */
+} MQTTTraceRing_t;
+
+/**
+ * @brief Set up a trace ring.
+ *
+ * @param[out] pRing The ring to set up.
+ * @param[in] pRecords The records of the ring, which must stay valid as long
+ * as the ring is used.
+ * @param[in] recordCount Number of records in @p pRecords, a power of 2.
+ *
+ * @return #MQTTTraceRingBadParameter if invalid parameters are passed;
+ * #MQTTTraceRingSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * static MQTTTraceRecord_t traceRecords[ 4096 ];
+ * MQTTTraceRing_t traceRing;
+ * MQTTTraceRecord_t copies[ 64 ];
+ * uint64_t cursor = 0;
+ * size_t count;
+ *
+ * MQTTTraceRing_Init( &traceRing, traceRecords, 4096 );
+ *
+ * // Later, on a thread that saves the records.
+ * count = MQTTTraceRing_Read( &traceRing, &cursor, copies, 64 );
+ * fwrite( copies, sizeof( MQTTTraceRecord_t ), count, traceFile );
+ * @endcode
+ */
+/* @[declare_mqtttracering_init] */
+MQTTTraceRingStatus_t MQTTTraceRing_Init( MQTTTraceRing_t * pRing,
+                                          MQTTTraceRecord_t * pRecords,
+                                          uint32_t recordCount );
+/* @[declare_mqtttracering_init] */
+
+/**
+ * @brief Write a record into a trace ring, overwriting the oldest one if the
+ * ring is full. Use #MQTT_TRACE_RING to call it from #MQTT_TRACE.
+ *
+ * @param[in] pRing The ring.
+ * @param[in] event The #MQTTTraceEvent_t.
+ * @param[in] pContext The #MQTTContext_t.
+ * @param[in] packetType First byte of the packet, or 0.
+ * @param[in] packetId Packet identifier, or 0.
+ * @param[in] bytes Bytes of the packet, or as described by the event.
+ * @param[in] status An #MQTTStatus_t, or as described by the event.
+ */
+/* @[declare_mqtttracering_emit] */
+void MQTTTraceRing_Emit( MQTTTraceRing_t * pRing,
+                         uint8_t event,
+                         const void * pContext,
+                         uint8_t packetType,
+                         uint16_t packetId,
+                         uint32_t bytes,
+                         uint32_t status );
+/* @[declare_mqtttracering_emit] */
+
+/**
+ * @brief Copy the records of a trace ring written since a cursor.
+ *
+ * Records overwritten before they could be copied are skipped, and the
+ * cursor moves past them, so the number of records lost is the distance the
+ * cursor moved minus the number copied. A record still being written is left
+ * for the next call.
+ *
+ * @param[in] pRing The ring.
+ * @param[in,out] pCursor Position of the next record to copy, 0 at first.
+ * @param[out] pRecords The copies.
+ * @param[in] maxRecords Most records to copy.
+ *
+ * @return The number of records copied.
+ */
+/* @[declare_mqtttracering_read] */
+size_t MQTTTraceRing_Read( MQTTTraceRing_t * pRing,
+                           uint64_t * pCursor,
+                           MQTTTraceRecord_t * pRecords,
+                           size_t maxRecords );
+/* @[declare_mqtttracering_read] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_TRACE_RING_H */
@@ -0,0 +1,70 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_trace_usdt.h
+ * @brief A backend of #MQTT_TRACE that places a USDT probe at each
+ * tracepoint, on Linux.
+ *
+ * A probe is a single no-op instruction, with a note in the ELF file giving
+ * the location of its arguments, until a tracer such as bpftrace, perf or
+ * SystemTap attaches to it. The provider is `coremqtt` and each probe is
+ * named after its #MQTTTraceEvent_t without the `MQTTTrace` prefix, with the
+ * context, packet type, packet ID, bytes and status as its arguments.
+ * Including this header in core_mqtt_config.h is enough:
+ * @code{c}
+ * // In core_mqtt_config.h.
+ * #include "core_mqtt_trace_usdt.h"
+ * @endcode
+ *
+ * The probes can then be listed and traced, for example:
+ * @code{sh}
+ * bpftrace -e 'usdt:./app:coremqtt:AckSent { printf( "%p %u\n", arg0, arg2 ); }'
+ * @endcode
+ *
+ * The `<sys/sdt.h>` header comes from the SystemTap SDT development package,
+ * such as `systemtap-sdt-dev` or `systemtap-sdt-devel`. It is only needed at
+ * compile time.
+ */
+#ifndef CORE_MQTT_TRACE_USDT_H
+#define CORE_MQTT_TRACE_USDT_H
+
+#include <sys/sdt.h>
+
+#ifdef MQTT_TRACE
+    #error MQTT_TRACE is already defined. Include only one tracing backend.
+#endif
+
+/**
+ * @brief Place the USDT probe `coremqtt:event`.
+ */
+#define MQTT_TRACE( event, pContext, packetType, packetId, bytes, status ) \
+    DTRACE_PROBE5( coremqtt, event,                                        \
+                   ( pContext ),                                           \
+                   ( uint32_t ) ( packetType ),                            \
+                   ( uint32_t ) ( packetId ),                              \
+                   ( uint32_t ) ( bytes ),                                 \
+                   ( uint32_t ) ( status ) )
+
+#endif /* ifndef CORE_MQTT_TRACE_USDT_H */
@@ -0,0 +1,808 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_posix.c
+ * @brief Implements the functions in core_mqtt_transport_posix.h.
+ */
+
+/* MSG_NOSIGNAL and getaddrinfo are POSIX.1-2008. */
+#ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE    200809L
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "core_mqtt_transport_posix.h"
+
+/* Include config defaults header to get default values of configs. */
+#include "core_mqtt_config_defaults.h"
+
+/**
+ * @brief Number of vectors sent by one call to #PosixTransport_Writev.
+ *
+ * The MQTT library passes at most a few vectors per packet, and sends the
+ * rest on the next call when more are passed.
+ */
+#define WRITEV_VECTOR_COUNT_MAX    ( 16U )
+
+/**
+ * @brief Flags for sending on a socket. A peer that closed the connection
+ * must cause an error, not a SIGPIPE.
+ */
+#ifdef MSG_NOSIGNAL
+    #define SEND_FLAGS    ( MSG_NOSIGNAL )
+#else
+    #define SEND_FLAGS    ( 0 )
+#endif
+
+/**
+ * @brief Size of the buffer that #PosixTransport_Skip reads bytes into when
+ * the socket cannot discard them itself.
+ */
+#define SKIP_BUFFER_SIZE    ( 256U )
+
+/**
+ * @brief Whether `recv` with `MSG_TRUNC` discards the bytes of a TCP socket
+ * without copying them, as it does on Linux.
+ */
+#if defined( __linux__ ) && defined( MSG_TRUNC )
+    #define TRUNC_SKIP_SUPPORTED    ( true )
+    #define TRUNC_FLAGS             ( MSG_TRUNC )
+#else
+    #define TRUNC_SKIP_SUPPORTED    ( false )
+    #define TRUNC_FLAGS             ( 0 )
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the transport of a network context passed to a transport
+ * function.
+ *
+ * @param[in] pNetworkContext Network context set by #PosixTransport_GetInterface.
+ *
+ * @return The transport, or NULL if it is not connected.
+ */
+static PosixTransport_t * getTransport( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Make a socket non-blocking and apply the options of a configuration.
+ *
+ * @param[in] socketDescriptor The socket.
+ * @param[in] pConfig Socket options to apply.
+ *
+ * @return #PosixTransportSocketError if an option could not be set;
+ * #PosixTransportSuccess otherwise.
+ */
+static PosixTransportStatus_t configureSocket( int socketDescriptor,
+                                               const PosixTransportConfig_t * pConfig );
+
+/**
+ * @brief Connect a non-blocking socket to an address, waiting for at most
+ * the configured timeout.
+ *
+ * @param[in] socketDescriptor The non-blocking socket.
+ * @param[in] pAddress The address to connect to.
+ * @param[in] timeoutMs Time to wait for the connection.
+ *
+ * @return `true` if the socket is connected; `false` otherwise.
+ */
+static bool connectWithTimeout( int socketDescriptor,
+                                const struct addrinfo * pAddress,
+                                uint32_t timeoutMs );
+
+/**
+ * @brief Whether a socket is a TCP socket.
+ *
+ * @param[in] socketDescriptor The socket.
+ *
+ * @return `true` for a stream socket of an IPv4 or IPv6 address; `false`
+ * otherwise.
+ */
+static bool isTcpSocket( int socketDescriptor );
+
+/**
+ * @brief Copy bytes already read ahead into a receive buffer.
+ *
+ * @param[in] pTransport The transport.
+ * @param[out] pBuffer The receive buffer, or NULL to drop the bytes.
+ * @param[in] bytesToRecv Size of @p pBuffer.
+ *
+ * @return Number of bytes copied.
+ */
+static size_t copyReadAhead( PosixTransport_t * pTransport,
+                             uint8_t * pBuffer,
+                             size_t bytesToRecv );
+
+/**
+ * @brief Convert the result of a socket call to the value returned by a
+ * transport function.
+ *
+ * @param[in] result Number of bytes transferred, or -1 with errno set.
+ *
+ * @return @p result if bytes were transferred; 0 if the call would block or
+ * was interrupted; -1 otherwise.
+ */
+static int32_t toTransportResult( ssize_t result );
+
+/*-----------------------------------------------------------*/
+
+static PosixTransport_t * getTransport( NetworkContext_t * pNetworkContext )
+{
+    /* PosixTransport_GetInterface stores the transport as the network context. */
+    PosixTransport_t * pTransport = ( PosixTransport_t * ) pNetworkContext;
+
+    if( ( pTransport != NULL ) && ( pTransport->socketDescriptor < 0 ) )
+    {
+        LogError( ( "The POSIX transport is not connected." ) );
+        pTransport = NULL;
+    }
+
+    return pTransport;
+}
+
+/*-----------------------------------------------------------*/
+
+static PosixTransportStatus_t configureSocket( int socketDescriptor,
+                                               const PosixTransportConfig_t * pConfig )
+{
+    PosixTransportStatus_t status = PosixTransportSuccess;
+    int flags;
+    int option;
+
+    assert( socketDescriptor >= 0 );
+    assert( pConfig != NULL );
+
+    flags = fcntl( socketDescriptor, F_GETFL, 0 );
+
+    if( ( flags < 0 ) || ( fcntl( socketDescriptor, F_SETFL, flags | O_NONBLOCK ) < 0 ) )
+    {
+        LogError( ( "Failed to make the socket non-blocking: errno=%d", errno ) );
+        status = PosixTransportSocketError;
+    }
+
+    if( ( status == PosixTransportSuccess ) && ( pConfig->noDelay == true ) )
+    {
+        option = 1;
+
+        if( setsockopt( socketDescriptor, IPPROTO_TCP, TCP_NODELAY, &option, sizeof( option ) ) < 0 )
+        {
+            LogError( ( "Failed to set TCP_NODELAY: errno=%d", errno ) );
+            status = PosixTransportSocketError;
+        }
+    }
+
+    if( ( status == PosixTransportSuccess ) && ( pConfig->sendBufferSize > 0 ) )
+    {
+        option = ( int ) pConfig->sendBufferSize;
+
+        if( setsockopt( socketDescriptor, SOL_SOCKET, SO_SNDBUF, &option, sizeof( option ) ) < 0 )
+        {
+            LogError( ( "Failed to set SO_SNDBUF to %d: errno=%d", option, errno ) );
+            status = PosixTransportSocketError;
+        }
+    }
+
+    if( ( status == PosixTransportSuccess ) && ( pConfig->recvBufferSize > 0 ) )
+    {
+        option = ( int ) pConfig->recvBufferSize;
+
+        if( setsockopt( socketDescriptor, SOL_SOCKET, SO_RCVBUF, &option, sizeof( option ) ) < 0 )
+        {
+            LogError( ( "Failed to set SO_RCVBUF to %d: errno=%d", option, errno ) );
+            status = PosixTransportSocketError;
+        }
+    }
+
+    #ifdef SO_NOSIGPIPE
+        if( status == PosixTransportSuccess )
+        {
+            option = 1;
+
+            if( setsockopt( socketDescriptor, SOL_SOCKET, SO_NOSIGPIPE, &option, sizeof( option ) ) < 0 )
+            {
+                LogError( ( "Failed to set SO_NOSIGPIPE: errno=%d", errno ) );
+                status = PosixTransportSocketError;
+            }
+        }
+    #endif
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool connectWithTimeout( int socketDescriptor,
+                                const struct addrinfo * pAddress,
+                                uint32_t timeoutMs )
+{
+    struct pollfd pollDescriptor;
+    int socketError = 0;
+    socklen_t socketErrorLength = sizeof( socketError );
+    bool connected = false;
+
+    assert( pAddress != NULL );
+
+    if( connect( socketDescriptor, pAddress->ai_addr, pAddress->ai_addrlen ) == 0 )
+    {
+        connected = true;
+    }
+    else if( errno == EINPROGRESS )
+    {
+        pollDescriptor.fd = socketDescriptor;
+        pollDescriptor.events = POLLOUT;
+        pollDescriptor.revents = 0;
+
+        /* The socket is writable once the connection succeeded or failed. */
+        if( ( poll( &pollDescriptor, 1U, ( timeoutMs > ( uint32_t ) INT_MAX ) ? INT_MAX : ( int ) timeoutMs ) == 1 ) &&
+            ( getsockopt( socketDescriptor, SOL_SOCKET, SO_ERROR, &socketError, &socketErrorLength ) == 0 ) &&
+            ( socketError == 0 ) )
+        {
+            connected = true;
+        }
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return connected;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool isTcpSocket( int socketDescriptor )
+{
+    struct sockaddr_storage address;
+    socklen_t addressLength = sizeof( address );
+    int socketType = 0;
+    socklen_t socketTypeLength = sizeof( socketType );
+    bool isTcp = false;
+
+    if( ( getsockname( socketDescriptor, ( struct sockaddr * ) &address, &addressLength ) == 0 ) &&
+        ( ( address.ss_family == AF_INET ) || ( address.ss_family == AF_INET6 ) ) &&
+        ( getsockopt( socketDescriptor, SOL_SOCKET, SO_TYPE, &socketType, &socketTypeLength ) == 0 ) &&
+        ( socketType == SOCK_STREAM ) )
+    {
+        isTcp = true;
+    }
+
+    return isTcp;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t copyReadAhead( PosixTransport_t * pTransport,
+                             uint8_t * pBuffer,
+                             size_t bytesToRecv )
+{
+    size_t bytesCopied = pTransport->readAheadEnd - pTransport->readAheadStart;
+
+    if( bytesCopied > bytesToRecv )
+    {
+        bytesCopied = bytesToRecv;
+    }
+
+    if( bytesCopied > 0U )
+    {
+        if( pBuffer != NULL )
+        {
+            ( void ) memcpy( pBuffer, &( pTransport->pReadAhead[ pTransport->readAheadStart ] ), bytesCopied );
+        }
+
+        pTransport->readAheadStart += bytesCopied;
+    }
+
+    return bytesCopied;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t toTransportResult( ssize_t result )
+{
+    int32_t transportResult = -1;
+
+    if( result >= 0 )
+    {
+        transportResult = ( int32_t ) result;
+    }
+    else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) )
+    {
+        transportResult = 0;
+    }
+    else
+    {
+        LogError( ( "Socket call failed: errno=%d", errno ) );
+    }
+
+    return transportResult;
+}
+
+/*-----------------------------------------------------------*/
+
+PosixTransportStatus_t PosixTransport_Connect( PosixTransport_t * pTransport,
+                                               const char * pHostName,
+                                               uint16_t port,
+                                               const PosixTransportConfig_t * pConfig )
+{
+    PosixTransportStatus_t status = PosixTransportSuccess;
+    struct addrinfo hints;
+    struct addrinfo * pAddresses = NULL;
+    const struct addrinfo * pAddress;
+    char portString[ 6 ];
+    int socketDescriptor = -1;
+
+    if( ( pTransport == NULL ) || ( pHostName == NULL ) || ( pConfig == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pHostName=%p, pConfig=%p",
+                    ( void * ) pTransport,
+                    ( const void * ) pHostName,
+                    ( const void * ) pConfig ) );
+        status = PosixTransportBadParameter;
+    }
+    else
+    {
+        ( void ) memset( &hints, 0, sizeof( hints ) );
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+        ( void ) snprintf( portString, sizeof( portString ), "%u", ( unsigned int ) port );
+
+        if( getaddrinfo( pHostName, portString, &hints, &pAddresses ) != 0 )
+        {
+            LogError( ( "Failed to resolve %s.", pHostName ) );
+            status = PosixTransportDnsFailure;
+        }
+    }
+
+    if( status == PosixTransportSuccess )
+    {
+        status = PosixTransportConnectFailure;
+
+        /* A socket that cannot be created or configured for one address, for
+         * example of an address family the host does not support, fails only
+         * that address, and the next one is tried. */
+        for( pAddress = pAddresses;
+             ( pAddress != NULL ) && ( status != PosixTransportSuccess );
+             pAddress = pAddress->ai_next )
+        {
+            socketDescriptor = socket( pAddress->ai_family, pAddress->ai_socktype, pAddress->ai_protocol );
+
+            if( socketDescriptor < 0 )
+            {
+                LogWarn( ( "Failed to create a socket for an address of %s: errno=%d", pHostName, errno ) );
+            }
+            else
+            {
+                status = configureSocket( socketDescriptor, pConfig );
+
+                if( ( status == PosixTransportSuccess ) &&
+                    ( connectWithTimeout( socketDescriptor, pAddress, pConfig->connectTimeoutMs ) == false ) )
+                {
+                    LogWarn( ( "Failed to connect to an address of %s.", pHostName ) );
+                    status = PosixTransportConnectFailure;
+                }
+
+                if( status != PosixTransportSuccess )
+                {
+                    ( void ) close( socketDescriptor );
+                    socketDescriptor = -1;
+                    status = PosixTransportConnectFailure;
+                }
+            }
+        }
+
+        freeaddrinfo( pAddresses );
+    }
+
+    if( status == PosixTransportSuccess )
+    {
+        status = PosixTransport_Attach( pTransport, socketDescriptor, pConfig );
+
+        if( status != PosixTransportSuccess )
+        {
+            ( void ) close( socketDescriptor );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+PosixTransportStatus_t PosixTransport_Attach( PosixTransport_t * pTransport,
+                                              int socketDescriptor,
+                                              const PosixTransportConfig_t * pConfig )
+{
+    PosixTransportStatus_t status = PosixTransportSuccess;
+
+    if( ( pTransport == NULL ) || ( pConfig == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pConfig=%p",
+                    ( void * ) pTransport,
+                    ( const void * ) pConfig ) );
+        status = PosixTransportBadParameter;
+    }
+    else if( socketDescriptor < 0 )
+    {
+        LogError( ( "Invalid parameter: socketDescriptor=%d", socketDescriptor ) );
+        status = PosixTransportBadParameter;
+    }
+    else if( ( pConfig->pReadAheadBuffer == NULL ) != ( pConfig->readAheadBufferSize == 0U ) )
+    {
+        LogError( ( "A read-ahead buffer must have a non-zero size: "
+                    "pReadAheadBuffer=%p, readAheadBufferSize=%lu",
+                    ( void * ) pConfig->pReadAheadBuffer,
+                    ( unsigned long ) pConfig->readAheadBufferSize ) );
+        status = PosixTransportBadParameter;
+    }
+    else
+    {
+        status = configureSocket( socketDescriptor, pConfig );
+    }
+
+    if( status == PosixTransportSuccess )
+    {
+        pTransport->socketDescriptor = socketDescriptor;
+        pTransport->pReadAhead = pConfig->pReadAheadBuffer;
+        pTransport->readAheadSize = pConfig->readAheadBufferSize;
+        pTransport->readAheadStart = 0U;
+        pTransport->readAheadEnd = 0U;
+        pTransport->skipWithTrunc = ( TRUNC_SKIP_SUPPORTED == true ) && isTcpSocket( socketDescriptor );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+PosixTransportStatus_t PosixTransport_Disconnect( PosixTransport_t * pTransport )
+{
+    PosixTransportStatus_t status = PosixTransportSuccess;
+
+    if( pTransport == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pTransport=%p", ( void * ) pTransport ) );
+        status = PosixTransportBadParameter;
+    }
+    else
+    {
+        if( pTransport->socketDescriptor >= 0 )
+        {
+            ( void ) shutdown( pTransport->socketDescriptor, SHUT_RDWR );
+            ( void ) close( pTransport->socketDescriptor );
+        }
+
+        pTransport->socketDescriptor = -1;
+        pTransport->readAheadStart = 0U;
+        pTransport->readAheadEnd = 0U;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+void PosixTransport_GetInterface( PosixTransport_t * pTransport,
+                                  TransportInterface_t * pTransportInterface )
+{
+    if( ( pTransport == NULL ) || ( pTransportInterface == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pTransportInterface=%p",
+                    ( void * ) pTransport,
+                    ( void * ) pTransportInterface ) );
+    }
+    else
+    {
+        pTransportInterface->recv = PosixTransport_Recv;
+        pTransportInterface->send = PosixTransport_Send;
+        pTransportInterface->writev = PosixTransport_Writev;
+        pTransportInterface->waitReadable = PosixTransport_WaitReadable;
+        pTransportInterface->skip = PosixTransport_Skip;
+        pTransportInterface->pNetworkContext = ( NetworkContext_t * ) pTransport;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t PosixTransport_Recv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+{
+    PosixTransport_t * pTransport = getTransport( pNetworkContext );
+    uint8_t * pBytes = ( uint8_t * ) pBuffer;
+    size_t bytesRequested = bytesToRecv;
+    size_t bytesCopied = 0U;
+    struct iovec ioVectors[ 2 ];
+    int ioVectorCount = 1;
+    ssize_t bytesRead;
+    int32_t result = 0;
+
+    /* The number of bytes returned must fit in the return value. */
+    if( bytesRequested > ( size_t ) INT32_MAX )
+    {
+        bytesRequested = ( size_t ) INT32_MAX;
+    }
+
+    if( ( pTransport == NULL ) || ( pBuffer == NULL ) || ( bytesRequested == 0U ) )
+    {
+        result = -1;
+    }
+    else
+    {
+        bytesCopied = copyReadAhead( pTransport, pBytes, bytesRequested );
+    }
+
+    if( ( result == 0 ) && ( bytesCopied < bytesRequested ) )
+    {
+        /* The read-ahead buffer is empty, so it can be refilled by the same
+         * call that reads the rest of the requested bytes. */
+        ioVectors[ 0 ].iov_base = &( pBytes[ bytesCopied ] );
+        ioVectors[ 0 ].iov_len = bytesRequested - bytesCopied;
+
+        if( pTransport->pReadAhead != NULL )
+        {
+            ioVectors[ 1 ].iov_base = pTransport->pReadAhead;
+            ioVectors[ 1 ].iov_len = pTransport->readAheadSize;
+            ioVectorCount = 2;
+        }
+
+        bytesRead = readv( pTransport->socketDescriptor, ioVectors, ioVectorCount );
+
+        if( bytesRead == 0 )
+        {
+            /* The peer closed the connection. Return the bytes copied, and the
+             * error on the next call. */
+            result = ( bytesCopied > 0U ) ? 0 : -1;
+        }
+        else if( bytesRead > ( ssize_t ) ioVectors[ 0 ].iov_len )
+        {
+            pTransport->readAheadStart = 0U;
+            pTransport->readAheadEnd = ( size_t ) bytesRead - ioVectors[ 0 ].iov_len;
+            bytesCopied = bytesRequested;
+        }
+        else if( bytesRead > 0 )
+        {
+            bytesCopied += ( size_t ) bytesRead;
+        }
+        else if( bytesCopied == 0U )
+        {
+            result = toTransportResult( bytesRead );
+        }
+        else
+        {
+            /* Return the bytes copied. A lasting error is returned by the
+             * next call. */
+        }
+    }
+
+    if( result == 0 )
+    {
+        result = ( int32_t ) bytesCopied;
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t PosixTransport_Send( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend )
+{
+    PosixTransport_t * pTransport = getTransport( pNetworkContext );
+    size_t bytesRequested = bytesToSend;
+    int32_t result = -1;
+
+    if( bytesRequested > ( size_t ) INT32_MAX )
+    {
+        bytesRequested = ( size_t ) INT32_MAX;
+    }
+
+    if( ( pTransport != NULL ) && ( pBuffer != NULL ) )
+    {
+        result = toTransportResult( send( pTransport->socketDescriptor, pBuffer,
+                                          bytesRequested, SEND_FLAGS ) );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t PosixTransport_Writev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount )
+{
+    PosixTransport_t * pTransport = getTransport( pNetworkContext );
+    struct iovec ioVectors[ WRITEV_VECTOR_COUNT_MAX ];
+    struct msghdr message;
+    size_t vectorCount = 0U;
+    size_t bytesToSend = 0U;
+    size_t vectorLength;
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pIoVec != NULL ) )
+    {
+        /* TransportOutVector_t points to const data, so it is copied rather
+         * than cast to struct iovec. Vectors past the maximum, or past the
+         * number of bytes that fit in the return value, are sent on the next
+         * call. */
+        while( ( vectorCount < ioVecCount ) &&
+               ( vectorCount < WRITEV_VECTOR_COUNT_MAX ) &&
+               ( bytesToSend < ( size_t ) INT32_MAX ) )
+        {
+            vectorLength = pIoVec[ vectorCount ].iov_len;
+
+            if( vectorLength > ( ( size_t ) INT32_MAX - bytesToSend ) )
+            {
+                vectorLength = ( size_t ) INT32_MAX - bytesToSend;
+            }
+
+            ioVectors[ vectorCount ].iov_base = ( void * ) pIoVec[ vectorCount ].iov_base;
+            ioVectors[ vectorCount ].iov_len = vectorLength;
+            bytesToSend += vectorLength;
+            vectorCount++;
+        }
+
+        /* sendmsg is writev with flags, so that a closed peer cannot raise
+         * SIGPIPE. */
+        ( void ) memset( &message, 0, sizeof( message ) );
+        message.msg_iov = ioVectors;
+        message.msg_iovlen = vectorCount;
+
+        result = toTransportResult( sendmsg( pTransport->socketDescriptor, &message, SEND_FLAGS ) );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t PosixTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs )
+{
+    PosixTransport_t * pTransport = getTransport( pNetworkContext );
+    struct pollfd pollDescriptor;
+    int pollResult;
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pTransport->readAheadStart != pTransport->readAheadEnd ) )
+    {
+        result = 1;
+    }
+    else if( pTransport != NULL )
+    {
+        pollDescriptor.fd = pTransport->socketDescriptor;
+        pollDescriptor.events = POLLIN;
+        pollDescriptor.revents = 0;
+
+        /* A closed or failed socket is also readable. */
+        pollResult = poll( &pollDescriptor, 1U, ( timeoutMs > ( uint32_t ) INT_MAX ) ? INT_MAX : ( int ) timeoutMs );
+
+        if( pollResult >= 0 )
+        {
+            result = ( int32_t ) pollResult;
+        }
+        else if( errno == EINTR )
+        {
+            result = 0;
+        }
+        else
+        {
+            LogError( ( "poll failed: errno=%d", errno ) );
+        }
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t PosixTransport_Skip( NetworkContext_t * pNetworkContext,
+                             size_t bytesToSkip )
+{
+    PosixTransport_t * pTransport = getTransport( pNetworkContext );
+    uint8_t skipBuffer[ SKIP_BUFFER_SIZE ];
+    size_t bytesRequested = bytesToSkip;
+    size_t bytesSkipped = 0U;
+    size_t bytesToRead;
+    ssize_t bytesRead;
+    int32_t result = 0;
+
+    if( bytesRequested > ( size_t ) INT32_MAX )
+    {
+        bytesRequested = ( size_t ) INT32_MAX;
+    }
+
+    if( ( pTransport == NULL ) || ( bytesRequested == 0U ) )
+    {
+        result = -1;
+    }
+    else
+    {
+        bytesSkipped = copyReadAhead( pTransport, NULL, bytesRequested );
+    }
+
+    if( ( result == 0 ) && ( bytesSkipped < bytesRequested ) )
+    {
+        bytesToRead = bytesRequested - bytesSkipped;
+
+        if( pTransport->skipWithTrunc == true )
+        {
+            /* The kernel drops the bytes without copying them. */
+            bytesRead = recv( pTransport->socketDescriptor, NULL, bytesToRead, TRUNC_FLAGS );
+        }
+        else
+        {
+            bytesRead = recv( pTransport->socketDescriptor, skipBuffer,
+                              ( bytesToRead < sizeof( skipBuffer ) ) ? bytesToRead : sizeof( skipBuffer ), 0 );
+        }
+
+        if( bytesRead == 0 )
+        {
+            /* The peer closed the connection. */
+            result = ( bytesSkipped > 0U ) ? 0 : -1;
+        }
+        else if( bytesRead > 0 )
+        {
+            bytesSkipped += ( size_t ) bytesRead;
+        }
+        else if( bytesSkipped == 0U )
+        {
+            result = toTransportResult( bytesRead );
+        }
+        else
+        {
+            /* Return the bytes skipped. A lasting error is returned by the
+             * next call. */
+        }
+    }
+
+    if( result == 0 )
+    {
+        result = ( int32_t ) bytesSkipped;
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
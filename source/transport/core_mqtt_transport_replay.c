@@ -0,0 +1,705 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_replay.c
+ * @brief Implementation of the recording and replay transports.
+ */
+
+#ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE    200809L
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "core_mqtt_transport_replay.h"
+
+/* Include config defaults header to get default values of configs. */
+#include "core_mqtt_config_defaults.h"
+
+/**
+ * @brief Bytes starting a recording.
+ */
+#define RECORDING_MAGIC            "CMQR"
+
+/**
+ * @brief Version of the recording format.
+ */
+#define RECORDING_VERSION          ( 1U )
+
+/**
+ * @brief Size of the header of a recording: the magic and the version.
+ */
+#define RECORDING_HEADER_SIZE      ( 8U )
+
+/**
+ * @brief Size of the header of a record: the time and the number of bytes.
+ */
+#define RECORD_HEADER_SIZE         ( 12U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read the monotonic clock.
+ *
+ * @return The time in nanoseconds.
+ */
+static uint64_t getTimeNs( void );
+
+/**
+ * @brief Encode an integer in little endian order.
+ *
+ * @param[out] pBytes Where to write the bytes.
+ * @param[in] value The integer.
+ * @param[in] size Number of bytes of the integer.
+ */
+static void encodeLittleEndian( uint8_t * pBytes,
+                                uint64_t value,
+                                size_t size );
+
+/**
+ * @brief Decode an integer in little endian order.
+ *
+ * @param[in] pBytes The bytes of the integer.
+ * @param[in] size Number of bytes of the integer.
+ *
+ * @return The integer.
+ */
+static uint64_t decodeLittleEndian( const uint8_t * pBytes,
+                                    size_t size );
+
+/**
+ * @brief Write every byte of some vectors to a file descriptor.
+ *
+ * @param[in] fileDescriptor Where to write.
+ * @param[in] pVectors The vectors, which are advanced past the bytes written.
+ * @param[in] vectorCount Number of vectors.
+ *
+ * @return true if every byte was written; false otherwise.
+ */
+static bool writeAll( int fileDescriptor,
+                      struct iovec * pVectors,
+                      int vectorCount );
+
+/**
+ * @brief Get the recorder of a network context passed to a recorder
+ * function.
+ *
+ * @param[in] pNetworkContext Network context set by
+ * #ReplayRecorder_GetInterface.
+ *
+ * @return The recorder, or NULL if it was not started.
+ */
+static ReplayRecorder_t * getRecorder( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Get the transport of a network context passed to a replay function.
+ *
+ * @param[in] pNetworkContext Network context set by
+ * #ReplayTransport_GetInterface.
+ *
+ * @return The transport, or NULL if it was not opened.
+ */
+static ReplayTransport_t * getReplay( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Start the next record if the current one has been received and the
+ * next one is due.
+ *
+ * @param[in] pTransport The transport.
+ * @param[out] pDueNs When the next record is due, if it is not due yet.
+ *
+ * @return true if bytes of a record can be received; false otherwise.
+ */
+static bool startRecord( ReplayTransport_t * pTransport,
+                         uint64_t * pDueNs );
+
+/**
+ * @brief Take bytes of the current record.
+ *
+ * @param[in] pTransport The transport.
+ * @param[out] pBuffer Buffer to copy the bytes into, or NULL to drop them.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes taken, or 0 if none can be received.
+ */
+static int32_t takeRecord( ReplayTransport_t * pTransport,
+                           uint8_t * pBuffer,
+                           size_t bytesToRecv );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t getTimeNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static void encodeLittleEndian( uint8_t * pBytes,
+                                uint64_t value,
+                                size_t size )
+{
+    size_t i;
+
+    for( i = 0U; i < size; i++ )
+    {
+        pBytes[ i ] = ( uint8_t ) ( value >> ( 8U * i ) );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t decodeLittleEndian( const uint8_t * pBytes,
+                                    size_t size )
+{
+    uint64_t value = 0U;
+    size_t i;
+
+    for( i = size; i > 0U; i-- )
+    {
+        value = ( value << 8U ) | pBytes[ i - 1U ];
+    }
+
+    return value;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool writeAll( int fileDescriptor,
+                      struct iovec * pVectors,
+                      int vectorCount )
+{
+    ssize_t written;
+    bool success = true;
+
+    while( ( success == true ) && ( vectorCount > 0 ) )
+    {
+        written = writev( fileDescriptor, pVectors, vectorCount );
+
+        if( written < 0 )
+        {
+            success = ( errno == EINTR );
+            written = 0;
+        }
+
+        /* Move past the vectors written, and into a vector written in part. */
+        while( ( vectorCount > 0 ) && ( ( size_t ) written >= pVectors->iov_len ) )
+        {
+            written -= ( ssize_t ) pVectors->iov_len;
+            pVectors++;
+            vectorCount--;
+        }
+
+        if( vectorCount > 0 )
+        {
+            pVectors->iov_base = &( ( ( uint8_t * ) pVectors->iov_base )[ written ] );
+            pVectors->iov_len -= ( size_t ) written;
+        }
+    }
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+static ReplayRecorder_t * getRecorder( NetworkContext_t * pNetworkContext )
+{
+    /* ReplayRecorder_GetInterface stores the recorder as the network
+     * context. */
+    ReplayRecorder_t * pRecorder = ( ReplayRecorder_t * ) pNetworkContext;
+
+    if( ( pRecorder != NULL ) && ( pRecorder->transport.recv == NULL ) )
+    {
+        LogError( ( "The recorder is not started." ) );
+        pRecorder = NULL;
+    }
+
+    return pRecorder;
+}
+
+/*-----------------------------------------------------------*/
+
+static ReplayTransport_t * getReplay( NetworkContext_t * pNetworkContext )
+{
+    /* ReplayTransport_GetInterface stores the transport as the network
+     * context. */
+    ReplayTransport_t * pTransport = ( ReplayTransport_t * ) pNetworkContext;
+
+    if( ( pTransport != NULL ) && ( pTransport->pRecording == NULL ) )
+    {
+        LogError( ( "The replay transport is not open." ) );
+        pTransport = NULL;
+    }
+
+    return pTransport;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool startRecord( ReplayTransport_t * pTransport,
+                         uint64_t * pDueNs )
+{
+    const uint8_t * pRecord;
+    uint64_t dueNs;
+
+    /* Skip empty records, and records only start when the last one has been
+     * received, so each call of the receive function ends with a record. */
+    while( ( pTransport->chunkRemaining == 0U ) && ( pTransport->nextRecord < pTransport->recordingLength ) )
+    {
+        pRecord = &( pTransport->pRecording[ pTransport->nextRecord ] );
+        dueNs = pTransport->startNs + decodeLittleEndian( pRecord, 8U );
+
+        if( ( pTransport->paced == true ) && ( getTimeNs() < dueNs ) )
+        {
+            *pDueNs = dueNs;
+            break;
+        }
+
+        /* ReplayTransport_Open checked that every record fits. */
+        pTransport->chunkRemaining = ( size_t ) decodeLittleEndian( &( pRecord[ 8 ] ), 4U );
+        pTransport->pChunk = &( pRecord[ RECORD_HEADER_SIZE ] );
+        pTransport->nextRecord += RECORD_HEADER_SIZE + pTransport->chunkRemaining;
+    }
+
+    return pTransport->chunkRemaining > 0U;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t takeRecord( ReplayTransport_t * pTransport,
+                           uint8_t * pBuffer,
+                           size_t bytesToRecv )
+{
+    uint64_t dueNs = 0U;
+    size_t length = 0U;
+
+    if( startRecord( pTransport, &dueNs ) == true )
+    {
+        length = ( bytesToRecv < pTransport->chunkRemaining ) ? bytesToRecv : pTransport->chunkRemaining;
+        length = ( length > ( size_t ) INT32_MAX ) ? ( size_t ) INT32_MAX : length;
+
+        if( pBuffer != NULL )
+        {
+            ( void ) memcpy( pBuffer, pTransport->pChunk, length );
+        }
+
+        pTransport->pChunk = &( pTransport->pChunk[ length ] );
+        pTransport->chunkRemaining -= length;
+    }
+
+    return ( int32_t ) length;
+}
+
+/*-----------------------------------------------------------*/
+
+ReplayTransportStatus_t ReplayRecorder_Start( ReplayRecorder_t * pRecorder,
+                                              const TransportInterface_t * pTransport,
+                                              int fileDescriptor )
+{
+    ReplayTransportStatus_t status = ReplayTransportSuccess;
+    uint8_t header[ RECORDING_HEADER_SIZE ];
+    struct iovec vector;
+
+    if( ( pRecorder == NULL ) || ( pTransport == NULL ) || ( fileDescriptor < 0 ) )
+    {
+        LogError( ( "Arguments cannot be NULL or negative: pRecorder=%p, pTransport=%p, fileDescriptor=%d",
+                    ( void * ) pRecorder,
+                    ( void * ) pTransport,
+                    fileDescriptor ) );
+        status = ReplayTransportBadParameter;
+    }
+    else if( ( pTransport->recv == NULL ) || ( pTransport->send == NULL ) )
+    {
+        LogError( ( "The recorded transport must have receive and send functions." ) );
+        status = ReplayTransportBadParameter;
+    }
+    else
+    {
+        ( void ) memset( pRecorder, 0, sizeof( *pRecorder ) );
+
+        ( void ) memcpy( header, RECORDING_MAGIC, 4U );
+        encodeLittleEndian( &( header[ 4 ] ), RECORDING_VERSION, 4U );
+        vector.iov_base = header;
+        vector.iov_len = sizeof( header );
+
+        if( writeAll( fileDescriptor, &vector, 1 ) == false )
+        {
+            LogError( ( "Writing the header of the recording failed: errno=%d", errno ) );
+            status = ReplayTransportSystemError;
+        }
+        else
+        {
+            pRecorder->transport = *pTransport;
+            pRecorder->fileDescriptor = fileDescriptor;
+            pRecorder->startNs = getTimeNs();
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+void ReplayRecorder_GetInterface( ReplayRecorder_t * pRecorder,
+                                  TransportInterface_t * pTransportInterface )
+{
+    if( ( pRecorder == NULL ) || ( pTransportInterface == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pRecorder=%p, pTransportInterface=%p",
+                    ( void * ) pRecorder,
+                    ( void * ) pTransportInterface ) );
+    }
+    else
+    {
+        pTransportInterface->recv = ReplayRecorder_Recv;
+        pTransportInterface->send = ReplayRecorder_Send;
+        pTransportInterface->writev = ( pRecorder->transport.writev != NULL ) ? ReplayRecorder_Writev : NULL;
+        pTransportInterface->waitReadable = ( pRecorder->transport.waitReadable != NULL ) ? ReplayRecorder_WaitReadable : NULL;
+
+        /* The library receives the bytes it would skip, so they are
+         * recorded. */
+        pTransportInterface->skip = NULL;
+        pTransportInterface->pNetworkContext = ( NetworkContext_t * ) pRecorder;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayRecorder_Recv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+{
+    ReplayRecorder_t * pRecorder = getRecorder( pNetworkContext );
+    uint8_t header[ RECORD_HEADER_SIZE ];
+    struct iovec vectors[ 2 ];
+    int32_t result = -1;
+
+    if( pRecorder != NULL )
+    {
+        result = pRecorder->transport.recv( pRecorder->transport.pNetworkContext, pBuffer, bytesToRecv );
+    }
+
+    if( ( result > 0 ) && ( pRecorder->failed == false ) )
+    {
+        encodeLittleEndian( header, getTimeNs() - pRecorder->startNs, 8U );
+        encodeLittleEndian( &( header[ 8 ] ), ( uint64_t ) result, 4U );
+        vectors[ 0 ].iov_base = header;
+        vectors[ 0 ].iov_len = sizeof( header );
+        vectors[ 1 ].iov_base = pBuffer;
+        vectors[ 1 ].iov_len = ( size_t ) result;
+
+        /* The connection goes on without recording, rather than failing
+         * because of the file. */
+        if( writeAll( pRecorder->fileDescriptor, vectors, 2 ) == false )
+        {
+            LogError( ( "Writing a record failed, so recording stops: errno=%d", errno ) );
+            pRecorder->failed = true;
+        }
+        else
+        {
+            pRecorder->recordCount++;
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayRecorder_Send( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend )
+{
+    ReplayRecorder_t * pRecorder = getRecorder( pNetworkContext );
+    int32_t result = -1;
+
+    if( pRecorder != NULL )
+    {
+        result = pRecorder->transport.send( pRecorder->transport.pNetworkContext, pBuffer, bytesToSend );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayRecorder_Writev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount )
+{
+    ReplayRecorder_t * pRecorder = getRecorder( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pRecorder != NULL ) && ( pRecorder->transport.writev != NULL ) )
+    {
+        result = pRecorder->transport.writev( pRecorder->transport.pNetworkContext, pIoVec, ioVecCount );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayRecorder_WaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs )
+{
+    ReplayRecorder_t * pRecorder = getRecorder( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pRecorder != NULL ) && ( pRecorder->transport.waitReadable != NULL ) )
+    {
+        result = pRecorder->transport.waitReadable( pRecorder->transport.pNetworkContext, timeoutMs );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+ReplayTransportStatus_t ReplayTransport_Open( ReplayTransport_t * pTransport,
+                                              const uint8_t * pRecording,
+                                              size_t recordingLength,
+                                              bool paced )
+{
+    ReplayTransportStatus_t status = ReplayTransportSuccess;
+    size_t offset = RECORDING_HEADER_SIZE;
+    uint64_t length;
+
+    if( ( pTransport == NULL ) || ( pRecording == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pRecording=%p",
+                    ( void * ) pTransport,
+                    ( const void * ) pRecording ) );
+        status = ReplayTransportBadParameter;
+    }
+    else if( ( recordingLength < RECORDING_HEADER_SIZE ) ||
+             ( memcmp( pRecording, RECORDING_MAGIC, 4U ) != 0 ) ||
+             ( decodeLittleEndian( &( pRecording[ 4 ] ), 4U ) != RECORDING_VERSION ) )
+    {
+        LogError( ( "The recording does not start with a header of version %u.", RECORDING_VERSION ) );
+        status = ReplayTransportBadRecording;
+    }
+    else
+    {
+        while( ( status == ReplayTransportSuccess ) && ( offset < recordingLength ) )
+        {
+            length = ( ( recordingLength - offset ) >= RECORD_HEADER_SIZE ) ?
+                     decodeLittleEndian( &( pRecording[ offset + 8U ] ), 4U ) : UINT64_MAX;
+
+            if( length > ( uint64_t ) ( recordingLength - offset - RECORD_HEADER_SIZE ) )
+            {
+                LogError( ( "The record at offset %lu is truncated.", ( unsigned long ) offset ) );
+                status = ReplayTransportBadRecording;
+            }
+            else
+            {
+                offset += RECORD_HEADER_SIZE + ( size_t ) length;
+            }
+        }
+    }
+
+    if( status == ReplayTransportSuccess )
+    {
+        ( void ) memset( pTransport, 0, sizeof( *pTransport ) );
+        pTransport->pRecording = pRecording;
+        pTransport->recordingLength = recordingLength;
+        pTransport->paced = paced;
+        status = ReplayTransport_Rewind( pTransport );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+ReplayTransportStatus_t ReplayTransport_Rewind( ReplayTransport_t * pTransport )
+{
+    ReplayTransportStatus_t status = ReplayTransportSuccess;
+
+    if( ( pTransport == NULL ) || ( pTransport->pRecording == NULL ) )
+    {
+        LogError( ( "The replay transport must be open: pTransport=%p", ( void * ) pTransport ) );
+        status = ReplayTransportBadParameter;
+    }
+    else
+    {
+        pTransport->nextRecord = RECORDING_HEADER_SIZE;
+        pTransport->pChunk = NULL;
+        pTransport->chunkRemaining = 0U;
+        pTransport->startNs = getTimeNs();
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+bool ReplayTransport_IsFinished( const ReplayTransport_t * pTransport )
+{
+    return ( pTransport == NULL ) ||
+           ( ( pTransport->chunkRemaining == 0U ) && ( pTransport->nextRecord >= pTransport->recordingLength ) );
+}
+
+/*-----------------------------------------------------------*/
+
+void ReplayTransport_GetInterface( ReplayTransport_t * pTransport,
+                                   TransportInterface_t * pTransportInterface )
+{
+    if( ( pTransport == NULL ) || ( pTransportInterface == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pTransportInterface=%p",
+                    ( void * ) pTransport,
+                    ( void * ) pTransportInterface ) );
+    }
+    else
+    {
+        pTransportInterface->recv = ReplayTransport_Recv;
+        pTransportInterface->send = ReplayTransport_Send;
+        pTransportInterface->writev = ReplayTransport_Writev;
+        pTransportInterface->waitReadable = ReplayTransport_WaitReadable;
+        pTransportInterface->skip = ReplayTransport_Skip;
+        pTransportInterface->pNetworkContext = ( NetworkContext_t * ) pTransport;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayTransport_Recv( NetworkContext_t * pNetworkContext,
+                              void * pBuffer,
+                              size_t bytesToRecv )
+{
+    ReplayTransport_t * pTransport = getReplay( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pBuffer != NULL ) )
+    {
+        result = takeRecord( pTransport, ( uint8_t * ) pBuffer, bytesToRecv );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayTransport_Send( NetworkContext_t * pNetworkContext,
+                              const void * pBuffer,
+                              size_t bytesToSend )
+{
+    TransportOutVector_t vector;
+
+    vector.iov_base = pBuffer;
+    vector.iov_len = bytesToSend;
+
+    return ReplayTransport_Writev( pNetworkContext, &vector, 1U );
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayTransport_Writev( NetworkContext_t * pNetworkContext,
+                                TransportOutVector_t * pIoVec,
+                                size_t ioVecCount )
+{
+    ReplayTransport_t * pTransport = getReplay( pNetworkContext );
+    size_t length = 0U;
+    size_t i;
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pIoVec != NULL ) )
+    {
+        for( i = 0U; i < ioVecCount; i++ )
+        {
+            length += pIoVec[ i ].iov_len;
+        }
+
+        length = ( length > ( size_t ) INT32_MAX ) ? ( size_t ) INT32_MAX : length;
+        pTransport->bytesSent += length;
+        result = ( int32_t ) length;
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                      uint32_t timeoutMs )
+{
+    ReplayTransport_t * pTransport = getReplay( pNetworkContext );
+    struct timespec sleepTime;
+    uint64_t nowNs, dueNs, waitNs;
+    int32_t result = -1;
+
+    if( pTransport != NULL )
+    {
+        /* Once every record has been received, nothing more is due. */
+        nowNs = getTimeNs();
+        dueNs = UINT64_MAX;
+        result = ( startRecord( pTransport, &dueNs ) == true ) ? 1 : 0;
+        waitNs = ( uint64_t ) timeoutMs * 1000000U;
+
+        if( ( result == 0 ) && ( dueNs < UINT64_MAX ) && ( ( dueNs - nowNs ) <= waitNs ) )
+        {
+            waitNs = dueNs - nowNs;
+            result = 1;
+        }
+
+        if( ( result == 0 ) || ( pTransport->chunkRemaining == 0U ) )
+        {
+            sleepTime.tv_sec = ( time_t ) ( waitNs / 1000000000U );
+            sleepTime.tv_nsec = ( long ) ( waitNs % 1000000000U );
+
+            while( nanosleep( &sleepTime, &sleepTime ) != 0 )
+            {
+                /* Sleep again for the rest of the time after a signal. */
+            }
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ReplayTransport_Skip( NetworkContext_t * pNetworkContext,
+                              size_t bytesToSkip )
+{
+    ReplayTransport_t * pTransport = getReplay( pNetworkContext );
+    int32_t result = -1;
+
+    if( pTransport != NULL )
+    {
+        result = takeRecord( pTransport, NULL, bytesToSkip );
+    }
+
+    return result;
+}
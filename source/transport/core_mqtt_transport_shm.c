@@ -0,0 +1,683 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_shm.c
+ * @brief Implements the functions in core_mqtt_transport_shm.h.
+ *
+ * Each ring counts the bytes written and read with free-running 32-bit
+ * indices. Only the producer moves the tail and only the consumer moves the
+ * head, so the ring needs no lock. A consumer about to sleep sets a waiting
+ * flag and sleeps on the tail with `FUTEX_WAIT`, and the producer calls
+ * `FUTEX_WAKE` after moving the tail only when the flag is set.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "core_mqtt_transport_shm.h"
+
+/* Include config defaults header to get default values of configs. */
+#include "core_mqtt_config_defaults.h"
+
+/**
+ * @brief Value identifying a segment of this transport.
+ */
+#define SEGMENT_MAGIC           ( 0x4D514D53U )
+
+/**
+ * @brief Size of a cache line, used to keep the indices written by the two
+ * processes apart.
+ */
+#define CACHE_LINE_SIZE         ( 64U )
+
+/**
+ * @brief Smallest and largest ring sizes.
+ */
+#define RING_SIZE_MIN           ( 64U )
+#define RING_SIZE_MAX           ( 1UL << 30 )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The header at the start of a segment.
+ */
+typedef struct SegmentHeader
+{
+    uint32_t magic;    /**< @brief #SEGMENT_MAGIC once the segment is set up. */
+    uint32_t ringSize; /**< @brief Size of each ring. */
+    uint32_t opened;   /**< @brief Set by the second end when it opens the segment. */
+    uint8_t padding[ CACHE_LINE_SIZE - ( 3U * sizeof( uint32_t ) ) ];
+} SegmentHeader_t;
+
+/**
+ * @brief Control block of one ring in a segment.
+ */
+struct ShmTransportRing
+{
+    uint32_t tail;    /**< @brief Number of bytes written, moved by the producer. */
+    uint8_t tailPadding[ CACHE_LINE_SIZE - sizeof( uint32_t ) ];
+    uint32_t head;    /**< @brief Number of bytes read, moved by the consumer. */
+    uint8_t headPadding[ CACHE_LINE_SIZE - sizeof( uint32_t ) ];
+    uint32_t waiting; /**< @brief Set while the consumer sleeps on the tail. */
+    uint32_t closed;  /**< @brief Set when the producer closes its end. */
+    uint8_t flagsPadding[ CACHE_LINE_SIZE - ( 2U * sizeof( uint32_t ) ) ];
+};
+
+/**
+ * @brief Offset of the bytes of the first ring in a segment. The bytes of
+ * the second ring follow them.
+ */
+#define RING_DATA_OFFSET    ( sizeof( SegmentHeader_t ) + ( 2U * sizeof( struct ShmTransportRing ) ) )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check that a ring size is a power of 2 from #RING_SIZE_MIN to
+ * #RING_SIZE_MAX.
+ *
+ * @param[in] ringSize The ring size.
+ *
+ * @return `true` if the ring size is valid.
+ */
+static bool isValidRingSize( uint32_t ringSize );
+
+/**
+ * @brief Map a segment and point an end at its rings.
+ *
+ * @param[in] pTransport The end, with its segment descriptor and ring size set.
+ * @param[in] isCreator Whether the end created the segment.
+ *
+ * @return #ShmTransportSystemError if mapping failed;
+ * #ShmTransportSuccess otherwise.
+ */
+static ShmTransportStatus_t mapSegment( ShmTransport_t * pTransport,
+                                        bool isCreator );
+
+/**
+ * @brief Get the end of a network context passed to a transport function.
+ *
+ * @param[in] pNetworkContext Network context set by #ShmTransport_GetInterface.
+ *
+ * @return The end, or NULL if it is not connected.
+ */
+static ShmTransport_t * getTransport( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Wake the other end if it sleeps waiting for bytes of a ring.
+ *
+ * @param[in] pRing The ring.
+ */
+static void wakeConsumer( struct ShmTransportRing * pRing );
+
+/**
+ * @brief Take bytes out of the receive ring of an end.
+ *
+ * @param[in] pTransport The end.
+ * @param[out] pBuffer Buffer to copy the bytes into, or NULL to drop them.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes taken; 0 if none are available; -1 if the other
+ * end has closed and every byte has been taken, or if the indices of the
+ * ring are corrupt.
+ */
+static int32_t takeReceived( ShmTransport_t * pTransport,
+                             uint8_t * pBuffer,
+                             size_t bytesToRecv );
+
+/*-----------------------------------------------------------*/
+
+static bool isValidRingSize( uint32_t ringSize )
+{
+    return ( ringSize >= RING_SIZE_MIN ) && ( ringSize <= RING_SIZE_MAX ) &&
+           ( ( ringSize & ( ringSize - 1U ) ) == 0U );
+}
+
+/*-----------------------------------------------------------*/
+
+static ShmTransportStatus_t mapSegment( ShmTransport_t * pTransport,
+                                        bool isCreator )
+{
+    ShmTransportStatus_t status = ShmTransportSuccess;
+    struct ShmTransportRing * pRings;
+    uint8_t * pSegment;
+
+    pTransport->segmentSize = RING_DATA_OFFSET + ( 2U * ( size_t ) pTransport->ringSize );
+    pTransport->pSegment = mmap( NULL, pTransport->segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                 pTransport->segmentDescriptor, 0 );
+
+    if( pTransport->pSegment == MAP_FAILED )
+    {
+        LogError( ( "Mapping the segment failed: errno=%d", errno ) );
+        pTransport->pSegment = NULL;
+        status = ShmTransportSystemError;
+    }
+    else
+    {
+        pSegment = ( uint8_t * ) pTransport->pSegment;
+        pRings = ( struct ShmTransportRing * ) &( pSegment[ sizeof( SegmentHeader_t ) ] );
+
+        /* The creator writes the first ring and reads the second. */
+        if( isCreator == true )
+        {
+            pTransport->pSendRing = &( pRings[ 0 ] );
+            pTransport->pSendData = &( pSegment[ RING_DATA_OFFSET ] );
+            pTransport->pRecvRing = &( pRings[ 1 ] );
+            pTransport->pRecvData = &( pSegment[ RING_DATA_OFFSET + pTransport->ringSize ] );
+        }
+        else
+        {
+            pTransport->pSendRing = &( pRings[ 1 ] );
+            pTransport->pSendData = &( pSegment[ RING_DATA_OFFSET + pTransport->ringSize ] );
+            pTransport->pRecvRing = &( pRings[ 0 ] );
+            pTransport->pRecvData = &( pSegment[ RING_DATA_OFFSET ] );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+static ShmTransport_t * getTransport( NetworkContext_t * pNetworkContext )
+{
+    /* ShmTransport_GetInterface stores the end as the network context. */
+    ShmTransport_t * pTransport = ( ShmTransport_t * ) pNetworkContext;
+
+    if( ( pTransport != NULL ) && ( pTransport->pSegment == NULL ) )
+    {
+        LogError( ( "The shared memory connection is not open." ) );
+        pTransport = NULL;
+    }
+
+    return pTransport;
+}
+
+/*-----------------------------------------------------------*/
+
+static void wakeConsumer( struct ShmTransportRing * pRing )
+{
+    /* The consumer sets the flag before checking the tail again, and this
+     * load follows the store of the tail, so the consumer either sees the
+     * new tail or is woken. */
+    if( __atomic_load_n( &( pRing->waiting ), __ATOMIC_SEQ_CST ) != 0U )
+    {
+        ( void ) syscall( SYS_futex, &( pRing->tail ), FUTEX_WAKE, 1, NULL, NULL, 0 );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t takeReceived( ShmTransport_t * pTransport,
+                             uint8_t * pBuffer,
+                             size_t bytesToRecv )
+{
+    struct ShmTransportRing * pRing = pTransport->pRecvRing;
+    uint32_t head, available, offset, firstPart;
+    bool closed;
+    int32_t result = -1;
+
+    head = pRing->head;
+
+    /* The closed flag is read first, so that bytes sent before the other
+     * end closed are always seen. */
+    closed = ( __atomic_load_n( &( pRing->closed ), __ATOMIC_ACQUIRE ) != 0U );
+    available = __atomic_load_n( &( pRing->tail ), __ATOMIC_ACQUIRE ) - head;
+
+    /* The other process may write anything into the segment. A ring never
+     * holds more than its size, so more means the indices are corrupt. */
+    if( available > pTransport->ringSize )
+    {
+        LogError( ( "The receive ring is corrupt: available=%lu, ringSize=%lu.",
+                    ( unsigned long ) available,
+                    ( unsigned long ) pTransport->ringSize ) );
+        available = 0U;
+        closed = true;
+    }
+
+    if( ( size_t ) available > bytesToRecv )
+    {
+        available = ( uint32_t ) bytesToRecv;
+    }
+
+    if( available > ( uint32_t ) INT32_MAX )
+    {
+        available = ( uint32_t ) INT32_MAX;
+    }
+
+    if( available > 0U )
+    {
+        if( pBuffer != NULL )
+        {
+            offset = head & ( pTransport->ringSize - 1U );
+            firstPart = pTransport->ringSize - offset;
+
+            if( firstPart > available )
+            {
+                firstPart = available;
+            }
+
+            ( void ) memcpy( pBuffer, &( pTransport->pRecvData[ offset ] ), firstPart );
+            ( void ) memcpy( &( pBuffer[ firstPart ] ), pTransport->pRecvData, available - firstPart );
+        }
+
+        /* The producer may reuse the bytes once the head has moved. */
+        __atomic_store_n( &( pRing->head ), head + available, __ATOMIC_RELEASE );
+        result = ( int32_t ) available;
+    }
+    else if( closed == false )
+    {
+        result = 0;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+ShmTransportStatus_t ShmTransport_Create( ShmTransport_t * pTransport,
+                                          uint32_t ringSize )
+{
+    ShmTransportStatus_t status = ShmTransportSuccess;
+    SegmentHeader_t * pHeader;
+
+    if( pTransport == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pTransport=%p", ( void * ) pTransport ) );
+        status = ShmTransportBadParameter;
+    }
+    else if( isValidRingSize( ringSize ) == false )
+    {
+        LogError( ( "ringSize=%lu must be a power of 2 from %u to %lu.",
+                    ( unsigned long ) ringSize,
+                    RING_SIZE_MIN,
+                    RING_SIZE_MAX ) );
+        status = ShmTransportBadParameter;
+    }
+    else
+    {
+        ( void ) memset( pTransport, 0, sizeof( *pTransport ) );
+        pTransport->ringSize = ringSize;
+        pTransport->segmentDescriptor = ( int ) syscall( SYS_memfd_create, "coremqtt-shm", MFD_CLOEXEC );
+
+        /* A new file reads as zeros, so every index starts at 0. */
+        if( ( pTransport->segmentDescriptor < 0 ) ||
+            ( ftruncate( pTransport->segmentDescriptor,
+                         ( off_t ) ( RING_DATA_OFFSET + ( 2U * ( size_t ) ringSize ) ) ) != 0 ) )
+        {
+            LogError( ( "Creating the segment failed: errno=%d", errno ) );
+            status = ShmTransportSystemError;
+        }
+        else
+        {
+            status = mapSegment( pTransport, true );
+        }
+
+        if( status == ShmTransportSuccess )
+        {
+            pHeader = ( SegmentHeader_t * ) pTransport->pSegment;
+            pHeader->ringSize = ringSize;
+            __atomic_store_n( &( pHeader->magic ), SEGMENT_MAGIC, __ATOMIC_RELEASE );
+        }
+        else if( pTransport->segmentDescriptor >= 0 )
+        {
+            ( void ) close( pTransport->segmentDescriptor );
+            pTransport->segmentDescriptor = -1;
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+ShmTransportStatus_t ShmTransport_Open( ShmTransport_t * pTransport,
+                                        int segmentDescriptor )
+{
+    ShmTransportStatus_t status = ShmTransportSuccess;
+    SegmentHeader_t header;
+    struct stat fileStatus;
+
+    if( pTransport == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pTransport=%p", ( void * ) pTransport ) );
+        status = ShmTransportBadParameter;
+    }
+    else if( ( segmentDescriptor < 0 ) ||
+             ( fstat( segmentDescriptor, &fileStatus ) != 0 ) ||
+             ( ( size_t ) fileStatus.st_size < sizeof( header ) ) ||
+             ( pread( segmentDescriptor, &header, sizeof( header ), 0 ) != ( ssize_t ) sizeof( header ) ) ||
+             ( header.magic != SEGMENT_MAGIC ) ||
+             ( isValidRingSize( header.ringSize ) == false ) ||
+             ( ( size_t ) fileStatus.st_size != ( RING_DATA_OFFSET + ( 2U * ( size_t ) header.ringSize ) ) ) )
+    {
+        LogError( ( "segmentDescriptor=%d is not a shared memory transport segment.",
+                    segmentDescriptor ) );
+        status = ShmTransportBadParameter;
+    }
+    else
+    {
+        ( void ) memset( pTransport, 0, sizeof( *pTransport ) );
+        pTransport->segmentDescriptor = segmentDescriptor;
+        pTransport->ringSize = header.ringSize;
+
+        status = mapSegment( pTransport, false );
+
+        /* Only one process may use the second end. */
+        if( ( status == ShmTransportSuccess ) &&
+            ( __atomic_exchange_n( &( ( ( SegmentHeader_t * ) pTransport->pSegment )->opened ), 1U,
+                                   __ATOMIC_ACQ_REL ) != 0U ) )
+        {
+            LogError( ( "The second end of the segment is already open." ) );
+            ( void ) munmap( pTransport->pSegment, pTransport->segmentSize );
+            pTransport->pSegment = NULL;
+            status = ShmTransportBadParameter;
+        }
+    }
+
+    if( ( status != ShmTransportSuccess ) && ( segmentDescriptor >= 0 ) )
+    {
+        ( void ) close( segmentDescriptor );
+
+        if( pTransport != NULL )
+        {
+            pTransport->segmentDescriptor = -1;
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+ShmTransportStatus_t ShmTransport_Disconnect( ShmTransport_t * pTransport )
+{
+    ShmTransportStatus_t status = ShmTransportSuccess;
+
+    if( pTransport == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pTransport=%p", ( void * ) pTransport ) );
+        status = ShmTransportBadParameter;
+    }
+    else
+    {
+        if( pTransport->pSegment != NULL )
+        {
+            __atomic_store_n( &( pTransport->pSendRing->closed ), 1U, __ATOMIC_SEQ_CST );
+            wakeConsumer( pTransport->pSendRing );
+            ( void ) munmap( pTransport->pSegment, pTransport->segmentSize );
+            pTransport->pSegment = NULL;
+        }
+
+        if( pTransport->segmentDescriptor >= 0 )
+        {
+            ( void ) close( pTransport->segmentDescriptor );
+            pTransport->segmentDescriptor = -1;
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+ShmTransportStatus_t ShmTransport_Wait( ShmTransport_t * pTransport,
+                                        uint32_t timeoutMs )
+{
+    ShmTransportStatus_t status = ShmTransportTimeout;
+    struct ShmTransportRing * pRing;
+    struct timespec now;
+    struct timespec timeout;
+    uint64_t deadlineMs = 0U;
+    uint64_t nowMs;
+    uint32_t tail;
+
+    if( ( pTransport == NULL ) || ( pTransport->pSegment == NULL ) )
+    {
+        LogError( ( "The end must be open: pTransport=%p", ( void * ) pTransport ) );
+        status = ShmTransportBadParameter;
+    }
+    else
+    {
+        pRing = pTransport->pRecvRing;
+        ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+        nowMs = ( ( uint64_t ) now.tv_sec * 1000U ) + ( ( uint64_t ) now.tv_nsec / 1000000U );
+        deadlineMs = nowMs + timeoutMs;
+
+        for( ; ; )
+        {
+            tail = __atomic_load_n( &( pRing->tail ), __ATOMIC_SEQ_CST );
+
+            if( ( tail != pRing->head ) || ( __atomic_load_n( &( pRing->closed ), __ATOMIC_SEQ_CST ) != 0U ) )
+            {
+                status = ShmTransportSuccess;
+                break;
+            }
+
+            if( nowMs >= deadlineMs )
+            {
+                break;
+            }
+
+            /* Give the producer a chance to send more before sleeping, so that
+             * it need not wake this process for every message it sends. */
+            ( void ) sched_yield();
+
+            /* The producer checks the flag after moving the tail, so it is
+             * set before the tail is checked again. */
+            __atomic_store_n( &( pRing->waiting ), 1U, __ATOMIC_SEQ_CST );
+
+            if( ( __atomic_load_n( &( pRing->tail ), __ATOMIC_SEQ_CST ) == tail ) &&
+                ( __atomic_load_n( &( pRing->closed ), __ATOMIC_SEQ_CST ) == 0U ) )
+            {
+                timeout.tv_sec = ( time_t ) ( ( deadlineMs - nowMs ) / 1000U );
+                timeout.tv_nsec = ( long ) ( ( deadlineMs - nowMs ) % 1000U ) * 1000000L;
+                ( void ) syscall( SYS_futex, &( pRing->tail ), FUTEX_WAIT, tail, &timeout, NULL, 0 );
+            }
+
+            __atomic_store_n( &( pRing->waiting ), 0U, __ATOMIC_RELAXED );
+
+            ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+            nowMs = ( ( uint64_t ) now.tv_sec * 1000U ) + ( ( uint64_t ) now.tv_nsec / 1000000U );
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+void ShmTransport_GetInterface( ShmTransport_t * pTransport,
+                                TransportInterface_t * pTransportInterface )
+{
+    if( ( pTransport == NULL ) || ( pTransportInterface == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pTransportInterface=%p",
+                    ( void * ) pTransport,
+                    ( void * ) pTransportInterface ) );
+    }
+    else
+    {
+        pTransportInterface->recv = ShmTransport_Recv;
+        pTransportInterface->send = ShmTransport_Send;
+        pTransportInterface->writev = ShmTransport_Writev;
+        pTransportInterface->waitReadable = ShmTransport_WaitReadable;
+        pTransportInterface->skip = ShmTransport_Skip;
+        pTransportInterface->pNetworkContext = ( NetworkContext_t * ) pTransport;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ShmTransport_Recv( NetworkContext_t * pNetworkContext,
+                           void * pBuffer,
+                           size_t bytesToRecv )
+{
+    ShmTransport_t * pTransport = getTransport( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pBuffer != NULL ) && ( bytesToRecv > 0U ) )
+    {
+        result = takeReceived( pTransport, ( uint8_t * ) pBuffer, bytesToRecv );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ShmTransport_Send( NetworkContext_t * pNetworkContext,
+                           const void * pBuffer,
+                           size_t bytesToSend )
+{
+    TransportOutVector_t vector;
+
+    vector.iov_base = pBuffer;
+    vector.iov_len = bytesToSend;
+
+    return ShmTransport_Writev( pNetworkContext, &vector, 1U );
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ShmTransport_Writev( NetworkContext_t * pNetworkContext,
+                             TransportOutVector_t * pIoVec,
+                             size_t ioVecCount )
+{
+    ShmTransport_t * pTransport = getTransport( pNetworkContext );
+    struct ShmTransportRing * pRing;
+    const uint8_t * pBytes;
+    uint32_t tail, space, length, offset, firstPart;
+    size_t i;
+    int32_t result = -1;
+
+    /* The other end closes its end by closing the ring it writes. */
+    if( ( pTransport != NULL ) && ( pIoVec != NULL ) &&
+        ( __atomic_load_n( &( pTransport->pRecvRing->closed ), __ATOMIC_ACQUIRE ) == 0U ) )
+    {
+        pRing = pTransport->pSendRing;
+        tail = pRing->tail;
+        space = pTransport->ringSize - ( tail - __atomic_load_n( &( pRing->head ), __ATOMIC_ACQUIRE ) );
+
+        /* The ring is at most 1 GiB, so the bytes copied fit in the result. */
+        for( i = 0U; ( i < ioVecCount ) && ( space > 0U ); i++ )
+        {
+            pBytes = ( const uint8_t * ) pIoVec[ i ].iov_base;
+            length = ( pIoVec[ i ].iov_len > ( size_t ) space ) ? space : ( uint32_t ) pIoVec[ i ].iov_len;
+
+            if( ( pBytes != NULL ) && ( length > 0U ) )
+            {
+                offset = tail & ( pTransport->ringSize - 1U );
+                firstPart = pTransport->ringSize - offset;
+
+                if( firstPart > length )
+                {
+                    firstPart = length;
+                }
+
+                ( void ) memcpy( &( pTransport->pSendData[ offset ] ), pBytes, firstPart );
+                ( void ) memcpy( pTransport->pSendData, &( pBytes[ firstPart ] ), length - firstPart );
+                tail += length;
+                space -= length;
+            }
+        }
+
+        result = ( int32_t ) ( tail - pRing->tail );
+
+        if( result > 0 )
+        {
+            __atomic_store_n( &( pRing->tail ), tail, __ATOMIC_SEQ_CST );
+            wakeConsumer( pRing );
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ShmTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                   uint32_t timeoutMs )
+{
+    ShmTransport_t * pTransport = getTransport( pNetworkContext );
+    ShmTransportStatus_t status = ShmTransportBadParameter;
+    int32_t result = -1;
+
+    if( pTransport != NULL )
+    {
+        status = ShmTransport_Wait( pTransport, timeoutMs );
+    }
+
+    if( status == ShmTransportSuccess )
+    {
+        result = 1;
+    }
+    else if( status == ShmTransportTimeout )
+    {
+        result = 0;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t ShmTransport_Skip( NetworkContext_t * pNetworkContext,
+                           size_t bytesToSkip )
+{
+    ShmTransport_t * pTransport = getTransport( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( bytesToSkip > 0U ) )
+    {
+        result = takeReceived( pTransport, NULL, bytesToSkip );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
@@ -0,0 +1,655 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_sim.c
+ * @brief Implementation of the simulated transport.
+ */
+
+#ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE    200809L
+#endif
+
+#include <string.h>
+#include <time.h>
+
+#include "core_mqtt_transport_sim.h"
+
+/* Include config defaults header to get default values of configs. */
+#include "core_mqtt_config_defaults.h"
+
+/**
+ * @brief Most vectors of a writev call cut short by an impairment. The bytes
+ * of later vectors are left for the next call.
+ */
+#define SIM_MAX_VECTORS    ( 16U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read the monotonic clock.
+ *
+ * @return The time in nanoseconds.
+ */
+static uint64_t getTimeNs( void );
+
+/**
+ * @brief Sleep for a time.
+ *
+ * @param[in] durationNs The time in nanoseconds.
+ */
+static void sleepNs( uint64_t durationNs );
+
+/**
+ * @brief Get the next random number of a transport, with xorshift32.
+ *
+ * @param[in] pTransport The transport.
+ *
+ * @return The number.
+ */
+static uint32_t nextRandom( SimTransport_t * pTransport );
+
+/**
+ * @brief Decide whether to apply an impairment given as a percentage.
+ *
+ * @param[in] pTransport The transport.
+ * @param[in] percent Percentage of calls to apply it to.
+ *
+ * @return true to apply the impairment; false otherwise.
+ */
+static bool chance( SimTransport_t * pTransport,
+                    uint32_t percent );
+
+/**
+ * @brief Add the tokens earned since a bucket was last updated.
+ *
+ * @param[in] pBucket The bucket.
+ * @param[in] bytesPerSecond The rate of the bucket, or 0 if it has none.
+ * @param[in] nowNs The time.
+ *
+ * @return The bytes that may pass now, or SIZE_MAX without a rate.
+ */
+static size_t refillBucket( SimTransportBucket_t * pBucket,
+                            uint64_t bytesPerSecond,
+                            uint64_t nowNs );
+
+/**
+ * @brief Take tokens for bytes that passed a bucket.
+ *
+ * @param[in] pBucket The bucket.
+ * @param[in] bytesPerSecond The rate of the bucket, or 0 if it has none.
+ * @param[in] bytes The bytes that passed.
+ */
+static void spendBucket( SimTransportBucket_t * pBucket,
+                         uint64_t bytesPerSecond,
+                         size_t bytes );
+
+/**
+ * @brief Receive bytes from the wrapped transport into the latency queue.
+ *
+ * @param[in] pTransport The transport.
+ * @param[in] nowNs The time.
+ *
+ * @return The result of the receive function of the wrapped transport, or 0
+ * if the queue is full.
+ */
+static int32_t fillDelayed( SimTransport_t * pTransport,
+                            uint64_t nowNs );
+
+/**
+ * @brief Take bytes of the first piece in the latency queue, if it is due.
+ *
+ * @param[in] pTransport The transport.
+ * @param[out] pBuffer Buffer to copy the bytes into.
+ * @param[in] bytesToRecv Most bytes to take.
+ * @param[in] nowNs The time.
+ *
+ * @return The number of bytes taken.
+ */
+static size_t takeDelayed( SimTransport_t * pTransport,
+                           uint8_t * pBuffer,
+                           size_t bytesToRecv,
+                           uint64_t nowNs );
+
+/**
+ * @brief Send a prefix of some vectors with the impairments.
+ *
+ * @param[in] pTransport The transport.
+ * @param[in] pIoVec The vectors to send.
+ * @param[in] ioVecCount Number of vectors in @p pIoVec.
+ * @param[in] isWritev Whether the library called writev, which may be cut
+ * short at random.
+ *
+ * @return The number of bytes sent; 0 if none can be sent now; a negative
+ * value if the wrapped transport failed.
+ */
+static int32_t sendImpaired( SimTransport_t * pTransport,
+                             TransportOutVector_t * pIoVec,
+                             size_t ioVecCount,
+                             bool isWritev );
+
+/**
+ * @brief Get the transport of a network context passed to a transport
+ * function.
+ *
+ * @param[in] pNetworkContext Network context set by #SimTransport_GetInterface.
+ *
+ * @return The transport, or NULL if it was not set up.
+ */
+static SimTransport_t * getTransport( NetworkContext_t * pNetworkContext );
+
+/*-----------------------------------------------------------*/
+
+static uint64_t getTimeNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static void sleepNs( uint64_t durationNs )
+{
+    struct timespec sleepTime;
+
+    sleepTime.tv_sec = ( time_t ) ( durationNs / 1000000000U );
+    sleepTime.tv_nsec = ( long ) ( durationNs % 1000000000U );
+
+    while( nanosleep( &sleepTime, &sleepTime ) != 0 )
+    {
+        /* Sleep again for the rest of the time after a signal. */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static uint32_t nextRandom( SimTransport_t * pTransport )
+{
+    uint32_t x = pTransport->randomState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pTransport->randomState = x;
+
+    return x;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool chance( SimTransport_t * pTransport,
+                    uint32_t percent )
+{
+    /* No random number is drawn for an impairment that is off, so turning
+     * one on does not change the choices of the others. */
+    return ( percent > 0U ) && ( ( nextRandom( pTransport ) % 100U ) < percent );
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t refillBucket( SimTransportBucket_t * pBucket,
+                            uint64_t bytesPerSecond,
+                            uint64_t nowNs )
+{
+    uint64_t burst, elapsedNs, earned;
+    size_t available = SIZE_MAX;
+
+    if( bytesPerSecond > 0U )
+    {
+        burst = ( bytesPerSecond * SIM_TRANSPORT_BURST_MS ) / 1000U;
+        burst = ( burst > 0U ) ? burst : 1U;
+        elapsedNs = nowNs - pBucket->updatedNs;
+
+        if( elapsedNs >= ( ( uint64_t ) SIM_TRANSPORT_BURST_MS * 1000000U ) )
+        {
+            pBucket->tokens = burst;
+            pBucket->updatedNs = nowNs;
+        }
+        else
+        {
+            earned = ( elapsedNs * bytesPerSecond ) / 1000000000U;
+
+            /* The time of a part of a token is kept for the next refill. */
+            if( earned > 0U )
+            {
+                pBucket->tokens = ( ( pBucket->tokens + earned ) < burst ) ? ( pBucket->tokens + earned ) : burst;
+                pBucket->updatedNs += ( earned * 1000000000U ) / bytesPerSecond;
+            }
+        }
+
+        available = ( pBucket->tokens < ( uint64_t ) SIZE_MAX ) ? ( size_t ) pBucket->tokens : SIZE_MAX;
+    }
+
+    return available;
+}
+
+/*-----------------------------------------------------------*/
+
+static void spendBucket( SimTransportBucket_t * pBucket,
+                         uint64_t bytesPerSecond,
+                         size_t bytes )
+{
+    if( bytesPerSecond > 0U )
+    {
+        pBucket->tokens -= ( bytes < pBucket->tokens ) ? bytes : pBucket->tokens;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t fillDelayed( SimTransport_t * pTransport,
+                            uint64_t nowNs )
+{
+    SimTransportChunk_t * pChunk;
+    size_t tail, space;
+    int32_t result = 0;
+
+    if( ( pTransport->chunkCount < SIM_TRANSPORT_DELAY_CHUNKS ) &&
+        ( pTransport->delayedCount < SIM_TRANSPORT_DELAY_BUFFER_SIZE ) )
+    {
+        /* Receive into the free bytes up to the end of the queue. The rest
+         * of the free bytes are used by the next call. */
+        tail = ( pTransport->delayedHead + pTransport->delayedCount ) % SIM_TRANSPORT_DELAY_BUFFER_SIZE;
+        space = SIM_TRANSPORT_DELAY_BUFFER_SIZE - pTransport->delayedCount;
+        space = ( space < ( SIM_TRANSPORT_DELAY_BUFFER_SIZE - tail ) ) ? space : ( SIM_TRANSPORT_DELAY_BUFFER_SIZE - tail );
+
+        result = pTransport->transport.recv( pTransport->transport.pNetworkContext, &( pTransport->delayed[ tail ] ), space );
+
+        if( result > 0 )
+        {
+            pChunk = &( pTransport->chunks[ ( pTransport->chunkHead + pTransport->chunkCount ) % SIM_TRANSPORT_DELAY_CHUNKS ] );
+            pChunk->readyNs = nowNs + ( ( uint64_t ) pTransport->config.latencyUs * 1000U );
+            pChunk->length = ( uint32_t ) result;
+            pTransport->chunkCount++;
+            pTransport->delayedCount += ( size_t ) result;
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t takeDelayed( SimTransport_t * pTransport,
+                           uint8_t * pBuffer,
+                           size_t bytesToRecv,
+                           uint64_t nowNs )
+{
+    SimTransportChunk_t * pChunk = &( pTransport->chunks[ pTransport->chunkHead ] );
+    size_t length = 0U;
+    size_t firstPart;
+
+    if( ( pTransport->chunkCount > 0U ) && ( pChunk->readyNs <= nowNs ) )
+    {
+        length = ( bytesToRecv < pChunk->length ) ? bytesToRecv : pChunk->length;
+        firstPart = SIM_TRANSPORT_DELAY_BUFFER_SIZE - pTransport->delayedHead;
+        firstPart = ( firstPart < length ) ? firstPart : length;
+
+        ( void ) memcpy( pBuffer, &( pTransport->delayed[ pTransport->delayedHead ] ), firstPart );
+        ( void ) memcpy( &( pBuffer[ firstPart ] ), pTransport->delayed, length - firstPart );
+
+        pTransport->delayedHead = ( pTransport->delayedHead + length ) % SIM_TRANSPORT_DELAY_BUFFER_SIZE;
+        pTransport->delayedCount -= length;
+        pChunk->length -= ( uint32_t ) length;
+
+        if( pChunk->length == 0U )
+        {
+            pTransport->chunkHead = ( pTransport->chunkHead + 1U ) % SIM_TRANSPORT_DELAY_CHUNKS;
+            pTransport->chunkCount--;
+        }
+    }
+
+    return length;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t sendImpaired( SimTransport_t * pTransport,
+                             TransportOutVector_t * pIoVec,
+                             size_t ioVecCount,
+                             bool isWritev )
+{
+    TransportOutVector_t vectors[ SIM_MAX_VECTORS ];
+    TransportOutVector_t * pVectors = pIoVec;
+    size_t vectorCount = ioVecCount;
+    size_t total = 0U;
+    size_t limit, i;
+    int32_t result = 0;
+
+    for( i = 0U; i < ioVecCount; i++ )
+    {
+        total += pIoVec[ i ].iov_len;
+    }
+
+    limit = total;
+
+    if( ( pTransport->config.maxSendSize > 0U ) && ( limit > pTransport->config.maxSendSize ) )
+    {
+        limit = pTransport->config.maxSendSize;
+    }
+
+    if( ( isWritev == true ) && ( limit > 1U ) && ( chance( pTransport, pTransport->config.shortWritevPercent ) == true ) )
+    {
+        limit = 1U + ( ( size_t ) nextRandom( pTransport ) % ( limit - 1U ) );
+    }
+
+    i = refillBucket( &( pTransport->sendBucket ), pTransport->config.sendBytesPerSecond, getTimeNs() );
+    limit = ( i < limit ) ? i : limit;
+
+    if( chance( pTransport, pTransport->config.zeroSendPercent ) == true )
+    {
+        limit = 0U;
+    }
+
+    if( limit < total )
+    {
+        /* Pass the wrapped transport only the vectors holding the first
+         * bytes, the last of them cut short. */
+        for( vectorCount = 0U; ( vectorCount < ioVecCount ) && ( vectorCount < SIM_MAX_VECTORS ) && ( limit > 0U ); vectorCount++ )
+        {
+            vectors[ vectorCount ] = pIoVec[ vectorCount ];
+
+            if( vectors[ vectorCount ].iov_len > limit )
+            {
+                vectors[ vectorCount ].iov_len = limit;
+            }
+
+            limit -= vectors[ vectorCount ].iov_len;
+        }
+
+        pVectors = vectors;
+        pTransport->stats.shortWrites += ( vectorCount > 0U ) ? 1U : 0U;
+    }
+
+    if( vectorCount == 0U )
+    {
+        result = 0;
+    }
+    else if( ( isWritev == true ) && ( pTransport->transport.writev != NULL ) )
+    {
+        result = pTransport->transport.writev( pTransport->transport.pNetworkContext, pVectors, vectorCount );
+    }
+    else
+    {
+        result = pTransport->transport.send( pTransport->transport.pNetworkContext, pVectors->iov_base, pVectors->iov_len );
+    }
+
+    if( result > 0 )
+    {
+        spendBucket( &( pTransport->sendBucket ), pTransport->config.sendBytesPerSecond, ( size_t ) result );
+        pTransport->stats.bytesSent += ( uint64_t ) result;
+    }
+    else if( result == 0 )
+    {
+        pTransport->stats.zeroSends++;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+static SimTransport_t * getTransport( NetworkContext_t * pNetworkContext )
+{
+    /* SimTransport_GetInterface stores the transport as the network
+     * context. */
+    SimTransport_t * pTransport = ( SimTransport_t * ) pNetworkContext;
+
+    if( ( pTransport != NULL ) && ( pTransport->transport.recv == NULL ) )
+    {
+        LogError( ( "The simulated transport is not set up." ) );
+        pTransport = NULL;
+    }
+
+    return pTransport;
+}
+
+/*-----------------------------------------------------------*/
+
+SimTransportStatus_t SimTransport_Init( SimTransport_t * pTransport,
+                                        const TransportInterface_t * pWrapped,
+                                        const SimTransportConfig_t * pConfig )
+{
+    SimTransportStatus_t status = SimTransportSuccess;
+
+    if( ( pTransport == NULL ) || ( pWrapped == NULL ) || ( pConfig == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pWrapped=%p, pConfig=%p",
+                    ( void * ) pTransport,
+                    ( const void * ) pWrapped,
+                    ( const void * ) pConfig ) );
+        status = SimTransportBadParameter;
+    }
+    else if( ( pWrapped->recv == NULL ) || ( pWrapped->send == NULL ) )
+    {
+        LogError( ( "The wrapped transport must have receive and send functions." ) );
+        status = SimTransportBadParameter;
+    }
+    else if( ( pConfig->zeroRecvPercent > 100U ) || ( pConfig->zeroSendPercent > 100U ) ||
+             ( pConfig->shortWritevPercent > 100U ) )
+    {
+        LogError( ( "Percentages cannot be more than 100: zeroRecvPercent=%lu, zeroSendPercent=%lu, shortWritevPercent=%lu",
+                    ( unsigned long ) pConfig->zeroRecvPercent,
+                    ( unsigned long ) pConfig->zeroSendPercent,
+                    ( unsigned long ) pConfig->shortWritevPercent ) );
+        status = SimTransportBadParameter;
+    }
+    else
+    {
+        ( void ) memset( pTransport, 0, sizeof( *pTransport ) );
+        pTransport->transport = *pWrapped;
+        pTransport->config = *pConfig;
+
+        /* xorshift32 never leaves a state of 0. */
+        pTransport->randomState = ( pConfig->seed != 0U ) ? pConfig->seed : 0x9E3779B9U;
+
+        /* Both directions start with a full burst. */
+        pTransport->recvBucket.updatedNs = getTimeNs() - ( ( uint64_t ) SIM_TRANSPORT_BURST_MS * 1000000U );
+        pTransport->sendBucket.updatedNs = pTransport->recvBucket.updatedNs;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+void SimTransport_GetInterface( SimTransport_t * pTransport,
+                                TransportInterface_t * pTransportInterface )
+{
+    if( ( pTransport == NULL ) || ( pTransportInterface == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pTransportInterface=%p",
+                    ( void * ) pTransport,
+                    ( void * ) pTransportInterface ) );
+    }
+    else
+    {
+        pTransportInterface->recv = SimTransport_Recv;
+        pTransportInterface->send = SimTransport_Send;
+        pTransportInterface->writev = ( pTransport->transport.writev != NULL ) ? SimTransport_Writev : NULL;
+        pTransportInterface->waitReadable = ( pTransport->transport.waitReadable != NULL ) ? SimTransport_WaitReadable : NULL;
+
+        /* The library receives the bytes it would skip, so they are
+         * impaired too. */
+        pTransportInterface->skip = NULL;
+        pTransportInterface->pNetworkContext = ( NetworkContext_t * ) pTransport;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t SimTransport_Recv( NetworkContext_t * pNetworkContext,
+                           void * pBuffer,
+                           size_t bytesToRecv )
+{
+    SimTransport_t * pTransport = getTransport( pNetworkContext );
+    uint64_t nowNs;
+    size_t limit;
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pBuffer != NULL ) )
+    {
+        nowNs = getTimeNs();
+        limit = refillBucket( &( pTransport->recvBucket ), pTransport->config.recvBytesPerSecond, nowNs );
+        limit = ( bytesToRecv < limit ) ? bytesToRecv : limit;
+
+        if( ( pTransport->config.maxRecvSize > 0U ) && ( limit > pTransport->config.maxRecvSize ) )
+        {
+            limit = pTransport->config.maxRecvSize;
+        }
+
+        limit = ( limit > ( size_t ) INT32_MAX ) ? ( size_t ) INT32_MAX : limit;
+
+        if( chance( pTransport, pTransport->config.zeroRecvPercent ) == true )
+        {
+            result = 0;
+        }
+        else if( pTransport->config.latencyUs == 0U )
+        {
+            result = ( limit > 0U ) ? pTransport->transport.recv( pTransport->transport.pNetworkContext, pBuffer, limit ) : 0;
+        }
+        else
+        {
+            /* An error of the wrapped transport is returned once the bytes
+             * received before it have been taken. */
+            result = fillDelayed( pTransport, nowNs );
+
+            if( ( result >= 0 ) || ( pTransport->chunkCount > 0U ) )
+            {
+                result = ( int32_t ) takeDelayed( pTransport, ( uint8_t * ) pBuffer, limit, nowNs );
+            }
+        }
+
+        if( result > 0 )
+        {
+            spendBucket( &( pTransport->recvBucket ), pTransport->config.recvBytesPerSecond, ( size_t ) result );
+            pTransport->stats.bytesReceived += ( uint64_t ) result;
+        }
+        else if( result == 0 )
+        {
+            pTransport->stats.zeroRecvs++;
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t SimTransport_Send( NetworkContext_t * pNetworkContext,
+                           const void * pBuffer,
+                           size_t bytesToSend )
+{
+    SimTransport_t * pTransport = getTransport( pNetworkContext );
+    TransportOutVector_t vector;
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pBuffer != NULL ) )
+    {
+        vector.iov_base = pBuffer;
+        vector.iov_len = bytesToSend;
+        result = sendImpaired( pTransport, &vector, 1U, false );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t SimTransport_Writev( NetworkContext_t * pNetworkContext,
+                             TransportOutVector_t * pIoVec,
+                             size_t ioVecCount )
+{
+    SimTransport_t * pTransport = getTransport( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pIoVec != NULL ) && ( ioVecCount > 0U ) )
+    {
+        result = sendImpaired( pTransport, pIoVec, ioVecCount, true );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t SimTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                   uint32_t timeoutMs )
+{
+    SimTransport_t * pTransport = getTransport( pNetworkContext );
+    uint64_t nowNs, waitNs, timeoutNs;
+    int32_t result = -1;
+
+    if( pTransport != NULL )
+    {
+        nowNs = getTimeNs();
+        timeoutNs = ( uint64_t ) timeoutMs * 1000000U;
+        waitNs = 0U;
+        result = 1;
+
+        /* Wait for a token when the rate is used up, then for held bytes,
+         * then for the wrapped transport. */
+        if( refillBucket( &( pTransport->recvBucket ), pTransport->config.recvBytesPerSecond, nowNs ) == 0U )
+        {
+            waitNs = ( 1000000000U / pTransport->config.recvBytesPerSecond ) + 1U;
+        }
+        else if( pTransport->chunkCount > 0U )
+        {
+            waitNs = ( pTransport->chunks[ pTransport->chunkHead ].readyNs > nowNs ) ?
+                     ( pTransport->chunks[ pTransport->chunkHead ].readyNs - nowNs ) : 0U;
+        }
+        else if( pTransport->transport.waitReadable != NULL )
+        {
+            result = pTransport->transport.waitReadable( pTransport->transport.pNetworkContext, timeoutMs );
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+
+        if( waitNs > timeoutNs )
+        {
+            waitNs = timeoutNs;
+            result = 0;
+        }
+
+        if( waitNs > 0U )
+        {
+            sleepNs( waitNs );
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,1113 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_uring.c
+ * @brief Implements the functions in core_mqtt_transport_uring.h.
+ *
+ * The ring is driven with the raw io_uring system calls, so that the
+ * transport has no dependencies beyond the kernel headers. It needs Linux
+ * 5.19 or later.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "core_mqtt_transport_uring.h"
+
+/* Include config defaults header to get default values of configs. */
+#include "core_mqtt_config_defaults.h"
+
+/**
+ * @brief Operations of a connection, encoded in the low bits of the user
+ * data of a submission along with the address of the connection.
+ */
+#define OPERATION_RECV          ( 0U )
+#define OPERATION_SEND          ( 1U )
+#define OPERATION_CANCEL        ( 2U )
+#define OPERATION_MASK          ( 3U )
+
+/**
+ * @brief Bits of #UringTransport_t.pendingOperations.
+ */
+#define PENDING_RECV            ( 1U )
+#define PENDING_SEND            ( 2U )
+#define PENDING_CANCEL          ( 4U )
+
+/**
+ * @brief Largest block of memory that can be registered as one fixed buffer.
+ */
+#define REGISTERED_SIZE_MAX     ( 1UL << 30 )
+
+/**
+ * @brief Index of the fixed buffer holding the buffers of every connection.
+ */
+#define FIXED_BUFFER_INDEX      ( 0U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get the connection of a network context passed to a transport
+ * function.
+ *
+ * @param[in] pNetworkContext Network context set by #UringTransport_GetInterface.
+ *
+ * @return The connection, or NULL if it is not attached.
+ */
+static UringTransport_t * getTransport( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Enter the ring to submit queued entries and collect completions.
+ *
+ * @param[in] pRing The ring.
+ * @param[in] timeoutMs Time to wait for a completion, or 0 not to wait.
+ *
+ * @return `true` unless submitting failed.
+ */
+static bool enterRing( UringTransportRing_t * pRing,
+                       uint32_t timeoutMs );
+
+/**
+ * @brief Get a free submission queue entry, submitting the queued entries
+ * first if the queue is full.
+ *
+ * @param[in] pRing The ring.
+ *
+ * @return The cleared entry, or NULL if the kernel did not take the queued
+ * entries.
+ */
+static struct io_uring_sqe * getSqe( UringTransportRing_t * pRing );
+
+/**
+ * @brief Queue a receive into the receive buffer of a connection.
+ *
+ * If the submission queue is full, the connection is returned by the next
+ * poll instead, and its next receive queues the receive again.
+ *
+ * @param[in] pTransport The connection.
+ */
+static void queueRecv( UringTransport_t * pTransport );
+
+/**
+ * @brief Queue a write of the send buffer of a connection.
+ *
+ * If the submission queue is full, the write is queued again by the next
+ * send of the connection, or by #UringTransport_Disconnect.
+ *
+ * @param[in] pTransport The connection.
+ */
+static void queueSend( UringTransport_t * pTransport );
+
+/**
+ * @brief Process the completions posted by the kernel.
+ *
+ * @param[in] pRing The ring.
+ */
+static void reapCompletions( UringTransportRing_t * pRing );
+
+/**
+ * @brief Update a connection with the result of one of its operations.
+ *
+ * @param[in] userData User data of the completed submission.
+ * @param[in] result Result of the operation.
+ */
+static void handleCompletion( uint64_t userData,
+                              int32_t result );
+
+/**
+ * @brief Add a connection to the end of the ready list of its ring.
+ *
+ * @param[in] pTransport The connection.
+ */
+static void pushReady( UringTransport_t * pTransport );
+
+/**
+ * @brief Remove a connection from the ready list of its ring.
+ *
+ * @param[in] pTransport The connection.
+ */
+static void removeReady( UringTransport_t * pTransport );
+
+/**
+ * @brief Copy bytes into the send buffer of a connection.
+ *
+ * @param[in] pTransport The connection.
+ * @param[in] pBytes The bytes.
+ * @param[in] length Number of bytes.
+ *
+ * @return Number of bytes copied.
+ */
+static size_t appendToSendBuffer( UringTransport_t * pTransport,
+                                  const void * pBytes,
+                                  size_t length );
+
+/**
+ * @brief Return the received bytes staged for a connection, receiving more
+ * first if none are staged.
+ *
+ * @param[in] pTransport The connection.
+ * @param[out] pBuffer Buffer to copy the bytes into, or NULL to drop them.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes returned; 0 if none are available; -1 if the
+ * connection closed or failed.
+ */
+static int32_t takeReceived( UringTransport_t * pTransport,
+                             void * pBuffer,
+                             size_t bytesToRecv );
+
+/**
+ * @brief Get the time of a monotonic clock in milliseconds.
+ *
+ * @return The time.
+ */
+static uint64_t getTimeMs( void );
+
+/*-----------------------------------------------------------*/
+
+static UringTransport_t * getTransport( NetworkContext_t * pNetworkContext )
+{
+    /* UringTransport_GetInterface stores the connection as the network context. */
+    UringTransport_t * pTransport = ( UringTransport_t * ) pNetworkContext;
+
+    if( ( pTransport != NULL ) && ( pTransport->socketDescriptor < 0 ) )
+    {
+        LogError( ( "The io_uring connection is not attached." ) );
+        pTransport = NULL;
+    }
+
+    return pTransport;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool enterRing( UringTransportRing_t * pRing,
+                       uint32_t timeoutMs )
+{
+    struct io_uring_getevents_arg eventsArg;
+    struct __kernel_timespec timeout;
+    uint32_t submitCount;
+    uint32_t flags = IORING_ENTER_GETEVENTS;
+    long result;
+    bool success = true;
+
+    assert( pRing != NULL );
+
+    /* Publish the queued entries to the kernel. */
+    __atomic_store_n( pRing->pSqTail, pRing->sqTail, __ATOMIC_RELEASE );
+    submitCount = pRing->sqTail - __atomic_load_n( pRing->pSqHead, __ATOMIC_ACQUIRE );
+
+    if( timeoutMs == 0U )
+    {
+        result = syscall( __NR_io_uring_enter, pRing->ringDescriptor, submitCount, 0U, flags, NULL, 0U );
+    }
+    else
+    {
+        timeout.tv_sec = ( long long ) ( timeoutMs / 1000U );
+        timeout.tv_nsec = ( long long ) ( timeoutMs % 1000U ) * 1000000LL;
+        ( void ) memset( &eventsArg, 0, sizeof( eventsArg ) );
+        eventsArg.ts = ( uint64_t ) ( uintptr_t ) &timeout;
+        flags |= IORING_ENTER_EXT_ARG;
+
+        result = syscall( __NR_io_uring_enter, pRing->ringDescriptor, submitCount, 1U, flags,
+                          &eventsArg, sizeof( eventsArg ) );
+    }
+
+    /* A timeout or signal only ends the wait. A busy completion queue is
+     * drained below, and the entries are submitted by the next call. */
+    if( ( result < 0 ) && ( errno != ETIME ) && ( errno != EINTR ) &&
+        ( errno != EBUSY ) && ( errno != EAGAIN ) )
+    {
+        LogError( ( "io_uring_enter failed: errno=%d", errno ) );
+        success = false;
+    }
+
+    reapCompletions( pRing );
+
+    return success;
+}
+
+/*-----------------------------------------------------------*/
+
+static struct io_uring_sqe * getSqe( UringTransportRing_t * pRing )
+{
+    struct io_uring_sqe * pSqe = NULL;
+
+    if( ( pRing->sqTail - __atomic_load_n( pRing->pSqHead, __ATOMIC_ACQUIRE ) ) == pRing->sqEntryCount )
+    {
+        ( void ) enterRing( pRing, 0U );
+    }
+
+    /* The kernel leaves the entries queued when it is busy, or when
+     * submitting failed. */
+    if( ( pRing->sqTail - __atomic_load_n( pRing->pSqHead, __ATOMIC_ACQUIRE ) ) < pRing->sqEntryCount )
+    {
+        pSqe = &( pRing->pSqes[ pRing->sqTail & pRing->sqMask ] );
+        pRing->sqTail++;
+        ( void ) memset( pSqe, 0, sizeof( *pSqe ) );
+    }
+    else
+    {
+        LogWarn( ( "The io_uring submission queue is full." ) );
+    }
+
+    return pSqe;
+}
+
+/*-----------------------------------------------------------*/
+
+static void queueRecv( UringTransport_t * pTransport )
+{
+    UringTransportRing_t * pRing = pTransport->pRing;
+    struct io_uring_sqe * pSqe = getSqe( pRing );
+
+    if( pSqe != NULL )
+    {
+        pSqe->opcode = IORING_OP_READ_FIXED;
+        pSqe->fd = pTransport->socketDescriptor;
+        pSqe->addr = ( uint64_t ) ( uintptr_t ) pTransport->pRecvBuffer;
+        pSqe->len = ( uint32_t ) pRing->bufferSize;
+        pSqe->off = ( uint64_t ) -1;
+        pSqe->buf_index = FIXED_BUFFER_INDEX;
+        pSqe->user_data = ( uint64_t ) ( uintptr_t ) pTransport | OPERATION_RECV;
+
+        pTransport->pendingOperations |= PENDING_RECV;
+    }
+    else
+    {
+        pushReady( pTransport );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void queueSend( UringTransport_t * pTransport )
+{
+    UringTransportRing_t * pRing = pTransport->pRing;
+    struct io_uring_sqe * pSqe = getSqe( pRing );
+
+    /* Bytes appended to the send buffer after this are written when it
+     * completes. */
+    if( pSqe != NULL )
+    {
+        pSqe->opcode = IORING_OP_WRITE_FIXED;
+        pSqe->fd = pTransport->socketDescriptor;
+        pSqe->addr = ( uint64_t ) ( uintptr_t ) pTransport->pSendBuffer;
+        pSqe->len = ( uint32_t ) pTransport->sendLength;
+        pSqe->off = ( uint64_t ) -1;
+        pSqe->buf_index = FIXED_BUFFER_INDEX;
+        pSqe->user_data = ( uint64_t ) ( uintptr_t ) pTransport | OPERATION_SEND;
+
+        pTransport->pendingOperations |= PENDING_SEND;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void reapCompletions( UringTransportRing_t * pRing )
+{
+    uint32_t head = *( pRing->pCqHead );
+    uint32_t tail = __atomic_load_n( pRing->pCqTail, __ATOMIC_ACQUIRE );
+    const struct io_uring_cqe * pCqe;
+
+    while( head != tail )
+    {
+        pCqe = &( pRing->pCqes[ head & pRing->cqMask ] );
+        handleCompletion( pCqe->user_data, pCqe->res );
+        head++;
+    }
+
+    __atomic_store_n( pRing->pCqHead, head, __ATOMIC_RELEASE );
+}
+
+/*-----------------------------------------------------------*/
+
+static void handleCompletion( uint64_t userData,
+                              int32_t result )
+{
+    const uint32_t operation = ( uint32_t ) ( userData & OPERATION_MASK );
+    UringTransport_t * pTransport = ( UringTransport_t * ) ( uintptr_t ) ( userData & ~( uint64_t ) OPERATION_MASK );
+    const bool retry = ( result == -EINTR ) || ( result == -EAGAIN );
+
+    if( operation == OPERATION_RECV )
+    {
+        pTransport->pendingOperations &= ( uint8_t ) ~PENDING_RECV;
+
+        if( result > 0 )
+        {
+            pTransport->recvStart = 0U;
+            pTransport->recvEnd = ( size_t ) result;
+            pushReady( pTransport );
+        }
+        else if( ( retry == true ) && ( pTransport->closed == false ) )
+        {
+            queueRecv( pTransport );
+        }
+        else
+        {
+            /* The peer closed the connection, or receiving failed. */
+            pTransport->closed = true;
+            pushReady( pTransport );
+        }
+    }
+    else if( operation == OPERATION_SEND )
+    {
+        pTransport->pendingOperations &= ( uint8_t ) ~PENDING_SEND;
+
+        if( result > 0 )
+        {
+            pTransport->sendLength -= ( size_t ) result;
+            ( void ) memmove( pTransport->pSendBuffer, &( pTransport->pSendBuffer[ result ] ),
+                              pTransport->sendLength );
+        }
+        else if( retry == false )
+        {
+            LogError( ( "Writing to the socket failed: result=%ld", ( long ) result ) );
+            pTransport->closed = true;
+            pushReady( pTransport );
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+
+        if( ( pTransport->sendLength > 0U ) && ( pTransport->closed == false ) )
+        {
+            queueSend( pTransport );
+        }
+    }
+    else if( operation == OPERATION_CANCEL )
+    {
+        pTransport->pendingOperations &= ( uint8_t ) ~PENDING_CANCEL;
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void pushReady( UringTransport_t * pTransport )
+{
+    UringTransportRing_t * pRing = pTransport->pRing;
+
+    if( pTransport->ready == false )
+    {
+        pTransport->ready = true;
+        pTransport->pNextReady = NULL;
+
+        if( pRing->pReadyTail == NULL )
+        {
+            pRing->pReadyHead = pTransport;
+        }
+        else
+        {
+            pRing->pReadyTail->pNextReady = pTransport;
+        }
+
+        pRing->pReadyTail = pTransport;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void removeReady( UringTransport_t * pTransport )
+{
+    UringTransportRing_t * pRing = pTransport->pRing;
+    UringTransport_t * pPrevious = NULL;
+    UringTransport_t * pCurrent = pRing->pReadyHead;
+
+    while( ( pTransport->ready == true ) && ( pCurrent != NULL ) )
+    {
+        if( pCurrent == pTransport )
+        {
+            if( pPrevious == NULL )
+            {
+                pRing->pReadyHead = pTransport->pNextReady;
+            }
+            else
+            {
+                pPrevious->pNextReady = pTransport->pNextReady;
+            }
+
+            if( pRing->pReadyTail == pTransport )
+            {
+                pRing->pReadyTail = pPrevious;
+            }
+
+            pTransport->ready = false;
+        }
+
+        pPrevious = pCurrent;
+        pCurrent = pCurrent->pNextReady;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static size_t appendToSendBuffer( UringTransport_t * pTransport,
+                                  const void * pBytes,
+                                  size_t length )
+{
+    size_t bytesCopied = pTransport->pRing->bufferSize - pTransport->sendLength;
+
+    if( bytesCopied > length )
+    {
+        bytesCopied = length;
+    }
+
+    if( bytesCopied > 0U )
+    {
+        ( void ) memcpy( &( pTransport->pSendBuffer[ pTransport->sendLength ] ), pBytes, bytesCopied );
+        pTransport->sendLength += bytesCopied;
+    }
+
+    return bytesCopied;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t takeReceived( UringTransport_t * pTransport,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+{
+    size_t bytesCopied = 0U;
+    int32_t result = -1;
+
+    if( ( pTransport->recvStart == pTransport->recvEnd ) && ( pTransport->closed == false ) )
+    {
+        if( ( pTransport->pendingOperations & PENDING_RECV ) == 0U )
+        {
+            queueRecv( pTransport );
+        }
+
+        /* Completions are posted without entering the ring, so the
+         * system call is only made to submit queued entries. */
+        if( pTransport->pRing->sqTail != *( pTransport->pRing->pSqTail ) )
+        {
+            ( void ) enterRing( pTransport->pRing, 0U );
+        }
+        else
+        {
+            reapCompletions( pTransport->pRing );
+        }
+    }
+
+    bytesCopied = pTransport->recvEnd - pTransport->recvStart;
+
+    if( bytesCopied > bytesToRecv )
+    {
+        bytesCopied = bytesToRecv;
+    }
+
+    /* The receive buffer holds at most INT32_MAX bytes. */
+    if( pBuffer != NULL )
+    {
+        ( void ) memcpy( pBuffer, &( pTransport->pRecvBuffer[ pTransport->recvStart ] ), bytesCopied );
+    }
+
+    pTransport->recvStart += bytesCopied;
+
+    if( pTransport->recvStart == pTransport->recvEnd )
+    {
+        if( pTransport->closed == false )
+        {
+            result = ( int32_t ) bytesCopied;
+
+            /* Submitted with the next batch. */
+            if( ( pTransport->pendingOperations & PENDING_RECV ) == 0U )
+            {
+                queueRecv( pTransport );
+            }
+        }
+        else if( bytesCopied > 0U )
+        {
+            /* The error is returned by the next call. */
+            result = ( int32_t ) bytesCopied;
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+    }
+    else
+    {
+        /* Return the connection from the next poll for the bytes left. */
+        result = ( int32_t ) bytesCopied;
+        pushReady( pTransport );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t getTimeMs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000U ) + ( ( uint64_t ) now.tv_nsec / 1000000U );
+}
+
+/*-----------------------------------------------------------*/
+
+UringTransportStatus_t UringTransport_InitRing( UringTransportRing_t * pRing,
+                                                uint32_t entryCount,
+                                                uint8_t * pBufferMemory,
+                                                size_t slotCount,
+                                                size_t bufferSize )
+{
+    UringTransportStatus_t status = UringTransportSuccess;
+    struct io_uring_params params;
+    struct iovec registeredMemory;
+    uint8_t * pSqRing;
+    uint8_t * pCqRing;
+    uint32_t i;
+    bool ringCleared = false;
+
+    if( ( pRing == NULL ) || ( pBufferMemory == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pRing=%p, pBufferMemory=%p",
+                    ( void * ) pRing,
+                    ( void * ) pBufferMemory ) );
+        status = UringTransportBadParameter;
+    }
+    else if( ( entryCount == 0U ) || ( slotCount == 0U ) || ( bufferSize == 0U ) ||
+             ( bufferSize > ( size_t ) INT32_MAX ) ||
+             ( slotCount > ( REGISTERED_SIZE_MAX / 2U / bufferSize ) ) )
+    {
+        LogError( ( "Invalid parameter: entryCount=%lu, slotCount=%lu, bufferSize=%lu",
+                    ( unsigned long ) entryCount,
+                    ( unsigned long ) slotCount,
+                    ( unsigned long ) bufferSize ) );
+        status = UringTransportBadParameter;
+    }
+    else
+    {
+        ( void ) memset( pRing, 0, sizeof( *pRing ) );
+        ( void ) memset( &params, 0, sizeof( params ) );
+        ringCleared = true;
+
+        /* Every connection can have a receive and a send in flight, so the
+         * completion queue is sized for all of them. */
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+        params.cq_entries = ( slotCount > ( ( size_t ) UINT32_MAX / 2U ) ) ? UINT32_MAX : ( uint32_t ) ( slotCount * 2U );
+
+        if( params.cq_entries < ( entryCount * 2U ) )
+        {
+            params.cq_entries = entryCount * 2U;
+        }
+
+        pRing->ringDescriptor = ( int ) syscall( __NR_io_uring_setup, entryCount, &params );
+
+        if( pRing->ringDescriptor < 0 )
+        {
+            LogError( ( "io_uring_setup failed: errno=%d", errno ) );
+            status = ( errno == ENOSYS ) ? UringTransportNotSupported : UringTransportSystemError;
+        }
+        else if( ( ( params.features & IORING_FEAT_NODROP ) == 0U ) ||
+                 ( ( params.features & IORING_FEAT_EXT_ARG ) == 0U ) )
+        {
+            LogError( ( "io_uring lacks needed features: features=0x%x", params.features ) );
+            status = UringTransportNotSupported;
+        }
+        else
+        {
+            /* Empty else MISRA 15.7 */
+        }
+    }
+
+    if( status == UringTransportSuccess )
+    {
+        pRing->sqRingSize = params.sq_off.array + ( params.sq_entries * sizeof( uint32_t ) );
+        pRing->cqRingSize = params.cq_off.cqes + ( params.cq_entries * sizeof( struct io_uring_cqe ) );
+        pRing->sqesSize = params.sq_entries * sizeof( struct io_uring_sqe );
+
+        pRing->pSqRing = mmap( NULL, pRing->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               pRing->ringDescriptor, IORING_OFF_SQ_RING );
+        pRing->pCqRing = mmap( NULL, pRing->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               pRing->ringDescriptor, IORING_OFF_CQ_RING );
+        pRing->pSqes = mmap( NULL, pRing->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             pRing->ringDescriptor, IORING_OFF_SQES );
+
+        if( ( pRing->pSqRing == MAP_FAILED ) || ( pRing->pCqRing == MAP_FAILED ) ||
+            ( pRing->pSqes == MAP_FAILED ) )
+        {
+            LogError( ( "Mapping the io_uring failed: errno=%d", errno ) );
+            status = UringTransportSystemError;
+        }
+    }
+
+    if( status == UringTransportSuccess )
+    {
+        pSqRing = ( uint8_t * ) pRing->pSqRing;
+        pCqRing = ( uint8_t * ) pRing->pCqRing;
+
+        pRing->pSqHead = ( uint32_t * ) &( pSqRing[ params.sq_off.head ] );
+        pRing->pSqTail = ( uint32_t * ) &( pSqRing[ params.sq_off.tail ] );
+        pRing->pSqArray = ( uint32_t * ) &( pSqRing[ params.sq_off.array ] );
+        pRing->sqMask = *( ( uint32_t * ) &( pSqRing[ params.sq_off.ring_mask ] ) );
+        pRing->sqEntryCount = params.sq_entries;
+        pRing->sqTail = *( pRing->pSqTail );
+
+        pRing->pCqHead = ( uint32_t * ) &( pCqRing[ params.cq_off.head ] );
+        pRing->pCqTail = ( uint32_t * ) &( pCqRing[ params.cq_off.tail ] );
+        pRing->pCqes = ( struct io_uring_cqe * ) &( pCqRing[ params.cq_off.cqes ] );
+        pRing->cqMask = *( ( uint32_t * ) &( pCqRing[ params.cq_off.ring_mask ] ) );
+
+        /* Entries are submitted in the order they are queued. */
+        for( i = 0U; i < params.sq_entries; i++ )
+        {
+            pRing->pSqArray[ i ] = i;
+        }
+
+        pRing->pBufferMemory = pBufferMemory;
+        pRing->slotCount = slotCount;
+        pRing->bufferSize = bufferSize;
+
+        registeredMemory.iov_base = pBufferMemory;
+        registeredMemory.iov_len = 2U * slotCount * bufferSize;
+
+        if( syscall( __NR_io_uring_register, pRing->ringDescriptor, IORING_REGISTER_BUFFERS,
+                     &registeredMemory, 1U ) < 0 )
+        {
+            LogError( ( "Registering the buffers failed: errno=%d", errno ) );
+            status = UringTransportSystemError;
+        }
+    }
+
+    /* A ring rejected by the parameter checks holds the caller's values,
+     * which are not released. */
+    if( ( status != UringTransportSuccess ) && ( ringCleared == true ) )
+    {
+        ( void ) UringTransport_CleanupRing( pRing );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+UringTransportStatus_t UringTransport_CleanupRing( UringTransportRing_t * pRing )
+{
+    UringTransportStatus_t status = UringTransportSuccess;
+
+    if( pRing == NULL )
+    {
+        LogError( ( "Argument cannot be NULL: pRing=%p", ( void * ) pRing ) );
+        status = UringTransportBadParameter;
+    }
+    else
+    {
+        if( ( pRing->pSqes != NULL ) && ( pRing->pSqes != MAP_FAILED ) )
+        {
+            ( void ) munmap( pRing->pSqes, pRing->sqesSize );
+        }
+
+        if( ( pRing->pCqRing != NULL ) && ( pRing->pCqRing != MAP_FAILED ) )
+        {
+            ( void ) munmap( pRing->pCqRing, pRing->cqRingSize );
+        }
+
+        if( ( pRing->pSqRing != NULL ) && ( pRing->pSqRing != MAP_FAILED ) )
+        {
+            ( void ) munmap( pRing->pSqRing, pRing->sqRingSize );
+        }
+
+        if( pRing->ringDescriptor >= 0 )
+        {
+            ( void ) close( pRing->ringDescriptor );
+        }
+
+        ( void ) memset( pRing, 0, sizeof( *pRing ) );
+        pRing->ringDescriptor = -1;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+UringTransportStatus_t UringTransport_Attach( UringTransportRing_t * pRing,
+                                              UringTransport_t * pTransport,
+                                              size_t slot,
+                                              int socketDescriptor )
+{
+    UringTransportStatus_t status = UringTransportSuccess;
+    int flags;
+
+    if( ( pRing == NULL ) || ( pTransport == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pRing=%p, pTransport=%p",
+                    ( void * ) pRing,
+                    ( void * ) pTransport ) );
+        status = UringTransportBadParameter;
+    }
+    else if( ( pRing->pBufferMemory == NULL ) || ( slot >= pRing->slotCount ) || ( socketDescriptor < 0 ) )
+    {
+        LogError( ( "Invalid parameter: The ring must be initialized, and slot=%lu must be "
+                    "less than %lu: socketDescriptor=%d",
+                    ( unsigned long ) slot,
+                    ( unsigned long ) pRing->slotCount,
+                    socketDescriptor ) );
+        status = UringTransportBadParameter;
+    }
+    else
+    {
+        /* io_uring fails operations on a non-blocking socket with EAGAIN
+         * instead of waiting for it. */
+        flags = fcntl( socketDescriptor, F_GETFL, 0 );
+
+        if( ( flags < 0 ) || ( fcntl( socketDescriptor, F_SETFL, flags & ~O_NONBLOCK ) < 0 ) )
+        {
+            LogError( ( "Failed to make the socket blocking: errno=%d", errno ) );
+            status = UringTransportSystemError;
+        }
+    }
+
+    if( status == UringTransportSuccess )
+    {
+        ( void ) memset( pTransport, 0, sizeof( *pTransport ) );
+        pTransport->pRing = pRing;
+        pTransport->socketDescriptor = socketDescriptor;
+        pTransport->pRecvBuffer = &( pRing->pBufferMemory[ slot * 2U * pRing->bufferSize ] );
+        pTransport->pSendBuffer = &( pTransport->pRecvBuffer[ pRing->bufferSize ] );
+
+        queueRecv( pTransport );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+UringTransportStatus_t UringTransport_Disconnect( UringTransport_t * pTransport,
+                                                  uint32_t timeoutMs )
+{
+    UringTransportStatus_t status = UringTransportSuccess;
+    UringTransportRing_t * pRing;
+    struct io_uring_sqe * pSqe;
+    uint64_t deadline;
+    uint64_t now;
+
+    if( ( pTransport == NULL ) || ( pTransport->pRing == NULL ) || ( pTransport->socketDescriptor < 0 ) )
+    {
+        LogError( ( "The connection must be attached: pTransport=%p", ( void * ) pTransport ) );
+        status = UringTransportBadParameter;
+    }
+    else
+    {
+        pRing = pTransport->pRing;
+        deadline = getTimeMs() + timeoutMs;
+        now = getTimeMs();
+
+        /* Write the bytes already accepted by the send functions. */
+        while( ( pTransport->sendLength > 0U ) && ( pTransport->closed == false ) && ( now < deadline ) )
+        {
+            if( ( pTransport->pendingOperations & PENDING_SEND ) == 0U )
+            {
+                queueSend( pTransport );
+            }
+
+            ( void ) enterRing( pRing, ( uint32_t ) ( deadline - now ) );
+            now = getTimeMs();
+        }
+
+        /* No operation is queued for the connection after this. */
+        pTransport->closed = true;
+
+        /* Cancel the receive, and a write that did not complete in time. The
+         * completion of the cancel refers to the connection, so it is waited
+         * for too. */
+        do
+        {
+            if( ( ( pTransport->pendingOperations & ( PENDING_RECV | PENDING_SEND ) ) != 0U ) &&
+                ( ( pTransport->pendingOperations & PENDING_CANCEL ) == 0U ) )
+            {
+                pSqe = getSqe( pRing );
+
+                if( pSqe != NULL )
+                {
+                    pSqe->opcode = IORING_OP_ASYNC_CANCEL;
+                    pSqe->fd = pTransport->socketDescriptor;
+                    pSqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+                    pSqe->user_data = ( uint64_t ) ( uintptr_t ) pTransport | OPERATION_CANCEL;
+                    pTransport->pendingOperations |= PENDING_CANCEL;
+                }
+            }
+
+            ( void ) enterRing( pRing, ( now < deadline ) ? ( uint32_t ) ( deadline - now ) : 1U );
+            now = getTimeMs();
+        } while( ( pTransport->pendingOperations != 0U ) && ( now < deadline ) );
+
+        /* The kernel may still use the buffers of the slot and the socket,
+         * so the connection stays attached until a later call finds its
+         * operations complete. */
+        if( pTransport->pendingOperations != 0U )
+        {
+            LogError( ( "Operations of the connection did not complete in time." ) );
+            status = UringTransportSystemError;
+        }
+        else
+        {
+            removeReady( pTransport );
+            ( void ) close( pTransport->socketDescriptor );
+            pTransport->socketDescriptor = -1;
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+UringTransportStatus_t UringTransport_Poll( UringTransportRing_t * pRing,
+                                            uint32_t timeoutMs,
+                                            UringTransport_t ** ppReady,
+                                            size_t readyCountMax,
+                                            size_t * pReadyCount )
+{
+    UringTransportStatus_t status = UringTransportSuccess;
+    UringTransport_t * pTransport;
+    size_t readyCount = 0U;
+
+    if( ( pRing == NULL ) || ( ppReady == NULL ) || ( pReadyCount == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pRing=%p, ppReady=%p, pReadyCount=%p",
+                    ( void * ) pRing,
+                    ( void * ) ppReady,
+                    ( void * ) pReadyCount ) );
+        status = UringTransportBadParameter;
+    }
+    else if( ( pRing->ringDescriptor < 0 ) || ( readyCountMax == 0U ) )
+    {
+        LogError( ( "Invalid parameter: The ring must be initialized, and readyCountMax=%lu "
+                    "must be > 0.",
+                    ( unsigned long ) readyCountMax ) );
+        status = UringTransportBadParameter;
+    }
+    else
+    {
+        /* Do not wait when connections are already ready. */
+        if( enterRing( pRing, ( pRing->pReadyHead == NULL ) ? timeoutMs : 0U ) == false )
+        {
+            status = UringTransportSystemError;
+        }
+
+        while( ( readyCount < readyCountMax ) && ( pRing->pReadyHead != NULL ) )
+        {
+            pTransport = pRing->pReadyHead;
+            pRing->pReadyHead = pTransport->pNextReady;
+            pTransport->ready = false;
+            ppReady[ readyCount ] = pTransport;
+            readyCount++;
+        }
+
+        if( pRing->pReadyHead == NULL )
+        {
+            pRing->pReadyTail = NULL;
+        }
+
+        *pReadyCount = readyCount;
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+void UringTransport_GetInterface( UringTransport_t * pTransport,
+                                  TransportInterface_t * pTransportInterface )
+{
+    if( ( pTransport == NULL ) || ( pTransportInterface == NULL ) )
+    {
+        LogError( ( "Arguments cannot be NULL: pTransport=%p, pTransportInterface=%p",
+                    ( void * ) pTransport,
+                    ( void * ) pTransportInterface ) );
+    }
+    else
+    {
+        pTransportInterface->recv = UringTransport_Recv;
+        pTransportInterface->send = UringTransport_Send;
+        pTransportInterface->writev = UringTransport_Writev;
+        pTransportInterface->waitReadable = UringTransport_WaitReadable;
+        pTransportInterface->skip = UringTransport_Skip;
+        pTransportInterface->pNetworkContext = ( NetworkContext_t * ) pTransport;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t UringTransport_Recv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+{
+    UringTransport_t * pTransport = getTransport( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pBuffer != NULL ) && ( bytesToRecv > 0U ) )
+    {
+        result = takeReceived( pTransport, pBuffer, bytesToRecv );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t UringTransport_Send( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend )
+{
+    TransportOutVector_t vector;
+
+    vector.iov_base = pBuffer;
+    vector.iov_len = bytesToSend;
+
+    return UringTransport_Writev( pNetworkContext, &vector, 1U );
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t UringTransport_Writev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount )
+{
+    UringTransport_t * pTransport = getTransport( pNetworkContext );
+    size_t bytesCopied = 0U;
+    size_t vectorBytes;
+    size_t i;
+    bool bufferFull = false;
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( pIoVec != NULL ) && ( pTransport->closed == false ) )
+    {
+        /* Make room by completing earlier writes if the buffer is full. */
+        if( pTransport->sendLength == pTransport->pRing->bufferSize )
+        {
+            ( void ) enterRing( pTransport->pRing, 0U );
+        }
+
+        /* Copying stops at the first vector that does not fit. */
+        for( i = 0U; ( i < ioVecCount ) && ( bufferFull == false ); i++ )
+        {
+            if( pIoVec[ i ].iov_base != NULL )
+            {
+                vectorBytes = appendToSendBuffer( pTransport, pIoVec[ i ].iov_base, pIoVec[ i ].iov_len );
+                bytesCopied += vectorBytes;
+                bufferFull = ( vectorBytes < pIoVec[ i ].iov_len );
+            }
+        }
+
+        /* Also queues a write that did not fit in the submission queue. */
+        if( ( pTransport->sendLength > 0U ) && ( ( pTransport->pendingOperations & PENDING_SEND ) == 0U ) )
+        {
+            queueSend( pTransport );
+        }
+
+        result = ( pTransport->closed == false ) ? ( int32_t ) bytesCopied : -1;
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t UringTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs )
+{
+    UringTransport_t * pTransport = getTransport( pNetworkContext );
+    uint64_t deadline;
+    uint64_t now;
+    int32_t result = -1;
+
+    if( pTransport != NULL )
+    {
+        deadline = getTimeMs() + timeoutMs;
+        now = getTimeMs();
+
+        if( ( ( pTransport->pendingOperations & PENDING_RECV ) == 0U ) &&
+            ( pTransport->recvStart == pTransport->recvEnd ) &&
+            ( pTransport->closed == false ) )
+        {
+            queueRecv( pTransport );
+        }
+
+        /* Completions of other connections also end the wait, so it is
+         * repeated until the receive of this one completes. */
+        result = 0;
+
+        while( ( pTransport->recvStart == pTransport->recvEnd ) &&
+               ( pTransport->closed == false ) &&
+               ( now < deadline ) &&
+               ( result == 0 ) )
+        {
+            if( enterRing( pTransport->pRing, ( uint32_t ) ( deadline - now ) ) == false )
+            {
+                result = -1;
+            }
+
+            now = getTimeMs();
+        }
+
+        if( ( pTransport->recvStart != pTransport->recvEnd ) || ( pTransport->closed == true ) )
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+int32_t UringTransport_Skip( NetworkContext_t * pNetworkContext,
+                             size_t bytesToSkip )
+{
+    UringTransport_t * pTransport = getTransport( pNetworkContext );
+    int32_t result = -1;
+
+    if( ( pTransport != NULL ) && ( bytesToSkip > 0U ) )
+    {
+        result = takeReceived( pTransport, NULL, bytesToSkip );
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
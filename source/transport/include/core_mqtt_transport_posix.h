@@ -0,0 +1,309 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_posix.h
+ * @brief Reference implementation of the transport interface over a
+ * non-blocking POSIX TCP socket.
+ */
+#ifndef CORE_MQTT_TRANSPORT_POSIX_H
+#define CORE_MQTT_TRANSPORT_POSIX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "transport_interface.h"
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Return codes of the POSIX transport functions.
+ */
+typedef enum PosixTransportStatus
+{
+    PosixTransportSuccess = 0,    /**< Function completed successfully. */
+    PosixTransportBadParameter,   /**< At least one parameter was invalid. */
+    PosixTransportDnsFailure,     /**< The host name could not be resolved. */
+    PosixTransportConnectFailure, /**< No address of the host accepted the connection in time. */
+    PosixTransportSocketError     /**< A socket could not be created or configured. */
+} PosixTransportStatus_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Socket options applied by #PosixTransport_Connect and
+ * #PosixTransport_Attach.
+ */
+typedef struct PosixTransportConfig
+{
+    /**
+     * @brief Whether to disable Nagle's algorithm with `TCP_NODELAY`.
+     */
+    bool noDelay;
+
+    /**
+     * @brief Size of the kernel send buffer set with `SO_SNDBUF`, or 0 to keep
+     * the system default.
+     */
+    int32_t sendBufferSize;
+
+    /**
+     * @brief Size of the kernel receive buffer set with `SO_RCVBUF`, or 0 to
+     * keep the system default.
+     */
+    int32_t recvBufferSize;
+
+    /**
+     * @brief Time to wait for #PosixTransport_Connect to connect to each
+     * address of the host.
+     */
+    uint32_t connectTimeoutMs;
+
+    /**
+     * @brief Optional buffer for bytes read ahead of what the MQTT library
+     * asked for, or NULL to read only the bytes asked for.
+     *
+     * The MQTT library reads the fixed header of a packet a byte at a time
+     * before it reads the rest of the packet. With a read-ahead buffer, one
+     * `readv` fills both the caller's buffer and this buffer, and the next
+     * calls to #PosixTransport_Recv are served without a system call.
+     */
+    uint8_t * pReadAheadBuffer;
+
+    /**
+     * @brief Size of pReadAheadBuffer.
+     */
+    size_t readAheadBufferSize;
+} PosixTransportConfig_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief State of a connection of the POSIX transport.
+ *
+ * The members are private to the transport. #PosixTransport_GetInterface
+ * fills a #TransportInterface_t with the transport functions and a pointer
+ * to this structure as the network context.
+ */
+typedef struct PosixTransport
+{
+    int socketDescriptor;       /**< @brief The connected socket, or -1. */
+    uint8_t * pReadAhead;       /**< @brief Buffer for bytes read ahead. */
+    size_t readAheadSize;       /**< @brief Size of pReadAhead. */
+    size_t readAheadStart;      /**< @brief Index of the first unread byte in pReadAhead. */
+    size_t readAheadEnd;        /**< @brief Index after the last unread byte in pReadAhead. */
+    bool skipWithTrunc;         /**< @brief Whether the socket discards bytes with `MSG_TRUNC`. */
+} PosixTransport_t;
+
+/**
+ * @brief Resolve a host name, connect a non-blocking TCP socket to it, and
+ * apply the socket options of a configuration.
+ *
+ * @param[out] pTransport The transport to connect.
+ * @param[in] pHostName Null-terminated host name or address of the server.
+ * @param[in] port TCP port of the server.
+ * @param[in] pConfig Socket options to apply.
+ *
+ * @return #PosixTransportBadParameter if invalid parameters are passed;
+ * #PosixTransportDnsFailure if the host name could not be resolved;
+ * #PosixTransportSocketError if the connected socket could not be configured;
+ * #PosixTransportConnectFailure if no address of the host could be connected
+ * to, including when a socket could not be created or configured for it;
+ * #PosixTransportSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * PosixTransport_t posixTransport;
+ * PosixTransportConfig_t config = { 0 };
+ * TransportInterface_t transport;
+ * uint8_t readAheadBuffer[ 1024 ];
+ *
+ * config.noDelay = true;
+ * config.connectTimeoutMs = 5000;
+ * config.pReadAheadBuffer = readAheadBuffer;
+ * config.readAheadBufferSize = sizeof( readAheadBuffer );
+ *
+ * if( PosixTransport_Connect( &posixTransport, "broker.example.com", 1883, &config ) ==
+ *     PosixTransportSuccess )
+ * {
+ *     PosixTransport_GetInterface( &posixTransport, &transport );
+ *
+ *     // Pass the transport interface to MQTT_Init.
+ * }
+ * @endcode
+ */
+/* @[declare_posixtransport_connect] */
+PosixTransportStatus_t PosixTransport_Connect( PosixTransport_t * pTransport,
+                                               const char * pHostName,
+                                               uint16_t port,
+                                               const PosixTransportConfig_t * pConfig );
+/* @[declare_posixtransport_connect] */
+
+/**
+ * @brief Use an already connected TCP socket for the transport, making it
+ * non-blocking and applying the socket options of a configuration.
+ *
+ * This is meant for sockets connected by the application, for example with
+ * its own name resolution or proxying. The transport owns the socket until
+ * #PosixTransport_Disconnect is called.
+ *
+ * @param[out] pTransport The transport to set up.
+ * @param[in] socketDescriptor The connected socket.
+ * @param[in] pConfig Socket options to apply.
+ *
+ * @return #PosixTransportBadParameter if invalid parameters are passed;
+ * #PosixTransportSocketError if the socket could not be configured;
+ * #PosixTransportSuccess otherwise.
+ */
+/* @[declare_posixtransport_attach] */
+PosixTransportStatus_t PosixTransport_Attach( PosixTransport_t * pTransport,
+                                              int socketDescriptor,
+                                              const PosixTransportConfig_t * pConfig );
+/* @[declare_posixtransport_attach] */
+
+/**
+ * @brief Close the socket of the transport.
+ *
+ * @param[in] pTransport The transport to disconnect.
+ *
+ * @return #PosixTransportBadParameter if invalid parameters are passed;
+ * #PosixTransportSuccess otherwise.
+ */
+/* @[declare_posixtransport_disconnect] */
+PosixTransportStatus_t PosixTransport_Disconnect( PosixTransport_t * pTransport );
+/* @[declare_posixtransport_disconnect] */
+
+/**
+ * @brief Fill a transport interface with the functions of the POSIX
+ * transport, including #PosixTransport_Writev.
+ *
+ * @param[in] pTransport The connected transport, used as the network context.
+ * @param[out] pTransportInterface The transport interface to fill.
+ */
+/* @[declare_posixtransport_getinterface] */
+void PosixTransport_GetInterface( PosixTransport_t * pTransport,
+                                  TransportInterface_t * pTransportInterface );
+/* @[declare_posixtransport_getinterface] */
+
+/**
+ * @brief Receive bytes without blocking, as described by #TransportRecv_t.
+ *
+ * Bytes already read ahead are returned first. When more are needed, a
+ * single `readv` reads into the rest of @p pBuffer and the read-ahead buffer.
+ *
+ * @param[in] pNetworkContext The #PosixTransport_t of the connection.
+ * @param[out] pBuffer Buffer to receive the bytes into.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes received; 0 if none are available;
+ * a negative value if the connection was closed or failed.
+ */
+/* @[declare_posixtransport_recv] */
+int32_t PosixTransport_Recv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv );
+/* @[declare_posixtransport_recv] */
+
+/**
+ * @brief Send bytes without blocking, as described by #TransportSend_t.
+ *
+ * @param[in] pNetworkContext The #PosixTransport_t of the connection.
+ * @param[in] pBuffer The bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return The number of bytes sent; 0 if the socket send buffer is full;
+ * a negative value if the connection failed.
+ */
+/* @[declare_posixtransport_send] */
+int32_t PosixTransport_Send( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend );
+/* @[declare_posixtransport_send] */
+
+/**
+ * @brief Send the bytes of several vectors with one system call, as
+ * described by #TransportWritev_t.
+ *
+ * @param[in] pNetworkContext The #PosixTransport_t of the connection.
+ * @param[in] pIoVec The vectors to send.
+ * @param[in] ioVecCount Number of vectors in @p pIoVec.
+ *
+ * @return The number of bytes sent; 0 if the socket send buffer is full;
+ * a negative value if the connection failed.
+ */
+/* @[declare_posixtransport_writev] */
+int32_t PosixTransport_Writev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount );
+/* @[declare_posixtransport_writev] */
+
+/**
+ * @brief Wait until bytes can be received, as described by
+ * #TransportWaitReadable_t.
+ *
+ * Returns at once when bytes read ahead are buffered, and otherwise waits for
+ * the socket with `poll`.
+ *
+ * @param[in] pNetworkContext The #PosixTransport_t of the connection.
+ * @param[in] timeoutMs Most time to wait.
+ *
+ * @return A positive value if bytes can be received or the connection closed;
+ * 0 if the timeout expired; a negative value if waiting failed.
+ */
+/* @[declare_posixtransport_waitreadable] */
+int32_t PosixTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs );
+/* @[declare_posixtransport_waitreadable] */
+
+/**
+ * @brief Discard received bytes, as described by #TransportSkip_t.
+ *
+ * Bytes read ahead are dropped first. On Linux, the bytes of a TCP socket are
+ * then discarded by the kernel with `MSG_TRUNC`, without copying them. Other
+ * sockets are read into a small buffer on the stack.
+ *
+ * @param[in] pNetworkContext The #PosixTransport_t of the connection.
+ * @param[in] bytesToSkip Number of bytes to discard.
+ *
+ * @return The number of bytes discarded; 0 if none are available;
+ * a negative value if the connection closed or failed.
+ */
+/* @[declare_posixtransport_skip] */
+int32_t PosixTransport_Skip( NetworkContext_t * pNetworkContext,
+                             size_t bytesToSkip );
+/* @[declare_posixtransport_skip] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_TRANSPORT_POSIX_H */
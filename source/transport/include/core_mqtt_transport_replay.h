@@ -0,0 +1,374 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_replay.h
+ * @brief A transport that records the bytes received over another transport,
+ * and a transport that replays them to the library without a network.
+ *
+ * A #ReplayRecorder_t wraps the transport interface of a live connection.
+ * Everything it receives is passed on to the library and also written to a
+ * file descriptor, as one record for each call of the receive function that
+ * returned bytes, with the time since recording started.
+ *
+ * A #ReplayTransport_t returns the bytes of a recording held in memory, one
+ * record at a time, so the library sees the reads of the recorded session.
+ * It returns them at once, or no earlier than they were received when it
+ * replays at the recorded pace. Bytes sent by the library are counted and
+ * discarded.
+ *
+ * A recording starts with the 4 bytes `CMQR` and a version, as a 32 bit
+ * little endian integer. Each record follows, made of the time it was
+ * received in nanoseconds since recording started, as a 64 bit little endian
+ * integer; the number of bytes, as a 32 bit little endian integer; and the
+ * bytes.
+ */
+#ifndef CORE_MQTT_TRANSPORT_REPLAY_H
+#define CORE_MQTT_TRANSPORT_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "transport_interface.h"
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Return codes of the replay transport functions.
+ */
+typedef enum ReplayTransportStatus
+{
+    ReplayTransportSuccess = 0,  /**< Function completed successfully. */
+    ReplayTransportBadParameter, /**< At least one parameter was invalid. */
+    ReplayTransportBadRecording, /**< The recording is not valid. */
+    ReplayTransportSystemError   /**< Writing the recording failed. */
+} ReplayTransportStatus_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Records the bytes received over a transport.
+ *
+ * The members are private to the transport. #ReplayRecorder_GetInterface
+ * fills a #TransportInterface_t with the recorder functions and a pointer to
+ * this structure as the network context.
+ */
+typedef struct ReplayRecorder
+{
+    TransportInterface_t transport; /**< @brief The transport being recorded. */
+    int fileDescriptor;             /**< @brief Where the records are written. */
+    uint64_t startNs;               /**< @brief When recording started. */
+    size_t recordCount;             /**< @brief Records written. */
+    bool failed;                    /**< @brief Whether writing a record failed, which stops recording. */
+} ReplayRecorder_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Replays a recording to the library.
+ *
+ * The members are private to the transport. #ReplayTransport_GetInterface
+ * fills a #TransportInterface_t with the replay functions and a pointer to
+ * this structure as the network context.
+ */
+typedef struct ReplayTransport
+{
+    const uint8_t * pRecording; /**< @brief The recording. */
+    size_t recordingLength;     /**< @brief Size of the recording. */
+    size_t nextRecord;          /**< @brief Offset of the first record not yet started. */
+    const uint8_t * pChunk;     /**< @brief Bytes of the current record not yet received. */
+    size_t chunkRemaining;      /**< @brief Number of bytes at @p pChunk. */
+    bool paced;                 /**< @brief Whether records are returned no earlier than they were recorded. */
+    uint64_t startNs;           /**< @brief When replaying started. */
+    uint64_t bytesSent;         /**< @brief Bytes sent by the library and discarded. */
+} ReplayTransport_t;
+
+/**
+ * @brief Start recording the bytes received over a transport.
+ *
+ * The header of the recording is written at once.
+ *
+ * @param[out] pRecorder The recorder to set up.
+ * @param[in] pTransport The transport to record, which is copied. Its
+ * optional skip function is not used, so that skipped bytes are recorded.
+ * @param[in] fileDescriptor Where to write the recording. The caller keeps
+ * ownership of it.
+ *
+ * @return #ReplayTransportBadParameter if invalid parameters are passed;
+ * #ReplayTransportSystemError if the header could not be written;
+ * #ReplayTransportSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * ReplayRecorder_t recorder;
+ * TransportInterface_t liveTransport = { 0 };
+ * TransportInterface_t transport;
+ * int fileDescriptor = open( "session.rec", O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+ *
+ * // Set up liveTransport for the connection to the broker, then:
+ * if( ReplayRecorder_Start( &recorder, &liveTransport, fileDescriptor ) == ReplayTransportSuccess )
+ * {
+ *     ReplayRecorder_GetInterface( &recorder, &transport );
+ *
+ *     // Pass the transport interface to MQTT_Init.
+ * }
+ * @endcode
+ */
+/* @[declare_replayrecorder_start] */
+ReplayTransportStatus_t ReplayRecorder_Start( ReplayRecorder_t * pRecorder,
+                                              const TransportInterface_t * pTransport,
+                                              int fileDescriptor );
+/* @[declare_replayrecorder_start] */
+
+/**
+ * @brief Fill a transport interface with the functions of a recorder.
+ *
+ * @param[in] pRecorder The recorder, used as the network context.
+ * @param[out] pTransportInterface The transport interface to fill.
+ */
+/* @[declare_replayrecorder_getinterface] */
+void ReplayRecorder_GetInterface( ReplayRecorder_t * pRecorder,
+                                  TransportInterface_t * pTransportInterface );
+/* @[declare_replayrecorder_getinterface] */
+
+/**
+ * @brief Receive bytes over the recorded transport and record them, as
+ * described by #TransportRecv_t.
+ *
+ * @param[in] pNetworkContext The #ReplayRecorder_t.
+ * @param[out] pBuffer Buffer to receive the bytes into.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The result of the receive function of the recorded transport.
+ */
+/* @[declare_replayrecorder_recv] */
+int32_t ReplayRecorder_Recv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv );
+/* @[declare_replayrecorder_recv] */
+
+/**
+ * @brief Send bytes over the recorded transport, as described by
+ * #TransportSend_t.
+ *
+ * @param[in] pNetworkContext The #ReplayRecorder_t.
+ * @param[in] pBuffer The bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return The result of the send function of the recorded transport.
+ */
+/* @[declare_replayrecorder_send] */
+int32_t ReplayRecorder_Send( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend );
+/* @[declare_replayrecorder_send] */
+
+/**
+ * @brief Send vectors over the recorded transport, as described by
+ * #TransportWritev_t.
+ *
+ * @param[in] pNetworkContext The #ReplayRecorder_t.
+ * @param[in] pIoVec The vectors to send.
+ * @param[in] ioVecCount Number of vectors in @p pIoVec.
+ *
+ * @return The result of the writev function of the recorded transport.
+ */
+/* @[declare_replayrecorder_writev] */
+int32_t ReplayRecorder_Writev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount );
+/* @[declare_replayrecorder_writev] */
+
+/**
+ * @brief Wait with the recorded transport, as described by
+ * #TransportWaitReadable_t. It is set in the interface only when the recorded
+ * transport has a wait function.
+ *
+ * @param[in] pNetworkContext The #ReplayRecorder_t.
+ * @param[in] timeoutMs Most time to wait.
+ *
+ * @return The result of the wait function of the recorded transport.
+ */
+/* @[declare_replayrecorder_waitreadable] */
+int32_t ReplayRecorder_WaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs );
+/* @[declare_replayrecorder_waitreadable] */
+
+/**
+ * @brief Set up replaying a recording.
+ *
+ * Every record is checked before replaying starts. The clock of a paced
+ * replay starts with this call.
+ *
+ * @param[out] pTransport The transport to set up.
+ * @param[in] pRecording The recording, which must stay valid while it is
+ * replayed.
+ * @param[in] recordingLength Size of the recording.
+ * @param[in] paced Whether to return each record no earlier than it was
+ * received in the recorded session, rather than at once.
+ *
+ * @return #ReplayTransportBadParameter if invalid parameters are passed;
+ * #ReplayTransportBadRecording if the recording has a bad header or a
+ * truncated record;
+ * #ReplayTransportSuccess otherwise.
+ */
+/* @[declare_replaytransport_open] */
+ReplayTransportStatus_t ReplayTransport_Open( ReplayTransport_t * pTransport,
+                                              const uint8_t * pRecording,
+                                              size_t recordingLength,
+                                              bool paced );
+/* @[declare_replaytransport_open] */
+
+/**
+ * @brief Start replaying a recording again from its first record.
+ *
+ * @param[in] pTransport The transport.
+ *
+ * @return #ReplayTransportBadParameter if invalid parameters are passed;
+ * #ReplayTransportSuccess otherwise.
+ */
+/* @[declare_replaytransport_rewind] */
+ReplayTransportStatus_t ReplayTransport_Rewind( ReplayTransport_t * pTransport );
+/* @[declare_replaytransport_rewind] */
+
+/**
+ * @brief Check whether every byte of a recording has been received.
+ *
+ * @param[in] pTransport The transport.
+ *
+ * @return true if every byte has been received or @p pTransport is NULL;
+ * false otherwise.
+ */
+/* @[declare_replaytransport_isfinished] */
+bool ReplayTransport_IsFinished( const ReplayTransport_t * pTransport );
+/* @[declare_replaytransport_isfinished] */
+
+/**
+ * @brief Fill a transport interface with the functions of the replay
+ * transport.
+ *
+ * @param[in] pTransport The transport, used as the network context.
+ * @param[out] pTransportInterface The transport interface to fill.
+ */
+/* @[declare_replaytransport_getinterface] */
+void ReplayTransport_GetInterface( ReplayTransport_t * pTransport,
+                                   TransportInterface_t * pTransportInterface );
+/* @[declare_replaytransport_getinterface] */
+
+/**
+ * @brief Copy bytes of the current record, as described by #TransportRecv_t.
+ *
+ * A call returns bytes of one record at most, so that the library receives
+ * them in the pieces the recorded session received them in.
+ *
+ * @param[in] pNetworkContext The #ReplayTransport_t.
+ * @param[out] pBuffer Buffer to receive the bytes into.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes received; 0 if the next record is not due yet
+ * or every record has been received; a negative value if the network
+ * context is not valid.
+ */
+/* @[declare_replaytransport_recv] */
+int32_t ReplayTransport_Recv( NetworkContext_t * pNetworkContext,
+                              void * pBuffer,
+                              size_t bytesToRecv );
+/* @[declare_replaytransport_recv] */
+
+/**
+ * @brief Discard bytes sent by the library, as described by #TransportSend_t.
+ *
+ * @param[in] pNetworkContext The #ReplayTransport_t.
+ * @param[in] pBuffer The bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return @p bytesToSend; a negative value if the network context is not
+ * valid.
+ */
+/* @[declare_replaytransport_send] */
+int32_t ReplayTransport_Send( NetworkContext_t * pNetworkContext,
+                              const void * pBuffer,
+                              size_t bytesToSend );
+/* @[declare_replaytransport_send] */
+
+/**
+ * @brief Discard vectors sent by the library, as described by
+ * #TransportWritev_t.
+ *
+ * @param[in] pNetworkContext The #ReplayTransport_t.
+ * @param[in] pIoVec The vectors to send.
+ * @param[in] ioVecCount Number of vectors in @p pIoVec.
+ *
+ * @return The number of bytes in the vectors; a negative value if the network
+ * context is not valid.
+ */
+/* @[declare_replaytransport_writev] */
+int32_t ReplayTransport_Writev( NetworkContext_t * pNetworkContext,
+                                TransportOutVector_t * pIoVec,
+                                size_t ioVecCount );
+/* @[declare_replaytransport_writev] */
+
+/**
+ * @brief Wait until the next record is due, as described by
+ * #TransportWaitReadable_t.
+ *
+ * @param[in] pNetworkContext The #ReplayTransport_t.
+ * @param[in] timeoutMs Most time to wait.
+ *
+ * @return A positive value if bytes can be received; 0 if the timeout
+ * expired first, which it always does once every record has been received;
+ * a negative value if the network context is not valid.
+ */
+/* @[declare_replaytransport_waitreadable] */
+int32_t ReplayTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                      uint32_t timeoutMs );
+/* @[declare_replaytransport_waitreadable] */
+
+/**
+ * @brief Discard bytes of the current record, as described by
+ * #TransportSkip_t.
+ *
+ * @param[in] pNetworkContext The #ReplayTransport_t.
+ * @param[in] bytesToSkip Number of bytes to discard.
+ *
+ * @return The number of bytes discarded, as for #ReplayTransport_Recv.
+ */
+/* @[declare_replaytransport_skip] */
+int32_t ReplayTransport_Skip( NetworkContext_t * pNetworkContext,
+                              size_t bytesToSkip );
+/* @[declare_replaytransport_skip] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_TRANSPORT_REPLAY_H */
@@ -0,0 +1,283 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_shm.h
+ * @brief Implementation of the transport interface over shared memory, for
+ * processes on the same Linux host.
+ *
+ * A segment created with `memfd_create` holds two single-producer,
+ * single-consumer byte rings, one for each direction. Sending copies bytes
+ * into one ring and receiving copies them out of the other, without a system
+ * call. A process waiting for bytes with #ShmTransport_Wait sleeps on a futex
+ * in the segment, and is woken by the sender only while it waits.
+ */
+#ifndef CORE_MQTT_TRANSPORT_SHM_H
+#define CORE_MQTT_TRANSPORT_SHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "transport_interface.h"
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Return codes of the shared memory transport functions.
+ */
+typedef enum ShmTransportStatus
+{
+    ShmTransportSuccess = 0,  /**< Function completed successfully. */
+    ShmTransportBadParameter, /**< At least one parameter was invalid, or the segment was not valid. */
+    ShmTransportSystemError,  /**< A system call failed. */
+    ShmTransportTimeout       /**< No bytes arrived in time. */
+} ShmTransportStatus_t;
+
+struct ShmTransportRing;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief One end of a shared memory connection.
+ *
+ * The members are private to the transport. #ShmTransport_GetInterface
+ * fills a #TransportInterface_t with the transport functions and a pointer
+ * to this structure as the network context.
+ */
+typedef struct ShmTransport
+{
+    int segmentDescriptor;                /**< @brief The memfd of the segment, or -1. */
+    void * pSegment;                      /**< @brief Mapping of the segment. */
+    size_t segmentSize;                   /**< @brief Size of the segment. */
+    uint32_t ringSize;                    /**< @brief Size of each ring, a power of 2. */
+
+    struct ShmTransportRing * pSendRing;  /**< @brief Control block of the ring this end writes. */
+    uint8_t * pSendData;                  /**< @brief Bytes of the ring this end writes. */
+    struct ShmTransportRing * pRecvRing;  /**< @brief Control block of the ring this end reads. */
+    uint8_t * pRecvData;                  /**< @brief Bytes of the ring this end reads. */
+} ShmTransport_t;
+
+/**
+ * @brief Create a shared memory segment and use it as the first end of a
+ * connection.
+ *
+ * The descriptor of the segment, `pTransport->segmentDescriptor`, is given to
+ * the other process, by inheriting it across `fork` or by sending it over a
+ * UNIX domain socket, which passes it to #ShmTransport_Open. It is closed on
+ * exec.
+ *
+ * @param[out] pTransport The end to set up.
+ * @param[in] ringSize Size of the ring for each direction. It must be a power
+ * of 2 of at least 64 bytes and at most 1 GiB.
+ *
+ * @return #ShmTransportBadParameter if invalid parameters are passed;
+ * #ShmTransportSystemError if the segment could not be created;
+ * #ShmTransportSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * ShmTransport_t shmTransport;
+ * TransportInterface_t transport;
+ *
+ * if( ShmTransport_Create( &shmTransport, 65536 ) == ShmTransportSuccess )
+ * {
+ *     if( fork() == 0 )
+ *     {
+ *         // The broker process uses the other end.
+ *         ShmTransport_t brokerEnd;
+ *
+ *         ShmTransport_Open( &brokerEnd, dup( shmTransport.segmentDescriptor ) );
+ *     }
+ *     else
+ *     {
+ *         ShmTransport_GetInterface( &shmTransport, &transport );
+ *
+ *         // Pass the transport interface to MQTT_Init.
+ *     }
+ * }
+ * @endcode
+ */
+/* @[declare_shmtransport_create] */
+ShmTransportStatus_t ShmTransport_Create( ShmTransport_t * pTransport,
+                                          uint32_t ringSize );
+/* @[declare_shmtransport_create] */
+
+/**
+ * @brief Map a segment created by #ShmTransport_Create and use it as the
+ * second end of the connection.
+ *
+ * @param[out] pTransport The end to set up.
+ * @param[in] segmentDescriptor The descriptor of the segment. The transport
+ * owns it from then on, even if the call fails.
+ *
+ * @return #ShmTransportBadParameter if invalid parameters are passed or the
+ * descriptor is not a segment of this transport;
+ * #ShmTransportSystemError if the segment could not be mapped;
+ * #ShmTransportSuccess otherwise.
+ */
+/* @[declare_shmtransport_open] */
+ShmTransportStatus_t ShmTransport_Open( ShmTransport_t * pTransport,
+                                        int segmentDescriptor );
+/* @[declare_shmtransport_open] */
+
+/**
+ * @brief Close one end of a connection.
+ *
+ * The other end receives the bytes already sent, and then an error. The
+ * segment is freed once both ends have closed it.
+ *
+ * @param[in] pTransport The end to close.
+ *
+ * @return #ShmTransportBadParameter if invalid parameters are passed;
+ * #ShmTransportSuccess otherwise.
+ */
+/* @[declare_shmtransport_disconnect] */
+ShmTransportStatus_t ShmTransport_Disconnect( ShmTransport_t * pTransport );
+/* @[declare_shmtransport_disconnect] */
+
+/**
+ * @brief Wait until bytes can be received, or the other end has closed.
+ *
+ * Call this before #MQTT_ProcessLoop instead of polling the receive function.
+ *
+ * @param[in] pTransport The end to wait on.
+ * @param[in] timeoutMs Most time to wait, or 0 to only check.
+ *
+ * @return #ShmTransportBadParameter if invalid parameters are passed;
+ * #ShmTransportTimeout if no bytes arrived in time;
+ * #ShmTransportSuccess otherwise.
+ */
+/* @[declare_shmtransport_wait] */
+ShmTransportStatus_t ShmTransport_Wait( ShmTransport_t * pTransport,
+                                        uint32_t timeoutMs );
+/* @[declare_shmtransport_wait] */
+
+/**
+ * @brief Fill a transport interface with the functions of the shared memory
+ * transport.
+ *
+ * @param[in] pTransport The end, used as the network context.
+ * @param[out] pTransportInterface The transport interface to fill.
+ */
+/* @[declare_shmtransport_getinterface] */
+void ShmTransport_GetInterface( ShmTransport_t * pTransport,
+                                TransportInterface_t * pTransportInterface );
+/* @[declare_shmtransport_getinterface] */
+
+/**
+ * @brief Copy bytes out of the receive ring, as described by
+ * #TransportRecv_t.
+ *
+ * @param[in] pNetworkContext The #ShmTransport_t of the end.
+ * @param[out] pBuffer Buffer to receive the bytes into.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes received; 0 if none are available;
+ * a negative value if the other end has closed and every byte has been
+ * received.
+ */
+/* @[declare_shmtransport_recv] */
+int32_t ShmTransport_Recv( NetworkContext_t * pNetworkContext,
+                           void * pBuffer,
+                           size_t bytesToRecv );
+/* @[declare_shmtransport_recv] */
+
+/**
+ * @brief Copy bytes into the send ring, as described by #TransportSend_t.
+ *
+ * @param[in] pNetworkContext The #ShmTransport_t of the end.
+ * @param[in] pBuffer The bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return The number of bytes copied; 0 if the ring is full;
+ * a negative value if the other end has closed.
+ */
+/* @[declare_shmtransport_send] */
+int32_t ShmTransport_Send( NetworkContext_t * pNetworkContext,
+                           const void * pBuffer,
+                           size_t bytesToSend );
+/* @[declare_shmtransport_send] */
+
+/**
+ * @brief Copy the bytes of several vectors into the send ring, as described
+ * by #TransportWritev_t. The other end sees them all at once.
+ *
+ * @param[in] pNetworkContext The #ShmTransport_t of the end.
+ * @param[in] pIoVec The vectors to send.
+ * @param[in] ioVecCount Number of vectors in @p pIoVec.
+ *
+ * @return The number of bytes copied; 0 if the ring is full;
+ * a negative value if the other end has closed.
+ */
+/* @[declare_shmtransport_writev] */
+int32_t ShmTransport_Writev( NetworkContext_t * pNetworkContext,
+                             TransportOutVector_t * pIoVec,
+                             size_t ioVecCount );
+/* @[declare_shmtransport_writev] */
+
+/**
+ * @brief Wait until bytes can be received, as described by
+ * #TransportWaitReadable_t, with #ShmTransport_Wait.
+ *
+ * @param[in] pNetworkContext The #ShmTransport_t of the end.
+ * @param[in] timeoutMs Most time to wait.
+ *
+ * @return A positive value if bytes can be received or the other end has
+ * closed; 0 if the timeout expired; a negative value if waiting failed.
+ */
+/* @[declare_shmtransport_waitreadable] */
+int32_t ShmTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                   uint32_t timeoutMs );
+/* @[declare_shmtransport_waitreadable] */
+
+/**
+ * @brief Discard received bytes, as described by #TransportSkip_t, by moving
+ * the head of the receive ring past them.
+ *
+ * @param[in] pNetworkContext The #ShmTransport_t of the end.
+ * @param[in] bytesToSkip Number of bytes to discard.
+ *
+ * @return The number of bytes discarded; 0 if none are available;
+ * a negative value if the other end has closed and every byte has been
+ * received.
+ */
+/* @[declare_shmtransport_skip] */
+int32_t ShmTransport_Skip( NetworkContext_t * pNetworkContext,
+                           size_t bytesToSkip );
+/* @[declare_shmtransport_skip] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_TRANSPORT_SHM_H */
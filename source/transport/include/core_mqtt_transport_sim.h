@@ -0,0 +1,302 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_sim.h
+ * @brief A transport that wraps another one and impairs it, to test and
+ * measure how the library copes with partial reads and writes, slow links and
+ * transports that return no bytes.
+ *
+ * Each impairment is set in a #SimTransportConfig_t and is off when its
+ * member is 0:
+ *
+ * - Receives and sends are cut to a most number of bytes, down to 1 byte.
+ * - A share of receives and sends return 0 without calling the wrapped
+ *   transport.
+ * - A share of writev calls send only part of the bytes, cut at a random
+ *   point.
+ * - The bytes of each direction are limited to a rate, by a token bucket
+ *   holding #SIM_TRANSPORT_BURST_MS of bytes.
+ * - Received bytes are held for a latency before the library gets them, in
+ *   a queue of #SIM_TRANSPORT_DELAY_BUFFER_SIZE bytes.
+ *
+ * The random choices come from a generator seeded by the configuration, so a
+ * run sees the same impairments whenever the library makes the same calls.
+ */
+#ifndef CORE_MQTT_TRANSPORT_SIM_H
+#define CORE_MQTT_TRANSPORT_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "transport_interface.h"
+
+/**
+ * @brief Size of the queue holding received bytes during the latency.
+ *
+ * Bytes are not received from the wrapped transport while the queue is full.
+ */
+#ifndef SIM_TRANSPORT_DELAY_BUFFER_SIZE
+    #define SIM_TRANSPORT_DELAY_BUFFER_SIZE    ( 65536U )
+#endif
+
+/**
+ * @brief Most pieces of received bytes held during the latency.
+ */
+#ifndef SIM_TRANSPORT_DELAY_CHUNKS
+    #define SIM_TRANSPORT_DELAY_CHUNKS    ( 256U )
+#endif
+
+/**
+ * @brief Time of bytes a direction limited to a rate may send at once after
+ * being idle.
+ */
+#ifndef SIM_TRANSPORT_BURST_MS
+    #define SIM_TRANSPORT_BURST_MS    ( 10U )
+#endif
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Return codes of the simulated transport functions.
+ */
+typedef enum SimTransportStatus
+{
+    SimTransportSuccess = 0, /**< Function completed successfully. */
+    SimTransportBadParameter /**< At least one parameter was invalid. */
+} SimTransportStatus_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Impairments of a simulated transport. A member of 0 turns its
+ * impairment off.
+ */
+typedef struct SimTransportConfig
+{
+    uint32_t seed;                    /**< @brief Seed of the random choices. */
+    size_t maxRecvSize;               /**< @brief Most bytes returned by one receive. */
+    size_t maxSendSize;               /**< @brief Most bytes taken by one send or writev. */
+    uint32_t zeroRecvPercent;         /**< @brief Percentage of receives that return 0. */
+    uint32_t zeroSendPercent;         /**< @brief Percentage of sends and writev calls that return 0. */
+    uint32_t shortWritevPercent;      /**< @brief Percentage of writev calls that send only part of the bytes. */
+    uint32_t latencyUs;               /**< @brief Time received bytes are held before the library gets them. */
+    uint64_t recvBytesPerSecond;      /**< @brief Rate of received bytes. */
+    uint64_t sendBytesPerSecond;      /**< @brief Rate of sent bytes. */
+} SimTransportConfig_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief Counts of the impairments a simulated transport applied.
+ */
+typedef struct SimTransportStats
+{
+    uint64_t bytesReceived; /**< @brief Bytes returned to the library. */
+    uint64_t bytesSent;     /**< @brief Bytes sent by the wrapped transport. */
+    uint64_t zeroRecvs;     /**< @brief Receives that returned 0, injected or not. */
+    uint64_t zeroSends;     /**< @brief Sends and writev calls that returned 0, injected or not. */
+    uint64_t shortWrites;   /**< @brief Sends and writev calls cut by an impairment. */
+} SimTransportStats_t;
+
+/**
+ * @brief A piece of received bytes held during the latency.
+ */
+typedef struct SimTransportChunk
+{
+    uint64_t readyNs; /**< @brief When the library may receive the bytes. */
+    uint32_t length;  /**< @brief Number of bytes left in the piece. */
+} SimTransportChunk_t;
+
+/**
+ * @brief A token bucket limiting one direction to a rate.
+ */
+typedef struct SimTransportBucket
+{
+    uint64_t tokens;    /**< @brief Bytes that may pass now. */
+    uint64_t updatedNs; /**< @brief When tokens were last added. */
+} SimTransportBucket_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A transport that impairs another one.
+ *
+ * The members are private to the transport. #SimTransport_GetInterface
+ * fills a #TransportInterface_t with the simulated transport functions and a
+ * pointer to this structure as the network context.
+ */
+typedef struct SimTransport
+{
+    TransportInterface_t transport;                          /**< @brief The wrapped transport. */
+    SimTransportConfig_t config;                             /**< @brief The impairments. */
+    uint32_t randomState;                                    /**< @brief State of the random generator. */
+    SimTransportBucket_t recvBucket;                         /**< @brief Rate limit of received bytes. */
+    SimTransportBucket_t sendBucket;                         /**< @brief Rate limit of sent bytes. */
+    uint8_t delayed[ SIM_TRANSPORT_DELAY_BUFFER_SIZE ];      /**< @brief Received bytes held during the latency. */
+    size_t delayedHead;                                      /**< @brief Offset of the first held byte. */
+    size_t delayedCount;                                     /**< @brief Number of held bytes. */
+    SimTransportChunk_t chunks[ SIM_TRANSPORT_DELAY_CHUNKS ]; /**< @brief Pieces of the held bytes. */
+    size_t chunkHead;                                        /**< @brief Index of the first piece. */
+    size_t chunkCount;                                       /**< @brief Number of pieces. */
+    SimTransportStats_t stats;                               /**< @brief Counts of the impairments applied. */
+} SimTransport_t;
+
+/**
+ * @brief Set up a simulated transport over another transport.
+ *
+ * @param[out] pTransport The transport to set up.
+ * @param[in] pWrapped The transport to impair, which is copied. Its optional
+ * skip function is not used, so that skipped bytes are impaired too.
+ * @param[in] pConfig The impairments, which are copied.
+ *
+ * @return #SimTransportBadParameter if invalid parameters are passed;
+ * #SimTransportSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * static SimTransport_t simTransport;
+ * SimTransportConfig_t config = { 0 };
+ * TransportInterface_t socketTransport = { 0 };
+ * TransportInterface_t transport;
+ *
+ * // Receive one byte at a time, and fail a tenth of the sends.
+ * config.seed = 1U;
+ * config.maxRecvSize = 1U;
+ * config.zeroSendPercent = 10U;
+ *
+ * // Set up socketTransport for the connection to the broker, then:
+ * if( SimTransport_Init( &simTransport, &socketTransport, &config ) == SimTransportSuccess )
+ * {
+ *     SimTransport_GetInterface( &simTransport, &transport );
+ *
+ *     // Pass the transport interface to MQTT_Init.
+ * }
+ * @endcode
+ */
+/* @[declare_simtransport_init] */
+SimTransportStatus_t SimTransport_Init( SimTransport_t * pTransport,
+                                        const TransportInterface_t * pWrapped,
+                                        const SimTransportConfig_t * pConfig );
+/* @[declare_simtransport_init] */
+
+/**
+ * @brief Fill a transport interface with the functions of a simulated
+ * transport.
+ *
+ * The writev and wait functions are set only when the wrapped transport has
+ * them, so the library calls the same functions it would call without the
+ * simulation.
+ *
+ * @param[in] pTransport The transport, used as the network context.
+ * @param[out] pTransportInterface The transport interface to fill.
+ */
+/* @[declare_simtransport_getinterface] */
+void SimTransport_GetInterface( SimTransport_t * pTransport,
+                                TransportInterface_t * pTransportInterface );
+/* @[declare_simtransport_getinterface] */
+
+/**
+ * @brief Receive bytes from the wrapped transport with the impairments, as
+ * described by #TransportRecv_t.
+ *
+ * @param[in] pNetworkContext The #SimTransport_t.
+ * @param[out] pBuffer Buffer to receive the bytes into.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes received; 0 if none can be received now; a
+ * negative value if the wrapped transport failed or the network context is
+ * not valid.
+ */
+/* @[declare_simtransport_recv] */
+int32_t SimTransport_Recv( NetworkContext_t * pNetworkContext,
+                           void * pBuffer,
+                           size_t bytesToRecv );
+/* @[declare_simtransport_recv] */
+
+/**
+ * @brief Send bytes over the wrapped transport with the impairments, as
+ * described by #TransportSend_t.
+ *
+ * @param[in] pNetworkContext The #SimTransport_t.
+ * @param[in] pBuffer The bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return The number of bytes sent; 0 if none can be sent now; a negative
+ * value if the wrapped transport failed or the network context is not valid.
+ */
+/* @[declare_simtransport_send] */
+int32_t SimTransport_Send( NetworkContext_t * pNetworkContext,
+                           const void * pBuffer,
+                           size_t bytesToSend );
+/* @[declare_simtransport_send] */
+
+/**
+ * @brief Send vectors over the wrapped transport with the impairments, as
+ * described by #TransportWritev_t.
+ *
+ * @param[in] pNetworkContext The #SimTransport_t.
+ * @param[in] pIoVec The vectors to send.
+ * @param[in] ioVecCount Number of vectors in @p pIoVec.
+ *
+ * @return The number of bytes sent; 0 if none can be sent now; a negative
+ * value if the wrapped transport failed or the network context is not valid.
+ */
+/* @[declare_simtransport_writev] */
+int32_t SimTransport_Writev( NetworkContext_t * pNetworkContext,
+                             TransportOutVector_t * pIoVec,
+                             size_t ioVecCount );
+/* @[declare_simtransport_writev] */
+
+/**
+ * @brief Wait until bytes can be received, as described by
+ * #TransportWaitReadable_t.
+ *
+ * Held bytes are waited for until they are due. Otherwise the wait function
+ * of the wrapped transport is called.
+ *
+ * @param[in] pNetworkContext The #SimTransport_t.
+ * @param[in] timeoutMs Most time to wait.
+ *
+ * @return A positive value if bytes may be received; 0 if the timeout
+ * expired; a negative value if the network context is not valid or waiting
+ * failed.
+ */
+/* @[declare_simtransport_waitreadable] */
+int32_t SimTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                   uint32_t timeoutMs );
+/* @[declare_simtransport_waitreadable] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_TRANSPORT_SIM_H */
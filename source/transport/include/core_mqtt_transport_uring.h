@@ -0,0 +1,388 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_uring.h
+ * @brief Implementation of the transport interface for Linux io_uring, with
+ * many connections sharing one ring.
+ *
+ * Each connection owns a receive buffer and a send buffer, carved from one
+ * block of memory that is registered with the ring, so that reads and writes
+ * use fixed buffers. Receives and sends are queued on the ring and submitted
+ * together, for every connection, by one system call in #UringTransport_Poll.
+ * The transport receive function copies from the connection's receive buffer,
+ * and the transport send functions copy into its send buffer, so they never
+ * wait for the kernel.
+ */
+#ifndef CORE_MQTT_TRANSPORT_URING_H
+#define CORE_MQTT_TRANSPORT_URING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <linux/io_uring.h>
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    extern "C" {
+#endif
+/* *INDENT-ON* */
+
+#include "transport_interface.h"
+
+/**
+ * @ingroup mqtt_enum_types
+ * @brief Return codes of the io_uring transport functions.
+ */
+typedef enum UringTransportStatus
+{
+    UringTransportSuccess = 0,  /**< Function completed successfully. */
+    UringTransportBadParameter, /**< At least one parameter was invalid. */
+    UringTransportNotSupported, /**< The kernel lacks a needed io_uring feature. */
+    UringTransportSystemError   /**< A system call failed. */
+} UringTransportStatus_t;
+
+struct UringTransport;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief An io_uring shared by the connections of the io_uring transport.
+ *
+ * The members are private to the transport.
+ */
+typedef struct UringTransportRing
+{
+    int ringDescriptor;                /**< @brief The io_uring file descriptor. */
+
+    uint8_t * pBufferMemory;           /**< @brief Registered memory holding the buffers of every slot. */
+    size_t slotCount;                  /**< @brief Number of connection slots. */
+    size_t bufferSize;                 /**< @brief Size of each receive and send buffer. */
+
+    void * pSqRing;                    /**< @brief Mapping of the submission queue ring. */
+    size_t sqRingSize;                 /**< @brief Size of pSqRing. */
+    void * pCqRing;                    /**< @brief Mapping of the completion queue ring. */
+    size_t cqRingSize;                 /**< @brief Size of pCqRing. */
+    struct io_uring_sqe * pSqes;       /**< @brief Mapping of the submission queue entries. */
+    size_t sqesSize;                   /**< @brief Size of pSqes. */
+
+    uint32_t * pSqHead;                /**< @brief Head of the submission queue, moved by the kernel. */
+    uint32_t * pSqTail;                /**< @brief Tail of the submission queue, moved by the transport. */
+    uint32_t * pSqArray;               /**< @brief Indices of the submitted entries. */
+    uint32_t sqMask;                   /**< @brief Mask of submission queue indices. */
+    uint32_t sqEntryCount;             /**< @brief Number of submission queue entries. */
+    uint32_t sqTail;                   /**< @brief Tail including entries queued but not yet submitted. */
+
+    uint32_t * pCqHead;                /**< @brief Head of the completion queue, moved by the transport. */
+    uint32_t * pCqTail;                /**< @brief Tail of the completion queue, moved by the kernel. */
+    struct io_uring_cqe * pCqes;       /**< @brief The completion queue entries. */
+    uint32_t cqMask;                   /**< @brief Mask of completion queue indices. */
+
+    struct UringTransport * pReadyHead; /**< @brief First connection with received bytes or a closed socket. */
+    struct UringTransport * pReadyTail; /**< @brief Last connection with received bytes or a closed socket. */
+} UringTransportRing_t;
+
+/**
+ * @ingroup mqtt_struct_types
+ * @brief A connection of the io_uring transport.
+ *
+ * The members are private to the transport. #UringTransport_GetInterface
+ * fills a #TransportInterface_t with the transport functions and a pointer
+ * to this structure as the network context.
+ */
+typedef struct UringTransport
+{
+    UringTransportRing_t * pRing;  /**< @brief The ring of the connection. */
+    int socketDescriptor;          /**< @brief The connected socket, or -1. */
+
+    uint8_t * pRecvBuffer;         /**< @brief Registered buffer the kernel reads into. */
+    size_t recvStart;              /**< @brief Index of the first byte not yet returned by recv. */
+    size_t recvEnd;                /**< @brief Index after the last byte read by the kernel. */
+
+    uint8_t * pSendBuffer;         /**< @brief Registered buffer the kernel writes from. */
+    size_t sendLength;             /**< @brief Number of bytes in pSendBuffer not yet written. */
+
+    uint8_t pendingOperations;     /**< @brief Operations submitted or queued on the ring. */
+    bool closed;                   /**< @brief Whether the peer closed the connection or it failed. */
+    bool ready;                    /**< @brief Whether the connection is in the ready list of the ring. */
+    struct UringTransport * pNextReady; /**< @brief Next connection in the ready list. */
+} UringTransport_t;
+
+/**
+ * @brief Set up an io_uring and register the memory for the buffers of its
+ * connections.
+ *
+ * @param[out] pRing The ring to set up.
+ * @param[in] entryCount Number of submission queue entries. Receives and
+ * sends queued beyond this are submitted early.
+ * @param[in] pBufferMemory Memory for the buffers, of
+ * `2 * slotCount * bufferSize` bytes. It must stay valid until
+ * #UringTransport_CleanupRing is called.
+ * @param[in] slotCount Number of connections that can use the ring.
+ * @param[in] bufferSize Size of the receive buffer and of the send buffer of
+ * each connection.
+ *
+ * @return #UringTransportBadParameter if invalid parameters are passed;
+ * #UringTransportNotSupported if the kernel lacks io_uring or one of its
+ * needed features;
+ * #UringTransportSystemError if a system call failed;
+ * #UringTransportSuccess otherwise.
+ *
+ * <b>Example</b>
+ * @code{c}
+ *
+ * // Variables used in this example.
+ * #define CONNECTION_COUNT    1024
+ * #define BUFFER_SIZE         4096
+ *
+ * static uint8_t bufferMemory[ 2 * CONNECTION_COUNT * BUFFER_SIZE ];
+ * UringTransportRing_t ring;
+ * UringTransport_t connections[ CONNECTION_COUNT ];
+ * TransportInterface_t transport;
+ *
+ * if( UringTransport_InitRing( &ring, 256, bufferMemory,
+ *                              CONNECTION_COUNT, BUFFER_SIZE ) == UringTransportSuccess )
+ * {
+ *     // For each connected socket.
+ *     UringTransport_Attach( &ring, &connections[ 0 ], 0, socketDescriptor );
+ *     UringTransport_GetInterface( &connections[ 0 ], &transport );
+ *
+ *     // Pass the transport interface to MQTT_Init.
+ * }
+ * @endcode
+ */
+/* @[declare_uringtransport_initring] */
+UringTransportStatus_t UringTransport_InitRing( UringTransportRing_t * pRing,
+                                                uint32_t entryCount,
+                                                uint8_t * pBufferMemory,
+                                                size_t slotCount,
+                                                size_t bufferSize );
+/* @[declare_uringtransport_initring] */
+
+/**
+ * @brief Close an io_uring and release its mappings.
+ *
+ * Every connection must be disconnected first.
+ *
+ * @param[in] pRing The ring to close.
+ *
+ * @return #UringTransportBadParameter if invalid parameters are passed;
+ * #UringTransportSuccess otherwise.
+ */
+/* @[declare_uringtransport_cleanupring] */
+UringTransportStatus_t UringTransport_CleanupRing( UringTransportRing_t * pRing );
+/* @[declare_uringtransport_cleanupring] */
+
+/**
+ * @brief Use a connected socket for a connection of an io_uring, and queue
+ * its first receive.
+ *
+ * io_uring waits for the socket itself, so the socket is made blocking. The
+ * transport owns the socket until #UringTransport_Disconnect is called.
+ *
+ * @param[in] pRing The ring.
+ * @param[out] pTransport The connection to set up.
+ * @param[in] slot Index of the buffers of the connection, less than the
+ * slot count of the ring and not used by another connection.
+ * @param[in] socketDescriptor The connected socket.
+ *
+ * @return #UringTransportBadParameter if invalid parameters are passed;
+ * #UringTransportSystemError if the socket could not be made blocking;
+ * #UringTransportSuccess otherwise.
+ */
+/* @[declare_uringtransport_attach] */
+UringTransportStatus_t UringTransport_Attach( UringTransportRing_t * pRing,
+                                              UringTransport_t * pTransport,
+                                              size_t slot,
+                                              int socketDescriptor );
+/* @[declare_uringtransport_attach] */
+
+/**
+ * @brief Write the bytes left in the send buffer of a connection, cancel its
+ * receive, and close its socket.
+ *
+ * Waits for at most @p timeoutMs for the operations of the connection to
+ * complete. When it returns #UringTransportSuccess, the socket is closed and
+ * the slot of the connection can be used again.
+ *
+ * If the operations did not complete in time, the kernel may still use the
+ * buffers of the slot, so the socket is left open and the connection stays
+ * attached. It may then be returned by #UringTransport_Poll. Call this
+ * function again, for example after a poll, until it succeeds, and do not
+ * reuse the slot or the #UringTransport_t before then.
+ *
+ * @param[in] pTransport The connection.
+ * @param[in] timeoutMs Time to wait for the bytes to be written and the
+ * operations to complete.
+ *
+ * @return #UringTransportBadParameter if invalid parameters are passed;
+ * #UringTransportSystemError if the operations did not complete in time;
+ * #UringTransportSuccess otherwise.
+ */
+/* @[declare_uringtransport_disconnect] */
+UringTransportStatus_t UringTransport_Disconnect( UringTransport_t * pTransport,
+                                                  uint32_t timeoutMs );
+/* @[declare_uringtransport_disconnect] */
+
+/**
+ * @brief Submit the receives and sends queued by every connection of an
+ * io_uring, and return the connections that received bytes or were closed.
+ *
+ * This is the only call that waits. A connection returned by this function
+ * should be passed to #MQTT_ProcessLoop or #MQTT_ReceiveLoop, which read
+ * the received bytes without a system call.
+ *
+ * @param[in] pRing The ring.
+ * @param[in] timeoutMs Time to wait for a connection to become ready, or 0
+ * to only submit and collect completions.
+ * @param[out] ppReady Array to write the ready connections to.
+ * @param[in] readyCountMax Number of entries in @p ppReady. Connections that
+ * do not fit are returned by the next call.
+ * @param[out] pReadyCount Number of connections written to @p ppReady.
+ *
+ * @return #UringTransportBadParameter if invalid parameters are passed;
+ * #UringTransportSystemError if submitting failed;
+ * #UringTransportSuccess otherwise.
+ */
+/* @[declare_uringtransport_poll] */
+UringTransportStatus_t UringTransport_Poll( UringTransportRing_t * pRing,
+                                            uint32_t timeoutMs,
+                                            UringTransport_t ** ppReady,
+                                            size_t readyCountMax,
+                                            size_t * pReadyCount );
+/* @[declare_uringtransport_poll] */
+
+/**
+ * @brief Fill a transport interface with the functions of the io_uring
+ * transport.
+ *
+ * @param[in] pTransport The connection, used as the network context.
+ * @param[out] pTransportInterface The transport interface to fill.
+ */
+/* @[declare_uringtransport_getinterface] */
+void UringTransport_GetInterface( UringTransport_t * pTransport,
+                                  TransportInterface_t * pTransportInterface );
+/* @[declare_uringtransport_getinterface] */
+
+/**
+ * @brief Return bytes received by the kernel, as described by
+ * #TransportRecv_t.
+ *
+ * When no bytes are waiting, completions are collected, and operations
+ * queued on the ring are submitted, without waiting, so that a connection
+ * can be used without calling #UringTransport_Poll, as in #MQTT_Connect. A connection with bytes left after this call is returned
+ * again by the next call to #UringTransport_Poll.
+ *
+ * @param[in] pNetworkContext The #UringTransport_t of the connection.
+ * @param[out] pBuffer Buffer to receive the bytes into.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return The number of bytes received; 0 if none are available;
+ * a negative value if the connection was closed or failed.
+ */
+/* @[declare_uringtransport_recv] */
+int32_t UringTransport_Recv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv );
+/* @[declare_uringtransport_recv] */
+
+/**
+ * @brief Copy bytes into the send buffer of a connection and queue a write,
+ * as described by #TransportSend_t.
+ *
+ * The write is submitted by the next call to #UringTransport_Poll, or by a
+ * receive that finds no bytes waiting.
+ *
+ * @param[in] pNetworkContext The #UringTransport_t of the connection.
+ * @param[in] pBuffer The bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return The number of bytes copied; 0 if the send buffer is full;
+ * a negative value if the connection was closed or failed.
+ */
+/* @[declare_uringtransport_send] */
+int32_t UringTransport_Send( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend );
+/* @[declare_uringtransport_send] */
+
+/**
+ * @brief Copy the bytes of several vectors into the send buffer of a
+ * connection and queue one write, as described by #TransportWritev_t.
+ *
+ * @param[in] pNetworkContext The #UringTransport_t of the connection.
+ * @param[in] pIoVec The vectors to send.
+ * @param[in] ioVecCount Number of vectors in @p pIoVec.
+ *
+ * @return The number of bytes copied; 0 if the send buffer is full;
+ * a negative value if the connection was closed or failed.
+ */
+/* @[declare_uringtransport_writev] */
+int32_t UringTransport_Writev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount );
+/* @[declare_uringtransport_writev] */
+
+/**
+ * @brief Wait until bytes can be received on one connection, as described by
+ * #TransportWaitReadable_t.
+ *
+ * Returns at once when received bytes are staged, and otherwise enters the
+ * ring until the receive of the connection completes. Completions of the
+ * other connections of the ring are handled, and those connections are
+ * returned by the next #UringTransport_Poll.
+ *
+ * @param[in] pNetworkContext The #UringTransport_t of the connection.
+ * @param[in] timeoutMs Most time to wait.
+ *
+ * @return A positive value if bytes can be received or the connection closed;
+ * 0 if the timeout expired; a negative value if waiting failed.
+ */
+/* @[declare_uringtransport_waitreadable] */
+int32_t UringTransport_WaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs );
+/* @[declare_uringtransport_waitreadable] */
+
+/**
+ * @brief Discard received bytes, as described by #TransportSkip_t, by moving
+ * past them in the registered receive buffer.
+ *
+ * @param[in] pNetworkContext The #UringTransport_t of the connection.
+ * @param[in] bytesToSkip Number of bytes to discard.
+ *
+ * @return The number of bytes discarded; 0 if none are available;
+ * a negative value if the connection closed or failed.
+ */
+/* @[declare_uringtransport_skip] */
+int32_t UringTransport_Skip( NetworkContext_t * pNetworkContext,
+                             size_t bytesToSkip );
+/* @[declare_uringtransport_skip] */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+    }
+#endif
+/* *INDENT-ON* */
+
+#endif /* ifndef CORE_MQTT_TRANSPORT_URING_H */
@@ -0,0 +1,58 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file MQTT_FramePackets_harness.c
+ * @brief Implements the proof harness for MQTT_FramePackets function.
+ */
+#include "core_mqtt.h"
+#include "mqtt_cbmc_state.h"
+
+void harness()
+{
+    uint8_t * pBuffer;
+    size_t bufferLength;
+    MQTTPacketInfo_t * pPackets;
+    size_t maxPackets;
+    size_t * pPacketCount;
+    size_t * pBytesConsumed;
+
+    /* The buffer length is bounded to limit the number of packets that can
+     * be framed. */
+    __CPROVER_assume( bufferLength < BUFFER_LENGTH_MAX );
+    __CPROVER_assume( maxPackets <= MAX_PACKETS );
+    pBuffer = malloc( bufferLength );
+    pPackets = malloc( sizeof( MQTTPacketInfo_t ) * maxPackets );
+
+    /* These are allocated for coverage of a NULL input. */
+    pPacketCount = malloc( sizeof( size_t ) );
+    pBytesConsumed = malloc( sizeof( size_t ) );
+
+    MQTT_FramePackets( pBuffer,
+                       bufferLength,
+                       pPackets,
+                       maxPackets,
+                       pPacketCount,
+                       pBytesConsumed );
+}
@@ -223,6 +223,8 @@ MQTTContext_t * allocateMqttContext( MQTTContext_t * pContext )
         pTransportInterface->recv = NetworkInterfaceReceiveStub;
         pTransportInterface->send = NetworkInterfaceSendStub;
         pTransportInterface->writev = NULL;
+        pTransportInterface->waitReadable = NULL;
+        pTransportInterface->skip = NULL;
     }
 
     pNetworkBuffer = allocateMqttFixedBuffer( NULL );
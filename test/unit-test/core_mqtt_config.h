@@ -73,4 +73,10 @@
 
 #define MQTT_SEND_TIMEOUT_MS                    ( 20U )
 
+#define MQTT_METRICS_ENABLED                    ( 1 )
+
+#define MQTT_TRANSPORT_WAIT_READABLE_ENABLED    ( 1 )
+
+#define MQTT_TRANSPORT_SKIP_ENABLED             ( 1 )
+
 #endif /* ifndef CORE_MQTT_CONFIG_H_ */
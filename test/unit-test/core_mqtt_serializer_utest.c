@@ -262,6 +262,34 @@ static int32_t mockReceiveSucceedThenFail( NetworkContext_t * pNetworkContext,
     return retVal;
 }
 
+/**
+ * @brief Number of bytes returned by each call to #mockReceiveChunk.
+ */
+static size_t receiveChunkSize = 0;
+
+/**
+ * @brief Number of calls made to #mockReceiveChunk.
+ */
+static size_t receiveChunkCalls = 0;
+
+/**
+ * @brief Mock transport receive that returns at most #receiveChunkSize bytes
+ * on each call.
+ */
+static int32_t mockReceiveChunk( NetworkContext_t * pNetworkContext,
+                                 void * pBuffer,
+                                 size_t bytesToRecv )
+{
+    receiveChunkCalls++;
+
+    if( bytesToRecv > receiveChunkSize )
+    {
+        bytesToRecv = receiveChunkSize;
+    }
+
+    return mockReceive( pNetworkContext, pBuffer, bytesToRecv );
+}
+
 /* ========================================================================== */
 
 /**
@@ -1926,6 +1954,209 @@ void test_MQTT_GetIncomingPacketTypeAndLength( void )
 
 /* ========================================================================== */
 
+/**
+ * @brief Tests that MQTT_GetIncomingPacketTypeAndLengthBuffered works as intended.
+ */
+void test_MQTT_GetIncomingPacketTypeAndLengthBuffered( void )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTPacketInfo_t mqttPacket;
+    NetworkContext_t networkContext;
+    MQTTFixedBuffer_t fixedBuffer;
+    uint8_t buffer[ 10 ] = { 0 };
+    uint8_t * bufPtr = buffer;
+    size_t index = 0;
+
+    /* Dummy network context - pointer to pointer to a buffer. */
+    networkContext.buffer = &bufPtr;
+    setupNetworkBuffer( &fixedBuffer );
+    memset( mqttBuffer, 0x00, MQTT_TEST_BUFFER_LENGTH );
+
+    /* Test NULL parameters. */
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( NULL, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, NULL, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, NULL, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, NULL );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    fixedBuffer.pBuffer = NULL;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    fixedBuffer.pBuffer = mqttBuffer;
+
+    /* Index beyond the end of the buffer. */
+    index = fixedBuffer.size + 1U;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+
+    /* A whole CONNACK is read with a single receive call. */
+    buffer[ 0 ] = MQTT_PACKET_TYPE_CONNACK;
+    buffer[ 1 ] = 0x02;
+    buffer[ 2 ] = 0x01;
+    buffer[ 3 ] = 0x00;
+    index = 0;
+    receiveChunkSize = 4;
+    receiveChunkCalls = 0;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 1, receiveChunkCalls );
+    TEST_ASSERT_EQUAL_INT( MQTT_PACKET_TYPE_CONNACK, mqttPacket.type );
+    TEST_ASSERT_EQUAL_INT( 2, mqttPacket.remainingLength );
+    TEST_ASSERT_EQUAL_INT( 2, mqttPacket.headerLength );
+    TEST_ASSERT_EQUAL_INT( 4, index );
+    TEST_ASSERT_EQUAL_MEMORY( buffer, mqttBuffer, 4 );
+
+    /* The header is already in the buffer, so no read is made. */
+    receiveChunkCalls = 0;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 0, receiveChunkCalls );
+    TEST_ASSERT_EQUAL_INT( 4, index );
+
+    /* The header arrives one byte at a time. Remaining length of 128. */
+    bufPtr = buffer;
+    buffer[ 0 ] = MQTT_PACKET_TYPE_PUBLISH;
+    buffer[ 1 ] = 0x80;
+    buffer[ 2 ] = 0x01;
+    index = 0;
+    receiveChunkSize = 1;
+    receiveChunkCalls = 0;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTNeedMoreBytes, status );
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTNeedMoreBytes, status );
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 3, receiveChunkCalls );
+    TEST_ASSERT_EQUAL_INT( MQTT_PACKET_TYPE_PUBLISH, mqttPacket.type );
+    TEST_ASSERT_EQUAL_INT( 128, mqttPacket.remainingLength );
+    TEST_ASSERT_EQUAL_INT( 3, mqttPacket.headerLength );
+    TEST_ASSERT_EQUAL_INT( 3, index );
+
+    /* Nothing read while part of the header is buffered. */
+    index = 2;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveNoData, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTNeedMoreBytes, status );
+    TEST_ASSERT_EQUAL_INT( 2, index );
+
+    /* Test if no data is available. */
+    index = 0;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveNoData, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTNoDataAvailable, status );
+    TEST_ASSERT_EQUAL_INT( 0, index );
+
+    /* Check when network receive fails. */
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveFailure, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
+
+    /* Test with incorrect packet type. */
+    bufPtr = buffer;
+    buffer[ 0 ] = 0x10; /* INVALID */
+    index = 0;
+    receiveChunkSize = 4;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTBadResponse, status );
+
+    /* A full buffer holding a partial header is not read into. */
+    mqttBuffer[ 0 ] = MQTT_PACKET_TYPE_PUBLISH;
+    mqttBuffer[ 1 ] = 0x80;
+    fixedBuffer.size = 2;
+    index = 2;
+    receiveChunkCalls = 0;
+    status = MQTT_GetIncomingPacketTypeAndLengthBuffered( mockReceiveChunk, &networkContext, &fixedBuffer, &index, &mqttPacket );
+    TEST_ASSERT_EQUAL_INT( MQTTNeedMoreBytes, status );
+    TEST_ASSERT_EQUAL_INT( 0, receiveChunkCalls );
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Tests that MQTT_FramePackets works as intended.
+ */
+void test_MQTT_FramePackets( void )
+{
+    MQTTStatus_t status = MQTTSuccess;
+    MQTTPacketInfo_t packets[ 4 ];
+    size_t packetCount = 0, consumed = 0;
+    uint8_t stream[] =
+    {
+        MQTT_PACKET_TYPE_CONNACK, 0x02, 0x00, 0x00,  /* CONNACK */
+        MQTT_PACKET_TYPE_PINGRESP, 0x00,             /* PINGRESP */
+        MQTT_PACKET_TYPE_PUBACK,   0x02, 0x00, 0x01, /* PUBACK */
+        MQTT_PACKET_TYPE_PUBLISH,  0x05, 0x00, 0x01  /* Partial PUBLISH */
+    };
+
+    /* Test NULL parameters. */
+    status = MQTT_FramePackets( stream, sizeof( stream ), NULL, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    status = MQTT_FramePackets( stream, sizeof( stream ), packets, 4, NULL, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    status = MQTT_FramePackets( stream, sizeof( stream ), packets, 4, &packetCount, NULL );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    status = MQTT_FramePackets( NULL, sizeof( stream ), packets, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+    status = MQTT_FramePackets( stream, sizeof( stream ), packets, 0, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTBadParameter, status );
+
+    /* An empty buffer holds no packets. */
+    status = MQTT_FramePackets( NULL, 0, packets, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 0, packetCount );
+    TEST_ASSERT_EQUAL_INT( 0, consumed );
+
+    /* Three complete packets followed by a partial PUBLISH. */
+    status = MQTT_FramePackets( stream, sizeof( stream ), packets, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 3, packetCount );
+    TEST_ASSERT_EQUAL_INT( 10, consumed );
+    TEST_ASSERT_EQUAL_INT( MQTT_PACKET_TYPE_CONNACK, packets[ 0 ].type );
+    TEST_ASSERT_EQUAL_INT( 2, packets[ 0 ].remainingLength );
+    TEST_ASSERT_EQUAL_INT( 2, packets[ 0 ].headerLength );
+    TEST_ASSERT_EQUAL_PTR( &stream[ 2 ], packets[ 0 ].pRemainingData );
+    TEST_ASSERT_EQUAL_INT( MQTT_PACKET_TYPE_PINGRESP, packets[ 1 ].type );
+    TEST_ASSERT_EQUAL_INT( 0, packets[ 1 ].remainingLength );
+    TEST_ASSERT_EQUAL_INT( MQTT_PACKET_TYPE_PUBACK, packets[ 2 ].type );
+    TEST_ASSERT_EQUAL_PTR( &stream[ 8 ], packets[ 2 ].pRemainingData );
+
+    /* Framing stops once the output array is full. */
+    status = MQTT_FramePackets( stream, sizeof( stream ), packets, 2, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 2, packetCount );
+    TEST_ASSERT_EQUAL_INT( 6, consumed );
+
+    /* The buffer ends inside a fixed header. */
+    stream[ 11 ] = 0x80;
+    status = MQTT_FramePackets( stream, 12, packets, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 3, packetCount );
+    TEST_ASSERT_EQUAL_INT( 10, consumed );
+
+    /* The buffer ends exactly at a packet boundary. */
+    status = MQTT_FramePackets( stream, 10, packets, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_INT( 3, packetCount );
+    TEST_ASSERT_EQUAL_INT( 10, consumed );
+
+    /* An invalid remaining length encoding. */
+    stream[ 11 ] = 0x80;
+    stream[ 12 ] = 0x00;
+    status = MQTT_FramePackets( stream, sizeof( stream ), packets, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTBadResponse, status );
+    TEST_ASSERT_EQUAL_INT( 3, packetCount );
+    TEST_ASSERT_EQUAL_INT( 10, consumed );
+
+    /* An invalid packet type. */
+    stream[ 6 ] = 0x00;
+    status = MQTT_FramePackets( stream, sizeof( stream ), packets, 4, &packetCount, &consumed );
+    TEST_ASSERT_EQUAL_INT( MQTTBadResponse, status );
+    TEST_ASSERT_EQUAL_INT( 2, packetCount );
+    TEST_ASSERT_EQUAL_INT( 6, consumed );
+}
+
+/* ========================================================================== */
+
 /**
  * @brief Tests that MQTT_SerializePublishHeaderWithoutTopic works as intended.
  */
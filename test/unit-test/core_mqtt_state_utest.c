@@ -34,9 +34,15 @@
 #define MQTT_PACKET_ID_INVALID         ( ( uint16_t ) 0U )
 #define  MQTT_STATE_ARRAY_MAX_COUNT    10
 
+/**
+ * @brief Time returned by #getTime.
+ */
+static uint32_t globalTimeMs = 0;
+
 /* ============================   UNITY FIXTURES ============================ */
 void setUp( void )
 {
+    globalTimeMs = 0;
 }
 
 /* called before each testcase */
@@ -82,7 +88,7 @@ static int32_t transportSendSuccess( NetworkContext_t * pNetworkContext,
  */
 static uint32_t getTime( void )
 {
-    return 0;
+    return globalTimeMs;
 }
 
 /**
@@ -1113,6 +1119,222 @@ void test_MQTT_PublishToResend( void )
 
 /* ========================================================================== */
 
+/**
+ * @brief Set up a context whose outgoing publishes are timed.
+ */
+static void setupAckLatency( MQTTContext_t * pContext,
+                             MQTTPubAckInfo_t * pIncomingRecords,
+                             MQTTPubAckInfo_t * pOutgoingRecords,
+                             MQTTAckLatency_t * pAckLatency )
+{
+    static TransportInterface_t transport;
+    static MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTStatus_t status;
+
+    transport.recv = transportRecvSuccess;
+    transport.send = transportSendSuccess;
+
+    status = MQTT_Init( pContext, &transport,
+                        getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    status = MQTT_InitStatefulQoS( pContext,
+                                   pOutgoingRecords, MQTT_STATE_ARRAY_MAX_COUNT,
+                                   pIncomingRecords, MQTT_STATE_ARRAY_MAX_COUNT );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    if( pAckLatency != NULL )
+    {
+        status = MQTT_InitAckLatency( pContext, pAckLatency );
+        TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    }
+}
+
+/**
+ * @brief Test that the latency from PUBLISH to PUBACK is recorded, across a
+ * wrap of the time.
+ */
+void test_MQTT_AckLatency_QoS1( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPubAckInfo_t incomingRecords[ MQTT_STATE_ARRAY_MAX_COUNT ] = { 0 };
+    MQTTPubAckInfo_t outgoingRecords[ MQTT_STATE_ARRAY_MAX_COUNT ] = { 0 };
+    MQTTAckLatency_t ackLatency;
+    MQTTPublishState_t state = MQTTStateNull;
+    MQTTStatus_t status;
+
+    setupAckLatency( &mqttContext, incomingRecords, outgoingRecords, &ackLatency );
+
+    status = MQTT_ReserveState( &mqttContext, 1, MQTTQoS1 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    globalTimeMs = 0xFFFFFFF0U;
+    status = MQTT_UpdateStatePublish( &mqttContext, 1, MQTT_SEND, MQTTQoS1, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( MQTTPubAckPending, state );
+    TEST_ASSERT_EQUAL( 0xFFFFFFF0U, outgoingRecords[ 0 ].sendTimeMs );
+
+    globalTimeMs = 14U;
+    status = MQTT_UpdateStateAck( &mqttContext, 1, MQTTPuback, MQTT_RECEIVE, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( MQTTPublishDone, state );
+
+    /* 30 ms has 15 as its 4 leading bits, shifted by 1. */
+    TEST_ASSERT_EQUAL( 1, ackLatency.pubAck.count );
+    TEST_ASSERT_EQUAL( 30, ackLatency.pubAck.maxMs );
+    TEST_ASSERT_EQUAL( 30, ackLatency.pubAck.totalMs );
+    TEST_ASSERT_EQUAL( 1, ackLatency.pubAck.buckets[ 23 ] );
+    TEST_ASSERT_EQUAL( 0, ackLatency.pubComp.count );
+    TEST_ASSERT_EQUAL( 0, ackLatency.pubRecToPubComp.count );
+    TEST_ASSERT_EQUAL( 0, outgoingRecords[ 0 ].sendTimeMs );
+}
+
+/**
+ * @brief Test that the latencies from PUBLISH and from PUBREC to PUBCOMP are
+ * recorded, while the PUBREC moves the record.
+ */
+void test_MQTT_AckLatency_QoS2( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPubAckInfo_t incomingRecords[ MQTT_STATE_ARRAY_MAX_COUNT ] = { 0 };
+    MQTTPubAckInfo_t outgoingRecords[ MQTT_STATE_ARRAY_MAX_COUNT ] = { 0 };
+    MQTTAckLatency_t ackLatency;
+    MQTTPublishState_t state = MQTTStateNull;
+    MQTTStatus_t status;
+
+    setupAckLatency( &mqttContext, incomingRecords, outgoingRecords, &ackLatency );
+
+    status = MQTT_ReserveState( &mqttContext, 1, MQTTQoS2 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    status = MQTT_ReserveState( &mqttContext, 2, MQTTQoS1 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    globalTimeMs = 1000U;
+    status = MQTT_UpdateStatePublish( &mqttContext, 1, MQTT_SEND, MQTTQoS2, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    globalTimeMs = 1040U;
+    status = MQTT_UpdateStateAck( &mqttContext, 1, MQTTPubrec, MQTT_RECEIVE, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( MQTTPubRelSend, state );
+
+    /* The record moved after the other one, with its stamps. */
+    TEST_ASSERT_EQUAL( MQTT_PACKET_ID_INVALID, outgoingRecords[ 0 ].packetId );
+    TEST_ASSERT_EQUAL( 0, outgoingRecords[ 0 ].sendTimeMs );
+    TEST_ASSERT_EQUAL( 1, outgoingRecords[ 2 ].packetId );
+    TEST_ASSERT_EQUAL( 1000U, outgoingRecords[ 2 ].sendTimeMs );
+    TEST_ASSERT_EQUAL( 1040U, outgoingRecords[ 2 ].pubRecTimeMs );
+
+    globalTimeMs = 1045U;
+    status = MQTT_UpdateStateAck( &mqttContext, 1, MQTTPubrel, MQTT_SEND, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( MQTTPubCompPending, state );
+
+    /* A PUBREL resent keeps the stamps. */
+    status = MQTT_UpdateStateAck( &mqttContext, 1, MQTTPubrel, MQTT_SEND, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( 1040U, outgoingRecords[ 2 ].pubRecTimeMs );
+
+    globalTimeMs = 1100U;
+    status = MQTT_UpdateStateAck( &mqttContext, 1, MQTTPubcomp, MQTT_RECEIVE, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( MQTTPublishDone, state );
+
+    TEST_ASSERT_EQUAL( 0, ackLatency.pubAck.count );
+    TEST_ASSERT_EQUAL( 1, ackLatency.pubComp.count );
+    TEST_ASSERT_EQUAL( 100, ackLatency.pubComp.maxMs );
+    TEST_ASSERT_EQUAL( 1, ackLatency.pubRecToPubComp.count );
+    TEST_ASSERT_EQUAL( 60, ackLatency.pubRecToPubComp.maxMs );
+}
+
+/**
+ * @brief Test that records are not stamped without #MQTT_InitAckLatency.
+ */
+void test_MQTT_AckLatency_NotInitialized( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPubAckInfo_t incomingRecords[ MQTT_STATE_ARRAY_MAX_COUNT ] = { 0 };
+    MQTTPubAckInfo_t outgoingRecords[ MQTT_STATE_ARRAY_MAX_COUNT ] = { 0 };
+    MQTTPublishState_t state = MQTTStateNull;
+    MQTTStatus_t status;
+
+    setupAckLatency( &mqttContext, incomingRecords, outgoingRecords, NULL );
+
+    status = MQTT_ReserveState( &mqttContext, 1, MQTTQoS1 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    globalTimeMs = 500U;
+    status = MQTT_UpdateStatePublish( &mqttContext, 1, MQTT_SEND, MQTTQoS1, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( 0, outgoingRecords[ 0 ].sendTimeMs );
+
+    status = MQTT_UpdateStateAck( &mqttContext, 1, MQTTPuback, MQTT_RECEIVE, &state );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_InitAckLatency( NULL, NULL ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_InitAckLatency( &mqttContext, NULL ) );
+    TEST_ASSERT_NULL( mqttContext.pAckLatency );
+}
+
+/**
+ * @brief Test reading percentiles of a histogram.
+ */
+void test_MQTT_GetLatencyPercentile( void )
+{
+    MQTTLatencyHistogram_t histogram = { 0 };
+    uint32_t latencyMs = 0;
+    MQTTStatus_t status;
+
+    status = MQTT_GetLatencyPercentile( NULL, 500U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+    status = MQTT_GetLatencyPercentile( &histogram, 500U, NULL );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+    status = MQTT_GetLatencyPercentile( &histogram, 1001U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+    status = MQTT_GetLatencyPercentile( &histogram, 500U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTNoDataAvailable, status );
+
+    /* 90 latencies of 5 ms, 9 of 30 or 31 ms and 1 beyond the last bound. */
+    histogram.buckets[ 5 ] = 90U;
+    histogram.buckets[ 23 ] = 9U;
+    histogram.buckets[ MQTT_LATENCY_BUCKET_COUNT - 1U ] = 1U;
+    histogram.count = 100U;
+    histogram.maxMs = 50000000U;
+
+    status = MQTT_GetLatencyPercentile( &histogram, 0U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( 5, latencyMs );
+    status = MQTT_GetLatencyPercentile( &histogram, 500U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( 5, latencyMs );
+    status = MQTT_GetLatencyPercentile( &histogram, 990U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( 31, latencyMs );
+    status = MQTT_GetLatencyPercentile( &histogram, 999U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( 50000000U, latencyMs );
+
+    /* The longest latency recorded bounds the bucket. */
+    ( void ) memset( &histogram, 0x00, sizeof( histogram ) );
+    histogram.buckets[ 23 ] = 1U;
+    histogram.count = 1U;
+    histogram.maxMs = 30U;
+    status = MQTT_GetLatencyPercentile( &histogram, 1000U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( 30, latencyMs );
+
+    /* Buckets above 16 ms are an eighth of a power of 2 wide. */
+    ( void ) memset( &histogram, 0x00, sizeof( histogram ) );
+    histogram.buckets[ 100 ] = 1U;
+    histogram.count = 1U;
+    histogram.maxMs = 0xFFFFFFFFU;
+    status = MQTT_GetLatencyPercentile( &histogram, 500U, &latencyMs );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( ( 13U << 11 ) - 1U, latencyMs );
+}
+
+/* ========================================================================== */
+
 void test_MQTT_State_strerror( void )
 {
     MQTTPublishState_t state;
@@ -0,0 +1,575 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_subscription_utest.c
+ * @brief Unit tests for functions in core_mqtt_subscription.h.
+ */
+#include <string.h>
+#include "unity.h"
+
+#include "core_mqtt.h"
+#include "core_mqtt_subscription.h"
+
+/**
+ * @brief Number of nodes of the trie used in the tests.
+ */
+#define NODE_COUNT          ( 32U )
+
+/**
+ * @brief Maximum length of a level in the trie used in the tests.
+ */
+#define LEVEL_LENGTH_MAX    ( 8U )
+
+/**
+ * @brief Number of hash buckets of the trie used in the tests.
+ */
+#define BUCKET_COUNT        ( 4U )
+
+/**
+ * @brief Number of handler IDs the tests can receive from a match.
+ */
+#define MATCH_COUNT_MAX     ( 8U )
+
+static MQTTSubscriptionTrie_t trie;
+static MQTTSubscriptionNode_t nodes[ NODE_COUNT ];
+static char levels[ NODE_COUNT * LEVEL_LENGTH_MAX ];
+static uint32_t buckets[ BUCKET_COUNT ];
+
+/**
+ * @brief Topic filters matched against #wildcardTopics.
+ */
+static const char * const wildcardFilters[] =
+{
+    "sport/tennis/player1",
+    "sport/+/player1",
+    "sport/#",
+    "+/+",
+    "#",
+    "sport/+",
+    "/finance",
+    "$SYS/#"
+};
+
+/**
+ * @brief Topic names matched against #wildcardFilters.
+ */
+static const char * const wildcardTopics[] =
+{
+    "sport/tennis/player1",
+    "sport/tennis/player2",
+    "sport",
+    "/finance",
+    "finance",
+    "$SYS/monitor",
+    "$SYS",
+    "sport/tennis/player1/ranking",
+    "a//b"
+};
+
+/**
+ * @brief Number of entries in #wildcardFilters.
+ */
+#define WILDCARD_FILTER_COUNT    ( sizeof( wildcardFilters ) / sizeof( wildcardFilters[ 0 ] ) )
+
+/**
+ * @brief Number of entries in #wildcardTopics.
+ */
+#define WILDCARD_TOPIC_COUNT     ( sizeof( wildcardTopics ) / sizeof( wildcardTopics[ 0 ] ) )
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp( void )
+{
+    MQTTStatus_t status;
+
+    status = MQTT_SubscriptionInit( &trie, nodes, levels, NODE_COUNT,
+                                    LEVEL_LENGTH_MAX, buckets, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+}
+
+/* Called after each test method. */
+void tearDown( void )
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Add a NUL terminated topic filter to the trie.
+ */
+static MQTTStatus_t addFilter( const char * pTopicFilter,
+                               uint32_t handlerId )
+{
+    return MQTT_SubscriptionAdd( &trie, pTopicFilter,
+                                 ( uint16_t ) strlen( pTopicFilter ),
+                                 handlerId );
+}
+
+/**
+ * @brief Match a NUL terminated topic name against the trie and return a
+ * bitmap of the matched handler IDs.
+ */
+static uint32_t matchTopic( const char * pTopicName )
+{
+    MQTTStatus_t status;
+    uint32_t handlerIds[ MATCH_COUNT_MAX ];
+    size_t matchCount = 0U, i;
+    uint32_t matched = 0U;
+
+    status = MQTT_SubscriptionMatch( &trie, pTopicName,
+                                     ( uint16_t ) strlen( pTopicName ),
+                                     handlerIds, MATCH_COUNT_MAX, &matchCount );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+
+    for( i = 0U; i < matchCount; i++ )
+    {
+        matched |= ( 1U << handlerIds[ i ] );
+    }
+
+    return matched;
+}
+
+/**
+ * @brief Count the nodes in the free list of the trie.
+ */
+static size_t countFreeNodes( void )
+{
+    size_t count = 0U;
+    uint32_t index = trie.freeNode;
+
+    while( index != MQTT_SUBSCRIPTION_NONE )
+    {
+        count++;
+        index = nodes[ index ].next;
+    }
+
+    return count;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test MQTT_SubscriptionInit with invalid parameters.
+ */
+void test_MQTT_SubscriptionInit_Invalid_Params( void )
+{
+    MQTTStatus_t status;
+
+    status = MQTT_SubscriptionInit( NULL, nodes, levels, NODE_COUNT, LEVEL_LENGTH_MAX, buckets, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+
+    status = MQTT_SubscriptionInit( &trie, NULL, levels, NODE_COUNT, LEVEL_LENGTH_MAX, buckets, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+
+    status = MQTT_SubscriptionInit( &trie, nodes, NULL, NODE_COUNT, LEVEL_LENGTH_MAX, buckets, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+
+    status = MQTT_SubscriptionInit( &trie, nodes, levels, NODE_COUNT, LEVEL_LENGTH_MAX, NULL, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+
+    status = MQTT_SubscriptionInit( &trie, nodes, levels, 0U, LEVEL_LENGTH_MAX, buckets, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+
+    status = MQTT_SubscriptionInit( &trie, nodes, levels, NODE_COUNT, 0U, buckets, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+
+    status = MQTT_SubscriptionInit( &trie, nodes, levels, NODE_COUNT, LEVEL_LENGTH_MAX, buckets, 0U );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, status );
+
+    /* Only the root node. */
+    status = MQTT_SubscriptionInit( &trie, nodes, levels, 1U, LEVEL_LENGTH_MAX, buckets, BUCKET_COUNT );
+    TEST_ASSERT_EQUAL( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( MQTT_SUBSCRIPTION_NONE, trie.freeNode );
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "#", 0U ) );
+    TEST_ASSERT_EQUAL( MQTTNoMemory, addFilter( "a", 1U ) );
+}
+
+/**
+ * @brief Test MQTT_SubscriptionAdd and MQTT_SubscriptionRemove with invalid
+ * parameters and invalid topic filters.
+ */
+void test_MQTT_SubscriptionAdd_Invalid_Params( void )
+{
+    MQTTSubscriptionTrie_t uninitialized = { 0 };
+
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionAdd( NULL, "a", 1U, 0U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionAdd( &uninitialized, "a", 1U, 0U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionAdd( &trie, NULL, 1U, 0U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionAdd( &trie, "a", 0U, 0U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, addFilter( "a", MQTT_SUBSCRIPTION_NONE ) );
+
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionRemove( NULL, "a", 1U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionRemove( &uninitialized, "a", 1U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionRemove( &trie, NULL, 1U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionRemove( &trie, "a", 0U ) );
+
+    /* Wildcards must occupy whole levels, and '#' must be last. */
+    TEST_ASSERT_EQUAL( MQTTBadParameter, addFilter( "a/b+", 0U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, addFilter( "a/#b", 0U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, addFilter( "a/#/b", 0U ) );
+
+    /* Levels longer than the maximum. */
+    TEST_ASSERT_EQUAL( MQTTBadParameter, addFilter( "a/123456789", 0U ) );
+
+    /* Too many levels. */
+    TEST_ASSERT_EQUAL( MQTTBadParameter, addFilter( "a/b/c/d/e/f/g/h/i/j/k/l/m/n/o/p/q", 0U ) );
+
+    /* Nodes added before a failure are freed. */
+    TEST_ASSERT_EQUAL( NODE_COUNT - 1U, countFreeNodes() );
+    TEST_ASSERT_EQUAL( 0U, trie.filterCount );
+}
+
+/**
+ * @brief Test MQTT_SubscriptionMatch with invalid parameters.
+ */
+void test_MQTT_SubscriptionMatch_Invalid_Params( void )
+{
+    MQTTSubscriptionTrie_t uninitialized = { 0 };
+    uint32_t handlerIds[ MATCH_COUNT_MAX ];
+    size_t matchCount;
+
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionMatch( NULL, "a", 1U, handlerIds, MATCH_COUNT_MAX, &matchCount ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionMatch( &uninitialized, "a", 1U, handlerIds, MATCH_COUNT_MAX, &matchCount ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionMatch( &trie, NULL, 1U, handlerIds, MATCH_COUNT_MAX, &matchCount ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionMatch( &trie, "a", 0U, handlerIds, MATCH_COUNT_MAX, &matchCount ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionMatch( &trie, "a", 1U, NULL, MATCH_COUNT_MAX, &matchCount ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionMatch( &trie, "a", 1U, handlerIds, 0U, &matchCount ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionMatch( &trie, "a", 1U, handlerIds, MATCH_COUNT_MAX, NULL ) );
+}
+
+/**
+ * @brief Test that MQTT_SubscriptionMatch finds the same filters as
+ * MQTT_MatchTopic for topic names where their rules agree.
+ */
+void test_MQTT_SubscriptionMatch_Wildcards( void )
+{
+    size_t filterIndex, topicIndex;
+    uint32_t matched, expected;
+    bool isMatch;
+
+    for( filterIndex = 0U; filterIndex < WILDCARD_FILTER_COUNT; filterIndex++ )
+    {
+        TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( wildcardFilters[ filterIndex ], ( uint32_t ) filterIndex ) );
+    }
+
+    TEST_ASSERT_EQUAL( WILDCARD_FILTER_COUNT, trie.filterCount );
+
+    for( topicIndex = 0U; topicIndex < WILDCARD_TOPIC_COUNT; topicIndex++ )
+    {
+        expected = 0U;
+
+        for( filterIndex = 0U; filterIndex < WILDCARD_FILTER_COUNT; filterIndex++ )
+        {
+            TEST_ASSERT_EQUAL( MQTTSuccess,
+                               MQTT_MatchTopic( wildcardTopics[ topicIndex ],
+                                                ( uint16_t ) strlen( wildcardTopics[ topicIndex ] ),
+                                                wildcardFilters[ filterIndex ],
+                                                ( uint16_t ) strlen( wildcardFilters[ filterIndex ] ),
+                                                &isMatch ) );
+
+            if( isMatch == true )
+            {
+                expected |= ( 1U << filterIndex );
+            }
+        }
+
+        matched = matchTopic( wildcardTopics[ topicIndex ] );
+        TEST_ASSERT_EQUAL_HEX32( expected, matched );
+    }
+
+    /* A '+' level matches an empty topic name level. */
+    TEST_ASSERT_EQUAL_HEX32( ( 1U << 2 ) | ( 1U << 3 ) | ( 1U << 4 ) | ( 1U << 5 ), matchTopic( "sport/" ) );
+}
+
+/**
+ * @brief Test the filters that MQTT_SubscriptionMatch and
+ * MQTT_MatchCompiledFilter match by the MQTT specification, where
+ * MQTT_MatchTopic does not.
+ */
+void test_MQTT_SubscriptionMatch_Differs_From_MatchTopic( void )
+{
+    static const char * const filters[] = { "a/+/#", "a/+/+", "+/#" };
+    static const char * const topics[] = { "a/b", "a/b/", "a" };
+    MQTTCompiledFilter_t compiledFilter;
+    MQTTFilterLevel_t filterLevels[ 4 ];
+    size_t i;
+    bool isMatch;
+
+    for( i = 0U; i < ( sizeof( filters ) / sizeof( filters[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( filters[ i ], ( uint32_t ) i ) );
+    }
+
+    for( i = 0U; i < ( sizeof( filters ) / sizeof( filters[ 0 ] ) ); i++ )
+    {
+        /* '#' matches the level before it, and '+' an empty level. */
+        TEST_ASSERT_NOT_EQUAL( 0U, matchTopic( topics[ i ] ) & ( 1U << i ) );
+
+        TEST_ASSERT_EQUAL( MQTTSuccess,
+                           MQTT_CompileTopicFilter( filters[ i ],
+                                                    ( uint16_t ) strlen( filters[ i ] ),
+                                                    filterLevels,
+                                                    4U,
+                                                    &compiledFilter ) );
+        TEST_ASSERT_EQUAL( MQTTSuccess,
+                           MQTT_MatchCompiledFilter( topics[ i ],
+                                                     ( uint16_t ) strlen( topics[ i ] ),
+                                                     &compiledFilter,
+                                                     &isMatch ) );
+        TEST_ASSERT_TRUE( isMatch );
+    }
+}
+
+/**
+ * @brief Test that MQTT_SubscriptionMatch reports when more filters match
+ * than fit in the output array.
+ */
+void test_MQTT_SubscriptionMatch_TooManyMatches( void )
+{
+    uint32_t handlerIds[ 1 ];
+    size_t matchCount = 0U;
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "a/#", 0U ) );
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "a/b", 1U ) );
+
+    TEST_ASSERT_EQUAL( MQTTNoMemory,
+                       MQTT_SubscriptionMatch( &trie, "a/b", 3U, handlerIds, 1U, &matchCount ) );
+    TEST_ASSERT_EQUAL( 1U, matchCount );
+}
+
+/**
+ * @brief Test that adding a filter again replaces its handler, and that
+ * removing filters frees only the nodes they do not share.
+ */
+void test_MQTT_SubscriptionRemove( void )
+{
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "a/b/c", 0U ) );
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "a/b", 1U ) );
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "a/+/c", 2U ) );
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "a/#", 3U ) );
+    TEST_ASSERT_EQUAL( NODE_COUNT - 6U, countFreeNodes() );
+
+    /* Replace the handler of an existing filter. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( "a/b", 4U ) );
+    TEST_ASSERT_EQUAL( 4U, trie.filterCount );
+    TEST_ASSERT_EQUAL_HEX32( ( 1U << 0 ) | ( 1U << 2 ) | ( 1U << 3 ), matchTopic( "a/b/c" ) );
+    TEST_ASSERT_EQUAL_HEX32( ( 1U << 3 ) | ( 1U << 4 ), matchTopic( "a/b" ) );
+
+    /* Filters not in the trie cannot be removed. */
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionRemove( &trie, "a/c", 3U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionRemove( &trie, "a", 1U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_SubscriptionRemove( &trie, "a/b/#", 5U ) );
+
+    /* "a/b" is still used by "a/b/c". */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_SubscriptionRemove( &trie, "a/b", 3U ) );
+    TEST_ASSERT_EQUAL( NODE_COUNT - 6U, countFreeNodes() );
+    TEST_ASSERT_EQUAL_HEX32( ( 1U << 3 ), matchTopic( "a/b" ) );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_SubscriptionRemove( &trie, "a/b/c", 5U ) );
+    TEST_ASSERT_EQUAL( NODE_COUNT - 4U, countFreeNodes() );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_SubscriptionRemove( &trie, "a/+/c", 5U ) );
+    TEST_ASSERT_EQUAL( NODE_COUNT - 2U, countFreeNodes() );
+    TEST_ASSERT_EQUAL_HEX32( ( 1U << 3 ), matchTopic( "a/b/c" ) );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_SubscriptionRemove( &trie, "a/#", 3U ) );
+    TEST_ASSERT_EQUAL( NODE_COUNT - 1U, countFreeNodes() );
+    TEST_ASSERT_EQUAL( 0U, trie.filterCount );
+    TEST_ASSERT_EQUAL_HEX32( 0U, matchTopic( "a/b/c" ) );
+}
+
+/**
+ * @brief Test that nodes sharing a hash bucket are found and unlinked
+ * correctly.
+ */
+void test_MQTT_SubscriptionAdd_BucketCollisions( void )
+{
+    static const char * const filters[] =
+    {
+        "l0", "l1", "l2", "l3", "l4", "l5", "l6", "l7", "l8", "l9"
+    };
+    size_t i;
+
+    for( i = 0U; i < ( sizeof( filters ) / sizeof( filters[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( filters[ i ], ( uint32_t ) i ) );
+    }
+
+    for( i = 0U; i < ( sizeof( filters ) / sizeof( filters[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL_HEX32( 1U << i, matchTopic( filters[ i ] ) );
+    }
+
+    /* Remove every other filter, then check the rest are still found. */
+    for( i = 0U; i < ( sizeof( filters ) / sizeof( filters[ 0 ] ) ); i += 2U )
+    {
+        TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_SubscriptionRemove( &trie, filters[ i ], 2U ) );
+    }
+
+    for( i = 0U; i < ( sizeof( filters ) / sizeof( filters[ 0 ] ) ); i++ )
+    {
+        TEST_ASSERT_EQUAL_HEX32( ( ( i % 2U ) == 1U ) ? ( 1U << i ) : 0U, matchTopic( filters[ i ] ) );
+    }
+
+    /* Topic name levels longer than any node never match a literal. */
+    TEST_ASSERT_EQUAL_HEX32( 0U, matchTopic( "l123456789" ) );
+}
+
+/**
+ * @brief Test MQTT_CompileTopicFilter and MQTT_MatchCompiledFilter with
+ * invalid parameters and invalid topic filters.
+ */
+void test_MQTT_CompileTopicFilter_Invalid_Params( void )
+{
+    MQTTCompiledFilter_t compiledFilter = { 0 };
+    MQTTFilterLevel_t filterLevels[ 4 ];
+    bool isMatch = false;
+
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( NULL, 1U, filterLevels, 4U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( "a", 0U, filterLevels, 4U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( "a", 1U, NULL, 4U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( "a", 1U, filterLevels, 0U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( "a", 1U, filterLevels, 4U, NULL ) );
+
+    /* Wildcards must occupy whole levels, '#' must be last, and the levels
+     * must fit in the array. */
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( "a/b+", 4U, filterLevels, 4U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( "a/#/b", 5U, filterLevels, 4U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_CompileTopicFilter( "a/b/c/d/e", 9U, filterLevels, 4U, &compiledFilter ) );
+
+    /* Matching an uncompiled filter. */
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_MatchCompiledFilter( "a", 1U, &compiledFilter, &isMatch ) );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_CompileTopicFilter( "a", 1U, filterLevels, 4U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_MatchCompiledFilter( NULL, 1U, &compiledFilter, &isMatch ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_MatchCompiledFilter( "a", 0U, &compiledFilter, &isMatch ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_MatchCompiledFilter( "a", 1U, NULL, &isMatch ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_MatchCompiledFilter( "a", 1U, &compiledFilter, NULL ) );
+}
+
+/**
+ * @brief Test that MQTT_CompileTopicFilter fills in the level table and the
+ * literal prefix of a topic filter.
+ */
+void test_MQTT_CompileTopicFilter_Levels( void )
+{
+    MQTTCompiledFilter_t compiledFilter;
+    MQTTCompiledFilter_t otherFilter;
+    MQTTFilterLevel_t filterLevels[ 4 ];
+    MQTTFilterLevel_t otherLevels[ 4 ];
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_CompileTopicFilter( "ab/c/+/#", 8U, filterLevels, 4U, &compiledFilter ) );
+    TEST_ASSERT_EQUAL( 4U, compiledFilter.levelCount );
+    TEST_ASSERT_EQUAL( 2U, compiledFilter.prefixLevelCount );
+    TEST_ASSERT_EQUAL( 4U, compiledFilter.prefixLength );
+    TEST_ASSERT_EQUAL( 0U, filterLevels[ 0 ].offset );
+    TEST_ASSERT_EQUAL( 2U, filterLevels[ 0 ].length );
+    TEST_ASSERT_EQUAL( MQTTFilterLevelLiteral, filterLevels[ 0 ].kind );
+    TEST_ASSERT_EQUAL( 3U, filterLevels[ 1 ].offset );
+    TEST_ASSERT_EQUAL( 1U, filterLevels[ 1 ].length );
+    TEST_ASSERT_EQUAL( MQTTFilterLevelSingle, filterLevels[ 2 ].kind );
+    TEST_ASSERT_EQUAL( 7U, filterLevels[ 3 ].offset );
+    TEST_ASSERT_EQUAL( MQTTFilterLevelMulti, filterLevels[ 3 ].kind );
+
+    /* Filters with the same literal prefix have the same prefix hash. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_CompileTopicFilter( "ab/c/+", 6U, otherLevels, 4U, &otherFilter ) );
+    TEST_ASSERT_EQUAL( compiledFilter.prefixHash, otherFilter.prefixHash );
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_CompileTopicFilter( "ab/d/+", 6U, otherLevels, 4U, &otherFilter ) );
+    TEST_ASSERT_NOT_EQUAL( compiledFilter.prefixHash, otherFilter.prefixHash );
+
+    /* A filter starting with a wildcard has no prefix. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_CompileTopicFilter( "+/a", 3U, otherLevels, 4U, &otherFilter ) );
+    TEST_ASSERT_EQUAL( 0U, otherFilter.prefixLevelCount );
+    TEST_ASSERT_EQUAL( 0U, otherFilter.prefixLength );
+}
+
+/**
+ * @brief Test that MQTT_MatchCompiledFilter matches the same topic names as
+ * MQTT_SubscriptionMatch.
+ */
+void test_MQTT_MatchCompiledFilter_Wildcards( void )
+{
+    MQTTCompiledFilter_t compiledFilters[ WILDCARD_FILTER_COUNT ];
+    MQTTFilterLevel_t filterLevels[ WILDCARD_FILTER_COUNT ][ 4 ];
+    size_t filterIndex, topicIndex;
+    uint32_t matched;
+    bool isMatch;
+
+    for( filterIndex = 0U; filterIndex < WILDCARD_FILTER_COUNT; filterIndex++ )
+    {
+        TEST_ASSERT_EQUAL( MQTTSuccess, addFilter( wildcardFilters[ filterIndex ], ( uint32_t ) filterIndex ) );
+        TEST_ASSERT_EQUAL( MQTTSuccess,
+                           MQTT_CompileTopicFilter( wildcardFilters[ filterIndex ],
+                                                    ( uint16_t ) strlen( wildcardFilters[ filterIndex ] ),
+                                                    filterLevels[ filterIndex ],
+                                                    4U,
+                                                    &compiledFilters[ filterIndex ] ) );
+    }
+
+    for( topicIndex = 0U; topicIndex < WILDCARD_TOPIC_COUNT; topicIndex++ )
+    {
+        matched = 0U;
+
+        for( filterIndex = 0U; filterIndex < WILDCARD_FILTER_COUNT; filterIndex++ )
+        {
+            TEST_ASSERT_EQUAL( MQTTSuccess,
+                               MQTT_MatchCompiledFilter( wildcardTopics[ topicIndex ],
+                                                         ( uint16_t ) strlen( wildcardTopics[ topicIndex ] ),
+                                                         &compiledFilters[ filterIndex ],
+                                                         &isMatch ) );
+
+            if( isMatch == true )
+            {
+                matched |= ( 1U << filterIndex );
+            }
+        }
+
+        TEST_ASSERT_EQUAL_HEX32( matchTopic( wildcardTopics[ topicIndex ] ), matched );
+    }
+
+    /* A literal prefix that is only the start of a topic name level. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchCompiledFilter( "sports/a", 8U, &compiledFilters[ 2 ], &isMatch ) );
+    TEST_ASSERT_FALSE( isMatch );
+
+    /* Topic names shorter than the literal prefix. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchCompiledFilter( "spo", 3U, &compiledFilters[ 2 ], &isMatch ) );
+    TEST_ASSERT_FALSE( isMatch );
+
+    /* A '+' level matches an empty topic name level. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchCompiledFilter( "sport/", 6U, &compiledFilters[ 3 ], &isMatch ) );
+    TEST_ASSERT_TRUE( isMatch );
+}
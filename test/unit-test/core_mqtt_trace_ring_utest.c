@@ -0,0 +1,280 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_trace_ring_utest.c
+ * @brief Unit tests for functions in core_mqtt_trace_ring.h.
+ *
+ * The concurrent writers test writes from child processes into a ring in
+ * shared memory.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "unity.h"
+
+#include "core_mqtt.h"
+#include "core_mqtt_trace_ring.h"
+
+/**
+ * @brief Number of records of the ring used in most tests.
+ */
+#define RECORD_COUNT    ( 8U )
+
+static MQTTTraceRecord_t records[ RECORD_COUNT ];
+static MQTTTraceRing_t ring;
+
+/**
+ * @brief A context address for the records.
+ */
+static MQTTContext_t context;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp( void )
+{
+    TEST_ASSERT_EQUAL( MQTTTraceRingSuccess, MQTTTraceRing_Init( &ring, records, RECORD_COUNT ) );
+}
+
+/* Called after each test method. */
+void tearDown( void )
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Write a record with a packet ID through #MQTT_TRACE_RING.
+ */
+static void emitAck( MQTTTraceRing_t * pRing,
+                     uint16_t packetId )
+{
+    MQTT_TRACE_RING( pRing, AckSent, &context, MQTT_PACKET_TYPE_PUBACK, packetId, 4U, MQTTSuccess );
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test that invalid parameters are rejected.
+ */
+void test_MQTTTraceRing_Init_Invalid_Params( void )
+{
+    MQTTTraceRecord_t copy;
+    uint64_t cursor = 0;
+
+    TEST_ASSERT_EQUAL( MQTTTraceRingBadParameter, MQTTTraceRing_Init( NULL, records, RECORD_COUNT ) );
+    TEST_ASSERT_EQUAL( MQTTTraceRingBadParameter, MQTTTraceRing_Init( &ring, NULL, RECORD_COUNT ) );
+    TEST_ASSERT_EQUAL( MQTTTraceRingBadParameter, MQTTTraceRing_Init( &ring, records, 0U ) );
+    TEST_ASSERT_EQUAL( MQTTTraceRingBadParameter, MQTTTraceRing_Init( &ring, records, 6U ) );
+
+    TEST_ASSERT_EQUAL( 0U, MQTTTraceRing_Read( NULL, &cursor, &copy, 1U ) );
+    TEST_ASSERT_EQUAL( 0U, MQTTTraceRing_Read( &ring, NULL, &copy, 1U ) );
+    TEST_ASSERT_EQUAL( 0U, MQTTTraceRing_Read( &ring, &cursor, NULL, 1U ) );
+}
+
+/**
+ * @brief Test that records are read back in order with their fields.
+ */
+void test_MQTTTraceRing_EmitAndRead( void )
+{
+    MQTTTraceRecord_t copies[ RECORD_COUNT ];
+    uint64_t cursor = 0;
+    size_t count;
+
+    TEST_ASSERT_EQUAL( 0U, MQTTTraceRing_Read( &ring, &cursor, copies, RECORD_COUNT ) );
+
+    MQTT_TRACE_RING( &ring, PacketReceived, &context, 0x32U, 0U, 20U, MQTTSuccess );
+    emitAck( &ring, 7U );
+    MQTT_TRACE_RING( &ring, StateChange, &context, MQTT_PACKET_TYPE_PUBACK, 7U, 0U, MQTTPublishDone );
+
+    /* Read one at a time, then the rest. */
+    count = MQTTTraceRing_Read( &ring, &cursor, copies, 1U );
+    TEST_ASSERT_EQUAL( 1U, count );
+    TEST_ASSERT_EQUAL( 1U, cursor );
+    TEST_ASSERT_EQUAL( MQTTTracePacketReceived, copies[ 0 ].event );
+    TEST_ASSERT_EQUAL( 0x32U, copies[ 0 ].packetType );
+    TEST_ASSERT_EQUAL( 20U, copies[ 0 ].bytes );
+    TEST_ASSERT_EQUAL_UINT64( ( uint64_t ) ( uintptr_t ) &context, copies[ 0 ].context );
+
+    count = MQTTTraceRing_Read( &ring, &cursor, &copies[ 1 ], RECORD_COUNT );
+    TEST_ASSERT_EQUAL( 2U, count );
+    TEST_ASSERT_EQUAL( 3U, cursor );
+    TEST_ASSERT_EQUAL( MQTTTraceAckSent, copies[ 1 ].event );
+    TEST_ASSERT_EQUAL( 7U, copies[ 1 ].packetId );
+    TEST_ASSERT_EQUAL( MQTTSuccess, copies[ 1 ].status );
+    TEST_ASSERT_EQUAL( MQTTTraceStateChange, copies[ 2 ].event );
+    TEST_ASSERT_EQUAL( MQTTPublishDone, copies[ 2 ].status );
+    TEST_ASSERT_TRUE( copies[ 0 ].timestampNs <= copies[ 1 ].timestampNs );
+    TEST_ASSERT_TRUE( copies[ 1 ].timestampNs <= copies[ 2 ].timestampNs );
+
+    TEST_ASSERT_EQUAL( 0U, MQTTTraceRing_Read( &ring, &cursor, copies, RECORD_COUNT ) );
+}
+
+/**
+ * @brief Test that a full ring overwrites the oldest records, and that the
+ * reader skips them.
+ */
+void test_MQTTTraceRing_Overwrite( void )
+{
+    MQTTTraceRecord_t copies[ RECORD_COUNT ];
+    uint64_t cursor = 0;
+    size_t count;
+    uint16_t i;
+
+    for( i = 1U; i <= 20U; i++ )
+    {
+        emitAck( &ring, i );
+    }
+
+    /* The first 12 records were lost. */
+    count = MQTTTraceRing_Read( &ring, &cursor, copies, RECORD_COUNT );
+    TEST_ASSERT_EQUAL( RECORD_COUNT, count );
+    TEST_ASSERT_EQUAL( 20U, cursor );
+
+    for( i = 0U; i < RECORD_COUNT; i++ )
+    {
+        TEST_ASSERT_EQUAL( 13U + i, copies[ i ].packetId );
+    }
+
+    /* A record overwritten after the ring was last checked is skipped. */
+    cursor = 18U;
+    emitAck( &ring, 21U );
+    emitAck( &ring, 22U );
+    count = MQTTTraceRing_Read( &ring, &cursor, copies, RECORD_COUNT );
+    TEST_ASSERT_EQUAL( 4U, count );
+    TEST_ASSERT_EQUAL( 22U, cursor );
+    TEST_ASSERT_EQUAL( 19U, copies[ 0 ].packetId );
+    TEST_ASSERT_EQUAL( 22U, copies[ 3 ].packetId );
+}
+
+/**
+ * @brief Test that the reader stops at a record still being written, and
+ * skips one overwritten by a newer record.
+ */
+void test_MQTTTraceRing_PendingRecord( void )
+{
+    MQTTTraceRecord_t copies[ RECORD_COUNT ];
+    uint64_t cursor = 0;
+    size_t count;
+
+    emitAck( &ring, 1U );
+    emitAck( &ring, 2U );
+    emitAck( &ring, 3U );
+
+    /* The second record is being written. */
+    records[ 1 ].sequence = 0U;
+    count = MQTTTraceRing_Read( &ring, &cursor, copies, RECORD_COUNT );
+    TEST_ASSERT_EQUAL( 1U, count );
+    TEST_ASSERT_EQUAL( 1U, cursor );
+
+    /* The second record was overwritten by a writer a lap ahead. */
+    records[ 1 ].sequence = 2U + RECORD_COUNT;
+    count = MQTTTraceRing_Read( &ring, &cursor, copies, RECORD_COUNT );
+    TEST_ASSERT_EQUAL( 1U, count );
+    TEST_ASSERT_EQUAL( 3U, cursor );
+    TEST_ASSERT_EQUAL( 3U, copies[ 0 ].packetId );
+}
+
+/**
+ * @brief Test that records written at once by several processes are all kept,
+ * in the order each process wrote them.
+ */
+void test_MQTTTraceRing_ConcurrentWriters( void )
+{
+    const uint32_t writerCount = 4U;
+    const uint32_t recordsPerWriter = 2000U;
+    const uint32_t sharedCount = 8192U;
+    MQTTTraceRing_t * pSharedRing;
+    MQTTTraceRecord_t * pSharedRecords;
+    MQTTTraceRecord_t * pCopies;
+    uint16_t lastPacketId[ 4 ] = { 0 };
+    uint64_t cursor = 0;
+    size_t count;
+    size_t i;
+    uint32_t writer;
+    pid_t child;
+    int childStatus;
+
+    pSharedRing = mmap( NULL, sizeof( MQTTTraceRing_t ) + ( sharedCount * sizeof( MQTTTraceRecord_t ) ),
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    TEST_ASSERT_NOT_EQUAL( MAP_FAILED, pSharedRing );
+    pSharedRecords = ( MQTTTraceRecord_t * ) &pSharedRing[ 1 ];
+    TEST_ASSERT_EQUAL( MQTTTraceRingSuccess, MQTTTraceRing_Init( pSharedRing, pSharedRecords, sharedCount ) );
+
+    for( writer = 0U; writer < writerCount; writer++ )
+    {
+        child = fork();
+        TEST_ASSERT_NOT_EQUAL( -1, child );
+
+        if( child == 0 )
+        {
+            for( i = 1U; i <= recordsPerWriter; i++ )
+            {
+                MQTT_TRACE_RING( pSharedRing, Dispatch, &context, writer, i, 0U, MQTTSuccess );
+            }
+
+            _exit( 0 );
+        }
+    }
+
+    for( writer = 0U; writer < writerCount; writer++ )
+    {
+        TEST_ASSERT_NOT_EQUAL( -1, wait( &childStatus ) );
+        TEST_ASSERT_EQUAL( 0, childStatus );
+    }
+
+    pCopies = malloc( sharedCount * sizeof( MQTTTraceRecord_t ) );
+    TEST_ASSERT_NOT_NULL( pCopies );
+
+    count = MQTTTraceRing_Read( pSharedRing, &cursor, pCopies, sharedCount );
+    TEST_ASSERT_EQUAL( writerCount * recordsPerWriter, count );
+
+    for( i = 0U; i < count; i++ )
+    {
+        TEST_ASSERT_EQUAL( MQTTTraceDispatch, pCopies[ i ].event );
+        TEST_ASSERT_TRUE( pCopies[ i ].packetType < writerCount );
+        TEST_ASSERT_EQUAL( lastPacketId[ pCopies[ i ].packetType ] + 1U, pCopies[ i ].packetId );
+        lastPacketId[ pCopies[ i ].packetType ] = pCopies[ i ].packetId;
+    }
+
+    free( pCopies );
+    ( void ) munmap( pSharedRing, sizeof( MQTTTraceRing_t ) + ( sharedCount * sizeof( MQTTTraceRecord_t ) ) );
+}
@@ -0,0 +1,533 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_posix_utest.c
+ * @brief Unit tests for functions in core_mqtt_transport_posix.h.
+ *
+ * The tests use a connected pair of UNIX domain sockets, with the transport
+ * on one end and the test on the other, and a TCP listener on the loopback
+ * interface for the connect tests.
+ */
+#define _POSIX_C_SOURCE    200809L
+
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "unity.h"
+
+#include "core_mqtt_transport_posix.h"
+
+/**
+ * @brief Size of the read-ahead buffer used in the tests.
+ */
+#define READ_AHEAD_SIZE    ( 8U )
+
+static PosixTransport_t posixTransport;
+static PosixTransportConfig_t config;
+static TransportInterface_t transport;
+static uint8_t readAheadBuffer[ READ_AHEAD_SIZE ];
+
+/**
+ * @brief The end of the socket pair used by the test.
+ */
+static int peerSocket = -1;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp( void )
+{
+    int sockets[ 2 ];
+
+    ( void ) memset( &posixTransport, 0, sizeof( posixTransport ) );
+    ( void ) memset( &config, 0, sizeof( config ) );
+    ( void ) memset( &transport, 0, sizeof( transport ) );
+
+    TEST_ASSERT_EQUAL( 0, socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) );
+    peerSocket = sockets[ 1 ];
+
+    /* TCP_NODELAY does not apply to UNIX domain sockets. */
+    config.noDelay = false;
+    config.pReadAheadBuffer = readAheadBuffer;
+    config.readAheadBufferSize = READ_AHEAD_SIZE;
+
+    TEST_ASSERT_EQUAL( PosixTransportSuccess,
+                       PosixTransport_Attach( &posixTransport, sockets[ 0 ], &config ) );
+    PosixTransport_GetInterface( &posixTransport, &transport );
+}
+
+/* Called after each test method. */
+void tearDown( void )
+{
+    ( void ) PosixTransport_Disconnect( &posixTransport );
+
+    if( peerSocket >= 0 )
+    {
+        ( void ) close( peerSocket );
+        peerSocket = -1;
+    }
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Open a TCP listener on an ephemeral loopback port.
+ */
+static int listenOnLoopback( uint16_t * pPort )
+{
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof( address );
+    int listener;
+
+    listener = socket( AF_INET, SOCK_STREAM, 0 );
+    TEST_ASSERT_TRUE( listener >= 0 );
+
+    ( void ) memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    address.sin_port = 0;
+
+    TEST_ASSERT_EQUAL( 0, bind( listener, ( struct sockaddr * ) &address, sizeof( address ) ) );
+    TEST_ASSERT_EQUAL( 0, listen( listener, 1 ) );
+    TEST_ASSERT_EQUAL( 0, getsockname( listener, ( struct sockaddr * ) &address, &addressLength ) );
+
+    *pPort = ntohs( address.sin_port );
+
+    return listener;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test the POSIX transport functions with invalid parameters.
+ */
+void test_PosixTransport_Invalid_Params( void )
+{
+    PosixTransport_t otherTransport;
+    uint8_t buffer[ 4 ];
+
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Connect( NULL, "localhost", 1883U, &config ) );
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Connect( &otherTransport, NULL, 1883U, &config ) );
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Connect( &otherTransport, "localhost", 1883U, NULL ) );
+
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Attach( NULL, peerSocket, &config ) );
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Attach( &otherTransport, peerSocket, NULL ) );
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Attach( &otherTransport, -1, &config ) );
+
+    /* A read-ahead buffer needs a size, and a size needs a buffer. */
+    config.readAheadBufferSize = 0U;
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Attach( &otherTransport, peerSocket, &config ) );
+    config.pReadAheadBuffer = NULL;
+    config.readAheadBufferSize = READ_AHEAD_SIZE;
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter,
+                       PosixTransport_Attach( &otherTransport, peerSocket, &config ) );
+
+    TEST_ASSERT_EQUAL( PosixTransportBadParameter, PosixTransport_Disconnect( NULL ) );
+
+    TEST_ASSERT_EQUAL( -1, PosixTransport_Recv( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, NULL, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, 0U ) );
+    TEST_ASSERT_EQUAL( -1, PosixTransport_Send( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.send( transport.pNetworkContext, NULL, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, PosixTransport_Writev( NULL, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, transport.writev( transport.pNetworkContext, NULL, 1U ) );
+    TEST_ASSERT_EQUAL( -1, PosixTransport_WaitReadable( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, PosixTransport_Skip( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( -1, transport.skip( transport.pNetworkContext, 0U ) );
+
+    /* Neither argument of PosixTransport_GetInterface may be NULL. */
+    ( void ) memset( &transport, 0, sizeof( transport ) );
+    PosixTransport_GetInterface( NULL, &transport );
+    TEST_ASSERT_NULL( transport.recv );
+    PosixTransport_GetInterface( &posixTransport, NULL );
+}
+
+/**
+ * @brief Test that PosixTransport_GetInterface fills all of the callbacks.
+ */
+void test_PosixTransport_GetInterface( void )
+{
+    TEST_ASSERT_TRUE( transport.recv == PosixTransport_Recv );
+    TEST_ASSERT_TRUE( transport.send == PosixTransport_Send );
+    TEST_ASSERT_TRUE( transport.writev == PosixTransport_Writev );
+    TEST_ASSERT_TRUE( transport.waitReadable == PosixTransport_WaitReadable );
+    TEST_ASSERT_TRUE( transport.skip == PosixTransport_Skip );
+    TEST_ASSERT_EQUAL_PTR( &posixTransport, transport.pNetworkContext );
+}
+
+/**
+ * @brief Test sending and receiving without blocking.
+ */
+void test_PosixTransport_Send_Recv( void )
+{
+    uint8_t buffer[ 16 ];
+
+    /* Nothing has been sent yet. */
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+
+    TEST_ASSERT_EQUAL( 5, transport.send( transport.pNetworkContext, "hello", 5U ) );
+    TEST_ASSERT_EQUAL( 5, read( peerSocket, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "hello", buffer, 5U );
+
+    TEST_ASSERT_EQUAL( 5, write( peerSocket, "world", 5U ) );
+    TEST_ASSERT_EQUAL( 5, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "world", buffer, 5U );
+}
+
+/**
+ * @brief Test that bytes past the requested ones are read ahead and returned
+ * by the next calls.
+ */
+void test_PosixTransport_Recv_ReadAhead( void )
+{
+    const char bytes[] = "abcdefghijkl";
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_EQUAL( 12, write( peerSocket, bytes, 12U ) );
+
+    /* One byte is asked for. The next eight are read ahead. */
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, 1U ) );
+    TEST_ASSERT_EQUAL( 'a', buffer[ 0 ] );
+    TEST_ASSERT_EQUAL( 8U, posixTransport.readAheadEnd - posixTransport.readAheadStart );
+
+    /* These are served from the read-ahead buffer. */
+    TEST_ASSERT_EQUAL( 2, transport.recv( transport.pNetworkContext, buffer, 2U ) );
+    TEST_ASSERT_EQUAL_MEMORY( "bc", buffer, 2U );
+
+    /* These take the last six read-ahead bytes and the rest from the socket. */
+    TEST_ASSERT_EQUAL( 9, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "defghijkl", buffer, 9U );
+    TEST_ASSERT_EQUAL( 0U, posixTransport.readAheadEnd - posixTransport.readAheadStart );
+
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+}
+
+/**
+ * @brief Test waiting for bytes on the socket and in the read-ahead buffer.
+ */
+void test_PosixTransport_WaitReadable( void )
+{
+    uint8_t buffer[ 4 ];
+
+    /* Nothing has been sent yet. */
+    TEST_ASSERT_EQUAL( 0, transport.waitReadable( transport.pNetworkContext, 0U ) );
+    TEST_ASSERT_EQUAL( 0, transport.waitReadable( transport.pNetworkContext, 10U ) );
+
+    TEST_ASSERT_EQUAL( 4, write( peerSocket, "abcd", 4U ) );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 10U ) );
+
+    /* The socket is drained, but bytes are left in the read-ahead buffer. */
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, 1U ) );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 0U ) );
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0, transport.waitReadable( transport.pNetworkContext, 0U ) );
+
+    /* A closed peer ends the wait, so that the error is received. */
+    ( void ) close( peerSocket );
+    peerSocket = -1;
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 1000U ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+}
+
+/**
+ * @brief Test discarding bytes read ahead and bytes of a socket that is not
+ * a TCP socket.
+ */
+void test_PosixTransport_Skip( void )
+{
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_FALSE( posixTransport.skipWithTrunc );
+    TEST_ASSERT_EQUAL( 0, transport.skip( transport.pNetworkContext, 4U ) );
+
+    TEST_ASSERT_EQUAL( 12, write( peerSocket, "abcdefghijkl", 12U ) );
+
+    /* The next eight bytes are read ahead. */
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, 1U ) );
+    TEST_ASSERT_EQUAL( 2, transport.skip( transport.pNetworkContext, 2U ) );
+
+    /* The rest of the read-ahead bytes and one byte of the socket. */
+    TEST_ASSERT_EQUAL( 7, transport.skip( transport.pNetworkContext, 7U ) );
+    TEST_ASSERT_EQUAL( 2, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "kl", buffer, 2U );
+
+    ( void ) close( peerSocket );
+    peerSocket = -1;
+    TEST_ASSERT_EQUAL( -1, transport.skip( transport.pNetworkContext, 4U ) );
+}
+
+/**
+ * @brief Test that a TCP socket discards bytes without reading them.
+ */
+void test_PosixTransport_Skip_Tcp( void )
+{
+    PosixTransport_t tcpTransport;
+    TransportInterface_t tcpInterface;
+    uint8_t bytes[ 1000 ];
+    uint8_t buffer[ 1000 ];
+    uint16_t port;
+    int listener, server;
+    int32_t result;
+    size_t bytesSkipped = 0U;
+    size_t bytesReceived = 0U;
+    size_t i;
+
+    listener = listenOnLoopback( &port );
+    config.connectTimeoutMs = 1000U;
+
+    TEST_ASSERT_EQUAL( PosixTransportSuccess,
+                       PosixTransport_Connect( &tcpTransport, "127.0.0.1", port, &config ) );
+    PosixTransport_GetInterface( &tcpTransport, &tcpInterface );
+
+    #ifdef __linux__
+        TEST_ASSERT_TRUE( tcpTransport.skipWithTrunc );
+    #endif
+
+    server = accept( listener, NULL, NULL );
+    TEST_ASSERT_TRUE( server >= 0 );
+
+    for( i = 0U; i < sizeof( bytes ); i++ )
+    {
+        bytes[ i ] = ( uint8_t ) i;
+    }
+
+    TEST_ASSERT_EQUAL( ( ssize_t ) sizeof( bytes ), write( server, bytes, sizeof( bytes ) ) );
+
+    while( bytesSkipped < 600U )
+    {
+        TEST_ASSERT_TRUE( tcpInterface.waitReadable( tcpInterface.pNetworkContext, 1000U ) > 0 );
+        result = tcpInterface.skip( tcpInterface.pNetworkContext, 600U - bytesSkipped );
+        TEST_ASSERT_TRUE( result > 0 );
+        bytesSkipped += ( size_t ) result;
+    }
+
+    while( bytesReceived < 400U )
+    {
+        TEST_ASSERT_TRUE( tcpInterface.waitReadable( tcpInterface.pNetworkContext, 1000U ) > 0 );
+        result = tcpInterface.recv( tcpInterface.pNetworkContext, &( buffer[ bytesReceived ] ),
+                                    sizeof( buffer ) - bytesReceived );
+        TEST_ASSERT_TRUE( result > 0 );
+        bytesReceived += ( size_t ) result;
+    }
+
+    TEST_ASSERT_EQUAL( 400U, bytesReceived );
+    TEST_ASSERT_EQUAL_MEMORY( &( bytes[ 600 ] ), buffer, 400U );
+
+    TEST_ASSERT_EQUAL( PosixTransportSuccess, PosixTransport_Disconnect( &tcpTransport ) );
+    ( void ) close( server );
+    ( void ) close( listener );
+}
+
+/**
+ * @brief Test receiving without a read-ahead buffer.
+ */
+void test_PosixTransport_Recv_No_ReadAhead( void )
+{
+    int sockets[ 2 ];
+    uint8_t buffer[ 4 ];
+
+    ( void ) PosixTransport_Disconnect( &posixTransport );
+    ( void ) close( peerSocket );
+    TEST_ASSERT_EQUAL( 0, socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) );
+    peerSocket = sockets[ 1 ];
+
+    config.pReadAheadBuffer = NULL;
+    config.readAheadBufferSize = 0U;
+    TEST_ASSERT_EQUAL( PosixTransportSuccess,
+                       PosixTransport_Attach( &posixTransport, sockets[ 0 ], &config ) );
+
+    TEST_ASSERT_EQUAL( 6, write( peerSocket, "abcdef", 6U ) );
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, 1U ) );
+    TEST_ASSERT_EQUAL( 4, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "bcde", buffer, 4U );
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+}
+
+/**
+ * @brief Test that vectors are sent in order with one call.
+ */
+void test_PosixTransport_Writev( void )
+{
+    TransportOutVector_t vectors[ 3 ];
+    uint8_t buffer[ 16 ];
+
+    vectors[ 0 ].iov_base = "\x30\x07";
+    vectors[ 0 ].iov_len = 2U;
+    vectors[ 1 ].iov_base = "\x00\x01t";
+    vectors[ 1 ].iov_len = 3U;
+    vectors[ 2 ].iov_base = "data";
+    vectors[ 2 ].iov_len = 4U;
+
+    TEST_ASSERT_EQUAL( 9, transport.writev( transport.pNetworkContext, vectors, 3U ) );
+    TEST_ASSERT_EQUAL( 9, read( peerSocket, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "\x30\x07\x00\x01tdata", buffer, 9U );
+
+    /* No vectors send no bytes. */
+    TEST_ASSERT_EQUAL( 0, transport.writev( transport.pNetworkContext, vectors, 0U ) );
+}
+
+/**
+ * @brief Test that a closed peer is reported as an error after the bytes
+ * received before it closed.
+ */
+void test_PosixTransport_Peer_Closed( void )
+{
+    TransportOutVector_t vector;
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_EQUAL( 3, write( peerSocket, "end", 3U ) );
+    ( void ) close( peerSocket );
+    peerSocket = -1;
+
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+
+    /* Sending fails instead of raising SIGPIPE. */
+    TEST_ASSERT_EQUAL( -1, transport.send( transport.pNetworkContext, "x", 1U ) );
+
+    vector.iov_base = "x";
+    vector.iov_len = 1U;
+    TEST_ASSERT_EQUAL( -1, transport.writev( transport.pNetworkContext, &vector, 1U ) );
+}
+
+/**
+ * @brief Test that a full socket send buffer makes sending return zero.
+ */
+void test_PosixTransport_Send_Buffer_Full( void )
+{
+    uint8_t buffer[ 1024 ] = { 0 };
+    int32_t result;
+
+    do
+    {
+        result = transport.send( transport.pNetworkContext, buffer, sizeof( buffer ) );
+    } while( result > 0 );
+
+    TEST_ASSERT_EQUAL( 0, result );
+}
+
+/**
+ * @brief Test that the transport functions fail after disconnecting.
+ */
+void test_PosixTransport_Disconnect( void )
+{
+    uint8_t buffer[ 4 ];
+
+    TEST_ASSERT_EQUAL( PosixTransportSuccess, PosixTransport_Disconnect( &posixTransport ) );
+    TEST_ASSERT_EQUAL( -1, posixTransport.socketDescriptor );
+
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.send( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+
+    /* Disconnecting twice is harmless. */
+    TEST_ASSERT_EQUAL( PosixTransportSuccess, PosixTransport_Disconnect( &posixTransport ) );
+}
+
+/**
+ * @brief Test connecting over TCP with socket options.
+ */
+void test_PosixTransport_Connect( void )
+{
+    PosixTransport_t tcpTransport;
+    TransportInterface_t tcpInterface;
+    uint16_t port;
+    uint8_t buffer[ 4 ];
+    int listener, server;
+
+    listener = listenOnLoopback( &port );
+
+    config.noDelay = true;
+    config.sendBufferSize = 65536;
+    config.recvBufferSize = 65536;
+    config.connectTimeoutMs = 1000U;
+
+    TEST_ASSERT_EQUAL( PosixTransportSuccess,
+                       PosixTransport_Connect( &tcpTransport, "127.0.0.1", port, &config ) );
+    PosixTransport_GetInterface( &tcpTransport, &tcpInterface );
+
+    server = accept( listener, NULL, NULL );
+    TEST_ASSERT_TRUE( server >= 0 );
+
+    TEST_ASSERT_EQUAL( 4, tcpInterface.send( tcpInterface.pNetworkContext, "ping", 4U ) );
+    TEST_ASSERT_EQUAL( 4, read( server, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "ping", buffer, 4U );
+
+    TEST_ASSERT_EQUAL( PosixTransportSuccess, PosixTransport_Disconnect( &tcpTransport ) );
+    ( void ) close( server );
+    ( void ) close( listener );
+}
+
+/**
+ * @brief Test connecting to a port nothing listens on.
+ */
+void test_PosixTransport_Connect_Refused( void )
+{
+    PosixTransport_t tcpTransport;
+    uint16_t port;
+    int listener;
+
+    /* Take a free port, then close it so that connecting is refused. */
+    listener = listenOnLoopback( &port );
+    ( void ) close( listener );
+
+    config.connectTimeoutMs = 1000U;
+
+    TEST_ASSERT_EQUAL( PosixTransportConnectFailure,
+                       PosixTransport_Connect( &tcpTransport, "127.0.0.1", port, &config ) );
+}
+
+/**
+ * @brief Test connecting with socket options that cannot be set.
+ */
+void test_PosixTransport_Attach_Socket_Error( void )
+{
+    PosixTransport_t otherTransport;
+
+    /* TCP_NODELAY cannot be set on a UNIX domain socket. */
+    config.noDelay = true;
+    TEST_ASSERT_EQUAL( PosixTransportSocketError,
+                       PosixTransport_Attach( &otherTransport, peerSocket, &config ) );
+}
@@ -0,0 +1,453 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_replay_utest.c
+ * @brief Unit tests for functions in core_mqtt_transport_replay.h.
+ *
+ * The recorder wraps a scripted transport of the test and writes to a
+ * temporary file, which is then replayed.
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "core_mqtt_transport_replay.h"
+
+/**
+ * @brief Size of the buffers holding recordings in the tests.
+ */
+#define RECORDING_SIZE    ( 256U )
+
+/**
+ * @brief Results of the receive function of the scripted transport, in
+ * order. A result of 0 returns no bytes.
+ */
+static const char * const scriptedReceives[] = { "abc", "", "defgh" };
+
+static size_t receiveCount;
+static size_t bytesSentToScript;
+static FILE * pRecordingFile;
+static uint8_t recording[ RECORDING_SIZE ];
+static size_t recordingLength;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp( void )
+{
+    receiveCount = 0U;
+    bytesSentToScript = 0U;
+    recordingLength = 0U;
+    pRecordingFile = tmpfile();
+    TEST_ASSERT_NOT_NULL( pRecordingFile );
+}
+
+/* Called after each test method. */
+void tearDown( void )
+{
+    ( void ) fclose( pRecordingFile );
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+static int32_t scriptedRecv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+{
+    int32_t result = -1;
+    size_t length;
+
+    ( void ) pNetworkContext;
+
+    if( receiveCount < ( sizeof( scriptedReceives ) / sizeof( scriptedReceives[ 0 ] ) ) )
+    {
+        length = strlen( scriptedReceives[ receiveCount ] );
+        TEST_ASSERT_GREATER_OR_EQUAL( length, bytesToRecv );
+        ( void ) memcpy( pBuffer, scriptedReceives[ receiveCount ], length );
+        result = ( int32_t ) length;
+        receiveCount++;
+    }
+
+    return result;
+}
+
+static int32_t scriptedSend( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend )
+{
+    ( void ) pNetworkContext;
+    ( void ) pBuffer;
+
+    bytesSentToScript += bytesToSend;
+
+    return ( int32_t ) bytesToSend;
+}
+
+static int32_t scriptedWritev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount )
+{
+    ( void ) pNetworkContext;
+
+    TEST_ASSERT_EQUAL( 1U, ioVecCount );
+
+    return scriptedSend( pNetworkContext, pIoVec->iov_base, pIoVec->iov_len );
+}
+
+static int32_t scriptedWaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs )
+{
+    ( void ) pNetworkContext;
+
+    return ( int32_t ) timeoutMs;
+}
+
+/**
+ * @brief Get a transport interface of the scripted transport, with or
+ * without its optional functions.
+ */
+static TransportInterface_t getScriptedTransport( bool withOptional )
+{
+    TransportInterface_t transport = { 0 };
+
+    transport.recv = scriptedRecv;
+    transport.send = scriptedSend;
+
+    if( withOptional == true )
+    {
+        transport.writev = scriptedWritev;
+        transport.waitReadable = scriptedWaitReadable;
+    }
+
+    return transport;
+}
+
+/**
+ * @brief Read the recording written to the temporary file.
+ */
+static void readRecording( void )
+{
+    rewind( pRecordingFile );
+    recordingLength = fread( recording, 1U, sizeof( recording ), pRecordingFile );
+}
+
+/**
+ * @brief Append bytes to the recording buffer.
+ */
+static void appendBytes( const void * pBytes,
+                         size_t length )
+{
+    TEST_ASSERT_LESS_OR_EQUAL( RECORDING_SIZE, recordingLength + length );
+    ( void ) memcpy( &( recording[ recordingLength ] ), pBytes, length );
+    recordingLength += length;
+}
+
+/**
+ * @brief Append a record to the recording buffer.
+ */
+static void appendRecord( uint64_t timeNs,
+                          const char * pBytes )
+{
+    uint8_t header[ 12 ];
+    uint32_t length = ( uint32_t ) strlen( pBytes );
+    size_t i;
+
+    for( i = 0U; i < 8U; i++ )
+    {
+        header[ i ] = ( uint8_t ) ( timeNs >> ( 8U * i ) );
+    }
+
+    for( i = 0U; i < 4U; i++ )
+    {
+        header[ 8U + i ] = ( uint8_t ) ( length >> ( 8U * i ) );
+    }
+
+    appendBytes( header, sizeof( header ) );
+    appendBytes( pBytes, length );
+}
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test the recording and replay functions with invalid parameters.
+ */
+void test_ReplayTransport_Invalid_Params( void )
+{
+    ReplayRecorder_t recorder = { 0 };
+    ReplayTransport_t replay = { 0 };
+    TransportInterface_t scripted = getScriptedTransport( true );
+    TransportInterface_t transport = { 0 };
+    uint8_t buffer[ 4 ];
+
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayRecorder_Start( NULL, &scripted, fileno( pRecordingFile ) ) );
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayRecorder_Start( &recorder, NULL, fileno( pRecordingFile ) ) );
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayRecorder_Start( &recorder, &scripted, -1 ) );
+    scripted.send = NULL;
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayRecorder_Start( &recorder, &scripted, fileno( pRecordingFile ) ) );
+
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayTransport_Open( NULL, recording, 8U, false ) );
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayTransport_Open( &replay, NULL, 8U, false ) );
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayTransport_Rewind( NULL ) );
+    TEST_ASSERT_EQUAL( ReplayTransportBadParameter, ReplayTransport_Rewind( &replay ) );
+    TEST_ASSERT_TRUE( ReplayTransport_IsFinished( NULL ) );
+
+    /* Functions given a recorder or transport that is not set up fail. */
+    TEST_ASSERT_EQUAL( -1, ReplayRecorder_Recv( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, ReplayRecorder_Recv( ( NetworkContext_t * ) &recorder, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, ReplayRecorder_Send( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, ReplayRecorder_Writev( NULL, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, ReplayRecorder_WaitReadable( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, ReplayTransport_Recv( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, ReplayTransport_Recv( ( NetworkContext_t * ) &replay, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, ReplayTransport_Send( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, ReplayTransport_Writev( NULL, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, ReplayTransport_WaitReadable( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, ReplayTransport_Skip( NULL, 1U ) );
+
+    /* Neither argument of the interface functions may be NULL. */
+    ReplayRecorder_GetInterface( NULL, &transport );
+    ReplayTransport_GetInterface( NULL, &transport );
+    TEST_ASSERT_NULL( transport.recv );
+    ReplayRecorder_GetInterface( &recorder, NULL );
+    ReplayTransport_GetInterface( &replay, NULL );
+}
+
+/**
+ * @brief Test that the interface functions fill the callbacks, and that the
+ * recorder only offers the optional functions of the recorded transport.
+ */
+void test_ReplayTransport_GetInterface( void )
+{
+    ReplayRecorder_t recorder;
+    ReplayTransport_t replay;
+    TransportInterface_t scripted = getScriptedTransport( true );
+    TransportInterface_t transport = { 0 };
+
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayRecorder_Start( &recorder, &scripted, fileno( pRecordingFile ) ) );
+    ReplayRecorder_GetInterface( &recorder, &transport );
+    TEST_ASSERT_TRUE( transport.recv == ReplayRecorder_Recv );
+    TEST_ASSERT_TRUE( transport.send == ReplayRecorder_Send );
+    TEST_ASSERT_TRUE( transport.writev == ReplayRecorder_Writev );
+    TEST_ASSERT_TRUE( transport.waitReadable == ReplayRecorder_WaitReadable );
+    TEST_ASSERT_NULL( transport.skip );
+    TEST_ASSERT_EQUAL_PTR( &recorder, transport.pNetworkContext );
+
+    scripted = getScriptedTransport( false );
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayRecorder_Start( &recorder, &scripted, fileno( pRecordingFile ) ) );
+    ReplayRecorder_GetInterface( &recorder, &transport );
+    TEST_ASSERT_NULL( transport.writev );
+    TEST_ASSERT_NULL( transport.waitReadable );
+    TEST_ASSERT_EQUAL( -1, ReplayRecorder_Writev( ( NetworkContext_t * ) &recorder, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, ReplayRecorder_WaitReadable( ( NetworkContext_t * ) &recorder, 0U ) );
+
+    appendBytes( "CMQR\x01\x00\x00\x00", 8U );
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayTransport_Open( &replay, recording, recordingLength, false ) );
+    ReplayTransport_GetInterface( &replay, &transport );
+    TEST_ASSERT_TRUE( transport.recv == ReplayTransport_Recv );
+    TEST_ASSERT_TRUE( transport.send == ReplayTransport_Send );
+    TEST_ASSERT_TRUE( transport.writev == ReplayTransport_Writev );
+    TEST_ASSERT_TRUE( transport.waitReadable == ReplayTransport_WaitReadable );
+    TEST_ASSERT_TRUE( transport.skip == ReplayTransport_Skip );
+    TEST_ASSERT_EQUAL_PTR( &replay, transport.pNetworkContext );
+}
+
+/**
+ * @brief Test that the recorder passes calls on to the recorded transport,
+ * and that the replay returns the received bytes in the recorded pieces.
+ */
+void test_ReplayTransport_Record_And_Replay( void )
+{
+    ReplayRecorder_t recorder;
+    ReplayTransport_t replay;
+    TransportInterface_t scripted = getScriptedTransport( true );
+    TransportInterface_t transport;
+    TransportOutVector_t vectors[ 2 ];
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayRecorder_Start( &recorder, &scripted, fileno( pRecordingFile ) ) );
+    ReplayRecorder_GetInterface( &recorder, &transport );
+
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "abc", buffer, 3U );
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 5, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 2U, recorder.recordCount );
+
+    TEST_ASSERT_EQUAL( 4, transport.send( transport.pNetworkContext, "ping", 4U ) );
+    vectors[ 0 ].iov_base = "pong";
+    vectors[ 0 ].iov_len = 4U;
+    TEST_ASSERT_EQUAL( 4, transport.writev( transport.pNetworkContext, vectors, 1U ) );
+    TEST_ASSERT_EQUAL( 8U, bytesSentToScript );
+    TEST_ASSERT_EQUAL( 7, transport.waitReadable( transport.pNetworkContext, 7U ) );
+
+    /* The header of the recording, then 2 records of 12 byte headers. */
+    readRecording();
+    TEST_ASSERT_EQUAL( 8U + 12U + 3U + 12U + 5U, recordingLength );
+    TEST_ASSERT_EQUAL_MEMORY( "CMQR", recording, 4U );
+
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayTransport_Open( &replay, recording, recordingLength, false ) );
+    ReplayTransport_GetInterface( &replay, &transport );
+
+    /* A read returns bytes of one record at most. */
+    TEST_ASSERT_EQUAL( 2, transport.recv( transport.pNetworkContext, buffer, 2U ) );
+    TEST_ASSERT_EQUAL_MEMORY( "ab", buffer, 2U );
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "c", buffer, 1U );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 1000U ) );
+    TEST_ASSERT_EQUAL( 2, transport.skip( transport.pNetworkContext, 2U ) );
+    TEST_ASSERT_FALSE( ReplayTransport_IsFinished( &replay ) );
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "fgh", buffer, 3U );
+    TEST_ASSERT_TRUE( ReplayTransport_IsFinished( &replay ) );
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0, transport.waitReadable( transport.pNetworkContext, 1U ) );
+
+    /* Sent bytes are counted and discarded. */
+    TEST_ASSERT_EQUAL( 4, transport.send( transport.pNetworkContext, "ping", 4U ) );
+    vectors[ 1 ].iov_base = "!";
+    vectors[ 1 ].iov_len = 1U;
+    TEST_ASSERT_EQUAL( 5, transport.writev( transport.pNetworkContext, vectors, 2U ) );
+    TEST_ASSERT_EQUAL( 9U, replay.bytesSent );
+
+    /* A rewound transport replays from the first record. */
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayTransport_Rewind( &replay ) );
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "abc", buffer, 3U );
+}
+
+/**
+ * @brief Test that a recorder whose file cannot be written fails to start,
+ * or stops recording while receiving goes on.
+ */
+void test_ReplayRecorder_Write_Fails( void )
+{
+    ReplayRecorder_t recorder;
+    TransportInterface_t scripted = getScriptedTransport( false );
+    uint8_t buffer[ 16 ];
+    int readOnlyDescriptor = open( "/dev/null", O_RDONLY );
+
+    TEST_ASSERT_GREATER_OR_EQUAL( 0, readOnlyDescriptor );
+    TEST_ASSERT_EQUAL( ReplayTransportSystemError, ReplayRecorder_Start( &recorder, &scripted, readOnlyDescriptor ) );
+
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayRecorder_Start( &recorder, &scripted, fileno( pRecordingFile ) ) );
+    recorder.fileDescriptor = readOnlyDescriptor;
+    TEST_ASSERT_EQUAL( 3, ReplayRecorder_Recv( ( NetworkContext_t * ) &recorder, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_TRUE( recorder.failed );
+    TEST_ASSERT_EQUAL( 0, ReplayRecorder_Recv( ( NetworkContext_t * ) &recorder, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 5, ReplayRecorder_Recv( ( NetworkContext_t * ) &recorder, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0U, recorder.recordCount );
+
+    ( void ) close( readOnlyDescriptor );
+}
+
+/**
+ * @brief Test that recordings with a bad header or a truncated record are
+ * rejected, and that empty records are passed over.
+ */
+void test_ReplayTransport_Bad_Recordings( void )
+{
+    ReplayTransport_t replay;
+    uint8_t buffer[ 16 ];
+
+    appendBytes( "CMQX\x01\x00\x00\x00", 8U );
+    TEST_ASSERT_EQUAL( ReplayTransportBadRecording, ReplayTransport_Open( &replay, recording, recordingLength, false ) );
+    TEST_ASSERT_EQUAL( ReplayTransportBadRecording, ReplayTransport_Open( &replay, recording, 4U, false ) );
+
+    recordingLength = 0U;
+    appendBytes( "CMQR\x02\x00\x00\x00", 8U );
+    TEST_ASSERT_EQUAL( ReplayTransportBadRecording, ReplayTransport_Open( &replay, recording, recordingLength, false ) );
+
+    /* A recording without records is finished at once. */
+    recordingLength = 0U;
+    appendBytes( "CMQR\x01\x00\x00\x00", 8U );
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayTransport_Open( &replay, recording, recordingLength, false ) );
+    TEST_ASSERT_TRUE( ReplayTransport_IsFinished( &replay ) );
+
+    appendRecord( 0U, "" );
+    appendRecord( 0U, "abcd" );
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayTransport_Open( &replay, recording, recordingLength, false ) );
+    TEST_ASSERT_EQUAL( 4, ReplayTransport_Recv( ( NetworkContext_t * ) &replay, buffer, sizeof( buffer ) ) );
+
+    /* A record longer than the rest of the recording, or a partial record
+     * header. */
+    TEST_ASSERT_EQUAL( ReplayTransportBadRecording, ReplayTransport_Open( &replay, recording, recordingLength - 1U, false ) );
+    TEST_ASSERT_EQUAL( ReplayTransportBadRecording, ReplayTransport_Open( &replay, recording, 8U + 12U + 5U, false ) );
+}
+
+/**
+ * @brief Test that a paced replay returns records no earlier than they were
+ * recorded, and that waiting sleeps until the next record is due.
+ */
+void test_ReplayTransport_Paced( void )
+{
+    ReplayTransport_t replay;
+    uint8_t buffer[ 16 ];
+    uint64_t start;
+
+    appendBytes( "CMQR\x01\x00\x00\x00", 8U );
+    appendRecord( 0U, "abc" );
+    appendRecord( 20000000U, "def" );
+
+    TEST_ASSERT_EQUAL( ReplayTransportSuccess, ReplayTransport_Open( &replay, recording, recordingLength, true ) );
+    start = nowNs();
+    TEST_ASSERT_EQUAL( 3, ReplayTransport_Recv( ( NetworkContext_t * ) &replay, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0, ReplayTransport_Recv( ( NetworkContext_t * ) &replay, buffer, sizeof( buffer ) ) );
+
+    /* The next record is not due within a millisecond. */
+    TEST_ASSERT_EQUAL( 0, ReplayTransport_WaitReadable( ( NetworkContext_t * ) &replay, 1U ) );
+    TEST_ASSERT_EQUAL( 1, ReplayTransport_WaitReadable( ( NetworkContext_t * ) &replay, 1000U ) );
+    TEST_ASSERT_GREATER_OR_EQUAL( 20000000U, nowNs() - start );
+    TEST_ASSERT_EQUAL( 3, ReplayTransport_Recv( ( NetworkContext_t * ) &replay, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "def", buffer, 3U );
+    TEST_ASSERT_TRUE( ReplayTransport_IsFinished( &replay ) );
+}
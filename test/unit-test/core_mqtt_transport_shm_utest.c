@@ -0,0 +1,382 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_shm_utest.c
+ * @brief Unit tests for functions in core_mqtt_transport_shm.h.
+ *
+ * Both ends of the connection are opened in the test process, except in the
+ * wake up test, which sends from a child process.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "unity.h"
+
+#include "core_mqtt_transport_shm.h"
+
+/**
+ * @brief Size of the rings used in the tests.
+ */
+#define RING_SIZE    ( 64U )
+
+static ShmTransport_t clientEnd;
+static ShmTransport_t brokerEnd;
+static TransportInterface_t client;
+static TransportInterface_t broker;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp( void )
+{
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Create( &clientEnd, RING_SIZE ) );
+    TEST_ASSERT_EQUAL( ShmTransportSuccess,
+                       ShmTransport_Open( &brokerEnd, dup( clientEnd.segmentDescriptor ) ) );
+
+    ShmTransport_GetInterface( &clientEnd, &client );
+    ShmTransport_GetInterface( &brokerEnd, &broker );
+}
+
+/* Called after each test method. */
+void tearDown( void )
+{
+    ( void ) ShmTransport_Disconnect( &clientEnd );
+    ( void ) ShmTransport_Disconnect( &brokerEnd );
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Write a ring size into the header of the segment of an end, resize
+ * the segment to match it, and open the other end of the segment.
+ */
+static ShmTransportStatus_t openWithRingSize( const ShmTransport_t * pCreator,
+                                              uint32_t ringSize )
+{
+    ShmTransport_t openedEnd;
+    struct stat fileStatus;
+    uint32_t currentRingSize = 0U;
+    off_t dataOffset;
+
+    /* The ring size is the second word of the header, and the ring bytes
+     * follow the header and control blocks. */
+    TEST_ASSERT_EQUAL( sizeof( currentRingSize ),
+                       pread( pCreator->segmentDescriptor, &currentRingSize, sizeof( currentRingSize ), sizeof( uint32_t ) ) );
+    TEST_ASSERT_EQUAL( 0, fstat( pCreator->segmentDescriptor, &fileStatus ) );
+    dataOffset = fileStatus.st_size - ( off_t ) ( 2U * currentRingSize );
+
+    TEST_ASSERT_EQUAL( sizeof( ringSize ),
+                       pwrite( pCreator->segmentDescriptor, &ringSize, sizeof( ringSize ), sizeof( uint32_t ) ) );
+    TEST_ASSERT_EQUAL( 0, ftruncate( pCreator->segmentDescriptor, dataOffset + ( off_t ) ( 2U * ringSize ) ) );
+
+    return ShmTransport_Open( &openedEnd, dup( pCreator->segmentDescriptor ) );
+}
+
+/**
+ * @brief Test the shared memory transport functions with invalid parameters.
+ */
+void test_ShmTransport_Invalid_Params( void )
+{
+    ShmTransport_t otherEnd;
+    uint8_t buffer[ 4 ];
+    int pipeDescriptors[ 2 ];
+
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Create( NULL, RING_SIZE ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Create( &otherEnd, 32U ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Create( &otherEnd, 100U ) );
+
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Open( NULL, -1 ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Open( &otherEnd, -1 ) );
+
+    /* A descriptor that is not a segment is rejected and closed. */
+    TEST_ASSERT_EQUAL( 0, pipe( pipeDescriptors ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Open( &otherEnd, pipeDescriptors[ 0 ] ) );
+    TEST_ASSERT_EQUAL( -1, close( pipeDescriptors[ 0 ] ) );
+    ( void ) close( pipeDescriptors[ 1 ] );
+
+    /* Only one process may open the second end. */
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter,
+                       ShmTransport_Open( &otherEnd, dup( clientEnd.segmentDescriptor ) ) );
+
+    /* A segment whose header has a ring size that Create rejects. */
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Create( &otherEnd, RING_SIZE ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter,
+                       openWithRingSize( &otherEnd, 0U ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter,
+                       openWithRingSize( &otherEnd, 96U ) );
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Disconnect( &otherEnd ) );
+
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Disconnect( NULL ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Wait( NULL, 0U ) );
+
+    TEST_ASSERT_EQUAL( -1, ShmTransport_Recv( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, client.recv( client.pNetworkContext, NULL, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, client.recv( client.pNetworkContext, buffer, 0U ) );
+    TEST_ASSERT_EQUAL( -1, ShmTransport_Send( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, ShmTransport_Writev( NULL, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, client.writev( client.pNetworkContext, NULL, 1U ) );
+    TEST_ASSERT_EQUAL( -1, ShmTransport_WaitReadable( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, ShmTransport_Skip( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( -1, client.skip( client.pNetworkContext, 0U ) );
+
+    /* Neither argument of ShmTransport_GetInterface may be NULL. */
+    ( void ) memset( &client, 0, sizeof( client ) );
+    ShmTransport_GetInterface( NULL, &client );
+    TEST_ASSERT_NULL( client.recv );
+    ShmTransport_GetInterface( &clientEnd, NULL );
+}
+
+/**
+ * @brief Test that ShmTransport_GetInterface fills all of the callbacks.
+ */
+void test_ShmTransport_GetInterface( void )
+{
+    TEST_ASSERT_TRUE( client.recv == ShmTransport_Recv );
+    TEST_ASSERT_TRUE( client.send == ShmTransport_Send );
+    TEST_ASSERT_TRUE( client.writev == ShmTransport_Writev );
+    TEST_ASSERT_TRUE( client.waitReadable == ShmTransport_WaitReadable );
+    TEST_ASSERT_TRUE( client.skip == ShmTransport_Skip );
+    TEST_ASSERT_EQUAL_PTR( &clientEnd, client.pNetworkContext );
+}
+
+/**
+ * @brief Test sending and receiving in both directions.
+ */
+void test_ShmTransport_Send_Recv( void )
+{
+    uint8_t buffer[ 16 ];
+
+    /* Nothing has been sent yet. */
+    TEST_ASSERT_EQUAL( 0, client.recv( client.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+
+    TEST_ASSERT_EQUAL( 5, client.send( client.pNetworkContext, "hello", 5U ) );
+    TEST_ASSERT_EQUAL( 2, broker.recv( broker.pNetworkContext, buffer, 2U ) );
+    TEST_ASSERT_EQUAL_MEMORY( "he", buffer, 2U );
+    TEST_ASSERT_EQUAL( 3, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "llo", buffer, 3U );
+
+    TEST_ASSERT_EQUAL( 5, broker.send( broker.pNetworkContext, "world", 5U ) );
+    TEST_ASSERT_EQUAL( 5, client.recv( client.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "world", buffer, 5U );
+}
+
+/**
+ * @brief Test bytes that wrap around the end of the ring.
+ */
+void test_ShmTransport_Wrap_Around( void )
+{
+    uint8_t bytes[ 50 ];
+    uint8_t buffer[ 64 ];
+    size_t i;
+
+    for( i = 0U; i < sizeof( bytes ); i++ )
+    {
+        bytes[ i ] = ( uint8_t ) i;
+    }
+
+    TEST_ASSERT_EQUAL( 40, client.send( client.pNetworkContext, bytes, 40U ) );
+    TEST_ASSERT_EQUAL( 40, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+
+    TEST_ASSERT_EQUAL( 50, client.send( client.pNetworkContext, bytes, sizeof( bytes ) ) );
+    TEST_ASSERT_EQUAL( 50, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( bytes, buffer, sizeof( bytes ) );
+}
+
+/**
+ * @brief Test that a full ring accepts no bytes until some are received.
+ */
+void test_ShmTransport_Ring_Full( void )
+{
+    uint8_t bytes[ RING_SIZE + 36U ] = { 0 };
+    uint8_t buffer[ 10 ];
+
+    TEST_ASSERT_EQUAL( RING_SIZE, client.send( client.pNetworkContext, bytes, sizeof( bytes ) ) );
+    TEST_ASSERT_EQUAL( 0, client.send( client.pNetworkContext, bytes, sizeof( bytes ) ) );
+
+    TEST_ASSERT_EQUAL( 10, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 10, client.send( client.pNetworkContext, bytes, sizeof( bytes ) ) );
+}
+
+/**
+ * @brief Test that vectors are copied in order and received together.
+ */
+void test_ShmTransport_Writev( void )
+{
+    TransportOutVector_t vectors[ 3 ];
+    uint8_t buffer[ 16 ];
+
+    vectors[ 0 ].iov_base = "\x30\x07";
+    vectors[ 0 ].iov_len = 2U;
+    vectors[ 1 ].iov_base = "\x00\x01t";
+    vectors[ 1 ].iov_len = 3U;
+    vectors[ 2 ].iov_base = "data";
+    vectors[ 2 ].iov_len = 4U;
+
+    TEST_ASSERT_EQUAL( 9, client.writev( client.pNetworkContext, vectors, 3U ) );
+    TEST_ASSERT_EQUAL( 9, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "\x30\x07\x00\x01tdata", buffer, 9U );
+
+    /* No vectors send no bytes. */
+    TEST_ASSERT_EQUAL( 0, client.writev( client.pNetworkContext, vectors, 0U ) );
+}
+
+/**
+ * @brief Test waiting with and without bytes to receive.
+ */
+void test_ShmTransport_Wait( void )
+{
+    TEST_ASSERT_EQUAL( ShmTransportTimeout, ShmTransport_Wait( &brokerEnd, 0U ) );
+    TEST_ASSERT_EQUAL( ShmTransportTimeout, ShmTransport_Wait( &brokerEnd, 10U ) );
+
+    TEST_ASSERT_EQUAL( 1, client.send( client.pNetworkContext, "x", 1U ) );
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Wait( &brokerEnd, 0U ) );
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Wait( &brokerEnd, 1000U ) );
+
+    /* The transport interface function waits the same way. */
+    TEST_ASSERT_EQUAL( 1, broker.waitReadable( broker.pNetworkContext, 0U ) );
+    TEST_ASSERT_EQUAL( 0, client.waitReadable( client.pNetworkContext, 10U ) );
+}
+
+/**
+ * @brief Test that a process waiting for bytes is woken by another process.
+ */
+void test_ShmTransport_Wait_Woken( void )
+{
+    uint8_t buffer[ 4 ];
+    int childStatus;
+    pid_t child;
+
+    child = fork();
+    TEST_ASSERT_TRUE( child >= 0 );
+
+    if( child == 0 )
+    {
+        ( void ) usleep( 20000 );
+        _exit( ( client.send( client.pNetworkContext, "wake", 4U ) == 4 ) ? EXIT_SUCCESS : EXIT_FAILURE );
+    }
+
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Wait( &brokerEnd, 5000U ) );
+    TEST_ASSERT_EQUAL( 4, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "wake", buffer, 4U );
+
+    TEST_ASSERT_EQUAL( child, waitpid( child, &childStatus, 0 ) );
+    TEST_ASSERT_TRUE( WIFEXITED( childStatus ) && ( WEXITSTATUS( childStatus ) == EXIT_SUCCESS ) );
+}
+
+/**
+ * @brief Test discarding bytes of the receive ring, across its end.
+ */
+void test_ShmTransport_Skip( void )
+{
+    uint8_t bytes[ 50 ];
+    uint8_t buffer[ 64 ];
+    size_t i;
+
+    for( i = 0U; i < sizeof( bytes ); i++ )
+    {
+        bytes[ i ] = ( uint8_t ) i;
+    }
+
+    TEST_ASSERT_EQUAL( 0, broker.skip( broker.pNetworkContext, 10U ) );
+
+    TEST_ASSERT_EQUAL( 40, client.send( client.pNetworkContext, bytes, 40U ) );
+    TEST_ASSERT_EQUAL( 40, broker.skip( broker.pNetworkContext, 40U ) );
+
+    TEST_ASSERT_EQUAL( 50, client.send( client.pNetworkContext, bytes, sizeof( bytes ) ) );
+    TEST_ASSERT_EQUAL( 30, broker.skip( broker.pNetworkContext, 30U ) );
+    TEST_ASSERT_EQUAL( 20, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( &( bytes[ 30 ] ), buffer, 20U );
+
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Disconnect( &clientEnd ) );
+    TEST_ASSERT_EQUAL( -1, broker.skip( broker.pNetworkContext, 10U ) );
+}
+
+/**
+ * @brief Test that a closed end is reported as an error after the bytes it
+ * sent before closing.
+ */
+void test_ShmTransport_Peer_Closed( void )
+{
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_EQUAL( 3, broker.send( broker.pNetworkContext, "end", 3U ) );
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Disconnect( &brokerEnd ) );
+
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Wait( &clientEnd, 1000U ) );
+    TEST_ASSERT_EQUAL( 3, client.recv( client.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, client.recv( client.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, client.send( client.pNetworkContext, "x", 1U ) );
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Wait( &clientEnd, 1000U ) );
+}
+
+/**
+ * @brief Test that a receive ring whose tail was moved beyond its size by
+ * the other end is treated as a closed connection.
+ */
+void test_ShmTransport_Corrupt_Tail( void )
+{
+    uint8_t buffer[ 4U * RING_SIZE ];
+
+    /* The tail is the first word of the control block of a ring. */
+    __atomic_store_n( ( uint32_t * ) clientEnd.pSendRing, 2U * RING_SIZE, __ATOMIC_RELEASE );
+
+    TEST_ASSERT_EQUAL( -1, broker.recv( broker.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, broker.skip( broker.pNetworkContext, sizeof( buffer ) ) );
+}
+
+/**
+ * @brief Test that the transport functions fail after disconnecting.
+ */
+void test_ShmTransport_Disconnect( void )
+{
+    uint8_t buffer[ 4 ];
+
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Disconnect( &clientEnd ) );
+    TEST_ASSERT_EQUAL( -1, clientEnd.segmentDescriptor );
+
+    TEST_ASSERT_EQUAL( -1, client.recv( client.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, client.send( client.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( ShmTransportBadParameter, ShmTransport_Wait( &clientEnd, 0U ) );
+
+    /* Disconnecting twice is harmless. */
+    TEST_ASSERT_EQUAL( ShmTransportSuccess, ShmTransport_Disconnect( &clientEnd ) );
+}
@@ -0,0 +1,402 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2022 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_sim_utest.c
+ * @brief Unit tests for functions in core_mqtt_transport_sim.h.
+ *
+ * The simulated transport wraps a scripted transport of the test, which
+ * receives an endless stream of letters and accepts every byte sent.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "unity.h"
+
+#include "core_mqtt_transport_sim.h"
+
+static SimTransport_t simTransport;
+static SimTransportConfig_t config;
+static TransportInterface_t scripted;
+static TransportInterface_t transport;
+static size_t streamPosition;
+static size_t recvCalls;
+static bool recvFails;
+static uint8_t sentBytes[ 64 ];
+static size_t sentCount;
+static size_t lastVectorCount;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+static int32_t scriptedRecv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+{
+    uint8_t * pBytes = ( uint8_t * ) pBuffer;
+    int32_t result = -1;
+    size_t i;
+
+    ( void ) pNetworkContext;
+
+    recvCalls++;
+
+    if( recvFails == false )
+    {
+        for( i = 0U; i < bytesToRecv; i++ )
+        {
+            pBytes[ i ] = ( uint8_t ) ( 'a' + ( ( streamPosition + i ) % 26U ) );
+        }
+
+        streamPosition += bytesToRecv;
+        result = ( int32_t ) bytesToRecv;
+    }
+
+    return result;
+}
+
+static int32_t scriptedWritev( NetworkContext_t * pNetworkContext,
+                               TransportOutVector_t * pIoVec,
+                               size_t ioVecCount )
+{
+    size_t i;
+    size_t total = 0U;
+
+    ( void ) pNetworkContext;
+
+    lastVectorCount = ioVecCount;
+
+    for( i = 0U; i < ioVecCount; i++ )
+    {
+        TEST_ASSERT_LESS_OR_EQUAL( sizeof( sentBytes ), sentCount + pIoVec[ i ].iov_len );
+        ( void ) memcpy( &( sentBytes[ sentCount ] ), pIoVec[ i ].iov_base, pIoVec[ i ].iov_len );
+        sentCount += pIoVec[ i ].iov_len;
+        total += pIoVec[ i ].iov_len;
+    }
+
+    return ( int32_t ) total;
+}
+
+static int32_t scriptedSend( NetworkContext_t * pNetworkContext,
+                             const void * pBuffer,
+                             size_t bytesToSend )
+{
+    TransportOutVector_t vector;
+
+    vector.iov_base = pBuffer;
+    vector.iov_len = bytesToSend;
+
+    return scriptedWritev( pNetworkContext, &vector, 1U );
+}
+
+static int32_t scriptedWaitReadable( NetworkContext_t * pNetworkContext,
+                                     uint32_t timeoutMs )
+{
+    ( void ) pNetworkContext;
+    ( void ) timeoutMs;
+
+    return 1;
+}
+
+/**
+ * @brief Set up the simulated transport with the impairments of #config.
+ */
+static void initTransport( void )
+{
+    TEST_ASSERT_EQUAL( SimTransportSuccess, SimTransport_Init( &simTransport, &scripted, &config ) );
+    SimTransport_GetInterface( &simTransport, &transport );
+}
+
+static uint64_t nowNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( uint64_t ) now.tv_sec * 1000000000U ) + ( uint64_t ) now.tv_nsec;
+}
+
+/* Called before each test method. */
+void setUp( void )
+{
+    ( void ) memset( &config, 0, sizeof( config ) );
+    ( void ) memset( &scripted, 0, sizeof( scripted ) );
+    scripted.recv = scriptedRecv;
+    scripted.send = scriptedSend;
+    scripted.writev = scriptedWritev;
+    scripted.waitReadable = scriptedWaitReadable;
+
+    streamPosition = 0U;
+    recvCalls = 0U;
+    recvFails = false;
+    sentCount = 0U;
+    lastVectorCount = 0U;
+}
+
+/* Called after each test method. */
+void tearDown( void )
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test the simulated transport functions with invalid parameters.
+ */
+void test_SimTransport_Invalid_Params( void )
+{
+    TransportInterface_t incomplete = scripted;
+    SimTransport_t unset = { 0 };
+    uint8_t buffer[ 4 ];
+
+    TEST_ASSERT_EQUAL( SimTransportBadParameter, SimTransport_Init( NULL, &scripted, &config ) );
+    TEST_ASSERT_EQUAL( SimTransportBadParameter, SimTransport_Init( &simTransport, NULL, &config ) );
+    TEST_ASSERT_EQUAL( SimTransportBadParameter, SimTransport_Init( &simTransport, &scripted, NULL ) );
+    incomplete.recv = NULL;
+    TEST_ASSERT_EQUAL( SimTransportBadParameter, SimTransport_Init( &simTransport, &incomplete, &config ) );
+    config.shortWritevPercent = 101U;
+    TEST_ASSERT_EQUAL( SimTransportBadParameter, SimTransport_Init( &simTransport, &scripted, &config ) );
+
+    TEST_ASSERT_EQUAL( -1, SimTransport_Recv( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, SimTransport_Recv( ( NetworkContext_t * ) &unset, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, SimTransport_Send( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, SimTransport_Writev( NULL, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, SimTransport_WaitReadable( NULL, 0U ) );
+
+    config.shortWritevPercent = 0U;
+    initTransport();
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, NULL, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.send( transport.pNetworkContext, NULL, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.writev( transport.pNetworkContext, NULL, 1U ) );
+
+    /* Neither argument of SimTransport_GetInterface may be NULL. */
+    ( void ) memset( &transport, 0, sizeof( transport ) );
+    SimTransport_GetInterface( NULL, &transport );
+    TEST_ASSERT_NULL( transport.recv );
+    SimTransport_GetInterface( &simTransport, NULL );
+}
+
+/**
+ * @brief Test that SimTransport_GetInterface only offers the optional
+ * functions of the wrapped transport.
+ */
+void test_SimTransport_GetInterface( void )
+{
+    initTransport();
+    TEST_ASSERT_TRUE( transport.recv == SimTransport_Recv );
+    TEST_ASSERT_TRUE( transport.send == SimTransport_Send );
+    TEST_ASSERT_TRUE( transport.writev == SimTransport_Writev );
+    TEST_ASSERT_TRUE( transport.waitReadable == SimTransport_WaitReadable );
+    TEST_ASSERT_NULL( transport.skip );
+    TEST_ASSERT_EQUAL_PTR( &simTransport, transport.pNetworkContext );
+
+    scripted.writev = NULL;
+    scripted.waitReadable = NULL;
+    initTransport();
+    TEST_ASSERT_NULL( transport.writev );
+    TEST_ASSERT_NULL( transport.waitReadable );
+}
+
+/**
+ * @brief Test that a transport without impairments passes every call on.
+ */
+void test_SimTransport_No_Impairments( void )
+{
+    TransportOutVector_t vectors[ 2 ] = { { "abcd", 4U }, { "efgh", 4U } };
+    uint8_t buffer[ 8 ];
+
+    initTransport();
+    TEST_ASSERT_EQUAL( 8, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "abcdefgh", buffer, 8U );
+    TEST_ASSERT_EQUAL( 8, transport.writev( transport.pNetworkContext, vectors, 2U ) );
+    TEST_ASSERT_EQUAL( 2U, lastVectorCount );
+    TEST_ASSERT_EQUAL( 3, transport.send( transport.pNetworkContext, "ijk", 3U ) );
+    TEST_ASSERT_EQUAL_MEMORY( "abcdefghijk", sentBytes, 11U );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 0U ) );
+
+    TEST_ASSERT_EQUAL( 8U, simTransport.stats.bytesReceived );
+    TEST_ASSERT_EQUAL( 11U, simTransport.stats.bytesSent );
+    TEST_ASSERT_EQUAL( 0U, simTransport.stats.shortWrites );
+}
+
+/**
+ * @brief Test that receives and sends are cut to the most sizes.
+ */
+void test_SimTransport_Fragmentation( void )
+{
+    TransportOutVector_t vectors[ 2 ] = { { "abcd", 4U }, { "efgh", 4U } };
+    uint8_t buffer[ 8 ];
+
+    config.maxRecvSize = 1U;
+    config.maxSendSize = 5U;
+    initTransport();
+
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 'b', buffer[ 0 ] );
+
+    /* The wrapped transport gets the first vector and part of the second. */
+    TEST_ASSERT_EQUAL( 5, transport.writev( transport.pNetworkContext, vectors, 2U ) );
+    TEST_ASSERT_EQUAL( 2U, lastVectorCount );
+    TEST_ASSERT_EQUAL( 5, transport.send( transport.pNetworkContext, "ijklmnop", 8U ) );
+    TEST_ASSERT_EQUAL_MEMORY( "abcdeijklm", sentBytes, 10U );
+    TEST_ASSERT_EQUAL( 2U, simTransport.stats.shortWrites );
+}
+
+/**
+ * @brief Test that receives and sends return no bytes when told to, without
+ * calling the wrapped transport.
+ */
+void test_SimTransport_Zero_Returns( void )
+{
+    TransportOutVector_t vector = { "abcd", 4U };
+    uint8_t buffer[ 8 ];
+
+    config.zeroRecvPercent = 100U;
+    config.zeroSendPercent = 100U;
+    initTransport();
+
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0, transport.send( transport.pNetworkContext, "abcd", 4U ) );
+    TEST_ASSERT_EQUAL( 0, transport.writev( transport.pNetworkContext, &vector, 1U ) );
+    TEST_ASSERT_EQUAL( 0U, recvCalls );
+    TEST_ASSERT_EQUAL( 0U, sentCount );
+    TEST_ASSERT_EQUAL( 1U, simTransport.stats.zeroRecvs );
+    TEST_ASSERT_EQUAL( 2U, simTransport.stats.zeroSends );
+    TEST_ASSERT_EQUAL( 0U, simTransport.stats.shortWrites );
+}
+
+/**
+ * @brief Test that short writev results cut at random points, the same for
+ * the same seed, and do not affect send.
+ */
+void test_SimTransport_Short_Writev( void )
+{
+    TransportOutVector_t vectors[ 2 ];
+    int32_t results[ 8 ];
+    int32_t result;
+    size_t i;
+
+    config.seed = 42U;
+    config.shortWritevPercent = 100U;
+    initTransport();
+
+    for( i = 0U; i < 8U; i++ )
+    {
+        vectors[ 0 ].iov_base = "abcd";
+        vectors[ 0 ].iov_len = 4U;
+        vectors[ 1 ].iov_base = "efgh";
+        vectors[ 1 ].iov_len = 4U;
+        sentCount = 0U;
+        results[ i ] = transport.writev( transport.pNetworkContext, vectors, 2U );
+        TEST_ASSERT_GREATER_OR_EQUAL( 1, results[ i ] );
+        TEST_ASSERT_LESS_OR_EQUAL( 7, results[ i ] );
+        TEST_ASSERT_EQUAL_MEMORY( "abcdefgh", sentBytes, ( size_t ) results[ i ] );
+    }
+
+    TEST_ASSERT_EQUAL( 4, transport.send( transport.pNetworkContext, "abcd", 4U ) );
+
+    /* The same seed gives the same cuts. */
+    initTransport();
+
+    for( i = 0U; i < 8U; i++ )
+    {
+        vectors[ 0 ].iov_base = "abcd";
+        vectors[ 0 ].iov_len = 4U;
+        vectors[ 1 ].iov_base = "efgh";
+        vectors[ 1 ].iov_len = 4U;
+        sentCount = 0U;
+        result = transport.writev( transport.pNetworkContext, vectors, 2U );
+        TEST_ASSERT_EQUAL( results[ i ], result );
+    }
+}
+
+/**
+ * @brief Test that received bytes are held for the latency, and that an error
+ * of the wrapped transport follows the bytes held before it.
+ */
+void test_SimTransport_Latency( void )
+{
+    uint8_t buffer[ 8 ];
+    uint64_t start;
+
+    config.latencyUs = 20000U;
+    initTransport();
+    start = nowNs();
+
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0, transport.waitReadable( transport.pNetworkContext, 1U ) );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 1000U ) );
+    TEST_ASSERT_GREATER_OR_EQUAL( 20000000U, nowNs() - start );
+
+    recvFails = true;
+    TEST_ASSERT_EQUAL( 8, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "abcdefgh", buffer, 8U );
+    TEST_ASSERT_EQUAL( 8, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "ijklmnop", buffer, 8U );
+
+    /* The queue is emptied before the error is returned. */
+    while( simTransport.chunkCount > 0U )
+    {
+        TEST_ASSERT_GREATER_THAN( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    }
+
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+}
+
+/**
+ * @brief Test that the rates limit the bytes of each direction, and that
+ * waiting sleeps until a byte may be received.
+ */
+void test_SimTransport_Bandwidth( void )
+{
+    uint8_t buffer[ 64 ];
+    uint8_t payload[ 64 ] = { 0 };
+
+    /* Bursts of 10 bytes. */
+    config.recvBytesPerSecond = 1000U;
+    config.sendBytesPerSecond = 1000U;
+    initTransport();
+
+    TEST_ASSERT_EQUAL( 10, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 10, transport.send( transport.pNetworkContext, payload, sizeof( payload ) ) );
+    TEST_ASSERT_EQUAL( 0, transport.send( transport.pNetworkContext, payload, sizeof( payload ) ) );
+
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 1000U ) );
+    TEST_ASSERT_GREATER_OR_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+}
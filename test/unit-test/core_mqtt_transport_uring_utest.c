@@ -0,0 +1,506 @@
+/*
+ * coreMQTT <DEVELOPMENT BRANCH>
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file core_mqtt_transport_uring_utest.c
+ * @brief Unit tests for functions in core_mqtt_transport_uring.h.
+ *
+ * The tests use connected pairs of UNIX domain sockets, with the transport
+ * on one end and the test on the other. They are ignored if the kernel does
+ * not support io_uring.
+ */
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "unity.h"
+
+#include "core_mqtt_transport_uring.h"
+
+/**
+ * @brief Number of connection slots of the ring used in the tests.
+ */
+#define SLOT_COUNT     ( 2U )
+
+/**
+ * @brief Size of the receive and send buffers of each connection.
+ */
+#define BUFFER_SIZE    ( 64U )
+
+/**
+ * @brief Time to wait for a connection to become ready.
+ */
+#define WAIT_MS        ( 1000U )
+
+static UringTransportRing_t ring;
+static UringTransport_t uringTransport;
+static TransportInterface_t transport;
+static uint8_t bufferMemory[ 2U * SLOT_COUNT * BUFFER_SIZE ];
+
+/**
+ * @brief Whether the ring was set up by setUp.
+ */
+static bool ringReady = false;
+
+/**
+ * @brief The end of the socket pair used by the test.
+ */
+static int peerSocket = -1;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp( void )
+{
+    UringTransportStatus_t status;
+    int sockets[ 2 ];
+
+    ( void ) memset( &uringTransport, 0, sizeof( uringTransport ) );
+    ( void ) memset( &transport, 0, sizeof( transport ) );
+    uringTransport.socketDescriptor = -1;
+    ringReady = false;
+
+    status = UringTransport_InitRing( &ring, 8U, bufferMemory, SLOT_COUNT, BUFFER_SIZE );
+
+    if( status == UringTransportNotSupported )
+    {
+        TEST_IGNORE_MESSAGE( "The kernel does not support io_uring." );
+    }
+
+    TEST_ASSERT_EQUAL( UringTransportSuccess, status );
+    ringReady = true;
+
+    TEST_ASSERT_EQUAL( 0, socketpair( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets ) );
+    peerSocket = sockets[ 1 ];
+
+    TEST_ASSERT_EQUAL( UringTransportSuccess,
+                       UringTransport_Attach( &ring, &uringTransport, 0U, sockets[ 0 ] ) );
+    UringTransport_GetInterface( &uringTransport, &transport );
+
+    /* The test end blocks, so that it can read what the transport writes. */
+    TEST_ASSERT_EQUAL( 0, fcntl( peerSocket, F_SETFL, 0 ) );
+}
+
+/* Called after each test method. */
+void tearDown( void )
+{
+    if( uringTransport.socketDescriptor >= 0 )
+    {
+        ( void ) UringTransport_Disconnect( &uringTransport, WAIT_MS );
+    }
+
+    if( ringReady == true )
+    {
+        ( void ) UringTransport_CleanupRing( &ring );
+    }
+
+    if( peerSocket >= 0 )
+    {
+        ( void ) close( peerSocket );
+        peerSocket = -1;
+    }
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Poll the ring until a connection is ready, and return it.
+ */
+static UringTransport_t * waitForReady( void )
+{
+    UringTransport_t * pReady = NULL;
+    size_t readyCount = 0U;
+    int attempts;
+
+    for( attempts = 0; ( attempts < 10 ) && ( readyCount == 0U ); attempts++ )
+    {
+        TEST_ASSERT_EQUAL( UringTransportSuccess,
+                           UringTransport_Poll( &ring, WAIT_MS, &pReady, 1U, &readyCount ) );
+    }
+
+    TEST_ASSERT_EQUAL( 1U, readyCount );
+
+    return pReady;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test the io_uring transport functions with invalid parameters.
+ */
+void test_UringTransport_Invalid_Params( void )
+{
+    UringTransportRing_t otherRing;
+    UringTransport_t otherTransport;
+    UringTransport_t * pReady;
+    size_t readyCount;
+    uint8_t buffer[ 4 ];
+
+    /* A rejected ring is not cleaned up, so the descriptor it holds stays
+     * open. */
+    ( void ) memset( &otherRing, 0, sizeof( otherRing ) );
+    otherRing.ringDescriptor = peerSocket;
+
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_InitRing( NULL, 8U, bufferMemory, SLOT_COUNT, BUFFER_SIZE ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_InitRing( &otherRing, 8U, NULL, SLOT_COUNT, BUFFER_SIZE ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_InitRing( &otherRing, 0U, bufferMemory, SLOT_COUNT, BUFFER_SIZE ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_InitRing( &otherRing, 8U, bufferMemory, 0U, BUFFER_SIZE ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_InitRing( &otherRing, 8U, bufferMemory, SLOT_COUNT, 0U ) );
+    TEST_ASSERT_NOT_EQUAL( -1, fcntl( peerSocket, F_GETFD ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter, UringTransport_CleanupRing( NULL ) );
+
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Attach( NULL, &otherTransport, 1U, peerSocket ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Attach( &ring, NULL, 1U, peerSocket ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Attach( &ring, &otherTransport, SLOT_COUNT, peerSocket ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Attach( &ring, &otherTransport, 1U, -1 ) );
+
+    TEST_ASSERT_EQUAL( UringTransportBadParameter, UringTransport_Disconnect( NULL, WAIT_MS ) );
+
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Poll( NULL, 0U, &pReady, 1U, &readyCount ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Poll( &ring, 0U, NULL, 1U, &readyCount ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Poll( &ring, 0U, &pReady, 0U, &readyCount ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter,
+                       UringTransport_Poll( &ring, 0U, &pReady, 1U, NULL ) );
+
+    TEST_ASSERT_EQUAL( -1, UringTransport_Recv( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, NULL, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, 0U ) );
+    TEST_ASSERT_EQUAL( -1, UringTransport_Send( NULL, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, UringTransport_Writev( NULL, NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, transport.writev( transport.pNetworkContext, NULL, 1U ) );
+    TEST_ASSERT_EQUAL( -1, UringTransport_WaitReadable( NULL, 0U ) );
+    TEST_ASSERT_EQUAL( -1, UringTransport_Skip( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( -1, transport.skip( transport.pNetworkContext, 0U ) );
+
+    /* Neither argument of UringTransport_GetInterface may be NULL. */
+    ( void ) memset( &transport, 0, sizeof( transport ) );
+    UringTransport_GetInterface( NULL, &transport );
+    TEST_ASSERT_NULL( transport.recv );
+    UringTransport_GetInterface( &uringTransport, NULL );
+}
+
+/**
+ * @brief Test that UringTransport_GetInterface fills all of the callbacks.
+ */
+void test_UringTransport_GetInterface( void )
+{
+    TEST_ASSERT_TRUE( transport.recv == UringTransport_Recv );
+    TEST_ASSERT_TRUE( transport.send == UringTransport_Send );
+    TEST_ASSERT_TRUE( transport.writev == UringTransport_Writev );
+    TEST_ASSERT_TRUE( transport.waitReadable == UringTransport_WaitReadable );
+    TEST_ASSERT_TRUE( transport.skip == UringTransport_Skip );
+    TEST_ASSERT_EQUAL_PTR( &uringTransport, transport.pNetworkContext );
+}
+
+/**
+ * @brief Test sending and receiving through the ring.
+ */
+void test_UringTransport_Send_Recv( void )
+{
+    UringTransport_t * pReady;
+    size_t readyCount;
+    uint8_t buffer[ 16 ];
+
+    /* Nothing has been sent yet. */
+    TEST_ASSERT_EQUAL( UringTransportSuccess,
+                       UringTransport_Poll( &ring, 0U, &pReady, 1U, &readyCount ) );
+    TEST_ASSERT_EQUAL( 0U, readyCount );
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+
+    /* The copied bytes are written once the ring is entered. */
+    TEST_ASSERT_EQUAL( 5, transport.send( transport.pNetworkContext, "hello", 5U ) );
+    TEST_ASSERT_EQUAL( UringTransportSuccess,
+                       UringTransport_Poll( &ring, 0U, &pReady, 1U, &readyCount ) );
+    TEST_ASSERT_EQUAL( 5, read( peerSocket, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "hello", buffer, 5U );
+
+    TEST_ASSERT_EQUAL( 5, write( peerSocket, "world", 5U ) );
+    TEST_ASSERT_EQUAL_PTR( &uringTransport, waitForReady() );
+    TEST_ASSERT_EQUAL( 5, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "world", buffer, 5U );
+}
+
+/**
+ * @brief Test that received bytes are returned over several calls.
+ */
+void test_UringTransport_Recv_Partial( void )
+{
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_EQUAL( 12, write( peerSocket, "abcdefghijkl", 12U ) );
+    ( void ) waitForReady();
+
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, 1U ) );
+    TEST_ASSERT_EQUAL( 'a', buffer[ 0 ] );
+    TEST_ASSERT_EQUAL( 2, transport.recv( transport.pNetworkContext, buffer, 2U ) );
+    TEST_ASSERT_EQUAL_MEMORY( "bc", buffer, 2U );
+    TEST_ASSERT_EQUAL( 9, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "defghijkl", buffer, 9U );
+
+    /* The next receive has been queued again. */
+    TEST_ASSERT_EQUAL( 0, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( 3, write( peerSocket, "mno", 3U ) );
+    ( void ) waitForReady();
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "mno", buffer, 3U );
+}
+
+/**
+ * @brief Test that receiving enters the ring itself, so that the connection
+ * works without polling.
+ */
+void test_UringTransport_Recv_Without_Poll( void )
+{
+    uint8_t buffer[ 16 ];
+    int32_t result = 0;
+    int attempts;
+
+    TEST_ASSERT_EQUAL( 4, write( peerSocket, "ping", 4U ) );
+
+    for( attempts = 0; ( attempts < 1000 ) && ( result == 0 ); attempts++ )
+    {
+        result = transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) );
+
+        if( result == 0 )
+        {
+            ( void ) usleep( 1000 );
+        }
+    }
+
+    TEST_ASSERT_EQUAL( 4, result );
+    TEST_ASSERT_EQUAL_MEMORY( "ping", buffer, 4U );
+}
+
+/**
+ * @brief Test waiting for the receive of one connection.
+ */
+void test_UringTransport_WaitReadable( void )
+{
+    uint8_t buffer[ 16 ];
+
+    /* Nothing has been sent yet. */
+    TEST_ASSERT_EQUAL( 0, transport.waitReadable( transport.pNetworkContext, 0U ) );
+    TEST_ASSERT_EQUAL( 0, transport.waitReadable( transport.pNetworkContext, 10U ) );
+
+    TEST_ASSERT_EQUAL( 4, write( peerSocket, "ping", 4U ) );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 1000U ) );
+
+    /* Staged bytes need no wait. */
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, 1U ) );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 0U ) );
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "ing", buffer, 3U );
+
+    /* A closed peer ends the wait, so that the error is received. */
+    ( void ) close( peerSocket );
+    peerSocket = -1;
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 1000U ) );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+}
+
+/**
+ * @brief Test discarding staged bytes.
+ */
+void test_UringTransport_Skip( void )
+{
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_EQUAL( 12, write( peerSocket, "abcdefghijkl", 12U ) );
+    TEST_ASSERT_EQUAL( 1, transport.waitReadable( transport.pNetworkContext, 1000U ) );
+
+    TEST_ASSERT_EQUAL( 5, transport.skip( transport.pNetworkContext, 5U ) );
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, 3U ) );
+    TEST_ASSERT_EQUAL_MEMORY( "fgh", buffer, 3U );
+
+    /* At most the staged bytes are skipped. */
+    TEST_ASSERT_EQUAL( 4, transport.skip( transport.pNetworkContext, 10U ) );
+    TEST_ASSERT_EQUAL( 0, transport.skip( transport.pNetworkContext, 10U ) );
+}
+
+/**
+ * @brief Test that vectors are copied in order and written together.
+ */
+void test_UringTransport_Writev( void )
+{
+    TransportOutVector_t vectors[ 3 ];
+    UringTransport_t * pReady;
+    size_t readyCount;
+    uint8_t buffer[ 16 ];
+
+    vectors[ 0 ].iov_base = "\x30\x07";
+    vectors[ 0 ].iov_len = 2U;
+    vectors[ 1 ].iov_base = "\x00\x01t";
+    vectors[ 1 ].iov_len = 3U;
+    vectors[ 2 ].iov_base = "data";
+    vectors[ 2 ].iov_len = 4U;
+
+    TEST_ASSERT_EQUAL( 9, transport.writev( transport.pNetworkContext, vectors, 3U ) );
+    TEST_ASSERT_EQUAL( UringTransportSuccess,
+                       UringTransport_Poll( &ring, 0U, &pReady, 1U, &readyCount ) );
+    TEST_ASSERT_EQUAL( 9, read( peerSocket, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "\x30\x07\x00\x01tdata", buffer, 9U );
+
+    /* No vectors send no bytes. */
+    TEST_ASSERT_EQUAL( 0, transport.writev( transport.pNetworkContext, vectors, 0U ) );
+}
+
+/**
+ * @brief Test that no more than the send buffer is accepted at once, and
+ * that the rest is accepted once the ring writes it.
+ */
+void test_UringTransport_Send_Buffer_Full( void )
+{
+    uint8_t bytes[ BUFFER_SIZE + 16U ];
+    uint8_t buffer[ sizeof( bytes ) ];
+    size_t bytesRead = 0U;
+    ssize_t result;
+
+    ( void ) memset( bytes, 'x', sizeof( bytes ) );
+    bytes[ sizeof( bytes ) - 1U ] = 'y';
+
+    TEST_ASSERT_EQUAL( BUFFER_SIZE, transport.send( transport.pNetworkContext, bytes, sizeof( bytes ) ) );
+
+    /* The full buffer is submitted and written by the next call. */
+    TEST_ASSERT_EQUAL( 16, transport.send( transport.pNetworkContext, &( bytes[ BUFFER_SIZE ] ), 16U ) );
+    ( void ) UringTransport_Disconnect( &uringTransport, WAIT_MS );
+
+    do
+    {
+        result = read( peerSocket, &( buffer[ bytesRead ] ), sizeof( buffer ) - bytesRead );
+
+        if( result > 0 )
+        {
+            bytesRead += ( size_t ) result;
+        }
+    } while( result > 0 );
+
+    TEST_ASSERT_EQUAL( sizeof( bytes ), bytesRead );
+    TEST_ASSERT_EQUAL_MEMORY( bytes, buffer, sizeof( bytes ) );
+}
+
+/**
+ * @brief Test that a closed peer is reported as an error after the bytes
+ * received before it closed.
+ */
+void test_UringTransport_Peer_Closed( void )
+{
+    uint8_t buffer[ 16 ];
+
+    TEST_ASSERT_EQUAL( 3, write( peerSocket, "end", 3U ) );
+    ( void ) waitForReady();
+    ( void ) close( peerSocket );
+    peerSocket = -1;
+
+    TEST_ASSERT_EQUAL( 3, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_PTR( &uringTransport, waitForReady() );
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.send( transport.pNetworkContext, "x", 1U ) );
+}
+
+/**
+ * @brief Test that polling returns only the connections that received bytes.
+ */
+void test_UringTransport_Poll_Many_Connections( void )
+{
+    UringTransport_t otherTransport;
+    TransportInterface_t otherInterface;
+    UringTransport_t * ready[ SLOT_COUNT ];
+    uint8_t buffer[ 16 ];
+    int sockets[ 2 ];
+
+    TEST_ASSERT_EQUAL( 0, socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) );
+    TEST_ASSERT_EQUAL( UringTransportSuccess,
+                       UringTransport_Attach( &ring, &otherTransport, 1U, sockets[ 0 ] ) );
+    UringTransport_GetInterface( &otherTransport, &otherInterface );
+
+    TEST_ASSERT_EQUAL( 5, write( sockets[ 1 ], "other", 5U ) );
+    TEST_ASSERT_EQUAL_PTR( &otherTransport, waitForReady() );
+    TEST_ASSERT_EQUAL( 5, otherInterface.recv( otherInterface.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "other", buffer, 5U );
+
+    /* Connections that do not fit are returned by the next call. */
+    TEST_ASSERT_EQUAL( 1, write( sockets[ 1 ], "1", 1U ) );
+    TEST_ASSERT_EQUAL( 1, write( peerSocket, "0", 1U ) );
+    ready[ 0 ] = waitForReady();
+    ready[ 1 ] = waitForReady();
+    TEST_ASSERT_TRUE( ready[ 0 ] != ready[ 1 ] );
+    TEST_ASSERT_TRUE( ( ready[ 0 ] == &uringTransport ) || ( ready[ 0 ] == &otherTransport ) );
+    TEST_ASSERT_TRUE( ( ready[ 1 ] == &uringTransport ) || ( ready[ 1 ] == &otherTransport ) );
+
+    TEST_ASSERT_EQUAL( 1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( '0', buffer[ 0 ] );
+    TEST_ASSERT_EQUAL( 1, otherInterface.recv( otherInterface.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( '1', buffer[ 0 ] );
+
+    TEST_ASSERT_EQUAL( UringTransportSuccess, UringTransport_Disconnect( &otherTransport, WAIT_MS ) );
+    ( void ) close( sockets[ 1 ] );
+}
+
+/**
+ * @brief Test that disconnecting writes the bytes left, closes the socket,
+ * and makes the transport functions fail.
+ */
+void test_UringTransport_Disconnect( void )
+{
+    uint8_t buffer[ 4 ];
+
+    TEST_ASSERT_EQUAL( 3, transport.send( transport.pNetworkContext, "bye", 3U ) );
+    TEST_ASSERT_EQUAL( UringTransportSuccess, UringTransport_Disconnect( &uringTransport, WAIT_MS ) );
+    TEST_ASSERT_EQUAL( -1, uringTransport.socketDescriptor );
+    TEST_ASSERT_EQUAL( 0U, uringTransport.pendingOperations );
+
+    TEST_ASSERT_EQUAL( 3, read( peerSocket, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL_MEMORY( "bye", buffer, 3U );
+    TEST_ASSERT_EQUAL( 0, read( peerSocket, buffer, sizeof( buffer ) ) );
+
+    TEST_ASSERT_EQUAL( -1, transport.recv( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( -1, transport.send( transport.pNetworkContext, buffer, sizeof( buffer ) ) );
+    TEST_ASSERT_EQUAL( UringTransportBadParameter, UringTransport_Disconnect( &uringTransport, WAIT_MS ) );
+}
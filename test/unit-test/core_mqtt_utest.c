@@ -874,6 +874,49 @@ static int32_t transportSendNoBytes( NetworkContext_t * pNetworkContext,
     return 0;
 }
 
+/**
+ * @brief Number of calls to #transportSendRecord.
+ */
+static uint32_t sendCallCount = 0U;
+
+/**
+ * @brief Most bytes #transportSendRecord sends in one call, or 0 for no limit.
+ */
+static size_t sendChunkLimit = 0U;
+
+/**
+ * @brief Bytes sent with #transportSendRecord.
+ */
+static uint8_t sentBytes[ 512 ];
+
+/**
+ * @brief Number of bytes in #sentBytes.
+ */
+static size_t sentByteCount = 0U;
+
+/**
+ * @brief Mocked transport send that records the calls and the bytes sent,
+ * sending at most #sendChunkLimit bytes at a time.
+ */
+static int32_t transportSendRecord( NetworkContext_t * pNetworkContext,
+                                    const void * pBuffer,
+                                    size_t bytesToWrite )
+{
+    ( void ) pNetworkContext;
+
+    if( ( sendChunkLimit > 0U ) && ( bytesToWrite > sendChunkLimit ) )
+    {
+        bytesToWrite = sendChunkLimit;
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32( sizeof( sentBytes ) - sentByteCount, bytesToWrite );
+    memcpy( &sentBytes[ sentByteCount ], pBuffer, bytesToWrite );
+    sentByteCount += bytesToWrite;
+    sendCallCount++;
+
+    return ( int32_t ) bytesToWrite;
+}
+
 /**
  * @brief Mocked transport send that succeeds then fails.
  */
@@ -904,17 +947,14 @@ static int32_t transportSendSucceedThenFailAfterConnect( NetworkContext_t * pNet
                                                          size_t bytesToSend )
 {
     int32_t retVal = bytesToSend;
-    static int counter = 0;
 
     ( void ) pNetworkContext;
-    ( void ) pMessage;
-
-    counter++;
 
-    if( counter == 3 )
+    /* Fail when the stored publish is resent, however many calls the CONNECT
+     * took. */
+    if( pMessage == publishCopyBuffer )
     {
         retVal = -1;
-        counter = 0;
     }
 
     return retVal;
@@ -1022,6 +1062,62 @@ static int32_t transportRecvNoData( NetworkContext_t * pNetworkContext,
     return 0;
 }
 
+/**
+ * @brief Number of calls to #transportSkipSuccess.
+ */
+static uint32_t skipCallCount = 0U;
+
+/**
+ * @brief Number of bytes discarded by #transportSkipSuccess.
+ */
+static size_t skippedByteCount = 0U;
+
+/**
+ * @brief Mocked transport skip function that discards all the bytes asked for.
+ */
+static int32_t transportSkipSuccess( NetworkContext_t * pNetworkContext,
+                                     size_t bytesToSkip )
+{
+    ( void ) pNetworkContext;
+    skipCallCount++;
+    skippedByteCount += bytesToSkip;
+    return ( int32_t ) bytesToSkip;
+}
+
+/**
+ * @brief Mocked transport skip function that fails.
+ */
+static int32_t transportSkipFailure( NetworkContext_t * pNetworkContext,
+                                     size_t bytesToSkip )
+{
+    ( void ) pNetworkContext;
+    ( void ) bytesToSkip;
+    return -1;
+}
+
+/**
+ * @brief Number of calls to #transportWaitReadable.
+ */
+static uint32_t waitReadableCallCount = 0U;
+
+/**
+ * @brief Timeout passed to the last call to #transportWaitReadable.
+ */
+static uint32_t waitReadableTimeoutMs = 0U;
+
+/**
+ * @brief Mocked transport wait function that records its calls and returns
+ * as if the timeout expired.
+ */
+static int32_t transportWaitReadable( NetworkContext_t * pNetworkContext,
+                                      uint32_t timeoutMs )
+{
+    ( void ) pNetworkContext;
+    waitReadableCallCount++;
+    waitReadableTimeoutMs = timeoutMs;
+    return 0;
+}
+
 /**
  * @brief Initialize the transport interface with the mocked functions for
  * send and receive.
@@ -1034,6 +1130,8 @@ static void setupTransportInterface( TransportInterface_t * pTransport )
     pTransport->send = transportSendSuccess;
     pTransport->recv = transportRecvSuccess;
     pTransport->writev = transportWritevSuccess;
+    pTransport->waitReadable = NULL;
+    pTransport->skip = NULL;
 }
 
 /**
@@ -1423,6 +1521,71 @@ void test_MQTT_InitRetransmits_Invalid_Params( void )
 
 /* ========================================================================== */
 
+/**
+ * @brief Number of publishes passed to the last call of #publishBatchCallback.
+ */
+static size_t publishBatchCount = 0;
+
+/**
+ * @brief Whether any ack had been sent when #publishBatchCallback was called.
+ */
+static bool publishBatchAckSent = false;
+
+/**
+ * @brief Mocked publish batch callback.
+ *
+ * @param[in] pContext MQTT context pointer.
+ * @param[in] pDeserializedInfo Deserialized publishes of the batch.
+ * @param[in] publishCount Number of publishes in the batch.
+ */
+static void publishBatchCallback( MQTTContext_t * pContext,
+                                  MQTTDeserializedInfo_t * pDeserializedInfo,
+                                  size_t publishCount )
+{
+    TEST_ASSERT_NOT_NULL( pDeserializedInfo );
+
+    publishBatchCount = publishCount;
+    publishBatchAckSent = pContext->controlPacketSent;
+}
+
+/**
+ * @brief Test that invalid parameters cause MQTT_InitPublishBatch to return MQTTBadParameter.
+ */
+void test_MQTT_InitPublishBatch_Invalid_Params( void )
+{
+    MQTTStatus_t mqttStatus = { 0 };
+    MQTTContext_t context = { 0 };
+    MQTTDeserializedInfo_t batch[ 2 ];
+    MQTTPublishInfo_t batchPublishes[ 2 ];
+
+    mqttStatus = MQTT_InitPublishBatch( NULL, publishBatchCallback, batch, batchPublishes, 2 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    mqttStatus = MQTT_InitPublishBatch( &context, NULL, batch, batchPublishes, 2 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    mqttStatus = MQTT_InitPublishBatch( &context, publishBatchCallback, NULL, batchPublishes, 2 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    mqttStatus = MQTT_InitPublishBatch( &context, publishBatchCallback, batch, NULL, 2 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    mqttStatus = MQTT_InitPublishBatch( &context, publishBatchCallback, batch, batchPublishes, 0 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    /* The context has not been initialized with MQTT_Init. */
+    mqttStatus = MQTT_InitPublishBatch( &context, publishBatchCallback, batch, batchPublishes, 2 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    setUPContext( &context );
+    mqttStatus = MQTT_InitPublishBatch( &context, publishBatchCallback, batch, batchPublishes, 2 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL_PTR( publishBatchCallback, context.publishBatchCallback );
+    TEST_ASSERT_EQUAL( 2, context.publishBatchMaxCount );
+}
+
+/* ========================================================================== */
+
 static uint8_t * MQTT_SerializeConnectFixedHeader_cb( uint8_t * pIndex,
                                                       const MQTTConnectInfo_t * pConnectInfo,
                                                       const MQTTPublishInfo_t * pWillInfo,
@@ -1914,9 +2077,9 @@ void test_MQTT_Connect_sendConnect5( void )
     MQTT_GetConnectPacketSize_ReturnThruPtr_pPacketSize( &packetSize );
     MQTT_GetConnectPacketSize_ReturnThruPtr_pRemainingLength( &remainingLength );
 
-    /* We know the send was successful if MQTT_GetIncomingPacketTypeAndLength()
+    /* We know the send was successful if MQTT_GetIncomingPacketTypeAndLengthBuffered()
      * is called. */
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTRecvFailed );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTRecvFailed );
 
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
 
@@ -1947,7 +2110,7 @@ void test_MQTT_Connect_sendConnect6( void )
 
     MQTT_GetConnectPacketSize_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( 2 );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( 2 );
 
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
 
@@ -1981,8 +2144,8 @@ void test_MQTT_Connect_receiveConnack( void )
 
     /* Nothing received from transport interface. Set timeout to 2 for branch coverage. */
     timeout = 2;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTNoDataAvailable, status );
@@ -1990,8 +2153,8 @@ void test_MQTT_Connect_receiveConnack( void )
     /* Did not receive a CONNACK. */
     incomingPacket.type = MQTT_PACKET_TYPE_PINGRESP;
     incomingPacket.remainingLength = 0;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTBadResponse, status );
 
@@ -2000,15 +2163,15 @@ void test_MQTT_Connect_receiveConnack( void )
     incomingPacket.remainingLength = 2;
     timeout = 2;
     mqttContext.transportInterface.recv = transportRecvFailure;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
 
     /* Bad response when deserializing CONNACK. */
     mqttContext.transportInterface.recv = transportRecvSuccess;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTBadResponse );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTBadResponse, status );
@@ -2018,8 +2181,8 @@ void test_MQTT_Connect_receiveConnack( void )
     mqttContext.transportInterface.recv = transportRecvSuccess;
     connectInfo.cleanSession = true;
     sessionPresentExpected = true;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresentExpected );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
@@ -2053,10 +2216,10 @@ void test_MQTT_Connect_receiveConnack_retries( void )
 
     /* Test with retries. MQTT_MAX_CONNACK_RECEIVE_RETRY_COUNT is 2.
      * Nothing received from transport interface. */
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
     /* 2 retries. */
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTNoDataAvailable, status );
@@ -2064,23 +2227,23 @@ void test_MQTT_Connect_receiveConnack_retries( void )
     /* Did not receive a CONNACK. */
     incomingPacket.type = MQTT_PACKET_TYPE_PINGRESP;
     incomingPacket.remainingLength = 0;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTBadResponse, status );
 
     /* Transport receive failure when receiving rest of packet. */
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
 
     /* Bad response when deserializing CONNACK. */
     mqttContext.transportInterface.recv = transportRecvSuccess;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTBadResponse );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTBadResponse, status );
@@ -2116,8 +2279,8 @@ void test_MQTT_Connect_partial_receive( void )
 
     /* Timeout in receiving entire packet, for branch coverage. This is due to the fact that the mocked
      * receive function always returns 0 bytes read. */
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
@@ -2130,8 +2293,8 @@ void test_MQTT_Connect_partial_receive( void )
     /* Not enough space for packet, discard it. */
     mqttContext.networkBuffer.size = 2;
     incomingPacket.remainingLength = 3;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTNoDataAvailable, status );
 
@@ -2139,8 +2302,8 @@ void test_MQTT_Connect_partial_receive( void )
      * iterations of the discard loop are required to discard the packet, but only
      * one will run. */
     mqttContext.transportInterface.recv = transportRecvSuccess;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
 
@@ -2148,8 +2311,8 @@ void test_MQTT_Connect_partial_receive( void )
     /* (Mocked) read only one byte at a time to ensure timeout will occur. */
     mqttContext.transportInterface.recv = transportRecvOneByte;
     incomingPacket.remainingLength = 20;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
 
@@ -2157,12 +2320,223 @@ void test_MQTT_Connect_partial_receive( void )
     mqttContext.transportInterface.recv = transportRecvFailure;
     /* Test with dummy get time function to make sure there are no infinite loops. */
     mqttContext.getTime = getTimeDummy;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, MQTT_NO_TIMEOUT_MS, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
 }
 
+/**
+ * @brief Test that a CONNACK too big for the network buffer is discarded with
+ * the transport skip function, in chunks of the size of the network buffer
+ * with the timeout checked between them.
+ */
+void test_MQTT_Connect_discardPacket_skip( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    bool sessionPresent = false;
+    MQTTStatus_t status;
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPacketInfo_t incomingPacket = { 0 };
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+    transport.recv = transportRecvFailure;
+    transport.skip = transportSkipSuccess;
+
+    memset( &mqttContext, 0x0, sizeof( mqttContext ) );
+    MQTT_Init( &mqttContext, &transport, getTime, eventCallback, &networkBuffer );
+
+    MQTT_SerializeConnect_IgnoreAndReturn( MQTTSuccess );
+    MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
+    MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
+
+    mqttContext.networkBuffer.size = 10;
+    incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
+    incomingPacket.remainingLength = 30;
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+
+    skipCallCount = 0U;
+    skippedByteCount = 0U;
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 10U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTNoDataAvailable, status );
+    TEST_ASSERT_EQUAL_UINT32( 3U, skipCallCount );
+    TEST_ASSERT_EQUAL( 30U, skippedByteCount );
+
+    /* The timeout expires before the packet is skipped in small chunks. */
+    mqttContext.networkBuffer.size = 2;
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+
+    skipCallCount = 0U;
+    skippedByteCount = 0U;
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 10U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
+    TEST_ASSERT_LESS_THAN_UINT32( 15U, skipCallCount );
+    TEST_ASSERT_LESS_THAN( 30U, skippedByteCount );
+}
+
+/**
+ * @brief Test that MQTT_Connect waits on the transport instead of polling for
+ * the CONNACK, when the transport has a wait function.
+ */
+void test_MQTT_Connect_receiveConnack_waitReadable( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    bool sessionPresent = false;
+    MQTTStatus_t status;
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPacketInfo_t incomingPacket = { 0 };
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+    transport.waitReadable = transportWaitReadable;
+    connectInfo.cleanSession = true;
+
+    memset( &mqttContext, 0x0, sizeof( mqttContext ) );
+    MQTT_Init( &mqttContext, &transport, getTime, eventCallback, &networkBuffer );
+
+    MQTT_SerializeConnect_IgnoreAndReturn( MQTTSuccess );
+    MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
+    MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
+
+    /* The transport is waited on after each read that found no CONNACK, for
+     * no longer than the time left. */
+    waitReadableCallCount = 0U;
+    incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
+    incomingPacket.remainingLength = 2;
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 100U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_UINT32( 2U, waitReadableCallCount );
+    TEST_ASSERT_GREATER_THAN_UINT32( 0U, waitReadableTimeoutMs );
+    TEST_ASSERT_LESS_THAN_UINT32( 100U, waitReadableTimeoutMs );
+
+    /* The retry count bounds the loop when there is no timeout, so the
+     * transport is not waited on. */
+    mqttContext.connectStatus = MQTTNotConnected;
+    waitReadableCallCount = 0U;
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTNoDataAvailable, status );
+    TEST_ASSERT_EQUAL_UINT32( 0U, waitReadableCallCount );
+
+    /* The rest of the CONNACK does not arrive. The transport is waited on
+     * between receives until the polling timeout expires. */
+    mqttContext.transportInterface.recv = transportRecvNoData;
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
+    TEST_ASSERT_GREATER_THAN_UINT32( 0U, waitReadableCallCount );
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32( MQTT_RECV_POLLING_TIMEOUT_MS, waitReadableTimeoutMs );
+}
+
+/**
+ * @brief Callback for MQTT_GetIncomingPacketTypeAndLengthBuffered that places
+ * a CONNACK followed by a PINGRESP in the network buffer, as if both arrived
+ * in a single transport read.
+ */
+static MQTTStatus_t MQTT_GetIncomingPacketTypeAndLengthBuffered_cb( TransportRecv_t readFunc,
+                                                                    NetworkContext_t * pNetworkContext,
+                                                                    const MQTTFixedBuffer_t * pFixedBuffer,
+                                                                    size_t * pIndex,
+                                                                    MQTTPacketInfo_t * pIncomingPacket,
+                                                                    int numcallbacks )
+{
+    const uint8_t packets[] = { MQTT_PACKET_TYPE_CONNACK, 2U, 1U, 0U,
+                                MQTT_PACKET_TYPE_PINGRESP, 0U };
+
+    ( void ) readFunc;
+    ( void ) pNetworkContext;
+    ( void ) numcallbacks;
+
+    memcpy( &pFixedBuffer->pBuffer[ *pIndex ], packets, sizeof( packets ) );
+    *pIndex += sizeof( packets );
+
+    pIncomingPacket->type = MQTT_PACKET_TYPE_CONNACK;
+    pIncomingPacket->remainingLength = 2U;
+    pIncomingPacket->headerLength = 2U;
+
+    return MQTTSuccess;
+}
+
+/**
+ * @brief Test that MQTT_Connect uses the CONNACK read along with its header
+ * and keeps the bytes that follow it in the network buffer.
+ */
+void test_MQTT_Connect_receiveConnack_buffered( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTConnectInfo_t connectInfo = { 0 };
+    bool sessionPresent = false, sessionPresentExpected = true;
+    MQTTStatus_t status;
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+
+    /* No receive should be made beyond the buffered read. */
+    transport.recv = transportRecvFailure;
+
+    memset( &mqttContext, 0x0, sizeof( mqttContext ) );
+    MQTT_Init( &mqttContext, &transport, getTime, eventCallback, &networkBuffer );
+
+    MQTT_SerializeConnect_IgnoreAndReturn( MQTTSuccess );
+    MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
+    MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
+
+    /* Only part of the fixed header arrives before the retries run out.
+     * MQTT_MAX_CONNACK_RECEIVE_RETRY_COUNT is 2. */
+    mqttContext.index = 1;
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTRecvFailed, status );
+    TEST_ASSERT_EQUAL_INT( 0, mqttContext.index );
+
+    /* The CONNACK and a following PINGRESP are read together. */
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_Stub( MQTT_GetIncomingPacketTypeAndLengthBuffered_cb );
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresentExpected );
+    MQTT_PubrelToResend_ExpectAnyArgsAndReturn( MQTT_PACKET_ID_INVALID );
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_TRUE( sessionPresent );
+
+    /* Only the PINGRESP is left in the buffer. */
+    TEST_ASSERT_EQUAL_INT( 2, mqttContext.index );
+    TEST_ASSERT_EQUAL_INT( MQTT_PACKET_TYPE_PINGRESP, mqttContext.networkBuffer.pBuffer[ 0 ] );
+    TEST_ASSERT_EQUAL_INT( 0, mqttContext.networkBuffer.pBuffer[ 1 ] );
+
+    /* Starting a clean session keeps the bytes after the CONNACK too. */
+    mqttContext.connectStatus = MQTTNotConnected;
+    connectInfo.cleanSession = true;
+    sessionPresentExpected = false;
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresentExpected );
+    status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_FALSE( sessionPresent );
+
+    TEST_ASSERT_EQUAL_INT( 2, mqttContext.index );
+    TEST_ASSERT_EQUAL_INT( MQTT_PACKET_TYPE_PINGRESP, mqttContext.networkBuffer.pBuffer[ 0 ] );
+    TEST_ASSERT_EQUAL_INT( 0, mqttContext.networkBuffer.pBuffer[ 1 ] );
+}
+
 /**
  * @brief Test resend of pending acks in MQTT_Connect.
  */
@@ -2194,8 +2568,8 @@ void test_MQTT_Connect_resendPendingAcks( void )
     /* successful receive CONNACK packet. */
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     /* Return with a session present flag. */
     sessionPresent = true;
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
@@ -2213,8 +2587,8 @@ void test_MQTT_Connect_resendPendingAcks( void )
     sessionPresentResult = false;
     mqttContext.connectStatus = MQTTNotConnected;
     mqttContext.keepAliveIntervalSec = 0;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( packetIdentifier );
@@ -2232,8 +2606,8 @@ void test_MQTT_Connect_resendPendingAcks( void )
     mqttContext.connectStatus = MQTTNotConnected;
     mqttContext.keepAliveIntervalSec = 0;
     mqttContext.transportInterface.send = transportSendFailure;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( packetIdentifier );
@@ -2249,8 +2623,8 @@ void test_MQTT_Connect_resendPendingAcks( void )
     /* Test 4. One packet found in ack pending state, Sent
      * PUBREL successfully. */
     mqttContext.connectStatus = MQTTNotConnected;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( packetIdentifier );
@@ -2269,8 +2643,8 @@ void test_MQTT_Connect_resendPendingAcks( void )
      * for first and failed for second and no attempt for third. */
     mqttContext.keepAliveIntervalSec = 0;
     mqttContext.connectStatus = MQTTNotConnected;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     /* First packet. */
@@ -2293,8 +2667,8 @@ void test_MQTT_Connect_resendPendingAcks( void )
     /* Test 6. Two packets found in ack pending state. Sent PUBREL successfully
      * for first and failed for second. */
     mqttContext.connectStatus = MQTTNotConnected;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     /* First packet. */
@@ -2360,8 +2734,8 @@ void test_MQTT_Connect_resendUnAckedPublishes( void )
     /* successful receive CONNACK packet. */
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     /* Return with a session present flag. */
     sessionPresent = false;
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
@@ -2418,8 +2792,8 @@ void test_MQTT_Connect_resendUnAckedPublishes2( void )
     /* successful receive CONNACK packet. */
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     /* Return with a session present flag. */
     sessionPresent = true;
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
@@ -2481,8 +2855,8 @@ void test_MQTT_Connect_resendUnAckedPublishes3( void )
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
     sessionPresent = true;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( MQTT_PACKET_TYPE_INVALID );
@@ -2544,8 +2918,8 @@ void test_MQTT_Connect_resendUnAckedPublishes4( void )
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
     sessionPresent = true;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( MQTT_PACKET_TYPE_INVALID );
@@ -2600,8 +2974,8 @@ void test_MQTT_Connect_resendUnAckedPublishes5( void )
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
     sessionPresent = true;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( MQTT_PACKET_TYPE_INVALID );
@@ -2657,8 +3031,8 @@ void test_MQTT_Connect_resendUnAckedPublishes6( void )
     sessionPresent = true;
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresent );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( MQTT_PACKET_TYPE_INVALID );
@@ -2704,8 +3078,8 @@ void test_MQTT_Connect_happy_path1()
     MQTT_SerializeConnect_IgnoreAndReturn( MQTTSuccess );
     MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_IgnoreAndReturn( MQTTSuccess );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
@@ -2741,8 +3115,8 @@ void test_MQTT_Connect_happy_path2()
     /* Success. */
     incomingPacket.type = MQTT_PACKET_TYPE_CONNACK;
     incomingPacket.remainingLength = 2;
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_IgnoreAndReturn( MQTTSuccess );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
     TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
@@ -2785,8 +3159,8 @@ void test_MQTT_Connect_happy_path3()
     MQTT_SerializeConnect_IgnoreAndReturn( MQTTSuccess );
     MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
 
     status = MQTT_Connect( &mqttContext, &connectInfo, &willInfo, timeout, &sessionPresent );
@@ -2843,8 +3217,8 @@ void test_MQTT_Connect_happy_path4()
     MQTT_SerializeConnect_IgnoreAndReturn( MQTTSuccess );
     MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresentExpected );
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, timeout, &sessionPresent );
@@ -2896,8 +3270,8 @@ void test_MQTT_Connect_happy_path5()
     MQTT_SerializeConnect_IgnoreAndReturn( MQTTSuccess );
     MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_DeserializeAck_ReturnThruPtr_pSessionPresent( &sessionPresentExpected );
     MQTT_PubrelToResend_ExpectAnyArgsAndReturn( MQTT_PACKET_TYPE_INVALID );
@@ -2940,9 +3314,9 @@ void test_MQTT_Connect_happy_path6()
 
     MQTT_GetConnectPacketSize_IgnoreAndReturn( MQTTSuccess );
     MQTT_SerializeConnectFixedHeader_Stub( MQTT_SerializeConnectFixedHeader_cb );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
-    MQTT_GetIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_GetIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTNoDataAvailable );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetIncomingPacketTypeAndLengthBuffered_ReturnThruPtr_pIncomingPacket( &incomingPacket );
     MQTT_DeserializeAck_IgnoreAndReturn( MQTTSuccess );
 
     status = MQTT_Connect( &mqttContext, &connectInfo, NULL, 0U, &sessionPresent );
@@ -3372,61 +3746,252 @@ void test_MQTT_Publish_WriteVSendsPartialBytes( void )
 }
 
 /**
- * @brief Test that MQTT_Publish works as intended.
+ * @brief Fixed header of a QoS 1 PUBLISH, returned by the mocked serializer in
+ * the tests of sending without writev.
  */
-void test_MQTT_Publish7( void )
-{
-    MQTTContext_t mqttContext = { 0 };
-    MQTTPublishInfo_t publishInfo = { 0 };
-    TransportInterface_t transport = { 0 };
-    MQTTFixedBuffer_t networkBuffer = { 0 };
-    MQTTStatus_t status;
+static const uint8_t publishHeader[ 5 ] = { MQTT_PACKET_TYPE_PUBLISH | 0x02U, 0x00U, 0x00U, 0x00U, 0x00U };
 
-    setupTransportInterface( &transport );
-    setupNetworkBuffer( &networkBuffer );
-    transport.writev = transportWritevFail;
+/**
+ * @brief Set up a QoS 1 publish with a header of @p headerLen bytes for the
+ * tests of sending without writev.
+ */
+static void setupPublishWithoutWritev( MQTTContext_t * pContext,
+                                       TransportInterface_t * pTransport,
+                                       MQTTFixedBuffer_t * pNetworkBuffer,
+                                       MQTTPubAckInfo_t * pOutgoingRecords,
+                                       size_t * pHeaderLen )
+{
+    setupTransportInterface( pTransport );
+    setupNetworkBuffer( pNetworkBuffer );
+    pTransport->writev = NULL;
+    pTransport->send = transportSendRecord;
 
-    memset( &mqttContext, 0x0, sizeof( mqttContext ) );
-    memset( &publishInfo, 0x0, sizeof( publishInfo ) );
-    MQTT_Init( &mqttContext, &transport, getTime, eventCallback, &networkBuffer );
+    memset( pContext, 0x0, sizeof( MQTTContext_t ) );
+    MQTT_Init( pContext, pTransport, getTime, eventCallback, pNetworkBuffer );
+    pContext->outgoingPublishRecordMaxCount = 1;
+    pContext->outgoingPublishRecords = pOutgoingRecords;
+    pContext->connectStatus = MQTTConnected;
 
     MQTT_GetPublishPacketSize_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_SerializePublishHeaderWithoutTopic_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_SerializePublishHeaderWithoutTopic_ReturnThruPtr_headerSize( pHeaderLen );
+    MQTT_SerializePublishHeaderWithoutTopic_ReturnArrayThruPtr_pBuffer( publishHeader, *pHeaderLen );
+    MQTT_ReserveState_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_UpdateDuplicatePublishFlag_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_UpdateDuplicatePublishFlag_ExpectAnyArgsAndReturn( MQTTSuccess );
-    mqttContext.connectStatus = MQTTConnected;
+    MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
 
-    /* We need sendPacket to be called with at least 1 byte to send, so that
-     * it can return failure. This argument is the output of serializing the
-     * publish header. */
-    publishInfo.pPayload = "Test";
-    publishInfo.payloadLength = 4;
-    status = MQTT_Publish( &mqttContext, &publishInfo, 0 );
-    TEST_ASSERT_EQUAL_INT( MQTTSendFailed, status );
+    sendCallCount = 0U;
+    sendChunkLimit = 0U;
+    sentByteCount = 0U;
 }
 
 /**
- * @brief Test that MQTT_Publish works as intended.
+ * @brief Test that without writev, the vectors of a small publish are
+ * gathered and sent with one call.
  */
-void test_MQTT_Publish8( void )
+void test_MQTT_Publish_GatherSmallVectors( void )
 {
     MQTTContext_t mqttContext = { 0 };
     MQTTPublishInfo_t publishInfo = { 0 };
     TransportInterface_t transport = { 0 };
     MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPubAckInfo_t outgoingPublishRecord[ 1 ];
     MQTTStatus_t status;
+    size_t headerLen = 4;
+    const uint8_t expected[] = "TestTopic\x00\x0ATestPublish";
 
-    setupTransportInterface( &transport );
-    setupNetworkBuffer( &networkBuffer );
-    transport.writev = transportWritevFail;
-
-    memset( &mqttContext, 0x0, sizeof( mqttContext ) );
-    memset( &publishInfo, 0x0, sizeof( publishInfo ) );
-    MQTT_Init( &mqttContext, &transport, getTime, eventCallback, &networkBuffer );
-
-    mqttContext.connectStatus = MQTTConnected;
+    setupPublishWithoutWritev( &mqttContext, &transport, &networkBuffer,
+                               outgoingPublishRecord, &headerLen );
 
-    /* We want to test the first call to sendPacket within sendPublish succeeding,
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = "TestTopic";
+    publishInfo.topicNameLength = strlen( publishInfo.pTopicName );
+    publishInfo.pPayload = "TestPublish";
+    publishInfo.payloadLength = strlen( publishInfo.pPayload );
+
+    status = MQTT_Publish( &mqttContext, &publishInfo, 10 );
+
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_UINT32( 1U, sendCallCount );
+    TEST_ASSERT_EQUAL( headerLen + sizeof( expected ) - 1U, sentByteCount );
+    TEST_ASSERT_EQUAL_MEMORY( expected, &sentBytes[ headerLen ], sizeof( expected ) - 1U );
+}
+
+/**
+ * @brief Test that without writev, a payload too large for the gather buffer
+ * is sent with its own call after the gathered header.
+ */
+void test_MQTT_Publish_GatherLargePayload( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPubAckInfo_t outgoingPublishRecord[ 1 ];
+    MQTTStatus_t status;
+    size_t headerLen = 5;
+    uint8_t payload[ MQTT_SEND_GATHER_BUFFER_SIZE + 1U ];
+
+    memset( payload, 0xA5, sizeof( payload ) );
+    setupPublishWithoutWritev( &mqttContext, &transport, &networkBuffer,
+                               outgoingPublishRecord, &headerLen );
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = "TestTopic";
+    publishInfo.topicNameLength = strlen( publishInfo.pTopicName );
+    publishInfo.pPayload = payload;
+    publishInfo.payloadLength = sizeof( payload );
+
+    status = MQTT_Publish( &mqttContext, &publishInfo, 10 );
+
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL_UINT32( 2U, sendCallCount );
+    TEST_ASSERT_EQUAL( headerLen + 9U + 2U + sizeof( payload ), sentByteCount );
+    TEST_ASSERT_EQUAL_MEMORY( "TestTopic\x00\x0A", &sentBytes[ headerLen ], 11U );
+    TEST_ASSERT_EQUAL_MEMORY( payload, &sentBytes[ headerLen + 11U ], sizeof( payload ) );
+}
+
+/**
+ * @brief Test that without writev, gathered vectors are sent in order when the
+ * transport sends only part of them at a time.
+ */
+void test_MQTT_Publish_GatherPartialSends( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPubAckInfo_t outgoingPublishRecord[ 1 ];
+    MQTTStatus_t status;
+    size_t headerLen = 2;
+    const uint8_t expected[] = "TestTopic\x00\x0ATestPublish";
+
+    setupPublishWithoutWritev( &mqttContext, &transport, &networkBuffer,
+                               outgoingPublishRecord, &headerLen );
+    sendChunkLimit = 3U;
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = "TestTopic";
+    publishInfo.topicNameLength = strlen( publishInfo.pTopicName );
+    publishInfo.pPayload = "TestPublish";
+    publishInfo.payloadLength = strlen( publishInfo.pPayload );
+
+    status = MQTT_Publish( &mqttContext, &publishInfo, 10 );
+
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+    TEST_ASSERT_EQUAL( headerLen + sizeof( expected ) - 1U, sentByteCount );
+    TEST_ASSERT_EQUAL_UINT32( ( sentByteCount + 2U ) / 3U, sendCallCount );
+    TEST_ASSERT_EQUAL_MEMORY( expected, &sentBytes[ headerLen ], sizeof( expected ) - 1U );
+}
+
+/**
+ * @brief Test that the metrics count the transport calls and bytes of a
+ * publish, and the publish records in use.
+ */
+void test_MQTT_Publish_Metrics( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPubAckInfo_t outgoingPublishRecord[ 1 ] = { 0 };
+    MQTTMetrics_t metrics;
+    MQTTMetrics_t snapshot;
+    MQTTStatus_t status;
+    size_t headerLen = 2;
+    size_t publishIndex = MQTT_METRICS_INDEX( MQTT_PACKET_TYPE_PUBLISH );
+
+    setupPublishWithoutWritev( &mqttContext, &transport, &networkBuffer,
+                               outgoingPublishRecord, &headerLen );
+    sendChunkLimit = 10U;
+
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, MQTT_InitMetrics( &mqttContext, &metrics ) );
+
+    /* The mocked state engine does not fill the record, so it is filled as
+     * MQTT_ReserveState would. */
+    outgoingPublishRecord[ 0 ].packetId = 10;
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = "TestTopic";
+    publishInfo.topicNameLength = strlen( publishInfo.pTopicName );
+    publishInfo.pPayload = "TestPublish";
+    publishInfo.payloadLength = strlen( publishInfo.pPayload );
+
+    status = MQTT_Publish( &mqttContext, &publishInfo, 10 );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, status );
+
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, MQTT_GetMetrics( &mqttContext, &snapshot ) );
+    TEST_ASSERT_EQUAL_UINT32( 1U, snapshot.packetsSent[ publishIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( sentByteCount, ( uint32_t ) snapshot.bytesSent[ publishIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( sendCallCount, snapshot.transportSendCalls );
+    TEST_ASSERT_EQUAL_UINT32( sendCallCount - 1U, snapshot.partialSends );
+    TEST_ASSERT_EQUAL( 1U, snapshot.outgoingPublishRecordsMax );
+    TEST_ASSERT_EQUAL( 0U, snapshot.incomingPublishRecordsMax );
+
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, MQTT_ResetMetrics( &mqttContext ) );
+    TEST_ASSERT_EQUAL_INT( MQTTSuccess, MQTT_GetMetrics( &mqttContext, &snapshot ) );
+    TEST_ASSERT_EQUAL_UINT32( 0U, snapshot.packetsSent[ publishIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 0U, snapshot.transportSendCalls );
+    TEST_ASSERT_EQUAL( 0U, snapshot.outgoingPublishRecordsMax );
+}
+
+/**
+ * @brief Test that MQTT_Publish works as intended.
+ */
+void test_MQTT_Publish7( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTStatus_t status;
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+    transport.writev = transportWritevFail;
+
+    memset( &mqttContext, 0x0, sizeof( mqttContext ) );
+    memset( &publishInfo, 0x0, sizeof( publishInfo ) );
+    MQTT_Init( &mqttContext, &transport, getTime, eventCallback, &networkBuffer );
+
+    MQTT_GetPublishPacketSize_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_SerializePublishHeaderWithoutTopic_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateDuplicatePublishFlag_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateDuplicatePublishFlag_ExpectAnyArgsAndReturn( MQTTSuccess );
+    mqttContext.connectStatus = MQTTConnected;
+
+    /* We need sendPacket to be called with at least 1 byte to send, so that
+     * it can return failure. This argument is the output of serializing the
+     * publish header. */
+    publishInfo.pPayload = "Test";
+    publishInfo.payloadLength = 4;
+    status = MQTT_Publish( &mqttContext, &publishInfo, 0 );
+    TEST_ASSERT_EQUAL_INT( MQTTSendFailed, status );
+}
+
+/**
+ * @brief Test that MQTT_Publish works as intended.
+ */
+void test_MQTT_Publish8( void )
+{
+    MQTTContext_t mqttContext = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTStatus_t status;
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+    transport.writev = transportWritevFail;
+
+    memset( &mqttContext, 0x0, sizeof( mqttContext ) );
+    memset( &publishInfo, 0x0, sizeof( publishInfo ) );
+    MQTT_Init( &mqttContext, &transport, getTime, eventCallback, &networkBuffer );
+
+    mqttContext.connectStatus = MQTTConnected;
+
+    /* We want to test the first call to sendPacket within sendPublish succeeding,
      * and the second one failing. */
     mqttContext.transportInterface.send = transportSendSucceedThenFail;
     MQTT_GetPublishPacketSize_ExpectAnyArgsAndReturn( MQTTSuccess );
@@ -4062,120 +4627,394 @@ void test_MQTT_ProcessLoop_discardPacket( void )
     TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
 }
 
-void test_MQTT_ProcessLoop_IncomingBufferNotInit( void )
+/**
+ * @brief Test that a packet too big for the network buffer is discarded with
+ * the transport skip function, in chunks of the size of the network buffer,
+ * without receiving it.
+ */
+void test_MQTT_ProcessLoop_discardPacket_skip( void )
 {
     MQTTContext_t context = { 0 };
     TransportInterface_t transport = { 0 };
     MQTTFixedBuffer_t networkBuffer = { 0 };
-    MQTTStatus_t mqttStatus;
     MQTTPacketInfo_t incomingPacket = { 0 };
-    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t mqttStatus;
 
-    setupTransportInterface( &transport );
     setupNetworkBuffer( &networkBuffer );
+    setupTransportInterface( &transport );
+    transport.skip = transportSkipSuccess;
 
     mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
 
-    /* First byte shows that it is a publish type packet. */
-    mqttBuffer[ 0 ] = MQTT_PACKET_TYPE_PUBLISH;
-    /* Length of the packet. */
-    mqttBuffer[ 1 ] = 20;
+    context.connectStatus = MQTTConnected;
+    context.networkBuffer.size = 20;
 
-    incomingPacket.type = MQTT_PACKET_TYPE_PUBLISH;
+    incomingPacket.type = currentPacketType;
     incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
     incomingPacket.headerLength = MQTT_SAMPLE_REMAINING_LENGTH;
 
     MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
 
-    /* Assume QoS = 1. */
-    publishInfo.qos = MQTTQoS1;
+    skipCallCount = 0U;
+    skippedByteCount = 0U;
+    mqttStatus = MQTT_ProcessLoop( &context );
 
-    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfo );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    /* The 108 bytes after the 20 in the buffer are skipped 20 at a time. */
+    TEST_ASSERT_EQUAL_UINT32( 6U, skipCallCount );
+    TEST_ASSERT_EQUAL( MQTT_SAMPLE_REMAINING_LENGTH + MQTT_SAMPLE_REMAINING_LENGTH - context.networkBuffer.size,
+                       skippedByteCount );
+    TEST_ASSERT_EQUAL( 0U, context.index );
+
+    /* A failed skip disconnects as a failed receive does. */
+    context.transportInterface.skip = transportSkipFailure;
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
 
     mqttStatus = MQTT_ProcessLoop( &context );
 
     TEST_ASSERT_EQUAL( MQTTRecvFailed, mqttStatus );
+    TEST_ASSERT_EQUAL( MQTTDisconnectPending, context.connectStatus );
 }
 
-void test_MQTT_ProcessLoop_IncomingBufferNotInitQoS0( void )
+/**
+ * @brief Test that the metrics count the receive calls, discarded packets,
+ * partial packets and keep alive events of the process loop.
+ */
+void test_MQTT_ProcessLoop_Metrics( void )
 {
     MQTTContext_t context = { 0 };
     TransportInterface_t transport = { 0 };
     MQTTFixedBuffer_t networkBuffer = { 0 };
-    MQTTStatus_t mqttStatus;
     MQTTPacketInfo_t incomingPacket = { 0 };
-    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTMetrics_t metrics;
+    MQTTStatus_t mqttStatus;
+    size_t pingreqSize = MQTT_PACKET_PINGREQ_SIZE;
 
-    setupTransportInterface( &transport );
     setupNetworkBuffer( &networkBuffer );
-
-    isEventCallbackInvoked = false;
+    setupTransportInterface( &transport );
+    transport.skip = transportSkipSuccess;
 
     mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_InitMetrics( &context, &metrics ) );
 
-    /* First byte shows that it is a publish type packet. */
-    mqttBuffer[ 0 ] = MQTT_PACKET_TYPE_PUBLISH;
-    /* Length of the packet. */
-    mqttBuffer[ 1 ] = 20;
+    context.connectStatus = MQTTConnected;
+    context.networkBuffer.size = 20;
 
+    /* A packet larger than the network buffer is discarded. */
     incomingPacket.type = MQTT_PACKET_TYPE_PUBLISH;
     incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
     incomingPacket.headerLength = MQTT_SAMPLE_REMAINING_LENGTH;
-
     MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
 
-    /* Assume QoS = 1. */
-    publishInfo.qos = MQTTQoS0;
+    mqttStatus = MQTT_ProcessLoop( &context );
 
-    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfo );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.transportRecvCalls );
+    TEST_ASSERT_EQUAL_UINT32( 6U, metrics.transportSkipCalls );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.discardedPackets );
+    TEST_ASSERT_EQUAL_UINT32( 2U * MQTT_SAMPLE_REMAINING_LENGTH, ( uint32_t ) metrics.discardedBytes );
+    TEST_ASSERT_EQUAL_UINT32( 0U, metrics.packetsReceived[ MQTT_METRICS_INDEX( MQTT_PACKET_TYPE_PUBLISH ) ] );
 
-    MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    /* Only part of a packet is in the network buffer. */
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
+
+    mqttStatus = MQTT_ProcessLoop( &context );
+
+    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, mqttStatus );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.needMoreBytes );
+
+    /* Nothing is received and a PINGREQ is sent to keep the connection
+     * alive. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_ResetMetrics( &context ) );
+    context.index = 0U;
+    context.pendingPacket.headerLength = 0U;
+    context.transportInterface.recv = transportRecvNoData;
+    context.keepAliveIntervalSec = 1;
+    globalEntryTime = MQTT_PINGRESP_TIMEOUT_MS;
+    MQTT_GetPingreqPacketSize_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_GetPingreqPacketSize_ReturnThruPtr_pPacketSize( &pingreqSize );
+    MQTT_SerializePingreq_ExpectAnyArgsAndReturn( MQTTSuccess );
 
     mqttStatus = MQTT_ProcessLoop( &context );
 
     TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
-    TEST_ASSERT_EQUAL( true, isEventCallbackInvoked );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.zeroByteRecvs );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.keepAlivePingsSent );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.transportSendCalls );
+
+    /* No PINGRESP arrives in time. */
+    globalEntryTime += MQTT_PINGRESP_TIMEOUT_MS + 1U;
+
+    mqttStatus = MQTT_ProcessLoop( &context );
+
+    TEST_ASSERT_EQUAL( MQTTKeepAliveTimeout, mqttStatus );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.keepAliveTimeouts );
 }
 
-void test_MQTT_ProcessLoop_HandleKeepAlive( void )
+/**
+ * @brief Test that the metrics functions reject invalid parameters and
+ * contexts without metrics.
+ */
+void test_MQTT_Metrics_Invalid_Params( void )
 {
     MQTTContext_t context = { 0 };
-    TransportInterface_t transport = { 0 };
-    MQTTFixedBuffer_t networkBuffer = { 0 };
-    MQTTStatus_t mqttStatus;
+    MQTTMetrics_t metrics;
 
-    setupTransportInterface( &transport );
-    transport.recv = transportRecvNoData;
-    setupNetworkBuffer( &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_InitMetrics( NULL, &metrics ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_InitMetrics( &context, NULL ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_GetMetrics( NULL, &metrics ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_GetMetrics( &context, NULL ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_GetMetrics( &context, &metrics ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ResetMetrics( NULL ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ResetMetrics( &context ) );
+}
 
-    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+/**
+ * @brief Time returned by #getTimeStill, which does not advance on its own.
+ */
+static uint32_t stillTimeMs = 0;
 
-    /* Set this value such that the library will be forced to send keep alive. */
-    context.waitingForPingResp = true;
-    /* Update the time so that there is timeout. */
-    globalEntryTime = MQTT_PINGRESP_TIMEOUT_MS;
-    mqttStatus = MQTT_ProcessLoop( &context );
+/**
+ * @brief How long #slowEventCallback takes.
+ */
+static uint32_t callbackDurationMs = 0;
 
-    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+/**
+ * @brief Packet type and duration given to #slowConsumerCallback.
+ */
+static uint8_t slowPacketType = 0;
+static uint32_t slowDurationMs = 0;
+static uint32_t slowConsumerCount = 0;
+
+static uint32_t getTimeStill( void )
+{
+    return stillTimeMs;
 }
 
-void test_MQTT_ProcessLoop_HandleKeepAlive1( void )
+static void slowEventCallback( MQTTContext_t * pContext,
+                               MQTTPacketInfo_t * pPacketInfo,
+                               MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+    ( void ) pPacketInfo;
+    ( void ) pDeserializedInfo;
+
+    stillTimeMs += callbackDurationMs;
+}
+
+static void slowConsumerCallback( MQTTContext_t * pContext,
+                                  uint8_t packetType,
+                                  uint32_t durationMs )
+{
+    ( void ) pContext;
+
+    slowPacketType = packetType;
+    slowDurationMs = durationMs;
+    slowConsumerCount++;
+}
+
+/**
+ * @brief Receive a SUBACK already in the network buffer with
+ * #MQTT_ReceiveLoop, while the application callback takes @p durationMs.
+ */
+static void receiveTimedSuback( MQTTContext_t * pContext,
+                                uint32_t durationMs )
+{
+    MQTTPacketInfo_t subackPacket = { 0 };
+
+    subackPacket.type = MQTT_PACKET_TYPE_SUBACK;
+    subackPacket.headerLength = 2;
+    subackPacket.remainingLength = 3;
+    pContext->index = 5;
+    callbackDurationMs = durationMs;
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &subackPacket );
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_RecordLatency_Expect( &pContext->pCallbackTiming->duration, durationMs );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_ReceiveLoop( pContext ) );
+}
+
+/**
+ * @brief Test that application callbacks are timed, that slow ones are
+ * reported, and that the network buffer is busy while they run.
+ */
+void test_MQTT_ReceiveLoop_CallbackTiming( void )
 {
     MQTTContext_t context = { 0 };
     TransportInterface_t transport = { 0 };
     MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTCallbackTiming_t timing;
     MQTTStatus_t mqttStatus;
-    size_t pingreqSize = MQTT_PACKET_PINGREQ_SIZE;
+    size_t subackIndex = MQTT_METRICS_INDEX( MQTT_PACKET_TYPE_SUBACK );
 
+    setupNetworkBuffer( &networkBuffer );
     setupTransportInterface( &transport );
     transport.recv = transportRecvNoData;
-    setupNetworkBuffer( &networkBuffer );
 
-    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    stillTimeMs = 1000;
+    slowConsumerCount = 0;
+
+    mqttStatus = MQTT_Init( &context, &transport, getTimeStill, slowEventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    mqttStatus = MQTT_InitCallbackTiming( &context, &timing, 10U, slowConsumerCallback );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    context.connectStatus = MQTTConnected;
+
+    /* A call within the budget is not reported. */
+    receiveTimedSuback( &context, 10U );
+
+    TEST_ASSERT_EQUAL_UINT32( 1U, timing.calls[ subackIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 10U, timing.maxMs[ subackIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 0U, timing.slowCalls );
+    TEST_ASSERT_EQUAL_UINT32( 0U, slowConsumerCount );
+    TEST_ASSERT_EQUAL_UINT32( 10U, ( uint32_t ) timing.bufferBusyMs );
+    TEST_ASSERT_FALSE( timing.bufferBusy );
+
+    /* A call over the budget is reported. */
+    receiveTimedSuback( &context, 25U );
+
+    TEST_ASSERT_EQUAL_UINT32( 2U, timing.calls[ subackIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 35U, ( uint32_t ) timing.totalMs[ subackIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 25U, timing.maxMs[ subackIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, timing.slowCalls );
+    TEST_ASSERT_EQUAL_UINT32( 1U, slowConsumerCount );
+    TEST_ASSERT_EQUAL( MQTT_PACKET_TYPE_SUBACK, slowPacketType );
+    TEST_ASSERT_EQUAL_UINT32( 25U, slowDurationMs );
+    TEST_ASSERT_EQUAL_UINT32( 35U, ( uint32_t ) timing.bufferBusyMs );
+    TEST_ASSERT_EQUAL_UINT32( 25U, timing.bufferBusyMaxMs );
+
+    /* Part of a packet keeps the network buffer busy. */
+    context.index = 1;
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
+    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, MQTT_ReceiveLoop( &context ) );
+    TEST_ASSERT_TRUE( timing.bufferBusy );
+    TEST_ASSERT_EQUAL_UINT32( 1035U, timing.bufferBusySinceMs );
+
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_InitCallbackTiming( NULL, &timing, 10U, NULL ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_InitCallbackTiming( &context, NULL, 10U, NULL ) );
+}
+
+void test_MQTT_ProcessLoop_IncomingBufferNotInit( void )
+{
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTStatus_t mqttStatus;
+    MQTTPacketInfo_t incomingPacket = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+
+    /* First byte shows that it is a publish type packet. */
+    mqttBuffer[ 0 ] = MQTT_PACKET_TYPE_PUBLISH;
+    /* Length of the packet. */
+    mqttBuffer[ 1 ] = 20;
+
+    incomingPacket.type = MQTT_PACKET_TYPE_PUBLISH;
+    incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
+    incomingPacket.headerLength = MQTT_SAMPLE_REMAINING_LENGTH;
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+
+    /* Assume QoS = 1. */
+    publishInfo.qos = MQTTQoS1;
+
+    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfo );
+
+    mqttStatus = MQTT_ProcessLoop( &context );
+
+    TEST_ASSERT_EQUAL( MQTTRecvFailed, mqttStatus );
+}
+
+void test_MQTT_ProcessLoop_IncomingBufferNotInitQoS0( void )
+{
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTStatus_t mqttStatus;
+    MQTTPacketInfo_t incomingPacket = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+
+    isEventCallbackInvoked = false;
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+
+    /* First byte shows that it is a publish type packet. */
+    mqttBuffer[ 0 ] = MQTT_PACKET_TYPE_PUBLISH;
+    /* Length of the packet. */
+    mqttBuffer[ 1 ] = 20;
+
+    incomingPacket.type = MQTT_PACKET_TYPE_PUBLISH;
+    incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
+    incomingPacket.headerLength = MQTT_SAMPLE_REMAINING_LENGTH;
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+
+    /* Assume QoS = 1. */
+    publishInfo.qos = MQTTQoS0;
+
+    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfo );
+
+    MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+
+    mqttStatus = MQTT_ProcessLoop( &context );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL( true, isEventCallbackInvoked );
+}
+
+void test_MQTT_ProcessLoop_HandleKeepAlive( void )
+{
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTStatus_t mqttStatus;
+
+    setupTransportInterface( &transport );
+    transport.recv = transportRecvNoData;
+    setupNetworkBuffer( &networkBuffer );
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+
+    /* Set this value such that the library will be forced to send keep alive. */
+    context.waitingForPingResp = true;
+    /* Update the time so that there is timeout. */
+    globalEntryTime = MQTT_PINGRESP_TIMEOUT_MS;
+    mqttStatus = MQTT_ProcessLoop( &context );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+}
+
+void test_MQTT_ProcessLoop_HandleKeepAlive1( void )
+{
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTStatus_t mqttStatus;
+    size_t pingreqSize = MQTT_PACKET_PINGREQ_SIZE;
+
+    setupTransportInterface( &transport );
+    transport.recv = transportRecvNoData;
+    setupNetworkBuffer( &networkBuffer );
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
 
     context.connectStatus = MQTTConnected;
 
@@ -4356,6 +5195,50 @@ void test_MQTT_ProcessLoop_handleIncomingPublish_Happy_Path1( void )
     expectProcessLoopCalls( &context, &expectParams );
 }
 
+/**
+ * @brief Test that the metrics count a received publish, its PUBACK and the
+ * incoming publish records in use.
+ */
+void test_MQTT_ProcessLoop_handleIncomingPublish_Metrics( void )
+{
+    MQTTStatus_t mqttStatus;
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    ProcessLoopReturns_t expectParams = { 0 };
+    MQTTPubAckInfo_t pIncomingCallback[ 10 ] = { 0 };
+    MQTTMetrics_t metrics;
+    size_t publishIndex = MQTT_METRICS_INDEX( MQTT_PACKET_TYPE_PUBLISH );
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+
+    mqttStatus = MQTT_InitStatefulQoS( &context, NULL, 0, pIncomingCallback, 10 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_InitMetrics( &context, &metrics ) );
+
+    /* The mocked state engine does not fill the record, so it is filled as
+     * MQTT_UpdateStatePublish would. */
+    pIncomingCallback[ 0 ].packetId = 1;
+
+    context.connectStatus = MQTTConnected;
+    modifyIncomingPacketStatus = MQTTSuccess;
+    currentPacketType = MQTT_PACKET_TYPE_PUBLISH;
+    resetProcessLoopParams( &expectParams );
+    expectParams.stateAfterDeserialize = MQTTPubAckSend;
+    expectParams.stateAfterSerialize = MQTTPublishDone;
+    expectParams.incomingPublish = true;
+    expectProcessLoopCalls( &context, &expectParams );
+
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.packetsReceived[ publishIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 2U * MQTT_SAMPLE_REMAINING_LENGTH, ( uint32_t ) metrics.bytesReceived[ publishIndex ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, metrics.transportSendCalls );
+    TEST_ASSERT_EQUAL( 1U, metrics.incomingPublishRecordsMax );
+}
+
 /**
  * @brief This test case covers one call to the private method,
  * handleIncomingPublish(...),
@@ -5344,206 +6227,646 @@ void test_MQTT_ProcessLoop_handleKeepAlive_Error_Paths4( void )
     MQTT_GetPingreqPacketSize_ExpectAnyArgsAndReturn( MQTTSuccess );
     MQTT_SerializePingreq_ExpectAnyArgsAndReturn( MQTTSuccess );
 
-    mqttStatus = MQTT_ProcessLoop( &context );
-    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, mqttStatus );
+    mqttStatus = MQTT_ProcessLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, mqttStatus );
+}
+
+/**
+ * @brief This test case covers all calls to the private method,
+ * handleKeepAlive(...),
+ * that result in the process loop returning an error.
+ */
+void test_MQTT_ProcessLoop_handleKeepAlive_Error_Paths5( void )
+{
+    MQTTStatus_t mqttStatus;
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    ProcessLoopReturns_t expectParams = { 0 };
+
+    setupTransportInterface( &transport );
+    transport.recv = transportRecvNoData;
+
+    setupNetworkBuffer( &networkBuffer );
+
+    modifyIncomingPacketStatus = MQTTNoDataAvailable;
+    globalEntryTime = MQTT_PINGRESP_TIMEOUT_MS + 1;
+
+    /* Coverage for the branch path where PINGRESP timeout interval has expired. */
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+
+    globalEntryTime = PACKET_RX_TIMEOUT_MS - 1U;
+    context.keepAliveIntervalSec = ( PACKET_TX_TIMEOUT_MS / 1000 ) + 1U;
+    context.lastPacketTxTime = 0;
+    context.lastPacketRxTime = 0;
+    context.pingReqSendTimeMs = 0;
+    context.waitingForPingResp = false;
+
+    /* Set the index to non-zero value to show that there is some data in the buffer
+     * to be processed. */
+    context.index = 12;
+
+    /* Set expected return values in the loop. */
+    resetProcessLoopParams( &expectParams );
+
+    MQTTPacketInfo_t incomingPacket = { 0 };
+    /* Modify incoming packet depending on type to be tested. */
+    currentPacketType = MQTT_PACKET_TYPE_PINGRESP;
+    incomingPacket.type = currentPacketType;
+    incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
+    incomingPacket.headerLength = MQTT_SAMPLE_REMAINING_LENGTH;
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+
+    mqttStatus = MQTT_ProcessLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, mqttStatus );
+}
+
+/**
+ * @brief This test mocks a failing transport receive and runs multiple
+ * iterations of the process loop, resulting in returning MQTTRecvFailed.
+ */
+void test_MQTT_ProcessLoop_Receive_Failed( void )
+{
+    MQTTStatus_t mqttStatus;
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPacketInfo_t incomingPacket = { 0 };
+
+    setupNetworkBuffer( &networkBuffer );
+    setupTransportInterface( &transport );
+    transport.writev = transportWritevFail;
+
+    mqttStatus = MQTT_Init( &context, &transport,
+                            getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    incomingPacket.type = MQTT_PACKET_TYPE_PUBCOMP;
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTRecvFailed );
+
+    mqttStatus = MQTT_ProcessLoop( &context );
+
+    TEST_ASSERT_EQUAL( MQTTRecvFailed, mqttStatus );
+}
+
+/**
+ * @brief Set the initial entry time close to the maximum value, causing
+ * an overflow. This test then checks that the process loop still runs for the
+ * expected number of iterations in spite of this.
+ */
+void test_MQTT_ProcessLoop_Timer_Overflow( void )
+{
+    MQTTStatus_t mqttStatus = { 0 };
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPacketInfo_t incomingPacket = { 0 };
+    MQTTPublishState_t publishState = MQTTPubAckSend;
+    MQTTPublishState_t ackState = MQTTPublishDone;
+    MQTTPubAckInfo_t incomingPublishRecords[ 10 ];
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+
+    incomingPacket.type = MQTT_PACKET_TYPE_PUBLISH;
+    incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
+
+    globalEntryTime = UINT32_MAX - MQTT_OVERFLOW_OFFSET;
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+
+    mqttStatus = MQTT_InitStatefulQoS( &context, NULL, 0, incomingPublishRecords, 10 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+
+    context.connectStatus = MQTTConnected;
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    /* Assume QoS = 1 so that a PUBACK will be sent after receiving PUBLISH. */
+    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateStatePublish_ReturnThruPtr_pNewState( &publishState );
+    MQTT_SerializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateStateAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateStateAck_ReturnThruPtr_pNewState( &ackState );
+
+    mqttStatus = MQTT_ProcessLoop( &context );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test that MQTT_ReceiveLoop() works as intended. Since the only difference
+ * between this and the process loop is keep alive, we only need to test the
+ * differences for coverage.
+ */
+void test_MQTT_ReceiveLoop( void )
+{
+    MQTTStatus_t mqttStatus;
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+
+    /* Verify that a NULL Context returns an error. */
+    mqttStatus = MQTT_ReceiveLoop( NULL );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    /* Verify that a NULL time function returns an error. */
+    context.getTime = NULL;
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+    context.getTime = getTime;
+
+    /* Verify that a null fixed network buffer returns an error. */
+    context.networkBuffer.pBuffer = NULL;
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+    setupNetworkBuffer( &( context.networkBuffer ) );
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTBadResponse );
+    /* Error case, for branch coverage. */
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTBadResponse, mqttStatus );
+
+    /* This will cover the case when there is data available in the buffer to be processed but
+     * no additional bytes have been received by the transport interface. */
+    context.transportInterface.recv = transportRecvNoData;
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTBadResponse );
+    /* Error case, for branch coverage. */
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTBadResponse, mqttStatus );
+
+    /* Reset the index to clear the buffer of any remaining data. */
+    context.index = 0;
+    /* Keep Alive should not trigger.*/
+    context.keepAliveIntervalSec = 1;
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_FALSE( context.controlPacketSent );
+
+    /* Test with a dummy getTime to ensure there's no infinite loops. */
+    context.getTime = getTimeDummy;
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    context.getTime = getTime;
+
+    /* Receive a PINGRESP. */
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+}
+
+/**
+ * @brief Test that the fixed header of a packet that arrives in parts is
+ * parsed only once.
+ */
+void test_MQTT_ReceiveLoop_PartialPacket_HeaderParsedOnce( void )
+{
+    MQTTStatus_t mqttStatus;
+    MQTTContext_t context = { 0 };
+    TransportInterface_t transport = { 0 };
+    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTPacketInfo_t incomingPacket = { 0 };
+
+    setupTransportInterface( &transport );
+    setupNetworkBuffer( &networkBuffer );
+    transport.recv = transportRecvNoData;
+
+    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+
+    incomingPacket.type = MQTT_PACKET_TYPE_PINGRESP;
+    incomingPacket.remainingLength = 2;
+    incomingPacket.headerLength = 2;
+
+    /* Only the fixed header has been received. */
+    context.index = 2;
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, mqttStatus );
+    TEST_ASSERT_EQUAL( 2, context.pendingPacket.headerLength );
+
+    /* Part of the rest arrives; the header is not parsed again. */
+    context.index = 3;
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, mqttStatus );
+
+    /* The whole packet has arrived. */
+    context.index = 4;
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL( 0, context.index );
+    TEST_ASSERT_EQUAL( 0, context.pendingPacket.headerLength );
+}
+
+/**
+ * @brief Test that the publishes received together are given to the batch
+ * callback in one call, before their acks are sent and before the packets
+ * that follow them are handled.
+ */
+void test_MQTT_ReceiveLoop_PublishBatch( void )
+{
+    MQTTStatus_t mqttStatus;
+    MQTTContext_t context = { 0 };
+    MQTTPacketInfo_t publishPacket = { 0 };
+    MQTTPacketInfo_t pingrespPacket = { 0 };
+    MQTTPublishInfo_t publishInfoQoS1 = { 0 };
+    MQTTPublishInfo_t publishInfoQoS0 = { 0 };
+    MQTTPublishState_t publishState = MQTTPubAckSend;
+    MQTTDeserializedInfo_t batch[ 4 ];
+    MQTTPublishInfo_t batchPublishes[ 4 ];
+
+    setUPContext( &context );
+    context.transportInterface.recv = transportRecvNoData;
+    context.connectStatus = MQTTConnected;
+
+    mqttStatus = MQTT_InitPublishBatch( &context, publishBatchCallback, batch, batchPublishes, 4 );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+
+    publishPacket.type = MQTT_PACKET_TYPE_PUBLISH;
+    publishPacket.headerLength = 2;
+    publishPacket.remainingLength = 2;
+    pingrespPacket.type = MQTT_PACKET_TYPE_PINGRESP;
+    pingrespPacket.headerLength = 2;
+    pingrespPacket.remainingLength = 0;
+    publishInfoQoS1.qos = MQTTQoS1;
+    publishInfoQoS0.qos = MQTTQoS0;
+
+    /* Two publishes followed by a PINGRESP are in the buffer. */
+    context.index = 10;
+    publishBatchCount = 0;
+    publishBatchAckSent = true;
+    isEventCallbackInvoked = false;
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &publishPacket );
+    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfoQoS1 );
+    MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateStatePublish_ReturnThruPtr_pNewState( &publishState );
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &publishPacket );
+    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfoQoS0 );
+    MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &pingrespPacket );
+
+    /* The batch is delivered before the PINGRESP, then the QoS 1 publish is acked. */
+    MQTT_CalculateStatePublish_ExpectAnyArgsAndReturn( MQTTPubAckSend );
+    MQTT_SerializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_UpdateStateAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_CalculateStatePublish_ExpectAnyArgsAndReturn( MQTTPublishDone );
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL( 2, publishBatchCount );
+    TEST_ASSERT_FALSE( publishBatchAckSent );
+    TEST_ASSERT_TRUE( context.controlPacketSent );
+    TEST_ASSERT_TRUE( isEventCallbackInvoked );
+    TEST_ASSERT_EQUAL( 0, context.publishBatchCount );
+    TEST_ASSERT_EQUAL( 0, context.index );
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Buffer given out by #getBufferCallback.
+ */
+static uint8_t replacementBuffer[ MQTT_TEST_BUFFER_LENGTH ];
+
+/**
+ * @brief Whether #getBufferCallback has a buffer to give out.
+ */
+static bool replacementBufferAvailable = true;
+
+/**
+ * @brief Network buffer taken by #takeBufferEventCallback.
+ */
+static MQTTFixedBuffer_t takenBuffer = { 0 };
+
+/**
+ * @brief Status returned by MQTT_TakeReceiveBuffer in #takeBufferEventCallback.
+ */
+static MQTTStatus_t takeBufferStatus = MQTTSuccess;
+
+/**
+ * @brief Mocked buffer pool returning #replacementBuffer.
+ */
+static bool getBufferCallback( MQTTContext_t * pContext,
+                               size_t minimumSize,
+                               MQTTFixedBuffer_t * pBuffer )
+{
+    ( void ) pContext;
+    ( void ) minimumSize;
+
+    pBuffer->pBuffer = replacementBuffer;
+    pBuffer->size = sizeof( replacementBuffer );
+
+    return replacementBufferAvailable;
+}
+
+/**
+ * @brief Event callback that takes the network buffer for incoming publishes.
+ */
+static void takeBufferEventCallback( MQTTContext_t * pContext,
+                                     MQTTPacketInfo_t * pPacketInfo,
+                                     MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pDeserializedInfo;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        takeBufferStatus = MQTT_TakeReceiveBuffer( pContext, &takenBuffer );
+    }
 }
 
 /**
- * @brief This test case covers all calls to the private method,
- * handleKeepAlive(...),
- * that result in the process loop returning an error.
+ * @brief Test that invalid parameters cause MQTT_InitBufferExchange and
+ * MQTT_TakeReceiveBuffer to return an error.
  */
-void test_MQTT_ProcessLoop_handleKeepAlive_Error_Paths5( void )
+void test_MQTT_InitBufferExchange_Invalid_Params( void )
 {
-    MQTTStatus_t mqttStatus;
+    MQTTStatus_t mqttStatus = { 0 };
     MQTTContext_t context = { 0 };
-    TransportInterface_t transport = { 0 };
-    MQTTFixedBuffer_t networkBuffer = { 0 };
-    ProcessLoopReturns_t expectParams = { 0 };
+    MQTTFixedBuffer_t buffer = { 0 };
 
-    setupTransportInterface( &transport );
-    transport.recv = transportRecvNoData;
+    mqttStatus = MQTT_InitBufferExchange( NULL, getBufferCallback );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    setupNetworkBuffer( &networkBuffer );
+    mqttStatus = MQTT_InitBufferExchange( &context, NULL );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    modifyIncomingPacketStatus = MQTTNoDataAvailable;
-    globalEntryTime = MQTT_PINGRESP_TIMEOUT_MS + 1;
+    /* The context has not been initialized with MQTT_Init. */
+    mqttStatus = MQTT_InitBufferExchange( &context, getBufferCallback );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    /* Coverage for the branch path where PINGRESP timeout interval has expired. */
-    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
-    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    setUPContext( &context );
 
-    globalEntryTime = PACKET_RX_TIMEOUT_MS - 1U;
-    context.keepAliveIntervalSec = ( PACKET_TX_TIMEOUT_MS / 1000 ) + 1U;
-    context.lastPacketTxTime = 0;
-    context.lastPacketRxTime = 0;
-    context.pingReqSendTimeMs = 0;
-    context.waitingForPingResp = false;
+    mqttStatus = MQTT_TakeReceiveBuffer( NULL, &buffer );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    /* Set the index to non-zero value to show that there is some data in the buffer
-     * to be processed. */
-    context.index = 12;
+    mqttStatus = MQTT_TakeReceiveBuffer( &context, NULL );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    /* Set expected return values in the loop. */
-    resetProcessLoopParams( &expectParams );
+    /* Buffer exchange has not been enabled. */
+    mqttStatus = MQTT_TakeReceiveBuffer( &context, &buffer );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    MQTTPacketInfo_t incomingPacket = { 0 };
-    /* Modify incoming packet depending on type to be tested. */
-    currentPacketType = MQTT_PACKET_TYPE_PINGRESP;
-    incomingPacket.type = currentPacketType;
-    incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
-    incomingPacket.headerLength = MQTT_SAMPLE_REMAINING_LENGTH;
+    mqttStatus = MQTT_InitBufferExchange( &context, getBufferCallback );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
 
-    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTNeedMoreBytes );
-    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
+    /* No publish is being delivered. */
+    mqttStatus = MQTT_TakeReceiveBuffer( &context, &buffer );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    mqttStatus = MQTT_ProcessLoop( &context );
-    TEST_ASSERT_EQUAL( MQTTNeedMoreBytes, mqttStatus );
+    /* The pool is empty. */
+    context.deliveredIndex = 4;
+    context.index = 4;
+    replacementBufferAvailable = false;
+    mqttStatus = MQTT_TakeReceiveBuffer( &context, &buffer );
+    TEST_ASSERT_EQUAL( MQTTNoMemory, mqttStatus );
+    TEST_ASSERT_EQUAL_PTR( mqttBuffer, context.networkBuffer.pBuffer );
+    replacementBufferAvailable = true;
 }
 
 /**
- * @brief This test mocks a failing transport receive and runs multiple
- * iterations of the process loop, resulting in returning MQTTRecvFailed.
+ * @brief Test that an event callback can take the network buffer holding an
+ * incoming publish, and that the bytes after the publish are kept.
  */
-void test_MQTT_ProcessLoop_Receive_Failed( void )
+void test_MQTT_ReceiveLoop_TakeReceiveBuffer( void )
 {
     MQTTStatus_t mqttStatus;
     MQTTContext_t context = { 0 };
-    TransportInterface_t transport = { 0 };
-    MQTTFixedBuffer_t networkBuffer = { 0 };
-    MQTTPacketInfo_t incomingPacket = { 0 };
+    MQTTPacketInfo_t publishPacket = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
 
-    setupNetworkBuffer( &networkBuffer );
-    setupTransportInterface( &transport );
-    transport.writev = transportWritevFail;
+    setUPContext( &context );
+    context.transportInterface.recv = transportRecvNoData;
+    context.appCallback = takeBufferEventCallback;
 
-    mqttStatus = MQTT_Init( &context, &transport,
-                            getTime, eventCallback, &networkBuffer );
+    mqttStatus = MQTT_InitBufferExchange( &context, getBufferCallback );
     TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
-    incomingPacket.type = MQTT_PACKET_TYPE_PUBCOMP;
 
-    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
-    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTRecvFailed );
+    publishPacket.type = MQTT_PACKET_TYPE_PUBLISH;
+    publishPacket.headerLength = 2;
+    publishPacket.remainingLength = 2;
+    publishInfo.qos = MQTTQoS0;
 
-    mqttStatus = MQTT_ProcessLoop( &context );
+    /* A publish followed by the start of the next packet. */
+    mqttBuffer[ 4 ] = MQTT_PACKET_TYPE_PINGRESP;
+    mqttBuffer[ 5 ] = 0;
+    context.index = 6;
+    takenBuffer.pBuffer = NULL;
+    takeBufferStatus = MQTTBadParameter;
 
-    TEST_ASSERT_EQUAL( MQTTRecvFailed, mqttStatus );
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &publishPacket );
+    MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfo );
+    MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+
+    mqttStatus = MQTT_ReceiveLoop( &context );
+    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL( MQTTSuccess, takeBufferStatus );
+    TEST_ASSERT_EQUAL_PTR( mqttBuffer, takenBuffer.pBuffer );
+    TEST_ASSERT_EQUAL_PTR( replacementBuffer, context.networkBuffer.pBuffer );
+    TEST_ASSERT_EQUAL( 2, context.index );
+    TEST_ASSERT_EQUAL( MQTT_PACKET_TYPE_PINGRESP, replacementBuffer[ 0 ] );
+    TEST_ASSERT_EQUAL( 0, context.deliveredIndex );
+    TEST_ASSERT_EQUAL( 0, context.takenLength );
 }
 
+/* ========================================================================== */
+
 /**
- * @brief Set the initial entry time close to the maximum value, causing
- * an overflow. This test then checks that the process loop still runs for the
- * expected number of iterations in spite of this.
+ * @brief Number of times #resolveTopicCallback was invoked.
  */
-void test_MQTT_ProcessLoop_Timer_Overflow( void )
+static uint32_t resolveTopicCount = 0U;
+
+/**
+ * @brief Handler ID given to #handlerIdEventCallback for the last publish.
+ */
+static uint32_t deliveredHandlerId = MQTT_HANDLER_ID_NONE;
+
+/**
+ * @brief Mocked topic resolver, returning the length of the topic name as
+ * its handler ID.
+ */
+static uint32_t resolveTopicCallback( MQTTContext_t * pContext,
+                                      const char * pTopicName,
+                                      uint16_t topicNameLength )
 {
-    MQTTStatus_t mqttStatus = { 0 };
-    MQTTContext_t context = { 0 };
-    TransportInterface_t transport = { 0 };
-    MQTTFixedBuffer_t networkBuffer = { 0 };
-    MQTTPacketInfo_t incomingPacket = { 0 };
-    MQTTPublishState_t publishState = MQTTPubAckSend;
-    MQTTPublishState_t ackState = MQTTPublishDone;
-    MQTTPubAckInfo_t incomingPublishRecords[ 10 ];
+    ( void ) pContext;
+    ( void ) pTopicName;
 
-    setupTransportInterface( &transport );
-    setupNetworkBuffer( &networkBuffer );
+    resolveTopicCount++;
 
-    incomingPacket.type = MQTT_PACKET_TYPE_PUBLISH;
-    incomingPacket.remainingLength = MQTT_SAMPLE_REMAINING_LENGTH;
+    return topicNameLength;
+}
 
-    globalEntryTime = UINT32_MAX - MQTT_OVERFLOW_OFFSET;
+/**
+ * @brief Event callback that records the handler ID of incoming publishes.
+ */
+static void handlerIdEventCallback( MQTTContext_t * pContext,
+                                    MQTTPacketInfo_t * pPacketInfo,
+                                    MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
 
-    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
-    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        deliveredHandlerId = pDeserializedInfo->handlerId;
+    }
+}
 
-    mqttStatus = MQTT_InitStatefulQoS( &context, NULL, 0, incomingPublishRecords, 10 );
-    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+/**
+ * @brief Receive one QoS 0 publish with a topic name through MQTT_ReceiveLoop.
+ */
+static void receivePublishWithTopic( MQTTContext_t * pContext,
+                                     const char * pTopicName )
+{
+    MQTTPacketInfo_t publishPacket = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
 
-    context.connectStatus = MQTTConnected;
+    publishPacket.type = MQTT_PACKET_TYPE_PUBLISH;
+    publishPacket.headerLength = 2;
+    publishPacket.remainingLength = 2;
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = pTopicName;
+    publishInfo.topicNameLength = ( uint16_t ) strlen( pTopicName );
+
+    pContext->index = 4;
+    deliveredHandlerId = MQTT_HANDLER_ID_NONE;
 
     MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &incomingPacket );
-    /* Assume QoS = 1 so that a PUBACK will be sent after receiving PUBLISH. */
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &publishPacket );
     MQTT_DeserializePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_DeserializePublish_ReturnThruPtr_pPublishInfo( &publishInfo );
     MQTT_UpdateStatePublish_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_UpdateStatePublish_ReturnThruPtr_pNewState( &publishState );
-    MQTT_SerializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_UpdateStateAck_ExpectAnyArgsAndReturn( MQTTSuccess );
-    MQTT_UpdateStateAck_ReturnThruPtr_pNewState( &ackState );
-
-    mqttStatus = MQTT_ProcessLoop( &context );
 
-    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_ReceiveLoop( pContext ) );
 }
 
-/* ========================================================================== */
-
 /**
- * @brief Test that MQTT_ReceiveLoop() works as intended. Since the only difference
- * between this and the process loop is keep alive, we only need to test the
- * differences for coverage.
+ * @brief Test that invalid parameters cause MQTT_InitTopicCache and
+ * MQTT_InvalidateTopicCache to return an error.
  */
-void test_MQTT_ReceiveLoop( void )
+void test_MQTT_InitTopicCache_Invalid_Params( void )
 {
     MQTTStatus_t mqttStatus;
     MQTTContext_t context = { 0 };
-    TransportInterface_t transport = { 0 };
-    MQTTFixedBuffer_t networkBuffer = { 0 };
+    MQTTTopicCacheEntry_t entries[ 2 ];
+    char names[ 2 * 8 ];
 
-    setupTransportInterface( &transport );
-    setupNetworkBuffer( &networkBuffer );
+    mqttStatus = MQTT_InitTopicCache( NULL, resolveTopicCallback, entries, names, 2, 8 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    mqttStatus = MQTT_Init( &context, &transport, getTime, eventCallback, &networkBuffer );
-    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    mqttStatus = MQTT_InitTopicCache( &context, NULL, entries, names, 2, 8 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    /* Verify that a NULL Context returns an error. */
-    mqttStatus = MQTT_ReceiveLoop( NULL );
+    mqttStatus = MQTT_InitTopicCache( &context, resolveTopicCallback, NULL, names, 2, 8 );
     TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    /* Verify that a NULL time function returns an error. */
-    context.getTime = NULL;
-    mqttStatus = MQTT_ReceiveLoop( &context );
+    mqttStatus = MQTT_InitTopicCache( &context, resolveTopicCallback, entries, NULL, 2, 8 );
     TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
-    context.getTime = getTime;
 
-    /* Verify that a null fixed network buffer returns an error. */
-    context.networkBuffer.pBuffer = NULL;
-    mqttStatus = MQTT_ReceiveLoop( &context );
+    mqttStatus = MQTT_InitTopicCache( &context, resolveTopicCallback, entries, names, 0, 8 );
     TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
-    setupNetworkBuffer( &( context.networkBuffer ) );
 
-    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTBadResponse );
-    /* Error case, for branch coverage. */
-    mqttStatus = MQTT_ReceiveLoop( &context );
-    TEST_ASSERT_EQUAL( MQTTBadResponse, mqttStatus );
+    mqttStatus = MQTT_InitTopicCache( &context, resolveTopicCallback, entries, names, 2, 0 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
 
-    /* This will cover the case when there is data available in the buffer to be processed but
-     * no additional bytes have been received by the transport interface. */
+    /* The context has not been initialized with MQTT_Init. */
+    mqttStatus = MQTT_InitTopicCache( &context, resolveTopicCallback, entries, names, 2, 8 );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    mqttStatus = MQTT_InvalidateTopicCache( NULL );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+
+    /* No topic cache has been set up. */
+    mqttStatus = MQTT_InvalidateTopicCache( &context );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, mqttStatus );
+}
+
+/**
+ * @brief Test that repeated topic names get their handler ID from the topic
+ * cache, and that the cache is cleared when the subscriptions change.
+ */
+void test_MQTT_ReceiveLoop_TopicCache( void )
+{
+    MQTTStatus_t mqttStatus;
+    MQTTContext_t context = { 0 };
+    MQTTPacketInfo_t subackPacket = { 0 };
+    MQTTTopicCacheEntry_t entries[ 2 ];
+    char names[ 2 * 8 ];
+
+    setUPContext( &context );
     context.transportInterface.recv = transportRecvNoData;
-    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTBadResponse );
-    /* Error case, for branch coverage. */
-    mqttStatus = MQTT_ReceiveLoop( &context );
-    TEST_ASSERT_EQUAL( MQTTBadResponse, mqttStatus );
+    context.appCallback = handlerIdEventCallback;
 
-    /* Reset the index to clear the buffer of any remaining data. */
-    context.index = 0;
-    /* Keep Alive should not trigger.*/
-    context.keepAliveIntervalSec = 1;
-    mqttStatus = MQTT_ReceiveLoop( &context );
-    TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
-    TEST_ASSERT_FALSE( context.controlPacketSent );
+    /* Without a topic cache, there is no handler ID. */
+    receivePublishWithTopic( &context, "a/b" );
+    TEST_ASSERT_EQUAL( MQTT_HANDLER_ID_NONE, deliveredHandlerId );
 
-    /* Test with a dummy getTime to ensure there's no infinite loops. */
-    context.getTime = getTimeDummy;
-    mqttStatus = MQTT_ReceiveLoop( &context );
+    mqttStatus = MQTT_InitTopicCache( &context, resolveTopicCallback, entries, names, 2, 8 );
     TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
-    context.getTime = getTime;
-
-    /* Receive a PINGRESP. */
-    mqttStatus = MQTT_ReceiveLoop( &context );
+    resolveTopicCount = 0U;
+
+    /* The first publish on a topic is resolved, the second is a hit. */
+    receivePublishWithTopic( &context, "a/b" );
+    TEST_ASSERT_EQUAL( 3U, deliveredHandlerId );
+    receivePublishWithTopic( &context, "a/b" );
+    TEST_ASSERT_EQUAL( 3U, deliveredHandlerId );
+    TEST_ASSERT_EQUAL( 1U, resolveTopicCount );
+    TEST_ASSERT_EQUAL( 1U, context.topicCacheHits );
+    TEST_ASSERT_EQUAL( 1U, context.topicCacheMisses );
+
+    /* Topic names longer than the cached names are resolved every time. */
+    receivePublishWithTopic( &context, "a/long/topic" );
+    receivePublishWithTopic( &context, "a/long/topic" );
+    TEST_ASSERT_EQUAL( 12U, deliveredHandlerId );
+    TEST_ASSERT_EQUAL( 3U, resolveTopicCount );
+
+    /* An invalidated cache resolves the topic again. */
+    mqttStatus = MQTT_InvalidateTopicCache( &context );
     TEST_ASSERT_EQUAL( MQTTSuccess, mqttStatus );
+    receivePublishWithTopic( &context, "a/b" );
+    TEST_ASSERT_EQUAL( 4U, resolveTopicCount );
+
+    /* A SUBACK also clears the cache. */
+    subackPacket.type = MQTT_PACKET_TYPE_SUBACK;
+    subackPacket.headerLength = 2;
+    subackPacket.remainingLength = 3;
+    context.index = 5;
+    MQTT_ProcessIncomingPacketTypeAndLength_ExpectAnyArgsAndReturn( MQTTSuccess );
+    MQTT_ProcessIncomingPacketTypeAndLength_ReturnThruPtr_pIncomingPacket( &subackPacket );
+    MQTT_DeserializeAck_ExpectAnyArgsAndReturn( MQTTSuccess );
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_ReceiveLoop( &context ) );
+
+    receivePublishWithTopic( &context, "a/b" );
+    TEST_ASSERT_EQUAL( 3U, deliveredHandlerId );
+    TEST_ASSERT_EQUAL( 5U, resolveTopicCount );
+    TEST_ASSERT_EQUAL( 1U, context.topicCacheHits );
+    TEST_ASSERT_EQUAL( 5U, context.topicCacheMisses );
 }
 
 /* ========================================================================== */
@@ -7043,6 +8366,103 @@ void test_MQTT_MatchTopic_Wildcard_MultiLevel_No_Match_Cases( void )
     TEST_ASSERT_EQUAL( false, matchResult );
 }
 
+/**
+ * @brief Verifies that MQTT_MatchTopic matches topic names and filters with
+ * levels longer than the blocks of bytes compared at a time.
+ */
+void test_MQTT_MatchTopic_Long_Levels( void )
+{
+    const char * pTopicName = NULL;
+    const char * pTopicFilter = NULL;
+    bool matchResult = false;
+
+    /* Levels of more than 16 characters around a '+' wildcard. */
+    pTopicName = "building-north-campus/floor-seventeen-east/room-1742/temperature";
+    pTopicFilter = "building-north-campus/+/room-1742/temperature";
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchTopic( pTopicName,
+                                                     strlen( pTopicName ),
+                                                     pTopicFilter,
+                                                     strlen( pTopicFilter ),
+                                                     &matchResult ) );
+    TEST_ASSERT_EQUAL( true, matchResult );
+
+    /* A difference after the first block of a long level. */
+    pTopicName = "building-north-campus/floor-seventeen-east/room-1742/temperature";
+    pTopicFilter = "building-north-campus/+/room-1742/temperaturX";
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchTopic( pTopicName,
+                                                     strlen( pTopicName ),
+                                                     pTopicFilter,
+                                                     strlen( pTopicFilter ),
+                                                     &matchResult ) );
+    TEST_ASSERT_EQUAL( false, matchResult );
+
+    /* A '+' wildcard spanning a level of more than 16 characters at the end
+     * of the topic name. */
+    pTopicName = "building/floor-seventeen-east-wing-b";
+    pTopicFilter = "building/+";
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchTopic( pTopicName,
+                                                     strlen( pTopicName ),
+                                                     pTopicFilter,
+                                                     strlen( pTopicFilter ),
+                                                     &matchResult ) );
+    TEST_ASSERT_EQUAL( true, matchResult );
+
+    pTopicName = "building/floor-seventeen-east-wing-b/room";
+    pTopicFilter = "building/+";
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchTopic( pTopicName,
+                                                     strlen( pTopicName ),
+                                                     pTopicFilter,
+                                                     strlen( pTopicFilter ),
+                                                     &matchResult ) );
+    TEST_ASSERT_EQUAL( false, matchResult );
+
+    /* A topic name of more than 16 characters matched by a '#' after it. */
+    pTopicName = "building-north-campus-east";
+    pTopicFilter = "building-north-campus-east/#";
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_MatchTopic( pTopicName,
+                                                     strlen( pTopicName ),
+                                                     pTopicFilter,
+                                                     strlen( pTopicFilter ),
+                                                     &matchResult ) );
+    TEST_ASSERT_EQUAL( true, matchResult );
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Tests that MQTT_ValidateTopicName rejects invalid parameters and
+ * topic names with wildcard or null characters.
+ */
+void test_MQTT_ValidateTopicName( void )
+{
+    const char * pTopicName = NULL;
+
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ValidateTopicName( NULL, 1U ) );
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ValidateTopicName( "a", 0U ) );
+
+    pTopicName = "sensors/kitchen/temperature";
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_ValidateTopicName( pTopicName, strlen( pTopicName ) ) );
+
+    pTopicName = "sensors/+/temperature";
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ValidateTopicName( pTopicName, strlen( pTopicName ) ) );
+
+    pTopicName = "sensors/#";
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ValidateTopicName( pTopicName, strlen( pTopicName ) ) );
+
+    /* Only the given length is checked. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_ValidateTopicName( pTopicName, 7U ) );
+
+    /* Invalid characters after the first 16. */
+    pTopicName = "building-north-campus/floor-seventeen/#";
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ValidateTopicName( pTopicName, strlen( pTopicName ) ) );
+
+    pTopicName = "building-north-campus/\0";
+    TEST_ASSERT_EQUAL( MQTTBadParameter, MQTT_ValidateTopicName( pTopicName, 23U ) );
+
+    pTopicName = "building-north-campus/floor-seventeen";
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_ValidateTopicName( pTopicName, strlen( pTopicName ) ) );
+}
+
 /* ========================================================================== */
 
 /**